@@ -0,0 +1,240 @@
+﻿// <copyright file="capture_benchmark.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/capture_reader.h"
+#include "power_overwhelming/capture_writer.h"
+#include "power_overwhelming/csv_encoder.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#include <tchar.h>
+#endif /* defined(_WIN32) */
+
+#if !defined(_tmain)
+#define _tmain main
+#define TCHAR char
+#define _T(x) (x)
+#endif /* !defined(_tmain) */
+
+
+namespace {
+
+    using namespace visus::power_overwhelming;
+
+    /// <summary>
+    /// Generates the samples of a sensor that is sampled at a fixed rate with
+    /// some jitter and whose values are quantised like the output of an ADC.
+    /// </summary>
+    /// <remarks>
+    /// Each sensor has its own random number generator such that a copy of
+    /// the initial state reproduces the samples of the sensor independently
+    /// from the others.
+    /// </remarks>
+    struct synthetic_sensor {
+        float current;
+        std::normal_distribution<double> jitter;
+        timestamp::value_type next;
+        timestamp::value_type period;
+        std::mt19937 rng;
+        std::uniform_int_distribution<int> walk;
+
+        synthetic_sensor(const timestamp::value_type begin,
+                const timestamp::value_type period,
+                const std::mt19937::result_type seed)
+            : current(1.0f), jitter(0.0, 0.01 * period), next(begin),
+            period(period), rng(seed), walk(-2, 2) { }
+
+        measurement_data operator ()(void) {
+            // The current of a INA226 is quantised to 1.25 mA, and the voltage
+            // to 1.25 mV, which we mimic here using a random walk.
+            this->current = (std::max)(0.0f,
+                this->current + 0.00125f * this->walk(this->rng));
+            const auto voltage = 12.0f + 0.00125f * this->walk(this->rng);
+            const auto t = this->next + static_cast<timestamp::value_type>(
+                this->jitter(this->rng));
+            this->next += this->period;
+            return measurement_data(timestamp(t), voltage, this->current);
+        }
+    };
+
+    /// <summary>
+    /// Answer the value following <paramref name="option" /> or
+    /// <paramref name="fallback" /> if the option has not been specified.
+    /// </summary>
+    template<class TValue>
+    TValue get_option(const std::vector<std::basic_string<TCHAR>>& cmd_line,
+            const TCHAR *option, const TValue fallback) {
+        auto it = std::find(cmd_line.begin(), cmd_line.end(), option);
+        if ((it == cmd_line.end()) || (++it == cmd_line.end())) {
+            return fallback;
+        } else {
+            return static_cast<TValue>(std::stod(*it));
+        }
+    }
+}
+
+
+/// <summary>
+/// Entry point of the capture benchmark, which writes synthetic samples of a
+/// configurable number of sensors into a capture file, compares its size to
+/// the CSV output of the collector and measures how fast the capture can be
+/// decoded.
+/// </summary>
+/// <param name="argc"></param>
+/// <param name="argv"></param>
+/// <returns></returns>
+int _tmain(const int argc, const TCHAR **argv) {
+    using namespace visus::power_overwhelming;
+    using std::chrono::steady_clock;
+    typedef std::chrono::duration<double> seconds;
+
+    const std::vector<std::basic_string<TCHAR>> cmd_line(argv, argv + argc);
+
+    if (std::find(cmd_line.begin(), cmd_line.end(), _T("--help"))
+            != cmd_line.end()) {
+        std::wcout << L"Writes synthetic samples into a capture file, "
+            << L"compares its size to CSV and" << std::endl
+            << L"measures the decoding throughput."
+            << std::endl << std::endl;
+        std::wcout << L"Usage: capture_benchmark [--sensors <count>] "
+            << L"[--rate <Hz>] [--duration <s>]" << std::endl
+            << L"    [--block <samples>] [--zstd]" << std::endl;
+        return 0;
+    }
+
+    try {
+        const auto block = get_option(cmd_line, _T("--block"),
+            capture_writer::default_block_size);
+        const auto compression = (std::find(cmd_line.begin(), cmd_line.end(),
+            _T("--zstd")) != cmd_line.end())
+            ? capture_compression::zstd
+            : capture_compression::none;
+        const auto duration = get_option(cmd_line, _T("--duration"), 60.0);
+        const auto rate = get_option(cmd_line, _T("--rate"), 1000.0);
+        const auto sensors = get_option(cmd_line, _T("--sensors"),
+            std::size_t(100));
+        const auto samples = static_cast<std::size_t>(duration * rate);
+        const std::filesystem::path path(L"capture_benchmark.pwrowg");
+
+        const auto period = static_cast<timestamp::value_type>(
+            timestamp::tick_rate / rate);
+        const auto begin = timestamp::now().value();
+        std::vector<synthetic_sensor> generators;
+        std::vector<std::wstring> names;
+        for (std::size_t s = 0; s < sensors; ++s) {
+            generators.emplace_back(begin, period,
+                static_cast<std::mt19937::result_type>(42 + s));
+            names.push_back(L"sensor" + std::to_wstring(s));
+        }
+
+        // Remember the initial state of the generators such that we can
+        // replay the samples in order to check what we read.
+        const auto replay = generators;
+
+        // Write the samples in the order the collector would receive them
+        // and compute the size of the equivalent CSV on the fly.
+        const csv_encoder encoder;
+        std::vector<csv_encoder::char_type> line(256);
+        std::uintmax_t csv = 0;
+
+        const auto write_begin = steady_clock::now();
+        {
+            capture_writer writer(path.wstring().c_str(), compression, block);
+            std::vector<capture_writer::id_type> ids;
+            for (auto& n : names) {
+                ids.push_back(writer.sensor(n.c_str()));
+            }
+
+            for (std::size_t i = 0; i < samples; ++i) {
+                for (std::size_t s = 0; s < sensors; ++s) {
+                    const measurement m(names[s].c_str(), generators[s]());
+                    writer.write(ids[s], m.data());
+                    // Add the empty marker column and the line break.
+                    csv += encoder.encode(line.data(), line.size(), m) + 2;
+                }
+            }
+
+            writer.close();
+        }
+        const auto write_end = steady_clock::now();
+
+        const auto size = std::filesystem::file_size(path);
+        const auto total = samples * sensors;
+        std::wcout << L"Samples: " << total << L" of " << sensors
+            << L" sensors" << std::endl;
+        std::wcout << L"CSV: " << csv << L" B, capture: " << size << L" B ("
+            << (static_cast<double>(csv) / size) << L"x smaller, "
+            << (static_cast<double>(size) / total) << L" B/sample)"
+            << std::endl;
+        std::wcout << L"Encoding: " << (total / seconds(write_end
+            - write_begin).count()) << L" samples/s" << std::endl;
+
+        const auto read_begin = steady_clock::now();
+        std::size_t decoded = 0;
+        {
+            capture_reader reader(path.wstring().c_str());
+            for (capture_reader::id_type s = 0; s < reader.sensors(); ++s) {
+                decoded += reader.read(s).size();
+            }
+        }
+        const auto read_end = steady_clock::now();
+
+        const auto elapsed = seconds(read_end - read_begin).count();
+        std::wcout << L"Decoding: " << (decoded / elapsed) << L" samples/s, "
+            << (size / elapsed / (1024.0 * 1024.0)) << L" MB/s" << std::endl;
+
+        // The codec must be lossless, so every sample must be bit-exact. This
+        // is done after the time measurement, because it decodes once more.
+        std::size_t mismatches = (decoded != total) ? 1 : 0;
+        {
+            capture_reader reader(path.wstring().c_str());
+            for (std::size_t s = 0; s < sensors; ++s) {
+                const auto series = reader.read(names[s].c_str());
+                auto expected = replay[s];
+
+                if (series.size() != samples) {
+                    ++mismatches;
+                    continue;
+                }
+
+                for (std::size_t i = 0; i < series.size(); ++i) {
+                    const auto a = expected();
+                    const auto& b = series.data()[i];
+                    if ((a.timestamp().value() != b.timestamp().value())
+                            || (a.voltage() != b.voltage())
+                            || (a.current() != b.current())
+                            || (a.power() != b.power())) {
+                        ++mismatches;
+                    }
+                }
+            }
+        }
+
+        if (mismatches > 0) {
+            std::wcout << L"Verification: " << mismatches
+                << L" samples differ from what has been written" << std::endl;
+            std::filesystem::remove(path);
+            return -1;
+        }
+        std::wcout << L"Verification: all samples match" << std::endl;
+
+        std::filesystem::remove(path);
+        return 0;
+    } catch (std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        return -1;
+    }
+}
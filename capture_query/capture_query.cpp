@@ -0,0 +1,177 @@
+﻿// <copyright file="capture_query.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/capture_reader.h"
+#include "power_overwhelming/convert_string.h"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#include <tchar.h>
+#endif /* defined(_WIN32) */
+
+#if !defined(_tmain)
+#define _tmain main
+#define TCHAR char
+#define _T(x) (x)
+#endif /* !defined(_tmain) */
+
+
+namespace {
+
+    using namespace visus::power_overwhelming;
+
+    /// <summary>
+    /// Answer all values following <paramref name="option" />.
+    /// </summary>
+    std::vector<std::wstring> get_options(
+            const std::vector<std::basic_string<TCHAR>>& cmd_line,
+            const TCHAR *option) {
+        std::vector<std::wstring> retval;
+
+        for (auto it = cmd_line.begin(); it != cmd_line.end(); ++it) {
+            if ((*it == option) && (it + 1 != cmd_line.end())) {
+                retval.push_back(convert_string<wchar_t>(*++it));
+            }
+        }
+
+        return retval;
+    }
+
+    /// <summary>
+    /// Answer the ID of the sensor or marker with the given name.
+    /// </summary>
+    template<class TGetter>
+    capture_reader::id_type find_id(const std::size_t cnt, TGetter&& get,
+            const std::wstring& name) {
+        for (capture_reader::id_type i = 0; i < cnt; ++i) {
+            if (name == get(i)) {
+                return i;
+            }
+        }
+
+        throw std::invalid_argument("The capture does not contain \""
+            + convert_string<char>(name) + "\".");
+    }
+}
+
+
+/// <summary>
+/// Entry point of the capture_query utility, which computes the energy
+/// consumed per sensor and marker in a capture file or extracts the samples
+/// in a time range.
+/// </summary>
+/// <param name="argc"></param>
+/// <param name="argv"></param>
+/// <returns></returns>
+int _tmain(const int argc, const TCHAR **argv) {
+    using namespace visus::power_overwhelming;
+
+    const std::vector<std::basic_string<TCHAR>> cmd_line(argv, argv + argc);
+
+    if ((argc < 2) || (std::find(cmd_line.begin(), cmd_line.end(),
+            _T("--help")) != cmd_line.end())) {
+        std::wcout << L"Computes the energy per sensor and marker in a "
+            << L"capture file or extracts its" << std::endl
+            << L"samples. Timestamps are given in 100 ns ticks as recorded "
+            << L"by the collector." << std::endl << std::endl;
+        std::wcout << L"Usage: capture_query <capture> [--sensor <name>]... "
+            << L"[--marker <name>]" << std::endl
+            << L"    [--begin <ticks>] [--end <ticks>] [--samples]"
+            << std::endl;
+        return (argc < 2) ? -1 : 0;
+    }
+
+    try {
+        capture_reader reader(convert_string<wchar_t>(cmd_line[1]).c_str());
+        capture_filter filter;
+
+        if (!reader.complete()) {
+            std::wcerr << L"The capture has not been closed properly. Only "
+                << L"the complete blocks are used." << std::endl;
+        }
+
+        for (auto& b : get_options(cmd_line, _T("--begin"))) {
+            filter.begin(timestamp(std::stoll(b)));
+        }
+
+        for (auto& e : get_options(cmd_line, _T("--end"))) {
+            filter.end(timestamp(std::stoll(e)));
+        }
+
+        for (auto& s : get_options(cmd_line, _T("--sensor"))) {
+            filter.sensor(find_id(reader.sensors(), [&reader](
+                    const capture_reader::id_type i) {
+                return reader.sensor(i);
+            }, s));
+        }
+
+        if (std::find(cmd_line.begin(), cmd_line.end(), _T("--samples"))
+                != cmd_line.end()) {
+            // Extract the raw samples as CSV. The marker filter does not
+            // apply here, because the series do not contain the markers.
+            std::wcout << L"sensor,timestamp,voltage,current,power"
+                << std::endl;
+
+            for (capture_reader::id_type s = 0; s < reader.sensors(); ++s) {
+                const auto series = reader.read(s, filter);
+                for (auto& d : series) {
+                    std::wcout << reader.sensor(s) << L","
+                        << d.timestamp().value() << L","
+                        << d.voltage() << L","
+                        << d.current() << L","
+                        << d.power() << std::endl;
+                }
+            }
+
+            return 0;
+        }
+
+        const auto markers = get_options(cmd_line, _T("--marker"));
+        std::vector<capture_reader::id_type> marker_ids;
+        for (auto& m : markers) {
+            marker_ids.push_back(find_id(reader.markers(), [&reader](
+                    const capture_reader::id_type i) {
+                return reader.marker(i);
+            }, m));
+        }
+
+        std::vector<capture_aggregate> aggregates(reader.sensors()
+            * (reader.markers() + 1));
+        aggregates.resize(reader.aggregate(aggregates.data(),
+            aggregates.size(), filter));
+
+        std::wcout << L"sensor,marker,samples,duration [s],energy [J],"
+            << L"mean [W],max [W]" << std::endl;
+
+        for (auto& a : aggregates) {
+            if (!marker_ids.empty() && (std::find(marker_ids.begin(),
+                    marker_ids.end(), a.marker) == marker_ids.end())) {
+                continue;
+            }
+
+            std::wcout << reader.sensor(a.sensor) << L","
+                << ((a.marker == capture_writer::no_marker)
+                    ? L""
+                    : reader.marker(a.marker)) << L","
+                << a.samples << L","
+                << a.duration << L","
+                << a.energy << L","
+                << a.mean_power << L","
+                << a.max_power << std::endl;
+        }
+
+        return 0;
+    } catch (std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        return -1;
+    }
+}
@@ -37,6 +37,18 @@ namespace power_overwhelming {
         /// <see cref="async_sampling::on_throttling_sample_callback" />.
         /// </summary>
         on_throttling_sample,
+
+        /// <summary>
+        /// Delivers views of the raw sample arrays of a sensor to an
+        /// <see cref="async_sampling::on_measurement_data_view_callback" />.
+        /// </summary>
+        on_measurement_data_view,
+
+        /// <summary>
+        /// Delivers all quantities measured by an HMC8015 to an
+        /// <see cref="async_sampling::on_hmc8015_sample_callback" />.
+        /// </summary>
+        on_hmc8015_sample,
     };
 
 } /* namespace power_overwhelming */
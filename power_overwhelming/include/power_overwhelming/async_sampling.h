@@ -18,8 +18,10 @@
 #endif /* defined(_WIN32) */
 
 #include "power_overwhelming/async_delivery_method.h"
+#include "power_overwhelming/hmc8015_sample.h"
 #include "power_overwhelming/measurement.h"
 #include "power_overwhelming/measurement_data_series.h"
+#include "power_overwhelming/measurement_data_view.h"
 #include "power_overwhelming/thermal_sample.h"
 #include "power_overwhelming/throttling_sample.h"
 #include "power_overwhelming/tinkerforge_sensor_source.h"
@@ -30,6 +32,7 @@ namespace power_overwhelming {
 
     /* Forward declarations. */
     class sensor;
+    class time_synchroniser;
 
 
     /// <summary>
@@ -73,6 +76,24 @@ namespace power_overwhelming {
             _In_ const measurement_data *, _In_ const std::size_t,
             _In_opt_ void *);
 
+        /// <summary>
+        /// The type of callback to be invoked if a sensor produced one or more
+        /// blocks of regularly sampled data, which are delivered as
+        /// <see cref="measurement_data_view" />s without expanding them into
+        /// <see cref="measurement_data" />.
+        /// </summary>
+        typedef void (*on_measurement_data_view_callback)(
+            _In_z_ const wchar_t *, _In_ const measurement_data_view *,
+            _In_ const std::size_t, _In_opt_ void *);
+
+        /// <summary>
+        /// The type of callback used for delivering
+        ///  <see cref="hmc8015_sample" />s.
+        /// </summary>
+        typedef void (*on_hmc8015_sample_callback)(_In_z_ const wchar_t *,
+            _In_ const hmc8015_sample *, _In_ const std::size_t,
+            _In_opt_ void *);
+
         /// <summary>
         /// The type of callback used for delivering
         ///  <see cref="thermal_sample" />s.
@@ -135,6 +156,65 @@ namespace power_overwhelming {
             return std::move(*this);
         }
 
+        /// <summary>
+        /// Answer the number of samples a Tinkerforge sensor accumulates
+        /// before delivering them at once.
+        /// </summary>
+        /// <returns>The number of samples per delivery.</returns>
+        inline std::size_t batch_size(void) const noexcept {
+            return this->_batch_size;
+        }
+
+        /// <summary>
+        /// If the sensor this sampling configuration is passed to is a
+        /// Tinkerforge sensor, instructs the sensor to combine the readings of
+        /// all sources into one sample if they have been received within the
+        /// specified time window.
+        /// </summary>
+        /// <remarks>
+        /// <para>Tinkerforge bricklets report current, power and voltage via
+        /// separate callbacks. The sensor delivers a sample only after it has
+        /// received all sources requested via <see cref="from_source" />. If
+        /// the readings of one period are further apart than the given window,
+        /// the period is discarded.</para>
+        /// <para>If the sensor is not a Tinkerforge sensor, this setting has no
+        /// effect.</para>
+        /// </remarks>
+        /// <param name="window">The maximum time between the first and the
+        /// last reading of a sample in microseconds. If zero, which is the
+        /// default, the sampling interval of the bricklet is used.</param>
+        /// <returns><c>*this</c>.</returns>
+        async_sampling& coalesces_within(
+            _In_ const microseconds_type window) noexcept;
+
+        /// <summary>
+        /// If the sensor this sampling configuration is passed to is a
+        /// Tinkerforge sensor, instructs the sensor to combine the readings of
+        /// all sources into one sample if they have been received within the
+        /// specified time window.
+        /// </summary>
+        /// <typeparam name="TValue">The type of the counter.</typeparam>
+        /// <typeparam name="TPeriod">The period of the duration.</typeparam>
+        /// <param name="window">The maximum time between the first and the
+        /// last reading of a sample.</param>
+        /// <returns><c>*this</c>.</returns>
+        template<class TValue, class TPeriod>
+        inline async_sampling& coalesces_within(
+                _In_ const std::chrono::duration<TValue, TPeriod> window) {
+            return this->coalesces_within(std::chrono::duration_cast<
+                std::chrono::microseconds>(window).count());
+        }
+
+        /// <summary>
+        /// Answer the time window within which the readings of a Tinkerforge
+        /// sensor are combined into a single sample.
+        /// </summary>
+        /// <returns>The window in microseconds, or zero if the sampling
+        /// interval should be used.</returns>
+        inline microseconds_type coalescing_window(void) const noexcept {
+            return this->_coalescing_window;
+        }
+
         /// <summary>
         /// Gets the user-defined context, if any, to be passed to the callback.
         /// </summary>
@@ -218,6 +298,89 @@ namespace power_overwhelming {
             return this->deliver(source, &sample, 1);
         }
 
+        /// <summary>
+        /// Invoke the callback for a <see cref="measurement_data_view" /> or,
+        /// if the sampling has been configured for another kind of power
+        /// samples, expand the views and deliver these samples.
+        /// </summary>
+        /// <remarks>
+        /// <para>This method is not thread-safe. Callers must make sure that
+        /// the instance is not changed while the callback is invoked from the
+        /// sampler thread.</para>
+        /// <para>If the callback accepts views, these are passed on as they
+        /// are. Otherwise, the samples referenced by the views are expanded
+        /// into <see cref="measurement_data" /> before they are delivered,
+        /// which incurs a heap allocation for all samples.</para>
+        /// </remarks>
+        /// <param name="source">The name of the sensor from which the
+        /// <paramref name="views" /> originate. This must not be
+        /// <c>nullptr</c>.</param>
+        /// <param name="views">A pointer to <paramref name="cnt" /> views
+        /// to deliver to the registered callback.</param>
+        /// <param name="cnt">The number of views to deliver.</param>
+        /// <returns><c>true</c> if a callback was invoked, <c>false</c> if none
+        /// has been set.</returns>
+        bool deliver(_In_z_ const wchar_t *source,
+            _In_reads_(cnt) const measurement_data_view *views,
+            _In_ const std::size_t cnt) const;
+
+        /// <summary>
+        /// Invoke the callback for a <see cref="measurement_data_view" /> or,
+        /// if the sampling has been configured for another kind of power
+        /// samples, expand the view and deliver these samples.
+        /// </summary>
+        /// <param name="source">The name of the sensor from which the
+        /// <paramref name="view" /> originates. This must not be
+        /// <c>nullptr</c>.</param>
+        /// <param name="view">The view to deliver.</param>
+        /// <returns><c>true</c> if a callback was invoked, <c>false</c> if none
+        /// has been set.</returns>
+        inline bool deliver(_In_z_ const wchar_t *source,
+                _In_ const measurement_data_view& view) const {
+            return this->deliver(source, &view, 1);
+        }
+
+        /// <summary>
+        /// Invoke the callback for a <see cref="hmc8015_sample" /> for
+        /// the <see cref="samples" /> provided to the method.
+        /// </summary>
+        /// <remarks>
+        /// <para>This method is not thread-safe. Callers must make sure that
+        /// the instance is not changed while the callback is invoked from the
+        /// sampler thread.</para>
+        /// </remarks>
+        /// <param name="source">The name of the sensor from which the
+        /// <paramref name="samples" /> originate. This must not be
+        /// <c>nullptr</c>.</param>
+        /// <param name="samples">A pointer to <paramref name="cnt" /> samples
+        /// to deliver to the registered callback.</param>
+        /// <param name="cnt">The number of samples to deliver.</param>
+        /// <returns><c>true</c> if a callback was invoked, <c>false</c> if none
+        /// has been set.</returns>
+        bool deliver(_In_ const wchar_t *source,
+            _In_reads_(cnt) const hmc8015_sample *samples,
+            _In_ const std::size_t cnt) const;
+
+        /// <summary>
+        /// Invoke the callback for a <see cref="hmc8015_sample" /> for
+        /// the <see cref="sample" /> provided to the method.
+        /// </summary>
+        /// <remarks>
+        /// <para>This method is not thread-safe. Callers must make sure that
+        /// the instance is not changed while the callback is invoked from the
+        /// sampler thread.</para>
+        /// </remarks>
+        /// <param name="source">The name of the sensor from which the
+        /// <paramref name="sample" /> originate. This must not be
+        /// <c>nullptr</c>.</param>
+        /// <param name="sample">The sample to deliver.</param>
+        /// <returns><c>true</c> if a callback was invoked, <c>false</c> if none
+        /// has been set.</returns>
+        inline bool deliver(_In_ const wchar_t *source,
+                const hmc8015_sample& sample) const {
+            return this->deliver(source, &sample, 1);
+        }
+
         /// <summary>
         /// Invoke the callback for a <see cref="throttling_sample" /> for
         /// the <see cref="samples" /> provided to the method.
@@ -300,6 +463,68 @@ namespace power_overwhelming {
             return this->deliver(source, &sample, 1);
         }
 
+        /// <summary>
+        /// Configures the <see cref="hmc8015_sensor" /> to deliver all of the
+        /// quantities it measures as <see cref="hmc8015_sample" />s to the
+        /// given <paramref name="callback" />.
+        /// </summary>
+        /// <param name="callback">The callbeck to deliver to. If this is
+        /// <c>nullptr</c>, sampling will be disabled (this is equivalent to
+        /// calling <see cref="is_disabled" />).</param>
+        /// <returns><c>*this</c>.</returns>
+        async_sampling& delivers_hmc8015_samples_to(
+            _In_opt_ const on_hmc8015_sample_callback callback) noexcept;
+
+        /// <summary>
+        /// Configures the <see cref="hmc8015_sensor" /> to deliver samples of
+        /// type <see cref="hmc8015_sample" /> to a callable like a functor
+        /// object or <see cref="std::function" />.
+        /// </summary>
+        /// <remarks>
+        /// See <see cref="delivers_measurement_data_to_functor" /> for
+        /// implementation details.
+        /// </remarks>
+        /// <typeparam name="TFunctor">The type of the functor being called.
+        /// This type must be convertible to
+        /// <c>std::function<void(const wchar_t *, const hmc8015_sample *, const std::size_t)></c>.
+        /// Note that you cannot pass a context to your callback here, because
+        /// the context is reserved to store the <c>std::function</c> itself. If
+        /// you need contextual information, you have to use a lambda capture.
+        /// </typeparam>
+        /// <param name="callback">The functor to be invoked.</param>
+        /// <returns><c>*this</c>.</returns>
+        template<class TFunctor>
+        async_sampling& delivers_hmc8015_samples_to_functor(
+            _In_ TFunctor&& callback);
+
+        /// <summary>
+        /// If the sensor this sampling configuration is passed to is a
+        /// Tinkerforge sensor, instructs the sensor to stream its data by
+        /// accumulating <paramref name="cnt" /> samples and delivering them
+        /// at once.
+        /// </summary>
+        /// <remarks>
+        /// <para>In streaming mode, the sensor does not request callbacks from
+        /// the bricklet more often than the ADC can produce new values with
+        /// its current averaging and conversion time configuration. The
+        /// requested sampling interval is therefore only a lower bound. The
+        /// samples are delivered as an array if the callback receives
+        /// <see cref="measurement_data" />. Any incomplete batch is delivered
+        /// when asynchronous sampling is disabled.</para>
+        /// <para>A batch is also delivered before it is full once its oldest
+        /// sample is older than <paramref name="cnt" /> times the coalescing
+        /// window, which defaults to the sampling interval. The check is made
+        /// whenever a new sample arrives, so the latency is bounded by this
+        /// age plus one sampling interval.</para>
+        /// <para>If the sensor is not a Tinkerforge sensor, this setting has no
+        /// effect.</para>
+        /// </remarks>
+        /// <param name="cnt">The number of samples per delivery. Zero and one
+        /// deliver every sample immediately, which is the default.</param>
+        /// <returns><c>*this</c>.</returns>
+        async_sampling& delivers_in_batches_of(
+            _In_ const std::size_t cnt) noexcept;
+
         /// <summary>
         /// Configures the <see cref="sensor" /> such that it produces samples
         /// of type <see cref="measurement" />.
@@ -376,6 +601,50 @@ namespace power_overwhelming {
         async_sampling& delivers_measurement_data_to_functor(
             _In_ TFunctor&& callback);
 
+        /// <summary>
+        /// Configures the <see cref="sensor" /> to deliver views of its raw
+        /// sample arrays instead of individual <see cref="measurement_data" />.
+        /// </summary>
+        /// <remarks>
+        /// <para>This delivery method is intended for sensors producing large
+        /// blocks of regularly sampled data like the <see cref="rtx_sensor" />.
+        /// Such sensors hand out the arrays they received from the instrument
+        /// along with the time base, which avoids constructing and storing a
+        /// <see cref="measurement_data" /> for each sample. The callback can
+        /// expand the samples on demand using
+        /// <see cref="measurement_data_view::expand" />.</para>
+        /// <para>Sensors that do not produce blocks of samples do not support
+        /// this delivery method.</para>
+        /// </remarks>
+        /// <param name="callback">The callbeck to deliver to. If this is
+        /// <c>nullptr</c>, sampling will be disabled (this is equivalent to
+        /// calling <see cref="is_disabled" />).</param>
+        /// <returns><c>*this</c>.</returns>
+        async_sampling& delivers_measurement_data_views_to(
+            _In_opt_ const on_measurement_data_view_callback callback) noexcept;
+
+        /// <summary>
+        /// Configures the <see cref="sensor" /> to deliver views of its raw
+        /// sample arrays to a callable like a functor object or
+        /// <see cref="std::function" />.
+        /// </summary>
+        /// <remarks>
+        /// See <see cref="delivers_measurement_data_to_functor" /> for
+        /// implementation details.
+        /// </remarks>
+        /// <typeparam name="TFunctor">The type of the functor being called.
+        /// This type must be convertible to
+        /// <c>std::function<void(const wchar_t *, const measurement_data_view *, const std::size_t)></c>.
+        /// Note that you cannot pass a context to your callback here, because
+        /// the context is reserved to store the <c>std::function</c> itself. If
+        /// you need contextual information, you have to use a lambda capture.
+        /// </typeparam>
+        /// <param name="callback">The functor to be invoked.</param>
+        /// <returns><c>*this</c>.</returns>
+        template<class TFunctor>
+        async_sampling& delivers_measurement_data_views_to_functor(
+            _In_ TFunctor&& callback);
+
         /// <summary>
         /// Configures the <see cref="thermal_sensor" /> to deliver samples
         /// of type <see cref="thermal_sample" /> to the given
@@ -688,6 +957,38 @@ namespace power_overwhelming {
         template<class TContext>
         async_sampling& stores_and_passes_context(_In_ TContext&& context);
 
+        /// <summary>
+        /// Configures the sampling to transform the timestamps of all
+        /// <see cref="measurement_data" /> into the clock of the reference peer
+        /// of the given <see cref="time_synchroniser" /> before they are
+        /// delivered.
+        /// </summary>
+        /// <remarks>
+        /// <para>The transformation is applied to samples delivered as
+        /// <see cref="measurement" /> or <see cref="measurement_data" />. Views
+        /// delivered via <see cref="delivers_measurement_data_views_to" /> are
+        /// passed on unchanged.</para>
+        /// <para>The caller remains owner of the synchroniser and must make
+        /// sure that it lives as long as the sensor is sampling.</para>
+        /// </remarks>
+        /// <param name="synchroniser">The synchroniser used to transform the
+        /// timestamps. If this is <c>nullptr</c>, the local timestamps are
+        /// delivered.</param>
+        /// <returns><c>*this</c>.</returns>
+        async_sampling& synchronises_with(
+            _In_opt_ const power_overwhelming::time_synchroniser *synchroniser)
+            noexcept;
+
+        /// <summary>
+        /// Answer the synchroniser used to transform timestamps into the clock
+        /// of a reference peer.
+        /// </summary>
+        /// <returns>The synchroniser, which may be <c>nullptr</c>.</returns>
+        inline const power_overwhelming::time_synchroniser *
+        time_synchroniser(void) const noexcept {
+            return this->_time_synchroniser;
+        }
+
         /// <summary>
         /// Answer the Tinkerforge sensor data to obtain in case the sensor
         /// is a Tinkerforge sensor.
@@ -721,7 +1022,9 @@ namespace power_overwhelming {
         /// </summary>
         union delivery_callback {
             on_measurement_callback on_measurement;
+            on_hmc8015_sample_callback on_hmc8015_samples;
             on_measurement_data_callback on_measurement_data;
+            on_measurement_data_view_callback on_measurement_data_views;
             on_thermal_sample_callback on_thermal_samples;
             on_throttling_sample_callback on_throttling_samples;
         };
@@ -733,6 +1036,14 @@ namespace power_overwhelming {
             == sizeof(on_measurement_data_callback),
             "Implementation assumes no padding around on_measurement "
             "on_measurement_data.");
+        static_assert(sizeof(delivery_callback)
+            == sizeof(on_measurement_data_view_callback),
+            "Implementation assumes no padding around on_measurement "
+            "on_measurement_data_views.");
+        static_assert(sizeof(delivery_callback)
+            == sizeof(on_hmc8015_sample_callback),
+            "Implementation assumes no padding around on_measurement "
+            "on_hmc8015_samples.");
         static_assert(sizeof(delivery_callback)
             == sizeof(on_thermal_sample_callback),
             "Implementation assumes no padding around on_measurement "
@@ -742,12 +1053,15 @@ namespace power_overwhelming {
             "Implementation assumes no padding around on_measurement "
             "on_throttling_samples.");
 
+        std::size_t _batch_size;
         delivery_callback _callback;
+        microseconds_type _coalescing_window;
         void *_context;
         void (CALLBACK *_context_deleter)(void *);
         async_delivery_method _delivery_method;
         microseconds_type _interval;
         microseconds_type _minimum_sleep;
+        const power_overwhelming::time_synchroniser *_time_synchroniser;
         power_overwhelming::tinkerforge_sensor_source
             _tinkerforge_sensor_source;
     };
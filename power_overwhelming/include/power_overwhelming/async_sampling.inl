@@ -5,6 +5,25 @@
 // <author>Christoph Müller</author>
 
 
+/*
+ * ...::async_sampling::delivers_hmc8015_samples_to_functor
+ */
+template<class TFunctor>
+visus::power_overwhelming::async_sampling&
+visus::power_overwhelming::async_sampling::delivers_hmc8015_samples_to_functor(
+        _In_ TFunctor&& callback) {
+    typedef std::function<void(const wchar_t *, const hmc8015_sample *,
+        const std::size_t)> function_type;
+    this->stores_and_passes_context(function_type(
+        std::forward<TFunctor>(callback)));
+    this->delivers_hmc8015_samples_to([](const wchar_t *n,
+            const hmc8015_sample *m, const size_t s, void *c) {
+        (*static_cast<function_type *>(c))(n, m, s);
+    });
+    return *this;
+}
+
+
 /*
  * ...::async_sampling::delivers_measurement_data_to_functor
  */
@@ -24,6 +43,25 @@ visus::power_overwhelming::async_sampling::delivers_measurement_data_to_functor(
 }
 
 
+/*
+ * ...::async_sampling::delivers_measurement_data_views_to_functor
+ */
+template<class TFunctor>
+visus::power_overwhelming::async_sampling&
+visus::power_overwhelming::async_sampling::delivers_measurement_data_views_to_functor(
+        _In_ TFunctor&& callback) {
+    typedef std::function<void(const wchar_t *, const measurement_data_view *,
+        const std::size_t)> function_type;
+    this->stores_and_passes_context(function_type(
+        std::forward<TFunctor>(callback)));
+    this->delivers_measurement_data_views_to([](const wchar_t *n,
+            const measurement_data_view *v, const size_t s, void *c) {
+        (*static_cast<function_type *>(c))(n, v, s);
+    });
+    return *this;
+}
+
+
 /*
  * ...::async_sampling::delivers_thermal_samples_to_functor
  */
@@ -19,6 +19,14 @@ namespace power_overwhelming {
     /// <summary>
     /// A block of binary data.
     /// </summary>
+    /// <remarks>
+    /// <para>The memory of a blob is drawn from a pool of power-of-two size
+    /// classes with thread-local free lists, which makes repeated allocations
+    /// of similar size, like in instrument I/O, cheap. As a consequence, the
+    /// <see cref="capacity" /> of a blob can be larger than its
+    /// <see cref="size" />, and changing the size within the capacity does
+    /// not reallocate the blob.</para>
+    /// </remarks>
     class POWER_OVERWHELMING_API blob final {
 
     public:
@@ -31,7 +39,7 @@ namespace power_overwhelming {
         /// <summary>
           /// Initialises a new and empty instance.
           /// </summary>
-        inline blob(void) noexcept : _data(nullptr), _size(0) { }
+        inline blob(void) noexcept : _capacity(0), _data(nullptr), _size(0) { }
 
         /// <summary>
         /// Initialises a new instance.
@@ -39,8 +47,7 @@ namespace power_overwhelming {
         /// <param name="size">The size of the blob in bytes.</param>
         /// <exception cref="std::bad_alloc">If the required memory could not
         /// be allocated.</exception>
-        explicit inline blob(_In_ const std::size_t size)
-            : _data(new byte_type[size]), _size(size) { }
+        explicit blob(_In_ const std::size_t size);
 
         /// <summary>
         /// Initialises a new blob from existing data.
@@ -194,6 +201,16 @@ namespace power_overwhelming {
             return this->as<byte_type>();
         }
 
+        /// <summary>
+        /// Answer the number of bytes the blob can hold without being
+        /// reallocated.
+        /// </summary>
+        /// <returns>The capacity of the blob in bytes, which is at least
+        /// <see cref="size" />.</returns>
+        inline std::size_t capacity(void) const noexcept {
+            return this->_capacity;
+        }
+
         /// <summary>
         /// Deallocate all data.
         /// </summary>
@@ -261,8 +278,9 @@ namespace power_overwhelming {
         /// </remarks>
         /// <param name="size">The required minimum size of the blob, in bytes.
         /// </param>
-        /// <returns><c>true</c> if the blob was reallocated, <c>false</c> if
-        /// the previous capacity was sufficient.</returns>
+        /// <returns><c>true</c> if the blob was enlarged, <c>false</c> if
+        /// the previous size was sufficient. The blob is only reallocated if
+        /// the new size exceeds its <see cref="capacity" />.</returns>
         /// <exception cref="std::bad_alloc">If the required memory could not
         /// be allocated.</exception>
         bool grow(_In_ const std::size_t size);
@@ -311,8 +329,9 @@ namespace power_overwhelming {
         /// </remarks>
         /// <param name="size">The required minimum size of the blob, in bytes.
         /// </param>
-        /// <returns><c>true</c> if the blob was reallocated, <c>false</c> if
-        /// the previous capacity was sufficient.</returns>
+        /// <returns><c>true</c> if the blob was enlarged and the existing
+        /// data may have been invalidated, <c>false</c> if the previous size
+        /// was sufficient.</returns>
         /// <exception cref="std::bad_alloc">If the required memory could not
         /// be allocated.</exception>
         bool reserve(_In_ const std::size_t size);
@@ -322,8 +341,10 @@ namespace power_overwhelming {
         /// <paramref name="size" /> in bytes.
         /// </summary>
         /// <remarks>
-        /// <para>If the buffer does not already have the requested size, any
-        /// existing data will be lost.</para>
+        /// <para>If the buffer does not already have the requested size, the
+        /// content of the blob is unspecified afterwards. The blob is only
+        /// reallocated if the requested size exceeds its
+        /// <see cref="capacity" /> or if it is zero.</para>
         /// <para>You can achieve the same effect by calling
         /// <see cref="blob::truncate" />, but preserve any exisiting content
         /// during the operation.</para>
@@ -413,6 +434,7 @@ namespace power_overwhelming {
 
     private:
 
+        std::size_t _capacity;
         byte_type *_data;
         std::size_t _size;
 
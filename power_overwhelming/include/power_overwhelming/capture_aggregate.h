@@ -0,0 +1,80 @@
+﻿// <copyright file="capture_aggregate.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+
+#include "power_overwhelming/capture_writer.h"
+#include "power_overwhelming/timestamp.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /// <summary>
+    /// Summarises the power samples of a sensor in a capture while a specific
+    /// marker was active.
+    /// </summary>
+    /// <remarks>
+    /// The energy is the integral of the power over time, which is computed
+    /// by holding the power of each sample until the next sample of the same
+    /// sensor. The interval between two samples is attributed to the marker
+    /// of the first one. Samples without valid power are ignored.
+    /// </remarks>
+    struct POWER_OVERWHELMING_API capture_aggregate final {
+
+        /// <summary>
+        /// The timestamp of the first sample.
+        /// </summary>
+        timestamp begin;
+
+        /// <summary>
+        /// The time in seconds covered by the intervals between the samples,
+        /// which is the time <see cref="energy" /> was consumed in.
+        /// </summary>
+        double duration;
+
+        /// <summary>
+        /// The timestamp of the last sample.
+        /// </summary>
+        timestamp end;
+
+        /// <summary>
+        /// The energy in Joules.
+        /// </summary>
+        double energy;
+
+        /// <summary>
+        /// The marker that was active, which is
+        /// <see cref="capture_writer::no_marker" /> for samples without
+        /// marker.
+        /// </summary>
+        capture_writer::id_type marker;
+
+        /// <summary>
+        /// The largest power in Watts.
+        /// </summary>
+        float max_power;
+
+        /// <summary>
+        /// The arithmetic mean of the power of all samples in Watts.
+        /// </summary>
+        double mean_power;
+
+        /// <summary>
+        /// The number of samples.
+        /// </summary>
+        std::uint64_t samples;
+
+        /// <summary>
+        /// The sensor the samples belong to.
+        /// </summary>
+        capture_writer::id_type sensor;
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
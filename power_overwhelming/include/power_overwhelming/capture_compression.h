@@ -0,0 +1,32 @@
+﻿// <copyright file="capture_compression.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /// <summary>
+    /// Specifies the general-purpose compressor applied to the blocks of a
+    /// capture file on top of the encoding of the samples.
+    /// </summary>
+    enum class capture_compression {
+
+        /// <summary>
+        /// Store the encoded samples as they are.
+        /// </summary>
+        none = 0,
+
+        /// <summary>
+        /// Compress each block using Zstandard. This is only available if the
+        /// library has been built with <c>PWROWG_WithZstd</c>.
+        /// </summary>
+        zstd = 1
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,168 @@
+﻿// <copyright file="capture_filter.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cstddef>
+
+#include "power_overwhelming/capture_writer.h"
+#include "power_overwhelming/timestamp.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /// <summary>
+    /// Selects the samples that a <see cref="capture_reader" /> extracts or
+    /// aggregates by their time and sensor.
+    /// </summary>
+    /// <remarks>
+    /// The reader uses the filter to skip whole blocks based on their index
+    /// entries, which is what makes queries on large captures fast.
+    /// </remarks>
+    class POWER_OVERWHELMING_API capture_filter final {
+
+    public:
+
+        /// <summary>
+        /// The type used to identify sensors.
+        /// </summary>
+        typedef capture_writer::id_type id_type;
+
+        /// <summary>
+        /// Initialises a new instance that selects all samples.
+        /// </summary>
+        capture_filter(void) noexcept;
+
+        /// <summary>
+        /// Clone <paramref name="rhs" />.
+        /// </summary>
+        /// <param name="rhs">The object to be cloned.</param>
+        capture_filter(_In_ const capture_filter& rhs);
+
+        /// <summary>
+        /// Move <paramref name="rhs" /> into a new instance.
+        /// </summary>
+        /// <param name="rhs">The object to be moved.</param>
+        capture_filter(_Inout_ capture_filter&& rhs) noexcept;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~capture_filter(void);
+
+        /// <summary>
+        /// Gets the begin of the selected time range.
+        /// </summary>
+        /// <returns>The timestamp of the earliest sample selected.</returns>
+        inline power_overwhelming::timestamp begin(void) const noexcept {
+            return this->_begin;
+        }
+
+        /// <summary>
+        /// Sets the begin of the selected time range.
+        /// </summary>
+        /// <param name="begin">The timestamp of the earliest sample selected.
+        /// </param>
+        /// <returns><c>*this</c>.</returns>
+        capture_filter& begin(
+            _In_ const power_overwhelming::timestamp begin) noexcept;
+
+        /// <summary>
+        /// Gets the end of the selected time range.
+        /// </summary>
+        /// <returns>The first timestamp after the selected range.</returns>
+        inline power_overwhelming::timestamp end(void) const noexcept {
+            return this->_end;
+        }
+
+        /// <summary>
+        /// Sets the end of the selected time range.
+        /// </summary>
+        /// <param name="end">The first timestamp after the selected range.
+        /// </param>
+        /// <returns><c>*this</c>.</returns>
+        capture_filter& end(
+            _In_ const power_overwhelming::timestamp end) noexcept;
+
+        /// <summary>
+        /// Answer whether the filter selects samples taken at the given time.
+        /// </summary>
+        /// <param name="timestamp">The time to be tested.</param>
+        /// <returns><c>true</c> if the time is within the range, <c>false</c>
+        /// otherwise.</returns>
+        inline bool matches(
+                _In_ const power_overwhelming::timestamp timestamp)
+                const noexcept {
+            return (timestamp >= this->_begin) && (timestamp < this->_end);
+        }
+
+        /// <summary>
+        /// Answer whether the filter selects the given sensor.
+        /// </summary>
+        /// <param name="sensor">The ID of the sensor to be tested.</param>
+        /// <returns><c>true</c> if the sensor is selected, <c>false</c>
+        /// otherwise.</returns>
+        bool matches(_In_ const id_type sensor) const noexcept;
+
+        /// <summary>
+        /// Answer whether the filter selects any samples between the two
+        /// given points in time.
+        /// </summary>
+        /// <param name="begin">The timestamp of the first sample.</param>
+        /// <param name="end">The timestamp of the last sample, which is
+        /// inclusive.</param>
+        /// <returns><c>true</c> if the range overlaps with the filter,
+        /// <c>false</c> otherwise.</returns>
+        inline bool overlaps(_In_ const power_overwhelming::timestamp begin,
+                _In_ const power_overwhelming::timestamp end) const noexcept {
+            return (begin < this->_end) && (end >= this->_begin);
+        }
+
+        /// <summary>
+        /// Adds the given sensor to the selected sensors.
+        /// </summary>
+        /// <remarks>
+        /// If no sensor has been added, all sensors are selected.
+        /// </remarks>
+        /// <param name="sensor">The ID of the sensor to be selected.</param>
+        /// <returns><c>*this</c>.</returns>
+        capture_filter& sensor(_In_ const id_type sensor);
+
+        /// <summary>
+        /// Answer the number of sensors that have been added explicitly.
+        /// </summary>
+        /// <returns>The number of explicitly selected sensors, which is zero
+        /// if all sensors are selected.</returns>
+        inline std::size_t sensors(void) const noexcept {
+            return this->_cnt_sensors;
+        }
+
+        /// <summary>
+        /// Assignment.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand.</param>
+        /// <returns><c>*this</c>.</returns>
+        capture_filter& operator =(_In_ const capture_filter& rhs);
+
+        /// <summary>
+        /// Move assignment.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand.</param>
+        /// <returns><c>*this</c>.</returns>
+        capture_filter& operator =(_Inout_ capture_filter&& rhs) noexcept;
+
+    private:
+
+        power_overwhelming::timestamp _begin;
+        std::size_t _cnt_sensors;
+        power_overwhelming::timestamp _end;
+        id_type *_sensors;
+
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,232 @@
+﻿// <copyright file="capture_reader.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+
+#include "power_overwhelming/capture_aggregate.h"
+#include "power_overwhelming/capture_filter.h"
+#include "power_overwhelming/capture_writer.h"
+#include "power_overwhelming/measurement_data_series.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /* Forward declarations. */
+    namespace detail { struct capture_reader_impl; }
+
+
+    /// <summary>
+    /// Reads capture files created by <see cref="capture_writer" /> or by a
+    /// <see cref="collector" /> configured to write captures.
+    /// </summary>
+    /// <remarks>
+    /// <para>The reader tolerates captures that have not been closed properly,
+    /// in which case it returns all complete blocks at the begin of the file.
+    /// </para>
+    /// <para>The capture is mapped into memory rather than being read, and
+    /// the blocks selected by a query are decoded in parallel on all cores.
+    /// </para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API capture_reader final {
+
+    public:
+
+        /// <summary>
+        /// The type of string characters.
+        /// </summary>
+        typedef capture_writer::char_type char_type;
+
+        /// <summary>
+        /// The type used to identify sensors and markers in a capture.
+        /// </summary>
+        typedef capture_writer::id_type id_type;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <remarks>
+        /// The default instance is created disposed, ie cannot be used for
+        /// anything, but assigning another instance.
+        /// </remarks>
+        inline capture_reader(void) noexcept : _impl(nullptr) { }
+
+        /// <summary>
+        /// Opens the given capture file.
+        /// </summary>
+        /// <param name="path">The path to the capture file.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="path" /> is <c>nullptr</c>.</exception>
+        /// <exception cref="std::system_error">If the file could not be
+        /// read.</exception>
+        /// <exception cref="std::runtime_error">If the file is not a capture
+        /// or if it has been written by an incompatible version.</exception>
+        explicit capture_reader(_In_z_ const char_type *path);
+
+        capture_reader(const capture_reader&) = delete;
+
+        /// <summary>
+        /// Move <paramref name="rhs" /> into a new instance.
+        /// </summary>
+        /// <param name="rhs">The object to be moved.</param>
+        inline capture_reader(_In_ capture_reader&& rhs) noexcept
+                : _impl(rhs._impl) {
+            rhs._impl = nullptr;
+        }
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~capture_reader(void);
+
+        /// <summary>
+        /// Computes the energy and the mean and maximum power for each
+        /// combination of sensor and marker selected by
+        /// <paramref name="filter" />.
+        /// </summary>
+        /// <remarks>
+        /// The aggregates are computed block by block without materialising
+        /// the samples. They are sorted by sensor and marker, with samples
+        /// without marker coming last. There can be at most
+        /// <c>sensors() * (markers() + 1)</c> aggregates.
+        /// </remarks>
+        /// <param name="dst">A buffer receiving at most
+        /// <paramref name="cnt" /> aggregates. This parameter can be
+        /// <c>nullptr</c> if <paramref name="cnt" /> is zero.</param>
+        /// <param name="cnt">The number of elements that can be written to
+        /// <paramref name="dst" />.</param>
+        /// <param name="filter">Selects the time range and sensors to be
+        /// aggregated.</param>
+        /// <returns>The total number of aggregates, which might be larger
+        /// than <paramref name="cnt" />.</returns>
+        /// <exception cref="std::runtime_error">If the object has been
+        /// disposed or if a block is corrupt.</exception>
+        std::size_t aggregate(_Out_writes_opt_(cnt) capture_aggregate *dst,
+            _In_ const std::size_t cnt,
+            _In_ const capture_filter& filter = capture_filter()) const;
+
+        /// <summary>
+        /// Answer the number of blocks in the capture.
+        /// </summary>
+        /// <returns>The number of blocks, which is zero for disposed objects.
+        /// </returns>
+        std::size_t blocks(void) const noexcept;
+
+        /// <summary>
+        /// Answer whether the capture has been closed properly, ie whether
+        /// it ends with the index of its blocks.
+        /// </summary>
+        /// <returns><c>true</c> if the capture is complete, <c>false</c>
+        /// otherwise.</returns>
+        bool complete(void) const noexcept;
+
+        /// <summary>
+        /// Answer the name of the given marker.
+        /// </summary>
+        /// <param name="id">The ID of the marker.</param>
+        /// <returns>The name of the marker.</returns>
+        /// <exception cref="std::out_of_range">If <paramref name="id" /> does
+        /// not designate a marker in the capture.</exception>
+        /// <exception cref="std::runtime_error">If the object has been
+        /// disposed.</exception>
+        _Ret_z_ const char_type *marker(_In_ const id_type id) const;
+
+        /// <summary>
+        /// Answer the number of markers declared in the capture.
+        /// </summary>
+        /// <returns>The number of markers, which is zero for disposed objects.
+        /// </returns>
+        std::size_t markers(void) const noexcept;
+
+        /// <summary>
+        /// Reads all samples of the given sensor.
+        /// </summary>
+        /// <param name="sensor">The ID of the sensor.</param>
+        /// <returns>The samples of the sensor in the order they have been
+        /// written.</returns>
+        /// <exception cref="std::out_of_range">If <paramref name="sensor" />
+        /// does not designate a sensor in the capture.</exception>
+        /// <exception cref="std::runtime_error">If the object has been
+        /// disposed or if a block is corrupt.</exception>
+        measurement_data_series read(_In_ const id_type sensor) const;
+
+        /// <summary>
+        /// Reads the samples of the given sensor that are selected by
+        /// <paramref name="filter" />.
+        /// </summary>
+        /// <param name="sensor">The ID of the sensor.</param>
+        /// <param name="filter">Selects the time range to be read. If the
+        /// filter does not select <paramref name="sensor" />, the result is
+        /// empty.</param>
+        /// <returns>The selected samples of the sensor in the order they have
+        /// been written.</returns>
+        /// <exception cref="std::out_of_range">If <paramref name="sensor" />
+        /// does not designate a sensor in the capture.</exception>
+        /// <exception cref="std::runtime_error">If the object has been
+        /// disposed or if a block is corrupt.</exception>
+        measurement_data_series read(_In_ const id_type sensor,
+            _In_ const capture_filter& filter) const;
+
+        /// <summary>
+        /// Reads all samples of the given sensor.
+        /// </summary>
+        /// <param name="sensor">The name of the sensor.</param>
+        /// <returns>The samples of the sensor in the order they have been
+        /// written.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="sensor" /> is <c>nullptr</c> or if the capture
+        /// does not contain a sensor of this name.</exception>
+        /// <exception cref="std::runtime_error">If the object has been
+        /// disposed or if a block is corrupt.</exception>
+        measurement_data_series read(_In_z_ const char_type *sensor) const;
+
+        /// <summary>
+        /// Answer the name of the given sensor.
+        /// </summary>
+        /// <param name="id">The ID of the sensor.</param>
+        /// <returns>The name of the sensor.</returns>
+        /// <exception cref="std::out_of_range">If <paramref name="id" /> does
+        /// not designate a sensor in the capture.</exception>
+        /// <exception cref="std::runtime_error">If the object has been
+        /// disposed.</exception>
+        _Ret_z_ const char_type *sensor(_In_ const id_type id) const;
+
+        /// <summary>
+        /// Answer the number of sensors declared in the capture.
+        /// </summary>
+        /// <returns>The number of sensors, which is zero for disposed objects.
+        /// </returns>
+        std::size_t sensors(void) const noexcept;
+
+        capture_reader& operator =(const capture_reader&) = delete;
+
+        /// <summary>
+        /// Move assignment.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand</param>
+        /// <returns><c>*this</c></returns>
+        capture_reader& operator =(_In_ capture_reader&& rhs) noexcept;
+
+        /// <summary>
+        /// Determines whether the object is valid.
+        /// </summary>
+        /// <returns><c>true</c> if the object is valid, <c>false</c>
+        /// otherwise.</returns>
+        operator bool(void) const noexcept;
+
+    private:
+
+        void check_not_disposed(void) const;
+
+        detail::capture_reader_impl *_impl;
+
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
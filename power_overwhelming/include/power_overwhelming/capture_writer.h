@@ -0,0 +1,226 @@
+﻿// <copyright file="capture_writer.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include <limits>
+
+#include "power_overwhelming/capture_compression.h"
+#include "power_overwhelming/measurement.h"
+#include "power_overwhelming/measurement_data_series.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /* Forward declarations. */
+    namespace detail { struct capture_writer_impl; }
+
+
+    /// <summary>
+    /// Writes samples into a compressed capture file.
+    /// </summary>
+    /// <remarks>
+    /// <para>A capture stores the samples of each sensor in blocks. The
+    /// timestamps in a block are stored as the difference of their
+    /// differences, which is typically zero or very small for regular
+    /// sampling, and the values are stored as the XOR with their predecessor,
+    /// which is very small if consecutive values are close. Optionally, each
+    /// block can be compressed using a general-purpose compressor on top of
+    /// that.</para>
+    /// <para>Each block can be decoded independently, which allows for reading
+    /// captures in parallel. The samples of a sensor are buffered until a
+    /// block is full, wherefore the file is only complete once the writer
+    /// has been closed. Captures can be read using
+    /// <see cref="capture_reader" />.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API capture_writer final {
+
+    public:
+
+        /// <summary>
+        /// The type of string characters.
+        /// </summary>
+        typedef wchar_t char_type;
+
+        /// <summary>
+        /// The type used to identify sensors and markers in a capture.
+        /// </summary>
+        typedef std::uint32_t id_type;
+
+        /// <summary>
+        /// The default number of samples in a block.
+        /// </summary>
+        static constexpr std::size_t default_block_size = 8192;
+
+        /// <summary>
+        /// The ID indicating that no marker is set, which is the same as
+        /// <see cref="collector::no_marker" />.
+        /// </summary>
+        static constexpr id_type no_marker
+            = (std::numeric_limits<id_type>::max)();
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <remarks>
+        /// The default instance is created disposed, ie cannot be used for
+        /// anything, but assigning another instance.
+        /// </remarks>
+        inline capture_writer(void) noexcept : _impl(nullptr) { }
+
+        /// <summary>
+        /// Creates a new capture file, truncating it if it exists.
+        /// </summary>
+        /// <param name="path">The path to the capture file.</param>
+        /// <param name="compression">The general-purpose compressor applied
+        /// to the blocks.</param>
+        /// <param name="block_size">The maximum number of samples in a block.
+        /// </param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="path" /> is <c>nullptr</c> or if
+        /// <paramref name="block_size" /> is zero.</exception>
+        /// <exception cref="std::logic_error">If the library was built
+        /// without support for the requested compression.</exception>
+        /// <exception cref="std::system_error">If the file could not be
+        /// created.</exception>
+        explicit capture_writer(_In_z_ const char_type *path,
+            _In_ const capture_compression compression
+            = capture_compression::none,
+            _In_ const std::size_t block_size = default_block_size);
+
+        capture_writer(const capture_writer&) = delete;
+
+        /// <summary>
+        /// Move <paramref name="rhs" /> into a new instance.
+        /// </summary>
+        /// <param name="rhs">The object to be moved.</param>
+        inline capture_writer(_In_ capture_writer&& rhs) noexcept
+                : _impl(rhs._impl) {
+            rhs._impl = nullptr;
+        }
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        /// <remarks>
+        /// The destructor closes the file, but it discards any error doing so.
+        /// Call <see cref="close" /> explicitly in order to learn whether the
+        /// capture has been written completely.
+        /// </remarks>
+        ~capture_writer(void);
+
+        /// <summary>
+        /// Writes all pending samples and the index of the blocks, and closes
+        /// the file.
+        /// </summary>
+        /// <remarks>
+        /// It is safe to call this method multiple times and on disposed
+        /// objects.
+        /// </remarks>
+        /// <exception cref="std::system_error">If writing the file failed.
+        /// </exception>
+        void close(void);
+
+        /// <summary>
+        /// Ends the current block of all sensors, even if it is not full.
+        /// </summary>
+        /// <exception cref="std::runtime_error">If the object has been
+        /// disposed.</exception>
+        void flush(void);
+
+        /// <summary>
+        /// Gets the ID of the given marker, declaring it in the capture if
+        /// necessary.
+        /// </summary>
+        /// <param name="name">The name of the marker.</param>
+        /// <returns>The ID of the marker, which is assigned in the order in
+        /// which the markers are declared, starting at zero.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="name" /> is <c>nullptr</c>.</exception>
+        /// <exception cref="std::runtime_error">If the object has been
+        /// disposed.</exception>
+        id_type marker(_In_z_ const char_type *name);
+
+        /// <summary>
+        /// Gets the ID of the given sensor, declaring it in the capture if
+        /// necessary.
+        /// </summary>
+        /// <param name="name">The name of the sensor.</param>
+        /// <returns>The ID of the sensor, which is assigned in the order in
+        /// which the sensors are declared, starting at zero.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="name" /> is <c>nullptr</c>.</exception>
+        /// <exception cref="std::runtime_error">If the object has been
+        /// disposed.</exception>
+        id_type sensor(_In_z_ const char_type *name);
+
+        /// <summary>
+        /// Writes a sample of the given sensor.
+        /// </summary>
+        /// <param name="sensor">The ID of the sensor obtained from
+        /// <see cref="sensor" />.</param>
+        /// <param name="sample">The sample to be written.</param>
+        /// <param name="marker">The ID of the marker obtained from
+        /// <see cref="marker" /> or <see cref="no_marker" />.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="sensor" /> has not been declared.</exception>
+        /// <exception cref="std::runtime_error">If the object has been
+        /// disposed.</exception>
+        void write(_In_ const id_type sensor,
+            _In_ const measurement_data& sample,
+            _In_ const id_type marker = no_marker);
+
+        /// <summary>
+        /// Writes a sample, declaring its sensor if necessary.
+        /// </summary>
+        /// <param name="sample">The sample to be written.</param>
+        /// <param name="marker">The ID of the marker obtained from
+        /// <see cref="marker" /> or <see cref="no_marker" />.</param>
+        /// <exception cref="std::runtime_error">If the object has been
+        /// disposed.</exception>
+        void write(_In_ const measurement& sample,
+            _In_ const id_type marker = no_marker);
+
+        /// <summary>
+        /// Writes all samples of the given series, declaring its sensor if
+        /// necessary.
+        /// </summary>
+        /// <param name="series">The series to be written.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="series" /> has no sensor.</exception>
+        /// <exception cref="std::runtime_error">If the object has been
+        /// disposed.</exception>
+        void write(_In_ const measurement_data_series& series);
+
+        capture_writer& operator =(const capture_writer&) = delete;
+
+        /// <summary>
+        /// Move assignment.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand</param>
+        /// <returns><c>*this</c></returns>
+        capture_writer& operator =(_In_ capture_writer&& rhs) noexcept;
+
+        /// <summary>
+        /// Determines whether the object is valid.
+        /// </summary>
+        /// <returns><c>true</c> if the object is valid, <c>false</c>
+        /// otherwise.</returns>
+        operator bool(void) const noexcept;
+
+    private:
+
+        void check_not_disposed(void) const;
+
+        detail::capture_writer_impl *_impl;
+
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
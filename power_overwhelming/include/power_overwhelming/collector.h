@@ -8,13 +8,16 @@
 
 #include <algorithm>
 #include <array>
+#include <cinttypes>
 #include <initializer_list>
+#include <limits>
 #include <memory>
 #include <numeric>
 #include <type_traits>
 #include <vector>
 
 #include "power_overwhelming/collector_settings.h"
+#include "power_overwhelming/timestamp.h"
 
 
 namespace visus {
@@ -31,10 +34,31 @@ namespace power_overwhelming {
 
     public:
 
+        /// <summary>
+        /// The type of a marker that has been registered using
+        /// <see cref="register_marker" />.
+        /// </summary>
+        typedef std::uint32_t marker_id_type;
+
+        /// <summary>
+        /// The marker ID which stops the current marker phase.
+        /// </summary>
+        /// <remarks>
+        /// Setting this marker is equivalent to passing <c>nullptr</c> to the
+        /// string overload of <see cref="marker" />.
+        /// </remarks>
+        static constexpr const marker_id_type no_marker
+            = (std::numeric_limits<marker_id_type>::max)();
+
         /// <summary>
         /// Creates a collector for all sensors that could be found and
         /// instantiated on the machine.
         /// </summary>
+        /// <remarks>
+        /// If <see cref="collector_settings::discovery_cache" /> is set, the
+        /// sensors are restored from this cache if it is still valid instead
+        /// of enumerating all of them.
+        /// </remarks>
         /// <param name="settings">The general settings for the collector,
         /// including the sampling interval.</param>
         /// <returns>A collector for all available sensors.</returns>
@@ -150,9 +174,83 @@ namespace power_overwhelming {
         /// Inject a marker in the command stream which will be included in the
         /// output.
         /// </summary>
+        /// <remarks>
+        /// <para>This overload needs to look up the marker string and wakes
+        /// the I/O thread. If markers are set at high frequency, register them
+        /// once using <see cref="register_marker" /> and use the overload
+        /// accepting the marker ID instead.</para>
+        /// </remarks>
         /// <param name="marker"></param>
         void marker(_In_opt_z_ const wchar_t *marker);
 
+        /// <summary>
+        /// Inject a pre-registered marker in the command stream which will be
+        /// included in the output for all samples acquired from now on.
+        /// </summary>
+        /// <remarks>
+        /// <para>This is the fast path for setting markers, which neither
+        /// locks nor allocates memory in the calling thread. The marker is
+        /// stamped with the current time and appended to a lock-free queue.
+        /// The I/O thread assigns the marker to the samples by their
+        /// timestamp when it writes them the next time.</para>
+        /// </remarks>
+        /// <param name="marker">The ID of the marker as returned by
+        /// <see cref="register_marker" />, or <see cref="no_marker" /> to stop
+        /// the current marker phase.</param>
+        /// <exception cref="std::runtime_error">If the collector has been
+        /// disposed.</exception>
+        void marker(_In_ const marker_id_type marker);
+
+        /// <summary>
+        /// Inject a pre-registered marker in the command stream which becomes
+        /// effective for all samples acquired at or after
+        /// <paramref name="when" />.
+        /// </summary>
+        /// <param name="marker">The ID of the marker as returned by
+        /// <see cref="register_marker" />, or <see cref="no_marker" /> to stop
+        /// the current marker phase.</param>
+        /// <param name="when">The timestamp at which the marker becomes
+        /// effective.</param>
+        /// <exception cref="std::runtime_error">If the collector has been
+        /// disposed.</exception>
+        void marker(_In_ const marker_id_type marker,
+            _In_ const timestamp when);
+
+        /// <summary>
+        /// Inject a marker in the command stream which becomes effective for
+        /// all samples acquired at or after <paramref name="when" />.
+        /// </summary>
+        /// <remarks>
+        /// <para>This overload allows for placing a marker retroactively, for
+        /// instance at the time a hardware trigger was emitted. The marker
+        /// can only be moved back to samples that have not yet been written
+        /// to disk, which is typically the case if the marker is injected
+        /// directly after the event it marks.</para>
+        /// </remarks>
+        /// <param name="marker">The marker to be injected. If this is
+        /// <c>nullptr</c>, the collector stops collecting samples and
+        /// <paramref name="when" /> is ignored.</param>
+        /// <param name="when">The timestamp at which the marker becomes
+        /// effective.</param>
+        void marker(_In_opt_z_ const wchar_t *marker,
+            _In_ const timestamp when);
+
+        /// <summary>
+        /// Registers a marker string such that it can be set efficiently
+        /// using its ID.
+        /// </summary>
+        /// <remarks>
+        /// Registering the same string multiple times yields the same ID. It
+        /// is safe to register markers while the collector is running.
+        /// </remarks>
+        /// <param name="marker">The marker string to register.</param>
+        /// <returns>The ID of the marker.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="marker" /> is <c>nullptr</c>.</exception>
+        /// <exception cref="std::runtime_error">If the collector has been
+        /// disposed.</exception>
+        marker_id_type register_marker(_In_z_ const wchar_t *marker);
+
         /// <summary>
         /// Answer the number of sensors in the collector.
         /// </summary>
@@ -172,6 +270,12 @@ namespace power_overwhelming {
         /// It is safe to call this method on disposed instances, in which case it
         /// will have no effect.
         /// </remarks>
+        /// <exception cref="std::exception">If the collector streamed its
+        /// samples to an aggregator and lost the connection while running, or
+        /// if the output file could not be closed. The exception is the one
+        /// that caused the first of these failures, and samples are missing
+        /// from the output. The collector is stopped nevertheless.
+        /// </exception>
         void stop(void);
 
         /// <summary>
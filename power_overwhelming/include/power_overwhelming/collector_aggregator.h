@@ -0,0 +1,148 @@
+﻿// <copyright file="collector_aggregator.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+
+#include "power_overwhelming/collector_settings.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /* Forward declarations */
+    namespace detail { struct collector_aggregator_impl; }
+
+    /// <summary>
+    /// Receives the samples of remote <see cref="collector" />s and merges
+    /// them into a single capture.
+    /// </summary>
+    /// <remarks>
+    /// <para>A <see cref="collector" /> becomes an agent of an aggregator if
+    /// its <see cref="collector_settings::aggregator" /> is set. Instead of
+    /// writing a local file, the agent streams batches of its samples over
+    /// TCP to the aggregator, which merges the streams of all agents by
+    /// their timestamps into one CSV file. The name of each sensor is
+    /// prefixed by the name of the node it is attached to.</para>
+    /// <para>The aggregator does not align the clocks of the agents. In order
+    /// to obtain a consistent time line, the agents should use a
+    /// <see cref="time_synchroniser" /> that references the clock of the
+    /// aggregator node, which can be configured via
+    /// <see cref="collector_settings::time_synchroniser" />.</para>
+    /// <para>Samples are written once all connected agents have delivered
+    /// samples that are more recent. Consequently, an agent that is connected
+    /// but has not sent any samples yet holds back the output of all others
+    /// until it sends its first batch or disconnects. The order is only
+    /// guaranteed for samples that arrive at the agents in order, which is
+    /// the case unless a sensor delivers with a delay longer than the
+    /// batching interval of the agent.</para>
+    /// <para>In order to bound the memory consumption, an agent that has not
+    /// sent any samples for ten times the batching interval, but at least for
+    /// one second, does not hold back the output anymore. This happens, for
+    /// instance, if the agent requires a marker that has not been set. If
+    /// such an agent resumes sending, its first batch might be written after
+    /// more recent samples of the other agents.</para>
+    /// <para>The output is written in the same format and using the same
+    /// output settings as the CSV output of a local
+    /// <see cref="collector" />.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API collector_aggregator final {
+
+    public:
+
+        /// <summary>
+        /// Creates a new aggregator that starts accepting agents immediately.
+        /// </summary>
+        /// <param name="settings">The settings of the aggregator. The
+        /// aggregator writes to <see cref="collector_settings::output_path" />
+        /// and listens on <see cref="collector_settings::aggregator_port" />.
+        /// </param>
+        /// <param name="address_family">The address family of the listening
+        /// socket, which must be either <c>AF_INET</c> or <c>AF_INET6</c>.
+        /// </param>
+        /// <returns>A new aggregator.</returns>
+        /// <exception cref="std::invalid_argument">If the address family is
+        /// not supported.</exception>
+        /// <exception cref="std::system_error">If the socket could not be
+        /// created or bound, or if the output file could not be opened.
+        /// </exception>
+        static collector_aggregator create(
+            _In_ const collector_settings& settings,
+            _In_ const int address_family);
+
+        /// <summary>
+        /// Initialise a new instance.
+        /// </summary>
+        /// <remarks>
+        /// The default instance is created disposed, ie cannot be used for
+        /// anything, but assigning another instance created by the static
+        /// factory method.
+        /// </remarks>
+        inline collector_aggregator(void) : _impl(nullptr) { }
+
+        collector_aggregator(const collector_aggregator&) = delete;
+
+        /// <summary>
+        /// Move <paramref name="rhs" /> into a new instance.
+        /// </summary>
+        /// <param name="rhs">The object to be moved.</param>
+        inline collector_aggregator(_In_ collector_aggregator&& rhs) noexcept
+                : _impl(rhs._impl) {
+            rhs._impl = nullptr;
+        }
+
+        /// <summary>
+        /// Finalises the instance, which stops it if still running.
+        /// </summary>
+        ~collector_aggregator(void);
+
+        /// <summary>
+        /// Answer the number of agents that are currently connected.
+        /// </summary>
+        /// <returns>The number of connected agents.</returns>
+        std::size_t agents(void) const noexcept;
+
+        /// <summary>
+        /// Disconnects all agents, writes all samples that have been received
+        /// so far and closes the output file.
+        /// </summary>
+        /// <remarks>
+        /// It is safe to call this method multiple times and on disposed
+        /// objects.
+        /// </remarks>
+        void stop(void);
+
+        collector_aggregator& operator =(const collector_aggregator&) = delete;
+
+        /// <summary>
+        /// Move assignment.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand</param>
+        /// <returns><c>*this</c></returns>
+        collector_aggregator& operator =(
+            _In_ collector_aggregator&& rhs) noexcept;
+
+        /// <summary>
+        /// Determines whether the object is valid.
+        /// </summary>
+        /// <remarks>
+        /// The aggregator is considered valid until it has been disposed by a
+        /// move operation.
+        /// </remarks>
+        /// <returns><c>true</c> if the object is valid, <c>false</c>
+        /// otherwise.</returns>
+        operator bool(void) const noexcept;
+
+    private:
+
+        detail::collector_aggregator_impl *_impl;
+
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
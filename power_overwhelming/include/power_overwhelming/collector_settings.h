@@ -7,13 +7,21 @@
 #pragma once
 
 #include <cinttypes>
+#include <cstddef>
 
+#include "power_overwhelming/capture_compression.h"
+#include "power_overwhelming/output_format.h"
+#include "power_overwhelming/output_sync_policy.h"
 #include "power_overwhelming/sensor.h"
 
 
 namespace visus {
 namespace power_overwhelming {
 
+    /* Forward declarations. */
+    class time_synchroniser;
+
+
     /// <summary>
     /// Enapsulates the settings of a
     /// <see cref="visus::power_overwhelming::collector" />.
@@ -27,6 +35,18 @@ namespace power_overwhelming {
         /// </summary>
         typedef sensor::microseconds_type sampling_interval_type;
 
+        /// <summary>
+        /// The default port on which a
+        /// <see cref="collector_aggregator" /> listens for agents.
+        /// </summary>
+        static constexpr std::uint16_t default_aggregator_port = 48700;
+
+        /// <summary>
+        /// The default size of the blocks written to the output file, which is
+        /// 1 MiB.
+        /// </summary>
+        static constexpr std::size_t default_output_block_size = 1 << 20;
+
         /// <summary>
         /// The default output path.
         /// </summary>
@@ -56,6 +76,177 @@ namespace power_overwhelming {
         /// </summary>
         ~collector_settings(void);
 
+        /// <summary>
+        /// Gets the host name of the <see cref="collector_aggregator" /> the
+        /// collector streams its samples to.
+        /// </summary>
+        /// <returns>The name or address of the aggregator, or <c>nullptr</c>
+        /// if the collector writes to <see cref="output_path" />.</returns>
+        inline _Ret_maybenull_z_ const wchar_t *aggregator(
+                void) const noexcept {
+            return this->_aggregator;
+        }
+
+        /// <summary>
+        /// Makes the collector an agent that streams its samples to the given
+        /// <see cref="collector_aggregator" /> instead of writing them to
+        /// <see cref="output_path" />.
+        /// </summary>
+        /// <remarks>
+        /// The connection to the aggregator is established when the collector
+        /// is started. An aggregator uses the
+        /// <see cref="aggregator_port" /> to listen for agents.
+        /// </remarks>
+        /// <param name="host">The name or address of the aggregator. It is
+        /// safe to pass <c>nullptr</c>, which makes the collector write to
+        /// <see cref="output_path" />.</param>
+        /// <param name="port">The port the aggregator is listening on.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& aggregator(_In_opt_z_ const wchar_t *host,
+            _In_ const std::uint16_t port = default_aggregator_port);
+
+        /// <summary>
+        /// Gets the port the <see cref="collector_aggregator" /> is listening
+        /// on.
+        /// </summary>
+        /// <returns>The port of the aggregator.</returns>
+        inline std::uint16_t aggregator_port(void) const noexcept {
+            return this->_aggregator_port;
+        }
+
+        /// <summary>
+        /// Gets the general-purpose compressor applied to the blocks if the
+        /// collector writes a capture.
+        /// </summary>
+        /// <returns>The compression of capture blocks.</returns>
+        inline power_overwhelming::capture_compression capture_compression(
+                void) const noexcept {
+            return this->_capture_compression;
+        }
+
+        /// <summary>
+        /// Sets the general-purpose compressor applied to the blocks if the
+        /// collector writes a capture.
+        /// </summary>
+        /// <remarks>
+        /// This setting has no effect unless the
+        /// <see cref="output_format" /> is
+        /// <see cref="output_format::capture" />. Starting the collector will
+        /// fail if the library has been built without support for the
+        /// requested compression.
+        /// </remarks>
+        /// <param name="compression">The compression of capture blocks.
+        /// </param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& capture_compression(
+            _In_ const power_overwhelming::capture_compression compression)
+            noexcept;
+
+        /// <summary>
+        /// Answer whether the collector tries to bypass the page cache of the
+        /// operating system when writing the output file.
+        /// </summary>
+        /// <returns><c>true</c> if direct I/O is requested, <c>false</c>
+        /// otherwise.</returns>
+        inline bool direct_io(void) const noexcept {
+            return this->_direct_io;
+        }
+
+        /// <summary>
+        /// Configures whether the collector tries to bypass the page cache of
+        /// the operating system when writing the output file.
+        /// </summary>
+        /// <remarks>
+        /// Direct I/O is only supported on Linux. The setting is silently
+        /// ignored on other platforms and if the file system of the output
+        /// file does not support it.
+        /// </remarks>
+        /// <param name="enable"><c>true</c> for enabling direct I/O,
+        /// <c>false</c> for using buffered I/O.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& direct_io(_In_ const bool enable) noexcept;
+
+        /// <summary>
+        /// Gets the path to the file where the results of the sensor discovery
+        /// are cached.
+        /// </summary>
+        /// <returns>The path to the discovery cache, or <c>nullptr</c> if the
+        /// sensors are enumerated every time.</returns>
+        inline _Ret_maybenull_z_ const wchar_t *discovery_cache(
+                void) const noexcept {
+            return this->_discovery_cache;
+        }
+
+        /// <summary>
+        /// Sets the path to the file where the results of the sensor discovery
+        /// are cached.
+        /// </summary>
+        /// <remarks>
+        /// <para>If the cache is enabled, the collector does not enumerate all
+        /// sensors on the machine, but instantiates the sensors described in
+        /// the cache file. The cache is only used if it has been created on a
+        /// machine with the same name, CPU and PCI devices and if it is not
+        /// older than one day. If any of the cached sensors cannot be created,
+        /// the cache is considered stale, too. In all of these cases, the
+        /// sensors are enumerated and the cache is rewritten.</para>
+        /// <para>Sensors that have been added to the system without changing
+        /// the hardware fingerprint, for instance additional Tinkerforge
+        /// bricklets, will not be picked up until the cache expires. Delete the
+        /// cache file in this case.</para>
+        /// </remarks>
+        /// <param name="path">The path to the cache file. It is safe to pass
+        /// <c>nullptr</c>, which disables the cache.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& discovery_cache(_In_opt_z_ const wchar_t *path);
+
+        /// <summary>
+        /// Gets the size of the blocks in which the collector writes its
+        /// output file.
+        /// </summary>
+        /// <returns>The size of an output block in bytes.</returns>
+        inline std::size_t output_block_size(void) const noexcept {
+            return this->_output_block_size;
+        }
+
+        /// <summary>
+        /// Sets the size of the blocks in which the collector writes its
+        /// output file.
+        /// </summary>
+        /// <remarks>
+        /// The collector formats its output into one block while the previous
+        /// one is being written to disk. Large blocks reduce the number of
+        /// I/O operations, but the data of an incomplete block do not reach
+        /// the file before the block is full or the collector is stopped.
+        /// </remarks>
+        /// <param name="size">The size of an output block in bytes, which
+        /// will be rounded up to a multiple of the page size.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="size" /> is zero.</exception>
+        collector_settings& output_block_size(_In_ const std::size_t size);
+
+        /// <summary>
+        /// Gets the format of the output file.
+        /// </summary>
+        /// <returns>The format of the output file.</returns>
+        inline power_overwhelming::output_format output_format(
+                void) const noexcept {
+            return this->_output_format;
+        }
+
+        /// <summary>
+        /// Sets the format of the output file.
+        /// </summary>
+        /// <remarks>
+        /// By default, the collector writes a CSV file. A capture is much
+        /// smaller and faster to write and to read, but requires
+        /// <see cref="capture_reader" /> to be read.
+        /// </remarks>
+        /// <param name="format">The format of the output file.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& output_format(
+            _In_ const power_overwhelming::output_format format) noexcept;
+
         /// <summary>
         /// Gets the path to the file where the collector should write its
         /// output to.
@@ -92,6 +283,53 @@ namespace power_overwhelming {
         collector_settings& sampling_interval(
             _In_ const sampling_interval_type interval);
 
+        /// <summary>
+        /// Gets the policy determining when the output file is synchronised
+        /// with the storage device.
+        /// </summary>
+        /// <returns>The synchronisation policy.</returns>
+        inline output_sync_policy sync_policy(void) const noexcept {
+            return this->_sync_policy;
+        }
+
+        /// <summary>
+        /// Sets the policy determining when the output file is synchronised
+        /// with the storage device.
+        /// </summary>
+        /// <param name="policy">The synchronisation policy.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& sync_policy(
+            _In_ const output_sync_policy policy) noexcept;
+
+        /// <summary>
+        /// Gets the synchroniser used to transform the timestamps of the
+        /// samples.
+        /// </summary>
+        /// <returns>The time synchroniser, which may be
+        /// <c>nullptr</c>.</returns>
+        inline const power_overwhelming::time_synchroniser *
+        time_synchroniser(void) const noexcept {
+            return this->_time_synchroniser;
+        }
+
+        /// <summary>
+        /// Sets a synchroniser that transforms the timestamps of the samples
+        /// streamed to an <see cref="aggregator" /> into the clock of the
+        /// reference peer of the synchroniser.
+        /// </summary>
+        /// <remarks>
+        /// The caller remains owner of the synchroniser and must make sure
+        /// that it lives as long as the collector is running. Typically, the
+        /// reference peer of the synchroniser is the node that runs the
+        /// aggregator.
+        /// </remarks>
+        /// <param name="synchroniser">The synchroniser, or <c>nullptr</c> for
+        /// using the local clock.</param>
+        /// <returns><c>*this</c>.</returns>
+        collector_settings& time_synchroniser(
+            _In_opt_ const power_overwhelming::time_synchroniser *synchroniser)
+            noexcept;
+
         /// <summary>
         /// Assignment.
         /// </summary>
@@ -101,8 +339,17 @@ namespace power_overwhelming {
 
     private:
 
+        wchar_t *_aggregator;
+        std::uint16_t _aggregator_port;
+        power_overwhelming::capture_compression _capture_compression;
+        bool _direct_io;
+        wchar_t *_discovery_cache;
+        std::size_t _output_block_size;
+        power_overwhelming::output_format _output_format;
         wchar_t *_output_path;
         sampling_interval_type _sampling_interval;
+        output_sync_policy _sync_policy;
+        const power_overwhelming::time_synchroniser *_time_synchroniser;
 
     };
 
@@ -0,0 +1,166 @@
+﻿// <copyright file="csv_encoder.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include <iostream>
+
+#include "power_overwhelming/csv_iomanip.h"
+#include "power_overwhelming/measurement_data.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /* Forward declarations. */
+    class measurement;
+
+
+    /// <summary>
+    /// Formats <see cref="measurement" />s and
+    /// <see cref="measurement_data" /> as lines of CSV into narrow character
+    /// buffers.
+    /// </summary>
+    /// <remarks>
+    /// <para>The encoder bypasses the locale-aware formatting of
+    /// <see cref="std::basic_ostream" /> and uses the shortest representation
+    /// of floating-point numbers that can be parsed back to the same value.
+    /// Timestamps are written as integers.</para>
+    /// <para>The order of the fields is the same as for the CSV output of
+    /// <see cref="measurement" />s to a stream, ie the sensor name, the
+    /// timestamp, the validity flag, the voltage, the current and the power.
+    /// </para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API csv_encoder final {
+
+    public:
+
+        /// <summary>
+        /// The type of characters produced by the encoder.
+        /// </summary>
+        typedef char char_type;
+
+        /// <summary>
+        /// The number of characters that must be available for encoding a
+        /// single value.
+        /// </summary>
+        static constexpr std::size_t max_value_size = 32;
+
+        /// <summary>
+        /// The number of characters that must be available for encoding
+        /// the fields of <see cref="measurement_data" />.
+        /// </summary>
+        static constexpr std::size_t max_data_size = 5 * max_value_size;
+
+        /// <summary>
+        /// Writes the shortest representation of <paramref name="value" />
+        /// that round-trips.
+        /// </summary>
+        /// <param name="dst">A buffer of at least
+        /// <see cref="max_value_size" /> characters.</param>
+        /// <param name="value">The value to be encoded.</param>
+        /// <returns>The number of characters written, which does not include
+        /// a terminating zero.</returns>
+        static std::size_t encode(
+            _Out_writes_(max_value_size) char_type *dst,
+            _In_ const float value) noexcept;
+
+        /// <summary>
+        /// Writes <paramref name="value" /> as a decimal integer.
+        /// </summary>
+        /// <param name="dst">A buffer of at least
+        /// <see cref="max_value_size" /> characters.</param>
+        /// <param name="value">The value to be encoded.</param>
+        /// <returns>The number of characters written, which does not include
+        /// a terminating zero.</returns>
+        static std::size_t encode(
+            _Out_writes_(max_value_size) char_type *dst,
+            _In_ const std::int64_t value) noexcept;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <param name="delimiter">The character separating the fields. This
+        /// defaults to the tabulator, which is also the fallback of
+        /// <see cref="getcsvdelimiter" />.</param>
+        /// <param name="quote">The character used for quoting strings, or
+        /// zero for not quoting them.</param>
+        explicit csv_encoder(_In_ const char_type delimiter = '\t',
+            _In_ const char_type quote = 0) noexcept;
+
+        /// <summary>
+        /// Initialises a new instance using the CSV delimiter and quote
+        /// character configured for <paramref name="stream" />.
+        /// </summary>
+        /// <typeparam name="TTraits">The traits type of the stream.
+        /// </typeparam>
+        /// <param name="stream">The stream to retrieve the CSV configuration
+        /// from.</param>
+        template<class TTraits>
+        explicit inline csv_encoder(
+                _In_ std::basic_ostream<char_type, TTraits>& stream) noexcept
+            : _delimiter(getcsvdelimiter(stream)),
+                _quote(getcsvquote(stream)) { }
+
+        /// <summary>
+        /// Gets the character separating the fields.
+        /// </summary>
+        /// <returns>The delimiter.</returns>
+        inline char_type delimiter(void) const noexcept {
+            return this->_delimiter;
+        }
+
+        /// <summary>
+        /// Encodes the timestamp, the validity flag, the voltage, the current
+        /// and the power of the given sample.
+        /// </summary>
+        /// <param name="dst">A buffer of at least
+        /// <see cref="max_data_size" /> characters.</param>
+        /// <param name="data">The sample to be encoded.</param>
+        /// <returns>The number of characters written, which does not include
+        /// a terminating zero.</returns>
+        std::size_t encode(_Out_writes_(max_data_size) char_type *dst,
+            _In_ const measurement_data& data) const noexcept;
+
+        /// <summary>
+        /// Encodes the given measurement including the name of its sensor.
+        /// </summary>
+        /// <remarks>
+        /// The sensor name is converted to the narrow character set, which
+        /// is free for names that are pure ASCII.
+        /// </remarks>
+        /// <param name="dst">The buffer to receive the line, which does not
+        /// include a line break or a terminating zero. It is safe to pass
+        /// <c>nullptr</c> for measuring the required size.</param>
+        /// <param name="cnt">The size of <paramref name="dst" /> in
+        /// characters.</param>
+        /// <param name="measurement">The measurement to be encoded.</param>
+        /// <returns>The number of characters required. If this is more than
+        /// <paramref name="cnt" />, nothing has been written.</returns>
+        std::size_t encode(_Out_writes_opt_(cnt) char_type *dst,
+            _In_ const std::size_t cnt,
+            _In_ const measurement& measurement) const;
+
+        /// <summary>
+        /// Gets the character used for quoting strings.
+        /// </summary>
+        /// <returns>The quote character, or zero if strings are not quoted.
+        /// </returns>
+        inline char_type quote(void) const noexcept {
+            return this->_quote;
+        }
+
+    private:
+
+        char_type _delimiter;
+        char_type _quote;
+
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
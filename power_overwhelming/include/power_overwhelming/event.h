@@ -16,6 +16,8 @@
 #define POWER_OVERWHELMING_EVENT_EMULATION
 #endif /* defined(_WIN32) */
 
+#include <cstddef>
+
 #include "power_overwhelming/power_overwhelming_api.h"
 
 
@@ -40,6 +42,22 @@ namespace power_overwhelming {
     typedef HANDLE event_type;
 #endif /* defined(POWER_OVERWHELMING_EVENT_EMULATION) */
 
+    /// <summary>
+    /// The type of the operating system handle backing an event.
+    /// </summary>
+    /// <remarks>
+    /// On Windows, this is the event handle itself. On Linux, events are
+    /// implemented using an <c>eventfd</c>, which becomes readable once the
+    /// event is signalled. The descriptor can therefore be added to
+    /// <c>poll</c> or <c>epoll</c> sets in order to wait for an event and
+    /// other I/O at the same time.
+    /// </remarks>
+#if defined(POWER_OVERWHELMING_EVENT_EMULATION)
+    typedef int event_native_handle_type;
+#else /* defined(POWER_OVERWHELMING_EVENT_EMULATION) */
+    typedef HANDLE event_native_handle_type;
+#endif /* defined(POWER_OVERWHELMING_EVENT_EMULATION) */
+
     /// <summary>
     /// Allocates a new event object.
     /// </summary>
@@ -95,5 +113,73 @@ namespace power_overwhelming {
     extern bool POWER_OVERWHELMING_API wait_event(_In_ event_type event,
         _In_ const unsigned int timeout);
 
+    /// <summary>
+    /// Waits for any or all of the given events to become signalled.
+    /// </summary>
+    /// <remarks>
+    /// <para>If <paramref name="wait_all" /> is <c>false</c>, only the event
+    /// whose index is returned is reset if it is an auto-reset event. If all
+    /// events are waited for, all auto-reset events are reset once all of
+    /// them have been observed being signalled at the same time.</para>
+    /// <para>On Windows, at most <c>MAXIMUM_WAIT_OBJECTS</c> events can be
+    /// waited for at once.</para>
+    /// </remarks>
+    /// <param name="events">The handles of the events to wait for.</param>
+    /// <param name="cnt">The number of elements in <paramref name="events" />.
+    /// </param>
+    /// <param name="wait_all">If <c>true</c>, wait until all events are
+    /// signalled, otherwise, return as soon as any of them is signalled.
+    /// </param>
+    /// <returns>The index of the event that was signalled if
+    /// <paramref name="wait_all" /> is <c>false</c>, zero if all events were
+    /// signalled.</returns>
+    /// <exception cref="std::invalid_argument">If <paramref name="events" />
+    /// is <c>nullptr</c> or <paramref name="cnt" /> is invalid.</exception>
+    /// <exception cref="std::system_error">In case the operation failed.
+    /// </exception>
+    extern std::size_t POWER_OVERWHELMING_API wait_events(
+        _In_reads_(cnt) const event_type *events,
+        _In_ const std::size_t cnt,
+        _In_ const bool wait_all);
+
+    /// <summary>
+    /// Waits for any or all of the given events to become signalled.
+    /// </summary>
+    /// <param name="events">The handles of the events to wait for.</param>
+    /// <param name="cnt">The number of elements in <paramref name="events" />.
+    /// </param>
+    /// <param name="wait_all">If <c>true</c>, wait until all events are
+    /// signalled, otherwise, return as soon as any of them is signalled.
+    /// </param>
+    /// <param name="timeout">The timeout to wait in milliseconds.</param>
+    /// <returns>The index of the event that was signalled if
+    /// <paramref name="wait_all" /> is <c>false</c>, zero if all events were
+    /// signalled, or <paramref name="cnt" /> if the operation timed out.
+    /// </returns>
+    /// <exception cref="std::invalid_argument">If <paramref name="events" />
+    /// is <c>nullptr</c> or <paramref name="cnt" /> is invalid.</exception>
+    /// <exception cref="std::system_error">In case the operation failed.
+    /// </exception>
+    extern std::size_t POWER_OVERWHELMING_API wait_events(
+        _In_reads_(cnt) const event_type *events,
+        _In_ const std::size_t cnt,
+        _In_ const bool wait_all,
+        _In_ const unsigned int timeout);
+
+    /// <summary>
+    /// Answer the operating system handle of the given event.
+    /// </summary>
+    /// <remarks>
+    /// The handle remains owned by the event and must not be closed by the
+    /// caller. It can be used to wait for the event in a native wait
+    /// function, but it should not be read or written directly.
+    /// </remarks>
+    /// <param name="event">The event to retrieve the handle for.</param>
+    /// <returns>The native handle of the event.</returns>
+    /// <exception cref="std::system_error">In case the operation failed.
+    /// </exception>
+    extern event_native_handle_type POWER_OVERWHELMING_API
+    get_event_native_handle(_In_ event_type event);
+
 } /* namespace power_overwhelming */
 } /* namespace visus */
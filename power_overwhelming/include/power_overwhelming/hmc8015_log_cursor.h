@@ -0,0 +1,134 @@
+﻿// <copyright file="hmc8015_log_cursor.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+
+#include "power_overwhelming/timestamp.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /* Forward declarations. */
+    namespace detail { struct hmc8015_log_cursor_impl; }
+    class hmc8015_sensor;
+
+
+    /// <summary>
+    /// Tracks the progress of harvesting a log file from an
+    /// <see cref="hmc8015_sensor" />.
+    /// </summary>
+    /// <remarks>
+    /// <para>A cursor remembers how much of a log file has already been
+    /// downloaded and parsed by <see cref="hmc8015_sensor::harvest_log" />,
+    /// the state of the parser, and the offset between the clock of the
+    /// instrument and the clock of the host. Passing the same cursor to
+    /// subsequent calls to <see cref="hmc8015_sensor::harvest_log" /> while
+    /// the instrument is still logging therefore only yields the samples that
+    /// have been added since the previous call.</para>
+    /// <para>A cursor must only be used for a single log file on a single
+    /// instrument. Call <see cref="reset" /> before reusing it for a
+    /// different one.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API hmc8015_log_cursor final {
+
+    public:
+
+        /// <summary>
+        /// Initialises a new cursor at the begin of a log file.
+        /// </summary>
+        /// <exception cref="std::bad_alloc">If the state of the cursor could
+        /// not be allocated.</exception>
+        hmc8015_log_cursor(void);
+
+        /// <summary>
+        /// Move <paramref name="rhs" /> into a new instance.
+        /// </summary>
+        /// <param name="rhs">The object to be moved.</param>
+        inline hmc8015_log_cursor(_Inout_ hmc8015_log_cursor&& rhs) noexcept
+                : _impl(rhs._impl) {
+            rhs._impl = nullptr;
+        }
+
+        /// <summary>
+        /// Finalise the instance.
+        /// </summary>
+        ~hmc8015_log_cursor(void);
+
+        /// <summary>
+        /// Answer the offset between the clock of the instrument and the clock
+        /// of the host, which is added to the timestamps in the log file.
+        /// </summary>
+        /// <returns>The clock offset in units of <see cref="timestamp" />
+        /// ticks, or zero if the offset has not yet been determined.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on an
+        /// object that has been disposed by moving it.</exception>
+        timestamp::value_type clock_offset(void) const;
+
+        /// <summary>
+        /// Answer the number of bytes of the log file that have already been
+        /// processed.
+        /// </summary>
+        /// <returns>The position in the log file where the next harvest will
+        /// resume.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on an
+        /// object that has been disposed by moving it.</exception>
+        std::uint64_t offset(void) const;
+
+        /// <summary>
+        /// Resets the cursor to the begin of the log file and discards the
+        /// clock offset.
+        /// </summary>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on an
+        /// object that has been disposed by moving it.</exception>
+        hmc8015_log_cursor& reset(void);
+
+        /// <summary>
+        /// Answer the number of data rows that have been parsed so far.
+        /// </summary>
+        /// <remarks>
+        /// This number includes rows that did not contain valid data and
+        /// were therefore not returned as samples.
+        /// </remarks>
+        /// <returns>The number of data rows.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on an
+        /// object that has been disposed by moving it.</exception>
+        std::uint64_t rows(void) const;
+
+        /// <summary>
+        /// Move assignment.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand.</param>
+        /// <returns><c>*this</c></returns>
+        hmc8015_log_cursor& operator =(
+            _Inout_ hmc8015_log_cursor&& rhs) noexcept;
+
+        /// <summary>
+        /// Determines whether the object is valid.
+        /// </summary>
+        /// <remarks>
+        /// A cursor is valid unless it has been disposed by a move operation.
+        /// </remarks>
+        /// <returns><c>true</c> if the object is valid, <c>false</c>
+        /// otherwise.</returns>
+        inline operator bool(void) const noexcept {
+            return (this->_impl != nullptr);
+        }
+
+    private:
+
+        detail::hmc8015_log_cursor_impl& check_not_disposed(void) const;
+
+        detail::hmc8015_log_cursor_impl *_impl;
+
+        friend class hmc8015_sensor;
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,174 @@
+﻿// <copyright file="hmc8015_sample.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cstddef>
+
+#include "power_overwhelming/hmc8015_function.h"
+#include "power_overwhelming/measurement_data.h"
+#include "power_overwhelming/timestamp.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /// <summary>
+    /// Container for all quantities an <see cref="hmc8015_sensor" /> obtained
+    /// in a single readout of its configured measurement functions.
+    /// </summary>
+    /// <remarks>
+    /// <para>The HMC8015 returns the values of all functions configured via
+    /// <see cref="hmc8015_sensor::custom_functions" /> in response to a
+    /// single query. This container preserves all of these values along with
+    /// the function they belong to, which allows for retrieving quantities
+    /// like the power factor or the consumed energy without additional round
+    /// trips to the instrument.</para>
+    /// <para>The sample does not allocate any memory and can therefore be
+    /// copied freely.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API hmc8015_sample final {
+
+    public:
+
+        /// <summary>
+        /// The type of a timestamp associated with the sample.
+        /// </summary>
+        typedef power_overwhelming::timestamp timestamp_type;
+
+        /// <summary>
+        /// The type used to store the measured values.
+        /// </summary>
+        typedef measurement_data::value_type value_type;
+
+        /// <summary>
+        /// The maximum number of functions the instrument can measure at the
+        /// same time.
+        /// </summary>
+        static constexpr const std::size_t max_functions = 10;
+
+        /// <summary>
+        /// Initialises a new instance without any values.
+        /// </summary>
+        /// <param name="timestamp">The timestamp when the sample was obtained.
+        /// </param>
+        hmc8015_sample(_In_ const timestamp_type timestamp
+            = timestamp_type::zero) noexcept;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <param name="timestamp">The timestamp when the sample was obtained.
+        /// </param>
+        /// <param name="functions">The functions that have been measured.
+        /// </param>
+        /// <param name="values">The values of the <paramref name="functions" />
+        /// in the same order.</param>
+        /// <param name="cnt">The number of elements in
+        /// <paramref name="functions" /> and <paramref name="values" />.
+        /// </param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="functions" /> or <paramref name="values" /> is
+        /// <c>nullptr</c> while <paramref name="cnt" /> is not zero, or if
+        /// <paramref name="cnt" /> exceeds <see cref="max_functions" />.
+        /// </exception>
+        hmc8015_sample(_In_ const timestamp_type timestamp,
+            _In_reads_(cnt) const hmc8015_function *functions,
+            _In_reads_(cnt) const value_type *values,
+            _In_ const std::size_t cnt);
+
+        /// <summary>
+        /// Answer whether the sample contains a value for the given function.
+        /// </summary>
+        /// <param name="function">The function to search.</param>
+        /// <returns><c>true</c> if the function has been measured,
+        /// <c>false</c> otherwise.</returns>
+        bool contains(_In_ const hmc8015_function function) const noexcept;
+
+        /// <summary>
+        /// Answer the function the <paramref name="i" />th value belongs to.
+        /// </summary>
+        /// <param name="i">The index of the value.</param>
+        /// <returns>The function of the <paramref name="i" />th value.
+        /// </returns>
+        /// <exception cref="std::range_error">If <paramref name="i" /> is
+        /// not a valid index.</exception>
+        hmc8015_function function(_In_ const std::size_t i) const;
+
+        /// <summary>
+        /// Answer the number of values in the sample.
+        /// </summary>
+        /// <returns>The number of values.</returns>
+        inline std::size_t size(void) const noexcept {
+            return this->_size;
+        }
+
+        /// <summary>
+        /// Gets the timestamp of the sample.
+        /// </summary>
+        /// <returns>The timestamp of the sample.</returns>
+        inline timestamp_type timestamp(void) const noexcept {
+            return this->_timestamp;
+        }
+
+        /// <summary>
+        /// Converts the sample into a <see cref="measurement_data" /> by
+        /// selecting the voltage, current and power.
+        /// </summary>
+        /// <remarks>
+        /// The voltage is taken from the RMS voltage and falls back to the
+        /// average voltage if the former has not been measured. The same
+        /// applies to the current. The power is always the active power.
+        /// Quantities that have not been measured are reported as
+        /// <see cref="measurement_data::invalid_value" />.
+        /// </remarks>
+        /// <returns>The electric quantities in the sample.</returns>
+        measurement_data to_measurement_data(void) const noexcept;
+
+        /// <summary>
+        /// Answer the value of the given function.
+        /// </summary>
+        /// <param name="function">The function to retrieve the value of.
+        /// </param>
+        /// <returns>The value of the function, or
+        /// <see cref="measurement_data::invalid_value" /> if the function has
+        /// not been measured or the instrument has not provided a valid value.
+        /// </returns>
+        value_type value(_In_ const hmc8015_function function) const noexcept;
+
+        /// <summary>
+        /// Answer the <paramref name="i" />th value in the order the functions
+        /// have been configured.
+        /// </summary>
+        /// <param name="i">The index of the value.</param>
+        /// <returns>The <paramref name="i" />th value.</returns>
+        /// <exception cref="std::range_error">If <paramref name="i" /> is
+        /// not a valid index.</exception>
+        value_type value(_In_ const std::size_t i) const;
+
+        /// <summary>
+        /// Answer the value of the given function.
+        /// </summary>
+        /// <param name="function">The function to retrieve the value of.
+        /// </param>
+        /// <returns>The value of the function, or
+        /// <see cref="measurement_data::invalid_value" /> if the function has
+        /// not been measured.</returns>
+        inline value_type operator [](
+                _In_ const hmc8015_function function) const noexcept {
+            return this->value(function);
+        }
+
+    private:
+
+        hmc8015_function _functions[max_functions];
+        std::size_t _size;
+        timestamp_type _timestamp;
+        value_type _values[max_functions];
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -14,9 +14,12 @@
 
 #include "power_overwhelming/blob.h"
 #include "power_overwhelming/hmc8015_function.h"
+#include "power_overwhelming/hmc8015_log_cursor.h"
+#include "power_overwhelming/hmc8015_sample.h"
 #include "power_overwhelming/integrator_mode.h"
 #include "power_overwhelming/instrument_range.h"
 #include "power_overwhelming/log_mode.h"
+#include "power_overwhelming/measurement_data_series.h"
 #include "power_overwhelming/sampler_source.h"
 #include "power_overwhelming/sensor.h"
 #include "power_overwhelming/visa_instrument.h"
@@ -240,21 +243,27 @@ namespace power_overwhelming {
         /// user-defined ones.
         /// </summary>
         /// <remarks>
-        /// <para>This is an advanced API which should only be used if you know
-        /// what you are doing. The <see cref="sample" /> method expects certain
-        /// functions to be enabled in a specific order. If you change this
-        /// here, the results of the sensor might be wrong or the sensor might
-        /// crash. The functions must therefore only changed for logging to a
-        /// file while never using the generic sampling methods defined by
-        /// <see cref="sensor" />. You can reset the functions to be sampled
-        /// using the <see cref="default_functions" /> method.</para>
+        /// <para>The sensor remembers the functions configured here and
+        /// retrieves the values of all of them in a single query whenever it
+        /// is sampled. The generic sampling methods defined by
+        /// <see cref="sensor" /> select the voltage, current and power from
+        /// these values as described for
+        /// <see cref="hmc8015_sample::to_measurement_data" />, wherefore they
+        /// will report invalid values if none of the electric quantities is
+        /// measured. All of the values can be obtained via
+        /// <see cref="sample_functions" /> or by delivering
+        /// <see cref="hmc8015_sample" />s asynchronously. You can reset the
+        /// functions to be sampled using the <see cref="default_functions" />
+        /// method.</para>
         /// </remarks>
         /// <param name="functions">An array of <paramref name="cnt" />
         /// <see cref="hmc8015_function" />s to measure.</param>
         /// <param name="cnt">The number of functions to measure.</param>
         /// <returns><c>*this</c>.</returns>
         /// <exception cref="std::invalid_argument">If
-        /// <paramref name="functions" /> is <c>nullptr</c>.</exception>
+        /// <paramref name="functions" /> is <c>nullptr</c> or if more than
+        /// <see cref="hmc8015_sample::max_functions" /> functions are
+        /// requested.</exception>
         /// <exception cref="std::runtime_error">If the method is called on an
         /// object that has been disposed by moving it.</exception>
         /// <exception cref="visa_exception">If the VISA command was not
@@ -268,14 +277,18 @@ namespace power_overwhelming {
         /// compile-time list.
         /// </summary>
         /// <remarks>
-        /// <para>This is an advanced API which should only be used if you know
-        /// what you are doing. The <see cref="sample" /> method expects certain
-        /// functions to be enabled in a specific order. If you change this
-        /// here, the results of the sensor might be wrong or the sensor might
-        /// crash. The functions must therefore only changed for logging to a
-        /// file while never using the generic sampling methods defined by
-        /// <see cref="sensor" />. You can reset the functions to be sampled
-        /// using the <see cref="default_functions" /> method.</para>
+        /// <para>The sensor remembers the functions configured here and
+        /// retrieves the values of all of them in a single query whenever it
+        /// is sampled. The generic sampling methods defined by
+        /// <see cref="sensor" /> select the voltage, current and power from
+        /// these values as described for
+        /// <see cref="hmc8015_sample::to_measurement_data" />, wherefore they
+        /// will report invalid values if none of the electric quantities is
+        /// measured. All of the values can be obtained via
+        /// <see cref="sample_functions" /> or by delivering
+        /// <see cref="hmc8015_sample" />s asynchronously. You can reset the
+        /// functions to be sampled using the <see cref="default_functions" />
+        /// method.</para>
         /// <para>This method allows for easy specification of compile-time
         /// function lists without declaring an array.</para>
         /// </remarks>
@@ -283,32 +296,34 @@ namespace power_overwhelming {
         /// enabled.</param>
         /// <returns><c>*this</c>.</returns>
         /// <exception cref="std::invalid_argument">If
-        /// <paramref name="functions" /> is <c>nullptr</c>.</exception>
+        /// <paramref name="functions" /> is <c>nullptr</c> or if more than
+        /// <see cref="hmc8015_sample::max_functions" /> functions are
+        /// requested.</exception>
         /// <exception cref="std::runtime_error">If the method is called on an
         /// object that has been disposed by moving it.</exception>
         /// <exception cref="visa_exception">If the VISA command was not
         /// processed successfully.</exception>
-        inline std::size_t custom_functions(
+        inline hmc8015_sensor& custom_functions(
                 _In_ std::initializer_list<hmc8015_function> functions) {
             return this->custom_functions(functions.begin(), functions.size());
         }
 
         /// <summary>
-        /// Enables the functions that are required for sampling the sensor
-        /// using <see cref="sample" />.
+        /// Enables the functions that are measured by default, which are the
+        /// RMS voltage and current, their ranges, the apparent power and the
+        /// active power.
         /// </summary>
         /// <remarks>
-        /// <para>The <see cref="sample" /> function assumes certain values in a
-        /// specific order. If the caller has changed these functions using
-        /// the <see cref="custom_functions" /> method, for instance to create a
-        /// custom log file, and wants to sample the instrument as a
-        /// sensor, this function needs to be called to reset the functions
-        /// to the expected layout.</para>
-        /// <para>For performance reasons, <see cref="sample" /> will not check
-        /// whether the functions have been reconfigured and do not match
-        /// the expected layout.</para>
+        /// <para>If the caller has changed the functions using the
+        /// <see cref="custom_functions" /> method, for instance to create a
+        /// custom log file, this method restores the default configuration.
+        /// </para>
         /// </remarks>
         /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on an
+        /// object that has been disposed by moving it.</exception>
+        /// <exception cref="visa_exception">If the VISA command was not
+        /// processed successfully.</exception>
         hmc8015_sensor& default_functions(void);
 
         /// <summary>
@@ -348,6 +363,106 @@ namespace power_overwhelming {
         std::size_t functions(_Out_writes_opt_z_(cnt) char *dst,
             _In_ const std::size_t cnt) const;
 
+        /// <summary>
+        /// Downloads the log file <paramref name="name" /> from the instrument
+        /// and returns all samples that have been added since the previous
+        /// call with the same <paramref name="cursor" />.
+        /// </summary>
+        /// <remarks>
+        /// <para>The log file is streamed from the instrument in chunks and
+        /// parsed while it is being received, wherefore the file is never held
+        /// in memory as a whole. The instrument cannot transfer only parts of
+        /// a file, but the part that has already been harvested before is
+        /// skipped without being parsed. It is therefore safe to call this
+        /// method periodically while the instrument is still logging.</para>
+        /// <para>The timestamps in the log file are expressed in the clock of
+        /// the instrument, which only has a resolution of one second and is
+        /// usually not synchronised with the host. On the first harvest with a
+        /// new <paramref name="cursor" />, the method therefore measures the
+        /// offset between the clock of the instrument and the clock of the
+        /// host by observing the instrument's clock ticking over to the next
+        /// second, which takes up to one second. All timestamps returned are
+        /// mapped to the clock of the host using this offset. The offset is
+        /// stored in <paramref name="cursor" /> and reused for subsequent
+        /// harvests, which makes sure that samples from multiple harvests are
+        /// consistent.</para>
+        /// <para>If the log file on the instrument has become smaller than the
+        /// data already harvested, it is assumed that the file has been
+        /// replaced and <paramref name="cursor" /> is reset.</para>
+        /// </remarks>
+        /// <param name="name">The name of the log file, which is typically
+        /// obtained from <see cref="log_file" />.</param>
+        /// <param name="cursor">The cursor tracking the progress of
+        /// harvesting the log file. The cursor is updated to the end of the
+        /// data returned.</param>
+        /// <param name="use_usb">If <c>true</c>, the file is read from a USB
+        /// thumb drive attached to the device rather than from the internal
+        /// memory of the device. This parameter defaults to <c>false</c>, ie
+        /// to the internal memory.</param>
+        /// <returns>The new samples in the log file.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on an
+        /// object that has been disposed by moving it, if
+        /// <paramref name="cursor" /> has been disposed, if the log file
+        /// contains lines that are too long to be parsed or if the library was
+        /// compiled without support for VISA.</exception>
+        /// <exception cref="std::invalid_argument">If <paramref name="name" />
+        /// is <c>nullptr</c>.</exception>
+        /// <exception cref="visa_exception">If any of the API calls to the
+        /// instrument failed.</exception>
+        measurement_data_series harvest_log(_In_z_ const wchar_t *name,
+            _Inout_ hmc8015_log_cursor& cursor,
+            _In_ const bool use_usb = false) const;
+
+        /// <summary>
+        /// Downloads the log file <paramref name="name" /> from the instrument
+        /// and returns all samples that have been added since the previous
+        /// call with the same <paramref name="cursor" />.
+        /// </summary>
+        /// <remarks>
+        /// <para>The log file is streamed from the instrument in chunks and
+        /// parsed while it is being received, wherefore the file is never held
+        /// in memory as a whole. The instrument cannot transfer only parts of
+        /// a file, but the part that has already been harvested before is
+        /// skipped without being parsed. It is therefore safe to call this
+        /// method periodically while the instrument is still logging.</para>
+        /// <para>The timestamps in the log file are expressed in the clock of
+        /// the instrument, which only has a resolution of one second and is
+        /// usually not synchronised with the host. On the first harvest with a
+        /// new <paramref name="cursor" />, the method therefore measures the
+        /// offset between the clock of the instrument and the clock of the
+        /// host by observing the instrument's clock ticking over to the next
+        /// second, which takes up to one second. All timestamps returned are
+        /// mapped to the clock of the host using this offset. The offset is
+        /// stored in <paramref name="cursor" /> and reused for subsequent
+        /// harvests, which makes sure that samples from multiple harvests are
+        /// consistent.</para>
+        /// <para>If the log file on the instrument has become smaller than the
+        /// data already harvested, it is assumed that the file has been
+        /// replaced and <paramref name="cursor" /> is reset.</para>
+        /// </remarks>
+        /// <param name="name">The name of the log file, which is typically
+        /// obtained from <see cref="log_file" />.</param>
+        /// <param name="cursor">The cursor tracking the progress of
+        /// harvesting the log file. The cursor is updated to the end of the
+        /// data returned.</param>
+        /// <param name="use_usb">If <c>true</c>, the file is read from a USB
+        /// thumb drive attached to the device rather than from the internal
+        /// memory of the device. This parameter defaults to <c>false</c>, ie
+        /// to the internal memory.</param>
+        /// <returns>The new samples in the log file.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on an
+        /// object that has been disposed by moving it, if
+        /// <paramref name="cursor" /> has been disposed, if the log file
+        /// contains lines that are too long to be parsed or if the library was
+        /// compiled without support for VISA.</exception>
+        /// <exception cref="std::invalid_argument">If <paramref name="name" />
+        /// is <c>nullptr</c>.</exception>
+        /// <exception cref="visa_exception">If any of the API calls to the
+        /// instrument failed.</exception>
+        measurement_data_series harvest_log(_In_z_ const char *name,
+            _Inout_ hmc8015_log_cursor& cursor,
+            _In_ const bool use_usb = false) const;
+
         /// <summary>
         /// Configures the behaviour of the integrator.
         /// </summary>
@@ -661,6 +776,22 @@ namespace power_overwhelming {
 
         using sensor::sample;
 
+        /// <summary>
+        /// Retrieves the current values of all functions configured via
+        /// <see cref="custom_functions" /> or <see cref="default_functions" />.
+        /// </summary>
+        /// <remarks>
+        /// All of the values are obtained with a single query, so retrieving
+        /// additional quantities does not incur additional round trips to the
+        /// instrument.
+        /// </remarks>
+        /// <returns>The values of all configured functions.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on an
+        /// object that has been disposed by moving it.</exception>
+        /// <exception cref="visa_exception">If the VISA command was not
+        /// processed successfully.</exception>
+        hmc8015_sample sample_functions(void) const;
+
         /// <summary>
         /// Starts the integrator if in manual mode.
         /// </summary>
@@ -768,6 +899,7 @@ namespace power_overwhelming {
             _In_ const float value);
 
         async_sampling _async_sampling;
+        blob _functions;
         visa_instrument _instrument;
         blob _name;
 
@@ -0,0 +1,153 @@
+﻿// <copyright file="hwmon_sensor.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include "power_overwhelming/sensor.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /* Forward declarations */
+    namespace detail { struct hwmon_sensor_impl; }
+
+
+    /// <summary>
+    /// Implementation of a power sensor reading the attributes of a Linux
+    /// hardware monitoring (hwmon) device in sysfs.
+    /// </summary>
+    /// <remarks>
+    /// <para>Many drivers, for instance amdgpu, the Intel GPU drivers or
+    /// drivers for platform and BMC sensors, expose their readings as files in
+    /// <c>/sys/class/hwmon/hwmon*</c>. The sensor uses the following
+    /// attributes of such a device if they are available: The power is read
+    /// from <c>power1_average</c> or <c>power1_input</c> (microwatts). If
+    /// neither is available, the power is derived from the changes of
+    /// <c>energy1_input</c> (microjoules). Furthermore, the voltage is read
+    /// from an <c>inN_input</c> attribute (millivolts) and the current from a
+    /// <c>currN_input</c> attribute (milliamperes). As the voltage and current
+    /// channels of a device are numbered independently, the sensor prefers a
+    /// pair of channels that have the same <c>*_label</c> or, if they have no
+    /// labels, the same number. Only for such a pair, devices providing
+    /// neither power nor energy report the product of voltage and current as
+    /// power. Without a pair, the lowest-numbered channels are reported for
+    /// information, but the power is never derived from them.</para>
+    /// <para>All attribute files are opened when the sensor is created and
+    /// remain open for its lifetime. Each sample re-reads all of them from the
+    /// start of the file and combines them into a single
+    /// <see cref="measurement_data" />.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API hwmon_sensor final : public sensor {
+
+    public:
+
+        /// <summary>
+        /// The directory where Linux exposes the hwmon devices.
+        /// </summary>
+        static constexpr const char *default_root = "/sys/class/hwmon";
+
+        /// <summary>
+        /// Create sensors for all hwmon devices that provide at least a power
+        /// or energy reading or a voltage and a current of the same rail.
+        /// </summary>
+        /// <remarks>
+        /// <para>It is safe to call the method on systems without hwmon
+        /// devices, including Windows. In this case, zero is returned.</para>
+        /// </remarks>
+        /// <param name="out_sensors">Receives the sensors, if not
+        /// <c>nullptr</c>.</param>
+        /// <param name="cnt_sensors">The available space in
+        /// <paramref name="out_sensors" />.</param>
+        /// <param name="root">The directory holding the hwmon devices. If this
+        /// is <c>nullptr</c>, which is the default,
+        /// <see cref="default_root" /> is searched.</param>
+        /// <returns>The number of sensors available on the system, regardless
+        /// of the size of the output array. If this number is larger than
+        /// <paramref name="cnt_sensors" />, not all sensors have been
+        /// returned.</returns>
+        static std::size_t for_all(
+            _Out_writes_opt_(cnt_sensors) hwmon_sensor *out_sensors,
+            _In_ const std::size_t cnt_sensors,
+            _In_opt_z_ const char *root = nullptr);
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        hwmon_sensor(void);
+
+        /// <summary>
+        /// Initialises a new instance for the hwmon device in the specified
+        /// directory.
+        /// </summary>
+        /// <param name="path">The path to the hwmon device, for instance
+        /// <c>/sys/class/hwmon/hwmon0</c>.</param>
+        /// <exception cref="std::invalid_argument">If <paramref name="path" />
+        /// is <c>nullptr</c> or if the device does not provide the attributes
+        /// required to measure power.</exception>
+        /// <exception cref="std::system_error">If an attribute file could not
+        /// be read.</exception>
+        explicit hwmon_sensor(_In_z_ const char *path);
+
+        /// <summary>
+        /// Move <paramref name="rhs" /> into a new instance.
+        /// </summary>
+        /// <param name="rhs">The object to be moved.</param>
+        inline hwmon_sensor(_In_ hwmon_sensor&& rhs) noexcept
+                : _impl(rhs._impl) {
+            rhs._impl = nullptr;
+        }
+
+        /// <summary>
+        /// Finalise the instance.
+        /// </summary>
+        virtual ~hwmon_sensor(void);
+
+        /// <summary>
+        /// Answer the name the driver reports for the hwmon device, for
+        /// instance &quot;amdgpu&quot;.
+        /// </summary>
+        /// <returns>The name of the device, or <c>nullptr</c> if the sensor
+        /// has been disposed.</returns>
+        _Ret_maybenull_z_ const char *device_name(void) const noexcept;
+
+        /// <inheritdoc />
+        virtual _Ret_maybenull_z_ const wchar_t *name(
+            void) const noexcept override;
+
+        /// <summary>
+        /// Answer the path to the hwmon device directory.
+        /// </summary>
+        /// <returns>The path of the device, or <c>nullptr</c> if the sensor
+        /// has been disposed.</returns>
+        _Ret_maybenull_z_ const char *path(void) const noexcept;
+
+        /// <summary>
+        /// Move assignment.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand</param>
+        /// <returns><c>*this</c></returns>
+        hwmon_sensor& operator =(_In_ hwmon_sensor&& rhs) noexcept;
+
+        /// <inheritdoc />
+        virtual operator bool(void) const noexcept override;
+
+    protected:
+
+        /// <inheritdoc />
+        void sample_async(_Inout_ async_sampling&& sampling) override;
+
+        /// <inheritdoc />
+        measurement_data sample_sync(void) const override;
+
+    private:
+
+        detail::hwmon_sensor_impl *_impl;
+
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
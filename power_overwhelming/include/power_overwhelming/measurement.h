@@ -6,10 +6,12 @@
 
 #pragma once
 
+#include <algorithm>
 #include <iostream>
 #include <utility>
 
 #include "power_overwhelming/convert_string.h"
+#include "power_overwhelming/csv_encoder.h"
 #include "power_overwhelming/csv_iomanip.h"
 #include "power_overwhelming/measurement_data.h"
 #include "power_overwhelming/quote.h"
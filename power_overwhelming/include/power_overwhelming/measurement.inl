@@ -86,11 +86,31 @@ std::basic_ostream<TChar, TTraits>& std::operator <<(
             }
         }
 
-        lhs << rhs.timestamp().value() << delim;
-        lhs << static_cast<bool>(rhs) << delim;
-        lhs << rhs.voltage() << delim;
-        lhs << rhs.current() << delim;
-        lhs << rhs.power();
+        // Format the numbers using the encoder, which is much faster than the
+        // locale-aware formatting of the stream, and widen them as necessary.
+        TChar buffer[csv_encoder::max_data_size];
+        csv_encoder::char_type value[csv_encoder::max_value_size];
+        auto cur = buffer;
+        const auto append = [&cur, &value](const std::size_t cnt) {
+            cur = std::transform(value, value + cnt, cur,
+                [](const csv_encoder::char_type c) {
+                    return static_cast<TChar>(c);
+                });
+        };
+
+        append(csv_encoder::encode(value, rhs.timestamp().value()));
+        *cur++ = delim;
+        *cur++ = static_cast<bool>(rhs)
+            ? POWER_OVERWHELMING_TPL_LITERAL(TChar, '1')
+            : POWER_OVERWHELMING_TPL_LITERAL(TChar, '0');
+        *cur++ = delim;
+        append(csv_encoder::encode(value, rhs.voltage()));
+        *cur++ = delim;
+        append(csv_encoder::encode(value, rhs.current()));
+        *cur++ = delim;
+        append(csv_encoder::encode(value, rhs.power()));
+
+        lhs.write(buffer, cur - buffer);
     }
 
     return lhs;
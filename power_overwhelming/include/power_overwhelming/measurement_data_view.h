@@ -0,0 +1,187 @@
+﻿// <copyright file="measurement_data_view.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cstddef>
+
+#include "power_overwhelming/measurement_data.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /// <summary>
+    /// A non-owning view of regularly sampled voltage and current values, which
+    /// share an implicit time base.
+    /// </summary>
+    /// <remarks>
+    /// <para>This class is intended for sensors like oscilloscopes, which
+    /// produce large numbers of samples in one go. Instead of constructing a
+    /// <see cref="measurement_data" /> for each of the samples, the sensor can
+    /// hand out the arrays it received from the instrument along with the
+    /// timestamp of the first sample and the distance between two samples.
+    /// Consumers can expand individual samples or ranges of samples into
+    /// <see cref="measurement_data" /> on demand.</para>
+    /// <para>The view does not own the data it references. It is only valid
+    /// for the duration of the callback it was passed to. Consumers that need
+    /// the data beyond that must copy it.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API measurement_data_view final {
+
+    public:
+
+        /// <summary>
+        /// The type of a timestamp associated with a sample.
+        /// </summary>
+        typedef measurement_data::timestamp_type timestamp_type;
+
+        /// <summary>
+        /// The type of current and voltage measurements.
+        /// </summary>
+        typedef measurement_data::value_type value_type;
+
+        /// <summary>
+        /// Initialises a new, empty view.
+        /// </summary>
+        measurement_data_view(void) noexcept;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <param name="voltages">A pointer to <paramref name="cnt" />
+        /// voltage samples in Volts. The view does not take ownership of the
+        /// data.</param>
+        /// <param name="currents">A pointer to <paramref name="cnt" />
+        /// current samples in Amperes. The view does not take ownership of the
+        /// data.</param>
+        /// <param name="cnt">The number of samples in both arrays.</param>
+        /// <param name="origin">The timestamp of the first sample.</param>
+        /// <param name="increment">The distance between two adjacent samples
+        /// in seconds.</param>
+        /// <exception cref="std::invalid_argument">If any of the arrays is
+        /// <c>nullptr</c> while <paramref name="cnt" /> is not zero.
+        /// </exception>
+        measurement_data_view(_In_reads_(cnt) const value_type *voltages,
+            _In_reads_(cnt) const value_type *currents,
+            _In_ const std::size_t cnt,
+            _In_ const timestamp_type origin,
+            _In_ const double increment);
+
+        /// <summary>
+        /// Answer the <paramref name="i" />th sample.
+        /// </summary>
+        /// <param name="i">The index of the sample to retrieve.</param>
+        /// <returns>The <paramref name="i" />th sample.</returns>
+        /// <exception cref="std::range_error">If <paramref name="i" /> does not
+        /// designate a valid sample.</exception>
+        measurement_data at(_In_ const std::size_t i) const;
+
+        /// <summary>
+        /// Answer the current samples.
+        /// </summary>
+        /// <returns>A pointer to <see cref="size" /> current samples.
+        /// </returns>
+        inline _Ret_maybenull_ const value_type *currents(void) const noexcept {
+            return this->_currents;
+        }
+
+        /// <summary>
+        /// Answer whether the view contains no samples.
+        /// </summary>
+        /// <returns><c>true</c> if the view is empty, <c>false</c> otherwise.
+        /// </returns>
+        inline bool empty(void) const noexcept {
+            return (this->_size == 0);
+        }
+
+        /// <summary>
+        /// Expands the samples starting at <paramref name="offset" /> into
+        /// <see cref="measurement_data" />.
+        /// </summary>
+        /// <remarks>
+        /// The timestamps are computed from the time base of the view rather
+        /// than being accumulated, so the result does not depend on how the
+        /// expansion is split into chunks.
+        /// </remarks>
+        /// <param name="dst">A buffer for at least <paramref name="cnt" />
+        /// samples. It is safe to pass <c>nullptr</c>, in which case nothing is
+        /// written.</param>
+        /// <param name="cnt">The number of elements in <paramref name="dst" />.
+        /// </param>
+        /// <param name="offset">The index of the first sample to be expanded.
+        /// This parameter defaults to zero.</param>
+        /// <returns>The number of samples from <paramref name="offset" /> to
+        /// the end of the view, regardless of whether all of them have been
+        /// written or not.</returns>
+        std::size_t expand(_Out_writes_opt_(cnt) measurement_data *dst,
+            _In_ const std::size_t cnt,
+            _In_ const std::size_t offset = 0) const;
+
+        /// <summary>
+        /// Answer the distance between two adjacent samples in seconds.
+        /// </summary>
+        /// <returns>The sample distance in seconds.</returns>
+        inline double increment(void) const noexcept {
+            return this->_increment;
+        }
+
+        /// <summary>
+        /// Answer the timestamp of the first sample.
+        /// </summary>
+        /// <returns>The timestamp of the first sample.</returns>
+        inline timestamp_type origin(void) const noexcept {
+            return this->_origin;
+        }
+
+        /// <summary>
+        /// Answer the number of samples in the view.
+        /// </summary>
+        /// <returns>The number of samples.</returns>
+        inline std::size_t size(void) const noexcept {
+            return this->_size;
+        }
+
+        /// <summary>
+        /// Answer the timestamp of the <paramref name="i" />th sample.
+        /// </summary>
+        /// <param name="i">The index of the sample. This index is not
+        /// checked.</param>
+        /// <returns>The timestamp of the sample.</returns>
+        timestamp_type timestamp(_In_ const std::size_t i) const noexcept;
+
+        /// <summary>
+        /// Answer the voltage samples.
+        /// </summary>
+        /// <returns>A pointer to <see cref="size" /> voltage samples.
+        /// </returns>
+        inline _Ret_maybenull_ const value_type *voltages(void) const noexcept {
+            return this->_voltages;
+        }
+
+        /// <summary>
+        /// Answer the <paramref name="i" />th sample.
+        /// </summary>
+        /// <param name="i">The index of the sample to retrieve.</param>
+        /// <returns>The <paramref name="i" />th sample.</returns>
+        /// <exception cref="std::range_error">If <paramref name="i" /> does not
+        /// designate a valid sample.</exception>
+        inline measurement_data operator [](_In_ const std::size_t i) const {
+            return this->at(i);
+        }
+
+    private:
+
+        const value_type *_currents;
+        double _increment;
+        timestamp_type _origin;
+        std::size_t _size;
+        const value_type *_voltages;
+
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,58 @@
+﻿// <copyright file="nvml_sampling_mode.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /// <summary>
+    /// Specifies how an <see cref="nvml_sensor" /> obtains the power
+    /// consumption of the GPU.
+    /// </summary>
+    enum class nvml_sampling_mode {
+
+        /// <summary>
+        /// Reads the power usage the driver reports at the time of the
+        /// request.
+        /// </summary>
+        /// <remarks>
+        /// This value is averaged by the driver and only updated at a
+        /// comparatively low rate, wherefore sampling faster than the update
+        /// rate of the driver will yield duplicate values. On the upside, this
+        /// mode is supported by all GPUs that report their power consumption.
+        /// </remarks>
+        power_usage,
+
+        /// <summary>
+        /// Derives the power from the difference of the total energy counter of
+        /// the GPU between two samples.
+        /// </summary>
+        /// <remarks>
+        /// The energy counter is only available on Volta and later GPUs. The
+        /// sensor will report the previous value if the counter has not
+        /// changed since the last sample.
+        /// </remarks>
+        energy_consumption,
+
+        /// <summary>
+        /// Retrieves all power samples the driver has recorded since the
+        /// previous sample from its internal buffer.
+        /// </summary>
+        /// <remarks>
+        /// In this mode, each sample carries the timestamp when the driver has
+        /// recorded it rather than the time of the request. Asynchronous
+        /// sampling delivers all samples that have been recorded since the last
+        /// delivery, which might be none.
+        /// </remarks>
+        power_samples
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
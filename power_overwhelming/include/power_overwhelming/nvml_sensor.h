@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include "power_overwhelming/nvml_sampling_mode.h"
 #include "power_overwhelming/sensor.h"
 
 
@@ -154,6 +155,33 @@ namespace power_overwhelming {
 
         using sensor::sample;
 
+        /// <summary>
+        /// Answer how the sensor obtains its power readings from NVML.
+        /// </summary>
+        /// <returns>The current sampling mode of the sensor.</returns>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        nvml_sampling_mode sampling_mode(void) const;
+
+        /// <summary>
+        /// Changes how the sensor obtains its power readings from NVML.
+        /// </summary>
+        /// <remarks>
+        /// <para>Changing the sampling mode discards any history of the
+        /// previous mode, ie the first reading of the energy counter or all
+        /// samples that the driver recorded before the mode was changed.
+        /// </para>
+        /// </remarks>
+        /// <param name="mode">The new sampling mode.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::runtime_error">If the sensor has been moved.
+        /// </exception>
+        /// <exception cref="std::invalid_argument">If <paramref name="mode" />
+        /// is not a valid sampling mode.</exception>
+        /// <exception cref="nvml_exception">If the driver does not support the
+        /// requested mode, for instance because it is too old.</exception>
+        nvml_sensor& sampling_mode(_In_ const nvml_sampling_mode mode);
+
         /// <summary>
         /// Asynchronously sample the sensor every
         /// <paramref name="sampling_period "/> microseconds.
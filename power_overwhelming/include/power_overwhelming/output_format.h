@@ -0,0 +1,32 @@
+﻿// <copyright file="output_format.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /// <summary>
+    /// Specifies the format of the file written by a
+    /// <see cref="collector" />.
+    /// </summary>
+    enum class output_format {
+
+        /// <summary>
+        /// A human-readable CSV file with one line per sample.
+        /// </summary>
+        csv,
+
+        /// <summary>
+        /// A compressed binary capture, which can be read using
+        /// <see cref="capture_reader" />.
+        /// </summary>
+        capture
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
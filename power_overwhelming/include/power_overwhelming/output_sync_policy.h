@@ -0,0 +1,41 @@
+﻿// <copyright file="output_sync_policy.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /// <summary>
+    /// Determines when the <see cref="collector" /> forces its output to be
+    /// persisted on the storage device.
+    /// </summary>
+    enum class output_sync_policy {
+
+        /// <summary>
+        /// Leave it to the operating system when the data are persisted. This
+        /// is the fastest option, but data written shortly before a system
+        /// crash might be lost.
+        /// </summary>
+        none,
+
+        /// <summary>
+        /// Synchronise the file once when it is closed.
+        /// </summary>
+        on_close,
+
+        /// <summary>
+        /// Synchronise the file after each block has been written. This limits
+        /// the loss of data on a crash to the current block, but stalls the
+        /// I/O thread of the collector until the storage device has completed
+        /// the operation.
+        /// </summary>
+        every_block
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -15,11 +15,15 @@
 #endif /* defined(_WIN32) */
 
 #include "power_overwhelming/parallel_port_pin.h"
+#include "power_overwhelming/timestamp.h"
 
 
 namespace visus {
 namespace power_overwhelming {
 
+    /* Forward declarations. */
+    class collector;
+
     /// <summary>
     /// Enables application to send trigger signals at low latency via a
     /// parallel port attached to the computer.
@@ -214,6 +218,75 @@ namespace power_overwhelming {
         void pulse(_In_ const parallel_port_pin pins = parallel_port_pin::data,
             _In_ const milliseconds_type period = 500) const;
 
+        /// <summary>
+        /// Activates the given data bits for <paramref name="period" />
+        /// milliseconds, disables all data pins afterwards and injects a
+        /// marker for the rising edge into <paramref name="collector" />.
+        /// </summary>
+        /// <remarks>
+        /// <para>The marker is placed at the timestamp of the rising edge
+        /// rather than at the time when the collector receives it, so it
+        /// lines up with the samples acquired at the time the trigger signal
+        /// was actually emitted.</para>
+        /// <para>The method will <i>not</i> disable the pins before pulsing
+        /// them. The caller must ensure that all relevant pins are low before
+        /// calling the method.</para>
+        /// </remarks>
+        /// <param name="collector">The collector to receive the marker.
+        /// </param>
+        /// <param name="marker">The marker to be injected. If this is
+        /// <c>nullptr</c>, the collector will stop collecting samples.
+        /// </param>
+        /// <param name="data">The data bits to be enabled.</param>
+        /// <param name="period">The period for which the data pins should be
+        /// enabled, in milliseconds. This parameter defaults to 500
+        /// milliseconds.</param>
+        /// <returns>The timestamp of the rising edge.</returns>
+        /// <exception cref="std::system_error">If the data could not be written
+        /// to the port.</exception>
+        timestamp pulse(_In_ collector& collector,
+            _In_opt_z_ const wchar_t *marker,
+            _In_ const value_type data,
+            _In_ const milliseconds_type period = 500) const;
+
+        /// <summary>
+        /// Activates the given data bits at the specified point in time for
+        /// <paramref name="period" /> milliseconds and disables all data pins
+        /// afterwards.
+        /// </summary>
+        /// <remarks>
+        /// <para>This method blocks the calling thread until the pulse has
+        /// been completed. The pulse is emitted from the calling thread, which
+        /// sleeps until shortly before <paramref name="when" /> and spins for
+        /// the rest of the time in order to reduce the jitter of the rising
+        /// edge. While spinning, the priority of the thread is raised, but not
+        /// to the maximum in order not to starve the system. Raising the
+        /// priority is best effort, ie on Linux, real-time scheduling is only
+        /// used if the process has the required privileges. Callers that need
+        /// to continue while the pulse is pending should call this method from
+        /// a thread of their own.</para>
+        /// <para>If <paramref name="when" /> has already passed, the pulse is
+        /// emitted immediately.</para>
+        /// </remarks>
+        /// <param name="when">The point in time at which the rising edge
+        /// should occur.</param>
+        /// <param name="data">The data bits to be enabled.</param>
+        /// <param name="period">The period for which the data pins should be
+        /// enabled, in milliseconds. This parameter defaults to 500
+        /// milliseconds.</param>
+        /// <param name="collector">An optional collector which receives a
+        /// marker for the rising edge.</param>
+        /// <param name="marker">The marker to be injected into
+        /// <paramref name="collector" />.</param>
+        /// <returns>The timestamp of the rising edge.</returns>
+        /// <exception cref="std::system_error">If the data could not be written
+        /// to the port.</exception>
+        timestamp pulse_at(_In_ const timestamp when,
+            _In_ const value_type data,
+            _In_ const milliseconds_type period = 500,
+            _In_opt_ collector *collector = nullptr,
+            _In_opt_z_ const wchar_t *marker = nullptr) const;
+
         /// <summary>
         /// Sets exactly the data bits active in <paramref name="data" />.
         /// </summary>
@@ -222,6 +295,31 @@ namespace power_overwhelming {
         /// to the port.</exception>
         void write(_In_ const value_type data) const;
 
+        /// <summary>
+        /// Sets exactly the data bits active in <paramref name="data" /> and
+        /// records when this happened.
+        /// </summary>
+        /// <remarks>
+        /// The timestamps are taken immediately before and after the call into
+        /// the operating system that changes the pins. The edge on the port
+        /// therefore occurred between <paramref name="before" /> and
+        /// <paramref name="after" />, and the difference between the two is
+        /// the uncertainty of the returned timestamp.
+        /// </remarks>
+        /// <param name="data">The data bits to be enabled.</param>
+        /// <param name="before">If not <c>nullptr</c>, receives the timestamp
+        /// immediately before the port was written.</param>
+        /// <param name="after">If not <c>nullptr</c>, receives the timestamp
+        /// immediately after the port was written.</param>
+        /// <returns>The estimated timestamp of the edge, which is the midpoint
+        /// between <paramref name="before" /> and <paramref name="after" />.
+        /// </returns>
+        /// <exception cref="std::system_error">If the data could not be written
+        /// to the port.</exception>
+        timestamp write(_In_ const value_type data,
+            _Out_opt_ timestamp *before,
+            _Out_opt_ timestamp *after = nullptr) const;
+
         /// <summary>
         /// Sets exactly the data bits active in <paramref name="pins" />.
         /// </summary>
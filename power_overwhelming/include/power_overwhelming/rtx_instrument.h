@@ -352,10 +352,13 @@ namespace power_overwhelming {
 
 #if false
         /// <summary>
-        /// 
+        /// Downloads the data of the specified channel in ASCII format and
+        /// converts them into floating-point numbers.
         /// </summary>
-        /// <param name="channel"></param>
-        /// <returns></returns>
+        /// <param name="channel">The one-based index of the channel to
+        /// retrieve.</param>
+        /// <returns>The channel data as a series of <c>float</c> values like
+        /// the result of <see cref="binary_data" />.</returns>
         blob ascii_data(_In_ const std::uint32_t channel);
 #endif
 
@@ -8,7 +8,9 @@
 
 #include <cinttypes>
 
+#include "power_overwhelming/measurement_data.h"
 #include "power_overwhelming/power_overwhelming_api.h"
+#include "power_overwhelming/timestamp.h"
 
 
 namespace visus {
@@ -18,14 +20,57 @@ namespace power_overwhelming {
     namespace detail { struct time_synchroniser_impl; }
 
     /// <summary>
-    /// 
+    /// Synchronises the local clock with a set of peers using Cristian's
+    /// algorithm.
     /// </summary>
+    /// <remarks>
+    /// <para>The synchroniser continuously probes all registered peers via
+    /// UDP. For each peer, it retains a sliding window of the probes with the
+    /// lowest round-trip time and fits a linear model of offset and drift of
+    /// the peer's clock relative to the local one.</para>
+    /// <para>One of the peers can be designated as the reference, which allows
+    /// for transforming local timestamps into the clock of the reference. An
+    /// <see cref="async_sampling" /> configuration can use this to transform
+    /// samples on the fly while they are being delivered.</para>
+    /// <para>All instances must be created via the factory method
+    /// <see cref="create" />, which also starts the synchroniser. The
+    /// synchroniser answers probes by other instances for as long as it
+    /// exists.</para>
+    /// </remarks>
     class POWER_OVERWHELMING_API time_synchroniser final {
 
     public:
 
+        /// <summary>
+        /// The type used to specify intervals in milliseconds.
+        /// </summary>
+        typedef std::uint32_t milliseconds_type;
+
+        /// <summary>
+        /// The default interval in which the peers are probed.
+        /// </summary>
+        static constexpr milliseconds_type default_probe_interval = 1000;
+
+        /// <summary>
+        /// Creates and starts a new time synchroniser.
+        /// </summary>
+        /// <param name="address_family">The address family of the socket,
+        /// which must be either <c>AF_INET</c> or <c>AF_INET6</c>.</param>
+        /// <param name="port">The UDP port on which the synchroniser answers
+        /// requests by its peers.</param>
+        /// <param name="probe_interval">The interval in milliseconds in which
+        /// the peers are probed.</param>
+        /// <returns>A new time synchroniser.</returns>
+        /// <exception cref="std::invalid_argument">If the address family is
+        /// not supported or the probe interval is zero.</exception>
+        /// <exception cref="std::system_error">If the socket could not be
+        /// created or bound.</exception>
+        /// <exception cref="std::logic_error">If the library was compiled
+        /// without support for the time synchroniser.</exception>
         static time_synchroniser create(_In_ const int address_family,
-            _In_ const std::uint16_t port);
+            _In_ const std::uint16_t port,
+            _In_ const milliseconds_type probe_interval
+            = default_probe_interval);
 
         /// <summary>
         /// Initialise a new instance.
@@ -63,6 +108,79 @@ namespace power_overwhelming {
         /// <returns><c>*this</c></returns>
         time_synchroniser& operator =(_In_ time_synchroniser&& rhs) noexcept;
 
+        /// <summary>
+        /// Adds a peer that is continuously probed by the synchroniser.
+        /// </summary>
+        /// <remarks>
+        /// Adding a peer that has already been registered has no effect.
+        /// </remarks>
+        /// <param name="host">The name or address of the peer.</param>
+        /// <param name="port">The port on which the peer's synchroniser
+        /// listens.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::invalid_argument">If <paramref name="host" />
+        /// is <c>nullptr</c>.</exception>
+        /// <exception cref="std::runtime_error">If the synchroniser has been
+        /// disposed or if the host could not be resolved.</exception>
+        time_synchroniser& add_peer(_In_z_ const char *host,
+            _In_ const std::uint16_t port);
+
+        /// <summary>
+        /// Designates the clock of the given peer as the reference to which
+        /// timestamps are transformed.
+        /// </summary>
+        /// <remarks>
+        /// If the peer has not yet been added, it will be added by this method.
+        /// </remarks>
+        /// <param name="host">The name or address of the peer. If this is
+        /// <c>nullptr</c>, the local clock will become the reference, ie no
+        /// transformation is applied anymore.</param>
+        /// <param name="port">The port on which the peer's synchroniser
+        /// listens.</param>
+        /// <returns><c>*this</c>.</returns>
+        /// <exception cref="std::runtime_error">If the synchroniser has been
+        /// disposed or if the host could not be resolved.</exception>
+        time_synchroniser& reference_peer(_In_opt_z_ const char *host,
+            _In_ const std::uint16_t port = 0);
+
+        /// <summary>
+        /// Answer whether the synchroniser has a model of the reference clock.
+        /// </summary>
+        /// <returns><c>true</c> if the local clock is the reference or if at
+        /// least one probe of the reference peer has been answered,
+        /// <c>false</c> otherwise.</returns>
+        /// <exception cref="std::runtime_error">If the synchroniser has been
+        /// disposed.</exception>
+        bool synchronised(void) const;
+
+        /// <summary>
+        /// Transforms the given local timestamp into the clock of the reference
+        /// peer.
+        /// </summary>
+        /// <param name="timestamp">The local timestamp.</param>
+        /// <returns>The timestamp as seen by the reference peer. If the
+        /// synchroniser is not yet <see cref="synchronised" />, this is the
+        /// input.</returns>
+        /// <exception cref="std::runtime_error">If the synchroniser has been
+        /// disposed.</exception>
+        power_overwhelming::timestamp to_reference(
+            _In_ const power_overwhelming::timestamp timestamp) const;
+
+        /// <summary>
+        /// Transforms the timestamps of the given samples in place into the
+        /// clock of the reference peer.
+        /// </summary>
+        /// <param name="data">The samples to be transformed.</param>
+        /// <param name="cnt">The number of elements in
+        /// <paramref name="data" />.</param>
+        /// <exception cref="std::invalid_argument">If <paramref name="data" />
+        /// is <c>nullptr</c>, but <paramref name="cnt" /> is not
+        /// zero.</exception>
+        /// <exception cref="std::runtime_error">If the synchroniser has been
+        /// disposed.</exception>
+        void to_reference(_Inout_updates_(cnt) measurement_data *data,
+            _In_ const std::size_t cnt) const;
+
         /// <summary>
         /// Determines whether the object is valid.
         /// </summary>
@@ -76,6 +194,13 @@ namespace power_overwhelming {
 
     private:
 
+        /// <summary>
+        /// Throws if the synchroniser has been disposed.
+        /// </summary>
+        /// <exception cref="std::runtime_error">If the object has been disposed
+        /// by a move operation.</exception>
+        void check_not_disposed(void) const;
+
         detail::time_synchroniser_impl *_impl;
 
     };
@@ -190,6 +190,59 @@ namespace power_overwhelming {
             _In_opt_z_ const char *host = default_host,
             _In_ const std::uint16_t port = default_port);
 
+        /// <summary>
+        /// Get the definitions of all current/voltage bricklets attached to
+        /// any of the given Brick daemons.
+        /// </summary>
+        /// <remarks>
+        /// <para>The connections to all Brick daemons are established
+        /// concurrently and all of them share the same deadline, i.e. the
+        /// method takes at most <paramref name="timeout" /> milliseconds
+        /// regardless of the number of endpoints. The method returns early
+        /// if the total number of bricklets found reaches
+        /// <paramref name="cnt" />. If <paramref name="dst" /> is
+        /// <c>nullptr</c> and <paramref name="cnt" /> is zero, the method
+        /// returns as soon as the enumeration has not yielded any new
+        /// bricklet for a short time.</para>
+        /// <para>The results of an enumeration are cached for a while after
+        /// the last connection to a Brick daemon has been closed, so repeated
+        /// calls do not need to wait for the bricklets to be enumerated
+        /// again.</para>
+        /// <para>Endpoints that cannot be connected are silently skipped.
+        /// </para>
+        /// <para>The returned definitions carry the host and port they have
+        /// been discovered on, which will be used if a sensor is created from
+        /// the definition.</para>
+        /// </remarks>
+        /// <param name="dst">Receives the sensor definitions. If
+        /// <c>nullptr</c>, the sensors will only be counted.</param>
+        /// <param name="cnt">Size of <paramref name="dst" /> in elements,
+        /// which is also the total number of bricklets to wait for.</param>
+        /// <param name="hosts">The hosts on which the Brick daemons are
+        /// running. <c>nullptr</c> entries are replaced with
+        /// &quot;localhost&quot;.</param>
+        /// <param name="ports">The ports of the Brick daemons, which must
+        /// hold <paramref name="cnt_endpoints" /> elements. If <c>nullptr</c>,
+        /// the default port 4223 is used for all hosts.</param>
+        /// <param name="cnt_endpoints">The number of elements in
+        /// <paramref name="hosts" />.</param>
+        /// <param name="timeout">The number of milliseconds to wait for the
+        /// bricklets on all Brick daemons to connect. This value defaults to
+        /// 1000.</param>
+        /// <returns>The number of current/voltage bricklets available,
+        /// regardless of how many have been copied.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="hosts" /> is <c>nullptr</c>, but
+        /// <paramref name="cnt_endpoints" /> is not zero.</exception>
+        static std::size_t get_definitions(
+            _When_(dst != nullptr, _Out_writes_opt_(cnt))
+            tinkerforge_sensor_definition *dst,
+            _In_ const std::size_t cnt,
+            _In_reads_(cnt_endpoints) const char *const *hosts,
+            _In_reads_opt_(cnt_endpoints) const std::uint16_t *ports,
+            _In_ const std::size_t cnt_endpoints,
+            _In_ const std::size_t timeout = 1000);
+
         /// <summary>
         /// Initialises a new instance.
         /// </summary>
@@ -241,7 +294,9 @@ namespace power_overwhelming {
         /// Initialises a new instance.
         /// </summary>
         /// <param name="definition">The definition of the bricklet to create
-        /// the sensor for</param>
+        /// the sensor for. If the definition carries the endpoint it has been
+        /// discovered on, this endpoint takes precedence over
+        /// <paramref name="host" /> and <paramref name="port" />.</param>
         /// <param name="host">The host on which the Brick daemon is running.
         /// This parameter defaults to &quot;localhost&quot;.</param>
         /// <param name="port">The port on which the Brick daemon is listening.
@@ -321,6 +376,20 @@ namespace power_overwhelming {
         /// </exception>
         tinkerforge_error_count error_count(void) const;
 
+        /// <summary>
+        /// Answer how often the connection to the Brick daemon has been lost
+        /// since the sensor was created.
+        /// </summary>
+        /// <remarks>
+        /// The sensor reconnects automatically and restores its asynchronous
+        /// sampling configuration, but every disconnect causes a gap in the
+        /// data delivered.
+        /// </remarks>
+        /// <returns>The number of gaps in the data.</returns>
+        /// <exception cref="std::runtime_error">If the sensor has been disposed
+        /// by a move before.</exception>
+        std::size_t gaps(void) const;
+
         /// <summary>
         /// Identify the bricklet used for the sensor.
         /// </summary>
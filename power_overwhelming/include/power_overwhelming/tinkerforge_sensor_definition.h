@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include <cinttypes>
+
 #include "power_overwhelming/power_overwhelming_api.h"
 
 
@@ -16,6 +18,11 @@ namespace power_overwhelming {
     /// Definition of a Tinkerforge sensor allowing the sensor UID and a
     /// description to be specified at the same time.
     /// </summary>
+    /// <remarks>
+    /// Definitions returned by <see cref="tinkerforge_sensor::get_definitions" />
+    /// also carry the Brick daemon endpoint the bricklet has been discovered
+    /// on.
+    /// </remarks>
     class POWER_OVERWHELMING_API tinkerforge_sensor_definition final {
 
     public:
@@ -24,7 +31,8 @@ namespace power_overwhelming {
         /// Initialises a new instance.
         /// </summary>
         inline tinkerforge_sensor_definition(void)
-            : _description(nullptr), _uid(nullptr) { }
+            : _description(nullptr), _host(nullptr), _port(0),
+            _uid(nullptr) { }
 
         /// <summary>
         /// Initialises a new instance.
@@ -36,6 +44,22 @@ namespace power_overwhelming {
         /// could not be allocated.</exception>
         tinkerforge_sensor_definition(_In_z_ const char *uid);
 
+        /// <summary>
+        /// Initialises a new instance for a bricklet attached to the Brick
+        /// daemon on the specified endpoint.
+        /// </summary>
+        /// <param name="uid">The UID of the sensor.</param>
+        /// <param name="host">The host on which the Brick daemon is running.
+        /// </param>
+        /// <param name="port">The port on which the Brick daemon is listening.
+        /// </param>
+        /// <exception cref="std::invalid_argument">If <paramref name="uid" />
+        /// or <paramref name="host" /> is <c>nullptr</c>.</exception>
+        /// <exception cref="std::bad_alloc">If the memory for the UID
+        /// could not be allocated.</exception>
+        tinkerforge_sensor_definition(_In_z_ const char *uid,
+            _In_z_ const char *host, _In_ const std::uint16_t port);
+
         /// <summary>
         /// Clone <paramref name="rhs" />.
         /// </summary>
@@ -51,8 +75,10 @@ namespace power_overwhelming {
         /// <param name="rhs">The object to be moved.</param>
         inline tinkerforge_sensor_definition(
                 _In_ tinkerforge_sensor_definition&& rhs) noexcept
-                : _description(rhs._description), _uid(rhs._uid) {
+                : _description(rhs._description), _host(rhs._host),
+                _port(rhs._port), _uid(rhs._uid) {
             rhs._description = nullptr;
+            rhs._host = nullptr;
             rhs._uid = nullptr;
         }
 
@@ -79,6 +105,25 @@ namespace power_overwhelming {
         /// could not be allocated.</exception>
         void description(_In_opt_z_ const wchar_t *description);
 
+        /// <summary>
+        /// Gets the host of the Brick daemon the sensor is attached to.
+        /// </summary>
+        /// <returns>The host name, or <c>nullptr</c> if the definition has
+        /// not been discovered on a specific endpoint. The object remains
+        /// owner of the memory returned.</returns>
+        inline _Ret_maybenull_z_ const char *host(void) const noexcept {
+            return this->_host;
+        }
+
+        /// <summary>
+        /// Gets the port of the Brick daemon the sensor is attached to.
+        /// </summary>
+        /// <returns>The port, which is only meaningful if
+        /// <see cref="host" /> is not <c>nullptr</c>.</returns>
+        inline std::uint16_t port(void) const noexcept {
+            return this->_port;
+        }
+
         /// <summary>
         /// Gets the UID of the sensor.
         /// </summary>
@@ -109,6 +154,8 @@ namespace power_overwhelming {
     private:
 
         wchar_t *_description;
+        char *_host;
+        std::uint16_t _port;
         char *_uid;
     };
 
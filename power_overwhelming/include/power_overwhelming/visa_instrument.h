@@ -25,6 +25,7 @@ namespace power_overwhelming {
 
     /* Forward declarations. */
     namespace detail { struct visa_instrument_impl; }
+    class hmc8015_sensor;
 
     /// <summary>
     /// Implementation of a VISA instrument, which can be used to implement a
@@ -44,6 +45,15 @@ namespace power_overwhelming {
         /// </summary>
         typedef blob::byte_type byte_type;
 
+        /// <summary>
+        /// The type of a callback that receives the chunks of a binary
+        /// response read by <see cref="read_binary" />.
+        /// </summary>
+        typedef void (*binary_chunk_callback)(
+            _In_reads_bytes_(cnt) const byte_type *chunk,
+            _In_ const std::size_t cnt,
+            _In_opt_ void *context);
+
         /// <summary>
         /// The type used to express device timeouts in milliseconds.
         /// </summary>
@@ -855,6 +865,56 @@ namespace power_overwhelming {
         blob query(_In_z_ const wchar_t *query,
             _In_ const std::size_t buffer_size = 1024) const;
 
+        /// <summary>
+        /// Write the given null-terminated query to the instrument and read
+        /// the response into <paramref name="response" />.
+        /// </summary>
+        /// <remarks>
+        /// The memory of <paramref name="response" /> is reused if it is large
+        /// enough, so callers polling an instrument should keep the blob
+        /// across iterations to avoid any allocation in the steady state.
+        /// </remarks>
+        /// <param name="response">The blob receiving the response, which will
+        /// be truncated to the size of the response.</param>
+        /// <param name="query">The query to be sent to the instrument.</param>
+        /// <returns>The size of the response in bytes.</returns>
+        /// <exception cref="std::invalid_argument">If <paramref name="query" />
+        /// is <c>nullptr</c>.</exception>
+        /// <exception cref="std::runtime_error">If the method is called on an
+        /// object that has been disposed by moving it.</exception>
+        /// <exception cref="visa_exception">If the operation failed. Note that
+        /// a failure here only refers to the use of the API, ie the instrument
+        /// can be in a failed state even if the call succeeded. Use
+        /// <see cref="throw_on_system_error" /> to check the internal state of
+        /// the instrument after the call.</exception>
+        std::size_t query(_Inout_ blob& response,
+            _In_z_ const char *query) const;
+
+        /// <summary>
+        /// Write the given null-terminated query to the instrument and read
+        /// the response into <paramref name="response" />.
+        /// </summary>
+        /// <remarks>
+        /// The memory of <paramref name="response" /> is reused if it is large
+        /// enough, so callers polling an instrument should keep the blob
+        /// across iterations to avoid any allocation in the steady state.
+        /// </remarks>
+        /// <param name="response">The blob receiving the response, which will
+        /// be truncated to the size of the response.</param>
+        /// <param name="query">The query to be sent to the instrument.</param>
+        /// <returns>The size of the response in bytes.</returns>
+        /// <exception cref="std::invalid_argument">If <paramref name="query" />
+        /// is <c>nullptr</c>.</exception>
+        /// <exception cref="std::runtime_error">If the method is called on an
+        /// object that has been disposed by moving it.</exception>
+        /// <exception cref="visa_exception">If the operation failed. Note that
+        /// a failure here only refers to the use of the API, ie the instrument
+        /// can be in a failed state even if the call succeeded. Use
+        /// <see cref="throw_on_system_error" /> to check the internal state of
+        /// the instrument after the call.</exception>
+        std::size_t query(_Inout_ blob& response,
+            _In_z_ const wchar_t *query) const;
+
         /// <summary>
         /// Read from the instrument into the given buffer.
         /// </summary>
@@ -902,6 +962,29 @@ namespace power_overwhelming {
         /// the instrument after the call.</exception>
         blob read_all(_In_ const std::size_t buffer_size = 1024) const;
 
+        /// <summary>
+        /// Read a full response into <paramref name="dst" />.
+        /// </summary>
+        /// <remarks>
+        /// <para>The memory of <paramref name="dst" /> is reused if it is
+        /// large enough, so callers reading repeatedly should keep the blob
+        /// across iterations to avoid any allocation in the steady state.
+        /// </para>
+        /// <para>This method has no effect if the library has been compiled
+        /// without support for VISA.</para>
+        /// </remarks>
+        /// <param name="dst">The blob receiving the response, which will be
+        /// truncated to the size of the response.</param>
+        /// <returns>The size of the response in bytes.</returns>
+        /// <exception cref="std::runtime_error">If the method is called on an
+        /// object that has been disposed by moving it.</exception>
+        /// <exception cref="visa_exception">If the operation failed. Note that
+        /// a failure here only refers to the use of the API, ie the instrument
+        /// can be in a failed state even if the call succeeded. Use
+        /// <see cref="throw_on_system_error" /> to check the internal state of
+        /// the instrument after the call.</exception>
+        std::size_t read_all(_Inout_ blob& dst) const;
+
         /// <summary>
         /// Reads a binary response starting with the # marker for the number of
         /// bytes to follow.
@@ -912,6 +995,56 @@ namespace power_overwhelming {
         /// binary.</exception>
         blob read_binary(void) const;
 
+        /// <summary>
+        /// Reads a binary response starting with the # marker for the number of
+        /// bytes to follow into <paramref name="dst" />.
+        /// </summary>
+        /// <remarks>
+        /// The memory of <paramref name="dst" /> is reused if it is large
+        /// enough, which avoids reallocating large waveforms on every
+        /// acquisition.
+        /// </remarks>
+        /// <param name="dst">The blob receiving the binary data excluding the
+        /// length marker.</param>
+        /// <returns>The size of the binary data in bytes.</returns>
+        /// <exception cref="visa_exception">If the operation failed.</exception>
+        /// <exception cref="std::runtime_error">If the method is called on an
+        /// object that has been disposed by moving it or if the data being read
+        /// are not binary.</exception>
+        std::size_t read_binary(_Inout_ blob& dst) const;
+
+        /// <summary>
+        /// Reads a binary response starting with the # marker for the number of
+        /// bytes to follow and passes the data to <paramref name="callback" />
+        /// in chunks.
+        /// </summary>
+        /// <remarks>
+        /// <para>In contrast to the overload returning a <see cref="blob" />,
+        /// this method never holds more than <paramref name="chunk_size" />
+        /// bytes of the response in memory, which allows for processing large
+        /// responses like log files while they are being received.</para>
+        /// <para>This method does nothing if the library has been compiled
+        /// without support for VISA.</para>
+        /// </remarks>
+        /// <param name="callback">The callback receiving the chunks of the
+        /// response in the order they have been received.</param>
+        /// <param name="context">A user-defined context pointer that is passed
+        /// to <paramref name="callback" />.</param>
+        /// <param name="chunk_size">The maximum size of a chunk in bytes. This
+        /// parameter defaults to 64 KiB.</param>
+        /// <returns>The total size of the binary data excluding the length
+        /// marker.</returns>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="callback" /> is <c>nullptr</c> or if
+        /// <paramref name="chunk_size" /> is zero.</exception>
+        /// <exception cref="std::runtime_error">If the method is called on an
+        /// object that has been disposed by moving it or if the data being read
+        /// are not binary.</exception>
+        /// <exception cref="visa_exception">If the operation failed.</exception>
+        std::size_t read_binary(_In_ const binary_chunk_callback callback,
+            _In_opt_ void *context,
+            _In_ const std::size_t chunk_size = 64 * 1024) const;
+
         /// <summary>
         /// Resets the instrument to its default state by issuing the
         /// <c>*RST</c> command.
@@ -1240,6 +1373,8 @@ namespace power_overwhelming {
 #endif /*defined(POWER_OVERWHELMING_WITH_VISA) */
 
         detail::visa_instrument_impl *_impl;
+
+        friend class hmc8015_sensor;
     };
 
 } /* namespace power_overwhelming */
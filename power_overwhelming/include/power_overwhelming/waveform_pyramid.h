@@ -0,0 +1,393 @@
+﻿// <copyright file="waveform_pyramid.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cstddef>
+
+#include "power_overwhelming/oscilloscope_waveform.h"
+#include "power_overwhelming/timestamp.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+
+    /* Forward declarations. */
+    namespace detail { struct waveform_pyramid_impl; }
+
+
+    /// <summary>
+    /// A min/max/mean level-of-detail pyramid over a regularly sampled series
+    /// of <c>float</c> values like an <see cref="oscilloscope_waveform" />.
+    /// </summary>
+    /// <remarks>
+    /// <para>The finest level of the pyramid summarises
+    /// <see cref="samples_per_bin" /> consecutive samples into a single
+    /// <see cref="waveform_pyramid::bin" />, and each coarser level summarises
+    /// <see cref="fan_out" /> bins of the level below. The pyramid is built
+    /// incrementally while samples are being <see cref="append" />ed, so it
+    /// can be maintained next to a running capture without keeping the raw
+    /// samples around.</para>
+    /// <para>Viewers can <see cref="query" /> any range of samples at any
+    /// resolution. The pyramid selects the finest level that fits into the
+    /// requested number of bins, wherefore the cost of a query is linear in
+    /// the number of bins returned and independent of the number of samples
+    /// in the range.</para>
+    /// <para>The pyramid can be persisted as a compact side car file next to
+    /// the capture it summarises using <see cref="save" /> and restored via
+    /// <see cref="load" />. A restored pyramid can continue to accept new
+    /// samples.</para>
+    /// <para>The pyramid is not copyable, but only movable for performance
+    /// reasons. It is not thread-safe.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API waveform_pyramid final {
+
+    public:
+
+        /// <summary>
+        /// Summary of a range of samples in the pyramid.
+        /// </summary>
+        struct bin final {
+
+            /// <summary>
+            /// The largest value in the range.
+            /// </summary>
+            float maximum;
+
+            /// <summary>
+            /// The arithmetic mean of the values in the range.
+            /// </summary>
+            float mean;
+
+            /// <summary>
+            /// The smallest value in the range.
+            /// </summary>
+            float minimum;
+        };
+
+        /// <summary>
+        /// The default number of bins of a level that are combined into one bin
+        /// of the next coarser level.
+        /// </summary>
+        static constexpr const std::size_t default_fan_out = 4;
+
+        /// <summary>
+        /// The default number of samples summarised in a bin of the finest
+        /// level of the pyramid.
+        /// </summary>
+        static constexpr const std::size_t default_samples_per_bin = 64;
+
+        /// <summary>
+        /// Restores a pyramid from a file previously written by
+        /// <see cref="save" />.
+        /// </summary>
+        /// <param name="path">The path to the file to be read.</param>
+        /// <returns>The pyramid stored in the file.</returns>
+        /// <exception cref="std::invalid_argument">If <paramref name="path" />
+        /// is <c>nullptr</c> or if the file is not a valid pyramid.</exception>
+        /// <exception cref="std::ios_base::failure">If the file could not be
+        /// read.</exception>
+        static waveform_pyramid load(_In_z_ const char *path);
+
+        /// <summary>
+        /// Restores a pyramid from a file previously written by
+        /// <see cref="save" />.
+        /// </summary>
+        /// <param name="path">The path to the file to be read.</param>
+        /// <returns>The pyramid stored in the file.</returns>
+        /// <exception cref="std::invalid_argument">If <paramref name="path" />
+        /// is <c>nullptr</c> or if the file is not a valid pyramid.</exception>
+        /// <exception cref="std::ios_base::failure">If the file could not be
+        /// read.</exception>
+        static waveform_pyramid load(_In_z_ const wchar_t *path);
+
+        /// <summary>
+        /// Initialises a new, invalid instance.
+        /// </summary>
+        inline waveform_pyramid(void) noexcept : _impl(nullptr) { }
+
+        /// <summary>
+        /// Initialises a new and empty pyramid for the given time base.
+        /// </summary>
+        /// <param name="origin">The timestamp of the first sample that will be
+        /// appended to the pyramid.</param>
+        /// <param name="sample_distance">The distance between two adjacent
+        /// samples in seconds.</param>
+        /// <param name="samples_per_bin">The number of samples combined into a
+        /// bin of the finest level. This parameter defaults to
+        /// <see cref="default_samples_per_bin" />.</param>
+        /// <param name="fan_out">The number of bins of a level that are
+        /// combined into a bin of the next coarser level. This parameter
+        /// defaults to <see cref="default_fan_out" />.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="sample_distance" /> is not positive, if
+        /// <paramref name="samples_per_bin" /> is zero or if
+        /// <paramref name="fan_out" /> is less than two.</exception>
+        /// <exception cref="std::bad_alloc">If the memory for the pyramid could
+        /// not be allocated.</exception>
+        waveform_pyramid(_In_ const timestamp origin,
+            _In_ const double sample_distance,
+            _In_ const std::size_t samples_per_bin = default_samples_per_bin,
+            _In_ const std::size_t fan_out = default_fan_out);
+
+        /// <summary>
+        /// Initialises a new pyramid summarising the given waveform.
+        /// </summary>
+        /// <param name="waveform">The waveform to build the pyramid for. The
+        /// time base of the pyramid is derived from the timestamp of the first
+        /// sample and the sample distance of the waveform.</param>
+        /// <param name="samples_per_bin">The number of samples combined into a
+        /// bin of the finest level. This parameter defaults to
+        /// <see cref="default_samples_per_bin" />.</param>
+        /// <param name="fan_out">The number of bins of a level that are
+        /// combined into a bin of the next coarser level. This parameter
+        /// defaults to <see cref="default_fan_out" />.</param>
+        /// <exception cref="std::invalid_argument">If the waveform has no
+        /// valid sample distance, if <paramref name="samples_per_bin" /> is
+        /// zero or if <paramref name="fan_out" /> is less than two.</exception>
+        /// <exception cref="std::bad_alloc">If the memory for the pyramid could
+        /// not be allocated.</exception>
+        explicit waveform_pyramid(_In_ const oscilloscope_waveform& waveform,
+            _In_ const std::size_t samples_per_bin = default_samples_per_bin,
+            _In_ const std::size_t fan_out = default_fan_out);
+
+        /// <summary>
+        /// Initialise from move.
+        /// </summary>
+        /// <param name="rhs">The object to be moved.</param>
+        inline waveform_pyramid(_Inout_ waveform_pyramid&& rhs) noexcept
+                : _impl(rhs._impl) {
+            rhs._impl = nullptr;
+        }
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~waveform_pyramid(void);
+
+        /// <summary>
+        /// Adds the given samples to the end of the pyramid.
+        /// </summary>
+        /// <remarks>
+        /// The amortised cost of adding a sample is constant. The method does
+        /// not retain the samples themselves, but only their summary.
+        /// </remarks>
+        /// <param name="samples">A pointer to at least <paramref name="cnt" />
+        /// samples. This may only be <c>nullptr</c> if <paramref name="cnt" />
+        /// is zero.</param>
+        /// <param name="cnt">The number of samples to be added.</param>
+        /// <exception cref="std::runtime_error">If the pyramid has been
+        /// disposed by a move operation.</exception>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="samples" /> is <c>nullptr</c>, but
+        /// <paramref name="cnt" /> is not zero.</exception>
+        /// <exception cref="std::bad_alloc">If the memory for the pyramid could
+        /// not be allocated.</exception>
+        void append(_In_reads_(cnt) const float *samples,
+            _In_ const std::size_t cnt);
+
+        /// <summary>
+        /// Adds a single sample to the end of the pyramid.
+        /// </summary>
+        /// <param name="sample">The sample to be added.</param>
+        /// <exception cref="std::runtime_error">If the pyramid has been
+        /// disposed by a move operation.</exception>
+        /// <exception cref="std::bad_alloc">If the memory for the pyramid could
+        /// not be allocated.</exception>
+        inline void append(_In_ const float sample) {
+            this->append(&sample, 1);
+        }
+
+        /// <summary>
+        /// Answer the number of bins of a level that are summarised by a bin of
+        /// the next coarser level.
+        /// </summary>
+        /// <returns>The fan-out of the pyramid, or zero if the pyramid is
+        /// invalid.</returns>
+        std::size_t fan_out(void) const noexcept;
+
+        /// <summary>
+        /// Answer the number of levels the pyramid currently has.
+        /// </summary>
+        /// <returns>The number of levels in the pyramid.</returns>
+        std::size_t levels(void) const noexcept;
+
+        /// <summary>
+        /// Answer the timestamp of the first sample in the pyramid.
+        /// </summary>
+        /// <returns>The origin of the time base.</returns>
+        timestamp origin(void) const noexcept;
+
+        /// <summary>
+        /// Retrieves the summary of the samples [<paramref name="begin" />,
+        /// <paramref name="end" />[ at a resolution of at most
+        /// <paramref name="cnt" /> bins.
+        /// </summary>
+        /// <remarks>
+        /// <para>The method selects the finest level of the pyramid that
+        /// covers the requested range with at most <paramref name="cnt" />
+        /// bins. The bins returned are aligned to the bin boundaries of the
+        /// selected level, ie the first bin may start before
+        /// <paramref name="begin" /> and the last one may end after
+        /// <paramref name="end" />. If the requested resolution is finer than
+        /// the finest level, the method returns fewer than
+        /// <paramref name="cnt" /> bins.</para>
+        /// <para>The last bin may summarise fewer samples than the other ones
+        /// if the range extends to the samples that have been appended most
+        /// recently.</para>
+        /// </remarks>
+        /// <param name="dst">A buffer for at least <paramref name="cnt" />
+        /// bins. It is safe to pass <c>nullptr</c>, in which case nothing is
+        /// written, but the number of bins is returned.</param>
+        /// <param name="cnt">The maximum number of bins to be returned.</param>
+        /// <param name="begin">The index of the first sample in the range.
+        /// </param>
+        /// <param name="end">The index of the sample after the last sample in
+        /// the range. This value is clamped to <see cref="size" />.</param>
+        /// <param name="first">If not <c>nullptr</c>, receives the index of the
+        /// first sample summarised by the first bin.</param>
+        /// <param name="width">If not <c>nullptr</c>, receives the number of
+        /// samples summarised by each bin.</param>
+        /// <returns>The number of bins for the requested range, regardless of
+        /// whether these have been written or not.</returns>
+        std::size_t query(_Out_writes_opt_(cnt) bin *dst,
+            _In_ const std::size_t cnt,
+            _In_ const std::size_t begin,
+            _In_ const std::size_t end,
+            _Out_opt_ std::size_t *first = nullptr,
+            _Out_opt_ std::size_t *width = nullptr) const;
+
+        /// <summary>
+        /// Retrieves the summary of the samples in the time range
+        /// [<paramref name="begin" />, <paramref name="end" />[ at a resolution
+        /// of at most <paramref name="cnt" /> bins.
+        /// </summary>
+        /// <remarks>
+        /// The timestamps are converted to sample indices using the time base
+        /// of the pyramid. See the index-based overload for details on how the
+        /// level is selected.
+        /// </remarks>
+        /// <param name="dst">A buffer for at least <paramref name="cnt" />
+        /// bins. It is safe to pass <c>nullptr</c>, in which case nothing is
+        /// written, but the number of bins is returned.</param>
+        /// <param name="cnt">The maximum number of bins to be returned.</param>
+        /// <param name="begin">The begin of the time range.</param>
+        /// <param name="end">The end of the time range.</param>
+        /// <param name="first">If not <c>nullptr</c>, receives the index of the
+        /// first sample summarised by the first bin.</param>
+        /// <param name="width">If not <c>nullptr</c>, receives the number of
+        /// samples summarised by each bin.</param>
+        /// <returns>The number of bins for the requested range, regardless of
+        /// whether these have been written or not.</returns>
+        std::size_t query(_Out_writes_opt_(cnt) bin *dst,
+            _In_ const std::size_t cnt,
+            _In_ const timestamp begin,
+            _In_ const timestamp end,
+            _Out_opt_ std::size_t *first = nullptr,
+            _Out_opt_ std::size_t *width = nullptr) const;
+
+        /// <summary>
+        /// Answer the distance between two adjacent samples in seconds.
+        /// </summary>
+        /// <returns>The sample distance in seconds.</returns>
+        double sample_distance(void) const noexcept;
+
+        /// <summary>
+        /// Answer the index of the sample that is closest to the given
+        /// point in time.
+        /// </summary>
+        /// <param name="timestamp">The point in time to find the sample for.
+        /// </param>
+        /// <returns>The index of the sample, which may be beyond the samples
+        /// that have been added so far. Timestamps before the origin yield
+        /// zero.</returns>
+        std::size_t sample_index(_In_ const timestamp timestamp) const noexcept;
+
+        /// <summary>
+        /// Answer the timestamp of the <paramref name="i" />th sample.
+        /// </summary>
+        /// <param name="i">The index of the sample.</param>
+        /// <returns>The timestamp of the sample.</returns>
+        timestamp sample_timestamp(_In_ const std::size_t i) const noexcept;
+
+        /// <summary>
+        /// Answer the number of samples summarised in a bin of the finest
+        /// level.
+        /// </summary>
+        /// <returns>The number of samples per bin of the finest level, or zero
+        /// if the pyramid is invalid.</returns>
+        std::size_t samples_per_bin(void) const noexcept;
+
+        /// <summary>
+        /// Writes the pyramid to the specified file.
+        /// </summary>
+        /// <remarks>
+        /// The file uses a native binary format, which is only intended to be
+        /// read on a machine with the same byte order.
+        /// </remarks>
+        /// <param name="path">The path of the file to be written. An existing
+        /// file will be overwritten.</param>
+        /// <exception cref="std::invalid_argument">If <paramref name="path" />
+        /// is <c>nullptr</c>.</exception>
+        /// <exception cref="std::runtime_error">If the pyramid has been
+        /// disposed by a move operation.</exception>
+        /// <exception cref="std::ios_base::failure">If the file could not be
+        /// written.</exception>
+        void save(_In_z_ const char *path) const;
+
+        /// <summary>
+        /// Writes the pyramid to the specified file.
+        /// </summary>
+        /// <remarks>
+        /// The file uses a native binary format, which is only intended to be
+        /// read on a machine with the same byte order.
+        /// </remarks>
+        /// <param name="path">The path of the file to be written. An existing
+        /// file will be overwritten.</param>
+        /// <exception cref="std::invalid_argument">If <paramref name="path" />
+        /// is <c>nullptr</c>.</exception>
+        /// <exception cref="std::runtime_error">If the pyramid has been
+        /// disposed by a move operation.</exception>
+        /// <exception cref="std::ios_base::failure">If the file could not be
+        /// written.</exception>
+        void save(_In_z_ const wchar_t *path) const;
+
+        /// <summary>
+        /// Answer the number of samples that have been added to the pyramid.
+        /// </summary>
+        /// <returns>The number of samples summarised by the pyramid.</returns>
+        std::size_t size(void) const noexcept;
+
+        /// <summary>
+        /// Move assignment.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand.</param>
+        /// <returns><c>*this</c>.</returns>
+        waveform_pyramid& operator =(_Inout_ waveform_pyramid&& rhs) noexcept;
+
+        /// <summary>
+        /// Answer whether the pyramid is valid.
+        /// </summary>
+        /// <returns><c>true</c> if the pyramid is valid, <c>false</c> if it
+        /// has been default-constructed or disposed by a move operation.
+        /// </returns>
+        inline operator bool(void) const noexcept {
+            return (this->_impl != nullptr);
+        }
+
+    private:
+
+        inline explicit waveform_pyramid(
+                _In_opt_ detail::waveform_pyramid_impl *impl) noexcept
+            : _impl(impl) { }
+
+        detail::waveform_pyramid_impl& check_not_disposed(void) const;
+
+        detail::waveform_pyramid_impl *_impl;
+    };
+
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -10,7 +10,10 @@
 #include <tchar.h>
 #endif /* defined(_WIN32) */
 
+#include <vector>
+
 #include "power_overwhelming/sensor.h"
+#include "power_overwhelming/time_synchroniser.h"
 
 
 /*
@@ -24,12 +27,15 @@ visus::power_overwhelming::async_sampling::default_interval;
  * visus::power_overwhelming::async_sampling::async_sampling
  */
 visus::power_overwhelming::async_sampling::async_sampling(void)
-        : _callback({ nullptr }),
+        : _batch_size(1),
+        _callback({ nullptr }),
+        _coalescing_window(0),
         _context(nullptr),
         _context_deleter(nullptr),
         _delivery_method(async_delivery_method::on_measurement_data),
         _interval(default_interval),
         _minimum_sleep(0),
+        _time_synchroniser(nullptr),
         _tinkerforge_sensor_source(
             power_overwhelming::tinkerforge_sensor_source::all) { }
 
@@ -42,6 +48,17 @@ visus::power_overwhelming::async_sampling::~async_sampling(void) noexcept {
 }
 
 
+/*
+ * visus::power_overwhelming::async_sampling::coalesces_within
+ */
+visus::power_overwhelming::async_sampling&
+visus::power_overwhelming::async_sampling::coalesces_within(
+        _In_ const microseconds_type window) noexcept {
+    this->_coalescing_window = window;
+    return *this;
+}
+
+
 /*
  * visus::power_overwhelming::async_sampling::deliver
  */
@@ -52,6 +69,18 @@ bool visus::power_overwhelming::async_sampling::deliver(
     auto context = const_cast<void *>(this->_context);
     auto retval = (this->_callback.on_measurement != nullptr);
 
+    if (retval && (this->_time_synchroniser != nullptr)) {
+        // Transform the timestamps into the reference clock. We cannot do this
+        // in place as the input is immutable, but we keep the buffer per
+        // thread such that we do not allocate on every delivery. Note that the
+        // sampler threads deliver one batch at a time, so this cannot be
+        // re-entered with the same buffer.
+        thread_local std::vector<measurement_data> synchronised;
+        synchronised.assign(samples, samples + cnt);
+        this->_time_synchroniser->to_reference(synchronised.data(), cnt);
+        samples = synchronised.data();
+    }
+
     switch (this->_delivery_method) {
         case async_delivery_method::on_measurement:
             if (retval) {
@@ -78,6 +107,73 @@ bool visus::power_overwhelming::async_sampling::deliver(
 }
 
 
+/*
+ * visus::power_overwhelming::async_sampling::deliver
+ */
+bool visus::power_overwhelming::async_sampling::deliver(
+        _In_z_ const wchar_t *source,
+        _In_reads_(cnt) const measurement_data_view *views,
+        _In_ const std::size_t cnt) const {
+    auto context = const_cast<void *>(this->_context);
+    auto retval = (this->_callback.on_measurement != nullptr);
+
+    switch (this->_delivery_method) {
+        case async_delivery_method::on_measurement_data_view:
+            if (retval) {
+                this->_callback.on_measurement_data_views(source, views, cnt,
+                    context);
+            }
+            break;
+
+        case async_delivery_method::on_measurement:
+        case async_delivery_method::on_measurement_data:
+            if (retval) {
+                // The callback cannot handle views, so we need to expand all
+                // of the samples.
+                std::size_t size = 0;
+                for (std::size_t i = 0; i < cnt; ++i) {
+                    size += views[i].size();
+                }
+
+                measurement_data_series series(source);
+                auto dst = measurement_data_series::resize(series, size);
+
+                for (std::size_t i = 0; i < cnt; ++i) {
+                    dst += views[i].expand(dst, views[i].size());
+                }
+
+                retval = this->deliver(series);
+            }
+            break;
+
+        default:
+            // The sampling object was not created for power samples.
+            retval = false;
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::async_sampling::deliver
+ */
+bool visus::power_overwhelming::async_sampling::deliver(
+        _In_ const wchar_t *source,
+        _In_reads_(cnt) const hmc8015_sample *samples,
+        _In_ const std::size_t cnt) const {
+    auto context = const_cast<void *>(this->_context);
+    auto retval = (this->_callback.on_hmc8015_samples != nullptr)
+        && (this->_delivery_method == async_delivery_method::on_hmc8015_sample);
+
+    if (retval) {
+        this->_callback.on_hmc8015_samples(source, samples, cnt, context);
+    }
+
+    return retval;
+}
+
+
 /*
  * visus::power_overwhelming::async_sampling::deliver
  */
@@ -117,6 +213,29 @@ bool visus::power_overwhelming::async_sampling::deliver(
 }
 
 
+/*
+ * visus::power_overwhelming::async_sampling::delivers_hmc8015_samples_to
+ */
+visus::power_overwhelming::async_sampling&
+visus::power_overwhelming::async_sampling::delivers_hmc8015_samples_to(
+        _In_opt_ const on_hmc8015_sample_callback callback) noexcept {
+    this->_callback.on_hmc8015_samples = callback;
+    this->_delivery_method = async_delivery_method::on_hmc8015_sample;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::async_sampling::delivers_in_batches_of
+ */
+visus::power_overwhelming::async_sampling&
+visus::power_overwhelming::async_sampling::delivers_in_batches_of(
+        _In_ const std::size_t cnt) noexcept {
+    this->_batch_size = cnt;
+    return *this;
+}
+
+
 /*
  * visus::power_overwhelming::async_sampling::delivers_measurements_to
  */
@@ -147,6 +266,18 @@ visus::power_overwhelming::async_sampling::delivers_measurement_data_to(
 }
 
 
+/*
+ * ...::async_sampling::delivers_measurement_data_views_to
+ */
+visus::power_overwhelming::async_sampling&
+visus::power_overwhelming::async_sampling::delivers_measurement_data_views_to(
+        _In_opt_ const on_measurement_data_view_callback callback) noexcept {
+    this->_callback.on_measurement_data_views = callback;
+    this->_delivery_method = async_delivery_method::on_measurement_data_view;
+    return *this;
+}
+
+
 /*
  * visus::power_overwhelming::async_sampling::delivers_thermal_samples_to
  */
@@ -238,6 +369,18 @@ visus::power_overwhelming::async_sampling::stores_and_passes_context(
 }
 
 
+/*
+ * visus::power_overwhelming::async_sampling::synchronises_with
+ */
+visus::power_overwhelming::async_sampling&
+visus::power_overwhelming::async_sampling::synchronises_with(
+        _In_opt_ const power_overwhelming::time_synchroniser *synchroniser)
+        noexcept {
+    this->_time_synchroniser = synchroniser;
+    return *this;
+}
+
+
 /*
  * visus::power_overwhelming::async_sampling::operator =
  */
@@ -257,6 +400,12 @@ visus::power_overwhelming::async_sampling::operator =(
         this->_tinkerforge_sensor_source = rhs._tinkerforge_sensor_source;
         rhs._tinkerforge_sensor_source
             = power_overwhelming::tinkerforge_sensor_source::all;
+        this->_coalescing_window = rhs._coalescing_window;
+        rhs._coalescing_window = 0;
+        this->_batch_size = rhs._batch_size;
+        rhs._batch_size = 1;
+        this->_time_synchroniser = rhs._time_synchroniser;
+        rhs._time_synchroniser = nullptr;
     }
 
     return *this;
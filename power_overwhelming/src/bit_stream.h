@@ -0,0 +1,169 @@
+﻿// <copyright file="bit_stream.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cassert>
+#include <cinttypes>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Appends values of arbitrary bit width to a byte buffer, most
+    /// significant bit first.
+    /// </summary>
+    class bit_writer final {
+
+    public:
+
+        /// <summary>
+        /// Initialises a new instance appending to <paramref name="dst" />.
+        /// </summary>
+        /// <param name="dst">The buffer receiving the bytes. The caller must
+        /// make sure that it lives as long as the writer.</param>
+        inline explicit bit_writer(_In_ std::vector<std::uint8_t>& dst)
+            : _bits(0), _buffer(0), _dst(dst) { }
+
+        bit_writer(const bit_writer&) = delete;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        inline ~bit_writer(void) {
+            this->flush();
+        }
+
+        /// <summary>
+        /// Writes the pending bits to the buffer, padding the last byte with
+        /// zeros.
+        /// </summary>
+        inline void flush(void) {
+            if (this->_bits > 0) {
+                this->_dst.push_back(static_cast<std::uint8_t>(
+                    this->_buffer << (8 - this->_bits)));
+                this->_bits = 0;
+                this->_buffer = 0;
+            }
+        }
+
+        /// <summary>
+        /// Writes the lowest <paramref name="bits" /> of
+        /// <paramref name="value" />.
+        /// </summary>
+        /// <param name="value">The value to be written.</param>
+        /// <param name="bits">The number of bits to be written, which must
+        /// be within [0, 64].</param>
+        inline void write(_In_ const std::uint64_t value,
+                _In_ const unsigned int bits) {
+            assert(bits <= 64);
+            if (bits > 32) {
+                // Split large values such that the buffer cannot overflow.
+                this->write(value >> 32, bits - 32);
+                this->write(value, 32);
+                return;
+            }
+
+            if (bits > 0) {
+                const auto mask = (std::uint64_t(1) << bits) - 1;
+                this->_buffer = (this->_buffer << bits) | (value & mask);
+                this->_bits += bits;
+
+                while (this->_bits >= 8) {
+                    this->_bits -= 8;
+                    this->_dst.push_back(static_cast<std::uint8_t>(
+                        this->_buffer >> this->_bits));
+                }
+            }
+        }
+
+        bit_writer& operator =(const bit_writer&) = delete;
+
+    private:
+
+        unsigned int _bits;
+        std::uint64_t _buffer;
+        std::vector<std::uint8_t>& _dst;
+    };
+
+
+    /// <summary>
+    /// Reads values written by a <see cref="bit_writer" />.
+    /// </summary>
+    class bit_reader final {
+
+    public:
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <param name="data">The data to read from, which must live as long
+        /// as the reader.</param>
+        /// <param name="size">The size of <paramref name="data" /> in bytes.
+        /// </param>
+        inline bit_reader(_In_reads_bytes_(size) const std::uint8_t *data,
+                _In_ const std::size_t size) noexcept
+            : _bits(0), _buffer(0), _data(data), _end(data + size) { }
+
+        /// <summary>
+        /// Reads a single bit.
+        /// </summary>
+        /// <returns><c>true</c> if the bit was set, <c>false</c> otherwise.
+        /// </returns>
+        /// <exception cref="std::runtime_error">If the end of the data has
+        /// been reached.</exception>
+        inline bool read_bit(void) {
+            return (this->read(1) != 0);
+        }
+
+        /// <summary>
+        /// Reads a value of the given width.
+        /// </summary>
+        /// <param name="bits">The number of bits to be read, which must be
+        /// within [0, 64].</param>
+        /// <returns>The value in the lowest <paramref name="bits" />.</returns>
+        /// <exception cref="std::runtime_error">If the end of the data has
+        /// been reached.</exception>
+        inline std::uint64_t read(_In_ const unsigned int bits) {
+            assert(bits <= 64);
+            if (bits > 32) {
+                const auto high = this->read(bits - 32);
+                return (high << 32) | this->read(32);
+            }
+
+            while (this->_bits < bits) {
+                if (this->_data >= this->_end) {
+                    throw std::runtime_error("The bit stream ended "
+                        "unexpectedly.");
+                }
+
+                this->_buffer = (this->_buffer << 8) | *this->_data++;
+                this->_bits += 8;
+            }
+
+            this->_bits -= bits;
+            const auto mask = (std::uint64_t(1) << bits) - 1;
+            return (this->_buffer >> this->_bits) & mask;
+        }
+
+    private:
+
+        unsigned int _bits;
+        std::uint64_t _buffer;
+        const std::uint8_t *_data;
+        const std::uint8_t *_end;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -10,14 +10,25 @@
 #include <cstring>
 #include <memory>
 
+#include "blob_pool.h"
+
+
+/*
+ * visus::power_overwhelming::blob::blob
+ */
+visus::power_overwhelming::blob::blob(_In_ const std::size_t size)
+        : _capacity(size), _data(nullptr), _size(size) {
+    this->_data = detail::blob_pool::allocate(this->_capacity);
+}
+
 
 /*
  * visus::power_overwhelming::blob::blob
  */
 visus::power_overwhelming::blob::blob(_In_ const blob& rhs)
-        : _data(nullptr), _size(rhs._size) {
+        : _capacity(rhs._size), _data(nullptr), _size(rhs._size) {
     if (rhs._data != nullptr) {
-        this->_data = new byte_type[this->_size];
+        this->_data = detail::blob_pool::allocate(this->_capacity);
         ::memcpy(this->_data, rhs._data, this->_size);
     }
 
@@ -29,7 +40,8 @@ visus::power_overwhelming::blob::blob(_In_ const blob& rhs)
  * visus::power_overwhelming::blob::blob
  */
 visus::power_overwhelming::blob::blob(_Inout_ blob&& rhs) noexcept
-        : _data(rhs._data), _size(rhs._size) {
+        : _capacity(rhs._capacity), _data(rhs._data), _size(rhs._size) {
+    rhs._capacity = 0;
     rhs._data = nullptr;
     rhs._size = 0;
     assert(rhs._data == nullptr);
@@ -41,7 +53,7 @@ visus::power_overwhelming::blob::blob(_Inout_ blob&& rhs) noexcept
  * visus::power_overwhelming::blob::~blob
  */
 visus::power_overwhelming::blob::~blob(void) {
-    delete[] this->_data;
+    detail::blob_pool::deallocate(this->_data, this->_capacity);
 }
 
 
@@ -73,7 +85,8 @@ _Ret_maybenull_ const void *visus::power_overwhelming::blob::at(
  * visus::power_overwhelming::blob::clear
  */
 void visus::power_overwhelming::blob::clear(void) {
-    delete[] this->_data;
+    detail::blob_pool::deallocate(this->_data, this->_capacity);
+    this->_capacity = 0;
     this->_data = nullptr;
     this->_size = 0;
 }
@@ -108,14 +121,20 @@ bool visus::power_overwhelming::blob::grow(_In_ const std::size_t size) {
     const auto retval = (size > this->_size);
 
     if (retval) {
-        const auto existing = this->_data;
-        this->_data = new byte_type[size];
+        if (size > this->_capacity) {
+            auto capacity = size;
+            auto data = detail::blob_pool::allocate(capacity);
+
+            if (this->_data != nullptr) {
+                ::memcpy(data, this->_data, this->_size);
+            }
 
-        if (existing != nullptr) {
-            ::memcpy(this->_data, existing, this->_size);
-            delete[] existing;
-            this->_size = size;
+            detail::blob_pool::deallocate(this->_data, this->_capacity);
+            this->_capacity = capacity;
+            this->_data = data;
         }
+
+        this->_size = size;
     }
 
     return retval;
@@ -173,9 +192,20 @@ bool visus::power_overwhelming::blob::reserve(_In_ const std::size_t size) {
     const auto retval = (size > this->_size);
 
     if (retval) {
-        delete[] this->_data;
+        if (size > this->_capacity) {
+            // Free the old block first, because we do not need to copy and
+            // the pool might be able to give it to us again.
+            detail::blob_pool::deallocate(this->_data, this->_capacity);
+            this->_capacity = 0;
+            this->_data = nullptr;
+            this->_size = 0;
+
+            auto capacity = size;
+            this->_data = detail::blob_pool::allocate(capacity);
+            this->_capacity = capacity;
+        }
+
         this->_size = size;
-        this->_data = new byte_type[this->_size];
     }
 
     return retval;
@@ -186,15 +216,14 @@ bool visus::power_overwhelming::blob::reserve(_In_ const std::size_t size) {
  * visus::power_overwhelming::blob::resize
  */
 void visus::power_overwhelming::blob::resize(_In_ const std::size_t size) {
-    if (this->_size != size) {
-        delete[] this->_data;
-        this->_size = size;
+    if (size == 0) {
+        this->clear();
 
-        if (this->_size > 0) {
-            this->_data = new byte_type[this->_size];
-        } else {
-            this->_data = nullptr;
-        }
+    } else if (size > this->_capacity) {
+        this->reserve(size);
+
+    } else {
+        this->_size = size;
     }
 }
 
@@ -203,20 +232,13 @@ void visus::power_overwhelming::blob::resize(_In_ const std::size_t size) {
  * visus::power_overwhelming::blob::truncate
  */
 void visus::power_overwhelming::blob::truncate(_In_ const std::size_t size) {
-    if (this->_size != size) {
-        const auto existing = this->_data;
-
-        if (size > 0) {
-            this->_data = new byte_type[size];
-        } else {
-            this->_data = nullptr;
-        }
+    if (size == 0) {
+        this->clear();
 
-        if ((this->_data != nullptr) && (existing != nullptr)) {
-            ::memcpy(this->_data, existing, (std::min)(this->_size, size));
-        }
+    } else if (size > this->_capacity) {
+        this->grow(size);
 
-        delete[] existing;
+    } else {
         this->_size = size;
     }
 }
@@ -228,18 +250,11 @@ void visus::power_overwhelming::blob::truncate(_In_ const std::size_t size) {
 visus::power_overwhelming::blob& visus::power_overwhelming::blob::operator =(
         _In_ const blob& rhs) {
     if (this != std::addressof(rhs)) {
-        if ((this->_data != nullptr) && (this->_size != rhs._size)) {
-            delete[] this->_data;
-            this->_data = nullptr;
-        }
-
-        this->_size = rhs._size;
-        if ((this->_data == nullptr) && (rhs._data != nullptr)) {
-            this->_data = new byte_type[this->_size];
-        }
+        if (rhs._data == nullptr) {
+            this->clear();
 
-        if (this->_data != nullptr) {
-            assert(rhs._data != nullptr);
+        } else {
+            this->resize(rhs._size);
             ::memcpy(this->_data, rhs._data, this->_size);
         }
     }
@@ -257,6 +272,9 @@ visus::power_overwhelming::blob& visus::power_overwhelming::blob::operator =(
 visus::power_overwhelming::blob& visus::power_overwhelming::blob::operator =(
         _Inout_ blob&& rhs) noexcept {
     if (this != std::addressof(rhs)) {
+        detail::blob_pool::deallocate(this->_data, this->_capacity);
+        this->_capacity = rhs._capacity;
+        rhs._capacity = 0;
         this->_data = rhs._data;
         rhs._data = nullptr;
         this->_size = rhs._size;
@@ -266,4 +284,4 @@ visus::power_overwhelming::blob& visus::power_overwhelming::blob::operator =(
     assert(rhs._data == nullptr);
     assert(rhs._size == 0);
     return *this;
-}
\ No newline at end of file
+}
@@ -0,0 +1,315 @@
+﻿// <copyright file="blob_pool.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "blob_pool.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <new>
+#include <vector>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else /* defined(_WIN32) */
+#include <sys/mman.h>
+#endif /* defined(_WIN32) */
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Answer the index of the size class of the given capacity, which must
+    /// be a power of two between the minimum and the maximum class size.
+    /// </summary>
+    static constexpr std::size_t blob_pool_class(
+            _In_ const std::size_t capacity) noexcept {
+        std::size_t retval = 0;
+
+        for (auto s = blob_pool::min_class_size; s < capacity; s <<= 1) {
+            ++retval;
+        }
+
+        return retval;
+    }
+
+    /// <summary>
+    /// The number of size classes the pool manages.
+    /// </summary>
+    static constexpr std::size_t blob_pool_classes = blob_pool_class(
+        blob_pool::max_class_size) + 1;
+
+    /// <summary>
+    /// Allocates a block of exactly <paramref name="size" /> bytes bypassing
+    /// the pool.
+    /// </summary>
+    static blob_pool::byte_type *blob_pool_allocate(
+            _In_ const std::size_t size) {
+        if (size < blob_pool::large_page_size) {
+            return static_cast<blob_pool::byte_type *>(::operator new(size));
+        }
+
+#if defined(_WIN32)
+        // Large pages require the SeLockMemoryPrivilege, which most users do
+        // not have, so we fall back to normal pages if this fails.
+        void *retval = nullptr;
+        const auto page = ::GetLargePageMinimum();
+
+        if ((page > 0) && (size % page == 0)) {
+            retval = ::VirtualAlloc(nullptr, size,
+                MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+        }
+
+        if (retval == nullptr) {
+            retval = ::VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT,
+                PAGE_READWRITE);
+        }
+
+        if (retval == nullptr) {
+            throw std::bad_alloc();
+        }
+
+#else /* defined(_WIN32) */
+        auto retval = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (retval == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+
+#if defined(MADV_HUGEPAGE)
+        // This is only a hint for transparent huge pages, so we do not care
+        // whether it succeeds.
+        ::madvise(retval, size, MADV_HUGEPAGE);
+#endif /* defined(MADV_HUGEPAGE) */
+#endif /* defined(_WIN32) */
+
+        return static_cast<blob_pool::byte_type *>(retval);
+    }
+
+    /// <summary>
+    /// Frees a block allocated by <see cref="blob_pool_allocate" />.
+    /// </summary>
+    static void blob_pool_free(_In_ blob_pool::byte_type *data,
+            _In_ const std::size_t size) noexcept {
+        assert(data != nullptr);
+        if (size < blob_pool::large_page_size) {
+            ::operator delete(data);
+        } else {
+#if defined(_WIN32)
+            ::VirtualFree(data, 0, MEM_RELEASE);
+#else /* defined(_WIN32) */
+            ::munmap(data, size);
+#endif /* defined(_WIN32) */
+        }
+    }
+
+    /// <summary>
+    /// Indicates that the free lists of the calling thread have already been
+    /// destroyed, which happens if a blob outlives the thread-local storage.
+    /// </summary>
+    static thread_local bool blob_pool_gone = false;
+
+    /// <summary>
+    /// The thread-local free lists of the pool.
+    /// </summary>
+    struct blob_pool_cache final {
+        std::array<std::vector<blob_pool::byte_type *>, blob_pool_classes>
+            blocks;
+        std::size_t retained = 0;
+
+        inline ~blob_pool_cache(void) {
+            this->clear();
+            blob_pool_gone = true;
+        }
+
+        void clear(void) noexcept {
+            auto size = blob_pool::min_class_size;
+            for (auto& b : this->blocks) {
+                for (auto d : b) {
+                    blob_pool_free(d, size);
+                }
+                b.clear();
+                size <<= 1;
+            }
+            this->retained = 0;
+        }
+    };
+
+    /// <summary>
+    /// Answer the free lists of the calling thread or <c>nullptr</c> if they
+    /// have already been destroyed.
+    /// </summary>
+    static blob_pool_cache *blob_pool_thread_cache(void) noexcept {
+        static thread_local blob_pool_cache cache;
+        return blob_pool_gone ? nullptr : &cache;
+    }
+
+    /// <summary>
+    /// Answer the free lists of the calling thread if the given capacity is
+    /// cached or <c>nullptr</c> otherwise.
+    /// </summary>
+    static blob_pool_cache *blob_pool_cache_for(
+            _In_ const std::size_t capacity) noexcept {
+        if (capacity > blob_pool::max_class_size) {
+            return nullptr;
+        }
+
+        assert(capacity >= blob_pool::min_class_size);
+        return blob_pool_thread_cache();
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::detail::blob_pool::allocate
+ */
+visus::power_overwhelming::detail::blob_pool::byte_type *
+visus::power_overwhelming::detail::blob_pool::allocate(
+        _Inout_ std::size_t& size) {
+    if (size == 0) {
+        return nullptr;
+    }
+
+    size = round_up(size);
+
+    auto cache = blob_pool_cache_for(size);
+    if (cache != nullptr) {
+        auto& list = cache->blocks[blob_pool_class(size)];
+        if (!list.empty()) {
+            auto retval = list.back();
+            list.pop_back();
+            assert(cache->retained >= size);
+            cache->retained -= size;
+            return retval;
+        }
+    }
+
+    return blob_pool_allocate(size);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::blob_pool::deallocate
+ */
+void visus::power_overwhelming::detail::blob_pool::deallocate(
+        _In_opt_ byte_type *data,
+        _In_ const std::size_t capacity) noexcept {
+    assert(capacity == round_up(capacity));
+    if (data == nullptr) {
+        return;
+    }
+
+    try {
+        auto cache = blob_pool_cache_for(capacity);
+        if ((cache != nullptr)
+                && (cache->retained + capacity <= thread_budget)) {
+            auto& list = cache->blocks[blob_pool_class(capacity)];
+            const auto limit = (std::min)(cache_budget / capacity,
+                max_cached_blocks);
+
+            if (list.size() < limit) {
+                list.push_back(data);
+                cache->retained += capacity;
+                return;
+            }
+        }
+    } catch (...) {
+        // If we cannot grow the free list, we free the block.
+    }
+
+    blob_pool_free(data, capacity);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::blob_pool::retained
+ */
+std::size_t visus::power_overwhelming::detail::blob_pool::retained(
+        void) noexcept {
+    auto cache = blob_pool_thread_cache();
+    return (cache != nullptr) ? cache->retained : 0;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::blob_pool::round_up
+ */
+std::size_t visus::power_overwhelming::detail::blob_pool::round_up(
+        _In_ const std::size_t size) noexcept {
+    if (size == 0) {
+        return 0;
+
+    } else if (size > max_class_size) {
+        // Huge blocks are not cached, so we only round to the page size.
+        return ((size + large_page_size - 1) / large_page_size)
+            * large_page_size;
+
+    } else {
+        auto retval = min_class_size;
+        while (retval < size) {
+            retval <<= 1;
+        }
+        return retval;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::blob_pool::trim
+ */
+void visus::power_overwhelming::detail::blob_pool::trim(void) noexcept {
+    auto cache = blob_pool_thread_cache();
+    if (cache != nullptr) {
+        cache->clear();
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::blob_pool::cache_budget
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::blob_pool::cache_budget;
+
+
+/*
+ * visus::power_overwhelming::detail::blob_pool::large_page_size
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::blob_pool::large_page_size;
+
+
+/*
+ * visus::power_overwhelming::detail::blob_pool::max_cached_blocks
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::blob_pool::max_cached_blocks;
+
+
+/*
+ * visus::power_overwhelming::detail::blob_pool::max_class_size
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::blob_pool::max_class_size;
+
+
+/*
+ * visus::power_overwhelming::detail::blob_pool::min_class_size
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::blob_pool::min_class_size;
+
+
+/*
+ * visus::power_overwhelming::detail::blob_pool::thread_budget
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::blob_pool::thread_budget;
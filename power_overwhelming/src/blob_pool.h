@@ -0,0 +1,132 @@
+﻿// <copyright file="blob_pool.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// A pool of memory blocks in power-of-two size classes, which serves the
+    /// allocations of <see cref="blob" />.
+    /// </summary>
+    /// <remarks>
+    /// <para>Instrument I/O allocates buffers of the same size over and over
+    /// again, for instance when polling a sensor or when downloading
+    /// waveforms. The pool keeps freed blocks on a thread-local free list
+    /// per size class, so that these allocations neither take a lock nor hit
+    /// the heap in the steady state. The number of blocks kept per class is
+    /// bounded such that the pool does not retain more than
+    /// <see cref="cache_budget" /> bytes per class and thread, but it always
+    /// keeps at least one block as long as the thread does not retain more
+    /// than <see cref="thread_budget" /> bytes in total.</para>
+    /// <para>Blocks of at least <see cref="large_page_size" /> bytes are
+    /// allocated directly from the operating system and are backed by large
+    /// pages if possible, which reduces TLB pressure when processing large
+    /// waveforms. Blocks larger than <see cref="max_class_size" /> are not
+    /// cached at all.</para>
+    /// <para>Blocks can be returned to the pool from any thread, because all
+    /// of them are allocated from process-wide allocators.</para>
+    /// </remarks>
+    class blob_pool final {
+
+    public:
+
+        /// <summary>
+        /// The type of the bytes allocated.
+        /// </summary>
+        typedef std::uint8_t byte_type;
+
+        /// <summary>
+        /// The number of bytes each thread retains at most per size class.
+        /// </summary>
+        static constexpr std::size_t cache_budget = 16 * 1024 * 1024;
+
+        /// <summary>
+        /// The maximum number of blocks retained per size class and thread.
+        /// </summary>
+        static constexpr std::size_t max_cached_blocks = 64;
+
+        /// <summary>
+        /// The size of the largest size class. Larger blocks are allocated
+        /// and freed on demand.
+        /// </summary>
+        static constexpr std::size_t max_class_size = cache_budget;
+
+        /// <summary>
+        /// The size of the smallest size class.
+        /// </summary>
+        static constexpr std::size_t min_class_size = 64;
+
+        /// <summary>
+        /// The size from which on blocks are allocated from the operating
+        /// system and backed by large pages if possible.
+        /// </summary>
+        static constexpr std::size_t large_page_size = 2 * 1024 * 1024;
+
+        /// <summary>
+        /// The number of bytes each thread retains at most in all size
+        /// classes together.
+        /// </summary>
+        static constexpr std::size_t thread_budget = 32 * 1024 * 1024;
+
+        /// <summary>
+        /// Allocates a block of at least <paramref name="size" /> bytes.
+        /// </summary>
+        /// <param name="size">The requested size in bytes, which receives the
+        /// actual capacity of the block. This capacity must be passed to
+        /// <see cref="deallocate" />.</param>
+        /// <returns>The block, which is <c>nullptr</c> if
+        /// <paramref name="size" /> is zero.</returns>
+        /// <exception cref="std::bad_alloc">If the memory could not be
+        /// allocated.</exception>
+        static byte_type *allocate(_Inout_ std::size_t& size);
+
+        /// <summary>
+        /// Returns a block to the pool.
+        /// </summary>
+        /// <param name="data">The block to be returned. It is safe to pass
+        /// <c>nullptr</c>.</param>
+        /// <param name="capacity">The capacity of the block as returned by
+        /// <see cref="allocate" />.</param>
+        static void deallocate(_In_opt_ byte_type *data,
+            _In_ const std::size_t capacity) noexcept;
+
+        /// <summary>
+        /// Answer the number of bytes in the blocks cached by the calling
+        /// thread.
+        /// </summary>
+        /// <returns>The number of bytes retained by the calling
+        /// thread.</returns>
+        static std::size_t retained(void) noexcept;
+
+        /// <summary>
+        /// Computes the capacity of the block that would be allocated for a
+        /// request of <paramref name="size" /> bytes.
+        /// </summary>
+        /// <param name="size">The requested size in bytes.</param>
+        /// <returns>The capacity of the block.</returns>
+        static std::size_t round_up(_In_ const std::size_t size) noexcept;
+
+        /// <summary>
+        /// Frees all blocks cached by the calling thread.
+        /// </summary>
+        static void trim(void) noexcept;
+
+        blob_pool(void) = delete;
+
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
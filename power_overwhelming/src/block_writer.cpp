@@ -0,0 +1,389 @@
+﻿// <copyright file="block_writer.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "block_writer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#else /* defined(_WIN32) */
+#include <fcntl.h>
+#include <unistd.h>
+#endif /* defined(_WIN32) */
+
+#include "power_overwhelming/convert_string.h"
+
+#include "io_util.h"
+
+
+namespace {
+
+    /// <summary>
+    /// Allocates <paramref name="size" /> bytes aligned to
+    /// <paramref name="alignment" />.
+    /// </summary>
+    void *aligned_allocate(_In_ const std::size_t size,
+            _In_ const std::size_t alignment) {
+#if defined(_WIN32)
+        auto retval = ::_aligned_malloc(size, alignment);
+#else /* defined(_WIN32) */
+        void *retval = nullptr;
+        if (::posix_memalign(&retval, alignment, size) != 0) {
+            retval = nullptr;
+        }
+#endif /* defined(_WIN32) */
+
+        if (retval == nullptr) {
+            throw std::bad_alloc();
+        }
+
+        return retval;
+    }
+
+    /// <summary>
+    /// Frees memory allocated by <see cref="aligned_allocate" />.
+    /// </summary>
+    void aligned_free(_In_opt_ void *ptr) noexcept {
+#if defined(_WIN32)
+        ::_aligned_free(ptr);
+#else /* defined(_WIN32) */
+        ::free(ptr);
+#endif /* defined(_WIN32) */
+    }
+
+}
+
+
+/*
+ * visus::power_overwhelming::detail::block_writer::block_writer
+ */
+visus::power_overwhelming::detail::block_writer::block_writer(
+        _In_z_ const wchar_t *path,
+        _In_ const std::size_t block_size,
+        _In_ const std::size_t blocks,
+        _In_ const output_sync_policy policy,
+        _In_ const bool direct_io)
+    : _block_size(0), _closing(false), _direct_io(false), _policy(policy) {
+    if (path == nullptr) {
+        throw std::invalid_argument("The path to the output file must not be "
+            "null.");
+    }
+    if (block_size == 0) {
+        throw std::invalid_argument("The block size must be positive.");
+    }
+    if (blocks == 0) {
+        throw std::invalid_argument("At least one block is required.");
+    }
+
+    this->_block_size = ((block_size + alignment - 1) / alignment) * alignment;
+
+#if defined(_WIN32)
+    this->_file = detail::open(path, GENERIC_WRITE, FILE_SHARE_READ,
+        CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN);
+#else /* defined(_WIN32) */
+    {
+        const auto p = power_overwhelming::convert_string<char>(path);
+        const auto flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+        const auto mode = 0644;
+
+#if defined(O_DIRECT)
+        if (direct_io) {
+            // Not all file systems support direct I/O, in which case open
+            // fails with EINVAL and we fall back to normal I/O.
+            this->_file = ::open(p.c_str(), flags | O_DIRECT, mode);
+            this->_direct_io = (this->_file != -1);
+        }
+#endif /* defined(O_DIRECT) */
+
+        if (!this->_direct_io) {
+            this->_file = detail::open(p.c_str(), flags, mode);
+        }
+    }
+#endif /* defined(_WIN32) */
+
+    try {
+        this->_blocks.reserve(blocks);
+        for (std::size_t i = 0; i < blocks; ++i) {
+            this->_blocks.push_back(static_cast<char_type *>(aligned_allocate(
+                this->_block_size, alignment)));
+        }
+        this->_free = this->_blocks;
+
+        this->_thread = std::thread(&block_writer::io, this);
+    } catch (...) {
+        for (auto b : this->_blocks) {
+            aligned_free(b);
+        }
+#if defined(_WIN32)
+        ::CloseHandle(this->_file);
+#else /* defined(_WIN32) */
+        ::close(this->_file);
+#endif /* defined(_WIN32) */
+        throw;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::block_writer::~block_writer
+ */
+visus::power_overwhelming::detail::block_writer::~block_writer(void) {
+    try {
+        this->close();
+    } catch (...) { /* There is no one we could report this to. */ }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::block_writer::close
+ */
+void visus::power_overwhelming::detail::block_writer::close(void) {
+    if (!this->is_open()) {
+        return;
+    }
+
+    // Hand the last, incomplete block to the I/O thread and wait for it to
+    // exit once all blocks have been written.
+    this->submit();
+    {
+        std::lock_guard<decltype(this->_lock)> l(this->_lock);
+        this->_closing = true;
+    }
+    this->_full_changed.notify_all();
+    this->_thread.join();
+
+    if ((this->_error == nullptr)
+            && (this->_policy != output_sync_policy::none)) {
+        // If we flush after every block, we need to make sure that the tail is
+        // persisted, too.
+#if defined(_WIN32)
+        if (!::FlushFileBuffers(this->_file)) {
+            this->_error = std::make_exception_ptr(std::system_error(
+                ::GetLastError(), std::system_category()));
+        }
+#else /* defined(_WIN32) */
+        if (::fsync(this->_file) != 0) {
+            this->_error = std::make_exception_ptr(std::system_error(
+                errno, std::system_category()));
+        }
+#endif /* defined(_WIN32) */
+    }
+
+#if defined(_WIN32)
+    ::CloseHandle(this->_file);
+#else /* defined(_WIN32) */
+    ::close(this->_file);
+#endif /* defined(_WIN32) */
+
+    for (auto b : this->_blocks) {
+        aligned_free(b);
+    }
+    this->_blocks.clear();
+    this->_free.clear();
+
+    if (this->_error != nullptr) {
+        std::rethrow_exception(this->_error);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::block_writer::overflow
+ */
+visus::power_overwhelming::detail::block_writer::int_type
+visus::power_overwhelming::detail::block_writer::overflow(int_type c) {
+    this->submit();
+
+    if (!this->acquire()) {
+        return traits_type::eof();
+    }
+
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *this->pptr() = traits_type::to_char_type(c);
+        this->pbump(1);
+    }
+
+    return traits_type::not_eof(c);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::block_writer::sync
+ */
+int visus::power_overwhelming::detail::block_writer::sync(void) {
+    // The I/O thread might fall back to normal I/O at any time, in which case
+    // we might miss the first opportunity to submit a partial block.
+    if (!this->_direct_io.load(std::memory_order::memory_order_acquire)) {
+        this->submit();
+    }
+
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    return (this->_error == nullptr) ? 0 : -1;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::block_writer::xsputn
+ */
+std::streamsize visus::power_overwhelming::detail::block_writer::xsputn(
+        const char_type *s, std::streamsize cnt) {
+    assert((s != nullptr) || (cnt == 0));
+    std::streamsize retval = 0;
+
+    while (retval < cnt) {
+        if (this->pptr() == this->epptr()) {
+            if (traits_type::eq_int_type(this->overflow(traits_type::eof()),
+                    traits_type::eof())) {
+                break;
+            }
+        }
+
+        const auto chunk = (std::min)(cnt - retval,
+            static_cast<std::streamsize>(this->epptr() - this->pptr()));
+        ::memcpy(this->pptr(), s + retval, static_cast<std::size_t>(chunk));
+        this->pbump(static_cast<int>(chunk));
+        retval += chunk;
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::block_writer::acquire
+ */
+bool visus::power_overwhelming::detail::block_writer::acquire(void) {
+    assert(this->pbase() == nullptr);
+    std::unique_lock<decltype(this->_lock)> l(this->_lock);
+    this->_free_changed.wait(l, [this](void) {
+        return (!this->_free.empty() || (this->_error != nullptr));
+    });
+
+    if (this->_error != nullptr) {
+        return false;
+    }
+
+    auto block = this->_free.back();
+    this->_free.pop_back();
+    this->setp(block, block + this->_block_size);
+    return true;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::block_writer::io
+ */
+void visus::power_overwhelming::detail::block_writer::io(void) {
+    while (true) {
+        block_type block;
+
+        {
+            std::unique_lock<decltype(this->_lock)> l(this->_lock);
+            this->_full_changed.wait(l, [this](void) {
+                return (!this->_full.empty() || this->_closing);
+            });
+
+            if (this->_full.empty()) {
+                // We have been asked to exit and written everything.
+                break;
+            }
+
+            block = this->_full.front();
+            this->_full.pop_front();
+        }
+
+        try {
+            this->write(block);
+        } catch (...) {
+            std::lock_guard<decltype(this->_lock)> l(this->_lock);
+            if (this->_error == nullptr) {
+                this->_error = std::current_exception();
+            }
+        }
+
+        {
+            std::lock_guard<decltype(this->_lock)> l(this->_lock);
+            this->_free.push_back(block.data);
+        }
+        this->_free_changed.notify_one();
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::block_writer::submit
+ */
+void visus::power_overwhelming::detail::block_writer::submit(void) {
+    if (this->pbase() == nullptr) {
+        // There is no current block.
+        return;
+    }
+
+    block_type block;
+    block.data = this->pbase();
+    block.size = static_cast<std::size_t>(this->pptr() - this->pbase());
+    this->setp(nullptr, nullptr);
+
+    {
+        std::lock_guard<decltype(this->_lock)> l(this->_lock);
+        if (block.size > 0) {
+            this->_full.push_back(block);
+        } else {
+            this->_free.push_back(block.data);
+        }
+    }
+    this->_full_changed.notify_one();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::block_writer::write
+ */
+void visus::power_overwhelming::detail::block_writer::write(
+        _In_ const block_type& block) {
+#if (defined(O_DIRECT) && !defined(_WIN32))
+    if (this->_direct_io.load(std::memory_order::memory_order_acquire)
+            && ((block.size % alignment) != 0)) {
+        // Direct I/O requires the size to be a multiple of the sector size,
+        // which is only violated by the tail of the file. Therefore, we
+        // can switch to normal I/O for the rest of the file.
+        const auto flags = ::fcntl(this->_file, F_GETFL);
+        if ((flags == -1) || (::fcntl(this->_file, F_SETFL, flags & ~O_DIRECT)
+                == -1)) {
+            throw std::system_error(errno, std::system_category());
+        }
+        this->_direct_io.store(false, std::memory_order::memory_order_release);
+    }
+#endif /* (defined(O_DIRECT) && !defined(_WIN32)) */
+
+    write_bytes(this->_file, block.data, block.size);
+
+    if (this->_policy == output_sync_policy::every_block) {
+#if defined(_WIN32)
+        if (!::FlushFileBuffers(this->_file)) {
+            throw std::system_error(::GetLastError(), std::system_category());
+        }
+#else /* defined(_WIN32) */
+        if (::fdatasync(this->_file) != 0) {
+            throw std::system_error(errno, std::system_category());
+        }
+#endif /* defined(_WIN32) */
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::block_writer::alignment
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::block_writer::alignment;
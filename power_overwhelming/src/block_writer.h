@@ -0,0 +1,201 @@
+﻿// <copyright file="block_writer.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <streambuf>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#endif /* defined(_WIN32) */
+
+#include "power_overwhelming/output_sync_policy.h"
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// A stream buffer that collects its output in large blocks, which are
+    /// written to a file by a dedicated I/O thread.
+    /// </summary>
+    /// <remarks>
+    /// <para>The thread using the stream formats into one block while the I/O
+    /// thread writes the blocks that have been filled before. If all blocks
+    /// are full, the formatting thread waits for the I/O thread, which
+    /// bounds the memory consumption.</para>
+    /// <para>Errors of the I/O thread put the stream into the bad state and
+    /// are rethrown by <see cref="close" />.</para>
+    /// <para>The stream buffer does not support seeking, wherefore
+    /// <c>tellp</c> of a stream using it will always fail.</para>
+    /// </remarks>
+    class POWER_OVERWHELMING_API block_writer final : public std::streambuf {
+
+    public:
+
+        /// <summary>
+        /// The alignment of the blocks, which also is the granularity of their
+        /// size.
+        /// </summary>
+        static constexpr std::size_t alignment = 4096;
+
+        /// <summary>
+        /// Opens the given file for writing, truncating it if it exists.
+        /// </summary>
+        /// <param name="path">The path to the file to be written.</param>
+        /// <param name="block_size">The size of a block in bytes, which will
+        /// be rounded up to the next multiple of <see cref="alignment" />.
+        /// </param>
+        /// <param name="blocks">The number of blocks, which must be at least
+        /// two in order to allow for formatting and I/O to overlap.</param>
+        /// <param name="policy">Determines when the file is synchronised with
+        /// the storage device.</param>
+        /// <param name="direct_io">If <c>true</c>, try to bypass the page
+        /// cache of the operating system. This is currently only supported on
+        /// Linux and silently ignored if the file system does not support it.
+        /// </param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="path" /> is <c>nullptr</c> or if
+        /// <paramref name="block_size" /> or <paramref name="blocks" /> is
+        /// zero.</exception>
+        /// <exception cref="std::system_error">If the file could not be
+        /// opened.</exception>
+        block_writer(_In_z_ const wchar_t *path,
+            _In_ const std::size_t block_size,
+            _In_ const std::size_t blocks = 2,
+            _In_ const output_sync_policy policy = output_sync_policy::none,
+            _In_ const bool direct_io = false);
+
+        block_writer(const block_writer&) = delete;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        /// <remarks>
+        /// The destructor closes the file if this has not yet been done
+        /// explicitly, but it discards any error doing so.
+        /// </remarks>
+        ~block_writer(void);
+
+        /// <summary>
+        /// Writes all pending data, waits for the I/O thread to exit and
+        /// closes the file.
+        /// </summary>
+        /// <remarks>
+        /// It is safe to call this method multiple times.
+        /// </remarks>
+        /// <exception cref="std::system_error">If any write operation failed.
+        /// </exception>
+        void close(void);
+
+        /// <summary>
+        /// Answer whether the file is written bypassing the page cache.
+        /// </summary>
+        /// <returns><c>true</c> if direct I/O is in use, <c>false</c>
+        /// otherwise.</returns>
+        inline bool direct_io(void) const noexcept {
+            return this->_direct_io.load(
+                std::memory_order::memory_order_acquire);
+        }
+
+        /// <summary>
+        /// Answer whether the file is open.
+        /// </summary>
+        /// <returns><c>true</c> if the file is open, <c>false</c> if it has
+        /// been closed.</returns>
+        inline bool is_open(void) const noexcept {
+            return this->_thread.joinable();
+        }
+
+        block_writer& operator =(const block_writer&) = delete;
+
+    protected:
+
+        /// <summary>
+        /// Hands the current block to the I/O thread and continues with the
+        /// next one.
+        /// </summary>
+        int_type overflow(int_type c) override;
+
+        /// <summary>
+        /// Hands the current block to the I/O thread even if it is not full.
+        /// </summary>
+        /// <remarks>
+        /// If direct I/O is used, only full blocks can be written while the
+        /// file is open, wherefore this method has no effect in this case.
+        /// </remarks>
+        int sync(void) override;
+
+        /// <summary>
+        /// Copies <paramref name="cnt" /> characters into the blocks.
+        /// </summary>
+        std::streamsize xsputn(const char_type *s,
+            std::streamsize cnt) override;
+
+    private:
+
+        /// <summary>
+        /// Represents a block that is ready to be written.
+        /// </summary>
+        struct block_type {
+            char_type *data;
+            std::size_t size;
+        };
+
+        /// <summary>
+        /// Waits for a free block and makes it the current one.
+        /// </summary>
+        /// <returns><c>true</c> on success, <c>false</c> if the I/O thread
+        /// failed.</returns>
+        bool acquire(void);
+
+        /// <summary>
+        /// Runs in <see cref="_thread" /> and writes all blocks submitted.
+        /// </summary>
+        void io(void);
+
+        /// <summary>
+        /// Hands the current block to the I/O thread.
+        /// </summary>
+        void submit(void);
+
+        /// <summary>
+        /// Writes the given block to the file.
+        /// </summary>
+        void write(_In_ const block_type& block);
+
+        std::size_t _block_size;
+        std::vector<char_type *> _blocks;
+        bool _closing;
+        std::atomic<bool> _direct_io;
+        std::exception_ptr _error;
+#if defined(_WIN32)
+        HANDLE _file;
+#else /* defined(_WIN32) */
+        int _file;
+#endif /* defined(_WIN32) */
+        std::vector<char_type *> _free;
+        std::condition_variable _free_changed;
+        std::deque<block_type> _full;
+        std::condition_variable _full_changed;
+        std::mutex _lock;
+        output_sync_policy _policy;
+        std::thread _thread;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
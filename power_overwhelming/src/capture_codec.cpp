@@ -0,0 +1,411 @@
+﻿// <copyright file="capture_codec.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "capture_codec.h"
+
+#include <cassert>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif /* defined(_MSC_VER) */
+
+#if defined(POWER_OVERWHELMING_WITH_ZSTD)
+#include <zstd.h>
+#endif /* defined(POWER_OVERWHELMING_WITH_ZSTD) */
+
+#include "bit_stream.h"
+
+
+namespace {
+
+    using visus::power_overwhelming::detail::bit_reader;
+    using visus::power_overwhelming::detail::bit_writer;
+    using visus::power_overwhelming::detail::capture_sample;
+
+    /// <summary>
+    /// The marker assumed before the first sample of a block.
+    /// </summary>
+    constexpr std::uint32_t initial_marker = UINT32_MAX;
+
+    /// <summary>
+    /// The buckets for delta-of-delta values by the number of bits required
+    /// to store them. The prefix of a bucket is <c>1</c> repeated as many
+    /// times as its index plus one, followed by a zero unless it is the last
+    /// bucket. A delta-of-delta of zero is a single zero bit.
+    /// </summary>
+    constexpr unsigned int dod_buckets[] = { 7, 12, 20, 32, 64 };
+
+    /// <summary>
+    /// Counts the leading zero bits of a non-zero value.
+    /// </summary>
+    inline unsigned int count_leading_zeros(const std::uint32_t value) {
+        assert(value != 0);
+#if defined(_MSC_VER)
+        unsigned long retval;
+        ::_BitScanReverse(&retval, value);
+        return 31 - retval;
+#else /* defined(_MSC_VER) */
+        return __builtin_clz(value);
+#endif /* defined(_MSC_VER) */
+    }
+
+    /// <summary>
+    /// Counts the trailing zero bits of a non-zero value.
+    /// </summary>
+    inline unsigned int count_trailing_zeros(const std::uint32_t value) {
+        assert(value != 0);
+#if defined(_MSC_VER)
+        unsigned long retval;
+        ::_BitScanForward(&retval, value);
+        return retval;
+#else /* defined(_MSC_VER) */
+        return __builtin_ctz(value);
+#endif /* defined(_MSC_VER) */
+    }
+
+    /// <summary>
+    /// Reinterprets the bits of a floating-point number.
+    /// </summary>
+    inline std::uint32_t to_bits(const float value) noexcept {
+        std::uint32_t retval;
+        ::memcpy(&retval, &value, sizeof(retval));
+        return retval;
+    }
+
+    /// <summary>
+    /// Reinterprets bits as floating-point number.
+    /// </summary>
+    inline float to_float(const std::uint32_t value) noexcept {
+        float retval;
+        ::memcpy(&retval, &value, sizeof(retval));
+        return retval;
+    }
+
+    /// <summary>
+    /// Encodes the timestamps of the samples as differences of their
+    /// differences, which are zero for perfectly regular samples.
+    /// </summary>
+    void encode_timestamps(bit_writer& writer, const capture_sample *src,
+            const std::size_t cnt) {
+        // The arithmetic is performed on unsigned numbers, which wrap around
+        // instead of causing undefined behaviour on overflow.
+        auto prev = static_cast<std::uint64_t>(src[0].timestamp);
+        std::uint64_t prev_delta = 0;
+        writer.write(prev, 64);
+
+        for (std::size_t i = 1; i < cnt; ++i) {
+            const auto cur = static_cast<std::uint64_t>(src[i].timestamp);
+            const auto delta = cur - prev;
+            const auto dod = static_cast<std::int64_t>(delta - prev_delta);
+            prev = cur;
+            prev_delta = delta;
+
+            if (dod == 0) {
+                writer.write(0, 1);
+                continue;
+            }
+
+            const auto last = std::size(dod_buckets) - 1;
+            for (std::size_t b = 0; b <= last; ++b) {
+                const auto bits = dod_buckets[b];
+                const auto bias = (std::int64_t(1) << (bits - 1)) - 1;
+
+                if ((b == last) || ((dod >= -bias) && (dod <= bias + 1))) {
+                    // Write the prefix identifying the bucket and the biased
+                    // value, which makes it positive.
+                    const auto prefix = (b == last) ? b + 1 : b + 2;
+                    const auto ones = (std::uint64_t(1) << (b + 1)) - 1;
+                    writer.write(ones << (prefix - b - 1), prefix);
+                    writer.write((b == last)
+                        ? static_cast<std::uint64_t>(dod)
+                        : static_cast<std::uint64_t>(dod + bias), bits);
+                    break;
+                }
+            }
+        }
+    }
+
+    /// <summary>
+    /// Decodes the output of <see cref="encode_timestamps" />.
+    /// </summary>
+    void decode_timestamps(capture_sample *dst, const std::size_t cnt,
+            bit_reader& reader) {
+        auto prev = reader.read(64);
+        std::uint64_t prev_delta = 0;
+        dst[0].timestamp = static_cast<capture_sample::timestamp_type>(prev);
+
+        for (std::size_t i = 1; i < cnt; ++i) {
+            std::uint64_t dod = 0;
+
+            if (reader.read_bit()) {
+                const auto last = std::size(dod_buckets) - 1;
+                std::size_t b = 0;
+                while ((b < last) && reader.read_bit()) {
+                    ++b;
+                }
+
+                const auto bits = dod_buckets[b];
+                const auto bias = (std::int64_t(1) << (bits - 1)) - 1;
+                dod = reader.read(bits);
+                if (b != last) {
+                    dod = static_cast<std::uint64_t>(
+                        static_cast<std::int64_t>(dod) - bias);
+                }
+            }
+
+            prev_delta += dod;
+            prev += prev_delta;
+            dst[i].timestamp = static_cast<capture_sample::timestamp_type>(
+                prev);
+        }
+    }
+
+    /// <summary>
+    /// Encodes the given member of the samples using the XOR of consecutive
+    /// values, which only needs to store the bits that changed.
+    /// </summary>
+    void encode_values(bit_writer& writer, const capture_sample *src,
+            const std::size_t cnt,
+            float capture_sample:: *member) {
+        auto prev = to_bits(src[0].*member);
+        unsigned int window_leading = 0;
+        unsigned int window_trailing = 0;
+        auto have_window = false;
+        writer.write(prev, 32);
+
+        for (std::size_t i = 1; i < cnt; ++i) {
+            const auto cur = to_bits(src[i].*member);
+            const auto x = cur ^ prev;
+            prev = cur;
+
+            if (x == 0) {
+                writer.write(0, 1);
+                continue;
+            }
+
+            const auto leading = count_leading_zeros(x);
+            const auto trailing = count_trailing_zeros(x);
+
+            if (have_window && (leading >= window_leading)
+                    && (trailing >= window_trailing)) {
+                // The changed bits fit into the window of the previous value,
+                // so we only need to store the window.
+                writer.write(0x2, 2);
+                writer.write(x >> window_trailing,
+                    32 - window_leading - window_trailing);
+
+            } else {
+                const auto meaningful = 32 - leading - trailing;
+                writer.write(0x3, 2);
+                writer.write(leading, 5);
+                writer.write(meaningful - 1, 5);
+                writer.write(x >> trailing, meaningful);
+                window_leading = leading;
+                window_trailing = trailing;
+                have_window = true;
+            }
+        }
+    }
+
+    /// <summary>
+    /// Decodes the output of <see cref="encode_values" />.
+    /// </summary>
+    void decode_values(capture_sample *dst, const std::size_t cnt,
+            bit_reader& reader, float capture_sample:: *member) {
+        auto prev = static_cast<std::uint32_t>(reader.read(32));
+        unsigned int window_leading = 0;
+        unsigned int window_trailing = 0;
+        dst[0].*member = to_float(prev);
+
+        for (std::size_t i = 1; i < cnt; ++i) {
+            if (reader.read_bit()) {
+                if (reader.read_bit()) {
+                    window_leading = static_cast<unsigned int>(reader.read(5));
+                    const auto meaningful = static_cast<unsigned int>(
+                        reader.read(5)) + 1;
+                    if (window_leading + meaningful > 32) {
+                        throw std::runtime_error("The encoded block is "
+                            "corrupt.");
+                    }
+                    window_trailing = 32 - window_leading - meaningful;
+                }
+
+                const auto x = reader.read(32 - window_leading
+                    - window_trailing);
+                prev ^= static_cast<std::uint32_t>(x << window_trailing);
+            }
+
+            dst[i].*member = to_float(prev);
+        }
+    }
+
+    /// <summary>
+    /// Encodes the markers as flags whether they changed.
+    /// </summary>
+    void encode_markers(bit_writer& writer, const capture_sample *src,
+            const std::size_t cnt) {
+        auto prev = initial_marker;
+
+        for (std::size_t i = 0; i < cnt; ++i) {
+            if (src[i].marker == prev) {
+                writer.write(0, 1);
+            } else {
+                writer.write(1, 1);
+                writer.write(src[i].marker, 32);
+                prev = src[i].marker;
+            }
+        }
+    }
+
+    /// <summary>
+    /// Decodes the output of <see cref="encode_markers" />.
+    /// </summary>
+    void decode_markers(capture_sample *dst, const std::size_t cnt,
+            bit_reader& reader) {
+        auto prev = initial_marker;
+
+        for (std::size_t i = 0; i < cnt; ++i) {
+            if (reader.read_bit()) {
+                prev = static_cast<std::uint32_t>(reader.read(32));
+            }
+
+            dst[i].marker = prev;
+        }
+    }
+
+}
+
+
+/*
+ * visus::power_overwhelming::detail::compress_capture_block
+ */
+void visus::power_overwhelming::detail::compress_capture_block(
+        _Out_ std::vector<std::uint8_t>& dst,
+        _In_reads_bytes_(cnt) const std::uint8_t *src,
+        _In_ const std::size_t cnt,
+        _In_ const capture_compression compression) {
+    switch (compression) {
+        case capture_compression::none:
+            dst.assign(src, src + cnt);
+            break;
+
+        case capture_compression::zstd: {
+#if defined(POWER_OVERWHELMING_WITH_ZSTD)
+            dst.resize(::ZSTD_compressBound(cnt));
+            const auto size = ::ZSTD_compress(dst.data(), dst.size(),
+                src, cnt, ZSTD_CLEVEL_DEFAULT);
+            if (::ZSTD_isError(size)) {
+                throw std::runtime_error(::ZSTD_getErrorName(size));
+            }
+            dst.resize(size);
+#else /* defined(POWER_OVERWHELMING_WITH_ZSTD) */
+            throw std::logic_error("This operation is not supported without "
+                "Zstandard.");
+#endif /* defined(POWER_OVERWHELMING_WITH_ZSTD) */
+            } break;
+
+        default:
+            throw std::invalid_argument("The specified compression method is "
+                "not supported.");
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::decode_capture_block
+ */
+void visus::power_overwhelming::detail::decode_capture_block(
+        _Out_writes_(cnt) capture_sample *dst,
+        _In_ const std::size_t cnt,
+        _In_reads_bytes_(size) const std::uint8_t *src,
+        _In_ const std::size_t size) {
+    if (cnt < 1) {
+        return;
+    }
+
+    assert(dst != nullptr);
+    bit_reader reader(src, size);
+    decode_timestamps(dst, cnt, reader);
+    decode_values(dst, cnt, reader, &capture_sample::voltage);
+    decode_values(dst, cnt, reader, &capture_sample::current);
+    decode_values(dst, cnt, reader, &capture_sample::power);
+    decode_markers(dst, cnt, reader);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::decompress_capture_block
+ */
+void visus::power_overwhelming::detail::decompress_capture_block(
+        _Out_ std::vector<std::uint8_t>& dst,
+        _In_ const std::size_t size,
+        _In_reads_bytes_(cnt) const std::uint8_t *src,
+        _In_ const std::size_t cnt,
+        _In_ const capture_compression compression) {
+    switch (compression) {
+        case capture_compression::none:
+            if (cnt != size) {
+                throw std::runtime_error("The size of an uncompressed block "
+                    "does not match its header.");
+            }
+            dst.assign(src, src + cnt);
+            break;
+
+        case capture_compression::zstd: {
+#if defined(POWER_OVERWHELMING_WITH_ZSTD)
+            // Do not trust the size from the file before allocating memory
+            // for it: it must be in line with what the frame claims to hold
+            // and with what the writer could have produced.
+            if ((size > capture_max_chunk_size) || (::ZSTD_getFrameContentSize(
+                    src, cnt) != static_cast<unsigned long long>(size))) {
+                throw std::runtime_error("The size of a compressed block does "
+                    "not match its header.");
+            }
+
+            dst.resize(size);
+            const auto s = ::ZSTD_decompress(dst.data(), dst.size(), src, cnt);
+            if (::ZSTD_isError(s)) {
+                throw std::runtime_error(::ZSTD_getErrorName(s));
+            }
+            if (s != size) {
+                throw std::runtime_error("The size of a decompressed block "
+                    "does not match its header.");
+            }
+#else /* defined(POWER_OVERWHELMING_WITH_ZSTD) */
+            throw std::logic_error("This operation is not supported without "
+                "Zstandard.");
+#endif /* defined(POWER_OVERWHELMING_WITH_ZSTD) */
+            } break;
+
+        default:
+            throw std::runtime_error("The block was compressed with an "
+                "unknown method.");
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::encode_capture_block
+ */
+void visus::power_overwhelming::detail::encode_capture_block(
+        _Inout_ std::vector<std::uint8_t>& dst,
+        _In_reads_(cnt) const capture_sample *src,
+        _In_ const std::size_t cnt) {
+    if (cnt < 1) {
+        return;
+    }
+
+    assert(src != nullptr);
+    bit_writer writer(dst);
+    encode_timestamps(writer, src, cnt);
+    encode_values(writer, src, cnt, &capture_sample::voltage);
+    encode_values(writer, src, cnt, &capture_sample::current);
+    encode_values(writer, src, cnt, &capture_sample::power);
+    encode_markers(writer, src, cnt);
+}
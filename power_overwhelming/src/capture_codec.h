@@ -0,0 +1,117 @@
+﻿// <copyright file="capture_codec.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include <vector>
+
+#include "power_overwhelming/capture_compression.h"
+
+#include "capture_format.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The minimum number of bits <see cref="encode_capture_block" /> emits
+    /// for a sample, which is one bit for each of its members if nothing
+    /// changed since the previous sample.
+    /// </summary>
+    /// <remarks>
+    /// Readers use this to reject blocks that claim to contain more samples
+    /// than their size allows for before allocating memory for them.
+    /// </remarks>
+    constexpr std::size_t capture_min_sample_bits = 5;
+
+    /// <summary>
+    /// Compresses the encoded samples of a block using the given method.
+    /// </summary>
+    /// <remarks>
+    /// This function is only exported for testing.
+    /// </remarks>
+    /// <param name="dst">The buffer receiving the compressed data, which
+    /// will be overwritten.</param>
+    /// <param name="src">The encoded samples.</param>
+    /// <param name="cnt">The size of <paramref name="src" /> in bytes.</param>
+    /// <param name="compression">The compression method.</param>
+    /// <exception cref="std::logic_error">If the library was built without
+    /// support for the requested compression method.</exception>
+    /// <exception cref="std::runtime_error">If the compression failed.
+    /// </exception>
+    POWER_OVERWHELMING_API void compress_capture_block(
+        _Out_ std::vector<std::uint8_t>& dst,
+        _In_reads_bytes_(cnt) const std::uint8_t *src,
+        _In_ const std::size_t cnt,
+        _In_ const capture_compression compression);
+
+    /// <summary>
+    /// Decodes the samples of a block.
+    /// </summary>
+    /// <remarks>
+    /// This function is only exported for testing.
+    /// </remarks>
+    /// <param name="dst">A buffer for at least <paramref name="cnt" />
+    /// samples.</param>
+    /// <param name="cnt">The number of samples in the block.</param>
+    /// <param name="src">The encoded samples, which must not be compressed.
+    /// </param>
+    /// <param name="size">The size of <paramref name="src" /> in bytes.
+    /// </param>
+    /// <exception cref="std::runtime_error">If <paramref name="src" /> is
+    /// too short for <paramref name="cnt" /> samples.</exception>
+    POWER_OVERWHELMING_API void decode_capture_block(
+        _Out_writes_(cnt) capture_sample *dst,
+        _In_ const std::size_t cnt,
+        _In_reads_bytes_(size) const std::uint8_t *src,
+        _In_ const std::size_t size);
+
+    /// <summary>
+    /// Decompresses a block that has been compressed with
+    /// <see cref="compress_capture_block" />.
+    /// </summary>
+    /// <remarks>
+    /// This function is only exported for testing.
+    /// </remarks>
+    /// <param name="dst">The buffer receiving the encoded samples, which
+    /// will be resized to <paramref name="size" />.</param>
+    /// <param name="size">The size of the encoded samples before they were
+    /// compressed.</param>
+    /// <param name="src">The compressed data.</param>
+    /// <param name="cnt">The size of <paramref name="src" /> in bytes.</param>
+    /// <param name="compression">The compression method.</param>
+    /// <exception cref="std::logic_error">If the library was built without
+    /// support for the requested compression method.</exception>
+    /// <exception cref="std::runtime_error">If the data are corrupt.
+    /// </exception>
+    POWER_OVERWHELMING_API void decompress_capture_block(
+        _Out_ std::vector<std::uint8_t>& dst,
+        _In_ const std::size_t size,
+        _In_reads_bytes_(cnt) const std::uint8_t *src,
+        _In_ const std::size_t cnt,
+        _In_ const capture_compression compression);
+
+    /// <summary>
+    /// Encodes the given samples as a block.
+    /// </summary>
+    /// <remarks>
+    /// This function is only exported for testing.
+    /// </remarks>
+    /// <param name="dst">The buffer the encoded samples are appended to.
+    /// </param>
+    /// <param name="src">The samples to be encoded.</param>
+    /// <param name="cnt">The number of samples.</param>
+    POWER_OVERWHELMING_API void encode_capture_block(
+        _Inout_ std::vector<std::uint8_t>& dst,
+        _In_reads_(cnt) const capture_sample *src,
+        _In_ const std::size_t cnt);
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
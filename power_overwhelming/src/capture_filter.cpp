@@ -0,0 +1,149 @@
+﻿// <copyright file="capture_filter.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/capture_filter.h"
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+
+
+/*
+ * visus::power_overwhelming::capture_filter::capture_filter
+ */
+visus::power_overwhelming::capture_filter::capture_filter(void) noexcept
+    : _begin((std::numeric_limits<timestamp::value_type>::min)()),
+    _cnt_sensors(0),
+    _end((std::numeric_limits<timestamp::value_type>::max)()),
+    _sensors(nullptr) { }
+
+
+/*
+ * visus::power_overwhelming::capture_filter::capture_filter
+ */
+visus::power_overwhelming::capture_filter::capture_filter(
+        _In_ const capture_filter& rhs) : _cnt_sensors(0), _sensors(nullptr) {
+    *this = rhs;
+}
+
+
+/*
+ * visus::power_overwhelming::capture_filter::capture_filter
+ */
+visus::power_overwhelming::capture_filter::capture_filter(
+        _Inout_ capture_filter&& rhs) noexcept
+        : _cnt_sensors(0), _sensors(nullptr) {
+    *this = std::move(rhs);
+}
+
+
+/*
+ * visus::power_overwhelming::capture_filter::~capture_filter
+ */
+visus::power_overwhelming::capture_filter::~capture_filter(void) {
+    delete[] this->_sensors;
+}
+
+
+/*
+ * visus::power_overwhelming::capture_filter::begin
+ */
+visus::power_overwhelming::capture_filter&
+visus::power_overwhelming::capture_filter::begin(
+        _In_ const power_overwhelming::timestamp begin) noexcept {
+    this->_begin = begin;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::capture_filter::end
+ */
+visus::power_overwhelming::capture_filter&
+visus::power_overwhelming::capture_filter::end(
+        _In_ const power_overwhelming::timestamp end) noexcept {
+    this->_end = end;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::capture_filter::matches
+ */
+bool visus::power_overwhelming::capture_filter::matches(
+        _In_ const id_type sensor) const noexcept {
+    return (this->_cnt_sensors == 0) || std::binary_search(this->_sensors,
+        this->_sensors + this->_cnt_sensors, sensor);
+}
+
+
+/*
+ * visus::power_overwhelming::capture_filter::sensor
+ */
+visus::power_overwhelming::capture_filter&
+visus::power_overwhelming::capture_filter::sensor(_In_ const id_type sensor) {
+    const auto end = this->_sensors + this->_cnt_sensors;
+    const auto it = std::lower_bound(this->_sensors, end, sensor);
+
+    if ((it == end) || (*it != sensor)) {
+        // Keep the sensors sorted such that we can use binary search when
+        // testing them.
+        const auto pos = it - this->_sensors;
+        auto sensors = new id_type[this->_cnt_sensors + 1];
+        std::copy(this->_sensors, it, sensors);
+        sensors[pos] = sensor;
+        std::copy(it, end, sensors + pos + 1);
+
+        delete[] this->_sensors;
+        this->_sensors = sensors;
+        ++this->_cnt_sensors;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::capture_filter::operator =
+ */
+visus::power_overwhelming::capture_filter&
+visus::power_overwhelming::capture_filter::operator =(
+        _In_ const capture_filter& rhs) {
+    if (this != std::addressof(rhs)) {
+        auto sensors = (rhs._cnt_sensors > 0)
+            ? new id_type[rhs._cnt_sensors]
+            : nullptr;
+        std::copy(rhs._sensors, rhs._sensors + rhs._cnt_sensors, sensors);
+
+        delete[] this->_sensors;
+        this->_begin = rhs._begin;
+        this->_cnt_sensors = rhs._cnt_sensors;
+        this->_end = rhs._end;
+        this->_sensors = sensors;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::capture_filter::operator =
+ */
+visus::power_overwhelming::capture_filter&
+visus::power_overwhelming::capture_filter::operator =(
+        _Inout_ capture_filter&& rhs) noexcept {
+    if (this != std::addressof(rhs)) {
+        delete[] this->_sensors;
+        this->_begin = rhs._begin;
+        this->_cnt_sensors = rhs._cnt_sensors;
+        rhs._cnt_sensors = 0;
+        this->_end = rhs._end;
+        this->_sensors = rhs._sensors;
+        rhs._sensors = nullptr;
+    }
+
+    return *this;
+}
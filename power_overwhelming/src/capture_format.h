@@ -0,0 +1,210 @@
+﻿// <copyright file="capture_format.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include <type_traits>
+
+#include "power_overwhelming/capture_compression.h"
+#include "power_overwhelming/measurement_data.h"
+#include "power_overwhelming/timestamp.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /*
+     * A capture file starts with a capture_file_header, which is followed by a
+     * sequence of chunks. Each chunk starts with a capture_chunk_header, which
+     * is followed by the number of payload bytes given in the header. Sensors
+     * and markers are declared in their own chunks before the first block
+     * referring to them, such that a file can be read sequentially even if
+     * the index at its end is missing, for instance because the writer
+     * crashed. If the index has been written, the file ends with a
+     * capture_trailer pointing to it. The index contains the offsets of all
+     * name chunks besides the descriptions of the blocks, such that a reader
+     * can open a closed capture without touching anything but the index and
+     * the names. All data are in little-endian byte order.
+     *
+     * The samples of a block belong to a single sensor. They are stored in
+     * columns in a single bit stream: the timestamps using delta-of-delta
+     * encoding, the voltages, currents and powers using the XOR encoding of
+     * Facebook's Gorilla database and finally the markers as flags whether
+     * they changed. As the encoders are reset for each block, every block can
+     * be decoded on its own. The bit stream may additionally be compressed
+     * as a whole, which is recorded in the block header.
+     */
+
+    /// <summary>
+    /// Identifies the type of a chunk in a capture file.
+    /// </summary>
+    enum class capture_chunk_id : std::uint32_t {
+
+        /// <summary>
+        /// Associates a sensor ID with the name of the sensor. The payload is
+        /// a <see cref="capture_name" /> followed by the UTF-8 name.
+        /// </summary>
+        sensor = 0x0001,
+
+        /// <summary>
+        /// Associates a marker ID with the name of the marker. The payload is
+        /// a <see cref="capture_name" /> followed by the UTF-8 name.
+        /// </summary>
+        marker = 0x0002,
+
+        /// <summary>
+        /// A <see cref="capture_block_header" /> followed by the encoded
+        /// samples.
+        /// </summary>
+        block = 0x0003,
+
+        /// <summary>
+        /// A <see cref="capture_index_header" /> followed by the 64-bit
+        /// offsets of the chunks declaring the sensors and the markers, each
+        /// in the order of their IDs, and by one
+        /// <see cref="capture_index_entry" /> for each block in the file.
+        /// </summary>
+        index = 0x0004
+    };
+
+    /// <summary>
+    /// The header at the begin of a capture file.
+    /// </summary>
+    struct capture_file_header {
+        std::uint8_t magic[8];
+        std::uint32_t version;
+        std::uint32_t reserved;
+    };
+
+    /// <summary>
+    /// The header of each chunk in a capture file.
+    /// </summary>
+    struct capture_chunk_header {
+        capture_chunk_id id;
+        std::uint32_t reserved;
+        std::uint64_t size;
+    };
+
+    /// <summary>
+    /// Precedes the name in <see cref="capture_chunk_id::sensor" /> and
+    /// <see cref="capture_chunk_id::marker" /> chunks.
+    /// </summary>
+    struct capture_name {
+        std::uint32_t id;
+    };
+
+    /// <summary>
+    /// Precedes the encoded samples in a
+    /// <see cref="capture_chunk_id::block" /> chunk.
+    /// </summary>
+    struct capture_block_header {
+        typedef power_overwhelming::timestamp::value_type timestamp_type;
+
+        std::uint32_t sensor;
+        std::uint32_t count;
+        capture_compression compression;
+        std::uint32_t size;
+        timestamp_type begin;
+        timestamp_type end;
+    };
+
+    /// <summary>
+    /// Precedes the contents of the <see cref="capture_chunk_id::index" />.
+    /// </summary>
+    struct capture_index_header {
+        std::uint32_t sensors;
+        std::uint32_t markers;
+        std::uint64_t blocks;
+    };
+
+    /// <summary>
+    /// Describes a block in the <see cref="capture_chunk_id::index" />.
+    /// </summary>
+    struct capture_index_entry {
+        typedef power_overwhelming::timestamp::value_type timestamp_type;
+
+        std::uint64_t offset;
+        std::uint32_t sensor;
+        std::uint32_t count;
+        timestamp_type begin;
+        timestamp_type end;
+    };
+
+    /// <summary>
+    /// The end of a capture file that has been closed properly.
+    /// </summary>
+    struct capture_trailer {
+        std::uint64_t index;
+        std::uint8_t magic[8];
+    };
+
+    /// <summary>
+    /// The in-memory representation of a sample that is encoded in a block.
+    /// </summary>
+    struct capture_sample {
+        typedef power_overwhelming::timestamp::value_type timestamp_type;
+        typedef measurement_data::value_type value_type;
+
+        timestamp_type timestamp;
+        value_type voltage;
+        value_type current;
+        value_type power;
+        std::uint32_t marker;
+    };
+
+    static_assert(sizeof(capture_file_header) == 16, "capture_file_header "
+        "must not contain padding.");
+    static_assert(sizeof(capture_chunk_header) == 16, "capture_chunk_header "
+        "must not contain padding.");
+    static_assert(sizeof(capture_block_header) == 32, "capture_block_header "
+        "must not contain padding.");
+    static_assert(sizeof(capture_index_header) == 16, "capture_index_header "
+        "must not contain padding.");
+    static_assert(sizeof(capture_index_entry) == 32, "capture_index_entry "
+        "must not contain padding.");
+    static_assert(sizeof(capture_trailer) == 16, "capture_trailer must not "
+        "contain padding.");
+    static_assert(std::is_trivially_copyable<capture_sample>::value,
+        "capture_sample must be copyable via memcpy.");
+
+    /// <summary>
+    /// The magic number at the begin of a capture file.
+    /// </summary>
+    constexpr std::uint8_t capture_file_magic[8] = {
+        'P', 'W', 'R', 'O', 'W', 'G', 'C', 'P'
+    };
+
+    /// <summary>
+    /// The magic number in the <see cref="capture_trailer" />.
+    /// </summary>
+    constexpr std::uint8_t capture_trailer_magic[8] = {
+        'P', 'W', 'R', 'O', 'W', 'G', 'I', 'X'
+    };
+
+    /// <summary>
+    /// The version of the capture format written by this library.
+    /// </summary>
+    constexpr std::uint32_t capture_version = 2;
+
+    /// <summary>
+    /// The upper limit for the payload of a chunk other than the index, which
+    /// readers use to reject garbage.
+    /// </summary>
+    constexpr std::uint64_t capture_max_chunk_size = 256 * 1024 * 1024;
+
+    /// <summary>
+    /// The maximum number of samples in a block, which makes sure that even
+    /// an incompressible block does not exceed
+    /// <see cref="capture_max_chunk_size" />.
+    /// </summary>
+    constexpr std::size_t capture_max_block_size = 1024 * 1024;
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,226 @@
+﻿// <copyright file="capture_reader.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/capture_reader.h"
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+
+#include "capture_reader_impl.h"
+
+
+/*
+ * visus::power_overwhelming::capture_reader::capture_reader
+ */
+visus::power_overwhelming::capture_reader::capture_reader(
+        _In_z_ const char_type *path)
+    : _impl(new detail::capture_reader_impl(path)) { }
+
+
+/*
+ * visus::power_overwhelming::capture_reader::~capture_reader
+ */
+visus::power_overwhelming::capture_reader::~capture_reader(void) {
+    delete this->_impl;
+}
+
+
+/*
+ * visus::power_overwhelming::capture_reader::aggregate
+ */
+std::size_t visus::power_overwhelming::capture_reader::aggregate(
+        _Out_writes_opt_(cnt) capture_aggregate *dst,
+        _In_ const std::size_t cnt,
+        _In_ const capture_filter& filter) const {
+    this->check_not_disposed();
+
+    if ((dst == nullptr) && (cnt > 0)) {
+        throw std::invalid_argument("The output buffer must not be null if "
+            "its size is not zero.");
+    }
+
+    const auto aggregates = this->_impl->aggregate(filter);
+    std::copy_n(aggregates.begin(), (std::min)(cnt, aggregates.size()), dst);
+    return aggregates.size();
+}
+
+
+/*
+ * visus::power_overwhelming::capture_reader::blocks
+ */
+std::size_t visus::power_overwhelming::capture_reader::blocks(
+        void) const noexcept {
+    return (this->_impl != nullptr) ? this->_impl->index.size() : 0;
+}
+
+
+/*
+ * visus::power_overwhelming::capture_reader::complete
+ */
+bool visus::power_overwhelming::capture_reader::complete(void) const noexcept {
+    return (this->_impl != nullptr) && this->_impl->complete;
+}
+
+
+/*
+ * visus::power_overwhelming::capture_reader::marker
+ */
+const visus::power_overwhelming::capture_reader::char_type *
+visus::power_overwhelming::capture_reader::marker(_In_ const id_type id) const {
+    this->check_not_disposed();
+    return this->_impl->markers.at(id).c_str();
+}
+
+
+/*
+ * visus::power_overwhelming::capture_reader::markers
+ */
+std::size_t visus::power_overwhelming::capture_reader::markers(
+        void) const noexcept {
+    return (this->_impl != nullptr) ? this->_impl->markers.size() : 0;
+}
+
+
+/*
+ * visus::power_overwhelming::capture_reader::read
+ */
+visus::power_overwhelming::measurement_data_series
+visus::power_overwhelming::capture_reader::read(
+        _In_ const id_type sensor) const {
+    return this->read(sensor, capture_filter());
+}
+
+
+/*
+ * visus::power_overwhelming::capture_reader::read
+ */
+visus::power_overwhelming::measurement_data_series
+visus::power_overwhelming::capture_reader::read(
+        _In_ const id_type sensor,
+        _In_ const capture_filter& filter) const {
+    this->check_not_disposed();
+    measurement_data_series retval(this->sensor(sensor));
+
+    if (!filter.matches(sensor)) {
+        return retval;
+    }
+
+    auto blocks = this->_impl->select(filter);
+    blocks.erase(std::remove_if(blocks.begin(), blocks.end(),
+        [this, sensor](const std::size_t b) {
+            return (this->_impl->index[b].sensor != sensor);
+        }), blocks.end());
+
+    // Blocks at the boundaries of the time range are only partially
+    // selected, so we need to collect the samples of each block separately
+    // before we know where to put them in the output.
+    std::vector<std::vector<measurement_data>> selected(blocks.size());
+    this->_impl->decode(blocks, [&selected, &filter](const std::size_t i,
+            const detail::capture_sample *samples, const std::size_t cnt) {
+        auto& dst = selected[i];
+        dst.reserve(cnt);
+
+        for (std::size_t j = 0; j < cnt; ++j) {
+            const auto& s = samples[j];
+            const timestamp t(s.timestamp);
+            if (filter.matches(t)) {
+                dst.emplace_back(t, s.voltage, s.current, s.power);
+            }
+        }
+    });
+
+    std::size_t cnt = 0;
+    for (auto& s : selected) {
+        cnt += s.size();
+    }
+
+    auto dst = measurement_data_series::resize(retval, cnt);
+    for (auto& s : selected) {
+        dst = std::copy(s.begin(), s.end(), dst);
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::capture_reader::read
+ */
+visus::power_overwhelming::measurement_data_series
+visus::power_overwhelming::capture_reader::read(
+        _In_z_ const char_type *sensor) const {
+    this->check_not_disposed();
+
+    if (sensor == nullptr) {
+        throw std::invalid_argument("The name of the sensor must not be "
+            "null.");
+    }
+
+    auto& sensors = this->_impl->sensors;
+    auto it = std::find(sensors.begin(), sensors.end(), sensor);
+    if (it == sensors.end()) {
+        throw std::invalid_argument("The capture does not contain the "
+            "requested sensor.");
+    }
+
+    return this->read(static_cast<id_type>(it - sensors.begin()));
+}
+
+
+/*
+ * visus::power_overwhelming::capture_reader::sensor
+ */
+const visus::power_overwhelming::capture_reader::char_type *
+visus::power_overwhelming::capture_reader::sensor(_In_ const id_type id) const {
+    this->check_not_disposed();
+    return this->_impl->sensors.at(id).c_str();
+}
+
+
+/*
+ * visus::power_overwhelming::capture_reader::sensors
+ */
+std::size_t visus::power_overwhelming::capture_reader::sensors(
+        void) const noexcept {
+    return (this->_impl != nullptr) ? this->_impl->sensors.size() : 0;
+}
+
+
+/*
+ * visus::power_overwhelming::capture_reader::operator =
+ */
+visus::power_overwhelming::capture_reader&
+visus::power_overwhelming::capture_reader::operator =(
+        _In_ capture_reader&& rhs) noexcept {
+    if (this != std::addressof(rhs)) {
+        delete this->_impl;
+        this->_impl = rhs._impl;
+        rhs._impl = nullptr;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::capture_reader::operator bool
+ */
+visus::power_overwhelming::capture_reader::operator bool(void) const noexcept {
+    return (this->_impl != nullptr);
+}
+
+
+/*
+ * visus::power_overwhelming::capture_reader::check_not_disposed
+ */
+void visus::power_overwhelming::capture_reader::check_not_disposed(
+        void) const {
+    if (!*this) {
+        throw std::runtime_error("A capture_reader which has been disposed by "
+            "a move operation cannot be used anymore.");
+    }
+}
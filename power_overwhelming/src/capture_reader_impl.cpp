@@ -0,0 +1,604 @@
+﻿// <copyright file="capture_reader_impl.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "capture_reader_impl.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include "power_overwhelming/convert_string.h"
+
+#include "capture_codec.h"
+
+
+namespace {
+
+    using visus::power_overwhelming::capture_aggregate;
+    using visus::power_overwhelming::capture_filter;
+    using visus::power_overwhelming::measurement_data;
+    using visus::power_overwhelming::timestamp;
+    using visus::power_overwhelming::detail::capture_sample;
+
+    /// <summary>
+    /// The partial aggregates of a single block.
+    /// </summary>
+    struct block_summary {
+        typedef capture_sample::timestamp_type timestamp_type;
+
+        /// <summary>
+        /// The aggregates for each marker in the block, where the mean power
+        /// is still the sum of all samples.
+        /// </summary>
+        std::vector<capture_aggregate> aggregates;
+
+        /// <summary>
+        /// The timestamp of the first selected sample.
+        /// </summary>
+        timestamp_type first;
+
+        /// <summary>
+        /// The timestamp of the last selected sample.
+        /// </summary>
+        timestamp_type last;
+
+        /// <summary>
+        /// The marker of the last selected sample.
+        /// </summary>
+        std::uint32_t last_marker;
+
+        /// <summary>
+        /// The power of the last selected sample.
+        /// </summary>
+        float last_power;
+
+        /// <summary>
+        /// Answer the aggregate for the given marker, adding it if necessary.
+        /// </summary>
+        capture_aggregate& operator [](const std::uint32_t marker) {
+            // There are typically only a few markers in a block, so a linear
+            // search is fastest.
+            auto it = std::find_if(this->aggregates.rbegin(),
+                this->aggregates.rend(),
+                [marker](const capture_aggregate& a) {
+                    return (a.marker == marker);
+                });
+            if (it != this->aggregates.rend()) {
+                return *it;
+            }
+
+            capture_aggregate retval;
+            retval.duration = 0.0;
+            retval.energy = 0.0;
+            retval.marker = marker;
+            retval.max_power = std::numeric_limits<float>::lowest();
+            retval.mean_power = 0.0;
+            retval.samples = 0;
+            this->aggregates.push_back(retval);
+            return this->aggregates.back();
+        }
+    };
+
+    /// <summary>
+    /// Adds the interval from the last sample in <paramref name="summary" />
+    /// to <paramref name="next" /> to the aggregate of its marker.
+    /// </summary>
+    void add_interval(block_summary& summary,
+            const block_summary::timestamp_type next) {
+        const auto dt = next - summary.last;
+        if (dt > 0) {
+            // Samples that are out of order do not contribute any energy.
+            const auto seconds = static_cast<double>(dt)
+                / timestamp::tick_rate;
+            auto& a = summary[summary.last_marker];
+            a.duration += seconds;
+            a.energy += summary.last_power * seconds;
+        }
+    }
+
+    /// <summary>
+    /// Answer whether a block of <paramref name="size" /> bytes of encoded
+    /// data can contain <paramref name="cnt" /> samples.
+    /// </summary>
+    inline bool is_plausible_block(const std::uint64_t cnt,
+            const std::uint64_t size) noexcept {
+        using namespace visus::power_overwhelming::detail;
+        return (cnt <= capture_max_block_size)
+            && (cnt <= size * 8 / capture_min_sample_bits);
+    }
+
+    /// <summary>
+    /// Summarises the samples of a block that are selected by
+    /// <paramref name="filter" />.
+    /// </summary>
+    void summarise(block_summary& dst, const capture_sample *samples,
+            const std::size_t cnt, const capture_filter& filter) {
+        auto any = false;
+
+        for (std::size_t i = 0; i < cnt; ++i) {
+            const auto& s = samples[i];
+            if (!filter.matches(timestamp(s.timestamp))) {
+                continue;
+            }
+            if ((s.power == measurement_data::invalid_value)
+                    || !std::isfinite(s.power)) {
+                continue;
+            }
+
+            if (any) {
+                add_interval(dst, s.timestamp);
+            } else {
+                dst.first = s.timestamp;
+                any = true;
+            }
+
+            auto& a = dst[s.marker];
+            if ((a.samples == 0) || (s.timestamp < a.begin)) {
+                a.begin = timestamp(s.timestamp);
+            }
+            if ((a.samples == 0) || (s.timestamp > a.end)) {
+                a.end = timestamp(s.timestamp);
+            }
+            a.max_power = (std::max)(a.max_power, s.power);
+            a.mean_power += s.power;
+            ++a.samples;
+
+            dst.last = s.timestamp;
+            dst.last_marker = s.marker;
+            dst.last_power = s.power;
+        }
+    }
+
+}
+
+
+/*
+ * ...::capture_reader_impl::capture_reader_impl
+ */
+visus::power_overwhelming::detail::capture_reader_impl::capture_reader_impl(
+        _In_z_ const wchar_t *path) : complete(false), file(path) {
+    this->parse();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::capture_reader_impl::aggregate
+ */
+std::vector<visus::power_overwhelming::capture_aggregate>
+visus::power_overwhelming::detail::capture_reader_impl::aggregate(
+        _In_ const capture_filter& filter) const {
+    const auto blocks = this->select(filter);
+    std::vector<block_summary> summaries(blocks.size());
+
+    this->decode(blocks, [&summaries, &filter](const std::size_t i,
+            const capture_sample *samples, const std::size_t cnt) {
+        summarise(summaries[i], samples, cnt, filter);
+    });
+
+    // The blocks of each sensor are in chronological order, so we only need
+    // to add the intervals between consecutive blocks of the same sensor
+    // before merging the partial results.
+    std::map<std::pair<id_type, id_type>, capture_aggregate> aggregates;
+    std::vector<block_summary *> previous(this->sensors.size(), nullptr);
+
+    for (std::size_t i = 0; i < blocks.size(); ++i) {
+        auto& summary = summaries[i];
+        if (summary.aggregates.empty()) {
+            continue;
+        }
+
+        const auto sensor = this->index[blocks[i]].sensor;
+        if (previous[sensor] != nullptr) {
+            add_interval(*previous[sensor], summary.first);
+        }
+        previous[sensor] = &summary;
+    }
+
+    for (std::size_t i = 0; i < blocks.size(); ++i) {
+        const auto sensor = this->index[blocks[i]].sensor;
+
+        for (auto& a : summaries[i].aggregates) {
+            const auto key = std::make_pair(sensor, a.marker);
+            auto it = aggregates.find(key);
+
+            if (it == aggregates.end()) {
+                aggregates.emplace(key, a).first->second.sensor = sensor;
+            } else {
+                auto& dst = it->second;
+                dst.begin = timestamp((std::min)(dst.begin.value(),
+                    a.begin.value()));
+                dst.duration += a.duration;
+                dst.end = timestamp((std::max)(dst.end.value(),
+                    a.end.value()));
+                dst.energy += a.energy;
+                dst.max_power = (std::max)(dst.max_power, a.max_power);
+                dst.mean_power += a.mean_power;
+                dst.samples += a.samples;
+            }
+        }
+    }
+
+    std::vector<capture_aggregate> retval;
+    retval.reserve(aggregates.size());
+    for (auto& a : aggregates) {
+        retval.push_back(a.second);
+        retval.back().mean_power /= static_cast<double>(a.second.samples);
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::capture_reader_impl::decode
+ */
+void visus::power_overwhelming::detail::capture_reader_impl::decode(
+        _Out_writes_(block.count) capture_sample *dst,
+        _In_ const capture_index_entry& block,
+        _Inout_ std::vector<std::uint8_t>& scratch) const {
+    // parse() has made sure that the chunk header is within the file, but
+    // if the blocks have been taken from the index, we did not look at them.
+    assert(block.offset + sizeof(capture_chunk_header) <= this->file.size());
+    auto src = this->file.data() + block.offset;
+
+    capture_chunk_header chunk;
+    ::memcpy(&chunk, src, sizeof(chunk));
+    src += sizeof(chunk);
+
+    if ((chunk.id != capture_chunk_id::block)
+            || (chunk.size < sizeof(capture_block_header))
+            || (chunk.size > this->file.size() - block.offset
+            - sizeof(chunk))) {
+        throw std::runtime_error("A block in the capture is corrupt.");
+    }
+
+    capture_block_header header;
+    ::memcpy(&header, src, sizeof(header));
+    src += sizeof(header);
+
+    if ((header.count != block.count) || (header.sensor != block.sensor)) {
+        throw std::runtime_error("A block in the capture does not match its "
+            "entry in the index.");
+    }
+
+    const auto size = static_cast<std::size_t>(chunk.size - sizeof(header));
+    if (!is_plausible_block(header.count, header.size)) {
+        throw std::runtime_error("A block in the capture claims to contain "
+            "more samples than its size allows for.");
+    }
+
+    if (header.compression == capture_compression::none) {
+        // Avoid the copy if the block is not compressed.
+        if (header.size != size) {
+            throw std::runtime_error("The size of an uncompressed block does "
+                "not match its header.");
+        }
+        decode_capture_block(dst, header.count, src, size);
+
+    } else {
+        decompress_capture_block(scratch, header.size, src, size,
+            header.compression);
+        decode_capture_block(dst, header.count, scratch.data(),
+            scratch.size());
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::capture_reader_impl::decode
+ */
+void visus::power_overwhelming::detail::capture_reader_impl::decode(
+        _In_ const std::vector<std::size_t>& blocks,
+        _In_ const consumer_type& consumer) const {
+    if (blocks.empty()) {
+        return;
+    }
+
+    const auto threads = (std::min)(blocks.size(), static_cast<std::size_t>(
+        (std::max)(1u, std::thread::hardware_concurrency())));
+    std::vector<std::exception_ptr> errors(threads);
+    std::atomic<std::size_t> next(0);
+
+    // Blocks are handed out one by one rather than in ranges, because their
+    // cost depends on their compression and on the filter of the consumer.
+    const auto work = [&](const std::size_t thread) {
+        std::vector<capture_sample> samples;
+        std::vector<std::uint8_t> scratch;
+
+        try {
+            for (auto i = next++; i < blocks.size(); i = next++) {
+                const auto& block = this->index[blocks[i]];
+                // parse() has rejected blocks exceeding the maximum size, so
+                // we cannot be tricked into allocating arbitrary amounts of
+                // memory here.
+                assert(block.count <= capture_max_block_size);
+                samples.resize(block.count);
+                this->decode(samples.data(), block, scratch);
+                consumer(i, samples.data(), samples.size());
+            }
+        } catch (...) {
+            errors[thread] = std::current_exception();
+            next = blocks.size();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for (std::size_t t = 1; t < threads; ++t) {
+        workers.emplace_back(work, t);
+    }
+
+    work(0);
+
+    for (auto& w : workers) {
+        w.join();
+    }
+
+    for (auto& e : errors) {
+        if (e != nullptr) {
+            std::rethrow_exception(e);
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::capture_reader_impl::parse
+ */
+void visus::power_overwhelming::detail::capture_reader_impl::parse(void) {
+    capture_file_header header;
+    if (this->file.size() < sizeof(header)) {
+        throw std::runtime_error("The file is too small to be a capture.");
+    }
+
+    ::memcpy(&header, this->file.data(), sizeof(header));
+    if (::memcmp(header.magic, capture_file_magic, sizeof(header.magic))
+            != 0) {
+        throw std::runtime_error("The file is not a capture.");
+    }
+    if (header.version != capture_version) {
+        throw std::runtime_error("The capture has been written by an "
+            "incompatible version of the library.");
+    }
+
+    // Only captures that have not been closed need to be walked chunk by
+    // chunk to recover the blocks they contain.
+    if (!this->parse_index()) {
+        this->parse_chunks(sizeof(header));
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::capture_reader_impl::parse_chunks
+ */
+void visus::power_overwhelming::detail::capture_reader_impl::parse_chunks(
+        _In_ std::size_t offset) {
+    const auto data = this->file.data();
+    const auto size = this->file.size();
+
+    // We stop at the first chunk that is not completely in the file. As the
+    // file is mapped, this only touches the pages containing the chunk
+    // headers.
+    while (offset + sizeof(capture_chunk_header) <= size) {
+        const auto begin = offset;
+        capture_chunk_header chunk;
+        ::memcpy(&chunk, data + offset, sizeof(chunk));
+        offset += sizeof(chunk);
+
+        if ((chunk.size > size - offset)
+                || ((chunk.id != capture_chunk_id::index)
+                && (chunk.size > capture_max_chunk_size))) {
+            break;
+        }
+
+        const auto payload = data + offset;
+        const auto payload_size = static_cast<std::size_t>(chunk.size);
+        offset += payload_size;
+
+        switch (chunk.id) {
+            case capture_chunk_id::marker:
+            case capture_chunk_id::sensor:
+                this->parse_name(chunk.id, payload, payload_size);
+                break;
+
+            case capture_chunk_id::block: {
+                capture_block_header header;
+                if (payload_size < sizeof(header)) {
+                    throw std::runtime_error("A block header in the capture "
+                        "is corrupt.");
+                }
+
+                ::memcpy(&header, payload, sizeof(header));
+                if (header.sensor >= this->sensors.size()) {
+                    throw std::runtime_error("A block in the capture refers "
+                        "to a sensor which has not been declared.");
+                }
+                if (!is_plausible_block(header.count, header.size)) {
+                    throw std::runtime_error("A block in the capture claims "
+                        "to contain more samples than its size allows for.");
+                }
+
+                this->index.push_back(capture_index_entry {
+                    begin,
+                    header.sensor,
+                    header.count,
+                    header.begin,
+                    header.end
+                });
+                } break;
+
+            case capture_chunk_id::index:
+                // We only get here if the trailer is missing, so the index
+                // is all that has been written and we already have every
+                // block before it.
+                return;
+
+            default:
+                // Skip chunks we do not know, which might have been added by
+                // a later version.
+                break;
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::capture_reader_impl::parse_index
+ */
+bool visus::power_overwhelming::detail::capture_reader_impl::parse_index(
+        void) {
+    const auto data = this->file.data();
+    const auto size = this->file.size();
+    const auto corrupt = [](void) {
+        throw std::runtime_error("The index of the capture is corrupt.");
+    };
+
+    capture_trailer trailer;
+    if (size < sizeof(capture_file_header) + sizeof(capture_chunk_header)
+            + sizeof(capture_index_header) + sizeof(trailer)) {
+        return false;
+    }
+
+    ::memcpy(&trailer, data + size - sizeof(trailer), sizeof(trailer));
+    if (::memcmp(trailer.magic, capture_trailer_magic, sizeof(trailer.magic))
+            != 0) {
+        return false;
+    }
+
+    // From here on, the writer claims to have closed the file, so anything
+    // that does not fit is an error rather than a reason to walk the file.
+    const auto end = size - sizeof(trailer);
+    if ((trailer.index < sizeof(capture_file_header))
+            || (trailer.index > end - sizeof(capture_chunk_header)
+            - sizeof(capture_index_header))) {
+        corrupt();
+    }
+
+    capture_chunk_header chunk;
+    ::memcpy(&chunk, data + trailer.index, sizeof(chunk));
+    const auto begin = static_cast<std::size_t>(trailer.index) + sizeof(chunk);
+    if ((chunk.id != capture_chunk_id::index) || (chunk.size != end - begin)) {
+        corrupt();
+    }
+
+    capture_index_header header;
+    ::memcpy(&header, data + begin, sizeof(header));
+    const auto names = static_cast<std::size_t>(header.sensors)
+        + header.markers;
+    auto available = static_cast<std::size_t>(chunk.size) - sizeof(header);
+    if (names > available / sizeof(std::uint64_t)) {
+        corrupt();
+    }
+
+    available -= names * sizeof(std::uint64_t);
+    if ((available % sizeof(capture_index_entry) != 0)
+            || (header.blocks != available / sizeof(capture_index_entry))) {
+        corrupt();
+    }
+
+    // Each block occupies at least its headers before the index.
+    if (header.blocks > (trailer.index - sizeof(capture_file_header))
+            / (sizeof(capture_chunk_header) + sizeof(capture_block_header))) {
+        corrupt();
+    }
+
+    // The names are the only thing outside the index we need to look at.
+    auto src = data + begin + sizeof(header);
+    this->sensors.reserve(header.sensors);
+    this->markers.reserve(header.markers);
+    for (std::size_t i = 0; i < names; ++i, src += sizeof(std::uint64_t)) {
+        std::uint64_t offset;
+        ::memcpy(&offset, src, sizeof(offset));
+        if ((offset < sizeof(capture_file_header))
+                || (offset > trailer.index - sizeof(capture_chunk_header))) {
+            corrupt();
+        }
+
+        capture_chunk_header name;
+        ::memcpy(&name, data + offset, sizeof(name));
+        offset += sizeof(name);
+        const auto expected = (i < header.sensors)
+            ? capture_chunk_id::sensor
+            : capture_chunk_id::marker;
+        if ((name.id != expected) || (name.size > trailer.index - offset)) {
+            corrupt();
+        }
+
+        this->parse_name(name.id, data + offset,
+            static_cast<std::size_t>(name.size));
+    }
+
+    this->index.resize(static_cast<std::size_t>(header.blocks));
+    ::memcpy(this->index.data(), src,
+        this->index.size() * sizeof(capture_index_entry));
+    for (auto& b : this->index) {
+        if ((b.sensor >= this->sensors.size())
+                || (b.count > capture_max_block_size)
+                || (b.offset < sizeof(capture_file_header))
+                || (b.offset > trailer.index - sizeof(capture_chunk_header))) {
+            corrupt();
+        }
+    }
+
+    this->complete = true;
+    return true;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::capture_reader_impl::parse_name
+ */
+void visus::power_overwhelming::detail::capture_reader_impl::parse_name(
+        _In_ const capture_chunk_id id,
+        _In_reads_bytes_(size) const std::uint8_t *payload,
+        _In_ const std::size_t size) {
+    capture_name name;
+    if (size < sizeof(name)) {
+        throw std::runtime_error("A name in the capture is corrupt.");
+    }
+
+    ::memcpy(&name, payload, sizeof(name));
+    auto& names = (id == capture_chunk_id::marker)
+        ? this->markers
+        : this->sensors;
+    if (name.id != names.size()) {
+        throw std::runtime_error("The names in the capture are not in "
+            "order.");
+    }
+
+    const std::string utf8(reinterpret_cast<const char *>(payload
+        + sizeof(name)), size - sizeof(name));
+    names.push_back(power_overwhelming::convert_string<wchar_t>(utf8));
+}
+
+
+/*
+ * visus::power_overwhelming::detail::capture_reader_impl::select
+ */
+std::vector<std::size_t>
+visus::power_overwhelming::detail::capture_reader_impl::select(
+        _In_ const capture_filter& filter) const {
+    std::vector<std::size_t> retval;
+
+    for (std::size_t i = 0; i < this->index.size(); ++i) {
+        const auto& b = this->index[i];
+        if (filter.matches(b.sensor) && filter.overlaps(timestamp(b.begin),
+                timestamp(b.end))) {
+            retval.push_back(i);
+        }
+    }
+
+    return retval;
+}
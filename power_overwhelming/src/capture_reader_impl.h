@@ -0,0 +1,159 @@
+﻿// <copyright file="capture_reader_impl.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "power_overwhelming/capture_aggregate.h"
+#include "power_overwhelming/capture_filter.h"
+#include "power_overwhelming/capture_reader.h"
+
+#include "capture_format.h"
+#include "memory_mapped_file.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Private data container for <see cref="capture_reader" />.
+    /// </summary>
+    struct POWER_OVERWHELMING_API capture_reader_impl final {
+
+        /// <summary>
+        /// The type used to identify sensors and markers.
+        /// </summary>
+        typedef capture_reader::id_type id_type;
+
+        /// <summary>
+        /// The type of a callback receiving the decoded samples of the
+        /// <paramref name="i" />-th selected block.
+        /// </summary>
+        typedef std::function<void(const std::size_t i,
+            const capture_sample *samples, const std::size_t cnt)>
+            consumer_type;
+
+        /// <summary>
+        /// Indicates whether the index at the end of the file was found.
+        /// </summary>
+        bool complete;
+
+        /// <summary>
+        /// The capture file mapped into memory.
+        /// </summary>
+        memory_mapped_file file;
+
+        /// <summary>
+        /// The blocks in the order they have been written.
+        /// </summary>
+        std::vector<capture_index_entry> index;
+
+        /// <summary>
+        /// The names of the markers, indexed by their ID.
+        /// </summary>
+        std::vector<std::wstring> markers;
+
+        /// <summary>
+        /// The names of the sensors, indexed by their ID.
+        /// </summary>
+        std::vector<std::wstring> sensors;
+
+        /// <summary>
+        /// Maps and parses the given capture file.
+        /// </summary>
+        /// <param name="path"></param>
+        explicit capture_reader_impl(_In_z_ const wchar_t *path);
+
+        /// <summary>
+        /// Computes the aggregates of all samples selected by
+        /// <paramref name="filter" />, ordered by sensor and marker.
+        /// </summary>
+        /// <param name="filter"></param>
+        /// <returns></returns>
+        std::vector<capture_aggregate> aggregate(
+            _In_ const capture_filter& filter) const;
+
+        /// <summary>
+        /// Decodes the given block into <paramref name="dst" />.
+        /// </summary>
+        /// <param name="dst">Receives <c>block.count</c> samples.</param>
+        /// <param name="block">The index entry of the block.</param>
+        /// <param name="scratch">A buffer for decompressing the block, which
+        /// allows for reusing the allocation for multiple blocks.</param>
+        void decode(_Out_writes_(block.count) capture_sample *dst,
+            _In_ const capture_index_entry& block,
+            _Inout_ std::vector<std::uint8_t>& scratch) const;
+
+        /// <summary>
+        /// Decodes the given blocks on all cores and passes their samples to
+        /// <paramref name="consumer" />.
+        /// </summary>
+        /// <remarks>
+        /// The consumer is called concurrently from multiple threads, but
+        /// only once for each block. The samples passed to it are only valid
+        /// during the call.
+        /// </remarks>
+        /// <param name="blocks">The indices of the blocks in
+        /// <see cref="index" />.</param>
+        /// <param name="consumer">The callback receiving the position of
+        /// the block in <paramref name="blocks" /> and its samples.</param>
+        void decode(_In_ const std::vector<std::size_t>& blocks,
+            _In_ const consumer_type& consumer) const;
+
+        /// <summary>
+        /// Checks the header of <see cref="file" /> and retrieves the
+        /// sensors, markers and blocks in it.
+        /// </summary>
+        void parse(void);
+
+        /// <summary>
+        /// Walks the chunks in <see cref="file" /> starting at
+        /// <paramref name="offset" /> to recover the sensors, markers and
+        /// blocks of a capture that has not been closed.
+        /// </summary>
+        /// <param name="offset">The offset of the first chunk.</param>
+        void parse_chunks(_In_ std::size_t offset);
+
+        /// <summary>
+        /// Retrieves the sensors, markers and blocks from the index the
+        /// trailer of <see cref="file" /> points to.
+        /// </summary>
+        /// <returns><c>true</c> if the index has been read, <c>false</c> if
+        /// the file has no trailer.</returns>
+        /// <exception cref="std::runtime_error">If the trailer is valid, but
+        /// the index is corrupt.</exception>
+        bool parse_index(void);
+
+        /// <summary>
+        /// Adds the name in the payload of a sensor or marker chunk to
+        /// <see cref="sensors" /> or <see cref="markers" />, respectively.
+        /// </summary>
+        /// <param name="id">The type of the chunk.</param>
+        /// <param name="payload">The payload of the chunk.</param>
+        /// <param name="size">The size of the payload in bytes.</param>
+        void parse_name(_In_ const capture_chunk_id id,
+            _In_reads_bytes_(size) const std::uint8_t *payload,
+            _In_ const std::size_t size);
+
+        /// <summary>
+        /// Answer the indices of the blocks in <see cref="index" /> that
+        /// might contain samples selected by <paramref name="filter" />.
+        /// </summary>
+        /// <param name="filter"></param>
+        /// <returns></returns>
+        std::vector<std::size_t> select(
+            _In_ const capture_filter& filter) const;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,175 @@
+﻿// <copyright file="capture_writer.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/capture_writer.h"
+
+#include <memory>
+#include <stdexcept>
+
+#include "power_overwhelming/collector.h"
+
+#include "capture_writer_impl.h"
+
+
+static_assert(visus::power_overwhelming::capture_writer::no_marker
+    == visus::power_overwhelming::collector::no_marker,
+    "A capture must be able to store the markers of a collector.");
+
+
+/*
+ * ...::capture_writer::default_block_size
+ */
+constexpr std::size_t
+visus::power_overwhelming::capture_writer::default_block_size;
+
+
+/*
+ * visus::power_overwhelming::capture_writer::no_marker
+ */
+constexpr visus::power_overwhelming::capture_writer::id_type
+visus::power_overwhelming::capture_writer::no_marker;
+
+
+/*
+ * visus::power_overwhelming::capture_writer::capture_writer
+ */
+visus::power_overwhelming::capture_writer::capture_writer(
+        _In_z_ const char_type *path,
+        _In_ const capture_compression compression,
+        _In_ const std::size_t block_size)
+    : _impl(new detail::capture_writer_impl(path, compression, block_size)) { }
+
+
+/*
+ * visus::power_overwhelming::capture_writer::~capture_writer
+ */
+visus::power_overwhelming::capture_writer::~capture_writer(void) {
+    delete this->_impl;
+}
+
+
+/*
+ * visus::power_overwhelming::capture_writer::close
+ */
+void visus::power_overwhelming::capture_writer::close(void) {
+    if (this->_impl != nullptr) {
+        this->_impl->close();
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::capture_writer::flush
+ */
+void visus::power_overwhelming::capture_writer::flush(void) {
+    this->check_not_disposed();
+    this->_impl->flush();
+}
+
+
+/*
+ * visus::power_overwhelming::capture_writer::marker
+ */
+visus::power_overwhelming::capture_writer::id_type
+visus::power_overwhelming::capture_writer::marker(
+        _In_z_ const char_type *name) {
+    this->check_not_disposed();
+    return this->_impl->declare(this->_impl->markers,
+        detail::capture_chunk_id::marker,
+        name);
+}
+
+
+/*
+ * visus::power_overwhelming::capture_writer::sensor
+ */
+visus::power_overwhelming::capture_writer::id_type
+visus::power_overwhelming::capture_writer::sensor(
+        _In_z_ const char_type *name) {
+    this->check_not_disposed();
+    return this->_impl->declare(this->_impl->sensors,
+        detail::capture_chunk_id::sensor,
+        name);
+}
+
+
+/*
+ * visus::power_overwhelming::capture_writer::write
+ */
+void visus::power_overwhelming::capture_writer::write(
+        _In_ const id_type sensor,
+        _In_ const measurement_data& sample,
+        _In_ const id_type marker) {
+    this->check_not_disposed();
+    this->_impl->write(sensor, sample, marker);
+}
+
+
+/*
+ * visus::power_overwhelming::capture_writer::write
+ */
+void visus::power_overwhelming::capture_writer::write(
+        _In_ const measurement& sample,
+        _In_ const id_type marker) {
+    this->check_not_disposed();
+    const auto sensor = (sample.sensor() != nullptr) ? sample.sensor() : L"";
+    this->_impl->write(this->sensor(sensor), sample.data(), marker);
+}
+
+
+/*
+ * visus::power_overwhelming::capture_writer::write
+ */
+void visus::power_overwhelming::capture_writer::write(
+        _In_ const measurement_data_series& series) {
+    this->check_not_disposed();
+
+    if (series.sensor() == nullptr) {
+        throw std::invalid_argument("A series must have a sensor to be "
+            "written to a capture.");
+    }
+
+    const auto sensor = this->sensor(series.sensor());
+    for (auto& s : series) {
+        this->_impl->write(sensor, s, no_marker);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::capture_writer::operator =
+ */
+visus::power_overwhelming::capture_writer&
+visus::power_overwhelming::capture_writer::operator =(
+        _In_ capture_writer&& rhs) noexcept {
+    if (this != std::addressof(rhs)) {
+        delete this->_impl;
+        this->_impl = rhs._impl;
+        rhs._impl = nullptr;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::capture_writer::operator bool
+ */
+visus::power_overwhelming::capture_writer::operator bool(void) const noexcept {
+    return (this->_impl != nullptr);
+}
+
+
+/*
+ * visus::power_overwhelming::capture_writer::check_not_disposed
+ */
+void visus::power_overwhelming::capture_writer::check_not_disposed(
+        void) const {
+    if (!*this) {
+        throw std::runtime_error("A capture_writer which has been disposed by "
+            "a move operation cannot be used anymore.");
+    }
+}
@@ -0,0 +1,296 @@
+﻿// <copyright file="capture_writer_impl.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "capture_writer_impl.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+#include "power_overwhelming/convert_string.h"
+
+#include "capture_codec.h"
+
+
+/*
+ * ...::capture_writer_impl::capture_writer_impl
+ */
+visus::power_overwhelming::detail::capture_writer_impl::capture_writer_impl(
+        _In_z_ const wchar_t *path,
+        _In_ const capture_compression compression,
+        _In_ const std::size_t block_size,
+        _In_ const std::size_t output_block_size,
+        _In_ const output_sync_policy policy,
+        _In_ const bool direct_io)
+        : block_size(block_size), compression(compression), offset(0) {
+    if (path == nullptr) {
+        throw std::invalid_argument("The path to the capture file must not be "
+            "null.");
+    }
+    if ((block_size < 1) || (block_size > capture_max_block_size)) {
+        throw std::invalid_argument("The number of samples in a block of a "
+            "capture is out of range.");
+    }
+
+    {
+        // Make sure that we fail before creating the file if the requested
+        // compression is not available.
+        const std::uint8_t probe = 0;
+        compress_capture_block(this->compressed, &probe, sizeof(probe),
+            compression);
+    }
+
+    this->output.reset(new block_writer(path, output_block_size, 2, policy,
+        direct_io));
+
+    capture_file_header header;
+    ::memcpy(header.magic, capture_file_magic, sizeof(header.magic));
+    header.version = capture_version;
+    header.reserved = 0;
+    this->write_raw(&header, sizeof(header));
+}
+
+
+/*
+ * ...::capture_writer_impl::~capture_writer_impl
+ */
+visus::power_overwhelming::detail::capture_writer_impl::~capture_writer_impl(
+        void) {
+    try {
+        this->close();
+    } catch (...) {
+        // There is no one to report this to.
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::capture_writer_impl::close
+ */
+void visus::power_overwhelming::detail::capture_writer_impl::close(void) {
+    if (!this->output) {
+        return;
+    }
+
+    this->flush();
+
+    capture_trailer trailer;
+    trailer.index = this->offset;
+    ::memcpy(trailer.magic, capture_trailer_magic, sizeof(trailer.magic));
+
+    // The index starts with the locations of the names, which we need to put
+    // in a single buffer as write_chunk only supports one header.
+    std::vector<std::uint64_t> header((sizeof(capture_index_header)
+        / sizeof(std::uint64_t)) + this->sensor_chunks.size()
+        + this->marker_chunks.size());
+    {
+        capture_index_header h;
+        h.sensors = static_cast<std::uint32_t>(this->sensor_chunks.size());
+        h.markers = static_cast<std::uint32_t>(this->marker_chunks.size());
+        h.blocks = this->index.size();
+        ::memcpy(header.data(), &h, sizeof(h));
+
+        auto dst = header.begin() + sizeof(h) / sizeof(std::uint64_t);
+        dst = std::copy(this->sensor_chunks.begin(), this->sensor_chunks.end(),
+            dst);
+        std::copy(this->marker_chunks.begin(), this->marker_chunks.end(),
+            dst);
+    }
+
+    this->write_chunk(capture_chunk_id::index,
+        header.data(),
+        header.size() * sizeof(std::uint64_t),
+        this->index.data(),
+        this->index.size() * sizeof(capture_index_entry));
+    this->write_raw(&trailer, sizeof(trailer));
+
+    // Make sure that the file is gone even if closing it fails, because
+    // there is no way to recover from that anyway.
+    auto output = std::move(this->output);
+    output->close();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::capture_writer_impl::declare
+ */
+visus::power_overwhelming::detail::capture_writer_impl::id_type
+visus::power_overwhelming::detail::capture_writer_impl::declare(
+        _Inout_ name_map_type& names,
+        _In_ const capture_chunk_id id,
+        _In_z_ const wchar_t *name) {
+    if (name == nullptr) {
+        throw std::invalid_argument("The name of a sensor or marker must not "
+            "be null.");
+    }
+
+    {
+        auto it = names.find(name);
+        if (it != names.end()) {
+            return it->second;
+        }
+    }
+
+    if (names.size() >= capture_writer::no_marker) {
+        throw std::runtime_error("The maximum number of sensors or markers "
+            "has been declared.");
+    }
+
+    const auto utf8 = power_overwhelming::convert_string<char>(name);
+    capture_name header;
+    header.id = static_cast<id_type>(names.size());
+    ((id == capture_chunk_id::marker)
+        ? this->marker_chunks
+        : this->sensor_chunks).push_back(this->offset);
+    this->write_chunk(id, &header, sizeof(header), utf8.data(), utf8.size());
+
+    names.emplace(name, header.id);
+    return header.id;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::capture_writer_impl::flush
+ */
+void visus::power_overwhelming::detail::capture_writer_impl::flush(void) {
+    for (std::size_t i = 0; i < this->pending.size(); ++i) {
+        this->flush(static_cast<id_type>(i));
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::capture_writer_impl::flush
+ */
+void visus::power_overwhelming::detail::capture_writer_impl::flush(
+        _In_ const id_type sensor) {
+    assert(sensor < this->pending.size());
+    auto& samples = this->pending[sensor];
+    if (samples.empty()) {
+        return;
+    }
+
+    this->encoded.clear();
+    encode_capture_block(this->encoded, samples.data(), samples.size());
+    compress_capture_block(this->compressed, this->encoded.data(),
+        this->encoded.size(), this->compression);
+
+    // The range of timestamps is what readers use to skip blocks, so it must
+    // be conservative even if the sensor delivered out of order.
+    const auto range = std::minmax_element(samples.begin(), samples.end(),
+        [](const capture_sample& l, const capture_sample& r) {
+            return (l.timestamp < r.timestamp);
+        });
+
+    capture_block_header header;
+    header.sensor = sensor;
+    header.count = static_cast<std::uint32_t>(samples.size());
+    header.compression = this->compression;
+    header.size = static_cast<std::uint32_t>(this->encoded.size());
+    header.begin = range.first->timestamp;
+    header.end = range.second->timestamp;
+
+    capture_index_entry entry;
+    entry.offset = this->offset;
+    entry.sensor = header.sensor;
+    entry.count = header.count;
+    entry.begin = header.begin;
+    entry.end = header.end;
+
+    this->write_chunk(capture_chunk_id::block, &header, sizeof(header),
+        this->compressed.data(), this->compressed.size());
+    this->index.push_back(entry);
+    samples.clear();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::capture_writer_impl::write
+ */
+void visus::power_overwhelming::detail::capture_writer_impl::write(
+        _In_ const id_type sensor,
+        _In_ const measurement_data& sample,
+        _In_ const id_type marker) {
+    if (sensor >= this->sensors.size()) {
+        throw std::invalid_argument("The sensor has not been declared in the "
+            "capture.");
+    }
+
+    if (this->pending.size() <= sensor) {
+        this->pending.resize(sensor + 1);
+    }
+
+    auto& samples = this->pending[sensor];
+    if (samples.capacity() < this->block_size) {
+        samples.reserve(this->block_size);
+    }
+
+    // Store the power that is effectively reported rather than how it was
+    // measured, but make sure that invalid samples remain invalid.
+    samples.push_back(capture_sample {
+        sample.timestamp().value(),
+        sample.voltage(),
+        sample.current(),
+        sample ? sample.power() : measurement_data::invalid_value,
+        marker
+    });
+
+    if (samples.size() >= this->block_size) {
+        this->flush(sensor);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::capture_writer_impl::write_chunk
+ */
+void visus::power_overwhelming::detail::capture_writer_impl::write_chunk(
+        _In_ const capture_chunk_id id,
+        _In_reads_bytes_(header_size) const void *header,
+        _In_ const std::size_t header_size,
+        _In_reads_bytes_(payload_size) const void *payload,
+        _In_ const std::size_t payload_size) {
+    capture_chunk_header chunk;
+    chunk.id = id;
+    chunk.reserved = 0;
+    chunk.size = header_size + payload_size;
+
+    this->write_raw(&chunk, sizeof(chunk));
+    this->write_raw(header, header_size);
+    this->write_raw(payload, payload_size);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::capture_writer_impl::write_raw
+ */
+void visus::power_overwhelming::detail::capture_writer_impl::write_raw(
+        _In_reads_bytes_(cnt) const void *data,
+        _In_ const std::size_t cnt) {
+    if (cnt < 1) {
+        return;
+    }
+
+    if (!this->output) {
+        throw std::runtime_error("The capture file has already been closed.");
+    }
+
+    const auto written = this->output->sputn(
+        static_cast<const char *>(data),
+        static_cast<std::streamsize>(cnt));
+    this->offset += written;
+
+    if (written != static_cast<std::streamsize>(cnt)) {
+        // The I/O thread has failed, which will be reported by closing the
+        // file. The capture is unusable after that in any case.
+        auto output = std::move(this->output);
+        output->close();
+        throw std::runtime_error("The capture file could not be written "
+            "completely.");
+    }
+}
+
@@ -0,0 +1,208 @@
+﻿// <copyright file="capture_writer_impl.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "power_overwhelming/capture_writer.h"
+#include "power_overwhelming/collector_settings.h"
+#include "power_overwhelming/output_sync_policy.h"
+
+#include "block_writer.h"
+#include "capture_format.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Private data container for <see cref="capture_writer" />.
+    /// </summary>
+    /// <remarks>
+    /// This class is also used directly by the collector if it is configured
+    /// to write captures, which is why it exposes the settings of the
+    /// underlying <see cref="block_writer" />.
+    /// </remarks>
+    struct POWER_OVERWHELMING_API capture_writer_impl final {
+
+        /// <summary>
+        /// The type used to identify sensors and markers.
+        /// </summary>
+        typedef capture_writer::id_type id_type;
+
+        /// <summary>
+        /// The type of the maps from names to IDs.
+        /// </summary>
+        typedef std::map<std::wstring, id_type, std::less<>> name_map_type;
+
+        /// <summary>
+        /// The maximum number of samples in a block.
+        /// </summary>
+        std::size_t block_size;
+
+        /// <summary>
+        /// The general-purpose compressor applied to the blocks.
+        /// </summary>
+        capture_compression compression;
+
+        /// <summary>
+        /// A scratch buffer for compressing blocks.
+        /// </summary>
+        std::vector<std::uint8_t> compressed;
+
+        /// <summary>
+        /// A scratch buffer for encoding blocks.
+        /// </summary>
+        std::vector<std::uint8_t> encoded;
+
+        /// <summary>
+        /// The index entries of all blocks written so far.
+        /// </summary>
+        std::vector<capture_index_entry> index;
+
+        /// <summary>
+        /// The offsets of the chunks declaring the markers, indexed by the ID
+        /// of the marker.
+        /// </summary>
+        std::vector<std::uint64_t> marker_chunks;
+
+        /// <summary>
+        /// The IDs of the markers that have been declared.
+        /// </summary>
+        name_map_type markers;
+
+        /// <summary>
+        /// The position in the file at which the next byte is written.
+        /// </summary>
+        std::uint64_t offset;
+
+        /// <summary>
+        /// The stream buffer writing the file, which is <c>nullptr</c> once
+        /// the file has been closed.
+        /// </summary>
+        std::unique_ptr<block_writer> output;
+
+        /// <summary>
+        /// The samples of each sensor that have not yet been written, indexed
+        /// by the ID of the sensor.
+        /// </summary>
+        std::vector<std::vector<capture_sample>> pending;
+
+        /// <summary>
+        /// The offsets of the chunks declaring the sensors, indexed by the ID
+        /// of the sensor.
+        /// </summary>
+        std::vector<std::uint64_t> sensor_chunks;
+
+        /// <summary>
+        /// The IDs of the sensors that have been declared.
+        /// </summary>
+        name_map_type sensors;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <param name="path">The path to the output file.</param>
+        /// <param name="compression">The general-purpose compressor applied
+        /// to the blocks.</param>
+        /// <param name="block_size">The maximum number of samples in a
+        /// block.</param>
+        /// <param name="output_block_size">The size of the blocks written to
+        /// disk.</param>
+        /// <param name="policy">Determines when data are synchronised to disk.
+        /// </param>
+        /// <param name="direct_io">Requests bypassing the page cache.</param>
+        capture_writer_impl(_In_z_ const wchar_t *path,
+            _In_ const capture_compression compression,
+            _In_ const std::size_t block_size,
+            _In_ const std::size_t output_block_size
+            = collector_settings::default_output_block_size,
+            _In_ const output_sync_policy policy = output_sync_policy::none,
+            _In_ const bool direct_io = false);
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        /// <remarks>
+        /// The destructor closes the file if this was not done before, but
+        /// ignores any error doing so.
+        /// </remarks>
+        ~capture_writer_impl(void);
+
+        /// <summary>
+        /// Writes all pending blocks, the index and the trailer, and closes
+        /// the file.
+        /// </summary>
+        void close(void);
+
+        /// <summary>
+        /// Declares <paramref name="name" /> in <paramref name="names" /> if
+        /// necessary and answers its ID.
+        /// </summary>
+        /// <param name="names"></param>
+        /// <param name="id"></param>
+        /// <param name="name"></param>
+        /// <returns></returns>
+        id_type declare(_Inout_ name_map_type& names,
+            _In_ const capture_chunk_id id,
+            _In_z_ const wchar_t *name);
+
+        /// <summary>
+        /// Writes the pending samples of all sensors.
+        /// </summary>
+        void flush(void);
+
+        /// <summary>
+        /// Writes the pending samples of the given sensor as a block.
+        /// </summary>
+        /// <param name="sensor"></param>
+        void flush(_In_ const id_type sensor);
+
+        /// <summary>
+        /// Adds a sample of the given sensor, writing the block of the sensor
+        /// if it is full.
+        /// </summary>
+        /// <param name="sensor"></param>
+        /// <param name="sample"></param>
+        /// <param name="marker"></param>
+        void write(_In_ const id_type sensor,
+            _In_ const measurement_data& sample,
+            _In_ const id_type marker);
+
+        /// <summary>
+        /// Writes a chunk consisting of a header and a payload.
+        /// </summary>
+        /// <param name="id"></param>
+        /// <param name="header"></param>
+        /// <param name="header_size"></param>
+        /// <param name="payload"></param>
+        /// <param name="payload_size"></param>
+        void write_chunk(_In_ const capture_chunk_id id,
+            _In_reads_bytes_(header_size) const void *header,
+            _In_ const std::size_t header_size,
+            _In_reads_bytes_(payload_size) const void *payload,
+            _In_ const std::size_t payload_size);
+
+        /// <summary>
+        /// Writes the given bytes to <see cref="output" />.
+        /// </summary>
+        /// <param name="data"></param>
+        /// <param name="cnt"></param>
+        void write_raw(_In_reads_bytes_(cnt) const void *data,
+            _In_ const std::size_t cnt);
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -16,6 +16,7 @@
 #include "power_overwhelming/convert_string.h"
 
 #include "collector_impl.h"
+#include "discovery_cache.h"
 #include "sensor_desc.h"
 #include "sensor_utilities.h"
 #include "tinkerforge_sensor_impl.h"
@@ -65,10 +66,13 @@ namespace detail {
 
         // If we have the sensors, create the output file and store the rest of the
         // properties.
-        dst->stream.open(cfg[field_output].get<std::string>(),
-            std::ofstream::trunc);
-        dst->sampling_interval = decltype(dst->sampling_interval)(
-            cfg[field_sampling].get<sensor::microseconds_type>());
+        const auto output = power_overwhelming::convert_string<wchar_t>(
+            cfg[field_output].get<std::string>());
+        collector_settings settings;
+        settings.output_path(output.c_str())
+            .sampling_interval(cfg[field_sampling]
+                .get<sensor::microseconds_type>());
+        dst->apply(settings);
     }
 
 } /* namespace detail */
@@ -84,7 +88,14 @@ visus::power_overwhelming::collector::for_all(
         _In_ const collector_settings& settings) {
     auto retval = collector(new detail::collector_impl());
     retval._impl->apply(settings);
-    retval._impl->sensors = detail::get_all_sensors();
+
+    if (settings.discovery_cache() != nullptr) {
+        retval._impl->sensors = detail::get_all_sensors_cached(
+            settings.discovery_cache());
+    } else {
+        retval._impl->sensors = detail::get_all_sensors();
+    }
+
     return retval;
 }
 
@@ -131,7 +142,11 @@ void visus::power_overwhelming::collector::make_configuration_template(
  * visus::power_overwhelming::collector::~collector
  */
 visus::power_overwhelming::collector::~collector(void) {
-    this->stop();
+    try {
+        this->stop();
+    } catch (...) {
+        // There is no one to report this to.
+    }
     delete this->_impl;
 }
 
@@ -150,6 +165,69 @@ void visus::power_overwhelming::collector::marker(
 }
 
 
+/*
+ * visus::power_overwhelming::collector::marker
+ */
+void visus::power_overwhelming::collector::marker(
+        _In_opt_z_ const wchar_t *marker,
+        _In_ const timestamp when) {
+    if (this->_impl == nullptr) {
+        throw std::runtime_error("The collector has been moved to another "
+            "instance wherefore no marker can be set.");
+    }
+
+    this->_impl->marker(marker, when);
+}
+
+
+/*
+ * visus::power_overwhelming::collector::marker
+ */
+void visus::power_overwhelming::collector::marker(
+        _In_ const marker_id_type marker) {
+    if (this->_impl == nullptr) {
+        throw std::runtime_error("The collector has been moved to another "
+            "instance wherefore no marker can be set.");
+    }
+
+    this->_impl->marker(marker, timestamp::now());
+}
+
+
+/*
+ * visus::power_overwhelming::collector::marker
+ */
+void visus::power_overwhelming::collector::marker(
+        _In_ const marker_id_type marker,
+        _In_ const timestamp when) {
+    if (this->_impl == nullptr) {
+        throw std::runtime_error("The collector has been moved to another "
+            "instance wherefore no marker can be set.");
+    }
+
+    this->_impl->marker(marker, when);
+}
+
+
+/*
+ * visus::power_overwhelming::collector::register_marker
+ */
+visus::power_overwhelming::collector::marker_id_type
+visus::power_overwhelming::collector::register_marker(
+        _In_z_ const wchar_t *marker) {
+    if (marker == nullptr) {
+        throw std::invalid_argument("A marker to be registered must not be "
+            "null.");
+    }
+    if (this->_impl == nullptr) {
+        throw std::runtime_error("The collector has been moved to another "
+            "instance wherefore no marker can be registered.");
+    }
+
+    return this->_impl->register_marker(marker);
+}
+
+
 /*
  * visus::power_overwhelming::collector::size
  */
@@ -236,3 +314,10 @@ void visus::power_overwhelming::collector::add(_In_ sensor *sensor) {
     this->_impl->sensors.emplace_back(sensor);
 }
 
+
+/*
+ * visus::power_overwhelming::collector::no_marker
+ */
+constexpr const visus::power_overwhelming::collector::marker_id_type
+visus::power_overwhelming::collector::no_marker;
+
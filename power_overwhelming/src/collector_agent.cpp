@@ -0,0 +1,178 @@
+﻿// <copyright file="collector_agent.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "collector_agent.h"
+
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+#include "power_overwhelming/convert_string.h"
+
+
+/*
+ * ...::detail::collector_agent::collector_agent
+ */
+visus::power_overwhelming::detail::collector_agent::collector_agent(
+        _In_z_ const wchar_t *node,
+        _In_z_ const wchar_t *host,
+        _In_ const std::uint16_t port,
+        _In_opt_ const time_synchroniser *synchroniser)
+        : _markers(0), _socket(invalid_socket), _synchroniser(synchroniser) {
+    if (node == nullptr) {
+        throw std::invalid_argument("The name of the node must not be null.");
+    }
+    if (host == nullptr) {
+        throw std::invalid_argument("The host name of the aggregator must not "
+            "be null.");
+    }
+
+    this->_socket = connect_tcp(
+        power_overwhelming::convert_string<char>(host).c_str(), port);
+
+    try {
+        const auto name = power_overwhelming::convert_string<char>(node);
+        this->append(colmsg_id::hello, name.data(), name.size());
+        this->send();
+    } catch (...) {
+        close_socket(this->_socket);
+        throw;
+    }
+}
+
+
+/*
+ * ...::detail::collector_agent::~collector_agent
+ */
+visus::power_overwhelming::detail::collector_agent::~collector_agent(void) {
+    close_socket(this->_socket);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_agent::add
+ */
+void visus::power_overwhelming::detail::collector_agent::add(
+        _In_ const measurement& sample,
+        _In_ const marker_id_type marker) {
+    assert(sample.sensor() != nullptr);
+    auto it = this->_sensors.find(sample.sensor());
+
+    if (it == this->_sensors.end()) {
+        // This is the first time we see the sensor, so we must announce it
+        // before the first sample is sent.
+        const auto id = static_cast<std::uint32_t>(this->_sensors.size());
+        it = this->_sensors.emplace(sample.sensor(), id).first;
+        this->append(colmsg_id::sensor, id, sample.sensor());
+    }
+
+    this->_ids.push_back(it->second);
+    this->_ids.push_back(marker);
+    this->_samples.emplace_back(sample.timestamp(), sample.voltage(),
+        sample.current(), sample.power());
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_agent::markers
+ */
+void visus::power_overwhelming::detail::collector_agent::markers(
+        _In_ const std::vector<std::wstring>& names) {
+    for (; this->_markers < names.size(); ++this->_markers) {
+        this->append(colmsg_id::marker,
+            static_cast<std::uint32_t>(this->_markers),
+            names[this->_markers].c_str());
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_agent::send
+ */
+void visus::power_overwhelming::detail::collector_agent::send(void) {
+    assert(this->_ids.size() == 2 * this->_samples.size());
+
+    if (!this->_samples.empty()) {
+        if (this->_synchroniser != nullptr) {
+            this->_synchroniser->to_reference(this->_samples.data(),
+                this->_samples.size());
+        }
+
+        // Serialise the samples directly into the message buffer.
+        const auto size = this->_samples.size() * sizeof(colmsg_sample);
+        this->append(colmsg_id::samples, nullptr, size);
+        auto dst = reinterpret_cast<colmsg_sample *>(this->_message.data()
+            + this->_message.size() - size);
+
+        for (std::size_t i = 0; i < this->_samples.size(); ++i, ++dst) {
+            const auto& s = this->_samples[i];
+            colmsg_sample sample;
+            sample.timestamp = s.timestamp().value();
+            sample.sensor = this->_ids[2 * i];
+            sample.marker = this->_ids[2 * i + 1];
+            sample.voltage = s.voltage();
+            sample.current = s.current();
+            sample.power = s.power();
+            sample.reserved = 0;
+            ::memcpy(dst, &sample, sizeof(sample));
+        }
+
+        this->_ids.clear();
+        this->_samples.clear();
+    }
+
+    if (!this->_message.empty()) {
+        send_all(this->_socket, this->_message.data(), this->_message.size());
+        this->_message.clear();
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_agent::append
+ */
+void visus::power_overwhelming::detail::collector_agent::append(
+        _In_ const colmsg_id id,
+        _In_reads_bytes_(cnt) const void *payload,
+        _In_ const std::size_t cnt) {
+    if (cnt > colmsg_max_size) {
+        throw std::invalid_argument("The message is too large to be sent to "
+            "the aggregator.");
+    }
+
+    colmsg_header header;
+    header.id = id;
+    header.size = static_cast<std::uint32_t>(cnt);
+
+    const auto offset = this->_message.size();
+    this->_message.resize(offset + sizeof(header) + cnt);
+    ::memcpy(this->_message.data() + offset, &header, sizeof(header));
+
+    if (payload != nullptr) {
+        ::memcpy(this->_message.data() + offset + sizeof(header), payload,
+            cnt);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_agent::append
+ */
+void visus::power_overwhelming::detail::collector_agent::append(
+        _In_ const colmsg_id id,
+        _In_ const std::uint32_t name_id,
+        _In_z_ const wchar_t *name) {
+    assert(name != nullptr);
+    const auto n = power_overwhelming::convert_string<char>(name);
+
+    std::vector<char> payload(sizeof(colmsg_name) + n.size());
+    colmsg_name header;
+    header.id = name_id;
+    ::memcpy(payload.data(), &header, sizeof(header));
+    ::memcpy(payload.data() + sizeof(header), n.data(), n.size());
+
+    this->append(id, payload.data(), payload.size());
+}
@@ -0,0 +1,126 @@
+﻿// <copyright file="collector_agent.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "power_overwhelming/collector.h"
+#include "power_overwhelming/measurement.h"
+#include "power_overwhelming/time_synchroniser.h"
+
+#include "collector_protocol.h"
+#include "socket_util.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Streams the samples of a <see cref="collector" /> to a remote
+    /// <see cref="collector_aggregator" />.
+    /// </summary>
+    /// <remarks>
+    /// The agent is not thread-safe. It is intended to be used exclusively by
+    /// the I/O thread of the collector, which batches the samples between
+    /// calls to <see cref="send" />.
+    /// </remarks>
+    class collector_agent final {
+
+    public:
+
+        /// <summary>
+        /// The type of a registered marker.
+        /// </summary>
+        typedef collector::marker_id_type marker_id_type;
+
+        /// <summary>
+        /// Connects to the given aggregator and introduces the agent as
+        /// <paramref name="node" />.
+        /// </summary>
+        /// <param name="node">The name of the node the agent is running
+        /// on.</param>
+        /// <param name="host">The name or address of the aggregator.</param>
+        /// <param name="port">The port the aggregator is listening on.</param>
+        /// <param name="synchroniser">An optional synchroniser that is used
+        /// to transform the timestamps of all samples into the reference clock
+        /// before they are sent.</param>
+        /// <exception cref="std::system_error">If the connection could not be
+        /// established.</exception>
+        collector_agent(_In_z_ const wchar_t *node,
+            _In_z_ const wchar_t *host,
+            _In_ const std::uint16_t port,
+            _In_opt_ const time_synchroniser *synchroniser = nullptr);
+
+        collector_agent(const collector_agent&) = delete;
+
+        /// <summary>
+        /// Finalises the instance, which closes the connection.
+        /// </summary>
+        ~collector_agent(void);
+
+        /// <summary>
+        /// Adds a sample to the current batch.
+        /// </summary>
+        /// <param name="sample">The sample to be added.</param>
+        /// <param name="marker">The ID of the marker that is active for the
+        /// sample, which must have been announced via
+        /// <see cref="markers" /> before.</param>
+        void add(_In_ const measurement& sample,
+            _In_ const marker_id_type marker);
+
+        /// <summary>
+        /// Announces all markers in <paramref name="names" /> that have not
+        /// yet been announced.
+        /// </summary>
+        /// <remarks>
+        /// The marker IDs are the indices into <paramref name="names" />,
+        /// which must therefore only grow.
+        /// </remarks>
+        /// <param name="names">The names of all registered markers.</param>
+        void markers(_In_ const std::vector<std::wstring>& names);
+
+        /// <summary>
+        /// Sends all pending announcements and the current batch of samples.
+        /// </summary>
+        /// <exception cref="std::system_error">If the connection was
+        /// lost.</exception>
+        void send(void);
+
+        collector_agent& operator =(const collector_agent&) = delete;
+
+    private:
+
+        /// <summary>
+        /// Appends a message to <see cref="_message" />.
+        /// </summary>
+        void append(_In_ const colmsg_id id,
+            _In_reads_bytes_(cnt) const void *payload,
+            _In_ const std::size_t cnt);
+
+        /// <summary>
+        /// Appends a name announcement to <see cref="_message" />.
+        /// </summary>
+        void append(_In_ const colmsg_id id, _In_ const std::uint32_t name_id,
+            _In_z_ const wchar_t *name);
+
+        std::vector<std::uint32_t> _ids;
+        std::size_t _markers;
+        std::vector<char> _message;
+        std::vector<measurement_data> _samples;
+        std::unordered_map<std::wstring, std::uint32_t> _sensors;
+        socket_scope _scope;
+        socket_type _socket;
+        const time_synchroniser *_synchroniser;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,87 @@
+﻿// <copyright file="collector_aggregator.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/collector_aggregator.h"
+
+#include <memory>
+
+#include "collector_aggregator_impl.h"
+
+
+/*
+ * visus::power_overwhelming::collector_aggregator::create
+ */
+visus::power_overwhelming::collector_aggregator
+visus::power_overwhelming::collector_aggregator::create(
+        _In_ const collector_settings& settings,
+        _In_ const int address_family) {
+    collector_aggregator retval;
+    retval._impl = new detail::collector_aggregator_impl();
+
+    try {
+        retval._impl->start(settings, address_family);
+    } catch (...) {
+        delete retval._impl;
+        retval._impl = nullptr;
+        throw;
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_aggregator::~collector_aggregator
+ */
+visus::power_overwhelming::collector_aggregator::~collector_aggregator(void) {
+    delete this->_impl;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_aggregator::agents
+ */
+std::size_t visus::power_overwhelming::collector_aggregator::agents(
+        void) const noexcept {
+    return (this->_impl != nullptr)
+        ? this->_impl->connected.load(std::memory_order::memory_order_acquire)
+        : 0;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_aggregator::stop
+ */
+void visus::power_overwhelming::collector_aggregator::stop(void) {
+    if (this->_impl != nullptr) {
+        this->_impl->stop();
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::collector_aggregator::operator =
+ */
+visus::power_overwhelming::collector_aggregator&
+visus::power_overwhelming::collector_aggregator::operator =(
+        _In_ collector_aggregator&& rhs) noexcept {
+    if (this != std::addressof(rhs)) {
+        delete this->_impl;
+        this->_impl = rhs._impl;
+        rhs._impl = nullptr;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_aggregator::operator bool
+ */
+visus::power_overwhelming::collector_aggregator::operator bool(
+        void) const noexcept {
+    return (this->_impl != nullptr);
+}
@@ -0,0 +1,412 @@
+﻿// <copyright file="collector_aggregator_impl.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "collector_aggregator_impl.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#if !defined(_WIN32)
+#include <sys/socket.h>
+#endif /* !defined(_WIN32) */
+
+#include "power_overwhelming/convert_string.h"
+#include "power_overwhelming/csv_encoder.h"
+#include "power_overwhelming/csv_iomanip.h"
+#include "power_overwhelming/measurement.h"
+
+
+/*
+ * ...::detail::collector_aggregator_impl::collector_aggregator_impl
+ */
+visus::power_overwhelming::detail::collector_aggregator_impl
+::collector_aggregator_impl(void) : connected(0),
+    evt_write(create_event(false, false)), header(true), running(false),
+    socket(invalid_socket), silence_timeout(0), stream(nullptr),
+    writing(false), write_interval(0) { }
+
+
+/*
+ * ...::detail::collector_aggregator_impl::~collector_aggregator_impl
+ */
+visus::power_overwhelming::detail::collector_aggregator_impl
+::~collector_aggregator_impl(void) {
+    this->stop();
+    destroy_event(this->evt_write);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_aggregator_impl::accept
+ */
+void visus::power_overwhelming::detail::collector_aggregator_impl::accept(
+        void) {
+    while (this->running.load(std::memory_order::memory_order_acquire)) {
+        auto socket = ::accept(this->socket, nullptr, nullptr);
+
+        if (socket == invalid_socket) {
+            // This is either a transient error or the listening socket was
+            // shut down, in which case the loop condition will exit.
+            continue;
+        }
+
+        std::lock_guard<decltype(this->lock)> l(this->lock);
+        if (!this->running.load(std::memory_order::memory_order_acquire)) {
+            // We have been stopped while accepting.
+            close_socket(socket);
+            break;
+        }
+
+        this->agents.emplace_back();
+        auto& agent = this->agents.back();
+        agent.connected = true;
+        agent.have_watermark = false;
+        agent.last_batch = std::chrono::steady_clock::now();
+        agent.socket = socket;
+        agent.watermark = 0;
+        agent.thread = std::thread(&collector_aggregator_impl::receive, this,
+            &agent);
+        this->connected.fetch_add(1, std::memory_order::memory_order_release);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_aggregator_impl::flush
+ */
+void visus::power_overwhelming::detail::collector_aggregator_impl::flush(
+        _In_ const bool everything) {
+    std::vector<record_type> records;
+
+    {
+        std::lock_guard<decltype(this->lock)> l(this->lock);
+
+        // Determine up to which point we have received all samples. Agents
+        // that have disconnected do not limit this, but agents that have not
+        // sent anything yet might still deliver older samples. However, we do
+        // not wait for agents that have been silent for too long, eg because
+        // they require a marker that has not been set, as the samples of all
+        // others would pile up in memory otherwise.
+        const auto now = std::chrono::steady_clock::now();
+        auto watermark = (std::numeric_limits<timestamp::value_type>::max)();
+        if (!everything) {
+            for (auto& a : this->agents) {
+                if (!a.connected) {
+                    continue;
+                }
+
+                if (now - a.last_batch > this->silence_timeout) {
+                    continue;
+                }
+
+                if (!a.have_watermark) {
+                    watermark = (std::numeric_limits<
+                        timestamp::value_type>::lowest)();
+                    break;
+                }
+
+                if (a.watermark < watermark) {
+                    watermark = a.watermark;
+                }
+            }
+        }
+
+        for (auto& a : this->agents) {
+            auto end = std::stable_partition(a.samples.begin(),
+                a.samples.end(),
+                [watermark](const colmsg_sample& s) {
+                    return (s.timestamp <= watermark);
+                });
+
+            for (auto it = a.samples.begin(); it != end; ++it) {
+                auto sensor = a.sensors.find(it->sensor);
+                if (sensor == a.sensors.end()) {
+                    // This is a protocol violation, so we cannot do anything
+                    // with the sample.
+                    continue;
+                }
+
+                auto marker = a.markers.find(it->marker);
+                records.push_back(record_type {
+                    (marker != a.markers.end()) ? &marker->second : nullptr,
+                    *it,
+                    &sensor->second
+                });
+            }
+
+            a.samples.erase(a.samples.begin(), end);
+        }
+    }
+
+    if (records.empty()) {
+        return;
+    }
+
+    // The samples of each agent are in order of arrival, so the sort merges
+    // only a small number of runs.
+    std::stable_sort(records.begin(), records.end(),
+        [](const record_type& l, const record_type& r) {
+            return (l.sample.timestamp < r.sample.timestamp);
+        });
+
+    const csv_encoder encoder(this->stream);
+    const auto delimiter = encoder.delimiter();
+    const auto quote = encoder.quote();
+    csv_encoder::char_type data[csv_encoder::max_data_size];
+
+    if (this->header) {
+        // If this is the first line, print the CSV header.
+        const auto& r = records.front();
+        this->stream << csvheader
+            << measurement(power_overwhelming::convert_string<wchar_t>(
+                *r.sensor).c_str(), timestamp(r.sample.timestamp),
+                r.sample.voltage, r.sample.current, r.sample.power)
+            << delimiter << "marker" << '\n'
+            << csvdata;
+        this->header = false;
+    }
+
+    // The names have been narrowed when they were announced, so we only need
+    // to encode the values of each sample.
+    for (auto& r : records) {
+        const measurement_data sample(timestamp(r.sample.timestamp),
+            r.sample.voltage, r.sample.current, r.sample.power);
+
+        if (quote != 0) {
+            this->stream.put(quote);
+        }
+        this->stream.write(r.sensor->data(), r.sensor->size());
+        if (quote != 0) {
+            this->stream.put(quote);
+        }
+        this->stream.put(delimiter);
+
+        this->stream.write(data, encoder.encode(data, sample));
+        this->stream.put(delimiter);
+        if (r.marker != nullptr) {
+            this->stream.write(r.marker->data(), r.marker->size());
+        }
+        this->stream.put('\n');
+    }
+
+    this->stream.flush();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_aggregator_impl::receive
+ */
+void visus::power_overwhelming::detail::collector_aggregator_impl::receive(
+        _In_ agent_type *agent) {
+    assert(agent != nullptr);
+    std::vector<char> payload;
+
+    try {
+        colmsg_header header;
+
+        while (receive_all(agent->socket, &header, sizeof(header))) {
+            if (header.size > colmsg_max_size) {
+                // Something is wrong with the agent, so disconnect it.
+                break;
+            }
+
+            payload.resize(header.size);
+            if (!receive_all(agent->socket, payload.data(), payload.size())) {
+                break;
+            }
+
+            std::lock_guard<decltype(this->lock)> l(this->lock);
+            switch (header.id) {
+                case colmsg_id::hello:
+                    agent->name = power_overwhelming::convert_string<
+                        wchar_t>(std::string(payload.begin(), payload.end()));
+                    break;
+
+                case colmsg_id::sensor:
+                case colmsg_id::marker: {
+                    if (payload.size() < sizeof(colmsg_name)) {
+                        break;
+                    }
+
+                    colmsg_name name;
+                    ::memcpy(&name, payload.data(), sizeof(name));
+                    std::string value(payload.begin() + sizeof(name),
+                        payload.end());
+
+                    if (header.id == colmsg_id::sensor) {
+                        agent->sensors[name.id] = power_overwhelming
+                            ::convert_string<char>(agent->name) + "/" + value;
+                    } else {
+                        agent->markers[name.id] = std::move(value);
+                    }
+                    } break;
+
+                case colmsg_id::samples: {
+                    const auto cnt = payload.size() / sizeof(colmsg_sample);
+                    if (cnt == 0) {
+                        break;
+                    }
+
+                    const auto offset = agent->samples.size();
+                    agent->samples.resize(offset + cnt);
+                    ::memcpy(agent->samples.data() + offset, payload.data(),
+                        cnt * sizeof(colmsg_sample));
+
+                    // The oldest sample of the most recent batch tells us up to
+                    // which point we have everything from this agent.
+                    auto oldest = std::min_element(
+                        agent->samples.begin() + offset,
+                        agent->samples.end(),
+                        [](const colmsg_sample& l, const colmsg_sample& r) {
+                            return (l.timestamp < r.timestamp);
+                        })->timestamp;
+                    if (!agent->have_watermark || (oldest > agent->watermark)) {
+                        agent->watermark = oldest;
+                        agent->have_watermark = true;
+                    }
+                    agent->last_batch = std::chrono::steady_clock::now();
+
+                    set_event(this->evt_write);
+                    } break;
+
+                default:
+                    // Ignore messages we do not understand.
+                    break;
+            }
+        }
+    } catch (...) {
+        // The connection was lost, which we handle like a disconnect.
+    }
+
+    {
+        std::lock_guard<decltype(this->lock)> l(this->lock);
+        agent->connected = false;
+        close_socket(agent->socket);
+        agent->socket = invalid_socket;
+    }
+
+    this->connected.fetch_sub(1, std::memory_order::memory_order_release);
+    set_event(this->evt_write);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_aggregator_impl::start
+ */
+void visus::power_overwhelming::detail::collector_aggregator_impl::start(
+        _In_ const collector_settings& settings,
+        _In_ const int address_family) {
+    using namespace std::chrono;
+    assert(settings.output_path() != nullptr);
+    assert(!this->running.load());
+
+    // Use the same output as a local collector would, with two blocks such
+    // that we can format into one while the other one is being written.
+    this->output.reset(new block_writer(settings.output_path(),
+        settings.output_block_size(),
+        2,
+        settings.sync_policy(),
+        settings.direct_io()));
+    this->stream.rdbuf(this->output.get());
+    this->header = true;
+
+    // Use the same flushing interval as a local collector would.
+    this->write_interval = (std::max)(milliseconds(1), duration_cast<
+        milliseconds>(microseconds(settings.sampling_interval())) * 8);
+
+    // Agents send their samples in the same interval, so if we have not heard
+    // from one for many intervals, it is most likely not sampling.
+    this->silence_timeout = (std::max)(milliseconds(1000),
+        10 * this->write_interval);
+
+    this->socket = listen_tcp(address_family, settings.aggregator_port());
+
+    this->running.store(true, std::memory_order::memory_order_release);
+    this->writing.store(true, std::memory_order::memory_order_release);
+    this->writer = std::thread(&collector_aggregator_impl::write, this);
+    this->acceptor = std::thread(&collector_aggregator_impl::accept, this);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_aggregator_impl::stop
+ */
+void visus::power_overwhelming::detail::collector_aggregator_impl::stop(void) {
+    {
+        auto expected = true;
+        if (!this->running.compare_exchange_strong(expected, false,
+                std::memory_order::memory_order_acq_rel)) {
+            // We are not running, so there is nothing to do.
+            return;
+        }
+    }
+
+    // Wake the acceptor. On Windows, closing the socket is the only reliable
+    // way to do so.
+    shutdown_socket(this->socket);
+#if defined(_WIN32)
+    close_socket(this->socket);
+    this->socket = invalid_socket;
+#endif /* defined(_WIN32) */
+    if (this->acceptor.joinable()) {
+        this->acceptor.join();
+    }
+    close_socket(this->socket);
+    this->socket = invalid_socket;
+
+    // Disconnect all agents. The acceptor has exited, so the list is not
+    // modified anymore.
+    {
+        std::lock_guard<decltype(this->lock)> l(this->lock);
+        for (auto& a : this->agents) {
+            shutdown_socket(a.socket);
+        }
+    }
+
+    for (auto& a : this->agents) {
+        if (a.thread.joinable()) {
+            a.thread.join();
+        }
+    }
+
+    // Finally, make the writer persist everything and exit.
+    this->writing.store(false, std::memory_order::memory_order_release);
+    set_event(this->evt_write);
+    if (this->writer.joinable()) {
+        this->writer.join();
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_aggregator_impl::write
+ */
+void visus::power_overwhelming::detail::collector_aggregator_impl::write(
+        void) {
+    const auto timeout = static_cast<unsigned int>(
+        this->write_interval.count());
+
+    while (this->writing.load(std::memory_order::memory_order_acquire)) {
+        wait_event(this->evt_write, timeout);
+        this->flush(false);
+    }
+
+    // At this point, all receivers have exited and we can write everything
+    // that is left.
+    this->flush(true);
+
+    try {
+        this->output->close();
+    } catch (...) {
+        // There is no one to report this to.
+    }
+
+    this->stream.rdbuf(nullptr);
+    this->output.reset();
+}
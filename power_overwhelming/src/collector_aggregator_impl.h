@@ -0,0 +1,248 @@
+﻿// <copyright file="collector_aggregator_impl.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "power_overwhelming/collector_settings.h"
+#include "power_overwhelming/event.h"
+#include "power_overwhelming/timestamp.h"
+
+#include "block_writer.h"
+#include "collector_protocol.h"
+#include "socket_util.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Private data container for <see cref="collector_aggregator" />.
+    /// </summary>
+    struct collector_aggregator_impl final {
+
+        /// <summary>
+        /// The state of a connected agent.
+        /// </summary>
+        struct agent_type {
+
+            /// <summary>
+            /// Indicates whether the agent is still connected.
+            /// </summary>
+            bool connected;
+
+            /// <summary>
+            /// Indicates whether <see cref="watermark" /> is valid.
+            /// </summary>
+            bool have_watermark;
+
+            /// <summary>
+            /// The point in time when the agent connected or when the most
+            /// recent batch of samples was received from it.
+            /// </summary>
+            std::chrono::steady_clock::time_point last_batch;
+
+            /// <summary>
+            /// The narrow names of the markers of the agent by their ID.
+            /// </summary>
+            std::unordered_map<std::uint32_t, std::string> markers;
+
+            /// <summary>
+            /// The name of the node the agent is running on.
+            /// </summary>
+            std::wstring name;
+
+            /// <summary>
+            /// The samples that have been received, but not yet been written.
+            /// </summary>
+            std::vector<colmsg_sample> samples;
+
+            /// <summary>
+            /// The fully qualified narrow names of the sensors of the agent by
+            /// their ID.
+            /// </summary>
+            std::unordered_map<std::uint32_t, std::string> sensors;
+
+            /// <summary>
+            /// The socket connected to the agent.
+            /// </summary>
+            socket_type socket;
+
+            /// <summary>
+            /// The thread executing <see cref="receive" /> for the agent.
+            /// </summary>
+            std::thread thread;
+
+            /// <summary>
+            /// The point in time until which we assume to have received all
+            /// samples from the agent.
+            /// </summary>
+            timestamp::value_type watermark;
+        };
+
+        /// <summary>
+        /// A sample that is ready to be written.
+        /// </summary>
+        struct record_type {
+            const std::string *marker;
+            colmsg_sample sample;
+            const std::string *sensor;
+        };
+
+        /// <summary>
+        /// The thread executing <see cref="accept" />.
+        /// </summary>
+        std::thread acceptor;
+
+        /// <summary>
+        /// All agents that have ever been connected.
+        /// </summary>
+        /// <remarks>
+        /// We never remove agents from the list while the aggregator is
+        /// running, which allows us to pass pointers to their names to the I/O
+        /// thread.
+        /// </remarks>
+        std::list<agent_type> agents;
+
+        /// <summary>
+        /// The number of agents that are currently connected.
+        /// </summary>
+        std::atomic<std::size_t> connected;
+
+        /// <summary>
+        /// An event to wake the I/O thread.
+        /// </summary>
+        event_type evt_write;
+
+        /// <summary>
+        /// Indicates whether the CSV header still needs to be written.
+        /// </summary>
+        bool header;
+
+        /// <summary>
+        /// The lock protecting the <see cref="agents" />.
+        /// </summary>
+        std::mutex lock;
+
+        /// <summary>
+        /// The stream buffer writing the output file in large blocks on a
+        /// separate thread.
+        /// </summary>
+        std::unique_ptr<block_writer> output;
+
+        /// <summary>
+        /// Indicates whether the aggregator should continue running.
+        /// </summary>
+        std::atomic<bool> running;
+
+        /// <summary>
+        /// Keeps the socket library alive.
+        /// </summary>
+        socket_scope scope;
+
+        /// <summary>
+        /// The socket accepting new agents.
+        /// </summary>
+        socket_type socket;
+
+        /// <summary>
+        /// The time after which a connected agent that has not sent any
+        /// samples does not hold back the output of the others anymore.
+        /// </summary>
+        std::chrono::milliseconds silence_timeout;
+
+        /// <summary>
+        /// The stream formatting the results into the blocks of
+        /// <see cref="output" />.
+        /// </summary>
+        std::ostream stream;
+
+        /// <summary>
+        /// Indicates whether the I/O thread should continue running.
+        /// </summary>
+        /// <remarks>
+        /// This flag is separate from <see cref="running" />, because the I/O
+        /// thread must continue until all receivers have exited.
+        /// </remarks>
+        std::atomic<bool> writing;
+
+        /// <summary>
+        /// The maximum time the I/O thread sleeps before checking for new
+        /// samples.
+        /// </summary>
+        std::chrono::milliseconds write_interval;
+
+        /// <summary>
+        /// The I/O thread executing <see cref="write" />.
+        /// </summary>
+        std::thread writer;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        collector_aggregator_impl(void);
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~collector_aggregator_impl(void);
+
+        /// <summary>
+        /// Runs in <see cref="acceptor" /> and accepts new agents.
+        /// </summary>
+        void accept(void);
+
+        /// <summary>
+        /// Removes all samples that can be written from the agents and writes
+        /// them to <see cref="stream" />.
+        /// </summary>
+        /// <param name="everything">If <c>true</c>, ignore the watermarks of
+        /// the agents and write all pending samples.</param>
+        void flush(_In_ const bool everything);
+
+        /// <summary>
+        /// Runs in the <see cref="agent_type::thread" /> and receives the
+        /// messages of <paramref name="agent" />.
+        /// </summary>
+        /// <param name="agent">The agent to receive from.</param>
+        void receive(_In_ agent_type *agent);
+
+        /// <summary>
+        /// Opens the output file and starts accepting agents.
+        /// </summary>
+        /// <param name="settings">The settings of the aggregator.</param>
+        /// <param name="address_family">The address family to listen
+        /// on.</param>
+        void start(_In_ const collector_settings& settings,
+            _In_ const int address_family);
+
+        /// <summary>
+        /// Disconnects all agents and writes all pending samples.
+        /// </summary>
+        void stop(void);
+
+        /// <summary>
+        /// Runs in <see cref="writer" /> and periodically writes all samples
+        /// that have been received from all agents.
+        /// </summary>
+        void write(void);
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -6,12 +6,16 @@
 
 #include "collector_impl.h"
 
+#include <algorithm>
 #include <cassert>
+#include <stdexcept>
 #include <system_error>
 
 #include "power_overwhelming/adl_sensor.h"
 #include "power_overwhelming/collector.h"
+#include "power_overwhelming/computer_name.h"
 #include "power_overwhelming/convert_string.h"
+#include "power_overwhelming/csv_encoder.h"
 #include "power_overwhelming/emi_sensor.h"
 #include "power_overwhelming/msr_sensor.h"
 #include "power_overwhelming/nvml_sensor.h"
@@ -19,6 +23,13 @@
 #include "power_overwhelming/tinkerforge_sensor.h"
 
 
+/*
+ * visus::power_overwhelming::detail::collector_impl::marker_lookback
+ */
+constexpr std::chrono::seconds
+visus::power_overwhelming::detail::collector_impl::marker_lookback;
+
+
 /*
  * visus::power_overwhelming::detail::collector_impl::on_measurement
  */
@@ -37,9 +48,9 @@ void visus::power_overwhelming::detail::collector_impl::on_measurement(
  * visus::power_overwhelming::detail::collector_impl::collector_impl
  */
 visus::power_overwhelming::detail::collector_impl::collector_impl(void)
-        : evt_write(create_event(false, false)),
+        : aggregator_port(0), evt_write(create_event(false, false)),
         have_marker(false), running(false), sampling_interval(0),
-        require_marker(false) { }
+        require_marker(false), synchroniser(nullptr), stream(nullptr) { }
 
 
 /*
@@ -58,12 +69,31 @@ void visus::power_overwhelming::detail::collector_impl::apply(
     assert(settings.output_path() != nullptr);
     auto output_path = settings.output_path();
 
-#if defined(_WIN32)
-    this->stream.open(output_path, std::ofstream::trunc);
-#else /* defined(_WIN32) */
-    auto p = power_overwhelming::convert_string<char>(output_path);
-    this->stream.open(p, std::ofstream::trunc);
-#endif /* defined(_WIN32) */
+    if (settings.aggregator() != nullptr) {
+        // The collector is an agent, which connects to the aggregator once it
+        // is started rather than writing to a file.
+        this->aggregator = settings.aggregator();
+        this->aggregator_port = settings.aggregator_port();
+        this->synchroniser = settings.time_synchroniser();
+
+    } else if (settings.output_format() == output_format::capture) {
+        this->capture.reset(new capture_writer_impl(output_path,
+            settings.capture_compression(),
+            capture_writer::default_block_size,
+            settings.output_block_size(),
+            settings.sync_policy(),
+            settings.direct_io()));
+
+    } else {
+        // Use two blocks such that we can format into one while the other
+        // one is being written.
+        this->output.reset(new block_writer(output_path,
+            settings.output_block_size(),
+            2,
+            settings.sync_policy(),
+            settings.direct_io()));
+        this->stream.rdbuf(this->output.get());
+    }
 
     this->sampling_interval = std::chrono::microseconds(
         settings.sampling_interval());
@@ -84,17 +114,23 @@ bool visus::power_overwhelming::detail::collector_impl::can_buffer(void) const {
  */
 void visus::power_overwhelming::detail::collector_impl::marker(
         const wchar_t *marker) {
+    this->marker(marker, timestamp::now());
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::marker
+ */
+void visus::power_overwhelming::detail::collector_impl::marker(
+        const wchar_t *marker, const timestamp when) {
     const auto have_marker = (marker != nullptr);
+    const auto id = have_marker
+        ? this->register_marker(marker)
+        : collector::no_marker;
 
-    // Enable/disable collection of samples by other threads.
-    this->have_marker.store(have_marker,
-        std::memory_order::memory_order_release);
+    this->marker(id, when);
 
     if (have_marker) {
-        // If we now have a marker, store it for the I/O thread to process.
-        std::lock_guard<decltype(this->lock)> l(this->lock);
-        this->markers.emplace_back(marker, this->buffer.size());
-
         // Wake the I/O thread, because if we start a new phase, it is typically
         // a good idea to make sure that what we already have is persisted.
         set_event(this->evt_write);
@@ -102,6 +138,49 @@ void visus::power_overwhelming::detail::collector_impl::marker(
 }
 
 
+/*
+ * visus::power_overwhelming::detail::collector_impl::marker
+ */
+void visus::power_overwhelming::detail::collector_impl::marker(
+        const marker_id_type marker, const timestamp when) {
+    // Enable/disable collection of samples by other threads.
+    this->have_marker.store(marker != collector::no_marker,
+        std::memory_order::memory_order_release);
+
+    if (!this->markers.try_push(marker_type { when, marker })) {
+        // The I/O thread is lagging behind, so we must take the slow path.
+        std::lock_guard<decltype(this->lock)> l(this->lock);
+        this->marker_overflow.push_back(marker_type { when, marker });
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::collector_impl::register_marker
+ */
+visus::power_overwhelming::detail::collector_impl::marker_id_type
+visus::power_overwhelming::detail::collector_impl::register_marker(
+        const wchar_t *marker) {
+    assert(marker != nullptr);
+    std::lock_guard<decltype(this->marker_lock)> l(this->marker_lock);
+
+    auto it = this->marker_ids.find(marker);
+    if (it != this->marker_ids.end()) {
+        return it->second;
+    }
+
+    if (this->marker_names.size() >= collector::no_marker) {
+        throw std::runtime_error("The maximum number of markers has been "
+            "registered.");
+    }
+
+    const auto retval = static_cast<marker_id_type>(this->marker_names.size());
+    this->marker_names.emplace_back(marker);
+    this->marker_ids.emplace(this->marker_names.back(), retval);
+    return retval;
+}
+
+
 /*
  * visus::power_overwhelming::detail::collector_impl::start
  */
@@ -117,6 +196,16 @@ void visus::power_overwhelming::detail::collector_impl::start(void) {
     }
 
     try {
+        if (!this->aggregator.empty()) {
+            // Connect to the aggregator first such that the caller is informed
+            // if it is not reachable.
+            this->agent.reset(new collector_agent(
+                computer_name<wchar_t>().c_str(),
+                this->aggregator.c_str(),
+                this->aggregator_port,
+                this->synchroniser));
+        }
+
         for (auto& s : this->sensors) {
             {
                 // Start ADL sampler. ADL is asynchronous, but we start a
@@ -185,6 +274,7 @@ void visus::power_overwhelming::detail::collector_impl::start(void) {
         // Finally, start the I/O thread.
         this->writer_thread = std::thread(&collector_impl::write, this);
     } catch (...) {
+        this->agent.reset();
         this->running = false;
         throw;
     }
@@ -241,6 +331,14 @@ void visus::power_overwhelming::detail::collector_impl::stop(void) {
     if (this->writer_thread.joinable()) {
         this->writer_thread.join();
     }
+
+    // If the I/O thread lost the connection to the aggregator or could not
+    // close the output, the caller must learn that samples are missing.
+    if (this->write_error) {
+        auto error = this->write_error;
+        this->write_error = nullptr;
+        std::rethrow_exception(error);
+    }
 }
 
 
@@ -251,7 +349,15 @@ void visus::power_overwhelming::detail::collector_impl::write(void) {
     using namespace std::chrono;
     buffer_type buffer;
     const auto delimiter = getcsvdelimiter(this->stream);
+    const csv_encoder encoder(this->stream);
+    const auto remote = !this->aggregator.empty();
+    auto header = true;
+    std::vector<std::string> labels;
+    std::vector<csv_encoder::char_type> line(256);
+    auto have_latest = false;
+    timestamp latest;
     marker_list_type markers;
+    std::vector<std::wstring> names;
     const auto timeout = static_cast<unsigned int>(duration_cast<milliseconds>(
         this->sampling_interval).count()) * 8;
 
@@ -261,38 +367,176 @@ void visus::power_overwhelming::detail::collector_impl::write(void) {
         {
             std::lock_guard<decltype(this->lock)> l(this->lock);
             buffer = std::move(this->buffer);
-            markers = std::move(this->markers);
+            markers.insert(markers.end(), this->marker_overflow.begin(),
+                this->marker_overflow.end());
+            this->marker_overflow.clear();
+        }
 
-            if (!markers.empty() && this->have_marker.load()) {
-                // Remember the last marker if it is still active. This is
-                // relevant in cases when we were invoked because of a timeout.
-                this->markers.push_back(markers.back());
+        // Collect the markers after the samples, which makes sure that we
+        // have all markers set before the last sample was acquired.
+        {
+            marker_type m;
+            while (this->markers.try_pop(m)) {
+                markers.push_back(m);
             }
         }
 
-        if ((this->stream.tellp() == 0) && !buffer.empty()) {
+        // Markers are typically in order already, so this is cheap.
+        std::stable_sort(markers.begin(), markers.end(),
+            [](const marker_type& l, const marker_type& r) {
+                return (l.when < r.when);
+            });
+
+        {
+            // Copy the names of markers that have been registered since the
+            // last time, so we can use them without holding the lock.
+            std::lock_guard<decltype(this->marker_lock)> l(this->marker_lock);
+            for (auto i = names.size(); i < this->marker_names.size(); ++i) {
+                names.push_back(this->marker_names[i]);
+            }
+        }
+
+        if (this->capture) {
+            // Declare new markers in the capture, which assigns the same IDs
+            // as we use, because both count in order of registration.
+            for (auto i = this->capture->markers.size(); i < names.size();
+                    ++i) {
+                this->capture->declare(this->capture->markers,
+                    capture_chunk_id::marker,
+                    names[i].c_str());
+            }
+
+        } else if (!remote) {
+            // The output is narrow, so convert the new names once here.
+            for (auto i = labels.size(); i < names.size(); ++i) {
+                labels.push_back(power_overwhelming::convert_string<char>(
+                    names[i]));
+            }
+        }
+
+        if (remote && this->agent) {
+            // Make sure that the aggregator knows all markers before we send
+            // samples referring to them.
+            this->agent->markers(names);
+
+        } else if (!remote && !this->capture && header && !buffer.empty()) {
             // If this is the first line, print the CSV header.
             this->stream << csvheader
                 << buffer.front() << delimiter
-                << L"marker" << std::endl
+                << "marker" << '\n'
                 << csvdata;
+            header = false;
+        }
+
+        const auto find_marker = [&markers](const timestamp t) {
+            // Find the first marker becoming effective after 't'.
+            return std::upper_bound(markers.begin(), markers.end(), t,
+                [](const timestamp t, const marker_type& m) {
+                    return (t < m.when);
+                });
+        };
+
+        for (auto& s : buffer) {
+            const auto t = s.timestamp();
+            const auto it = find_marker(t);
+            const auto have_marker = (it != markers.begin())
+                && ((it - 1)->id < names.size());
+
+            if (!have_latest || (t > latest)) {
+                have_latest = true;
+                latest = t;
+            }
+
+            if (!have_marker && this->require_marker) {
+                continue;
+            }
+
+            if (remote) {
+                if (this->agent) {
+                    this->agent->add(s, have_marker
+                        ? (it - 1)->id
+                        : collector::no_marker);
+                }
+                continue;
+            }
+
+            if (this->capture) {
+                const auto sensor = (s.sensor() != nullptr) ? s.sensor() : L"";
+                this->capture->write(this->capture->declare(
+                    this->capture->sensors, capture_chunk_id::sensor, sensor),
+                    s.data(),
+                    have_marker ? (it - 1)->id : collector::no_marker);
+                continue;
+            }
+
+            auto cnt = encoder.encode(line.data(), line.size(), s);
+            if (cnt > line.size()) {
+                line.resize(2 * cnt);
+                cnt = encoder.encode(line.data(), line.size(), s);
+            }
+
+            this->stream.write(line.data(), cnt);
+            this->stream.put(delimiter);
+            if (have_marker) {
+                const auto& label = labels[(it - 1)->id];
+                this->stream.write(label.data(), label.size());
+            }
+            this->stream.put('\n');
         }
 
-        for (std::size_t i = 0, m = 0; i < buffer.size(); ++i) {
-            if ((m + 1 < markers.size()) && (i >= markers[m + 1].second)) {
-                ++m;
+        if (remote && this->agent) {
+            try {
+                this->agent->send();
+            } catch (...) {
+                // The connection to the aggregator was lost, so all further
+                // samples are dropped. Remember why such that stop() can
+                // report the loss to the caller.
+                this->write_error = std::current_exception();
+                this->agent.reset();
             }
+        }
 
-            if (m < markers.size()) {
-                this->stream << buffer[i] << delimiter
-                    << markers[m].first << std::endl;
-            } else {
-                this->stream << buffer[i] << delimiter << std::endl;
+        if (have_latest) {
+            // Discard all markers that have been superseded before the
+            // lookback horizon, but retain the one that is active at this
+            // point. The latest sample is not a safe bound, because batched
+            // sensors deliver samples older than the ones from other sensors
+            // that have already been written.
+            const auto it = find_marker(latest - marker_lookback);
+            if (it != markers.begin()) {
+                markers.erase(markers.begin(), it - 1);
+            }
+        }
+    }
+
+    if (this->capture) {
+        try {
+            this->capture->close();
+        } catch (...) {
+            // The capture might lack its index or the last block, which stop()
+            // must report unless there has been an earlier error.
+            if (!this->write_error) {
+                this->write_error = std::current_exception();
+            }
+        }
+
+        this->capture.reset();
+    }
+
+    if (this->output) {
+        try {
+            this->output->close();
+        } catch (...) {
+            // Buffered samples might not have been written, which stop() must
+            // report unless there has been an earlier error.
+            if (!this->write_error) {
+                this->write_error = std::current_exception();
             }
         }
 
-        this->stream.flush();
+        this->stream.rdbuf(nullptr);
+        this->output.reset();
     }
 
-    this->stream.close();
+    this->agent.reset();
 }
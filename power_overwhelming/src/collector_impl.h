@@ -7,19 +7,29 @@
 
 #include <atomic>
 #include <chrono>
-#include <fstream>
+#include <exception>
 #include <memory>
 #include <mutex>
+#include <ostream>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 #if defined(_WIN32)
 #include <Windows.h>
 #endif /* defined(_WIN32) */
 
+#include "power_overwhelming/collector.h"
 #include "power_overwhelming/collector_settings.h"
 #include "power_overwhelming/event.h"
+#include "power_overwhelming/time_synchroniser.h"
+#include "power_overwhelming/timestamp.h"
+
+#include "block_writer.h"
+#include "capture_writer_impl.h"
+#include "collector_agent.h"
+#include "lock_free_queue.h"
 
 
 namespace visus {
@@ -38,15 +48,43 @@ namespace detail {
         typedef std::vector<measurement> buffer_type;
 
         /// <summary>
-        /// Represents a marker in the measurement buffer.
+        /// The type of a registered marker.
+        /// </summary>
+        typedef collector::marker_id_type marker_id_type;
+
+        /// <summary>
+        /// Represents a marker that becomes effective at a specific point in
+        /// time.
         /// </summary>
-        typedef std::pair<std::wstring, std::size_t> marker_type;
+        struct marker_type {
+            timestamp when;
+            marker_id_type id;
+        };
 
         /// <summary>
         /// The type of a marker list.
         /// </summary>
         typedef std::vector<marker_type> marker_list_type;
 
+        /// <summary>
+        /// The type of the queue transporting markers from the threads
+        /// setting them to the I/O thread.
+        /// </summary>
+        typedef lock_free_queue<marker_type, 1024> marker_queue_type;
+
+        /// <summary>
+        /// The time before the latest sample for which the I/O thread retains
+        /// markers in order to assign them to samples delivered late.
+        /// </summary>
+        /// <remarks>
+        /// Sensors like the Tinkerforge bricklets in streaming mode deliver
+        /// their samples in batches, ie after samples with a later timestamp
+        /// from other sensors have already been written. Samples older than
+        /// this horizon receive the marker that was active at the horizon.
+        /// </remarks>
+        static constexpr std::chrono::seconds marker_lookback
+            = std::chrono::seconds(60);
+
         /// <summary>
         /// Processes asynchronously created measurements.
         /// </summary>
@@ -54,11 +92,45 @@ namespace detail {
         /// <param name="context"></param>
         static void on_measurement(const measurement& m, void *context);
 
+        /// <summary>
+        /// The connection to the aggregator if the collector streams its
+        /// samples to a remote machine.
+        /// </summary>
+        std::unique_ptr<collector_agent> agent;
+
+        /// <summary>
+        /// The first error the I/O thread could not handle, which is rethrown
+        /// by <see cref="stop" />.
+        /// </summary>
+        /// <remarks>
+        /// This is either the error that made the I/O thread lose the
+        /// connection to the aggregator or the error that prevented it from
+        /// closing the output files.
+        /// </remarks>
+        std::exception_ptr write_error;
+
+        /// <summary>
+        /// The host name of the aggregator, which is empty if the collector
+        /// writes to <see cref="stream" />.
+        /// </summary>
+        std::wstring aggregator;
+
+        /// <summary>
+        /// The port of the aggregator.
+        /// </summary>
+        std::uint16_t aggregator_port;
+
         /// <summary>
         /// Buffers the measurements until a marker is reached.
         /// </summary>
         buffer_type buffer;
 
+        /// <summary>
+        /// The writer for the output file if the collector writes a capture
+        /// rather than CSV to <see cref="output" />.
+        /// </summary>
+        std::unique_ptr<capture_writer_impl> capture;
+
         /// <summary>
         /// An event to wake the I/O thread.
         /// </summary>
@@ -76,14 +148,42 @@ namespace detail {
 
         /// <summary>
         /// The lock protecting the <see cref="buffer" /> and the
-        /// <see cref="markers" />.
+        /// <see cref="marker_overflow" />.
         /// </summary>
         std::mutex lock;
 
         /// <summary>
-        /// The markers for the current <see cref="buffer" />.
+        /// The lock protecting <see cref="marker_ids" /> and
+        /// <see cref="marker_names" />.
+        /// </summary>
+        std::mutex marker_lock;
+
+        /// <summary>
+        /// Maps registered marker strings to their IDs.
+        /// </summary>
+        std::unordered_map<std::wstring, marker_id_type> marker_ids;
+
+        /// <summary>
+        /// The registered marker strings, indexed by their ID.
+        /// </summary>
+        std::vector<std::wstring> marker_names;
+
+        /// <summary>
+        /// Receives markers if <see cref="markers" /> is full.
+        /// </summary>
+        marker_list_type marker_overflow;
+
+        /// <summary>
+        /// The markers that have been set, but not yet been processed by the
+        /// I/O thread.
+        /// </summary>
+        marker_queue_type markers;
+
+        /// <summary>
+        /// The stream buffer writing the output file in large blocks on a
+        /// separate thread.
         /// </summary>
-        marker_list_type markers;
+        std::unique_ptr<block_writer> output;
 
         /// <summary>
         /// Indicates whether the collector thread should continue running.
@@ -111,9 +211,16 @@ namespace detail {
         std::vector<std::unique_ptr<sensor>> sensors;
 
         /// <summary>
-        /// The output stream for the results.
+        /// An optional synchroniser that transforms the timestamps of the
+        /// samples streamed to the <see cref="aggregator" />.
+        /// </summary>
+        const time_synchroniser *synchroniser;
+
+        /// <summary>
+        /// The stream formatting the results into the blocks of
+        /// <see cref="output" />.
         /// </summary>
-        std::wofstream stream;
+        std::ostream stream;
 
         /// <summary>
         /// The I/O thread executing <see cref="write" />.
@@ -153,6 +260,29 @@ namespace detail {
         /// <param name="marker"></param>
         void marker(const wchar_t *marker);
 
+        /// <summary>
+        /// Inject a marker in the stream that becomes effective for the
+        /// buffered samples at or after <paramref name="when" />.
+        /// </summary>
+        /// <param name="marker"></param>
+        /// <param name="when"></param>
+        void marker(const wchar_t *marker, const timestamp when);
+
+        /// <summary>
+        /// Enqueues the given marker without locking.
+        /// </summary>
+        /// <param name="marker"></param>
+        /// <param name="when"></param>
+        void marker(const marker_id_type marker, const timestamp when);
+
+        /// <summary>
+        /// Registers the given marker string if necessary and returns its
+        /// ID.
+        /// </summary>
+        /// <param name="marker"></param>
+        /// <returns></returns>
+        marker_id_type register_marker(const wchar_t *marker);
+
         /// <summary>
         /// Starts the collector thread if not running.
         /// </summary>
@@ -165,8 +295,14 @@ namespace detail {
 
         /// <summary>
         /// Asynchronously writes data from <see cref="buffer" /> and
-        /// <see cref="markers" /> to <see cref="stream" />.
+        /// <see cref="markers" /> to <see cref="stream" />, the
+        /// <see cref="capture" /> or the <see cref="agent" />.
         /// </summary>
+        /// <remarks>
+        /// Markers are assigned to the samples by their timestamp, ie each
+        /// sample receives the latest marker that became effective at or
+        /// before the time the sample was acquired.
+        /// </remarks>
         void write(void);
     };
 
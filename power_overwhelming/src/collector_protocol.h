@@ -0,0 +1,103 @@
+﻿// <copyright file="collector_protocol.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <type_traits>
+
+#include "power_overwhelming/collector.h"
+#include "power_overwhelming/measurement_data.h"
+#include "power_overwhelming/timestamp.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /*
+     * The collector agents stream their samples as a sequence of messages over
+     * a TCP connection to the aggregator. Each message starts with a
+     * colmsg_header, which is followed by the number of payload bytes given in
+     * the header. All data are in the native byte order of the agent, which
+     * we assume to be the same on all machines of a cluster.
+     */
+
+    /// <summary>
+    /// Identifies the type of a message from a collector agent.
+    /// </summary>
+    enum class colmsg_id : std::uint32_t {
+
+        /// <summary>
+        /// The first message of a connection, which carries the name of the
+        /// node as UTF-8 string.
+        /// </summary>
+        hello = 0x0001,
+
+        /// <summary>
+        /// Associates a sensor ID with the name of the sensor. The payload is
+        /// a <see cref="colmsg_name" /> followed by the UTF-8 name.
+        /// </summary>
+        sensor = 0x0002,
+
+        /// <summary>
+        /// Associates a marker ID with the name of the marker. The payload is
+        /// a <see cref="colmsg_name" /> followed by the UTF-8 name.
+        /// </summary>
+        marker = 0x0003,
+
+        /// <summary>
+        /// A batch of <see cref="colmsg_sample" />s.
+        /// </summary>
+        samples = 0x0004
+    };
+
+    /// <summary>
+    /// The header of each message from a collector agent.
+    /// </summary>
+    struct colmsg_header {
+        colmsg_id id;
+        std::uint32_t size;
+    };
+
+    /// <summary>
+    /// Precedes the name in <see cref="colmsg_id::sensor" /> and
+    /// <see cref="colmsg_id::marker" /> messages.
+    /// </summary>
+    struct colmsg_name {
+        std::uint32_t id;
+    };
+
+    /// <summary>
+    /// The wire format of a single sample.
+    /// </summary>
+    struct colmsg_sample {
+        typedef power_overwhelming::timestamp::value_type timestamp_type;
+        typedef measurement_data::value_type value_type;
+
+        timestamp_type timestamp;
+        std::uint32_t sensor;
+        collector::marker_id_type marker;
+        value_type voltage;
+        value_type current;
+        value_type power;
+        std::uint32_t reserved;
+    };
+
+    static_assert(std::is_trivially_copyable<colmsg_sample>::value,
+        "colmsg_sample must be transferrable via memcpy.");
+    static_assert(sizeof(colmsg_sample) == 32, "colmsg_sample must not "
+        "contain padding.");
+
+    /// <summary>
+    /// The upper limit for the payload of a message, which the aggregator uses
+    /// to reject garbage.
+    /// </summary>
+    constexpr std::uint32_t colmsg_max_size = 64 * 1024 * 1024;
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
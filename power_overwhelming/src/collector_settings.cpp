@@ -1,5 +1,5 @@
 ﻿// <copyright file="collector_settings.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
-// Copyright © 2023 Visualisierungsinstitut der Universität Stuttgart.
+// Copyright © 2023 - 2024 Visualisierungsinstitut der Universität Stuttgart.
 // Licensed under the MIT licence. See LICENCE file for details.
 // </copyright>
 // <author>Christoph Müller</author>
@@ -11,6 +11,20 @@
 #include "string_functions.h"
 
 
+/*
+ * ...::collector_settings::default_aggregator_port
+ */
+constexpr std::uint16_t
+visus::power_overwhelming::collector_settings::default_aggregator_port;
+
+
+/*
+ * ...::collector_settings::default_output_block_size
+ */
+constexpr std::size_t
+visus::power_overwhelming::collector_settings::default_output_block_size;
+
+
 /*
  * visus::power_overwhelming::collector_settings::default_output_path
  */
@@ -22,7 +36,14 @@ constexpr const wchar_t *visus::power_overwhelming::collector_settings
  * visus::power_overwhelming::collector_settings::collector_settings
  */
 visus::power_overwhelming::collector_settings::collector_settings(void)
-        : _output_path(nullptr), _sampling_interval(default_sampling_interval) {
+        : _aggregator(nullptr), _aggregator_port(default_aggregator_port),
+        _capture_compression(power_overwhelming::capture_compression::none),
+        _direct_io(false), _discovery_cache(nullptr),
+        _output_block_size(default_output_block_size),
+        _output_format(power_overwhelming::output_format::csv),
+        _output_path(nullptr),
+        _sampling_interval(default_sampling_interval),
+        _sync_policy(output_sync_policy::none), _time_synchroniser(nullptr) {
     this->output_path(default_output_path);
 }
 
@@ -31,7 +52,9 @@ visus::power_overwhelming::collector_settings::collector_settings(void)
  * visus::power_overwhelming::collector_settings::collector_settings
  */
 visus::power_overwhelming::collector_settings::collector_settings(
-        _In_ const collector_settings& rhs) : _output_path(nullptr) {
+        _In_ const collector_settings& rhs)
+        : _aggregator(nullptr), _discovery_cache(nullptr),
+        _output_path(nullptr) {
     *this = rhs;
 }
 
@@ -40,12 +63,88 @@ visus::power_overwhelming::collector_settings::collector_settings(
  * visus::power_overwhelming::collector_settings::~collector_settings
  */
 visus::power_overwhelming::collector_settings::~collector_settings(void) {
+    detail::safe_assign(this->_aggregator, nullptr);
+    detail::safe_assign(this->_discovery_cache, nullptr);
+
     if (this->_output_path != nullptr) {
         ::free(this->_output_path);
     }
 }
 
 
+/*
+ * visus::power_overwhelming::collector_settings::aggregator
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::aggregator(
+        _In_opt_z_ const wchar_t *host,
+        _In_ const std::uint16_t port) {
+    detail::safe_assign(this->_aggregator, host);
+    this->_aggregator_port = port;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::capture_compression
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::capture_compression(
+        _In_ const power_overwhelming::capture_compression compression)
+        noexcept {
+    this->_capture_compression = compression;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::direct_io
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::direct_io(
+        _In_ const bool enable) noexcept {
+    this->_direct_io = enable;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::discovery_cache
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::discovery_cache(
+        _In_opt_z_ const wchar_t *path) {
+    detail::safe_assign(this->_discovery_cache, path);
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::output_block_size
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::output_block_size(
+        _In_ const std::size_t size) {
+    if (size == 0) {
+        throw std::invalid_argument("The output block size must be positive.");
+    }
+
+    this->_output_block_size = size;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::output_format
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::output_format(
+        _In_ const power_overwhelming::output_format format) noexcept {
+    this->_output_format = format;
+    return *this;
+}
+
+
 /*
  * visus::power_overwhelming::collector_settings::output_path
  */
@@ -73,6 +172,29 @@ visus::power_overwhelming::collector_settings::sampling_interval(
 }
 
 
+/*
+ * visus::power_overwhelming::collector_settings::sync_policy
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::sync_policy(
+        _In_ const output_sync_policy policy) noexcept {
+    this->_sync_policy = policy;
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::collector_settings::time_synchroniser
+ */
+visus::power_overwhelming::collector_settings&
+visus::power_overwhelming::collector_settings::time_synchroniser(
+        _In_opt_ const power_overwhelming::time_synchroniser *synchroniser)
+        noexcept {
+    this->_time_synchroniser = synchroniser;
+    return *this;
+}
+
+
 /*
  * visus::power_overwhelming::collector_settings::operator =
  */
@@ -80,8 +202,16 @@ visus::power_overwhelming::collector_settings&
 visus::power_overwhelming::collector_settings::operator =(
         _In_ const collector_settings& rhs) {
     if (this != std::addressof(rhs)) {
+        this->aggregator(rhs._aggregator, rhs._aggregator_port);
+        this->capture_compression(rhs._capture_compression);
+        this->direct_io(rhs._direct_io);
+        this->discovery_cache(rhs._discovery_cache);
+        this->output_block_size(rhs._output_block_size);
+        this->output_format(rhs._output_format);
         this->output_path(rhs._output_path);
         this->sampling_interval(rhs._sampling_interval);
+        this->sync_policy(rhs._sync_policy);
+        this->time_synchroniser(rhs._time_synchroniser);
     }
 
     return *this;
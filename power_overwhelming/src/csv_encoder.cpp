@@ -0,0 +1,169 @@
+﻿// <copyright file="csv_encoder.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/csv_encoder.h"
+
+#include <cassert>
+#include <charconv>
+#include <cstring>
+#include <string>
+
+#include "power_overwhelming/convert_string.h"
+#include "power_overwhelming/measurement.h"
+
+
+namespace {
+
+    /// <summary>
+    /// Encodes the numeric fields of a sample with an explicitly given
+    /// validity flag.
+    /// </summary>
+    std::size_t encode_data(
+            _Out_writes_(visus::power_overwhelming::csv_encoder::max_data_size)
+            char *dst,
+            _In_ const visus::power_overwhelming::measurement_data& data,
+            _In_ const bool valid,
+            _In_ const char delimiter) noexcept {
+        using visus::power_overwhelming::csv_encoder;
+        auto cur = dst;
+
+        cur += csv_encoder::encode(cur, data.timestamp().value());
+        *cur++ = delimiter;
+        *cur++ = valid ? '1' : '0';
+        *cur++ = delimiter;
+        cur += csv_encoder::encode(cur, data.voltage());
+        *cur++ = delimiter;
+        cur += csv_encoder::encode(cur, data.current());
+        *cur++ = delimiter;
+        cur += csv_encoder::encode(cur, data.power());
+
+        assert(cur <= dst + csv_encoder::max_data_size);
+        return static_cast<std::size_t>(cur - dst);
+    }
+
+}
+
+
+/*
+ * visus::power_overwhelming::csv_encoder::encode
+ */
+std::size_t visus::power_overwhelming::csv_encoder::encode(
+        _Out_writes_(max_value_size) char_type *dst,
+        _In_ const float value) noexcept {
+    assert(dst != nullptr);
+    const auto r = std::to_chars(dst, dst + max_value_size, value);
+    assert(r.ec == std::errc());
+    return static_cast<std::size_t>(r.ptr - dst);
+}
+
+
+/*
+ * visus::power_overwhelming::csv_encoder::encode
+ */
+std::size_t visus::power_overwhelming::csv_encoder::encode(
+        _Out_writes_(max_value_size) char_type *dst,
+        _In_ const std::int64_t value) noexcept {
+    assert(dst != nullptr);
+    const auto r = std::to_chars(dst, dst + max_value_size, value);
+    assert(r.ec == std::errc());
+    return static_cast<std::size_t>(r.ptr - dst);
+}
+
+
+/*
+ * visus::power_overwhelming::csv_encoder::csv_encoder
+ */
+visus::power_overwhelming::csv_encoder::csv_encoder(
+        _In_ const char_type delimiter,
+        _In_ const char_type quote) noexcept
+    : _delimiter(delimiter), _quote(quote) { }
+
+
+/*
+ * visus::power_overwhelming::csv_encoder::encode
+ */
+std::size_t visus::power_overwhelming::csv_encoder::encode(
+        _Out_writes_(max_data_size) char_type *dst,
+        _In_ const measurement_data& data) const noexcept {
+    assert(dst != nullptr);
+    return encode_data(dst, data, static_cast<bool>(data), this->_delimiter);
+}
+
+
+/*
+ * visus::power_overwhelming::csv_encoder::encode
+ */
+std::size_t visus::power_overwhelming::csv_encoder::encode(
+        _Out_writes_opt_(cnt) char_type *dst,
+        _In_ const std::size_t cnt,
+        _In_ const measurement& measurement) const {
+    const char_type *sensor = nullptr;
+    std::size_t sensor_cnt = 0;
+    std::string converted;
+
+    if (measurement.sensor() != nullptr) {
+        // Sensor names are typically ASCII, in which case we can narrow them
+        // in place rather than allocating a converted string.
+        auto ascii = true;
+        auto s = measurement.sensor();
+        for (; s[sensor_cnt] != 0; ++sensor_cnt) {
+            ascii = ascii && (static_cast<std::uint32_t>(s[sensor_cnt]) < 0x80);
+        }
+
+        if (!ascii) {
+            converted = power_overwhelming::convert_string<char_type>(s);
+            sensor = converted.c_str();
+            sensor_cnt = converted.size();
+        }
+    }
+
+    char_type data[max_data_size];
+    const auto data_cnt = encode_data(data, measurement.data(),
+        static_cast<bool>(measurement), this->_delimiter);
+    const auto quote_cnt = (this->_quote != 0) ? 2 : 0;
+    const auto retval = quote_cnt + sensor_cnt + 1 + data_cnt;
+
+    if ((dst != nullptr) && (cnt >= retval)) {
+        auto cur = dst;
+
+        if (this->_quote != 0) {
+            *cur++ = this->_quote;
+        }
+
+        if (sensor != nullptr) {
+            ::memcpy(cur, sensor, sensor_cnt * sizeof(char_type));
+            cur += sensor_cnt;
+        } else {
+            auto s = measurement.sensor();
+            for (std::size_t i = 0; i < sensor_cnt; ++i) {
+                *cur++ = static_cast<char_type>(s[i]);
+            }
+        }
+
+        if (this->_quote != 0) {
+            *cur++ = this->_quote;
+        }
+
+        *cur++ = this->_delimiter;
+        ::memcpy(cur, data, data_cnt * sizeof(char_type));
+        cur += data_cnt;
+        assert(cur == dst + retval);
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::csv_encoder::max_data_size
+ */
+constexpr std::size_t visus::power_overwhelming::csv_encoder::max_data_size;
+
+
+/*
+ * visus::power_overwhelming::csv_encoder::max_value_size
+ */
+constexpr std::size_t visus::power_overwhelming::csv_encoder::max_value_size;
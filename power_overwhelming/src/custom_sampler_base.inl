@@ -73,8 +73,8 @@ void visus::power_overwhelming::detail::custom_sampler_base<TDerived, TKey,
     } else {
         // This is an existing group, so the sampling interval must match.
         if (group->interval.count() != sensor->async_sampling.interval()) {
-            throw std::invalid_argument("All sensors using the same RTA/RB "
-                "instrument must be sampled at the same rate.");
+            throw std::invalid_argument("All sensors sampled by the same "
+                "thread must be sampled at the same rate.");
         }
 
         std::lock_guard<decltype(group->lock)> l(group->lock);
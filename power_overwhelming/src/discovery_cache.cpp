@@ -0,0 +1,180 @@
+﻿// <copyright file="discovery_cache.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "discovery_cache.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#include <cfgmgr32.h>
+#include <SetupAPI.h>
+
+#pragma comment(lib, "Setupapi.lib")
+#endif /* defined(_WIN32) */
+
+#include "power_overwhelming/computer_name.h"
+#include "power_overwhelming/cpu_info.h"
+
+#include "on_exit.h"
+#include "sensor_utilities.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    static constexpr const char *field_cpu = "cpu";
+    static constexpr const char *field_created = "created";
+    static constexpr const char *field_fingerprint = "fingerprint";
+    static constexpr const char *field_machine = "machine";
+    static constexpr const char *field_pci = "pci";
+    static constexpr const char *field_processors = "processors";
+    static constexpr const char *field_sensors = "sensors";
+
+    /// <summary>
+    /// Gets the bus IDs of all PCI devices on the system in a stable order.
+    /// </summary>
+    static std::vector<std::string> get_pci_devices(void) {
+        std::vector<std::string> retval;
+
+#if defined(_WIN32)
+        auto devs = ::SetupDiGetClassDevsA(nullptr, "PCI", NULL,
+            DIGCF_ALLCLASSES | DIGCF_PRESENT);
+        if (devs == INVALID_HANDLE_VALUE) {
+            return retval;
+        }
+
+        auto guard = on_exit([devs](void) {
+            ::SetupDiDestroyDeviceInfoList(devs);
+        });
+
+        SP_DEVINFO_DATA info;
+        ::ZeroMemory(&info, sizeof(info));
+        info.cbSize = sizeof(info);
+
+        for (DWORD i = 0; ::SetupDiEnumDeviceInfo(devs, i, &info); ++i) {
+            char id[MAX_DEVICE_ID_LEN];
+            if (::SetupDiGetDeviceInstanceIdA(devs, &info, id, sizeof(id),
+                    nullptr)) {
+                retval.emplace_back(id);
+            }
+        }
+
+#else /* defined(_WIN32) */
+        namespace fs = std::filesystem;
+
+        // A missing directory just means that there are no PCI devices we can
+        // see, which is not an error.
+        std::error_code ec;
+        for (fs::directory_iterator it("/sys/bus/pci/devices", ec), end;
+                !ec && (it != end); it.increment(ec)) {
+            retval.push_back(it->path().filename().generic_string());
+        }
+#endif /* defined(_WIN32) */
+
+        std::sort(retval.begin(), retval.end());
+        return retval;
+    }
+
+    /// <summary>
+    /// Answer the current time in seconds since the epoch.
+    /// </summary>
+    static inline std::int64_t seconds_since_epoch(void) {
+        using namespace std::chrono;
+        return duration_cast<seconds>(
+            system_clock::now().time_since_epoch()).count();
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::detail::get_all_sensors_cached
+ */
+std::vector<std::unique_ptr<visus::power_overwhelming::sensor>>
+visus::power_overwhelming::detail::get_all_sensors_cached(
+        const wchar_t *path) {
+    using namespace std::chrono;
+    const auto fingerprint = get_hardware_fingerprint();
+    const auto now = seconds_since_epoch();
+
+    try {
+        const auto cache = read_json(path);
+        const auto created = cache.at(field_created).get<std::int64_t>();
+        const auto age = seconds(now - created);
+
+        if ((cache.at(field_fingerprint) == fingerprint)
+                && (age >= seconds::zero())
+                && (age < discovery_cache_lifetime)) {
+            // Note: This throws if any of the sensors has vanished, in which
+            // case we rediscover all of them.
+            return parse_sensors(cache.at(field_sensors));
+        }
+    } catch (...) {
+        // The cache is missing, corrupt or describes sensors that are not
+        // available anymore, so we need a full enumeration.
+    }
+
+    auto descs = nlohmann::json::array();
+    auto retval = get_all_sensors(descs);
+
+    try {
+        nlohmann::json cache;
+        cache[field_fingerprint] = fingerprint;
+        cache[field_created] = now;
+        cache[field_sensors] = std::move(descs);
+        write_json(path, cache);
+    } catch (...) {
+        // The cache is only an optimisation, so we do not care if it cannot
+        // be written.
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::get_hardware_fingerprint
+ */
+nlohmann::json visus::power_overwhelming::detail::get_hardware_fingerprint(
+        void) {
+    nlohmann::json retval;
+
+    retval[field_machine] = computer_name<char>();
+    retval[field_processors] = std::thread::hardware_concurrency();
+
+    {
+        auto cpu = nlohmann::json::array();
+        cpu_info infos[2];
+        const auto cnt = get_cpu_info(infos, 2);
+
+        if (cnt > 0) {
+            cpu.push_back(static_cast<int>(extract_cpu_vendor(infos[0])));
+        }
+
+        if (cnt > 1) {
+            const auto model = extract_cpu_model(infos);
+            cpu.push_back(model.base_family);
+            cpu.push_back(model.extended_family);
+            cpu.push_back(model.base_model);
+            cpu.push_back(model.extended_model);
+            cpu.push_back(model.stepping);
+        }
+
+        retval[field_cpu] = std::move(cpu);
+    }
+
+    retval[field_pci] = get_pci_devices();
+
+    return retval;
+}
@@ -0,0 +1,61 @@
+﻿// <copyright file="discovery_cache.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "power_overwhelming/sensor.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The time after which a discovery cache is considered stale even if the
+    /// hardware fingerprint did not change.
+    /// </summary>
+    constexpr std::chrono::hours discovery_cache_lifetime(24);
+
+    /// <summary>
+    /// Gets all sensors available on the current machine, preferring the
+    /// descriptors from the discovery cache at <paramref name="path" /> over
+    /// a full enumeration.
+    /// </summary>
+    /// <remarks>
+    /// <para>The cache is used if it exists, its hardware fingerprint matches
+    /// <see cref="get_hardware_fingerprint" />, it is not older than
+    /// <see cref="discovery_cache_lifetime" /> and all of the sensors therein
+    /// can be instantiated. Otherwise, all sensors are enumerated and the
+    /// cache is rewritten.</para>
+    /// <para>The cache is only an optimisation, so failing to write it is not
+    /// an error.</para>
+    /// </remarks>
+    /// <param name="path">The path to the cache file.</param>
+    /// <returns>A list of all sensors we know on this system.</returns>
+    std::vector<std::unique_ptr<sensor>> get_all_sensors_cached(
+        const wchar_t *path);
+
+    /// <summary>
+    /// Computes a cheap fingerprint of the hardware of the current machine,
+    /// which allows for detecting whether a discovery cache is still valid.
+    /// </summary>
+    /// <remarks>
+    /// The fingerprint comprises the name of the machine, the CPU vendor and
+    /// model, the number of logical processors and the bus IDs of all PCI
+    /// devices.
+    /// </remarks>
+    /// <returns>A JSON object describing the hardware.</returns>
+    nlohmann::json get_hardware_fingerprint(void);
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
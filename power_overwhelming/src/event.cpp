@@ -1,28 +1,48 @@
 ﻿// <copyright file="event.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
-// Copyright © 2018 - 2023 Visualisierungsinstitut der Universität Stuttgart.
+// Copyright © 2018 - 2024 Visualisierungsinstitut der Universität Stuttgart.
 // Licensed under the MIT licence. See LICENCE file for details.
 // </copyright>
 // <author>Christoph Müller</author>
 
 #include "power_overwhelming/event.h"
 
+#include <algorithm>
 #include <cassert>
-#include <condition_variable>
-#include <mutex>
+#include <chrono>
+#include <cinttypes>
+#include <stdexcept>
 #include <system_error>
+#include <vector>
 
 #include <errno.h>
 
+#if defined(POWER_OVERWHELMING_EVENT_EMULATION)
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#endif /* defined(POWER_OVERWHELMING_EVENT_EMULATION) */
 
+
+#if defined(POWER_OVERWHELMING_EVENT_EMULATION)
 namespace visus {
 namespace power_overwhelming {
 namespace detail {
 
+    /// <summary>
+    /// The Linux implementation of an event, which is based on a non-blocking
+    /// <c>eventfd</c>.
+    /// </summary>
+    /// <remarks>
+    /// The event is signalled while the counter of the <c>eventfd</c> is
+    /// non-zero, ie while the descriptor is readable. Auto-reset events are
+    /// reset by the waiter that successfully reads the counter, whereas
+    /// manual reset events are only drained in <see cref="reset_event" />.
+    /// This way, waiting and signalling do not require any user-space lock
+    /// and the descriptor can be used in <c>poll</c> or <c>epoll</c>.
+    /// </remarks>
     struct event_impl {
-        std::condition_variable condition;
-        std::mutex mutex;
+        int fd;
         bool manual_reset;
-        bool signalled;
     };
 
 } /* namespace detail */
@@ -30,6 +50,173 @@ namespace detail {
 } /* namespace visus */
 
 
+namespace {
+
+    typedef std::chrono::steady_clock clock_type;
+
+    /// <summary>
+    /// Tries to reset an auto-reset event after it has been reported to be
+    /// readable.
+    /// </summary>
+    /// <returns><c>true</c> if the calling thread obtained the signal,
+    /// <c>false</c> if another waiter was faster.</returns>
+    bool consume(visus::power_overwhelming::event_type event) {
+        assert(event != nullptr);
+        if (event->manual_reset) {
+            return true;
+        }
+
+        std::uint64_t value;
+        if (::read(event->fd, &value, sizeof(value)) == sizeof(value)) {
+            return true;
+        }
+
+        auto error = errno;
+        if (error == EAGAIN) {
+            return false;
+        } else {
+            throw std::system_error(error, std::system_category());
+        }
+    }
+
+    /// <summary>
+    /// Signals the given <c>eventfd</c>.
+    /// </summary>
+    void signal_eventfd(const int fd) {
+        const std::uint64_t value = 1;
+        if (::write(fd, &value, sizeof(value)) != sizeof(value)) {
+            auto error = errno;
+            if (error != EAGAIN) {
+                // EAGAIN means the counter is saturated, in which case the
+                // event is signalled anyway.
+                throw std::system_error(error, std::system_category());
+            }
+        }
+    }
+
+    /// <summary>
+    /// Waits for the given descriptors to become readable.
+    /// </summary>
+    /// <returns>The number of descriptors that became readable, which is zero
+    /// if the operation timed out.</returns>
+    int poll_for(pollfd *fds, const std::size_t cnt, const bool infinite,
+            const clock_type::time_point deadline) {
+        using namespace std::chrono;
+        assert(fds != nullptr);
+
+        while (true) {
+            auto timeout = -1;
+            if (!infinite) {
+                auto dt = duration_cast<milliseconds>(deadline
+                    - clock_type::now()).count();
+                timeout = static_cast<int>((std::max)(dt,
+                    static_cast<decltype(dt)>(0)));
+            }
+
+            auto retval = ::poll(fds, static_cast<nfds_t>(cnt), timeout);
+            if (retval >= 0) {
+                return retval;
+            }
+
+            auto error = errno;
+            if (error != EINTR) {
+                throw std::system_error(error, std::system_category());
+            }
+        }
+    }
+
+    /// <summary>
+    /// Implements all wait operations on Linux.
+    /// </summary>
+    std::size_t wait_events(
+            const visus::power_overwhelming::event_type *events,
+            pollfd *fds,
+            const std::size_t cnt,
+            const bool wait_all,
+            const bool infinite,
+            const unsigned int timeout) {
+        assert(events != nullptr);
+        assert(fds != nullptr);
+        const auto deadline = clock_type::now()
+            + std::chrono::milliseconds(timeout);
+
+        for (std::size_t i = 0; i < cnt; ++i) {
+            if (events[i] == nullptr) {
+                throw std::system_error(EINVAL, std::system_category());
+            }
+
+            fds[i].fd = events[i]->fd;
+            fds[i].events = POLLIN;
+            fds[i].revents = 0;
+        }
+
+        if (!wait_all) {
+            while (true) {
+                if (poll_for(fds, cnt, infinite, deadline) == 0) {
+                    return cnt;
+                }
+
+                for (std::size_t i = 0; i < cnt; ++i) {
+                    if (((fds[i].revents & POLLIN) != 0)
+                            && consume(events[i])) {
+                        return i;
+                    }
+                }
+                // If we get here, other waiters reset all auto-reset events
+                // before we could, so we need to wait again.
+            }
+
+        } else {
+            while (true) {
+                // Wait until all events have been observed readable. Poll
+                // ignores negative descriptors, so we can exclude the ones
+                // we have already seen by inverting them.
+                std::size_t ready = 0;
+                while (ready < cnt) {
+                    if (poll_for(fds, cnt, infinite, deadline) == 0) {
+                        return cnt;
+                    }
+
+                    for (std::size_t i = 0; i < cnt; ++i) {
+                        if ((fds[i].fd >= 0) && (fds[i].revents & POLLIN)) {
+                            fds[i].fd = ~fds[i].fd;
+                            ++ready;
+                        }
+                    }
+                }
+
+                // Reset all auto-reset events at once. If another waiter
+                // obtained one of them in the meantime, give back the ones
+                // we already have and start over.
+                std::size_t consumed = 0;
+                for (; consumed < cnt; ++consumed) {
+                    if (!consume(events[consumed])) {
+                        break;
+                    }
+                }
+
+                if (consumed == cnt) {
+                    return 0;
+                }
+
+                for (std::size_t i = 0; i < consumed; ++i) {
+                    if (!events[i]->manual_reset) {
+                        signal_eventfd(events[i]->fd);
+                    }
+                }
+
+                for (std::size_t i = 0; i < cnt; ++i) {
+                    fds[i].fd = events[i]->fd;
+                    fds[i].revents = 0;
+                }
+            }
+        }
+    }
+
+}
+#endif /* defined(POWER_OVERWHELMING_EVENT_EMULATION) */
+
+
 /*
  * visus::power_overwhelming::create_event
  */
@@ -37,16 +224,21 @@ _Ret_valid_ visus::power_overwhelming::event_type
 visus::power_overwhelming::create_event(_In_ const bool manual_reset,
         _In_ const bool initially_signalled) {
 #if defined(POWER_OVERWHELMING_EVENT_EMULATION)
-    auto retval = new detail::event_impl;
-
-    retval->manual_reset = manual_reset;
-    retval->signalled = false;
-
-    if (initially_signalled) {
-        set_event(retval);
+    auto fd = ::eventfd(initially_signalled ? 1 : 0,
+        EFD_CLOEXEC | EFD_NONBLOCK);
+    if (fd == -1) {
+        throw std::system_error(errno, std::system_category());
     }
 
-    return retval;
+    try {
+        auto retval = new detail::event_impl;
+        retval->fd = fd;
+        retval->manual_reset = manual_reset;
+        return retval;
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
 
 #else /* defined(POWER_OVERWHELMING_EVENT_EMULATION) */
     auto retval = ::CreateEvent(nullptr, manual_reset, initially_signalled,
@@ -66,7 +258,10 @@ visus::power_overwhelming::create_event(_In_ const bool manual_reset,
  */
 void visus::power_overwhelming::destroy_event(_Inout_opt_ event_type& event) {
 #if defined(POWER_OVERWHELMING_EVENT_EMULATION)
-    delete event;
+    if (event != nullptr) {
+        ::close(event->fd);
+        delete event;
+    }
     event = nullptr;
 
 #else /* defined(POWER_OVERWHELMING_EVENT_EMULATION) */
@@ -76,6 +271,28 @@ void visus::power_overwhelming::destroy_event(_Inout_opt_ event_type& event) {
 }
 
 
+/*
+ * visus::power_overwhelming::get_event_native_handle
+ */
+visus::power_overwhelming::event_native_handle_type
+visus::power_overwhelming::get_event_native_handle(_In_ event_type event) {
+#if defined(POWER_OVERWHELMING_EVENT_EMULATION)
+    if (event == nullptr) {
+        throw std::system_error(EINVAL, std::system_category());
+    }
+
+    return event->fd;
+
+#else /* defined(POWER_OVERWHELMING_EVENT_EMULATION) */
+    if (event == NULL) {
+        throw std::system_error(ERROR_INVALID_HANDLE, std::system_category());
+    }
+
+    return event;
+#endif /* defined(POWER_OVERWHELMING_EVENT_EMULATION) */
+}
+
+
 /*
  * visus::power_overwhelming::reset_event
  */
@@ -85,8 +302,14 @@ void visus::power_overwhelming::reset_event(_In_ event_type event) {
         throw std::system_error(EINVAL, std::system_category());
     }
 
-    std::unique_lock<decltype(event->mutex)> lock(event->mutex);
-    event->signalled = false;
+    std::uint64_t value;
+    if (::read(event->fd, &value, sizeof(value)) != sizeof(value)) {
+        auto error = errno;
+        if (error != EAGAIN) {
+            // EAGAIN means that the event is not signalled in the first place.
+            throw std::system_error(error, std::system_category());
+        }
+    }
 
 #else /* defined(POWER_OVERWHELMING_EVENT_EMULATION) */
     if (!::ResetEvent(event)) {
@@ -106,16 +329,7 @@ void visus::power_overwhelming::set_event(_In_ event_type event) {
         throw std::system_error(EINVAL, std::system_category());
     }
 
-    std::unique_lock<decltype(event->mutex)> lock(event->mutex);
-    event->signalled = true;
-
-    if (event->manual_reset) {
-        // In case of a manual reset event, signal one thread.
-        event->condition.notify_one();
-    } else {
-        // In case of an auto reset event, signal all threads.
-        event->condition.notify_all();
-    }
+    signal_eventfd(event->fd);
 
 #else /* defined(POWER_OVERWHELMING_EVENT_EMULATION) */
     if (!::SetEvent(event)) {
@@ -131,17 +345,9 @@ void visus::power_overwhelming::set_event(_In_ event_type event) {
  */
 void visus::power_overwhelming::wait_event(_In_ event_type event) {
 #if defined(POWER_OVERWHELMING_EVENT_EMULATION)
-    if (event == nullptr) {
-        throw std::system_error(EINVAL, std::system_category());
-    }
-
-    std::unique_lock<decltype(event->mutex)> lock(event->mutex);
-    event->condition.wait(lock, [event]() { return event->signalled; });
-
-    if (!event->manual_reset) {
-        // In case of an auto reset event, reset it now.
-        event->signalled = false;
-    }
+    pollfd fd;
+    auto retval = ::wait_events(&event, &fd, 1, false, true, 0);
+    assert(retval == 0);
 
 #else /* defined(POWER_OVERWHELMING_EVENT_EMULATION) */
     switch (::WaitForSingleObject(event, INFINITE)) {
@@ -166,23 +372,8 @@ void visus::power_overwhelming::wait_event(_In_ event_type event) {
 bool visus::power_overwhelming::wait_event(_In_ event_type event,
         _In_ const unsigned int timeout) {
 #if defined(POWER_OVERWHELMING_EVENT_EMULATION)
-    if (event == nullptr) {
-        throw std::system_error(EINVAL, std::system_category());
-    }
-
-    const auto dt = std::chrono::milliseconds(timeout);
-
-    std::unique_lock<decltype(event->mutex)> lock(event->mutex);
-
-    auto retval = event->condition.wait_for(lock, dt,
-        [event]() { return event->signalled; });
-
-    if (retval && !event->manual_reset) {
-        // In case of an auto reset event, reset it now.
-        event->signalled = false;
-    }
-
-    return retval;
+    pollfd fd;
+    return (::wait_events(&event, &fd, 1, false, false, timeout) == 0);
 
 #else /* defined(POWER_OVERWHELMING_EVENT_EMULATION) */
     auto retval = ::WaitForSingleObject(event, timeout);
@@ -200,3 +391,73 @@ bool visus::power_overwhelming::wait_event(_In_ event_type event,
     }
 #endif /* defined(POWER_OVERWHELMING_EVENT_EMULATION) */
 }
+
+
+/*
+ * visus::power_overwhelming::wait_events
+ */
+std::size_t visus::power_overwhelming::wait_events(
+        _In_reads_(cnt) const event_type *events,
+        _In_ const std::size_t cnt,
+        _In_ const bool wait_all) {
+#if defined(POWER_OVERWHELMING_EVENT_EMULATION)
+    if (events == nullptr) {
+        throw std::invalid_argument("The events to wait for must be valid.");
+    }
+    if (cnt < 1) {
+        throw std::invalid_argument("At least one event must be specified.");
+    }
+
+    std::vector<pollfd> fds(cnt);
+    auto retval = ::wait_events(events, fds.data(), cnt, wait_all, true, 0);
+    assert(retval < cnt);
+    return retval;
+
+#else /* defined(POWER_OVERWHELMING_EVENT_EMULATION) */
+    return wait_events(events, cnt, wait_all, INFINITE);
+#endif /* defined(POWER_OVERWHELMING_EVENT_EMULATION) */
+}
+
+
+/*
+ * visus::power_overwhelming::wait_events
+ */
+std::size_t visus::power_overwhelming::wait_events(
+        _In_reads_(cnt) const event_type *events,
+        _In_ const std::size_t cnt,
+        _In_ const bool wait_all,
+        _In_ const unsigned int timeout) {
+    if (events == nullptr) {
+        throw std::invalid_argument("The events to wait for must be valid.");
+    }
+    if (cnt < 1) {
+        throw std::invalid_argument("At least one event must be specified.");
+    }
+
+#if defined(POWER_OVERWHELMING_EVENT_EMULATION)
+    std::vector<pollfd> fds(cnt);
+    return ::wait_events(events, fds.data(), cnt, wait_all, false, timeout);
+
+#else /* defined(POWER_OVERWHELMING_EVENT_EMULATION) */
+    if (cnt > MAXIMUM_WAIT_OBJECTS) {
+        throw std::invalid_argument("Too many events were specified.");
+    }
+
+    auto retval = ::WaitForMultipleObjects(static_cast<DWORD>(cnt), events,
+        wait_all ? TRUE : FALSE, timeout);
+
+    if ((retval >= WAIT_OBJECT_0) && (retval < WAIT_OBJECT_0 + cnt)) {
+        return wait_all ? 0 : (retval - WAIT_OBJECT_0);
+    }
+
+    if ((retval >= WAIT_ABANDONED_0) && (retval < WAIT_ABANDONED_0 + cnt)) {
+        return wait_all ? 0 : (retval - WAIT_ABANDONED_0);
+    }
+
+    if (retval == WAIT_TIMEOUT) {
+        return cnt;
+    }
+
+    throw std::system_error(::GetLastError(), std::system_category());
+#endif /* defined(POWER_OVERWHELMING_EVENT_EMULATION) */
+}
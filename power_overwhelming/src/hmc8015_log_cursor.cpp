@@ -0,0 +1,97 @@
+﻿// <copyright file="hmc8015_log_cursor.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/hmc8015_log_cursor.h"
+
+#include <memory>
+#include <stdexcept>
+
+#include "hmc8015_log_cursor_impl.h"
+
+
+/*
+ * visus::power_overwhelming::hmc8015_log_cursor::hmc8015_log_cursor
+ */
+visus::power_overwhelming::hmc8015_log_cursor::hmc8015_log_cursor(void)
+    : _impl(new detail::hmc8015_log_cursor_impl()) { }
+
+
+/*
+ * visus::power_overwhelming::hmc8015_log_cursor::~hmc8015_log_cursor
+ */
+visus::power_overwhelming::hmc8015_log_cursor::~hmc8015_log_cursor(void) {
+    delete this->_impl;
+}
+
+
+/*
+ * visus::power_overwhelming::hmc8015_log_cursor::clock_offset
+ */
+visus::power_overwhelming::timestamp::value_type
+visus::power_overwhelming::hmc8015_log_cursor::clock_offset(void) const {
+    auto& impl = this->check_not_disposed();
+    return impl.clock_valid ? impl.clock_offset : 0;
+}
+
+
+/*
+ * visus::power_overwhelming::hmc8015_log_cursor::offset
+ */
+std::uint64_t visus::power_overwhelming::hmc8015_log_cursor::offset(
+        void) const {
+    return this->check_not_disposed().parser.offset();
+}
+
+
+/*
+ * visus::power_overwhelming::hmc8015_log_cursor::reset
+ */
+visus::power_overwhelming::hmc8015_log_cursor&
+visus::power_overwhelming::hmc8015_log_cursor::reset(void) {
+    auto& impl = this->check_not_disposed();
+    impl.clock_offset = 0;
+    impl.clock_valid = false;
+    impl.parser.reset();
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::hmc8015_log_cursor::rows
+ */
+std::uint64_t visus::power_overwhelming::hmc8015_log_cursor::rows(void) const {
+    return this->check_not_disposed().parser.rows();
+}
+
+
+/*
+ * visus::power_overwhelming::hmc8015_log_cursor::operator =
+ */
+visus::power_overwhelming::hmc8015_log_cursor&
+visus::power_overwhelming::hmc8015_log_cursor::operator =(
+        _Inout_ hmc8015_log_cursor&& rhs) noexcept {
+    if (this != std::addressof(rhs)) {
+        delete this->_impl;
+        this->_impl = rhs._impl;
+        rhs._impl = nullptr;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::hmc8015_log_cursor::check_not_disposed
+ */
+visus::power_overwhelming::detail::hmc8015_log_cursor_impl&
+visus::power_overwhelming::hmc8015_log_cursor::check_not_disposed(void) const {
+    if (this->_impl == nullptr) {
+        throw std::runtime_error("A disposed instance of hmc8015_log_cursor "
+            "cannot be used.");
+    }
+
+    return *this->_impl;
+}
@@ -0,0 +1,47 @@
+﻿// <copyright file="hmc8015_log_cursor_impl.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include "power_overwhelming/hmc8015_log_cursor.h"
+
+#include "hmc8015_log_parser.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Private data container for the <see cref="hmc8015_log_cursor" />.
+    /// </summary>
+    struct hmc8015_log_cursor_impl final {
+
+        /// <summary>
+        /// The offset between the clock of the instrument and the host.
+        /// </summary>
+        timestamp::value_type clock_offset;
+
+        /// <summary>
+        /// Indicates whether <see cref="clock_offset" /> has been determined.
+        /// </summary>
+        bool clock_valid;
+
+        /// <summary>
+        /// The parser, which also tracks the position in the log file.
+        /// </summary>
+        hmc8015_log_parser parser;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        inline hmc8015_log_cursor_impl(void) noexcept
+            : clock_offset(0), clock_valid(false) { }
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
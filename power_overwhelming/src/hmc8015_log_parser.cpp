@@ -0,0 +1,600 @@
+﻿// <copyright file="hmc8015_log_parser.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "hmc8015_log_parser.h"
+
+#include <cassert>
+#include <cctype>
+#include <cstring>
+#include <stdexcept>
+
+#include "scpi_parser.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The number of timestamp ticks per day.
+    /// </summary>
+    static constexpr const timestamp::value_type ticks_per_day
+        = 24LL * 60LL * 60LL * timestamp::tick_rate;
+
+    /// <summary>
+    /// Answer whether <paramref name="str" /> of length
+    /// <paramref name="cnt" /> contains <paramref name="what" /> ignoring the
+    /// case of the characters.
+    /// </summary>
+    static bool contains_ci(_In_reads_(cnt) const char *str,
+            _In_ const std::size_t cnt,
+            _In_z_ const char *what) noexcept {
+        const auto len = ::strlen(what);
+
+        for (std::size_t i = 0; i + len <= cnt; ++i) {
+            std::size_t j = 0;
+            while ((j < len) && (std::tolower(static_cast<unsigned char>(
+                    str[i + j])) == what[j])) {
+                ++j;
+            }
+
+            if (j == len) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    /// <summary>
+    /// Answer whether the range [<paramref name="begin" />,
+    /// <paramref name="end" />[ is equal to <paramref name="what" /> ignoring
+    /// the case of the characters.
+    /// </summary>
+    static bool equals_ci(_In_ const char *begin, _In_ const char *end,
+            _In_z_ const char *what) noexcept {
+        const auto len = ::strlen(what);
+        return (static_cast<std::size_t>(end - begin) == len)
+            && contains_ci(begin, len, what);
+    }
+
+    /// <summary>
+    /// Retrieves the next field from the given line and advances
+    /// <paramref name="cur" /> past the delimiter.
+    /// </summary>
+    /// <remarks>
+    /// Leading and trailing white spaces and quotes are removed from the
+    /// field.
+    /// </remarks>
+    static bool next_field(_Inout_ const char *& cur,
+            _In_ const char *end,
+            _In_ const char delimiter,
+            _Out_ const char *& field_begin,
+            _Out_ const char *& field_end) noexcept {
+        if (cur > end) {
+            return false;
+        }
+
+        field_begin = cur;
+        while ((cur < end) && (*cur != delimiter)) {
+            ++cur;
+        }
+        field_end = cur++;
+
+        while ((field_begin < field_end) && ((*field_begin == ' ')
+                || (*field_begin == '"') || (*field_begin == '\t'))) {
+            ++field_begin;
+        }
+        while ((field_end > field_begin) && ((field_end[-1] == ' ')
+                || (field_end[-1] == '"') || (field_end[-1] == '\t'))) {
+            --field_end;
+        }
+
+        return true;
+    }
+
+    /// <summary>
+    /// Parses a floating-point number from the given range, accepting a
+    /// decimal comma.
+    /// </summary>
+    static bool parse_number(_In_ const char *begin, _In_ const char *end,
+            _Out_ double& value) noexcept {
+        const auto len = static_cast<std::size_t>(end - begin);
+        auto comma = static_cast<const char *>(::memchr(begin, ',', len));
+
+        if (comma == nullptr) {
+            return (parse_scpi_number(begin, end, value) != nullptr);
+        }
+
+        // Only numbers with a decimal comma need to be copied in order to
+        // replace the comma with a point.
+        char buffer[64];
+        if (len > sizeof(buffer)) {
+            return false;
+        }
+
+        ::memcpy(buffer, begin, len);
+        buffer[comma - begin] = '.';
+        return (parse_scpi_number(buffer, buffer + len, value) != nullptr);
+    }
+
+    /// <summary>
+    /// Parses an unsigned integer and advances <paramref name="cur" /> past
+    /// it.
+    /// </summary>
+    static bool parse_uint(_Inout_ const char *& cur, _In_ const char *end,
+            _Out_ int& value) noexcept {
+        value = 0;
+        const auto begin = cur;
+
+        while ((cur < end) && (*cur >= '0') && (*cur <= '9')) {
+            value = 10 * value + (*cur++ - '0');
+        }
+
+        return (cur != begin);
+    }
+
+    /// <summary>
+    /// Parses a date in ISO format (y-m-d) or in German format (d.m.y) and
+    /// advances <paramref name="cur" /> past it.
+    /// </summary>
+    static bool parse_date(_Inout_ const char *& cur, _In_ const char *end,
+            _Out_ int& year, _Out_ int& month, _Out_ int& day) noexcept {
+        int values[3];
+
+        while ((cur < end) && ((*cur < '0') || (*cur > '9'))) {
+            ++cur;
+        }
+
+        for (std::size_t i = 0; i < 3; ++i) {
+            if (i > 0) {
+                if ((cur == end) || ((*cur != '-') && (*cur != '.')
+                        && (*cur != '/'))) {
+                    return false;
+                }
+                ++cur;
+            }
+
+            if (!parse_uint(cur, end, values[i])) {
+                return false;
+            }
+        }
+
+        if (values[0] > 31) {
+            year = values[0];
+            month = values[1];
+            day = values[2];
+        } else {
+            day = values[0];
+            month = values[1];
+            year = values[2];
+        }
+
+        return true;
+    }
+
+    /// <summary>
+    /// Parses a time of the day in the format hh:mm:ss[.fff] into timestamp
+    /// ticks and advances <paramref name="cur" /> past it.
+    /// </summary>
+    static bool parse_time_of_day(_Inout_ const char *& cur,
+            _In_ const char *end,
+            _Out_ timestamp::value_type& ticks) noexcept {
+        int values[3];
+
+        while ((cur < end) && ((*cur < '0') || (*cur > '9'))) {
+            ++cur;
+        }
+
+        for (std::size_t i = 0; i < 3; ++i) {
+            if (i > 0) {
+                if ((cur == end) || (*cur != ':')) {
+                    return false;
+                }
+                ++cur;
+            }
+
+            if (!parse_uint(cur, end, values[i])) {
+                return false;
+            }
+        }
+
+        ticks = values[0];
+        ticks = 60 * ticks + values[1];
+        ticks = 60 * ticks + values[2];
+        ticks *= timestamp::tick_rate;
+
+        if ((cur < end) && ((*cur == '.') || (*cur == ','))) {
+            auto scale = timestamp::tick_rate / 10;
+            ++cur;
+
+            while ((cur < end) && (*cur >= '0') && (*cur <= '9')) {
+                ticks += scale * (*cur++ - '0');
+                scale /= 10;
+            }
+        }
+
+        return true;
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::detail::hmc8015_log_parser::hmc8015_log_parser
+ */
+visus::power_overwhelming::detail::hmc8015_log_parser::hmc8015_log_parser(
+        void) noexcept {
+    this->reset();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::hmc8015_log_parser::feed
+ */
+std::size_t visus::power_overwhelming::detail::hmc8015_log_parser::feed(
+        _In_reads_bytes_(cnt) const char *data,
+        _In_ const std::size_t cnt,
+        _Inout_ std::vector<measurement_data>& dst) {
+    assert((data != nullptr) || (cnt == 0));
+    const auto end = data + cnt;
+    std::size_t retval = 0;
+
+    while (data < end) {
+        auto nl = static_cast<const char *>(::memchr(data, '\n', end - data));
+        const auto len = static_cast<std::size_t>(((nl != nullptr)
+            ? nl : end) - data);
+
+        if ((this->_carry_size > 0) || (nl == nullptr)) {
+            // The line has started in a previous chunk or will end in one of
+            // the next chunks, so we need to assemble it in the carry buffer.
+            if (this->_carry_size + len > this->_carry.size()) {
+                throw std::runtime_error("The HMC8015 log file contains a line "
+                    "that exceeds the maximum line length.");
+            }
+
+            ::memcpy(this->_carry.data() + this->_carry_size, data, len);
+            this->_carry_size += len;
+
+            if (nl != nullptr) {
+                retval += this->line(this->_carry.data(), this->_carry_size,
+                    dst);
+                this->_offset += this->_carry_size + 1;
+                this->_carry_size = 0;
+            }
+
+        } else {
+            // The line is complete in the chunk, so we can parse it in place.
+            retval += this->line(data, len, dst);
+            this->_offset += len + 1;
+        }
+
+        data += len + 1;
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::hmc8015_log_parser::reset
+ */
+void visus::power_overwhelming::detail::hmc8015_log_parser::reset(
+        void) noexcept {
+    this->_carry_size = 0;
+    this->_current = npos;
+    this->_day = 0;
+    this->_day_offset = 0;
+    this->_delimiter = ';';
+    this->_interval = 0.0f;
+    this->_last_time_of_day = 0;
+    this->_month = 0;
+    this->_offset = 0;
+    this->_power = npos;
+    this->_row_date = 0;
+    this->_row_date_key = 0;
+    this->_rows = 0;
+    this->_start = 0;
+    this->_start_time_of_day = 0;
+    this->_time = npos;
+    this->_voltage = npos;
+    this->_year = 0;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::hmc8015_log_parser::start
+ */
+visus::power_overwhelming::timestamp
+visus::power_overwhelming::detail::hmc8015_log_parser::start(void) const {
+    return timestamp(this->_start);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::hmc8015_log_parser::header
+ */
+bool visus::power_overwhelming::detail::hmc8015_log_parser::header(
+        _In_reads_(cnt) const char *line,
+        _In_ const std::size_t cnt) {
+    const auto end = line + cnt;
+
+    // Determine the delimiter, which is the first of the candidates that
+    // occurs in the line.
+    this->_delimiter = ',';
+    for (auto d : { ';', '\t' }) {
+        if (::memchr(line, d, cnt) != nullptr) {
+            this->_delimiter = d;
+            break;
+        }
+    }
+
+    auto cur = line;
+    const char *field_begin, *field_end;
+    for (std::size_t i = 0; next_field(cur, end, this->_delimiter, field_begin,
+            field_end); ++i) {
+        // Strip the unit, which is either in brackets or separated by a space.
+        auto name_end = field_begin;
+        while ((name_end < field_end) && (*name_end != '[')
+                && (*name_end != '(') && (*name_end != ' ')) {
+            ++name_end;
+        }
+
+        if (equals_ci(field_begin, name_end, "u")
+                || equals_ci(field_begin, name_end, "urms")) {
+            if (this->_voltage == npos) {
+                this->_voltage = i;
+            }
+
+        } else if (equals_ci(field_begin, name_end, "i")
+                || equals_ci(field_begin, name_end, "irms")) {
+            if (this->_current == npos) {
+                this->_current = i;
+            }
+
+        } else if (equals_ci(field_begin, name_end, "p")) {
+            if (this->_power == npos) {
+                this->_power = i;
+            }
+
+        } else if (contains_ci(field_begin, name_end - field_begin, "time")) {
+            if (this->_time == npos) {
+                this->_time = i;
+            }
+        }
+    }
+
+    if (!this->has_header()) {
+        this->_time = npos;
+        return false;
+    } else {
+        return true;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::hmc8015_log_parser::line
+ */
+std::size_t visus::power_overwhelming::detail::hmc8015_log_parser::line(
+        _In_reads_(cnt) const char *line,
+        _In_ std::size_t cnt,
+        _Inout_ std::vector<measurement_data>& dst) {
+    // Skip the byte order mark if the file has one.
+    if ((this->_offset == 0) && (cnt >= 3) && (::memcmp(line, "\xEF\xBB\xBF",
+            3) == 0)) {
+        line += 3;
+        cnt -= 3;
+    }
+
+    // Remove Windows line endings.
+    if ((cnt > 0) && (line[cnt - 1] == '\r')) {
+        --cnt;
+    }
+
+    if (cnt == 0) {
+        return 0;
+
+    } else if (*line == '#') {
+        if (!this->has_header()) {
+            this->metadata(line + 1, cnt - 1);
+        }
+        return 0;
+
+    } else if (!this->has_header()) {
+        if (!this->header(line, cnt)) {
+            this->metadata(line, cnt);
+        }
+        return 0;
+
+    } else {
+        return this->row(line, cnt, dst);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::hmc8015_log_parser::metadata
+ */
+void visus::power_overwhelming::detail::hmc8015_log_parser::metadata(
+        _In_reads_(cnt) const char *line,
+        _In_ const std::size_t cnt) {
+    const auto end = line + cnt;
+
+    // The key is everything up to the first separator, which is either a
+    // colon or any of the possible delimiters.
+    auto value = line;
+    while ((value < end) && (*value != ':') && (*value != ';')
+            && (*value != ',') && (*value != '\t')) {
+        ++value;
+    }
+
+    const auto key_size = static_cast<std::size_t>(value - line);
+    if (value < end) {
+        ++value;
+    }
+
+    const auto is_date = contains_ci(line, key_size, "date");
+    const auto is_time = contains_ci(line, key_size, "time");
+
+    if (is_date) {
+        int year, month, day;
+        if (parse_date(value, end, year, month, day)) {
+            this->_year = year;
+            this->_month = month;
+            this->_day = day;
+            this->update_start();
+        }
+    }
+
+    if (is_time) {
+        timestamp::value_type time_of_day;
+        if (parse_time_of_day(value, end, time_of_day)) {
+            this->_start_time_of_day = time_of_day;
+            this->_last_time_of_day = time_of_day;
+            this->update_start();
+        }
+
+    } else if (!is_date && contains_ci(line, key_size, "interval")) {
+        while ((value < end) && (*value == ' ')) {
+            ++value;
+        }
+
+        auto unit = value;
+        while ((unit < end) && (((*unit >= '0') && (*unit <= '9'))
+                || (*unit == '.') || (*unit == ','))) {
+            ++unit;
+        }
+
+        double interval;
+        if (parse_number(value, unit, interval)) {
+            while ((unit < end) && (*unit == ' ')) {
+                ++unit;
+            }
+
+            if (contains_ci(unit, end - unit, "ms")) {
+                interval /= 1000.0;
+            }
+
+            this->_interval = static_cast<float>(interval);
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::hmc8015_log_parser::row
+ */
+std::size_t visus::power_overwhelming::detail::hmc8015_log_parser::row(
+        _In_reads_(cnt) const char *line,
+        _In_ const std::size_t cnt,
+        _Inout_ std::vector<measurement_data>& dst) {
+    const auto end = line + cnt;
+    auto current = measurement_data::invalid_value;
+    auto power = measurement_data::invalid_value;
+    auto voltage = measurement_data::invalid_value;
+    // The start of the log is only computed when the metadata are parsed,
+    // so the timestamps of the rows are cheap offsets from it.
+    const auto start = this->_start;
+    auto time = start + static_cast<timestamp::value_type>(
+        this->_rows * this->_interval * timestamp::tick_rate);
+
+    auto cur = line;
+    const char *field_begin, *field_end;
+    for (std::size_t i = 0; next_field(cur, end, this->_delimiter, field_begin,
+            field_end); ++i) {
+        double value;
+
+        if (i == this->_time) {
+            auto c = field_begin;
+
+            if (::memchr(field_begin, ':', field_end - field_begin) == nullptr) {
+                // Relative time in seconds since the start of logging.
+                if (parse_number(field_begin, field_end, value)) {
+                    time = start + static_cast<timestamp::value_type>(value
+                        * timestamp::tick_rate);
+                }
+
+            } else if (::memchr(field_begin, ' ', field_end - field_begin)
+                    != nullptr) {
+                // Date and time of day.
+                int year, month, day;
+                timestamp::value_type time_of_day;
+                if (parse_date(c, field_end, year, month, day)
+                        && parse_time_of_day(c, field_end, time_of_day)) {
+                    // Consecutive rows are typically on the same day, so we
+                    // only convert the date if it changes.
+                    const auto key = (year * 100 + month) * 100 + day;
+                    if (key != this->_row_date_key) {
+                        this->_row_date = timestamp::create(year, month, day)
+                            .value();
+                        this->_row_date_key = key;
+                    }
+                    time = this->_row_date + time_of_day;
+                }
+
+            } else {
+                // Time of day only, which requires us to track the midnight.
+                timestamp::value_type time_of_day;
+                if (parse_time_of_day(c, field_end, time_of_day)) {
+                    if (time_of_day < this->_last_time_of_day) {
+                        this->_day_offset += ticks_per_day;
+                    }
+                    this->_last_time_of_day = time_of_day;
+
+                    time = start - this->_start_time_of_day
+                        + this->_day_offset + time_of_day;
+                }
+            }
+
+        } else if (i == this->_current) {
+            if (parse_number(field_begin, field_end, value)) {
+                current = static_cast<measurement_data::value_type>(value);
+            }
+
+        } else if (i == this->_power) {
+            if (parse_number(field_begin, field_end, value)) {
+                power = static_cast<measurement_data::value_type>(value);
+            }
+
+        } else if (i == this->_voltage) {
+            if (parse_number(field_begin, field_end, value)) {
+                voltage = static_cast<measurement_data::value_type>(value);
+            }
+        }
+    }
+
+    ++this->_rows;
+
+    if (power != measurement_data::invalid_value) {
+        dst.emplace_back(timestamp(time), voltage, current, power);
+    } else if ((voltage != measurement_data::invalid_value)
+            && (current != measurement_data::invalid_value)) {
+        dst.emplace_back(timestamp(time), voltage, current);
+    } else {
+        // The row does not contain any usable data, eg because the
+        // instrument marked the values as overflow.
+        return 0;
+    }
+
+    return 1;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::hmc8015_log_parser::update_start
+ */
+void visus::power_overwhelming::detail::hmc8015_log_parser::update_start(
+        void) {
+    if (this->_year == 0) {
+        this->_start = 0;
+    } else {
+        auto date = timestamp::create(this->_year, this->_month, this->_day);
+        this->_start = date.value() + this->_start_time_of_day;
+    }
+}
@@ -0,0 +1,190 @@
+﻿// <copyright file="hmc8015_log_parser.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <array>
+#include <cinttypes>
+#include <cstddef>
+#include <vector>
+
+#include "power_overwhelming/measurement_data.h"
+#include "power_overwhelming/timestamp.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// An incremental parser for the CSV log files written by the R&amp;S
+    /// HMC8015 power analyser.
+    /// </summary>
+    /// <remarks>
+    /// <para>The parser accepts the log file in arbitrary chunks as they are
+    /// received from the instrument. Only complete lines are parsed, the
+    /// remainder of a chunk is kept in a fixed-size buffer until the rest of
+    /// the line arrives. Apart from the output, the parser does not allocate
+    /// any memory, because it tokenises the lines in place.</para>
+    /// <para>The parser is tolerant with respect to the exact layout of the
+    /// file: Lines before the header row are considered to be metadata, of
+    /// which the date, the start time and the logging interval are
+    /// recognised. The header row is the first row naming a voltage, current
+    /// or power column. The field delimiter is detected from the header row.
+    /// If the file contains a time column, the timestamps are derived from
+    /// it. Otherwise, the row number and the logging interval are used.
+    /// </para>
+    /// <para>All timestamps are expressed in the clock of the instrument.
+    /// </para>
+    /// </remarks>
+    class hmc8015_log_parser final {
+
+    public:
+
+        /// <summary>
+        /// The maximum length of a line in bytes.
+        /// </summary>
+        static constexpr const std::size_t max_line = 1024;
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        hmc8015_log_parser(void) noexcept;
+
+        /// <summary>
+        /// Parses the given chunk of the log file and appends all samples in
+        /// complete lines to <paramref name="dst" />.
+        /// </summary>
+        /// <param name="data">The chunk of the log file.</param>
+        /// <param name="cnt">The size of the chunk in bytes.</param>
+        /// <param name="dst">The vector receiving the samples.</param>
+        /// <returns>The number of samples that have been added to
+        /// <paramref name="dst" />.</returns>
+        /// <exception cref="std::runtime_error">If a line exceeds
+        /// <see cref="max_line" /> bytes.</exception>
+        std::size_t feed(_In_reads_bytes_(cnt) const char *data,
+            _In_ const std::size_t cnt,
+            _Inout_ std::vector<measurement_data>& dst);
+
+        /// <summary>
+        /// Answer whether the header row of the file has been parsed.
+        /// </summary>
+        /// <returns><c>true</c> if the header has been found, <c>false</c>
+        /// otherwise.</returns>
+        inline bool has_header(void) const noexcept {
+            return (this->_voltage != npos)
+                || (this->_current != npos)
+                || (this->_power != npos);
+        }
+
+        /// <summary>
+        /// Answer the number of bytes in complete lines that have been
+        /// processed so far.
+        /// </summary>
+        /// <returns>The offset of the first incomplete line in the file.
+        /// </returns>
+        inline std::uint64_t offset(void) const noexcept {
+            return this->_offset;
+        }
+
+        /// <summary>
+        /// Resets the parser to its initial state.
+        /// </summary>
+        void reset(void) noexcept;
+
+        /// <summary>
+        /// Discards an incomplete line at the end of the data fed so far such
+        /// that parsing can continue at <see cref="offset" />.
+        /// </summary>
+        /// <remarks>
+        /// This method must be called before the log file is downloaded again
+        /// in order to harvest rows that have been added after the previous
+        /// download.
+        /// </remarks>
+        inline void restart(void) noexcept {
+            this->_carry_size = 0;
+        }
+
+        /// <summary>
+        /// Answer the number of data rows that have been parsed so far.
+        /// </summary>
+        /// <returns>The number of data rows.</returns>
+        inline std::uint64_t rows(void) const noexcept {
+            return this->_rows;
+        }
+
+        /// <summary>
+        /// Answer the time when logging was started as recorded in the
+        /// metadata of the file.
+        /// </summary>
+        /// <returns>The start time in the clock of the instrument, or
+        /// <see cref="timestamp::zero" /> if the file does not contain the
+        /// start time (yet).</returns>
+        timestamp start(void) const;
+
+    private:
+
+        /// <summary>
+        /// Marks columns that are not present in the file.
+        /// </summary>
+        static constexpr const std::size_t npos = static_cast<std::size_t>(-1);
+
+        /// <summary>
+        /// Processes a complete line without the line break.
+        /// </summary>
+        std::size_t line(_In_reads_(cnt) const char *line,
+            _In_ const std::size_t cnt,
+            _Inout_ std::vector<measurement_data>& dst);
+
+        /// <summary>
+        /// Interprets the given line as metadata.
+        /// </summary>
+        void metadata(_In_reads_(cnt) const char *line,
+            _In_ const std::size_t cnt);
+
+        /// <summary>
+        /// Tries interpreting the given line as the header row.
+        /// </summary>
+        bool header(_In_reads_(cnt) const char *line,
+            _In_ const std::size_t cnt);
+
+        /// <summary>
+        /// Interprets the given line as data row.
+        /// </summary>
+        std::size_t row(_In_reads_(cnt) const char *line,
+            _In_ const std::size_t cnt,
+            _Inout_ std::vector<measurement_data>& dst);
+
+        /// <summary>
+        /// Recomputes <see cref="_start" /> after the date or the start time
+        /// in the metadata have changed.
+        /// </summary>
+        void update_start(void);
+
+        std::array<char, max_line> _carry;
+        std::size_t _carry_size;
+        std::size_t _current;
+        int _day;
+        timestamp::value_type _day_offset;
+        char _delimiter;
+        float _interval;
+        timestamp::value_type _last_time_of_day;
+        int _month;
+        std::uint64_t _offset;
+        std::size_t _power;
+        timestamp::value_type _row_date;
+        int _row_date_key;
+        std::uint64_t _rows;
+        timestamp::value_type _start;
+        timestamp::value_type _start_time_of_day;
+        std::size_t _time;
+        std::size_t _voltage;
+        int _year;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,125 @@
+﻿// <copyright file="hmc8015_sample.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/hmc8015_sample.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+
+/*
+ * visus::power_overwhelming::hmc8015_sample::max_functions
+ */
+const std::size_t
+visus::power_overwhelming::hmc8015_sample::max_functions;
+
+
+/*
+ * visus::power_overwhelming::hmc8015_sample::hmc8015_sample
+ */
+visus::power_overwhelming::hmc8015_sample::hmc8015_sample(
+        _In_ const timestamp_type timestamp) noexcept
+    : _size(0), _timestamp(timestamp) { }
+
+
+/*
+ * visus::power_overwhelming::hmc8015_sample::hmc8015_sample
+ */
+visus::power_overwhelming::hmc8015_sample::hmc8015_sample(
+        _In_ const timestamp_type timestamp,
+        _In_reads_(cnt) const hmc8015_function *functions,
+        _In_reads_(cnt) const value_type *values,
+        _In_ const std::size_t cnt)
+        : _size(cnt), _timestamp(timestamp) {
+    if ((cnt > 0) && ((functions == nullptr) || (values == nullptr))) {
+        throw std::invalid_argument("The functions and values of a sample "
+            "must be valid.");
+    }
+    if (cnt > max_functions) {
+        throw std::invalid_argument("The HMC8015 cannot measure more than "
+            "ten functions at the same time.");
+    }
+
+    std::copy(functions, functions + cnt, this->_functions);
+    std::copy(values, values + cnt, this->_values);
+}
+
+
+/*
+ * visus::power_overwhelming::hmc8015_sample::contains
+ */
+bool visus::power_overwhelming::hmc8015_sample::contains(
+        _In_ const hmc8015_function function) const noexcept {
+    const auto end = this->_functions + this->_size;
+    return (std::find(this->_functions, end, function) != end);
+}
+
+
+/*
+ * visus::power_overwhelming::hmc8015_sample::function
+ */
+visus::power_overwhelming::hmc8015_function
+visus::power_overwhelming::hmc8015_sample::function(
+        _In_ const std::size_t i) const {
+    if (i >= this->_size) {
+        throw std::range_error("The specified function index is out of "
+            "range.");
+    }
+
+    return this->_functions[i];
+}
+
+
+/*
+ * visus::power_overwhelming::hmc8015_sample::to_measurement_data
+ */
+visus::power_overwhelming::measurement_data
+visus::power_overwhelming::hmc8015_sample::to_measurement_data(
+        void) const noexcept {
+    auto voltage = this->value(hmc8015_function::rms_voltage);
+    if (voltage == measurement_data::invalid_value) {
+        voltage = this->value(hmc8015_function::average_voltage);
+    }
+
+    auto current = this->value(hmc8015_function::rms_current);
+    if (current == measurement_data::invalid_value) {
+        current = this->value(hmc8015_function::current_average);
+    }
+
+    const auto power = this->value(hmc8015_function::active_power);
+
+    return measurement_data(this->_timestamp, voltage, current, power);
+}
+
+
+/*
+ * visus::power_overwhelming::hmc8015_sample::value
+ */
+visus::power_overwhelming::hmc8015_sample::value_type
+visus::power_overwhelming::hmc8015_sample::value(
+        _In_ const hmc8015_function function) const noexcept {
+    for (std::size_t i = 0; i < this->_size; ++i) {
+        if (this->_functions[i] == function) {
+            return this->_values[i];
+        }
+    }
+
+    return measurement_data::invalid_value;
+}
+
+
+/*
+ * visus::power_overwhelming::hmc8015_sample::value
+ */
+visus::power_overwhelming::hmc8015_sample::value_type
+visus::power_overwhelming::hmc8015_sample::value(
+        _In_ const std::size_t i) const {
+    if (i >= this->_size) {
+        throw std::range_error("The specified value index is out of range.");
+    }
+
+    return this->_values[i];
+}
@@ -8,22 +8,151 @@
 
 #include <algorithm>
 #include <cassert>
+#include <iterator>
 #include <limits>
 #include <stdexcept>
 #include <utility>
+#include <vector>
 
 #include "power_overwhelming/convert_string.h"
 #include "power_overwhelming/timestamp.h"
 
+#include "hmc8015_log_cursor_impl.h"
 #include "hmc8015_sensor_impl.h"
 #include "no_visa_error_msg.h"
 #include "sampler.h"
+#include "scpi_parser.h"
 #include "string_functions.h"
-#include "tokenise.h"
 #include "visa_instrument_impl.h"
 #include "visa_library.h"
 
 
+#if defined(POWER_OVERWHELMING_WITH_VISA)
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The size of the chunks in which log files are downloaded.
+    /// </summary>
+    static constexpr std::size_t hmc8015_log_chunk_size = 64 * 1024;
+
+    /// <summary>
+    /// The context passed to <see cref="harvest_hmc8015_log_chunk" /> while
+    /// harvesting a log file.
+    /// </summary>
+    struct hmc8015_log_harvest final {
+        hmc8015_log_parser *parser;
+        std::uint64_t position;
+        std::vector<measurement_data> samples;
+        std::uint64_t skip;
+    };
+
+    /// <summary>
+    /// Feeds a chunk of a log file to the parser of the
+    /// <see cref="hmc8015_log_harvest" /> passed as
+    /// <paramref name="context" />, skipping everything that has already been
+    /// harvested before.
+    /// </summary>
+    static void harvest_hmc8015_log_chunk(
+            _In_reads_bytes_(cnt) const visa_instrument::byte_type *chunk,
+            _In_ const std::size_t cnt,
+            _In_opt_ void *context) {
+        assert(context != nullptr);
+        auto harvest = static_cast<hmc8015_log_harvest *>(context);
+        const auto end = harvest->position + cnt;
+
+        if (end > harvest->skip) {
+            const auto begin = (harvest->skip > harvest->position)
+                ? static_cast<std::size_t>(harvest->skip - harvest->position)
+                : static_cast<std::size_t>(0);
+            harvest->parser->feed(reinterpret_cast<const char *>(chunk) + begin,
+                cnt - begin,
+                harvest->samples);
+        }
+
+        harvest->position = end;
+    }
+
+    /// <summary>
+    /// Parses a response of three comma-separated integers as returned by
+    /// <c>SYST:DATE?</c> and <c>SYST:TIME?</c>.
+    /// </summary>
+    static void parse_hmc8015_triple(_Out_writes_(3) int *dst,
+            _In_ const blob& response) {
+        auto str = response.as<char>();
+        scpi_tokeniser tokens(str, str + response.size());
+        std::string_view token;
+
+        for (std::size_t i = 0; i < 3; ++i) {
+            if (!tokens.next(token) || !parse_scpi_number(token, dst[i])) {
+                throw std::runtime_error("The instrument reported an invalid "
+                    "date or time.");
+            }
+        }
+    }
+
+    /// <summary>
+    /// Queries the time of the day from the HMC8015 in seconds and answers the
+    /// host time in the middle of the query in <paramref name="host" />.
+    /// </summary>
+    static int query_hmc8015_time(_In_ const visa_instrument& instrument,
+            _Out_ timestamp& host) {
+        const auto before = timestamp::now();
+        const auto response = instrument.query("SYST:TIME?\n");
+        const auto after = timestamp::now();
+        host = timestamp(before.value() + (after.value() - before.value()) / 2);
+
+        int time[3];
+        parse_hmc8015_triple(time, response);
+        return (time[0] * 60 + time[1]) * 60 + time[2];
+    }
+
+    /// <summary>
+    /// Measures the offset that needs to be added to a timestamp from the clock
+    /// of the HMC8015 to obtain a timestamp in the clock of the host.
+    /// </summary>
+    /// <remarks>
+    /// The clock of the instrument only reports full seconds, wherefore a
+    /// single query could be off by up to one second. We therefore poll the
+    /// clock until it ticks over to the next second, which happened in
+    /// between the last two queries.
+    /// </remarks>
+    static timestamp::value_type estimate_hmc8015_clock_offset(
+            _In_ const visa_instrument& instrument) {
+        timestamp host;
+        const auto start = query_hmc8015_time(instrument, host);
+        const auto deadline = host.value() + 3 * timestamp::tick_rate / 2;
+
+        auto current = start;
+        auto previous_host = host;
+        while ((current == start) && (host.value() < deadline)) {
+            previous_host = host;
+            current = query_hmc8015_time(instrument, host);
+        }
+
+        int date[3];
+        parse_hmc8015_triple(date, instrument.query("SYST:DATE?\n"));
+
+        const auto time = timestamp::create(date[0], date[1], date[2]).value()
+            + current * timestamp::tick_rate;
+
+        if (current != start) {
+            // The second started in between the last two queries.
+            return (previous_host.value() + host.value()) / 2 - time;
+        } else {
+            // The clock did not tick, which should not happen. Assume that we
+            // are in the middle of the second in this case.
+            return host.value() - time - timestamp::tick_rate / 2;
+        }
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+#endif /*defined(POWER_OVERWHELMING_WITH_VISA) */
+
+
 /*
  * visus::power_overwhelming::hmc8015_sensor::for_all
  */
@@ -86,6 +215,7 @@ visus::power_overwhelming::hmc8015_sensor::hmc8015_sensor(
 visus::power_overwhelming::hmc8015_sensor::hmc8015_sensor(
         _Inout_ hmc8015_sensor&& rhs) noexcept
     : _async_sampling(std::move(rhs._async_sampling)),
+        _functions(std::move(rhs._functions)),
         _instrument(std::move(rhs._instrument)),
         _name(std::move(rhs._name)) { }
 
@@ -158,6 +288,12 @@ visus::power_overwhelming::hmc8015_sensor::custom_functions(
         throw std::invalid_argument("The list of measurement functions must be "
             "valid.");
     }
+    if (cnt > hmc8015_sample::max_functions) {
+        throw std::invalid_argument("The HMC8015 cannot measure more than "
+            "ten functions at the same time.");
+    }
+
+    this->check_not_disposed();
 
     std::string cmd("CHAN1:MEAS:FUNC ");
 
@@ -172,6 +308,13 @@ visus::power_overwhelming::hmc8015_sensor::custom_functions(
 
     this->_instrument.write(cmd.c_str());
 
+    // Remember the functions only after the instrument has accepted them such
+    // that the layout we expect for the responses is always the one that has
+    // been configured.
+    this->_functions.resize(cnt * sizeof(hmc8015_function));
+    std::copy(functions, functions + cnt,
+        this->_functions.as<hmc8015_function>());
+
     return *this;
 }
 
@@ -181,10 +324,9 @@ visus::power_overwhelming::hmc8015_sensor::custom_functions(
  */
 visus::power_overwhelming::hmc8015_sensor&
 visus::power_overwhelming::hmc8015_sensor::default_functions(void) {
-    this->check_not_disposed();
-    this->_instrument.write("CHAN1:MEAS:FUNC URMS, URAN, IRMS, "
-        "IRAN, S, P\n");
-    return *this;
+    return this->custom_functions(
+        std::begin(detail::hmc8015_sensor_impl::default_functions),
+        std::size(detail::hmc8015_sensor_impl::default_functions));
 }
 
 
@@ -288,6 +430,96 @@ std::size_t visus::power_overwhelming::hmc8015_sensor::functions(
 }
 
 
+/*
+ * visus::power_overwhelming::hmc8015_sensor::harvest_log
+ */
+visus::power_overwhelming::measurement_data_series
+visus::power_overwhelming::hmc8015_sensor::harvest_log(
+        _In_z_ const wchar_t *name,
+        _Inout_ hmc8015_log_cursor& cursor,
+        _In_ const bool use_usb) const {
+    if (name == nullptr) {
+        throw std::invalid_argument("The name of the log file cannot be "
+            "null.");
+    }
+
+    const auto n = convert_string<char>(name);
+    return this->harvest_log(n.c_str(), cursor, use_usb);
+}
+
+
+/*
+ * visus::power_overwhelming::hmc8015_sensor::harvest_log
+ */
+visus::power_overwhelming::measurement_data_series
+visus::power_overwhelming::hmc8015_sensor::harvest_log(
+        _In_z_ const char *name,
+        _Inout_ hmc8015_log_cursor& cursor,
+        _In_ const bool use_usb) const {
+    if ((name == nullptr) || (*name == 0)) {
+        throw std::invalid_argument("The name of the log file cannot be "
+            "null or empty.");
+    }
+
+#if defined(POWER_OVERWHELMING_WITH_VISA)
+    this->check_not_disposed();
+    auto& state = cursor.check_not_disposed();
+
+    if (!state.clock_valid) {
+        state.clock_offset = detail::estimate_hmc8015_clock_offset(
+            this->_instrument);
+        state.clock_valid = true;
+    }
+
+    std::string query("DATA:DATA? \"");
+    query += name;
+    query += "\", ";
+    query += (use_usb ? "EXT" : "INT");
+
+    this->_instrument.write(query.c_str());
+
+    // The instrument announces the size of the file before its contents. If
+    // the file is smaller than what we have seen before, it must have been
+    // replaced, so we start over from its begin rather than downloading it a
+    // second time.
+    auto& instrument = this->_instrument.check_not_disposed();
+    const auto size = instrument.read_binary_header();
+    if (size < state.parser.offset()) {
+        state.parser.reset();
+    }
+
+    // Stream the file through the parser, which skips everything we have
+    // already seen. Any incomplete line at the end of the previous harvest
+    // needs to be read again, because it might have been completed since.
+    detail::hmc8015_log_harvest harvest;
+    harvest.parser = &state.parser;
+    harvest.position = 0;
+    harvest.skip = state.parser.offset();
+    state.parser.restart();
+
+    instrument.read_binary_data(size, detail::harvest_hmc8015_log_chunk,
+        &harvest, detail::hmc8015_log_chunk_size);
+    this->_instrument.throw_on_system_error();
+
+    measurement_data_series retval(this->name());
+    auto dst = measurement_data_series::resize(retval, harvest.samples.size());
+
+    for (auto& s : harvest.samples) {
+        *dst++ = measurement_data(
+            timestamp(s.timestamp().value() + state.clock_offset),
+            s.voltage(),
+            s.current(),
+            s.power());
+    }
+
+    return retval;
+
+#else /*defined(POWER_OVERWHELMING_WITH_VISA) */
+    throw std::runtime_error(detail::no_visa_error_msg);
+#endif /*defined(POWER_OVERWHELMING_WITH_VISA) */
+}
+
+
 /*
  * visus::power_overwhelming::hmc8015_sensor::integrator_behaviour
  */
@@ -607,6 +839,22 @@ visus::power_overwhelming::hmc8015_sensor::reset_integrator(void) {
 }
 
 
+/*
+ * visus::power_overwhelming::hmc8015_sensor::sample_functions
+ */
+visus::power_overwhelming::hmc8015_sample
+visus::power_overwhelming::hmc8015_sensor::sample_functions(void) const {
+    this->check_not_disposed();
+
+    auto response = this->_instrument.query("CHAN1:MEAS:DATA?\n");
+    auto timestamp = power_overwhelming::timestamp::now();
+    return detail::hmc8015_sensor_impl::parse_sample(timestamp,
+        this->_functions.as<hmc8015_function>(),
+        this->_functions.size() / sizeof(hmc8015_function),
+        response);
+}
+
+
 /*
  * visus::power_overwhelming::hmc8015_sensor::start_integrator
  */
@@ -637,6 +885,7 @@ visus::power_overwhelming::hmc8015_sensor::operator =(
         _Inout_ hmc8015_sensor&& rhs) noexcept {
     if (this != std::addressof(rhs)) {
         this->_async_sampling = std::move(rhs._async_sampling);
+        this->_functions = std::move(rhs._functions);
         this->_instrument = std::move(rhs._instrument);
         this->_name = std::move(rhs._name);
     }
@@ -677,18 +926,7 @@ void visus::power_overwhelming::hmc8015_sensor::sample_async(
 visus::power_overwhelming::measurement_data
 visus::power_overwhelming::hmc8015_sensor::sample_sync(void) const {
     assert(*this);
-
-    // TODO: could use CHAN1:MEAS:FORM BIN here.
-    auto response = this->_instrument.query("CHAN1:MEAS:DATA?\n");
-    auto timestamp = power_overwhelming::timestamp::now();
-    auto tokens = detail::tokenise(std::string(response.begin(),
-        response.end()), ',', true);
-
-    auto v = static_cast<measurement::value_type>(::atof(tokens[0].c_str()));
-    auto c = static_cast<measurement::value_type>(::atof(tokens[1].c_str()));
-    auto p = static_cast<measurement::value_type>(::atof(tokens[2].c_str()));
-
-    return measurement_data(timestamp, v, c, p);
+    return this->sample_functions().to_measurement_data();
 }
 
 
@@ -730,8 +968,17 @@ bool visus::power_overwhelming::hmc8015_sensor::deliver(void) const {
     auto retval = static_cast<bool>(this->_async_sampling);
 
     if (retval) {
-        retval = this->_async_sampling.deliver(this->name(),
-            this->sample_sync());
+        switch (this->_async_sampling.delivery_method()) {
+            case async_delivery_method::on_hmc8015_sample:
+                retval = this->_async_sampling.deliver(this->name(),
+                    this->sample_functions());
+                break;
+
+            default:
+                retval = this->_async_sampling.deliver(this->name(),
+                    this->sample_sync());
+                break;
+        }
     }
 
     return retval;
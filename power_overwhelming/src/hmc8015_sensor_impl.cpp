@@ -6,9 +6,41 @@
 
 #include "hmc8015_sensor_impl.h"
 
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+
 #include "power_overwhelming/timestamp.h"
 
-#include "tokenise.h"
+#include "scpi_parser.h"
+
+
+/*
+ * visus::power_overwhelming::detail::hmc8015_sensor_impl::parse_sample
+ */
+visus::power_overwhelming::hmc8015_sample
+visus::power_overwhelming::detail::hmc8015_sensor_impl::parse_sample(
+        _In_ const timestamp timestamp,
+        _In_reads_(cnt) const hmc8015_function *functions,
+        _In_ const std::size_t cnt,
+        _In_ const blob& response) noexcept {
+    assert(cnt <= hmc8015_sample::max_functions);
+    const auto n = (std::min)(cnt, hmc8015_sample::max_functions);
+    hmc8015_sample::value_type values[hmc8015_sample::max_functions];
+
+    auto str = response.as<char>();
+    scpi_tokeniser tokens(str, str + response.size());
+    std::string_view token;
+
+    for (std::size_t i = 0; i < n; ++i) {
+        auto& v = values[i];
+        if (!tokens.next(token) || !parse_scpi_number(token, v)) {
+            v = measurement_data::invalid_value;
+        }
+    }
+
+    return hmc8015_sample(timestamp, functions, values, n);
+}
 
 
 /*
@@ -50,12 +82,8 @@ visus::power_overwhelming::measurement_data
 visus::power_overwhelming::detail::hmc8015_sensor_impl::sample(void) const {
     auto response = this->instrument.query("CHAN1:MEAS:DATA?\n");
     auto timestamp = power_overwhelming::timestamp::now();
-    auto tokens = detail::tokenise(std::string(response.begin(),
-        response.end()), ',', true);
-
-    auto v = static_cast<measurement::value_type>(::atof(tokens[0].c_str()));
-    auto c = static_cast<measurement::value_type>(::atof(tokens[1].c_str()));
-    auto p = static_cast<measurement::value_type>(::atof(tokens[2].c_str()));
-
-    return measurement_data(timestamp, v, c, p);
+    return parse_sample(timestamp,
+        std::begin(default_functions),
+        std::size(default_functions),
+        response).to_measurement_data();
 }
@@ -4,10 +4,13 @@
 // </copyright>
 // <author>Christoph Müller</author>
 
+#pragma once
+
 #include "power_overwhelming/visa_instrument.h"
 
 #include <string>
 
+#include "power_overwhelming/hmc8015_sample.h"
 #include "power_overwhelming/measurement_data.h"
 
 #include "basic_sampler_source.h"
@@ -23,6 +26,44 @@ namespace detail {
     struct hmc8015_sensor_impl final
             : public basic_sampler_source<hmc8015_sensor_impl> {
 
+        /// <summary>
+        /// The functions that are measured unless the user configures
+        /// something else.
+        /// </summary>
+        static constexpr const hmc8015_function default_functions[] = {
+            hmc8015_function::rms_voltage,
+            hmc8015_function::voltage_range,
+            hmc8015_function::rms_current,
+            hmc8015_function::current_range,
+            hmc8015_function::apparent_power,
+            hmc8015_function::active_power
+        };
+
+        /// <summary>
+        /// Parses the response to <c>CHAN1:MEAS:DATA?</c>, which comprises
+        /// the values of all configured <paramref name="functions" /> in the
+        /// order they have been configured.
+        /// </summary>
+        /// <remarks>
+        /// The response is parsed in place without allocating memory and
+        /// independently from the locale of the process. Fields that are
+        /// missing or not a number are reported as
+        /// <see cref="measurement_data::invalid_value" />. Any surplus fields
+        /// in the response are ignored.
+        /// </remarks>
+        /// <param name="timestamp">The timestamp of the sample.</param>
+        /// <param name="functions">The functions that have been configured
+        /// on the instrument.</param>
+        /// <param name="cnt">The number of <paramref name="functions" />,
+        /// which must not exceed <see cref="hmc8015_sample::max_functions" />.
+        /// </param>
+        /// <param name="response">The response of the instrument.</param>
+        /// <returns>The values in the response.</returns>
+        static hmc8015_sample parse_sample(_In_ const timestamp timestamp,
+            _In_reads_(cnt) const hmc8015_function *functions,
+            _In_ const std::size_t cnt,
+            _In_ const blob& response) noexcept;
+
         visa_instrument instrument;
 
         std::wstring sensor_name;
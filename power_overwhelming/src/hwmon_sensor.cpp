@@ -0,0 +1,187 @@
+﻿// <copyright file="hwmon_sensor.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/hwmon_sensor.h"
+
+#include <algorithm>
+#include <cassert>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "hwmon_sensor_impl.h"
+#include "sampler.h"
+
+
+/*
+ * visus::power_overwhelming::hwmon_sensor::default_root
+ */
+constexpr const char *visus::power_overwhelming::hwmon_sensor::default_root;
+
+
+/*
+ * visus::power_overwhelming::hwmon_sensor::for_all
+ */
+std::size_t visus::power_overwhelming::hwmon_sensor::for_all(
+        _Out_writes_opt_(cnt_sensors) hwmon_sensor *out_sensors,
+        _In_ const std::size_t cnt_sensors,
+        _In_opt_z_ const char *root) {
+    namespace fs = std::filesystem;
+    std::vector<std::string> devices;
+    std::size_t retval = 0;
+
+    if (root == nullptr) {
+        root = default_root;
+    }
+
+    {
+        // Enumerate without exceptions, because a missing directory just means
+        // that there are no hwmon devices, which is always the case on
+        // Windows.
+        std::error_code ec;
+        for (fs::directory_iterator it(root, ec), end; !ec && (it != end);
+                it.increment(ec)) {
+            std::error_code ec2;
+            if (fs::is_directory(it->path(), ec2)) {
+                devices.push_back(it->path().generic_string());
+            }
+        }
+    }
+
+    // Make sure that the order of the sensors is stable.
+    std::sort(devices.begin(), devices.end());
+
+    for (auto& d : devices) {
+        try {
+            hwmon_sensor sensor(d.c_str());
+
+            if (retval < cnt_sensors) {
+                out_sensors[retval] = std::move(sensor);
+            }
+
+            ++retval;
+        } catch (...) {
+            // Most hwmon devices are temperature sensors or fans, which we
+            // just skip.
+        }
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::hwmon_sensor::hwmon_sensor
+ */
+visus::power_overwhelming::hwmon_sensor::hwmon_sensor(void)
+    : _impl(nullptr) { }
+
+
+/*
+ * visus::power_overwhelming::hwmon_sensor::hwmon_sensor
+ */
+visus::power_overwhelming::hwmon_sensor::hwmon_sensor(
+        _In_z_ const char *path) : _impl(nullptr) {
+    if (path == nullptr) {
+        throw std::invalid_argument("The path to the hwmon device must not be "
+            "null.");
+    }
+
+    this->_impl = new detail::hwmon_sensor_impl(path);
+}
+
+
+/*
+ * visus::power_overwhelming::hwmon_sensor::~hwmon_sensor
+ */
+visus::power_overwhelming::hwmon_sensor::~hwmon_sensor(void) {
+    delete this->_impl;
+}
+
+
+/*
+ * visus::power_overwhelming::hwmon_sensor::device_name
+ */
+_Ret_maybenull_z_ const char *
+visus::power_overwhelming::hwmon_sensor::device_name(void) const noexcept {
+    return (this->_impl != nullptr)
+        ? this->_impl->device_name.c_str()
+        : nullptr;
+}
+
+
+/*
+ * visus::power_overwhelming::hwmon_sensor::name
+ */
+_Ret_maybenull_z_ const wchar_t *visus::power_overwhelming::hwmon_sensor::name(
+        void) const noexcept {
+    return (this->_impl != nullptr)
+        ? this->_impl->sensor_name.c_str()
+        : nullptr;
+}
+
+
+/*
+ * visus::power_overwhelming::hwmon_sensor::path
+ */
+_Ret_maybenull_z_ const char *visus::power_overwhelming::hwmon_sensor::path(
+        void) const noexcept {
+    return (this->_impl != nullptr)
+        ? this->_impl->path.c_str()
+        : nullptr;
+}
+
+
+/*
+ * visus::power_overwhelming::hwmon_sensor::operator =
+ */
+visus::power_overwhelming::hwmon_sensor&
+visus::power_overwhelming::hwmon_sensor::operator =(
+        _In_ hwmon_sensor&& rhs) noexcept {
+    if (this != std::addressof(rhs)) {
+        delete this->_impl;
+        this->_impl = rhs._impl;
+        rhs._impl = nullptr;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::hwmon_sensor::operator bool
+ */
+visus::power_overwhelming::hwmon_sensor::operator bool(void) const noexcept {
+    return (this->_impl != nullptr);
+}
+
+
+/*
+ * visus::power_overwhelming::hwmon_sensor::sample_async
+ */
+void visus::power_overwhelming::hwmon_sensor::sample_async(
+        _Inout_ async_sampling&& sampling) {
+    assert(this->_impl != nullptr);
+    this->_impl->async_sampling = std::move(sampling);
+
+    if (this->_impl->async_sampling) {
+        detail::sampler::default_sampler += this->_impl;
+    } else {
+        detail::sampler::default_sampler -= this->_impl;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::hwmon_sensor::sample_sync
+ */
+visus::power_overwhelming::measurement_data
+visus::power_overwhelming::hwmon_sensor::sample_sync(void) const {
+    assert(this->_impl != nullptr);
+    return this->_impl->sample();
+}
@@ -0,0 +1,391 @@
+﻿// <copyright file="hwmon_sensor_impl.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "hwmon_sensor_impl.h"
+
+#include <cassert>
+#include <cstdlib>
+#include <filesystem>
+#include <map>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+
+#if defined(_WIN32)
+#include <io.h>
+#else /* defined(_WIN32) */
+#include <unistd.h>
+#endif /* defined(_WIN32) */
+
+#include "power_overwhelming/convert_string.h"
+
+#include "io_util.h"
+#include "sampler.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Closes the given descriptor if it is valid and invalidates it.
+    /// </summary>
+    static void close_attribute(
+            _Inout_ hwmon_sensor_impl::handle_type& handle) noexcept {
+        if (handle != hwmon_sensor_impl::invalid_handle_value) {
+#if defined(_WIN32)
+            ::_close(handle);
+#else /* defined(_WIN32) */
+            ::close(handle);
+#endif /* defined(_WIN32) */
+            handle = hwmon_sensor_impl::invalid_handle_value;
+        }
+    }
+
+    /// <summary>
+    /// Reads the textual attribute <paramref name="attribute" /> of the hwmon
+    /// device in <paramref name="path" /> or returns an empty string if the
+    /// device does not have the attribute.
+    /// </summary>
+    static std::string read_text_attribute(_In_ const std::string& path,
+            _In_z_ const char *attribute) {
+        auto handle = hwmon_sensor_impl::open_attribute(path, attribute);
+        if (handle == hwmon_sensor_impl::invalid_handle_value) {
+            return std::string();
+        }
+
+        char buffer[64];
+        std::size_t cnt = 0;
+
+        try {
+            cnt = read_at(handle, buffer, sizeof(buffer), 0);
+        } catch (...) {
+            close_attribute(handle);
+            throw;
+        }
+        close_attribute(handle);
+
+        // The file is terminated by a line break, which we do not want.
+        while ((cnt > 0) && ((buffer[cnt - 1] == '\n')
+                || (buffer[cnt - 1] == '\r'))) {
+            --cnt;
+        }
+
+        return std::string(buffer, cnt);
+    }
+
+    /// <summary>
+    /// Parses the channel number from an attribute name of the form
+    /// <c>&lt;prefix&gt;N_input</c>.
+    /// </summary>
+    /// <returns>The channel number, or -1 if <paramref name="name" /> is not
+    /// an input attribute with the given prefix.</returns>
+    static int parse_channel(_In_ const std::string& name,
+            _In_ const std::string& prefix) {
+        static const std::string suffix("_input");
+        if ((name.size() <= prefix.size() + suffix.size())
+                || (name.compare(0, prefix.size(), prefix) != 0)
+                || (name.compare(name.size() - suffix.size(), suffix.size(),
+                    suffix) != 0)) {
+            return -1;
+        }
+
+        const auto digits = name.substr(prefix.size(),
+            name.size() - prefix.size() - suffix.size());
+        if (digits.find_first_not_of("0123456789") != std::string::npos) {
+            return -1;
+        }
+
+        return std::atoi(digits.c_str());
+    }
+
+    /// <summary>
+    /// Enumerates the voltage and current channels of the hwmon device in
+    /// <paramref name="path" /> and selects a voltage and a current channel
+    /// that measure the same rail.
+    /// </summary>
+    /// <remarks>
+    /// <para>The numbering of the <c>in*</c> and <c>curr*</c> channels is
+    /// independent and they frequently measure different rails, eg
+    /// <c>in0</c> is the shunt voltage on ina2xx and the graphics core
+    /// voltage on amdgpu. Therefore, a pair is only formed if both channels
+    /// have the same <c>*_label</c> or if neither has a label and both have
+    /// the same number. If there are multiple pairs, the one with the lowest
+    /// number is used.</para>
+    /// <para>If there is no pair, the lowest voltage and current channels are
+    /// selected individually, and <paramref name="paired" /> is set
+    /// <c>false</c>.</para>
+    /// </remarks>
+    static void find_channels(_In_ const std::string& path,
+            _Out_ int& voltage, _Out_ int& current, _Out_ bool& paired) {
+        namespace fs = std::filesystem;
+        std::map<int, std::string> currents;
+        std::map<int, std::string> voltages;
+
+        voltage = -1;
+        current = -1;
+        paired = false;
+
+        {
+            std::error_code ec;
+            for (fs::directory_iterator it(path, ec), end; !ec && (it != end);
+                    it.increment(ec)) {
+                const auto name = it->path().filename().string();
+                auto channel = parse_channel(name, "in");
+                if (channel >= 0) {
+                    const auto label = "in" + std::to_string(channel)
+                        + "_label";
+                    voltages[channel] = read_text_attribute(path,
+                        label.c_str());
+                    continue;
+                }
+
+                channel = parse_channel(name, "curr");
+                if (channel >= 0) {
+                    const auto label = "curr" + std::to_string(channel)
+                        + "_label";
+                    currents[channel] = read_text_attribute(path,
+                        label.c_str());
+                }
+            }
+        }
+
+        for (auto& c : currents) {
+            for (auto& v : voltages) {
+                const auto matches = (c.second.empty() && v.second.empty())
+                    ? (c.first == v.first)
+                    : (c.second == v.second);
+                if (matches) {
+                    voltage = v.first;
+                    current = c.first;
+                    paired = true;
+                    return;
+                }
+            }
+        }
+
+        if (!voltages.empty()) {
+            voltage = voltages.begin()->first;
+        }
+        if (!currents.empty()) {
+            current = currents.begin()->first;
+        }
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::detail::hwmon_sensor_impl::invalid_handle_value
+ */
+constexpr const visus::power_overwhelming::detail::hwmon_sensor_impl::handle_type
+visus::power_overwhelming::detail::hwmon_sensor_impl::invalid_handle_value;
+
+
+/*
+ * visus::power_overwhelming::detail::hwmon_sensor_impl::open_attribute
+ */
+visus::power_overwhelming::detail::hwmon_sensor_impl::handle_type
+visus::power_overwhelming::detail::hwmon_sensor_impl::open_attribute(
+        _In_ const std::string& path,
+        _In_z_ const char *attribute) noexcept {
+    try {
+        const auto p = path + "/" + attribute;
+        return detail::open(p.c_str(), O_RDONLY);
+    } catch (...) {
+        return invalid_handle_value;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::hwmon_sensor_impl::read_attribute
+ */
+visus::power_overwhelming::detail::hwmon_sensor_impl::attribute_type
+visus::power_overwhelming::detail::hwmon_sensor_impl::read_attribute(
+        _In_ const handle_type handle) {
+    // sysfs attributes are tiny, so a single read from the start of the file
+    // is sufficient and does not require the file to be reopened.
+    char buffer[32];
+    const auto cnt = read_at(handle, buffer, sizeof(buffer) - 1, 0);
+    buffer[cnt] = 0;
+
+    char *end = nullptr;
+    const auto retval = std::strtoll(buffer, &end, 10);
+    if (end == buffer) {
+        throw std::runtime_error("The hwmon attribute does not contain an "
+            "integral number.");
+    }
+
+    return static_cast<attribute_type>(retval);
+}
+
+
+/*
+ * ...::detail::hwmon_sensor_impl::hwmon_sensor_impl
+ */
+visus::power_overwhelming::detail::hwmon_sensor_impl::hwmon_sensor_impl(
+        _In_ const std::string& path)
+    : current(invalid_handle_value),
+        energy(invalid_handle_value),
+        last_energy(0),
+        last_power(0),
+        paired(false),
+        path(path),
+        power(invalid_handle_value),
+        voltage(invalid_handle_value) {
+    this->power = open_attribute(this->path, "power1_average");
+    if (this->power == invalid_handle_value) {
+        this->power = open_attribute(this->path, "power1_input");
+    }
+    if (this->power == invalid_handle_value) {
+        this->energy = open_attribute(this->path, "energy1_input");
+    }
+
+    {
+        int current, voltage;
+        find_channels(this->path, voltage, current, this->paired);
+
+        if (current >= 0) {
+            const auto a = "curr" + std::to_string(current) + "_input";
+            this->current = open_attribute(this->path, a.c_str());
+        }
+        if (voltage >= 0) {
+            const auto a = "in" + std::to_string(voltage) + "_input";
+            this->voltage = open_attribute(this->path, a.c_str());
+        }
+
+        this->paired = this->paired
+            && (this->current != invalid_handle_value)
+            && (this->voltage != invalid_handle_value);
+    }
+
+    const auto have_power = (this->power != invalid_handle_value)
+        || (this->energy != invalid_handle_value);
+    if (!have_power && !this->paired) {
+        this->close();
+        throw std::invalid_argument("The hwmon device does not provide "
+            "attributes for measuring power.");
+    }
+
+    try {
+        this->device_name = read_text_attribute(this->path, "name");
+
+        // Establish the reference for computing the power from the energy
+        // counter in the first call to sample().
+        if (this->energy != invalid_handle_value) {
+            this->last_energy = read_attribute(this->energy);
+            this->last_time = std::chrono::system_clock::now();
+        }
+    } catch (...) {
+        this->close();
+        throw;
+    }
+
+    {
+        auto pos = this->path.find_last_of("/\\");
+        auto dir = (pos != std::string::npos)
+            ? this->path.substr(pos + 1)
+            : this->path;
+        auto name = this->device_name.empty() ? dir : this->device_name;
+        this->sensor_name = L"HWMON/"
+            + power_overwhelming::convert_string<wchar_t>(name) + L"/"
+            + power_overwhelming::convert_string<wchar_t>(dir);
+    }
+}
+
+
+/*
+ * ...::detail::hwmon_sensor_impl::~hwmon_sensor_impl
+ */
+visus::power_overwhelming::detail::hwmon_sensor_impl::~hwmon_sensor_impl(
+        void) noexcept {
+    // Make sure that a sensor that is being destroyed is removed from all
+    // asynchronous sampling threads before we close the files.
+    sampler::default_sampler -= this;
+    this->close();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::hwmon_sensor_impl::sample
+ */
+visus::power_overwhelming::measurement_data
+visus::power_overwhelming::detail::hwmon_sensor_impl::sample(void) const {
+    typedef measurement_data::value_type value_type;
+    typedef std::chrono::duration<value_type> seconds_type;
+    static constexpr auto kilo = static_cast<value_type>(1000);
+    static constexpr auto mega = static_cast<value_type>(1000000);
+
+    // Read all attributes right after another such that they form a single
+    // tick with a common timestamp.
+    const auto now = std::chrono::system_clock::now();
+    auto current = measurement_data::invalid_value;
+    auto power = measurement_data::invalid_value;
+    auto voltage = measurement_data::invalid_value;
+
+    if (this->power != invalid_handle_value) {
+        power = static_cast<value_type>(read_attribute(this->power)) / mega;
+
+    } else if (this->energy != invalid_handle_value) {
+        const auto energy = read_attribute(this->energy);
+        const auto dt = std::chrono::duration_cast<seconds_type>(
+            now - this->last_time).count();
+
+        // If the counter did not advance, eg because the driver updates it
+        // less frequently than we sample, or if it wrapped around, we report
+        // the previous power.
+        if ((energy > this->last_energy) && (dt > 0)) {
+            this->last_power = static_cast<value_type>(
+                energy - this->last_energy) / mega / dt;
+            this->last_energy = energy;
+            this->last_time = now;
+        } else if (energy < this->last_energy) {
+            this->last_energy = energy;
+            this->last_time = now;
+        }
+
+        power = this->last_power;
+    }
+
+    if (this->current != invalid_handle_value) {
+        current = static_cast<value_type>(read_attribute(this->current))
+            / kilo;
+    }
+
+    if (this->voltage != invalid_handle_value) {
+        voltage = static_cast<value_type>(read_attribute(this->voltage))
+            / kilo;
+    }
+
+    if ((this->power == invalid_handle_value)
+            && (this->energy == invalid_handle_value)
+            && this->paired) {
+        // Many platform sensors only report voltage and current, which we
+        // have read in the same tick and can derive the power from as long
+        // as both measure the same rail.
+        assert(current != measurement_data::invalid_value);
+        assert(voltage != measurement_data::invalid_value);
+        power = voltage * current;
+    }
+
+    return measurement_data(timestamp(now), voltage, current, power);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::hwmon_sensor_impl::close
+ */
+void visus::power_overwhelming::detail::hwmon_sensor_impl::close(
+        void) noexcept {
+    close_attribute(this->current);
+    close_attribute(this->energy);
+    close_attribute(this->power);
+    close_attribute(this->voltage);
+}
@@ -0,0 +1,164 @@
+﻿// <copyright file="hwmon_sensor_impl.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <chrono>
+#include <cinttypes>
+#include <string>
+
+#include "power_overwhelming/hwmon_sensor.h"
+
+#include "basic_sampler_source.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Private data container for the <see cref="hwmon_sensor" />.
+    /// </summary>
+    struct hwmon_sensor_impl final
+            : public basic_sampler_source<hwmon_sensor_impl> {
+
+        /// <summary>
+        /// The type of a raw value read from an attribute file.
+        /// </summary>
+        typedef std::int64_t attribute_type;
+
+        /// <summary>
+        /// The type of a file descriptor.
+        /// </summary>
+        typedef int handle_type;
+
+        /// <summary>
+        /// Represents an attribute that is not available.
+        /// </summary>
+        static constexpr const handle_type invalid_handle_value = -1;
+
+        /// <summary>
+        /// Opens the specified attribute of the hwmon device in
+        /// <paramref name="path" />.
+        /// </summary>
+        /// <param name="path">The path to the hwmon device.</param>
+        /// <param name="attribute">The name of the attribute file.</param>
+        /// <returns>The file descriptor of the attribute or
+        /// <see cref="invalid_handle_value" /> if the attribute does not exist
+        /// or cannot be read by the calling user.</returns>
+        static handle_type open_attribute(_In_ const std::string& path,
+            _In_z_ const char *attribute) noexcept;
+
+        /// <summary>
+        /// Reads the integral value of the attribute from the start of the
+        /// given open file.
+        /// </summary>
+        /// <param name="handle">The file descriptor of the attribute.</param>
+        /// <returns>The value of the attribute.</returns>
+        /// <exception cref="std::system_error">If the file could not be read.
+        /// </exception>
+        /// <exception cref="std::runtime_error">If the file does not contain
+        /// an integral number.</exception>
+        static attribute_type read_attribute(_In_ const handle_type handle);
+
+        /// <summary>
+        /// The file descriptor of the <c>currN_input</c> attribute used as the
+        /// current.
+        /// </summary>
+        handle_type current;
+
+        /// <summary>
+        /// The name the driver reports for the device.
+        /// </summary>
+        std::string device_name;
+
+        /// <summary>
+        /// The file descriptor of <c>energy1_input</c>, which is only opened
+        /// if there is no power attribute.
+        /// </summary>
+        handle_type energy;
+
+        /// <summary>
+        /// The last value read from <see cref="energy" />.
+        /// </summary>
+        mutable attribute_type last_energy;
+
+        /// <summary>
+        /// The power derived from the last change of <see cref="energy" />.
+        /// </summary>
+        mutable measurement_data::value_type last_power;
+
+        /// <summary>
+        /// The point in time when <see cref="last_energy" /> was read.
+        /// </summary>
+        mutable std::chrono::system_clock::time_point last_time;
+
+        /// <summary>
+        /// Indicates whether <see cref="voltage" /> and <see cref="current" />
+        /// measure the same rail, which is required to derive the power from
+        /// them.
+        /// </summary>
+        bool paired;
+
+        /// <summary>
+        /// The path to the hwmon device.
+        /// </summary>
+        std::string path;
+
+        /// <summary>
+        /// The file descriptor of <c>power1_average</c> or
+        /// <c>power1_input</c>.
+        /// </summary>
+        handle_type power;
+
+        /// <summary>
+        /// The sensor name.
+        /// </summary>
+        std::wstring sensor_name;
+
+        /// <summary>
+        /// The file descriptor of the <c>inN_input</c> attribute used as the
+        /// voltage.
+        /// </summary>
+        handle_type voltage;
+
+        /// <summary>
+        /// Initialises a new instance for the given hwmon device.
+        /// </summary>
+        /// <param name="path">The path to the hwmon device.</param>
+        /// <exception cref="std::invalid_argument">If the device provides
+        /// neither a power or energy attribute nor a voltage and a current
+        /// channel of the same rail.</exception>
+        /// <exception cref="std::system_error">If an attribute could not be
+        /// read.</exception>
+        explicit hwmon_sensor_impl(_In_ const std::string& path);
+
+        hwmon_sensor_impl(const hwmon_sensor_impl&) = delete;
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~hwmon_sensor_impl(void) noexcept;
+
+        /// <summary>
+        /// Reads all available attributes of the device.
+        /// </summary>
+        /// <returns>A measurement from the sensor.</returns>
+        measurement_data sample(void) const;
+
+        hwmon_sensor_impl& operator =(const hwmon_sensor_impl&) = delete;
+
+    private:
+
+        /// <summary>
+        /// Closes all attribute files.
+        /// </summary>
+        void close(void) noexcept;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -6,6 +6,9 @@
 
 #include "io_util.h"
 
+#include <algorithm>
+#include <cerrno>
+#include <climits>
 #include <stdexcept>
 #include <system_error>
 
@@ -184,6 +187,28 @@ void visus::power_overwhelming::detail::read_bytes(_In_ const HANDLE handle,
 #endif /* defined(_WIN32) */
 
 
+/*
+ * visus::power_overwhelming::detail::read_at
+ */
+std::size_t visus::power_overwhelming::detail::read_at(_In_ const int fd,
+        _Out_writes_bytes_(cnt) void *dst,
+        _In_ const std::size_t cnt,
+        _In_ const std::streamoff offset) {
+#if defined(_WIN32)
+    seek(fd, offset, posix_seek_origin::begin);
+    auto retval = ::_read(fd, dst, static_cast<unsigned int>(cnt));
+#else /* defined(_WIN32) */
+    auto retval = ::pread(fd, dst, cnt, offset);
+#endif /* defined(_WIN32) */
+
+    if (retval == -1) {
+        THROW_LAST_ERROR();
+    }
+
+    return static_cast<std::size_t>(retval);
+}
+
+
 /*
  * visus::power_overwhelming::detail::read_bytes
  */
@@ -251,3 +276,59 @@ std::streamoff visus::power_overwhelming::detail::seek(_In_ const int fd,
 
     return retval;
 }
+
+
+#if defined(_WIN32)
+/*
+ * visus::power_overwhelming::detail::write_bytes
+ */
+void visus::power_overwhelming::detail::write_bytes(_In_ const HANDLE handle,
+        _In_reads_bytes_(cnt) const void *src, _In_ const std::size_t cnt) {
+    auto s = static_cast<const std::uint8_t *>(src);
+    auto rem = cnt;
+
+    while (rem > 0) {
+        const auto chunk = static_cast<DWORD>((std::min)(rem,
+            static_cast<std::size_t>(MAXDWORD)));
+        DWORD c = 0;
+
+        if (!::WriteFile(handle, s, chunk, &c, nullptr)) {
+            THROW_LAST_ERROR();
+        }
+
+        s += c;
+        rem -= c;
+    }
+}
+#endif /* defined(_WIN32) */
+
+
+/*
+ * visus::power_overwhelming::detail::write_bytes
+ */
+void visus::power_overwhelming::detail::write_bytes(_In_ const int fd,
+        _In_reads_bytes_(cnt) const void *src, _In_ const std::size_t cnt) {
+    auto s = static_cast<const std::uint8_t *>(src);
+    auto rem = cnt;
+
+    while (rem > 0) {
+#if defined(_WIN32)
+        const auto c = ::_write(fd, s, static_cast<unsigned int>((std::min)(
+            rem, static_cast<std::size_t>(INT_MAX))));
+#else /* defined(_WIN32) */
+        const auto c = ::write(fd, s, rem);
+#endif /* defined(_WIN32) */
+
+        if (c == -1) {
+#if !defined(_WIN32)
+            if (errno == EINTR) {
+                continue;
+            }
+#endif /* !defined(_WIN32) */
+            THROW_LAST_ERROR();
+        }
+
+        s += c;
+        rem -= c;
+    }
+}
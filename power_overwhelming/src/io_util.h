@@ -136,6 +136,27 @@ namespace detail {
         _In_ const HANDLE handle);
 #endif /* defined(_WIN329 */
 
+    /// <summary>
+    /// Reads at most <paramref name="cnt" /> bytes starting at the specified
+    /// offset without moving the file pointer where the platform supports
+    /// this.
+    /// </summary>
+    /// <remarks>
+    /// This is the equivalent of <c>pread</c> and intended for repeatedly
+    /// reading files like sysfs attributes from an already open descriptor.
+    /// On Windows, the file pointer is moved.
+    /// </remarks>
+    /// <param name="fd">The file descriptor to read from.</param>
+    /// <param name="dst">The buffer receiving the data.</param>
+    /// <param name="cnt">The size of <paramref name="dst" /> in bytes.</param>
+    /// <param name="offset">The offset in the file to read from.</param>
+    /// <returns>The number of bytes actually read.</returns>
+    /// <exception cref="std::system_error">If the operation failed.</exception>
+    POWER_OVERWHELMING_API std::size_t read_at(_In_ const int fd,
+        _Out_writes_bytes_(cnt) void *dst,
+        _In_ const std::size_t cnt,
+        _In_ const std::streamoff offset);
+
 #if defined(_WIN32)
     /// <summary>
     /// Reads exactly <paramref name="cnt" /> bytes or fails.
@@ -193,6 +214,29 @@ namespace detail {
         _In_ const std::streamoff offset,
         _In_ const posix_seek_origin origin);
 
+#if defined(_WIN32)
+    /// <summary>
+    /// Writes all of the given bytes to a file.
+    /// </summary>
+    /// <param name="handle">An open file handle.</param>
+    /// <param name="src">The data to be written.</param>
+    /// <param name="cnt">The number of bytes to be written.</param>
+    /// <exception cref="std::system_error">If the operation failed.</exception>
+    POWER_OVERWHELMING_API void write_bytes(_In_ const HANDLE handle,
+        _In_reads_bytes_(cnt) const void *src, _In_ const std::size_t cnt);
+#endif /* defined(_WIN32) */
+
+    /// <summary>
+    /// Writes all of the given bytes to a file, retrying if the operation was
+    /// interrupted or completed only partially.
+    /// </summary>
+    /// <param name="fd">An open file descriptor.</param>
+    /// <param name="src">The data to be written.</param>
+    /// <param name="cnt">The number of bytes to be written.</param>
+    /// <exception cref="std::system_error">If the operation failed.</exception>
+    POWER_OVERWHELMING_API void write_bytes(_In_ const int fd,
+        _In_reads_bytes_(cnt) const void *src, _In_ const std::size_t cnt);
+
 } /* namespace detail */
 } /* namespace power_overwhelming */
 } /* namespace visus */
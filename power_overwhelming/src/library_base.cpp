@@ -105,3 +105,17 @@ visus::power_overwhelming::detail::library_base::get_function(
     return retval;
 }
 
+
+/*
+ * visus::power_overwhelming::detail::library_base::try_get_function
+ */
+visus::power_overwhelming::detail::library_base::function_type
+visus::power_overwhelming::detail::library_base::try_get_function(
+        const char *name) noexcept {
+#if defined(_WIN32)
+    return ::GetProcAddress(this->_handle, name);
+#else /* defined(_WIN32) */
+    return ::dlsym(this->_handle, name);
+#endif /* defined(_WIN32) */
+}
+
@@ -88,6 +88,24 @@ namespace detail {
             return reinterpret_cast<TFunction>(this->get_function(name));
         }
 
+        /// <summary>
+        /// Retrieves the function <paramref name="name" /> if the library
+        /// exports it.
+        /// </summary>
+        /// <remarks>
+        /// This method is intended for functions that have been added in later
+        /// versions of a library and which are therefore optional.
+        /// </remarks>
+        /// <param name="name">The name of the function to retrieve.</param>
+        /// <returns>The address of the function or <c>nullptr</c> if the
+        /// library does not export it.</returns>
+        function_type try_get_function(const char *name) noexcept;
+
+        template<class TFunction>
+        inline TFunction try_get_function(const char *name) noexcept {
+            return reinterpret_cast<TFunction>(this->try_get_function(name));
+        }
+
     private:
 
         handle_type _handle;
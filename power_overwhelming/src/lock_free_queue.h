@@ -0,0 +1,108 @@
+﻿// <copyright file="lock_free_queue.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// A bounded multi-producer, multi-consumer queue that neither locks nor
+    /// allocates when elements are added or removed.
+    /// </summary>
+    /// <remarks>
+    /// <para>The implementation follows Dmitry Vyukov's bounded MPMC queue:
+    /// each cell carries a sequence number which tells producers and
+    /// consumers whether the cell is ready for them, so that a successful
+    /// operation requires only a single compare-and-swap on the respective
+    /// position counter.</para>
+    /// <para>The queue is not fair and operations fail rather than block if
+    /// the queue is full or empty, respectively.</para>
+    /// </remarks>
+    /// <typeparam name="TValue">The type of the elements in the queue, which
+    /// must be trivially copyable.</typeparam>
+    /// <typeparam name="Capacity">The number of elements the queue can hold,
+    /// which must be a power of two.</typeparam>
+    template<class TValue, std::size_t Capacity> class lock_free_queue final {
+
+    public:
+
+        static_assert(std::is_trivially_copyable<TValue>::value, "The "
+            "elements of a lock-free queue must be trivially copyable.");
+        static_assert((Capacity >= 2) && ((Capacity & (Capacity - 1)) == 0),
+            "The capacity of a lock-free queue must be a power of two.");
+
+        /// <summary>
+        /// The type of the elements in the queue.
+        /// </summary>
+        typedef TValue value_type;
+
+        /// <summary>
+        /// The number of elements the queue can hold.
+        /// </summary>
+        static constexpr const std::size_t capacity = Capacity;
+
+        /// <summary>
+        /// Initialises a new, empty instance.
+        /// </summary>
+        lock_free_queue(void) noexcept;
+
+        lock_free_queue(const lock_free_queue&) = delete;
+
+        /// <summary>
+        /// Tries to remove the oldest element from the queue.
+        /// </summary>
+        /// <param name="dst">Receives the element if the operation succeeds.
+        /// </param>
+        /// <returns><c>true</c> if an element was dequeued, <c>false</c> if
+        /// the queue was empty.</returns>
+        bool try_pop(value_type& dst) noexcept;
+
+        /// <summary>
+        /// Tries to append an element to the queue.
+        /// </summary>
+        /// <param name="value">The element to be added.</param>
+        /// <returns><c>true</c> if the element was enqueued, <c>false</c> if
+        /// the queue was full.</returns>
+        bool try_push(const value_type& value) noexcept;
+
+        lock_free_queue& operator =(const lock_free_queue&) = delete;
+
+    private:
+
+        /// <summary>
+        /// The assumed size of a cache line, which is used to prevent false
+        /// sharing between producers and consumers.
+        /// </summary>
+        static constexpr const std::size_t cache_line = 64;
+
+        /// <summary>
+        /// A slot in the ring buffer.
+        /// </summary>
+        struct cell_type {
+            std::atomic<std::size_t> sequence;
+            value_type value;
+        };
+
+        static constexpr const std::size_t mask = Capacity - 1;
+
+        std::array<cell_type, Capacity> _cells;
+        alignas(cache_line) std::atomic<std::size_t> _head;
+        alignas(cache_line) std::atomic<std::size_t> _tail;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+#include "lock_free_queue.inl"
@@ -0,0 +1,115 @@
+﻿// <copyright file="lock_free_queue.inl" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+
+/*
+ * ...::detail::lock_free_queue<TValue, Capacity>::lock_free_queue
+ */
+template<class TValue, std::size_t Capacity>
+visus::power_overwhelming::detail::lock_free_queue<TValue, Capacity>
+::lock_free_queue(void) noexcept : _head(0), _tail(0) {
+    for (std::size_t i = 0; i < Capacity; ++i) {
+        this->_cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+
+/*
+ * ...::detail::lock_free_queue<TValue, Capacity>::try_pop
+ */
+template<class TValue, std::size_t Capacity>
+bool visus::power_overwhelming::detail::lock_free_queue<TValue, Capacity>
+::try_pop(value_type& dst) noexcept {
+    auto pos = this->_head.load(std::memory_order_relaxed);
+
+    while (true) {
+        auto& cell = this->_cells[pos & mask];
+        const auto seq = cell.sequence.load(std::memory_order_acquire);
+        const auto diff = static_cast<std::ptrdiff_t>(seq)
+            - static_cast<std::ptrdiff_t>(pos + 1);
+
+        if (diff == 0) {
+            // The cell has been filled for this round, try to claim it.
+            if (this->_head.compare_exchange_weak(pos, pos + 1,
+                    std::memory_order_relaxed)) {
+                dst = cell.value;
+                // Release the cell for the producers of the next round.
+                cell.sequence.store(pos + Capacity,
+                    std::memory_order_release);
+                return true;
+            }
+
+        } else if (diff < 0) {
+            // The producer has not yet filled the cell, so we are empty.
+            return false;
+
+        } else {
+            // Another consumer was faster, retry with the current head.
+            pos = this->_head.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+
+/*
+ * ...::detail::lock_free_queue<TValue, Capacity>::try_push
+ */
+template<class TValue, std::size_t Capacity>
+bool visus::power_overwhelming::detail::lock_free_queue<TValue, Capacity>
+::try_push(const value_type& value) noexcept {
+    auto pos = this->_tail.load(std::memory_order_relaxed);
+
+    while (true) {
+        auto& cell = this->_cells[pos & mask];
+        const auto seq = cell.sequence.load(std::memory_order_acquire);
+        const auto diff = static_cast<std::ptrdiff_t>(seq)
+            - static_cast<std::ptrdiff_t>(pos);
+
+        if (diff == 0) {
+            // The cell is free for this round, try to claim it.
+            if (this->_tail.compare_exchange_weak(pos, pos + 1,
+                    std::memory_order_relaxed)) {
+                cell.value = value;
+                // Publish the value to the consumers.
+                cell.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+
+        } else if (diff < 0) {
+            // The consumers have not yet emptied the cell, so we are full.
+            return false;
+
+        } else {
+            // Another producer was faster, retry with the current tail.
+            pos = this->_tail.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+
+/*
+ * ...::detail::lock_free_queue<TValue, Capacity>::capacity
+ */
+template<class TValue, std::size_t Capacity>
+constexpr const std::size_t
+visus::power_overwhelming::detail::lock_free_queue<TValue, Capacity>::capacity;
+
+
+/*
+ * ...::detail::lock_free_queue<TValue, Capacity>::cache_line
+ */
+template<class TValue, std::size_t Capacity>
+constexpr const std::size_t
+visus::power_overwhelming::detail::lock_free_queue<TValue, Capacity>
+::cache_line;
+
+
+/*
+ * ...::detail::lock_free_queue<TValue, Capacity>::mask
+ */
+template<class TValue, std::size_t Capacity>
+constexpr const std::size_t
+visus::power_overwhelming::detail::lock_free_queue<TValue, Capacity>::mask;
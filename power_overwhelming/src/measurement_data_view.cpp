@@ -0,0 +1,104 @@
+﻿// <copyright file="measurement_data_view.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/measurement_data_view.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+
+/*
+ * ...::measurement_data_view::measurement_data_view
+ */
+visus::power_overwhelming::measurement_data_view::measurement_data_view(
+        void) noexcept
+    : _currents(nullptr),
+        _increment(0.0),
+        _origin(0),
+        _size(0),
+        _voltages(nullptr) { }
+
+
+/*
+ * ...::measurement_data_view::measurement_data_view
+ */
+visus::power_overwhelming::measurement_data_view::measurement_data_view(
+        _In_reads_(cnt) const value_type *voltages,
+        _In_reads_(cnt) const value_type *currents,
+        _In_ const std::size_t cnt,
+        _In_ const timestamp_type origin,
+        _In_ const double increment)
+    : _currents(currents),
+        _increment(increment),
+        _origin(origin),
+        _size(cnt),
+        _voltages(voltages) {
+    if (cnt > 0) {
+        if (voltages == nullptr) {
+            throw std::invalid_argument("The voltage samples must not be "
+                "nullptr.");
+        }
+        if (currents == nullptr) {
+            throw std::invalid_argument("The current samples must not be "
+                "nullptr.");
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::measurement_data_view::at
+ */
+visus::power_overwhelming::measurement_data
+visus::power_overwhelming::measurement_data_view::at(
+        _In_ const std::size_t i) const {
+    if (i >= this->_size) {
+        throw std::range_error("The specified sample index is out of range.");
+    }
+
+    return measurement_data(this->timestamp(i),
+        this->_voltages[i],
+        this->_currents[i]);
+}
+
+
+/*
+ * visus::power_overwhelming::measurement_data_view::expand
+ */
+std::size_t visus::power_overwhelming::measurement_data_view::expand(
+        _Out_writes_opt_(cnt) measurement_data *dst,
+        _In_ const std::size_t cnt,
+        _In_ const std::size_t offset) const {
+    const auto retval = (offset < this->_size) ? this->_size - offset : 0;
+
+    if (dst != nullptr) {
+        const auto end = offset + (std::min)(cnt, retval);
+        const auto ticks = this->_increment * timestamp_type::tick_rate;
+
+        for (auto i = offset; i < end; ++i) {
+            const auto dt = std::llround(static_cast<double>(i) * ticks);
+            *dst++ = measurement_data(
+                timestamp_type(this->_origin.value() + dt),
+                this->_voltages[i],
+                this->_currents[i]);
+        }
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::measurement_data_view::timestamp
+ */
+visus::power_overwhelming::measurement_data_view::timestamp_type
+visus::power_overwhelming::measurement_data_view::timestamp(
+        _In_ const std::size_t i) const noexcept {
+    const auto dt = static_cast<double>(i) * this->_increment
+        * timestamp_type::tick_rate;
+    return timestamp_type(this->_origin.value() + std::llround(dt));
+}
@@ -0,0 +1,138 @@
+﻿// <copyright file="memory_mapped_file.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "memory_mapped_file.h"
+
+#include <cerrno>
+#include <memory>
+#include <stdexcept>
+#include <system_error>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif /* !defined(_WIN32) */
+
+#include "power_overwhelming/convert_string.h"
+
+#include "io_util.h"
+#include "on_exit.h"
+
+
+/*
+ * ...::memory_mapped_file::memory_mapped_file
+ */
+visus::power_overwhelming::detail::memory_mapped_file::memory_mapped_file(
+        _In_z_ const wchar_t *path) : _data(nullptr), _size(0) {
+    if (path == nullptr) {
+        throw std::invalid_argument("The path to the file to be mapped must "
+            "not be null.");
+    }
+
+#if defined(_WIN32)
+    auto file = detail::open(path, GENERIC_READ, FILE_SHARE_READ,
+        OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS);
+    auto file_guard = on_exit([file](void) { ::CloseHandle(file); });
+
+    {
+        LARGE_INTEGER size;
+        if (!::GetFileSizeEx(file, &size)) {
+            throw std::system_error(::GetLastError(), std::system_category());
+        }
+        this->_size = static_cast<std::size_t>(size.QuadPart);
+    }
+
+    if (this->_size > 0) {
+        // The mapping object can be closed once the view has been created,
+        // because the view keeps it alive.
+        auto mapping = ::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0,
+            nullptr);
+        if (mapping == NULL) {
+            throw std::system_error(::GetLastError(), std::system_category());
+        }
+        auto mapping_guard = on_exit([mapping](void) {
+            ::CloseHandle(mapping);
+        });
+
+        this->_data = static_cast<const byte_type *>(::MapViewOfFile(mapping,
+            FILE_MAP_READ, 0, 0, 0));
+        if (this->_data == nullptr) {
+            throw std::system_error(::GetLastError(), std::system_category());
+        }
+    }
+
+#else /* defined(_WIN32) */
+    const auto p = power_overwhelming::convert_string<char>(path);
+    auto file = detail::open(p.c_str(), O_RDONLY | O_CLOEXEC);
+    auto file_guard = on_exit([file](void) { ::close(file); });
+
+    {
+        struct stat s;
+        if (::fstat(file, &s) != 0) {
+            throw std::system_error(errno, std::system_category());
+        }
+        this->_size = static_cast<std::size_t>(s.st_size);
+    }
+
+    if (this->_size > 0) {
+        // The mapping remains valid after the descriptor has been closed.
+        auto data = ::mmap(nullptr, this->_size, PROT_READ, MAP_SHARED, file,
+            0);
+        if (data == MAP_FAILED) {
+            throw std::system_error(errno, std::system_category());
+        }
+
+        this->_data = static_cast<const byte_type *>(data);
+    }
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * ...::memory_mapped_file::~memory_mapped_file
+ */
+visus::power_overwhelming::detail::memory_mapped_file::~memory_mapped_file(
+        void) {
+    this->unmap();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::memory_mapped_file::operator =
+ */
+visus::power_overwhelming::detail::memory_mapped_file&
+visus::power_overwhelming::detail::memory_mapped_file::operator =(
+        _Inout_ memory_mapped_file&& rhs) noexcept {
+    if (this != std::addressof(rhs)) {
+        this->unmap();
+        this->_data = rhs._data;
+        rhs._data = nullptr;
+        this->_size = rhs._size;
+        rhs._size = 0;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::memory_mapped_file::unmap
+ */
+void visus::power_overwhelming::detail::memory_mapped_file::unmap(
+        void) noexcept {
+    if (this->_data != nullptr) {
+#if defined(_WIN32)
+        ::UnmapViewOfFile(this->_data);
+#else /* defined(_WIN32) */
+        ::munmap(const_cast<byte_type *>(this->_data), this->_size);
+#endif /* defined(_WIN32) */
+        this->_data = nullptr;
+    }
+
+    this->_size = 0;
+}
@@ -0,0 +1,110 @@
+﻿// <copyright file="memory_mapped_file.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#endif /* defined(_WIN32) */
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Maps a whole file read-only into the address space of the process.
+    /// </summary>
+    /// <remarks>
+    /// The mapping allows for reading large files without copying them and
+    /// from multiple threads at the same time. Only the parts of the file that
+    /// are actually accessed are loaded by the operating system.
+    /// </remarks>
+    class POWER_OVERWHELMING_API memory_mapped_file final {
+
+    public:
+
+        /// <summary>
+        /// The type of the bytes in the file.
+        /// </summary>
+        typedef std::uint8_t byte_type;
+
+        /// <summary>
+        /// Initialises a new instance without a file.
+        /// </summary>
+        inline memory_mapped_file(void) noexcept
+            : _data(nullptr), _size(0) { }
+
+        /// <summary>
+        /// Maps the given file.
+        /// </summary>
+        /// <param name="path">The path to the file to be mapped.</param>
+        /// <exception cref="std::invalid_argument">If
+        /// <paramref name="path" /> is <c>nullptr</c>.</exception>
+        /// <exception cref="std::system_error">If the file could not be
+        /// opened or mapped.</exception>
+        explicit memory_mapped_file(_In_z_ const wchar_t *path);
+
+        memory_mapped_file(const memory_mapped_file&) = delete;
+
+        /// <summary>
+        /// Move <paramref name="rhs" /> into a new instance.
+        /// </summary>
+        /// <param name="rhs">The object to be moved.</param>
+        inline memory_mapped_file(_Inout_ memory_mapped_file&& rhs) noexcept
+                : _data(rhs._data), _size(rhs._size) {
+            rhs._data = nullptr;
+            rhs._size = 0;
+        }
+
+        /// <summary>
+        /// Finalises the instance.
+        /// </summary>
+        ~memory_mapped_file(void);
+
+        /// <summary>
+        /// Answer the begin of the mapped file.
+        /// </summary>
+        /// <returns>The begin of the file, which is <c>nullptr</c> if the
+        /// file is empty.</returns>
+        inline _Ret_maybenull_ const byte_type *data(void) const noexcept {
+            return this->_data;
+        }
+
+        /// <summary>
+        /// Answer the size of the mapped file.
+        /// </summary>
+        /// <returns>The size of the file in bytes.</returns>
+        inline std::size_t size(void) const noexcept {
+            return this->_size;
+        }
+
+        memory_mapped_file& operator =(const memory_mapped_file&) = delete;
+
+        /// <summary>
+        /// Move assignment.
+        /// </summary>
+        /// <param name="rhs">The right-hand side operand.</param>
+        /// <returns><c>*this</c>.</returns>
+        memory_mapped_file& operator =(
+            _Inout_ memory_mapped_file&& rhs) noexcept;
+
+    private:
+
+        void unmap(void) noexcept;
+
+        const byte_type *_data;
+        std::size_t _size;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
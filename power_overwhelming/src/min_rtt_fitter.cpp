@@ -0,0 +1,170 @@
+﻿// <copyright file="min_rtt_fitter.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "min_rtt_fitter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+
+/*
+ * visus::power_overwhelming::detail::min_rtt_fitter::min_rtt_fitter
+ */
+visus::power_overwhelming::detail::min_rtt_fitter::min_rtt_fitter(
+        _In_ const std::size_t capacity,
+        _In_ const double rejection_factor,
+        _In_ const timestamp::value_type min_rtt,
+        _In_ const double nominal_slope,
+        _In_ const double max_deviation) noexcept
+    : _capacity(capacity), _max_deviation(max_deviation), _min_rtt(min_rtt),
+        _nominal_slope(nominal_slope), _rejection_factor(rejection_factor) {
+    this->clear();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::min_rtt_fitter::accept
+ */
+bool visus::power_overwhelming::detail::min_rtt_fitter::accept(
+        _In_ const timestamp::value_type rtt) {
+    if (rtt < 0) {
+        // The local clock has been set back while we were probing.
+        return false;
+    }
+
+    if (this->_samples.size() >= 3) {
+        std::vector<timestamp::value_type> rtts;
+        rtts.reserve(this->_samples.size());
+        for (auto& s : this->_samples) {
+            rtts.push_back(s.rtt);
+        }
+
+        auto median = rtts.begin() + rtts.size() / 2;
+        std::nth_element(rtts.begin(), median, rtts.end());
+        const auto limit = this->_rejection_factor * static_cast<double>(
+            (std::max)(*median, this->_min_rtt));
+
+        if ((rtt > limit) && (this->_rejected < this->_capacity)) {
+            ++this->_rejected;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::min_rtt_fitter::add
+ */
+void visus::power_overwhelming::detail::min_rtt_fitter::add(
+        _In_ const sample_type& sample) {
+    this->_rejected = 0;
+
+    if (this->_samples.size() >= this->_capacity) {
+        this->_samples.erase(this->_samples.begin());
+    }
+    this->_samples.push_back(sample);
+
+    this->fit();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::min_rtt_fitter::clear
+ */
+void visus::power_overwhelming::detail::min_rtt_fitter::clear(void) noexcept {
+    this->_intercept = 0.0;
+    this->_reference_x = 0;
+    this->_reference_y = 0;
+    this->_rejected = 0;
+    this->_samples.clear();
+    this->_slope = this->_nominal_slope;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::min_rtt_fitter::roundtrip
+ */
+visus::power_overwhelming::timestamp::value_type
+visus::power_overwhelming::detail::min_rtt_fitter::roundtrip(
+        void) const noexcept {
+    auto it = std::min_element(this->_samples.begin(), this->_samples.end(),
+        [](const sample_type& lhs, const sample_type& rhs) {
+            return (lhs.rtt < rhs.rtt);
+        });
+    return (it != this->_samples.end()) ? it->rtt : 0;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::min_rtt_fitter::operator ()
+ */
+visus::power_overwhelming::detail::min_rtt_fitter::value_type
+visus::power_overwhelming::detail::min_rtt_fitter::operator ()(
+        _In_ const value_type x) const noexcept {
+    const auto dx = static_cast<double>(x - this->_reference_x);
+    return this->_reference_y + std::llround(this->_intercept
+        + this->_slope * dx);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::min_rtt_fitter::fit
+ */
+void visus::power_overwhelming::detail::min_rtt_fitter::fit(void) {
+    // Use the half of the window with the lowest RTT, because the asymmetry of
+    // the round trip, which we cannot measure, is bounded by the RTT.
+    std::vector<const sample_type *> samples;
+    samples.reserve(this->_samples.size());
+    for (auto& s : this->_samples) {
+        samples.push_back(std::addressof(s));
+    }
+
+    const auto cnt = (std::min)(samples.size(),
+        (std::max)(static_cast<std::size_t>(2), (samples.size() + 1) / 2));
+    std::partial_sort(samples.begin(), samples.begin() + cnt, samples.end(),
+            [](const sample_type *lhs, const sample_type *rhs) {
+        return (lhs->rtt < rhs->rtt);
+    });
+    samples.resize(cnt);
+
+    // Fit relative to the newest probe such that the values we are working with
+    // remain small enough for double precision.
+    this->_reference_x = this->_samples.back().x;
+    this->_reference_y = this->_samples.back().y;
+
+    auto mx = 0.0;
+    auto my = 0.0;
+    for (auto s : samples) {
+        mx += static_cast<double>(s->x - this->_reference_x);
+        my += static_cast<double>(s->y - this->_reference_y);
+    }
+    mx /= static_cast<double>(cnt);
+    my /= static_cast<double>(cnt);
+
+    auto sxx = 0.0;
+    auto sxy = 0.0;
+    for (auto s : samples) {
+        const auto x = static_cast<double>(s->x - this->_reference_x) - mx;
+        const auto y = static_cast<double>(s->y - this->_reference_y) - my;
+        sxx += x * x;
+        sxy += x * y;
+    }
+
+    if (sxx > 0.0) {
+        // Only accept a new slope if it is plausible. Otherwise, e.g. if all
+        // selected probes have been taken at the same time, we keep the
+        // previous estimate of the slope and only update the offset.
+        const auto slope = sxy / sxx;
+        if (std::abs(slope - this->_nominal_slope) <= this->_max_deviation) {
+            this->_slope = slope;
+        }
+    }
+
+    this->_intercept = my - this->_slope * mx;
+}
@@ -0,0 +1,164 @@
+﻿// <copyright file="min_rtt_fitter.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <vector>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+#include "power_overwhelming/timestamp.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// A least-squares fit of a linear relation between two clocks, which is
+    /// robust against probes delayed on their round trip.
+    /// </summary>
+    /// <remarks>
+    /// <para>The fitter retains a sliding window of recent probes, each of
+    /// which comprises a time on the first clock, the corresponding value on
+    /// the second clock and the round-trip time (RTT) of the probe. As the
+    /// error caused by an asymmetric round trip is bounded by half of the RTT,
+    /// only the half of the window with the lowest RTT is used for fitting
+    /// offset and slope. Probes with an RTT far above the median of the window
+    /// are rejected altogether.</para>
+    /// <para>This is the common basis of the
+    /// <see cref="tinkerforge_clock_model" /> and the
+    /// <see cref="peer_clock_model" />, which only differ in how they derive
+    /// the coordinates from their probes.</para>
+    /// <para>This class is not thread-safe.</para>
+    /// </remarks>
+    class min_rtt_fitter final {
+
+    public:
+
+        /// <summary>
+        /// The type of the coordinates of the fitted probes.
+        /// </summary>
+        typedef std::int64_t value_type;
+
+        /// <summary>
+        /// A probe reduced to the quantities used for fitting.
+        /// </summary>
+        struct sample_type {
+            value_type x;
+            value_type y;
+            timestamp::value_type rtt;
+        };
+
+        /// <summary>
+        /// Initialises a new instance without any probes.
+        /// </summary>
+        /// <param name="capacity">The maximum number of probes retained in the
+        /// window.</param>
+        /// <param name="rejection_factor">The factor by which the RTT of a
+        /// probe may exceed the median RTT of the window before the probe is
+        /// rejected.</param>
+        /// <param name="min_rtt">The RTT below which probes are never
+        /// rejected, because it cannot be distinguished from jitter.</param>
+        /// <param name="nominal_slope">The slope before the first fit and the
+        /// expected slope of all fits.</param>
+        /// <param name="max_deviation">The maximum absolute deviation from
+        /// <paramref name="nominal_slope" /> that is accepted from a fit. Fits
+        /// beyond this value are considered degenerate and only the offset is
+        /// updated.</param>
+        min_rtt_fitter(_In_ const std::size_t capacity,
+            _In_ const double rejection_factor,
+            _In_ const timestamp::value_type min_rtt,
+            _In_ const double nominal_slope,
+            _In_ const double max_deviation) noexcept;
+
+        /// <summary>
+        /// Answer whether a probe with the given RTT should be added.
+        /// </summary>
+        /// <remarks>
+        /// If the fitter has been rejecting more than the capacity of the
+        /// window in a row, it assumes that the link has become permanently
+        /// slower and accepts the probe anyway.
+        /// </remarks>
+        /// <param name="rtt">The RTT of the probe.</param>
+        /// <returns><c>true</c> if the probe is acceptable, <c>false</c> if it
+        /// is an outlier.</returns>
+        bool accept(_In_ const timestamp::value_type rtt);
+
+        /// <summary>
+        /// Adds a probe that has been accepted to the window and refits the
+        /// model.
+        /// </summary>
+        /// <param name="sample">The sample to be added.</param>
+        void add(_In_ const sample_type& sample);
+
+        /// <summary>
+        /// Discards all probes and resets the model to the nominal slope.
+        /// </summary>
+        void clear(void) noexcept;
+
+        /// <summary>
+        /// Answer whether the window has no probes.
+        /// </summary>
+        /// <returns><c>true</c> if the model cannot be evaluated yet,
+        /// <c>false</c> otherwise.</returns>
+        inline bool empty(void) const noexcept {
+            return this->_samples.empty();
+        }
+
+        /// <summary>
+        /// Answer the lowest RTT in the window.
+        /// </summary>
+        /// <returns>The minimum RTT, or zero if the window is empty.</returns>
+        timestamp::value_type roundtrip(void) const noexcept;
+
+        /// <summary>
+        /// Answer the number of probes in the window.
+        /// </summary>
+        /// <returns>The number of probes.</returns>
+        inline std::size_t size(void) const noexcept {
+            return this->_samples.size();
+        }
+
+        /// <summary>
+        /// Answer the current estimate of the slope.
+        /// </summary>
+        /// <returns>The slope.</returns>
+        inline double slope(void) const noexcept {
+            return this->_slope;
+        }
+
+        /// <summary>
+        /// Evaluates the model at the given position.
+        /// </summary>
+        /// <param name="x">The position on the first clock.</param>
+        /// <returns>The estimated value on the second clock.</returns>
+        value_type operator ()(_In_ const value_type x) const noexcept;
+
+    private:
+
+        /// <summary>
+        /// Refits <see cref="_intercept" /> and <see cref="_slope" /> from the
+        /// probes with the lowest RTT in the window.
+        /// </summary>
+        void fit(void);
+
+        std::size_t _capacity;
+        double _intercept;
+        double _max_deviation;
+        timestamp::value_type _min_rtt;
+        double _nominal_slope;
+        value_type _reference_x;
+        value_type _reference_y;
+        std::size_t _rejected;
+        double _rejection_factor;
+        std::vector<sample_type> _samples;
+        double _slope;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -10,6 +10,9 @@
 #define __POWER_OVERWHELMING_GET_NVML_FUNC(n) \
     this->n = this->get_function<decltype(this->n)>(#n)
 
+#define __POWER_OVERWHELMING_TRY_GET_NVML_FUNC(n) \
+    this->n = this->try_get_function<decltype(this->n)>(#n)
+
 
 /*
  * visus::power_overwhelming::detail::nvidia_management_library::instance
@@ -27,10 +30,18 @@ visus::power_overwhelming::detail::nvidia_management_library::instance(void) {
 visus::power_overwhelming::detail::nvidia_management_library
 ::nvidia_management_library(void)
 #if defined(_WIN32)
-        : library_base(TEXT("nvml.dll")) {
+    : nvidia_management_library(TEXT("nvml.dll")) { }
 #else /* defined(_WIN32) */
-        : library_base("libnvidia-ml.so") {
+    : nvidia_management_library("libnvidia-ml.so") { }
 #endif /* defined(_WIN32) */
+
+
+/*
+ * ...::detail::nvidia_management_library::nvidia_management_library
+ */
+visus::power_overwhelming::detail::nvidia_management_library
+::nvidia_management_library(const char_type *path)
+        : library_base(path) {
     __POWER_OVERWHELMING_GET_NVML_FUNC(nvmlDeviceGetCount);
     __POWER_OVERWHELMING_GET_NVML_FUNC(nvmlDeviceGetName);
     __POWER_OVERWHELMING_GET_NVML_FUNC(nvmlDeviceGetPciInfo);
@@ -43,4 +54,8 @@ visus::power_overwhelming::detail::nvidia_management_library
     __POWER_OVERWHELMING_GET_NVML_FUNC(nvmlErrorString);
     __POWER_OVERWHELMING_GET_NVML_FUNC(nvmlInit);
     __POWER_OVERWHELMING_GET_NVML_FUNC(nvmlShutdown);
+
+    // These functions are not supported by older drivers.
+    __POWER_OVERWHELMING_TRY_GET_NVML_FUNC(nvmlDeviceGetSamples);
+    __POWER_OVERWHELMING_TRY_GET_NVML_FUNC(nvmlDeviceGetTotalEnergyConsumption);
 }
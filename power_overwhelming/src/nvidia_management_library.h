@@ -9,6 +9,7 @@
 #include <nvml.h>
 
 #include "library_base.h"
+#include "nvml_extensions.h"
 
 
 namespace visus {
@@ -34,6 +35,18 @@ namespace detail {
         /// </exception>
         static const nvidia_management_library& instance(void);
 
+        /// <summary>
+        /// Loads the library from the specified location.
+        /// </summary>
+        /// <remarks>
+        /// Applications should use <see cref="instance" />. This constructor
+        /// allows for loading a stub of the library for testing.
+        /// </remarks>
+        /// <param name="path">The path to the library.</param>
+        /// <exception cref="std::system_error">If the library could not
+        /// be loaded.</exception>
+        explicit nvidia_management_library(const char_type *path);
+
         __POWER_OVERWHELMING_NVML_FUNC(nvmlDeviceGetCount);
         __POWER_OVERWHELMING_NVML_FUNC(nvmlDeviceGetName);
         __POWER_OVERWHELMING_NVML_FUNC(nvmlDeviceGetPciInfo);
@@ -47,6 +60,19 @@ namespace detail {
         __POWER_OVERWHELMING_NVML_FUNC(nvmlInit);
         __POWER_OVERWHELMING_NVML_FUNC(nvmlShutdown);
 
+        /// <summary>
+        /// Retrieves the samples from the internal buffer of the driver. This
+        /// function is <c>nullptr</c> if the driver does not provide it.
+        /// </summary>
+        nvml_device_get_samples_func nvmlDeviceGetSamples = nullptr;
+
+        /// <summary>
+        /// Retrieves the energy counter of the GPU. This function is
+        /// <c>nullptr</c> if the driver does not provide it.
+        /// </summary>
+        nvml_device_get_total_energy_consumption_func
+            nvmlDeviceGetTotalEnergyConsumption = nullptr;
+
     private:
 
         nvidia_management_library(void);
@@ -0,0 +1,82 @@
+﻿// <copyright file="nvml_extensions.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <nvml.h>
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /*
+     * The NVML header we are building against predates the APIs for reading
+     * the energy counter and the internal sample buffer of the driver. As
+     * these are part of the stable ABI of NVML, we declare the parts we need
+     * here and load the functions dynamically if the driver provides them.
+     */
+
+    /// <summary>
+    /// Mirrors <c>nvmlSamplingType_t</c>.
+    /// </summary>
+    enum nvml_sampling_type {
+        nvml_total_power_samples = 0
+    };
+
+    /// <summary>
+    /// Mirrors <c>nvmlValueType_t</c>.
+    /// </summary>
+    enum nvml_value_type {
+        nvml_value_type_double = 0,
+        nvml_value_type_unsigned_int = 1,
+        nvml_value_type_unsigned_long = 2,
+        nvml_value_type_unsigned_long_long = 3,
+        nvml_value_type_signed_long_long = 4
+    };
+
+    /// <summary>
+    /// Mirrors <c>nvmlValue_t</c>.
+    /// </summary>
+    union nvml_value {
+        double dVal;
+        unsigned int uiVal;
+        unsigned long ulVal;
+        unsigned long long ullVal;
+        signed long long sllVal;
+    };
+
+    /// <summary>
+    /// Mirrors <c>nvmlSample_t</c>, which holds a sample and the CPU
+    /// timestamp in microseconds when the driver recorded it.
+    /// </summary>
+    struct nvml_sample {
+        unsigned long long timeStamp;
+        nvml_value sampleValue;
+    };
+
+    /// <summary>
+    /// The signature of <c>nvmlDeviceGetSamples</c>.
+    /// </summary>
+    typedef nvmlReturn_t (*nvml_device_get_samples_func)(
+        nvmlDevice_t device,
+        nvml_sampling_type type,
+        unsigned long long lastSeenTimeStamp,
+        nvml_value_type *sampleValType,
+        unsigned int *sampleCount,
+        nvml_sample *samples);
+
+    /// <summary>
+    /// The signature of <c>nvmlDeviceGetTotalEnergyConsumption</c>, which
+    /// returns the energy in millijoules since the driver was last reloaded.
+    /// </summary>
+    typedef nvmlReturn_t (*nvml_device_get_total_energy_consumption_func)(
+        nvmlDevice_t device,
+        unsigned long long *energy);
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,314 @@
+﻿// <copyright file="nvml_power_reader.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "nvml_power_reader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+#include "nvml_exception.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Converts an NVML sample in milliwatts into watts.
+    /// </summary>
+    /// <returns><c>true</c> if the value could be converted, <c>false</c>
+    /// if the type of the value is unknown.</returns>
+    static bool to_watts(_Out_ measurement_data::value_type& dst,
+            _In_ const nvml_value_type type,
+            _In_ const nvml_value& value) noexcept {
+        typedef measurement_data::value_type value_type;
+        static constexpr auto thousand = static_cast<value_type>(1000);
+
+        switch (type) {
+            case nvml_value_type_double:
+                dst = static_cast<value_type>(value.dVal) / thousand;
+                return true;
+
+            case nvml_value_type_unsigned_int:
+                dst = static_cast<value_type>(value.uiVal) / thousand;
+                return true;
+
+            case nvml_value_type_unsigned_long:
+                dst = static_cast<value_type>(value.ulVal) / thousand;
+                return true;
+
+            case nvml_value_type_unsigned_long_long:
+                dst = static_cast<value_type>(value.ullVal) / thousand;
+                return true;
+
+            case nvml_value_type_signed_long_long:
+                dst = static_cast<value_type>(value.sllVal) / thousand;
+                return true;
+
+            default:
+                return false;
+        }
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_power_reader::to_timestamp
+ */
+visus::power_overwhelming::timestamp
+visus::power_overwhelming::detail::nvml_power_reader::to_timestamp(
+        _In_ const unsigned long long microseconds) {
+    using namespace std::chrono;
+    const auto dt = duration_cast<system_clock::duration>(
+        std::chrono::microseconds(microseconds));
+    return timestamp::from_time_point(system_clock::time_point(dt));
+}
+
+
+/*
+ * ...::detail::nvml_power_reader::nvml_power_reader
+ */
+visus::power_overwhelming::detail::nvml_power_reader::nvml_power_reader(
+        _In_ const nvidia_management_library& library) noexcept
+    : _energy(0),
+        _energy_time(timestamp::zero),
+        _last_seen(0),
+        _library(library),
+        _mode(nvml_sampling_mode::power_usage),
+        _power(measurement_data::invalid_value),
+        _power_time(timestamp::zero) { }
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_power_reader::mode
+ */
+void visus::power_overwhelming::detail::nvml_power_reader::mode(
+        _In_ const nvmlDevice_t device,
+        _In_ const nvml_sampling_mode mode) {
+    switch (mode) {
+        case nvml_sampling_mode::power_usage:
+            break;
+
+        case nvml_sampling_mode::energy_consumption:
+            if (this->_library.nvmlDeviceGetTotalEnergyConsumption == nullptr) {
+                throw nvml_exception(NVML_ERROR_FUNCTION_NOT_FOUND, "The "
+                    "installed driver cannot report the energy consumption.");
+            }
+            break;
+
+        case nvml_sampling_mode::power_samples:
+            if (this->_library.nvmlDeviceGetSamples == nullptr) {
+                throw nvml_exception(NVML_ERROR_FUNCTION_NOT_FOUND, "The "
+                    "installed driver cannot report buffered power samples.");
+            }
+            break;
+
+        default:
+            throw std::invalid_argument("The specified sampling mode is "
+                "unknown.");
+    }
+
+    this->_energy = 0;
+    this->_energy_time = timestamp::zero;
+    this->_last_seen = 0;
+    this->_power = measurement_data::invalid_value;
+    this->_power_time = timestamp::zero;
+
+    // Obtain an initial reading, which establishes the reference for the
+    // energy counter and discards the history in the buffer of the driver,
+    // which was recorded before the user requested the samples.
+    switch (mode) {
+        case nvml_sampling_mode::energy_consumption:
+            this->read_energy(device, timestamp::now());
+            break;
+
+        case nvml_sampling_mode::power_samples:
+            this->read_samples(nullptr, device);
+            break;
+
+        default:
+            break;
+    }
+
+    this->_mode = mode;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_power_reader::read
+ */
+visus::power_overwhelming::measurement_data
+visus::power_overwhelming::detail::nvml_power_reader::read(
+        _In_ const nvmlDevice_t device) {
+    const auto now = timestamp::now();
+
+    switch (this->_mode) {
+        case nvml_sampling_mode::energy_consumption:
+            return measurement_data(now, this->read_energy(device, now));
+
+        case nvml_sampling_mode::power_samples:
+            this->read_samples(nullptr, device);
+            if (this->_power_time.value() != 0) {
+                return measurement_data(this->_power_time, this->_power);
+            } else {
+                // The driver has not recorded any sample yet, so the best we
+                // can do is returning its current estimate.
+                return measurement_data(now, this->read_power_usage(device));
+            }
+
+        default:
+            return measurement_data(now, this->read_power_usage(device));
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_power_reader::read
+ */
+std::size_t visus::power_overwhelming::detail::nvml_power_reader::read(
+        _Inout_ std::vector<measurement_data>& dst,
+        _In_ const nvmlDevice_t device) {
+    if (this->_mode == nvml_sampling_mode::power_samples) {
+        return this->read_samples(&dst, device);
+    } else {
+        dst.push_back(this->read(device));
+        return 1;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_power_reader::read_energy
+ */
+visus::power_overwhelming::detail::nvml_power_reader::value_type
+visus::power_overwhelming::detail::nvml_power_reader::read_energy(
+        _In_ const nvmlDevice_t device,
+        _In_ const timestamp now) {
+    unsigned long long energy = 0;
+
+    auto status = this->_library.nvmlDeviceGetTotalEnergyConsumption(device,
+        &energy);
+    if (status != NVML_SUCCESS) {
+        this->throw_error(status);
+    }
+
+    if ((this->_energy_time.value() == 0) || (energy < this->_energy)) {
+        // This is either the first reading or the driver has been reloaded,
+        // which resets the counter. We cannot compute a difference in this
+        // case, so we fall back to the estimate of the driver.
+        this->_power = this->read_power_usage(device);
+        this->_energy = energy;
+        this->_energy_time = now;
+
+    } else if (energy != this->_energy) {
+        // The counter is in millijoules, so we get the power in watts by
+        // dividing the difference by the elapsed time in milliseconds.
+        const auto dt = static_cast<double>(now.value()
+            - this->_energy_time.value()) * 1000.0 / timestamp::tick_rate;
+
+        if (dt > 0.0) {
+            this->_power = static_cast<value_type>(
+                static_cast<double>(energy - this->_energy) / dt);
+            this->_energy = energy;
+            this->_energy_time = now;
+        }
+    }
+    // Note: If the counter has not changed, we keep the reference and report
+    // the previous power such that the next change is distributed over the
+    // whole period since the last update of the counter.
+
+    return this->_power;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_power_reader::read_power_usage
+ */
+visus::power_overwhelming::detail::nvml_power_reader::value_type
+visus::power_overwhelming::detail::nvml_power_reader::read_power_usage(
+        _In_ const nvmlDevice_t device) const {
+    static constexpr auto thousand = static_cast<value_type>(1000);
+
+    // Get the power usage in milliwatts.
+    unsigned int mw = 0;
+    auto status = this->_library.nvmlDeviceGetPowerUsage(device, &mw);
+    if (status != NVML_SUCCESS) {
+        this->throw_error(status);
+    }
+
+    return static_cast<value_type>(mw) / thousand;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_power_reader::read_samples
+ */
+std::size_t visus::power_overwhelming::detail::nvml_power_reader::read_samples(
+        _Inout_opt_ std::vector<measurement_data> *dst,
+        _In_ const nvmlDevice_t device) {
+    auto cnt = 0u;
+    auto type = nvml_value_type_unsigned_int;
+
+    // Ask for the number of samples in the buffer first.
+    auto status = this->_library.nvmlDeviceGetSamples(device,
+        nvml_total_power_samples, this->_last_seen, &type, &cnt, nullptr);
+    if (status == NVML_ERROR_NOT_FOUND) {
+        // There are no new samples since the last call.
+        return 0;
+    } else if (status != NVML_SUCCESS) {
+        this->throw_error(status);
+    }
+
+    this->_buffer.resize(cnt);
+    status = this->_library.nvmlDeviceGetSamples(device,
+        nvml_total_power_samples, this->_last_seen, &type, &cnt,
+        this->_buffer.data());
+    if (status == NVML_ERROR_NOT_FOUND) {
+        return 0;
+    } else if (status != NVML_SUCCESS) {
+        this->throw_error(status);
+    }
+
+    std::size_t retval = 0;
+    cnt = (std::min)(cnt, static_cast<unsigned int>(this->_buffer.size()));
+
+    for (unsigned int i = 0; i < cnt; ++i) {
+        const auto& s = this->_buffer[i];
+        value_type power;
+
+        if ((s.timeStamp <= this->_last_seen)
+                || !to_watts(power, type, s.sampleValue)) {
+            continue;
+        }
+
+        this->_last_seen = s.timeStamp;
+        this->_power = power;
+        this->_power_time = to_timestamp(s.timeStamp);
+
+        if (dst != nullptr) {
+            dst->emplace_back(this->_power_time, this->_power);
+        }
+
+        ++retval;
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_power_reader::throw_error
+ */
+void visus::power_overwhelming::detail::nvml_power_reader::throw_error(
+        _In_ const nvmlReturn_t status) const {
+    // Use the error message of the library we are bound to, which is not
+    // necessarily the global instance used by nvml_exception.
+    throw nvml_exception(status, this->_library.nvmlErrorString(status));
+}
@@ -0,0 +1,148 @@
+﻿// <copyright file="nvml_power_reader.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <vector>
+
+#include "power_overwhelming/measurement_data.h"
+#include "power_overwhelming/nvml_sampling_mode.h"
+#include "power_overwhelming/timestamp.h"
+
+#include "nvidia_management_library.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Obtains the power consumption of an NVML device using one of the
+    /// <see cref="nvml_sampling_mode" />s and tracks the state that is
+    /// required for the modes that are based on differences between two
+    /// readings.
+    /// </summary>
+    /// <remarks>
+    /// The reader is not thread-safe. Callers must serialise all calls to a
+    /// single instance.
+    /// </remarks>
+    class nvml_power_reader final {
+
+    public:
+
+        /// <summary>
+        /// The type used to represent a power reading.
+        /// </summary>
+        typedef measurement_data::value_type value_type;
+
+        /// <summary>
+        /// Converts a CPU timestamp in microseconds since the UNIX epoch as
+        /// reported by NVML into a <see cref="timestamp" />.
+        /// </summary>
+        /// <param name="microseconds">The timestamp reported by NVML.
+        /// </param>
+        /// <returns>The equivalent timestamp.</returns>
+        static timestamp to_timestamp(
+            _In_ const unsigned long long microseconds);
+
+        /// <summary>
+        /// Initialises a new instance which reads the
+        /// <see cref="nvml_sampling_mode::power_usage" />.
+        /// </summary>
+        /// <param name="library">The NVML instance to read from, which must
+        /// live at least as long as the reader.</param>
+        explicit nvml_power_reader(
+            _In_ const nvidia_management_library& library) noexcept;
+
+        nvml_power_reader(const nvml_power_reader&) = delete;
+
+        /// <summary>
+        /// Answer the mode the reader is currently using.
+        /// </summary>
+        /// <returns>The current sampling mode.</returns>
+        inline nvml_sampling_mode mode(void) const noexcept {
+            return this->_mode;
+        }
+
+        /// <summary>
+        /// Changes the sampling mode to read the given
+        /// <paramref name="device" />.
+        /// </summary>
+        /// <remarks>
+        /// Changing the mode resets the state of the reader and obtains an
+        /// initial reading, which allows for checking whether the device
+        /// supports the mode.
+        /// </remarks>
+        /// <param name="device">The device to be sampled.</param>
+        /// <param name="mode">The new sampling mode.</param>
+        /// <exception cref="nvml_exception">If the mode is not supported by
+        /// the driver or the device, or if the initial reading failed.
+        /// </exception>
+        void mode(_In_ const nvmlDevice_t device,
+            _In_ const nvml_sampling_mode mode);
+
+        /// <summary>
+        /// Obtains the most recent power reading from the given
+        /// <paramref name="device" />.
+        /// </summary>
+        /// <remarks>
+        /// In <see cref="nvml_sampling_mode::power_samples" />, the buffer of
+        /// the driver is drained and the most recent sample is returned. If the
+        /// driver has not recorded a new sample, the previous one is returned.
+        /// </remarks>
+        /// <param name="device">The device to be sampled.</param>
+        /// <returns>The most recent power reading.</returns>
+        /// <exception cref="nvml_exception">If the device could not be read.
+        /// </exception>
+        measurement_data read(_In_ const nvmlDevice_t device);
+
+        /// <summary>
+        /// Obtains all new power readings from the given
+        /// <paramref name="device" /> and appends them to
+        /// <paramref name="dst" />.
+        /// </summary>
+        /// <remarks>
+        /// For <see cref="nvml_sampling_mode::power_samples" />, this method
+        /// appends all samples the driver has recorded since the previous
+        /// call, which might be none. For all other modes, exactly one sample
+        /// is appended.
+        /// </remarks>
+        /// <param name="dst">The vector to append the readings to.</param>
+        /// <param name="device">The device to be sampled.</param>
+        /// <returns>The number of readings that have been appended.</returns>
+        /// <exception cref="nvml_exception">If the device could not be read.
+        /// </exception>
+        std::size_t read(_Inout_ std::vector<measurement_data>& dst,
+            _In_ const nvmlDevice_t device);
+
+        nvml_power_reader& operator =(const nvml_power_reader&) = delete;
+
+    private:
+
+        value_type read_energy(_In_ const nvmlDevice_t device,
+            _In_ const timestamp now);
+
+        value_type read_power_usage(_In_ const nvmlDevice_t device) const;
+
+        std::size_t read_samples(
+            _Inout_opt_ std::vector<measurement_data> *dst,
+            _In_ const nvmlDevice_t device);
+
+        [[noreturn]] void throw_error(_In_ const nvmlReturn_t status) const;
+
+        std::vector<nvml_sample> _buffer;
+        unsigned long long _energy;
+        timestamp _energy_time;
+        unsigned long long _last_seen;
+        const nvidia_management_library& _library;
+        nvml_sampling_mode _mode;
+        value_type _power;
+        timestamp _power_time;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,93 @@
+﻿// <copyright file="nvml_sampler.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "nvml_sampler.h"
+
+#include <cassert>
+#include <sstream>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#include <tchar.h>
+#endif /* defined(_WIN32) */
+
+#include "thread_name.h"
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sampler::next_tick
+ */
+visus::power_overwhelming::detail::nvml_sampler::clock_type::time_point
+visus::power_overwhelming::detail::nvml_sampler::next_tick(
+        _In_ const clock_type::time_point now,
+        _In_ const interval_type interval) {
+    using namespace std::chrono;
+    const auto i = duration_cast<clock_type::duration>(interval);
+
+    if (i.count() <= 0) {
+        throw std::invalid_argument("The sampling interval must be positive.");
+    }
+
+    const auto ticks = now.time_since_epoch() / i;
+    return clock_type::time_point((ticks + 1) * i);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sampler::sample
+ */
+void visus::power_overwhelming::detail::nvml_sampler::sample(
+        _In_ std::string guid, _In_ sensor_group *group) {
+    using namespace std::chrono;
+    assert(group != nullptr);
+    auto have_sensors = true;
+
+    {
+        std::stringstream stream;
+        stream << "PwrOwg NVML Sampler for " << guid;
+        auto name = stream.str();
+        set_thread_name(name.c_str());
+#if (defined(_WIN32) && (defined(DEBUG) || defined(_DEBUG)))
+        name += " is starting.\r\n";
+        ::OutputDebugStringA(name.c_str());
+#endif /* (defined(_WIN32) && (defined(DEBUG) || defined(_DEBUG))) */
+    }
+
+    while (have_sensors) {
+        async_sampling::microseconds_type min_sleep = 0;
+
+        {
+            std::lock_guard<decltype(group->lock)> l(group->lock);
+
+            // Each sensor timestamps its reading right at the call to NVML,
+            // so a slow sensor only affects the readings after it on the same
+            // device.
+            for (auto& s : group->sensors) {
+                if (s->async_sampling.minimum_sleep() > min_sleep) {
+                    min_sleep = s->async_sampling.minimum_sleep();
+                }
+
+                s->deliver();
+            }
+
+            have_sensors = !group->sensors.empty();
+        }
+
+        if (have_sensors) {
+            // Sleep until the next tick on the grid, but at least for the
+            // minimum time that allows other threads access to the sensor
+            // list. If the device stalled, this skips the missed ticks.
+            const auto earliest = clock_type::now() + microseconds(min_sleep);
+            std::this_thread::sleep_until(next_tick(earliest,
+                group->interval));
+        }
+    }
+
+#if (defined(_WIN32) && (defined(DEBUG) || defined(_DEBUG)))
+    ::OutputDebugString(_T("PWROWG NVML sampler thread is exiting\r\n"));
+#endif /* (defined(_WIN32) && (defined(DEBUG) || defined(_DEBUG))) */
+}
@@ -0,0 +1,71 @@
+﻿// <copyright file="nvml_sampler.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <chrono>
+#include <string>
+
+#include "custom_sampler_base.h"
+#include "nvml_sensor_impl.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// A customised sampler for NVML sensors, which runs a worker thread for
+    /// each GPU such that a device that blocks in NVML, for instance because
+    /// it is busy or waking up from a low-power state, does not delay the
+    /// readings of all other GPUs.
+    /// </summary>
+    /// <remarks>
+    /// All workers with the same sampling interval wake up on the same grid of
+    /// ticks, which is aligned with the epoch of the clock. Therefore, the
+    /// readings of all GPUs for a tick are taken at the same time. A worker
+    /// that misses ticks because its device stalled skips these ticks rather
+    /// than trying to catch up.
+    /// </remarks>
+    class nvml_sampler final : public custom_sampler_base<nvml_sampler,
+            std::string, nvml_sensor_impl> {
+
+    public:
+
+        /// <summary>
+        /// The clock used to schedule the workers.
+        /// </summary>
+        typedef std::chrono::steady_clock clock_type;
+
+        /// <summary>
+        /// Answer the first tick on the grid defined by
+        /// <paramref name="interval" /> that is after <paramref name="now" />.
+        /// </summary>
+        /// <param name="now">The current point in time.</param>
+        /// <param name="interval">The sampling interval, which must be
+        /// positive.</param>
+        /// <returns>The next tick after <paramref name="now" />.</returns>
+        static clock_type::time_point next_tick(
+            _In_ const clock_type::time_point now,
+            _In_ const interval_type interval);
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        nvml_sampler(void) = default;
+
+    private:
+
+        void sample(_In_ std::string guid, _In_ sensor_group *group);
+
+        friend class custom_sampler_base<nvml_sampler, std::string,
+            nvml_sensor_impl>;
+
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
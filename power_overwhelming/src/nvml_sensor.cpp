@@ -8,11 +8,12 @@
 
 #include <cassert>
 #include <stdexcept>
+#include <string>
 
 #include "nvidia_management_library.h"
 #include "nvml_exception.h"
+#include "nvml_sampler.h"
 #include "nvml_sensor_impl.h"
-#include "sampler.h"
 
 
 /*
@@ -226,6 +227,28 @@ void visus::power_overwhelming::nvml_sensor::sample(
 }
 
 
+/*
+ * visus::power_overwhelming::nvml_sensor::sampling_mode
+ */
+visus::power_overwhelming::nvml_sampling_mode
+visus::power_overwhelming::nvml_sensor::sampling_mode(void) const {
+    this->check_not_disposed();
+    return this->_impl->reader.mode();
+}
+
+
+/*
+ * visus::power_overwhelming::nvml_sensor::sampling_mode
+ */
+visus::power_overwhelming::nvml_sensor&
+visus::power_overwhelming::nvml_sensor::sampling_mode(
+        _In_ const nvml_sampling_mode mode) {
+    this->check_not_disposed();
+    this->_impl->sampling_mode(mode);
+    return *this;
+}
+
+
 /*
  * visus::power_overwhelming::nvml_sensor::operator =
  */
@@ -256,12 +279,20 @@ visus::power_overwhelming::nvml_sensor::operator bool(void) const noexcept {
 void visus::power_overwhelming::nvml_sensor::sample_async(
         _Inout_ async_sampling&& sampling) {
     assert(this->_impl != nullptr);
+    // Make sure that the sensor is not left in the group of its old sampling
+    // rate if it is reconfigured.
+    detail::nvml_sampler::default_sampler.remove(this->_impl);
     this->_impl->async_sampling = std::move(sampling);
 
-    if (this->_impl->async_sampling) {
-        detail::sampler::default_sampler += this->_impl;
-    } else {
-        detail::sampler::default_sampler -= this->_impl;
+    // Like the default sampler, ignore non-positive intervals, which the
+    // worker could not place on its tick grid.
+    if (this->_impl->async_sampling
+            && (this->_impl->async_sampling.interval() > 0)) {
+        // Sensors on the same GPU share a worker thread, unless they are
+        // sampled at different rates.
+        auto key = this->_impl->device_guid + "@"
+            + std::to_string(this->_impl->async_sampling.interval());
+        detail::nvml_sampler::default_sampler.add(key, this->_impl);
     }
 }
 
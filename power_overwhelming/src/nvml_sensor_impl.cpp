@@ -1,5 +1,5 @@
 // <copyright file="nvml_sensor_impl.cpp" company="Visualisierungsinstitut der Universitt Stuttgart">
-// Copyright  2021 - 2023 Visualisierungsinstitut der Universitt Stuttgart.
+// Copyright  2021 - 2024 Visualisierungsinstitut der Universitt Stuttgart.
 // Licensed under the MIT licence. See LICENCE file for details.
 // </copyright>
 // <author>Christoph Mller</author>
@@ -12,7 +12,7 @@
 
 #include "nvidia_management_library.h"
 #include "nvml_exception.h"
-#include "sampler.h"
+#include "nvml_sampler.h"
 
 
 /*
@@ -21,7 +21,54 @@
 visus::power_overwhelming::detail::nvml_sensor_impl::~nvml_sensor_impl(void) {
     // Make sure that a sensor that is being destroyed is removed from all
     // asynchronous sampling threads.
-    sampler::default_sampler -= this;
+    nvml_sampler::default_sampler.remove(this);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::nvml_sensor_impl::deliver
+ */
+bool visus::power_overwhelming::detail::nvml_sensor_impl::deliver(
+        void) const {
+    if (!this->async_sampling) {
+        return false;
+    }
+
+    // Acquire the samples under the lock, but deliver them only after the
+    // lock has been released, because the callback may call sample_sync() or
+    // sampling_mode() on the very same sensor.
+    std::vector<measurement_data> samples;
+
+    {
+        std::lock_guard<decltype(this->lock)> l(this->lock);
+        if (this->reader.mode() != nvml_sampling_mode::power_samples) {
+            samples.push_back(this->reader.read(this->device));
+        } else {
+            // Reuse the allocation of the previous call.
+            samples = std::move(this->buffer);
+            samples.clear();
+
+            if (this->reader.read(samples, this->device) == 0) {
+                // NVML has not recorded any new sample since the last call,
+                // which is not a reason to remove the sensor from the sampler
+                // thread.
+                this->buffer = std::move(samples);
+                return true;
+            }
+        }
+    }
+
+    const auto retval = this->async_sampling.deliver(
+        this->sensor_name.c_str(), samples.data(), samples.size());
+
+    {
+        std::lock_guard<decltype(this->lock)> l(this->lock);
+        if (samples.capacity() > this->buffer.capacity()) {
+            this->buffer = std::move(samples);
+        }
+    }
+
+    return retval;
 }
 
 
@@ -70,22 +117,21 @@ void visus::power_overwhelming::detail::nvml_sensor_impl::load_device_name(
 }
 
 
+/*
+ * visus::power_overwhelming::detail::nvml_sensor_impl::sampling_mode
+ */
+void visus::power_overwhelming::detail::nvml_sensor_impl::sampling_mode(
+        _In_ const nvml_sampling_mode mode) {
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+    this->reader.mode(this->device, mode);
+}
+
+
 /*
  * visus::power_overwhelming::detail::nvml_sensor_impl::sample
  */
 visus::power_overwhelming::measurement_data
 visus::power_overwhelming::detail::nvml_sensor_impl::sample(void) const {
-    static constexpr auto thousand = static_cast<measurement_data::value_type>(1000);
-    const auto timestamp = power_overwhelming::timestamp::now();
-
-    // Get the power usage in milliwatts.
-    unsigned int mw = 0;
-    auto status = detail::nvidia_management_library::instance()
-        .nvmlDeviceGetPowerUsage(this->device, &mw);
-    if (status != NVML_SUCCESS) {
-        throw nvml_exception(status);
-    }
-
-    return measurement_data(timestamp,
-        static_cast<measurement_data::value_type>(mw) / thousand);
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+    return this->reader.read(this->device);
 }
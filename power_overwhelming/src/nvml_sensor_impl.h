@@ -6,13 +6,16 @@
 
 #pragma once
 
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include <nvml.h>
 
 #include "power_overwhelming/timestamp.h"
 
 #include "basic_sampler_source.h"
+#include "nvml_power_reader.h"
 #include "nvml_scope.h"
 
 
@@ -41,12 +44,36 @@ namespace detail {
         /// </summary>
         std::wstring device_name;
 
+        /// <summary>
+        /// Receives the samples drained from the driver in the
+        /// <see cref="nvml_sampling_mode::power_samples" /> mode before they
+        /// are delivered to the asynchronous sampling callback.
+        /// </summary>
+        mutable std::vector<measurement_data> buffer;
+
+        /// <summary>
+        /// Serialises access to the <see cref="reader" />, which is stateful
+        /// and might be used from the sampler thread and the user at the same
+        /// time.
+        /// </summary>
+        mutable std::mutex lock;
+
         /// <summary>
         /// The NVML scope making sure the library is ready while the sensor
         /// exists.
         /// </summary>
+        /// <remarks>
+        /// This member must be declared before the <see cref="reader" />,
+        /// which depends on the library being loaded.
+        /// </remarks>
         nvml_scope scope;
 
+        /// <summary>
+        /// Obtains the power readings from NVML using the configured
+        /// <see cref="nvml_sampling_mode" />.
+        /// </summary>
+        mutable nvml_power_reader reader;
+
         /// <summary>
         /// The sensor name.
         /// </summary>
@@ -55,13 +82,28 @@ namespace detail {
         /// <summary>
         /// Initialises a new instance.
         /// </summary>
-        inline nvml_sensor_impl(void) : device(nullptr) { }
+        inline nvml_sensor_impl(void) : device(nullptr),
+            reader(nvidia_management_library::instance()) { }
 
         /// <summary>
         /// Finalises the instance.
         /// </summary>
         ~nvml_sensor_impl(void);
 
+        /// <summary>
+        /// Deliver all samples obtained since the last call to the
+        /// asynchronous sampling callback.
+        /// </summary>
+        /// <remarks>
+        /// In the <see cref="nvml_sampling_mode::power_samples" /> mode, this
+        /// method delivers all samples that NVML recorded since the last call
+        /// at once, which might be none. In all other modes, a single sample
+        /// is obtained.
+        /// </remarks>
+        /// <returns><c>true</c> if the sensor should remain in the sampler,
+        /// <c>false</c> if asynchronous sampling has been disabled.</returns>
+        bool deliver(void) const override;
+
         /// <summary>
         /// Loads the name of <see cref="device" /> into
         /// <see cref="device_name" />, the device GUID into
@@ -70,6 +112,14 @@ namespace detail {
         /// </summary>
         void load_device_name(void);
 
+        /// <summary>
+        /// Changes the way in which power readings are obtained from NVML.
+        /// </summary>
+        /// <param name="mode">The new sampling mode.</param>
+        /// <exception cref="nvml_exception">If the driver does not support
+        /// the requested mode for the device.</exception>
+        void sampling_mode(_In_ const nvml_sampling_mode mode);
+
         /// <summary>
         /// Sample the sensor.
         /// </summary>
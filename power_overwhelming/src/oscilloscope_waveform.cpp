@@ -10,8 +10,8 @@
 #include <ctime>
 #include <memory>
 
+#include "scpi_parser.h"
 #include "string_functions.h"
-#include "tokenise.h"
 
 
 /*
@@ -60,27 +60,35 @@ visus::power_overwhelming::oscilloscope_waveform::oscilloscope_waveform(
     this->_record_length = samples.size() / sizeof(float);
 
     {
-        const auto date_tokens = detail::tokenise(std::string(segment_date),
-            ",", true);
-        const auto time_tokens = detail::tokenise(std::string(segment_time),
-            ",", true);
-
-        if (date_tokens.size() < 3) {
-            throw std::invalid_argument("The specified segment date does not "
-                "have the expected format.");
+        int date[3];
+        detail::scpi_tokeniser date_tokens(segment_date);
+        std::string_view token;
+
+        for (auto& d : date) {
+            if (!date_tokens.next(token) || !detail::parse_scpi_number(token,
+                    d)) {
+                throw std::invalid_argument("The specified segment date does "
+                    "not have the expected format.");
+            }
         }
-        if (time_tokens.size() < 3) {
+
+        int hours, minutes;
+        float remainder;
+        detail::scpi_tokeniser time_tokens(segment_time);
+
+        if (!time_tokens.next(token)
+                || !detail::parse_scpi_number(token, hours)
+                || !time_tokens.next(token)
+                || !detail::parse_scpi_number(token, minutes)
+                || !time_tokens.next(token)
+                || !detail::parse_scpi_number(token, remainder)) {
             throw std::invalid_argument("The specified segment timestamp does "
                 "not have the expected format.");
         }
 
-        const auto year = std::stoi(date_tokens[0]);
-        const auto month = std::stoi(date_tokens[1]);
-        const auto day = std::stoi(date_tokens[2]);
-
-        const auto hours = std::stoi(time_tokens[0]);
-        const auto minutes = std::stoi(time_tokens[1]);
-        auto remainder = std::stof(time_tokens[2]);
+        const auto year = date[0];
+        const auto month = date[1];
+        const auto day = date[2];
 
         float seconds;
         remainder = std::modf(remainder, &seconds) * 1000;
@@ -95,9 +103,10 @@ visus::power_overwhelming::oscilloscope_waveform::oscilloscope_waveform(
             millis, micros, static_cast<int>(nanos));
     }
 
-    this->_segment_offset = std::atof(segment_offset);
-    this->_time_begin = std::atof(xorg);
-    this->_time_increment = std::atof(xinc);
+    // Values that are not numbers remain zero.
+    detail::parse_scpi_number(segment_offset, this->_segment_offset);
+    detail::parse_scpi_number(xorg, this->_time_begin);
+    detail::parse_scpi_number(xinc, this->_time_increment);
 
     // Do not move samples unless everything else succeeded.
     this->_samples = std::move(samples);
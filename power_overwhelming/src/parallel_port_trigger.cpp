@@ -6,6 +6,7 @@
 
 #include "power_overwhelming/parallel_port_trigger.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cerrno>
 #include <cstdio>
@@ -17,12 +18,15 @@
 
 #if !defined(_WIN32)
 #include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
 #include <unistd.h>
 #include <linux/ppdev.h>
 #include <sys/io.h>
 #include <sys/ioctl.h>
 #endif /* !defined(_WIN32) */
 
+#include "power_overwhelming/collector.h"
 #include "power_overwhelming/convert_string.h"
 
 
@@ -101,6 +105,71 @@ namespace detail {
         { 0, nullptr }
     };
 
+    /// <summary>
+    /// The time before a scheduled pulse at which the calling thread stops
+    /// sleeping and starts spinning.
+    /// </summary>
+    static constexpr std::chrono::milliseconds pulse_spin_time(2);
+
+    /// <summary>
+    /// The real-time priority used while spinning for a scheduled pulse.
+    /// </summary>
+    /// <remarks>
+    /// This is deliberately well below the maximum such that kernel threads
+    /// and interrupt handlers, which typically run at priority 50, are not
+    /// starved by the spinning thread.
+    /// </remarks>
+    static constexpr int pulse_priority = 10;
+
+    /// <summary>
+    /// Raises the priority of the calling thread for its lifetime, ignoring
+    /// any errors.
+    /// </summary>
+    class thread_priority_boost final {
+
+    public:
+
+        thread_priority_boost(void) noexcept {
+#if defined(_WIN32)
+            this->_priority = ::GetThreadPriority(::GetCurrentThread());
+            ::SetThreadPriority(::GetCurrentThread(), THREAD_PRIORITY_HIGHEST);
+#else /* defined(_WIN32) */
+            ::pthread_getschedparam(::pthread_self(), &this->_policy,
+                &this->_param);
+
+            sched_param param { };
+            param.sched_priority = (std::min)(pulse_priority,
+                ::sched_get_priority_max(SCHED_FIFO));
+            // Real-time scheduling requires privileges, so this is best
+            // effort and we just continue at normal priority if it fails.
+            ::pthread_setschedparam(::pthread_self(), SCHED_FIFO, &param);
+#endif /* defined(_WIN32) */
+        }
+
+        thread_priority_boost(const thread_priority_boost&) = delete;
+
+        ~thread_priority_boost(void) noexcept {
+#if defined(_WIN32)
+            ::SetThreadPriority(::GetCurrentThread(), this->_priority);
+#else /* defined(_WIN32) */
+            ::pthread_setschedparam(::pthread_self(), this->_policy,
+                &this->_param);
+#endif /* defined(_WIN32) */
+        }
+
+        thread_priority_boost& operator =(
+            const thread_priority_boost&) = delete;
+
+    private:
+
+#if defined(_WIN32)
+        int _priority;
+#else /* defined(_WIN32) */
+        sched_param _param;
+        int _policy;
+#endif /* defined(_WIN32) */
+    };
+
 } /* namespace detail */
 } /* power_overwhelming */
 } /* visus */
@@ -375,6 +444,87 @@ void visus::power_overwhelming::parallel_port_trigger::pulse(
 }
 
 
+/*
+ * visus::power_overwhelming::parallel_port_trigger::pulse
+ */
+visus::power_overwhelming::timestamp
+visus::power_overwhelming::parallel_port_trigger::pulse(
+        _In_ collector& collector,
+        _In_opt_z_ const wchar_t *marker,
+        _In_ const value_type data,
+        _In_ const milliseconds_type period) const {
+    const auto retval = this->write(data, nullptr);
+    collector.marker(marker, retval);
+    std::this_thread::sleep_for(std::chrono::milliseconds(period));
+    this->write(static_cast<value_type>(0));
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::parallel_port_trigger::pulse_at
+ */
+visus::power_overwhelming::timestamp
+visus::power_overwhelming::parallel_port_trigger::pulse_at(
+        _In_ const timestamp when,
+        _In_ const value_type data,
+        _In_ const milliseconds_type period,
+        _In_opt_ collector *collector,
+        _In_opt_z_ const wchar_t *marker) const {
+    timestamp retval;
+
+    // Sleep until shortly before the pulse and spin afterwards, because the
+    // wake-up from sleeping is too imprecise.
+    {
+        const auto spin = when - detail::pulse_spin_time;
+        const auto now = timestamp::now();
+        if (now < spin) {
+            std::this_thread::sleep_for(spin - now);
+        }
+    }
+
+    {
+        // Only the short spinning phase and the rising edge run at raised
+        // priority.
+        detail::thread_priority_boost boost;
+        while (timestamp::now() < when);
+        retval = this->write(data, nullptr);
+    }
+
+    if (collector != nullptr) {
+        collector->marker(marker, retval);
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(period));
+    this->write(static_cast<value_type>(0));
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::parallel_port_trigger::write
+ */
+visus::power_overwhelming::timestamp
+visus::power_overwhelming::parallel_port_trigger::write(
+        _In_ const value_type data,
+        _Out_opt_ timestamp *before,
+        _Out_opt_ timestamp *after) const {
+    const auto b = timestamp::now();
+    this->write(data);
+    const auto a = timestamp::now();
+
+    if (before != nullptr) {
+        *before = b;
+    }
+    if (after != nullptr) {
+        *after = a;
+    }
+
+    return b + (a - b) / 2;
+}
+
+
 /*
  * visus::power_overwhelming::parallel_port_trigger::write
  */
@@ -0,0 +1,69 @@
+﻿// <copyright file="peer_clock_model.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "peer_clock_model.h"
+
+
+/*
+ * visus::power_overwhelming::detail::peer_clock_model::peer_clock_model
+ */
+visus::power_overwhelming::detail::peer_clock_model::peer_clock_model(
+        void) noexcept
+    // RTTs below 50 µs cannot be distinguished from scheduling jitter, so we
+    // never reject probes below this limit. Both clocks are expected to run at
+    // the same rate, so the offset is nominally constant.
+    : _fitter(capacity, rejection_factor, timestamp::tick_rate / 20000, 0.0,
+        max_drift) { }
+
+
+/*
+ * visus::power_overwhelming::detail::peer_clock_model::add
+ */
+bool visus::power_overwhelming::detail::peer_clock_model::add(
+        _In_ const probe_type& probe) {
+    const auto rtt = probe.receive.value() - probe.send.value();
+
+    if (!this->_fitter.accept(rtt)) {
+        return false;
+    }
+
+    min_rtt_fitter::sample_type sample;
+    sample.x = probe.send.value() + rtt / 2;
+    sample.y = probe.peer.value() - sample.x;
+    sample.rtt = rtt;
+    this->_fitter.add(sample);
+
+    return true;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::peer_clock_model::clear
+ */
+void visus::power_overwhelming::detail::peer_clock_model::clear(
+        void) noexcept {
+    this->_fitter.clear();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::peer_clock_model::capacity
+ */
+constexpr std::size_t
+visus::power_overwhelming::detail::peer_clock_model::capacity;
+
+
+/*
+ * visus::power_overwhelming::detail::peer_clock_model::max_drift
+ */
+constexpr double visus::power_overwhelming::detail::peer_clock_model::max_drift;
+
+
+/*
+ * ...::detail::peer_clock_model::rejection_factor
+ */
+constexpr double
+visus::power_overwhelming::detail::peer_clock_model::rejection_factor;
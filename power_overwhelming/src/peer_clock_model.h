@@ -0,0 +1,168 @@
+﻿// <copyright file="peer_clock_model.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+#include "power_overwhelming/timestamp.h"
+
+#include "min_rtt_fitter.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// An online linear model of the offset between the local clock and the
+    /// clock of a peer node of the <see cref="time_synchroniser" />.
+    /// </summary>
+    /// <remarks>
+    /// <para>The model is fitted from probes following Cristian's algorithm,
+    /// each comprising the local time when a request was sent, the time the
+    /// peer reported in its response and the local time when the response
+    /// arrived. The peer time is assumed to correspond to the midpoint of the
+    /// round trip, so the error caused by an asymmetric round trip is bounded
+    /// by half of the round-trip time (RTT). Therefore, the model only uses the
+    /// probes with the lowest RTT from a sliding window of recent probes to fit
+    /// the offset and its drift via least squares, which is implemented by the
+    /// <see cref="min_rtt_fitter" />.</para>
+    /// <para>This class is not thread-safe.</para>
+    /// </remarks>
+    class peer_clock_model final {
+
+    public:
+
+        /// <summary>
+        /// A single measurement of the clock of the peer.
+        /// </summary>
+        struct probe_type {
+            /// <summary>
+            /// The local time when the request was sent.
+            /// </summary>
+            timestamp send;
+
+            /// <summary>
+            /// The time reported by the peer.
+            /// </summary>
+            timestamp peer;
+
+            /// <summary>
+            /// The local time when the response was received.
+            /// </summary>
+            timestamp receive;
+        };
+
+        /// <summary>
+        /// The maximum number of probes retained in the window.
+        /// </summary>
+        static constexpr std::size_t capacity = 32;
+
+        /// <summary>
+        /// The maximum relative drift that the model accepts from a fit. Fits
+        /// beyond this value are considered degenerate and only the offset is
+        /// updated.
+        /// </summary>
+        static constexpr double max_drift = 0.001;
+
+        /// <summary>
+        /// The factor by which the RTT of a probe may exceed the median RTT of
+        /// the window before the probe is rejected.
+        /// </summary>
+        static constexpr double rejection_factor = 4.0;
+
+        /// <summary>
+        /// Initialises a new instance without any probes.
+        /// </summary>
+        peer_clock_model(void) noexcept;
+
+        /// <summary>
+        /// Adds a new probe to the model and refits it.
+        /// </summary>
+        /// <remarks>
+        /// If the model has been rejecting more than <see cref="capacity" />
+        /// probes in a row, it assumes that the link has become permanently
+        /// slower and accepts the probe anyway.
+        /// </remarks>
+        /// <param name="probe">The probe to be added.</param>
+        /// <returns><c>true</c> if the probe has been used, <c>false</c> if it
+        /// has been rejected as an outlier.</returns>
+        bool add(_In_ const probe_type& probe);
+
+        /// <summary>
+        /// Discards all probes and resets the model to a zero offset.
+        /// </summary>
+        void clear(void) noexcept;
+
+        /// <summary>
+        /// Answer the estimated relative drift of the peer clock.
+        /// </summary>
+        /// <returns>The relative deviation of the rate of the peer clock from
+        /// the rate of the local clock. Multiply by one million to obtain parts
+        /// per million.</returns>
+        inline double drift(void) const noexcept {
+            return this->_fitter.slope();
+        }
+
+        /// <summary>
+        /// Answer whether the model has no probes.
+        /// </summary>
+        /// <returns><c>true</c> if the model cannot translate times yet,
+        /// <c>false</c> otherwise.</returns>
+        inline bool empty(void) const noexcept {
+            return this->_fitter.empty();
+        }
+
+        /// <summary>
+        /// Answer the estimated offset of the peer clock at the given local
+        /// time.
+        /// </summary>
+        /// <param name="local">The local time to compute the offset for.
+        /// </param>
+        /// <returns>The value to be added to <paramref name="local" /> in
+        /// order to obtain the time on the peer, in 100 ns units.</returns>
+        inline timestamp::value_type offset(
+                _In_ const timestamp local) const noexcept {
+            return this->_fitter(local.value());
+        }
+
+        /// <summary>
+        /// Answer the lowest RTT in the window, half of which bounds the error
+        /// of the model.
+        /// </summary>
+        /// <returns>The minimum RTT in 100 ns units, or zero if the model is
+        /// empty.</returns>
+        inline timestamp::value_type roundtrip(void) const noexcept {
+            return this->_fitter.roundtrip();
+        }
+
+        /// <summary>
+        /// Answer the number of probes in the window.
+        /// </summary>
+        /// <returns>The number of probes.</returns>
+        inline std::size_t size(void) const noexcept {
+            return this->_fitter.size();
+        }
+
+        /// <summary>
+        /// Translates the given local time into the time of the peer.
+        /// </summary>
+        /// <param name="local">The local time.</param>
+        /// <returns>The estimated time on the peer.</returns>
+        inline timestamp operator ()(_In_ const timestamp local) const noexcept {
+            return timestamp(local.value() + this->offset(local));
+        }
+
+    private:
+
+        min_rtt_fitter _fitter;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
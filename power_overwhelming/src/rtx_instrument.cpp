@@ -14,6 +14,7 @@
 
 #include "on_exit.h"
 #include "no_visa_error_msg.h"
+#include "scpi_parser.h"
 #include "string_functions.h"
 #include "visa_instrument_impl.h"
 #include "visa_timeout_override.h"
@@ -332,7 +333,17 @@ visus::power_overwhelming::rtx_instrument::ascii_data(
     this->check_system_error();
 
     auto query = detail::format_string("CHAN%u:DATA?\n", channel);
-    return this->query(query.c_str());
+    auto response = this->query(query.c_str());
+
+    // Size the output by scanning for the delimiters first and convert the
+    // values in place afterwards.
+    auto begin = response.as<char>();
+    auto end = begin + response.size();
+    const auto cnt = detail::parse_scpi_array<float>(nullptr, 0, begin, end);
+
+    blob retval(cnt * sizeof(float));
+    detail::parse_scpi_array(retval.as<float>(), cnt, begin, end);
+    return retval;
 
 #else /*defined(POWER_OVERWHELMING_WITH_VISA) */
     throw std::logic_error(detail::no_visa_error_msg);
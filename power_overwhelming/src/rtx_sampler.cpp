@@ -6,6 +6,7 @@
 
 #include "rtx_sampler.h"
 
+#include <algorithm>
 #include <cassert>
 #include <chrono>
 #include <sstream>
@@ -15,7 +16,7 @@
 #include <tchar.h>
 #endif /* defined(_WIN32) */
 
-#include "power_overwhelming/measurement_data_series.h"
+#include "power_overwhelming/measurement_data_view.h"
 #include "power_overwhelming/timestamp.h"
 
 #include "thread_name.h"
@@ -28,7 +29,6 @@ void visus::power_overwhelming::detail::rtx_sampler::sample(
         _In_ std::string path, _In_ sensor_group *group) {
     using namespace std::chrono;
     assert(group != nullptr);
-    std::vector<measurement_data> data;
     auto have_sensors = true;
 
     {
@@ -64,9 +64,10 @@ void visus::power_overwhelming::detail::rtx_sampler::sample(
             // Get all the data we have.
             auto waveforms = dev.data(oscilloscope_waveform_points::maximum);
 
-            // Construct the measurement_data from the sample data. Asynchronous
-            // sampling can deliver batches of measurement_data, so we will
-            // deliver all of the waveform points.
+            // Deliver views of the sample data to the sensors. The samples
+            // are only expanded into measurement_data if the callback of a
+            // sensor requires this, so we neither copy the waveforms nor
+            // compute the timestamps of all samples if not necessary.
             for (auto& s : group->sensors) {
                 if (s->async_sampling.minimum_sleep() > min_sleep) {
                     min_sleep = s->async_sampling.minimum_sleep();
@@ -85,21 +86,18 @@ void visus::power_overwhelming::detail::rtx_sampler::sample(
 
                 if ((current != nullptr) && (voltage != nullptr)) {
                     const auto& current_waveform = current->waveform();
-                    assert(current_waveform.size()
-                        == voltage->waveform().size());
-
-                    data.clear();
-                    data.reserve(current_waveform.size());
-
-                    for (std::size_t i = 0; i < current_waveform.size(); ++i) {
-                        auto timestamp = current_waveform.sample_timestamp(i);
-                        data.emplace_back(timestamp,
-                            voltage->waveform().sample(i),
-                            current->waveform().sample(i));
-                    }
-
-                    s->async_sampling.deliver(s->sensor_name.c_str(),
-                        data.data(), data.size());
+                    const auto& voltage_waveform = voltage->waveform();
+                    assert(current_waveform.size() == voltage_waveform.size());
+
+                    const measurement_data_view view(
+                        voltage_waveform.samples(),
+                        current_waveform.samples(),
+                        (std::min)(current_waveform.size(),
+                            voltage_waveform.size()),
+                        current_waveform.sample_timestamp(0),
+                        current_waveform.sample_distance());
+
+                    s->async_sampling.deliver(s->sensor_name.c_str(), view);
                 }
             }
 
@@ -17,6 +17,7 @@
 #include <vector>
 
 #include "power_overwhelming/convert_string.h"
+#include "power_overwhelming/measurement_data_view.h"
 #include "power_overwhelming/timestamp.h"
 
 #include "rtx_sampler.h"
@@ -299,16 +300,13 @@ visus::power_overwhelming::rtx_sensor::acquire(void) const {
     // Convert the two waveforms into a data series.
     assert(current.record_length() == voltage.record_length());
     measurement_data_series retval(this->name());
-    auto dst = measurement_data_series::resize(retval, current.record_length());
-    const auto dist = std::chrono::duration<float>(current.sample_distance());
-
-    for (std::size_t i = 0; i < current.record_length(); ++i) {
-        throw "TODO";
-        //dst[i] = measurement_data(
-        //    begin.value() + (i * dist),
-        //    voltage.sample(i),
-        //    current.sample(i));
-    }
+    const measurement_data_view view(voltage.samples(),
+        current.samples(),
+        (std::min)(current.record_length(), voltage.record_length()),
+        begin,
+        current.sample_distance());
+    auto dst = measurement_data_series::resize(retval, view.size());
+    view.expand(dst, view.size());
 
     return retval;
 }
@@ -0,0 +1,37 @@
+﻿// <copyright file="scpi_parser.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "scpi_parser.h"
+
+
+/*
+ * visus::power_overwhelming::detail::scpi_tokeniser::next
+ */
+bool visus::power_overwhelming::detail::scpi_tokeniser::next(
+        _Out_ std::string_view& token) noexcept {
+    if (this->_cur == nullptr) {
+        return false;
+    }
+
+    auto end = static_cast<const char *>(::memchr(this->_cur,
+        this->_delimiter, this->_end - this->_cur));
+    auto begin = this->_cur;
+    this->_cur = (end != nullptr) ? end + 1 : nullptr;
+
+    if (end == nullptr) {
+        end = this->_end;
+    }
+
+    while ((begin < end) && is_scpi_space(*begin)) {
+        ++begin;
+    }
+    while ((end > begin) && is_scpi_space(end[-1])) {
+        --end;
+    }
+
+    token = std::string_view(begin, end - begin);
+    return true;
+}
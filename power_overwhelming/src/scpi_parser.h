@@ -0,0 +1,177 @@
+﻿// <copyright file="scpi_parser.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The value SCPI instruments report if a measurement is not a number.
+    /// </summary>
+    constexpr const double scpi_not_a_number = 9.91e37;
+
+    /// <summary>
+    /// Answer whether <paramref name="c" /> is a white space in an SCPI
+    /// response.
+    /// </summary>
+    /// <remarks>
+    /// In contrast to <c>std::isspace</c>, this function does not depend on
+    /// the current locale.
+    /// </remarks>
+    inline constexpr bool is_scpi_space(_In_ const char c) noexcept {
+        return (c == ' ') || (c == '\t') || (c == '\r') || (c == '\n');
+    }
+
+    /// <summary>
+    /// Splits an SCPI response at the given delimiter without copying or
+    /// allocating memory.
+    /// </summary>
+    /// <remarks>
+    /// The tokens returned are views into the input, which must therefore
+    /// outlive the tokeniser. White spaces around the tokens, including the
+    /// line break terminating a response, are removed.
+    /// </remarks>
+    class scpi_tokeniser final {
+
+    public:
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <param name="begin">The begin of the response.</param>
+        /// <param name="end">The end of the response.</param>
+        /// <param name="delimiter">The delimiter between the tokens. This
+        /// parameter defaults to a comma.</param>
+        inline scpi_tokeniser(_In_ const char *begin, _In_ const char *end,
+                _In_ const char delimiter = ',') noexcept
+                : _cur(begin), _delimiter(delimiter), _end(end) {
+            while ((this->_end > this->_cur) && is_scpi_space(this->_end[-1])) {
+                --this->_end;
+            }
+            if (this->_cur == this->_end) {
+                this->_cur = nullptr;
+            }
+        }
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        /// <param name="response">The response to be split.</param>
+        /// <param name="delimiter">The delimiter between the tokens. This
+        /// parameter defaults to a comma.</param>
+        inline explicit scpi_tokeniser(_In_ const std::string_view response,
+                _In_ const char delimiter = ',') noexcept
+            : scpi_tokeniser(response.data(), response.data() + response.size(),
+                delimiter) { }
+
+        /// <summary>
+        /// Retrieves the next token.
+        /// </summary>
+        /// <param name="token">Receives the next token if the method returns
+        /// <c>true</c>.</param>
+        /// <returns><c>true</c> if a token was retrieved, <c>false</c> if the
+        /// end of the response has been reached.</returns>
+        bool next(_Out_ std::string_view& token) noexcept;
+
+    private:
+
+        const char *_cur;
+        char _delimiter;
+        const char *_end;
+    };
+
+    /// <summary>
+    /// Parses a number from an SCPI response independently from the current
+    /// locale.
+    /// </summary>
+    /// <remarks>
+    /// Leading white spaces and a leading plus sign are skipped. Floating-point
+    /// numbers that represent <see cref="scpi_not_a_number" /> are returned as
+    /// quiet NaN.
+    /// </remarks>
+    /// <typeparam name="TValue">The type of the number, which must be an
+    /// arithmetic type supported by <c>std::from_chars</c>.</typeparam>
+    /// <param name="begin">The begin of the text to be parsed.</param>
+    /// <param name="end">The end of the text to be parsed.</param>
+    /// <param name="value">Receives the number if the method succeeds.
+    /// </param>
+    /// <returns>A pointer to the first character after the number, or
+    /// <c>nullptr</c> if the text does not start with a number.</returns>
+    template<class TValue>
+    _Ret_maybenull_ const char *parse_scpi_number(_In_ const char *begin,
+        _In_ const char *end, _Out_ TValue& value) noexcept;
+
+    /// <summary>
+    /// Parses a token retrieved from <see cref="scpi_tokeniser" /> as number.
+    /// </summary>
+    /// <typeparam name="TValue">The type of the number, which must be an
+    /// arithmetic type supported by <c>std::from_chars</c>.</typeparam>
+    /// <param name="token">The token to be parsed.</param>
+    /// <param name="value">Receives the number if the method succeeds.
+    /// </param>
+    /// <returns><c>true</c> if the token starts with a number, <c>false</c>
+    /// otherwise.</returns>
+    template<class TValue>
+    inline bool parse_scpi_number(_In_ const std::string_view token,
+            _Out_ TValue& value) noexcept {
+        return (parse_scpi_number(token.data(), token.data() + token.size(),
+            value) != nullptr);
+    }
+
+    /// <summary>
+    /// Parses a delimited list of numbers like the ASCII representation of
+    /// a waveform.
+    /// </summary>
+    /// <remarks>
+    /// <para>The number of values in the list is determined by counting the
+    /// delimiters in a single pass over the input, which the compiler can
+    /// vectorise. Afterwards, the values are parsed in place. This allows for
+    /// sizing the output before parsing lists of millions of values.</para>
+    /// <para>Following the conventions of the library, callers can pass
+    /// <c>nullptr</c> for <paramref name="dst" /> to determine the number of
+    /// values in the list.</para>
+    /// </remarks>
+    /// <typeparam name="TValue">The type of the numbers, which must be an
+    /// arithmetic type supported by <c>std::from_chars</c>.</typeparam>
+    /// <param name="dst">The buffer receiving the values. This may be
+    /// <c>nullptr</c>.</param>
+    /// <param name="cnt">The number of elements that can be written to
+    /// <paramref name="dst" />.</param>
+    /// <param name="begin">The begin of the list.</param>
+    /// <param name="end">The end of the list.</param>
+    /// <param name="delimiter">The delimiter between the values. This
+    /// parameter defaults to a comma.</param>
+    /// <returns>The number of values in the list, regardless of whether they
+    /// have been written to <paramref name="dst" /> or not.</returns>
+    /// <exception cref="std::invalid_argument">If any of the values written
+    /// to <paramref name="dst" /> is not a number.</exception>
+    template<class TValue>
+    std::size_t parse_scpi_array(_Out_writes_opt_(cnt) TValue *dst,
+        _In_ const std::size_t cnt,
+        _In_ const char *begin,
+        _In_ const char *end,
+        _In_ const char delimiter = ',');
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+#include "scpi_parser.inl"
@@ -0,0 +1,88 @@
+﻿// <copyright file="scpi_parser.inl" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+
+/*
+ * visus::power_overwhelming::detail::parse_scpi_number
+ */
+template<class TValue>
+_Ret_maybenull_ const char *
+visus::power_overwhelming::detail::parse_scpi_number(
+        _In_ const char *begin,
+        _In_ const char *end,
+        _Out_ TValue& value) noexcept {
+    static_assert(std::is_arithmetic<TValue>::value, "SCPI numbers can only "
+        "be parsed into arithmetic types.");
+
+    while ((begin < end) && is_scpi_space(*begin)) {
+        ++begin;
+    }
+    if ((begin < end) && (*begin == '+')) {
+        ++begin;
+    }
+
+    const auto retval = std::from_chars(begin, end, value);
+    if (retval.ec != std::errc()) {
+        return nullptr;
+    }
+
+    if constexpr (std::is_floating_point<TValue>::value) {
+        if (value == static_cast<TValue>(scpi_not_a_number)) {
+            value = std::numeric_limits<TValue>::quiet_NaN();
+        }
+    }
+
+    return retval.ptr;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::parse_scpi_array
+ */
+template<class TValue>
+std::size_t visus::power_overwhelming::detail::parse_scpi_array(
+        _Out_writes_opt_(cnt) TValue *dst,
+        _In_ const std::size_t cnt,
+        _In_ const char *begin,
+        _In_ const char *end,
+        _In_ const char delimiter) {
+    while ((end > begin) && is_scpi_space(end[-1])) {
+        --end;
+    }
+
+    if (begin == end) {
+        return 0;
+    }
+
+    // Counting the delimiters is a tight loop without dependencies, which the
+    // compiler vectorises, in contrast to the parsing below.
+    const auto retval = static_cast<std::size_t>(std::count(begin, end,
+        delimiter)) + 1;
+
+    if (dst != nullptr) {
+        const auto last = (std::min)(cnt, retval);
+        auto cur = begin;
+
+        for (std::size_t i = 0; i < last; ++i) {
+            cur = parse_scpi_number(cur, end, dst[i]);
+            if (cur == nullptr) {
+                throw std::invalid_argument("The SCPI response contains a "
+                    "value that is not a number.");
+            }
+
+            // Skip the delimiter and anything else that follows the number.
+            cur = static_cast<const char *>(::memchr(cur, delimiter,
+                end - cur));
+            if (cur == nullptr) {
+                assert(i == retval - 1);
+                break;
+            }
+            ++cur;
+        }
+    }
+
+    return retval;
+}
@@ -13,6 +13,7 @@
 #include "power_overwhelming/adl_sensor.h"
 #include "power_overwhelming/emi_sensor.h"
 #include "power_overwhelming/hmc8015_sensor.h"
+#include "power_overwhelming/hwmon_sensor.h"
 #include "power_overwhelming/msr_sensor.h"
 #include "power_overwhelming/nvml_sensor.h"
 #include "power_overwhelming/regex_escape.h"
@@ -236,6 +237,28 @@ namespace detail {
         }
     };
 
+    /// <summary>
+    /// Specialisation for <see cref="hwmon_sensor" />.
+    /// </summary>
+    template<> struct sensor_desc<hwmon_sensor> final
+            : detail::sensor_desc_base<sensor_desc<hwmon_sensor>> {
+        POWER_OVERWHELMING_DECLARE_SENSOR_NAME(hwmon_sensor);
+        POWER_OVERWHELMING_DECLARE_INTRINSIC_ASYNC(false);
+
+        static inline value_type deserialise(const nlohmann::json& value) {
+            auto path = value[json_field_path].get<std::string>();
+            return value_type(path.c_str());
+        }
+
+        static inline nlohmann::json serialise(const value_type& value) {
+            return nlohmann::json::object({
+                json_serialise(json_field_type, type_name),
+                json_serialise(json_field_name, value.name()),
+                json_serialise(json_field_path, value.path())
+            });
+        }
+    };
+
     /// <summary>
     /// Specialisation for <see cref="msr_sensor" />.
     /// </summary>
@@ -441,6 +464,7 @@ namespace detail {
         adl_sensor,
         emi_sensor,
         hmc8015_sensor,
+        hwmon_sensor,
         msr_sensor,
         nvml_sensor,
         rtx_sensor,
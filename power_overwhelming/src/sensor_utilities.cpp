@@ -87,6 +87,40 @@ namespace detail {
         } catch (...) { /* Ignore any failing sensor. */ }
     }
 
+    /// <summary>
+    /// Add all sensors of the specified types to the given list of sensors
+    /// and their descriptors to the given JSON array.
+    /// </summary>
+    template<class TSensor, class... TSensors>
+    void add_sensors(std::vector<std::unique_ptr<sensor>>& dst,
+            nlohmann::json& descs,
+            sensor_list_type<TSensor, TSensors ...>) {
+        add_sensors(dst, descs, sensor_list_type<TSensor>());
+        add_sensors(dst, descs, sensor_list_type<TSensors ...>());
+    }
+
+    /// <summary>
+    /// Recursion stop for <see cref="add_sensors" />.
+    /// </summary>
+    template<class TSensor>
+    inline void add_sensors(std::vector<std::unique_ptr<sensor>>& dst,
+            nlohmann::json& descs,
+            sensor_list_type<TSensor>) {
+        try {
+            auto sensors = get_all_sensors_of<TSensor>();
+
+            // Serialise all sensors before moving any of them such that the
+            // list of sensors and descriptors are consistent if one fails.
+            auto d = nlohmann::json::array();
+            for (auto& s : sensors) {
+                d.push_back(sensor_desc<TSensor>::serialise(s));
+            }
+
+            move_sensors(dst, std::move(sensors));
+            descs.insert(descs.end(), d.begin(), d.end());
+        } catch (...) { /* Ignore any failing sensor. */ }
+    }
+
 
     /// <summary>
     /// Check whether the given JSON can be parsed as sensor definition and
@@ -139,6 +173,22 @@ visus::power_overwhelming::detail::get_all_sensors(void) {
 }
 
 
+/*
+ * visus::power_overwhelming::detail::get_all_sensors
+ */
+std::vector<std::unique_ptr<visus::power_overwhelming::sensor>>
+visus::power_overwhelming::detail::get_all_sensors(nlohmann::json& descs) {
+    std::vector<std::unique_ptr<sensor>> retval;
+
+    if (descs.type() != nlohmann::json::value_t::array) {
+        descs = nlohmann::json::array();
+    }
+
+    add_sensors(retval, descs, sensor_list());
+    return retval;
+}
+
+
 
 /*
  * visus::power_overwhelming::detail::parse_sensors
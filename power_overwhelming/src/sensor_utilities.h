@@ -32,6 +32,16 @@ namespace detail {
     /// <returns>A list of all sensors we know on this system.</returns>
     extern std::vector<std::unique_ptr<sensor>> get_all_sensors(void);
 
+    /// <summary>
+    /// Gets all sensors available on the current machine and their serialised
+    /// descriptions.
+    /// </summary>
+    /// <param name="descs">A JSON array that receives the descriptors of the
+    /// sensors returned.</param>
+    /// <returns>A list of all sensors we know on this system.</returns>
+    extern std::vector<std::unique_ptr<sensor>> get_all_sensors(
+        nlohmann::json& descs);
+
     /// <summary>
     /// Gets all sensors of the specified type.
     /// </summary>
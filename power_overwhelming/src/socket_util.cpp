@@ -0,0 +1,282 @@
+﻿// <copyright file="socket_util.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "socket_util.h"
+
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#if defined(_WIN32)
+#include <WS2tcpip.h>
+#else /* defined(_WIN32) */
+#include <errno.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#endif /* defined(_WIN32) */
+
+#include "on_exit.h"
+
+
+#if defined(_WIN32)
+#define THROW_LAST_SOCKET_ERROR() throw std::system_error(::WSAGetLastError(),\
+    std::system_category())
+#else /* defined(_WIN32) */
+#define THROW_LAST_SOCKET_ERROR() throw std::system_error(errno,\
+    std::system_category())
+#endif /* defined(_WIN32) */
+
+
+/*
+ * visus::power_overwhelming::detail::socket_scope::socket_scope
+ */
+visus::power_overwhelming::detail::socket_scope::socket_scope(void) {
+#if defined(_WIN32)
+    WSADATA wsa_data = { };
+    auto status = ::WSAStartup(MAKEWORD(2, 2), &wsa_data);
+    if (status != 0) {
+        throw std::system_error(status, std::system_category());
+    }
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * visus::power_overwhelming::detail::socket_scope::~socket_scope
+ */
+visus::power_overwhelming::detail::socket_scope::~socket_scope(void) {
+#if defined(_WIN32)
+    ::WSACleanup();
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * visus::power_overwhelming::detail::close_socket
+ */
+void visus::power_overwhelming::detail::close_socket(
+        _In_ const socket_type socket) noexcept {
+    if (socket != invalid_socket) {
+#if defined(_WIN32)
+        ::closesocket(socket);
+#else /* defined(_WIN32) */
+        ::close(socket);
+#endif /* defined(_WIN32) */
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::connect_tcp
+ */
+visus::power_overwhelming::detail::socket_type
+visus::power_overwhelming::detail::connect_tcp(_In_z_ const char *host,
+        _In_ const std::uint16_t port) {
+    if (host == nullptr) {
+        throw std::invalid_argument("The host to connect to must not be "
+            "null.");
+    }
+
+    addrinfo hints = { };
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+
+    const auto service = std::to_string(port);
+    addrinfo *addresses = nullptr;
+    {
+        auto status = ::getaddrinfo(host, service.c_str(), &hints, &addresses);
+        if (status != 0) {
+#if defined(_WIN32)
+            throw std::system_error(status, std::system_category());
+#else /* defined(_WIN32) */
+            throw std::runtime_error(::gai_strerror(status));
+#endif /* defined(_WIN32) */
+        }
+    }
+
+    const auto guard_addresses = on_exit([addresses](void) {
+        ::freeaddrinfo(addresses);
+    });
+
+    // Try all addresses the host name resolves to and use the first one that
+    // accepts the connection.
+    for (auto a = addresses; a != nullptr; a = a->ai_next) {
+        auto retval = ::socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (retval == invalid_socket) {
+            continue;
+        }
+
+        if (::connect(retval, a->ai_addr, static_cast<int>(a->ai_addrlen))
+                == 0) {
+            // We send batches ourselves, so there is no need to wait for
+            // more data before sending.
+            int no_delay = 1;
+            ::setsockopt(retval, IPPROTO_TCP, TCP_NODELAY,
+                reinterpret_cast<char *>(&no_delay), sizeof(no_delay));
+            return retval;
+        }
+
+        if (a->ai_next == nullptr) {
+            // This was the last chance, so report the error to the caller.
+            const auto guard_socket = on_exit([retval](void) {
+                close_socket(retval);
+            });
+            THROW_LAST_SOCKET_ERROR();
+        }
+
+        close_socket(retval);
+    }
+
+    THROW_LAST_SOCKET_ERROR();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::listen_tcp
+ */
+visus::power_overwhelming::detail::socket_type
+visus::power_overwhelming::detail::listen_tcp(_In_ const int address_family,
+        _In_ const std::uint16_t port) {
+    if ((address_family != AF_INET) && (address_family != AF_INET6)) {
+        throw std::invalid_argument("Only IPv4 and IPv6 are supported.");
+    }
+
+    auto retval = ::socket(address_family, SOCK_STREAM, IPPROTO_TCP);
+    if (retval == invalid_socket) {
+        THROW_LAST_SOCKET_ERROR();
+    }
+
+    auto guard_socket = on_exit([retval](void) {
+        close_socket(retval);
+    });
+
+    {
+        int reuse = 1;
+        if (::setsockopt(retval, SOL_SOCKET, SO_REUSEADDR,
+                reinterpret_cast<char *>(&reuse), sizeof(reuse)) != 0) {
+            THROW_LAST_SOCKET_ERROR();
+        }
+    }
+
+    switch (address_family) {
+        case AF_INET: {
+            sockaddr_in addr = { };
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(port);
+            if (::bind(retval, reinterpret_cast<sockaddr *>(&addr),
+                    sizeof(addr)) != 0) {
+                THROW_LAST_SOCKET_ERROR();
+            }
+            } break;
+
+        case AF_INET6: {
+            sockaddr_in6 addr = { };
+            addr.sin6_family = AF_INET6;
+            addr.sin6_port = htons(port);
+            if (::bind(retval, reinterpret_cast<sockaddr *>(&addr),
+                    sizeof(addr)) != 0) {
+                THROW_LAST_SOCKET_ERROR();
+            }
+            } break;
+    }
+
+    if (::listen(retval, SOMAXCONN) != 0) {
+        THROW_LAST_SOCKET_ERROR();
+    }
+
+    guard_socket.cancel();
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::receive_all
+ */
+bool visus::power_overwhelming::detail::receive_all(
+        _In_ const socket_type socket,
+        _Out_writes_bytes_(cnt) void *dst,
+        _In_ const std::size_t cnt) {
+    assert((dst != nullptr) || (cnt == 0));
+    auto cur = static_cast<char *>(dst);
+    auto rem = cnt;
+
+    while (rem > 0) {
+        auto read = ::recv(socket, cur, static_cast<int>(rem), 0);
+        if (read == 0) {
+            // Peer closed the connection gracefully.
+            return false;
+        }
+        if (read < 0) {
+#if !defined(_WIN32)
+            if (errno == EINTR) {
+                continue;
+            }
+#endif /* !defined(_WIN32) */
+            THROW_LAST_SOCKET_ERROR();
+        }
+
+        cur += read;
+        rem -= read;
+    }
+
+    return true;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::send_all
+ */
+void visus::power_overwhelming::detail::send_all(
+        _In_ const socket_type socket,
+        _In_reads_bytes_(cnt) const void *data,
+        _In_ const std::size_t cnt) {
+    assert((data != nullptr) || (cnt == 0));
+    auto cur = static_cast<const char *>(data);
+    auto rem = cnt;
+
+#if defined(MSG_NOSIGNAL)
+    // Make sure that we get an error rather than SIGPIPE if the peer is gone.
+    static constexpr int flags = MSG_NOSIGNAL;
+#else /* defined(MSG_NOSIGNAL) */
+    static constexpr int flags = 0;
+#endif /* defined(MSG_NOSIGNAL) */
+
+    while (rem > 0) {
+        auto written = ::send(socket, cur, static_cast<int>(rem), flags);
+        if (written < 0) {
+#if !defined(_WIN32)
+            if (errno == EINTR) {
+                continue;
+            }
+#endif /* !defined(_WIN32) */
+            THROW_LAST_SOCKET_ERROR();
+        }
+
+        cur += written;
+        rem -= written;
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::shutdown_socket
+ */
+void visus::power_overwhelming::detail::shutdown_socket(
+        _In_ const socket_type socket) noexcept {
+    if (socket != invalid_socket) {
+#if defined(_WIN32)
+        ::shutdown(socket, SD_BOTH);
+#else /* defined(_WIN32) */
+        ::shutdown(socket, SHUT_RDWR);
+#endif /* defined(_WIN32) */
+    }
+}
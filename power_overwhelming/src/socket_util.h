@@ -0,0 +1,141 @@
+﻿// <copyright file="socket_util.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <cstddef>
+
+#if defined(_WIN32)
+#include <WinSock2.h>
+#include <Windows.h>
+#endif /* defined(_WIN32) */
+
+#include "power_overwhelming/power_overwhelming_api.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+#if defined(_WIN32)
+    /// <summary>
+    /// The native handle of a socket.
+    /// </summary>
+    typedef SOCKET socket_type;
+
+    /// <summary>
+    /// The value of an invalid socket.
+    /// </summary>
+    constexpr socket_type invalid_socket = INVALID_SOCKET;
+#else /* defined(_WIN32) */
+    typedef int socket_type;
+    constexpr socket_type invalid_socket = -1;
+#endif /* defined(_WIN32) */
+
+    /// <summary>
+    /// Initialises the socket library for the lifetime of the object.
+    /// </summary>
+    /// <remarks>
+    /// This is only required on Windows, where it calls <c>WSAStartup</c>
+    /// and <c>WSACleanup</c>. On all other platforms, the object does
+    /// nothing.
+    /// </remarks>
+    class socket_scope final {
+
+    public:
+
+        /// <summary>
+        /// Initialises the socket library.
+        /// </summary>
+        /// <exception cref="std::system_error">If the socket library could not
+        /// be initialised.</exception>
+        socket_scope(void);
+
+        socket_scope(const socket_scope&) = delete;
+
+        /// <summary>
+        /// Releases the socket library.
+        /// </summary>
+        ~socket_scope(void);
+
+        socket_scope& operator =(const socket_scope&) = delete;
+    };
+
+    /// <summary>
+    /// Closes the given socket if it is valid.
+    /// </summary>
+    /// <param name="socket">The socket to be closed.</param>
+    void close_socket(_In_ const socket_type socket) noexcept;
+
+    /// <summary>
+    /// Opens a TCP connection to the given end point.
+    /// </summary>
+    /// <param name="host">The name or address of the host to connect
+    /// to.</param>
+    /// <param name="port">The port to connect to.</param>
+    /// <returns>The connected socket, which the caller must close using
+    /// <see cref="close_socket" />.</returns>
+    /// <exception cref="std::invalid_argument">If <paramref name="host" />
+    /// is <c>nullptr</c>.</exception>
+    /// <exception cref="std::runtime_error">If the host could not be
+    /// resolved.</exception>
+    /// <exception cref="std::system_error">If the connection could not be
+    /// established.</exception>
+    socket_type connect_tcp(_In_z_ const char *host,
+        _In_ const std::uint16_t port);
+
+    /// <summary>
+    /// Creates a TCP socket that listens on all interfaces on the given port.
+    /// </summary>
+    /// <param name="address_family">The address family, which must be either
+    /// <c>AF_INET</c> or <c>AF_INET6</c>.</param>
+    /// <param name="port">The port to listen on.</param>
+    /// <returns>The listening socket, which the caller must close using
+    /// <see cref="close_socket" />.</returns>
+    /// <exception cref="std::invalid_argument">If the address family is not
+    /// supported.</exception>
+    /// <exception cref="std::system_error">If the socket could not be created
+    /// or bound.</exception>
+    socket_type listen_tcp(_In_ const int address_family,
+        _In_ const std::uint16_t port);
+
+    /// <summary>
+    /// Receives exactly <paramref name="cnt" /> bytes from the given socket.
+    /// </summary>
+    /// <param name="socket">The socket to read from.</param>
+    /// <param name="dst">The buffer receiving at least <paramref name="cnt" />
+    /// bytes.</param>
+    /// <param name="cnt">The number of bytes to read.</param>
+    /// <returns><c>true</c> if all data have been received, <c>false</c> if
+    /// the peer closed the connection gracefully before.</returns>
+    /// <exception cref="std::system_error">If the read failed.</exception>
+    bool receive_all(_In_ const socket_type socket,
+        _Out_writes_bytes_(cnt) void *dst,
+        _In_ const std::size_t cnt);
+
+    /// <summary>
+    /// Sends all of the given data over the given socket.
+    /// </summary>
+    /// <param name="socket">The socket to write to.</param>
+    /// <param name="data">The data to be sent.</param>
+    /// <param name="cnt">The size of <paramref name="data" /> in
+    /// bytes.</param>
+    /// <exception cref="std::system_error">If the write failed.</exception>
+    void send_all(_In_ const socket_type socket,
+        _In_reads_bytes_(cnt) const void *data,
+        _In_ const std::size_t cnt);
+
+    /// <summary>
+    /// Shuts down sending and receiving on the given socket, which wakes any
+    /// thread blocking in a call on the socket.
+    /// </summary>
+    /// <param name="socket">The socket to shut down.</param>
+    void shutdown_socket(_In_ const socket_type socket) noexcept;
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -7,9 +7,12 @@
 #include "string_functions.h"
 
 #include <cmath>
+#include <cstring>
 #include <cwchar>
 #include <stdexcept>
 
+#include "scpi_parser.h"
+
 
 /*
  * visus::power_overwhelming::detail::equals
@@ -70,7 +73,15 @@ bool visus::power_overwhelming::detail::equals(_In_opt_z_ const wchar_t *lhs,
  */
 float visus::power_overwhelming::detail::parse_float(
         _In_opt_z_ const char *str) {
-    return (str != nullptr) ? std::atof(str) : 0.0f;
+    auto retval = 0.0f;
+
+    if (str != nullptr) {
+        // Parse independently from the locale, because the numbers come from
+        // instruments that always use a decimal point.
+        parse_scpi_number(str, str + ::strlen(str), retval);
+    }
+
+    return retval;
 }
 
 
@@ -1,31 +1,49 @@
 ﻿// <copyright file="time_synchroniser.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
-// Copyright © 2022 - 2023 Visualisierungsinstitut der Universität Stuttgart.
+// Copyright © 2022 - 2024 Visualisierungsinstitut der Universität Stuttgart.
 // Licensed under the MIT licence. See LICENCE file for details.
 // </copyright>
 // <author>Christoph Müller</author>
 
 #include "power_overwhelming/time_synchroniser.h"
 
+#include <stdexcept>
+
 #include "time_synchroniser_impl.h"
 
 
+/// <summary>
+/// Throws if the library was compiled without support for the time
+/// synchroniser.
+/// </summary>
+#if defined(POWER_OVERWHELMING_WITH_TIME_SYNCHRONISER)
+#define _PWROWG_CHECK_TIMESYNC()
+#else /* defined(POWER_OVERWHELMING_WITH_TIME_SYNCHRONISER) */
+#define _PWROWG_CHECK_TIMESYNC() throw std::logic_error("The library was "\
+    "compiled without support for Cristian's algorithm.")
+#endif /* defined(POWER_OVERWHELMING_WITH_TIME_SYNCHRONISER) */
+
+
 /*
  * visus::power_overwhelming::time_synchroniser::create
  */
 visus::power_overwhelming::time_synchroniser
 visus::power_overwhelming::time_synchroniser::create(
         _In_ const int address_family,
-        _In_ const std::uint16_t port) {
+        _In_ const std::uint16_t port,
+        _In_ const milliseconds_type probe_interval) {
     time_synchroniser retval;
 
 #if defined(POWER_OVERWHELMING_WITH_TIME_SYNCHRONISER)
-    // TODO: set other options.
+    if (probe_interval == 0) {
+        throw std::invalid_argument("The probe interval must be positive.");
+    }
+
     retval._impl = new detail::time_synchroniser_impl();
+    retval._impl->probe_interval = std::chrono::milliseconds(probe_interval);
     retval._impl->start(address_family, port);
 
 #else /* defined(POWER_OVERWHELMING_WITH_TIME_SYNCHRONISER) */
-    throw std::logic_error("The library was compiled without support for "
-        "Cristian's algorithm.");
+    _PWROWG_CHECK_TIMESYNC();
 #endif /* defined(POWER_OVERWHELMING_WITH_TIME_SYNCHRONISER) */
 
     return retval;
@@ -47,6 +65,7 @@ visus::power_overwhelming::time_synchroniser&
 visus::power_overwhelming::time_synchroniser::operator =(
         _In_ time_synchroniser&& rhs) noexcept {
     if (this != std::addressof(rhs)) {
+        delete this->_impl;
         this->_impl = rhs._impl;
         rhs._impl = nullptr;
     }
@@ -55,6 +74,99 @@ visus::power_overwhelming::time_synchroniser::operator =(
 }
 
 
+/*
+ * visus::power_overwhelming::time_synchroniser::add_peer
+ */
+visus::power_overwhelming::time_synchroniser&
+visus::power_overwhelming::time_synchroniser::add_peer(
+        _In_z_ const char *host,
+        _In_ const std::uint16_t port) {
+    _PWROWG_CHECK_TIMESYNC();
+#if defined(POWER_OVERWHELMING_WITH_TIME_SYNCHRONISER)
+    this->check_not_disposed();
+    this->_impl->add_peer(host, port);
+#endif /* defined(POWER_OVERWHELMING_WITH_TIME_SYNCHRONISER) */
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::time_synchroniser::reference_peer
+ */
+visus::power_overwhelming::time_synchroniser&
+visus::power_overwhelming::time_synchroniser::reference_peer(
+        _In_opt_z_ const char *host,
+        _In_ const std::uint16_t port) {
+    _PWROWG_CHECK_TIMESYNC();
+#if defined(POWER_OVERWHELMING_WITH_TIME_SYNCHRONISER)
+    this->check_not_disposed();
+
+    if (host == nullptr) {
+        std::lock_guard<decltype(this->_impl->lock)> l(this->_impl->lock);
+        this->_impl->reference = nullptr;
+
+    } else {
+        // Note: add_peer acquires the lock itself, but the model returned
+        // will not move in the map, so we can safely use it afterwards.
+        auto& peer = this->_impl->add_peer(host, port);
+        std::lock_guard<decltype(this->_impl->lock)> l(this->_impl->lock);
+        this->_impl->reference = &peer;
+    }
+#endif /* defined(POWER_OVERWHELMING_WITH_TIME_SYNCHRONISER) */
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::time_synchroniser::synchronised
+ */
+bool visus::power_overwhelming::time_synchroniser::synchronised(void) const {
+    _PWROWG_CHECK_TIMESYNC();
+#if defined(POWER_OVERWHELMING_WITH_TIME_SYNCHRONISER)
+    this->check_not_disposed();
+    std::lock_guard<decltype(this->_impl->lock)> l(this->_impl->lock);
+    return ((this->_impl->reference == nullptr)
+        || !this->_impl->reference->empty());
+#endif /* defined(POWER_OVERWHELMING_WITH_TIME_SYNCHRONISER) */
+}
+
+
+/*
+ * visus::power_overwhelming::time_synchroniser::to_reference
+ */
+visus::power_overwhelming::timestamp
+visus::power_overwhelming::time_synchroniser::to_reference(
+        _In_ const power_overwhelming::timestamp timestamp) const {
+    _PWROWG_CHECK_TIMESYNC();
+#if defined(POWER_OVERWHELMING_WITH_TIME_SYNCHRONISER)
+    this->check_not_disposed();
+    std::lock_guard<decltype(this->_impl->lock)> l(this->_impl->lock);
+    auto reference = this->_impl->reference;
+    return ((reference != nullptr) && !reference->empty())
+        ? (*reference)(timestamp)
+        : timestamp;
+#endif /* defined(POWER_OVERWHELMING_WITH_TIME_SYNCHRONISER) */
+}
+
+
+/*
+ * visus::power_overwhelming::time_synchroniser::to_reference
+ */
+void visus::power_overwhelming::time_synchroniser::to_reference(
+        _Inout_updates_(cnt) measurement_data *data,
+        _In_ const std::size_t cnt) const {
+    _PWROWG_CHECK_TIMESYNC();
+#if defined(POWER_OVERWHELMING_WITH_TIME_SYNCHRONISER)
+    this->check_not_disposed();
+    if ((data == nullptr) && (cnt > 0)) {
+        throw std::invalid_argument("The sample array must not be null.");
+    }
+
+    this->_impl->to_reference(data, cnt);
+#endif /* defined(POWER_OVERWHELMING_WITH_TIME_SYNCHRONISER) */
+}
+
+
 /*
  * visus::power_overwhelming::time_synchroniser::operator bool
  */
@@ -62,3 +174,22 @@ visus::power_overwhelming::time_synchroniser::operator bool(
         void) const noexcept {
     return (this->_impl != nullptr);
 }
+
+
+/*
+ * visus::power_overwhelming::time_synchroniser::check_not_disposed
+ */
+void visus::power_overwhelming::time_synchroniser::check_not_disposed(
+        void) const {
+    if (this->_impl == nullptr) {
+        throw std::runtime_error("The time_synchroniser has been moved to "
+            "another instance wherefore it cannot be used anymore.");
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::time_synchroniser::default_probe_interval
+ */
+constexpr visus::power_overwhelming::time_synchroniser::milliseconds_type
+visus::power_overwhelming::time_synchroniser::default_probe_interval;
@@ -1,5 +1,5 @@
 // <copyright file="time_synchroniser_impl.cpp" company="Visualisierungsinstitut der Universitt Stuttgart">
-// Copyright  2022 - 2023 Visualisierungsinstitut der Universitt Stuttgart.
+// Copyright  2022 - 2024 Visualisierungsinstitut der Universitt Stuttgart.
 // Licensed under the MIT licence. See LICENCE file for details.
 // </copyright>
 // <author>Christoph Mller</author>
@@ -7,16 +7,22 @@
 #if defined(POWER_OVERWHELMING_WITH_TIME_SYNCHRONISER)
 #include "time_synchroniser_impl.h"
 
+#include <algorithm>
 #include <cassert>
 #include <chrono>
 #include <cstring>
+#include <stdexcept>
+#include <string>
 #include <system_error>
+#include <type_traits>
 
 #if defined(_WIN32)
 #include <WS2tcpip.h>
 #else /* defined(_WIN32) */
 #include <errno.h>
+#include <netdb.h>
 #include <unistd.h>
+#include <sys/time.h>
 #endif /* defined(_WIN32) */
 
 #include "on_exit.h"
@@ -43,25 +49,68 @@ static inline int WSAGetLastError(void) {
 #endif /* !defined(_WIN32) */
 
 
+/// <summary>
+/// The timeout of the receiver, which determines how fast it notices that it
+/// should exit.
+/// </summary>
+static constexpr unsigned int timesync_receive_timeout = 100;
+
+
+/// <summary>
+/// Answer the length of the given socket address.
+/// </summary>
+static inline socklen_t address_length(const sockaddr_storage& address) {
+    switch (address.ss_family) {
+        case AF_INET: return sizeof(sockaddr_in);
+        case AF_INET6: return sizeof(sockaddr_in6);
+        default: return sizeof(sockaddr_storage);
+    }
+}
+
+
+/// <summary>
+/// Closes the given socket.
+/// </summary>
+static inline void close_socket(SOCKET socket) {
+#if defined(_WIN32)
+    ::closesocket(socket);
+#else /* defined(_WIN32) */
+    ::close(socket);
+#endif /* defined(_WIN32) */
+}
+
+
 /*
- * std::less<sockaddr>::operator ()
+ * std::less<sockaddr_storage>::operator ()
  */
-bool std::less<sockaddr>::operator ()(const sockaddr & lhs,
-        const sockaddr & rhs) const {
-    if (lhs.sa_family == rhs.sa_family) {
-        switch (lhs.sa_family) {
-            case AF_INET:
-                return (::memcmp(&lhs, &rhs, sizeof(sockaddr_in)) < 0);
+bool std::less<sockaddr_storage>::operator ()(const sockaddr_storage& lhs,
+        const sockaddr_storage& rhs) const {
+    if (lhs.ss_family == rhs.ss_family) {
+        switch (lhs.ss_family) {
+            case AF_INET: {
+                auto& l = reinterpret_cast<const sockaddr_in&>(lhs);
+                auto& r = reinterpret_cast<const sockaddr_in&>(rhs);
+                auto retval = ::memcmp(&l.sin_addr, &r.sin_addr,
+                    sizeof(l.sin_addr));
+                return (retval != 0) ? (retval < 0) : (l.sin_port < r.sin_port);
+            }
 
-            case AF_INET6:
-                return (::memcmp(&lhs, &rhs, sizeof(sockaddr_in6)) < 0);
+            case AF_INET6: {
+                auto& l = reinterpret_cast<const sockaddr_in6&>(lhs);
+                auto& r = reinterpret_cast<const sockaddr_in6&>(rhs);
+                auto retval = ::memcmp(&l.sin6_addr, &r.sin6_addr,
+                    sizeof(l.sin6_addr));
+                return (retval != 0)
+                    ? (retval < 0)
+                    : (l.sin6_port < r.sin6_port);
+            }
 
             default:
-                return (::memcmp(&lhs, &rhs, sizeof(sockaddr)) < 0);
+                return (::memcmp(&lhs, &rhs, sizeof(sockaddr_storage)) < 0);
         }
 
     } else {
-        return lhs.sa_family < rhs.sa_family;
+        return lhs.ss_family < rhs.ss_family;
     }
 }
 
@@ -70,8 +119,9 @@ bool std::less<sockaddr>::operator ()(const sockaddr & lhs,
  * visus::power_overwhelming::detail::time_synchroniser_impl::time_synchroniser_impl
  */
 visus::power_overwhelming::detail::time_synchroniser_impl
-::time_synchroniser_impl(void) : grace_period(2), socket(INVALID_SOCKET),
-    state(0) { }
+::time_synchroniser_impl(void) : address_family(AF_UNSPEC), grace_period(2),
+    probe_interval(1000), reference(nullptr), sequence_number(0),
+    socket(INVALID_SOCKET), state(0), stop_event(create_event(true, false)) { }
 
 
 /*
@@ -80,10 +130,49 @@ visus::power_overwhelming::detail::time_synchroniser_impl
 visus::power_overwhelming::detail::time_synchroniser_impl
 ::~time_synchroniser_impl(void) {
     this->stop();
+    destroy_event(this->stop_event);
+}
 
-    if (this->receiver.joinable()) {
-        this->receiver.join();
+
+/*
+ * visus::power_overwhelming::detail::time_synchroniser_impl::add_peer
+ */
+visus::power_overwhelming::detail::peer_clock_model&
+visus::power_overwhelming::detail::time_synchroniser_impl::add_peer(
+        const char *host, const std::uint16_t port) {
+    if (host == nullptr) {
+        throw std::invalid_argument("The host name of a peer must not be "
+            "null.");
     }
+
+    addrinfo hints = { };
+    hints.ai_family = this->address_family;
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_protocol = IPPROTO_UDP;
+
+    const auto service = std::to_string(port);
+    addrinfo *addresses = nullptr;
+    {
+        auto status = ::getaddrinfo(host, service.c_str(), &hints, &addresses);
+        if (status != 0) {
+#if defined(_WIN32)
+            throw std::system_error(status, std::system_category());
+#else /* defined(_WIN32) */
+            throw std::runtime_error(::gai_strerror(status));
+#endif /* defined(_WIN32) */
+        }
+    }
+
+    const auto guard_addresses = on_exit([addresses](void) {
+        ::freeaddrinfo(addresses);
+    });
+
+    address_type address = { };
+    assert(addresses->ai_addrlen <= sizeof(address));
+    ::memcpy(&address, addresses->ai_addr, addresses->ai_addrlen);
+
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+    return this->peers[address];
 }
 
 
@@ -106,73 +195,161 @@ void visus::power_overwhelming::detail::time_synchroniser_impl::on_request(
  * visus::power_overwhelming::detail::time_synchroniser_impl::on_response
  */
 void visus::power_overwhelming::detail::time_synchroniser_impl::on_response(
-        const tsmsg_response *response, const sockaddr& addr,
-        const int addr_length) {
+        const tsmsg_response *response, const address_type& addr) {
     assert(response != nullptr);
     const auto now = timestamp::now();
 
-    // Search the corresponding request for this response. Also, clear all
-    // all orphaned requests in the same pass.
     std::lock_guard<decltype(this->lock)> _l(this->lock);
-    for (auto it = this->requests.begin(); it != this->requests.end(); ++it) {
+    const auto timeout = this->probe_interval * this->grace_period;
+    auto peer = this->peers.find(addr);
+
+    // Search the corresponding request for this response. Also, clear all
+    // orphaned requests in the same pass.
+    for (auto it = this->requests.begin(); it != this->requests.end();) {
         if (it->sequence_number == response->sequence_number) {
             // We found a corresponding request for the response. Update the
-            // estimate for the clock drift based on the round trip time of the
-            // request/response pair and the time we received from the server.
-            assert(it->timestamp >= now);
-            const auto roundtrip = now - it->timestamp;
-            auto& peer = this->peers[addr];
-
-            if (peer.roundtrip > roundtrip.count()) {
-                auto server_time = response->timestamp.value()
-                    + (0.5 * roundtrip.count());
-                peer.roundtrip = roundtrip.count();
-                peer.timestamp = now;
-                peer.drift = server_time - now;
+            // model of the peer clock based on the round trip time of the
+            // request/response pair and the time we received from the peer.
+            assert(now >= it->timestamp);
+            if (peer != this->peers.end()) {
+                peer->second.add({ it->timestamp, response->timestamp, now });
             }
 
             it = this->requests.erase(it);
 
-        } else if (it->sequence_number + this->grace_period
-                < response->sequence_number) {
+        } else if (now - it->timestamp > timeout) {
             // We consider this request to be orphaned, so we delete it. If we
             // still receive a response for it, it will be ignored.
             it = this->requests.erase(it);
+
+        } else {
+            ++it;
         }
     }
 }
 
 
+/*
+ * visus::power_overwhelming::detail::time_synchroniser_impl::probe
+ */
+void visus::power_overwhelming::detail::time_synchroniser_impl::probe(void) {
+    const auto interval = static_cast<unsigned int>(
+        this->probe_interval.count());
+
+    do {
+        std::lock_guard<decltype(this->lock)> l(this->lock);
+
+        {
+            // Discard the requests that will not be answered anymore, because
+            // unlike on_response, this also runs if no peer answers at all.
+            const auto now = timestamp::now();
+            const auto timeout = this->probe_interval * this->grace_period;
+            auto end = std::remove_if(this->requests.begin(),
+                this->requests.end(),
+                [now, timeout](const tsmsg_request& r) {
+                    return (now - r.timestamp > timeout);
+                });
+            this->requests.erase(end, this->requests.end());
+        }
+
+        for (auto& p : this->peers) {
+            this->requests.emplace_back(this->sequence_number++);
+            auto& request = this->requests.back();
+
+            // Note: fire and forget. If the request is lost, it will be
+            // discarded once the grace period is over.
+            ::sendto(this->socket, reinterpret_cast<char *>(&request),
+                sizeof(request), 0,
+                reinterpret_cast<const sockaddr *>(&p.first),
+                address_length(p.first));
+        }
+    } while (!wait_event(this->stop_event, interval));
+}
+
+
 /*
  * visus::power_overwhelming::detail::time_synchroniser_impl::receive
  */
 void visus::power_overwhelming::detail::time_synchroniser_impl::receive(
-        const int address_family, const std::uint16_t port) {
-    assert(this->socket == INVALID_SOCKET);
+        void) {
+    assert(this->socket != INVALID_SOCKET);
 
-    // Set the state of the receiver and install an exit handler that
-    // marks it stopped if this scope is left. The exit guard will make
-    // sure that the state is reset regardless of whether the thread
-    // existed in an orderly manner or died due to an exception.
-    this->state.store(1, std::memory_order::memory_order_release);
+    // Receive until indicated to leave.
+    while (this->state.load(std::memory_order::memory_order_acquire) == 1) {
+        address_type addr;
+        socklen_t addr_length = sizeof(addr);
+        char buffer[TIMESYNC_MAX_DATAGRAM];
+
+        const auto cnt = ::recvfrom(this->socket, buffer, sizeof(buffer), 0,
+            reinterpret_cast<sockaddr *>(&addr), &addr_length);
+        typedef std::decay_t<decltype(cnt)> count_type;
+
+        if ((cnt == SOCKET_ERROR)
+                || (cnt < static_cast<count_type>(sizeof(std::uint32_t)))) {
+            // This is most likely the timeout, which allows us to check
+            // whether we should exit.
+            continue;
+        }
+
+        switch (*reinterpret_cast<std::uint32_t *>(buffer)) {
+            case tsmsg_request::id:
+                if (cnt >= static_cast<count_type>(sizeof(tsmsg_request))) {
+                    this->on_request(
+                        reinterpret_cast<tsmsg_request *>(buffer),
+                        reinterpret_cast<sockaddr&>(addr),
+                        static_cast<int>(addr_length));
+                }
+                break;
+
+            case tsmsg_response::id:
+                if (cnt >= static_cast<count_type>(sizeof(tsmsg_response))) {
+                    this->on_response(
+                        reinterpret_cast<tsmsg_response *>(buffer), addr);
+                }
+                break;
+
+            default:
+                // Ignore anything we do not understand.
+                break;
+        }
+    } /* end while (this->state.load(... */
+}
+
+
+/*
+ * visus::power_overwhelming::detail::time_synchroniser_impl::start
+ */
+void visus::power_overwhelming::detail::time_synchroniser_impl::start(
+        const int address_family, const std::uint16_t port) {
+    auto expected = 0;
+    if (!this->state.compare_exchange_strong(expected, 2,
+            std::memory_order::memory_order_release)) {
+        throw std::runtime_error("The time_synchroniser is already running");
+    }
 
-    const auto guard_state = on_exit([this](void) {
+    // Reset the state if we cannot start. The socket is created synchronously
+    // such that errors are reported to the caller.
+    auto guard_state = on_exit([this](void) {
+        if (this->socket != INVALID_SOCKET) {
+            close_socket(this->socket);
+            this->socket = INVALID_SOCKET;
+        }
+#if defined(_WIN32)
+        ::WSACleanup();
+#endif /*defined(_WIN32) */
         this->state.store(0, std::memory_order::memory_order_release);
     });
 
 #if defined(_WIN32)
-    // Winsock must be initialised per thread. Also, make sure to install
-    // an exit handler cleaning it up if the scope is left.
     {
         WSADATA wsa_data = { };
         auto retval = ::WSAStartup(MAKEWORD(2, 2), &wsa_data);
         if (retval != 0) {
-            throw std::system_error(::WSAGetLastError(),
-                std::system_category());
+            guard_state.cancel();
+            this->state.store(0, std::memory_order::memory_order_release);
+            throw std::system_error(retval, std::system_category());
         }
     }
-
-    const auto guard_wsa_cleanup = on_exit([](void) { ::WSACleanup(); });
 #endif /*defined(_WIN32) */
 
     // Create, configure and bind the local socket.
@@ -197,11 +374,28 @@ void visus::power_overwhelming::detail::time_synchroniser_impl::receive(
         }
     }
 
+    {
+        // Make sure that the receiver periodically checks whether it should
+        // exit, because closing the socket does not reliably wake it.
+#if defined(_WIN32)
+        DWORD timeout = timesync_receive_timeout;
+#else /* defined(_WIN32) */
+        timeval timeout = { };
+        timeout.tv_usec = timesync_receive_timeout * 1000;
+#endif /* defined(_WIN32) */
+        if (::setsockopt(this->socket, SOL_SOCKET, SO_RCVTIMEO,
+                reinterpret_cast<char *>(&timeout), sizeof(timeout))
+                == SOCKET_ERROR) {
+            throw std::system_error(::WSAGetLastError(),
+                std::system_category());
+        }
+    }
+
     switch (address_family) {
         case AF_INET: {
             sockaddr_in addr = { };
             addr.sin_family = address_family;
-            addr.sin_port = ::htons(port);
+            addr.sin_port = htons(port);
             if (::bind(this->socket, reinterpret_cast<sockaddr *>(&addr),
                     sizeof(addr)) == SOCKET_ERROR) {
                 throw std::system_error(::WSAGetLastError(),
@@ -212,7 +406,7 @@ void visus::power_overwhelming::detail::time_synchroniser_impl::receive(
         case AF_INET6: {
             sockaddr_in6 addr = { };
             addr.sin6_family = address_family;
-            addr.sin6_port = ::htons(port);
+            addr.sin6_port = htons(port);
             if (::bind(this->socket, reinterpret_cast<sockaddr *>(&addr),
                     sizeof(addr)) == SOCKET_ERROR) {
                 throw std::system_error(::WSAGetLastError(),
@@ -225,70 +419,61 @@ void visus::power_overwhelming::detail::time_synchroniser_impl::receive(
                 "the time_synchroniser.");
     } /* end switch (address_family) */
 
-    // Receive until indicated to leave.
-    while (this->state.load(std::memory_order::memory_order_acquire) == 1) {
-        sockaddr addr;
-        socklen_t addr_length = sizeof(addr);
-        char buffer[TIMESYNC_MAX_DATAGRAM];
-
-        const auto cnt = ::recvfrom(this->socket, buffer, sizeof(buffer), 0,
-            &addr, &addr_length);
-
-        if (cnt != SOCKET_ERROR) {
-            switch (*reinterpret_cast<std::uint32_t *>(buffer)) {
-                case tsmsg_request::id:
-                    this->on_request(
-                        reinterpret_cast<tsmsg_request *>(buffer),
-                        addr, addr_length);
-                    break;
-
-                case tsmsg_response::id:
-                    this->on_response(
-                        reinterpret_cast<tsmsg_response *>(buffer),
-                        addr, addr_length);
-                    break;
-
-                default:
-                    // Ignore anything we do not understand.
-                    break;
-            }
-        }
-    } /* end while (this->running.load(... */
+    this->address_family = address_family;
+    reset_event(this->stop_event);
+    this->state.store(1, std::memory_order::memory_order_release);
+    this->receiver = std::thread(&time_synchroniser_impl::receive, this);
+    this->prober = std::thread(&time_synchroniser_impl::probe, this);
+    guard_state.cancel();
 }
 
 
 /*
- * visus::power_overwhelming::detail::time_synchroniser_impl::start
+ * visus::power_overwhelming::detail::time_synchroniser_impl::stop
  */
-void visus::power_overwhelming::detail::time_synchroniser_impl::start(
-        const int address_family, const std::uint16_t port) {
-    auto expected = 0;
-    if (!this->state.compare_exchange_strong(expected, 2,
+void visus::power_overwhelming::detail::time_synchroniser_impl::stop(void) {
+    auto expected = 1;
+    if (this->state.compare_exchange_strong(expected, 2,
             std::memory_order::memory_order_release)) {
-        throw std::runtime_error("The time_synchroniser is already running");
-    }
+        set_event(this->stop_event);
 
-    this->receiver = std::thread(&time_synchroniser_impl::receive,
-        this, address_family, port);
+        if (this->prober.joinable()) {
+            this->prober.join();
+        }
+        if (this->receiver.joinable()) {
+            this->receiver.join();
+        }
+
+        assert(this->socket != INVALID_SOCKET);
+        close_socket(this->socket);
+        this->socket = INVALID_SOCKET;
+#if defined(_WIN32)
+        ::WSACleanup();
+#endif /*defined(_WIN32) */
+
+        this->state.store(0, std::memory_order::memory_order_release);
+    }
 }
 
 
 /*
- * visus::power_overwhelming::detail::time_synchroniser_impl::stop
+ * visus::power_overwhelming::detail::time_synchroniser_impl::to_reference
  */
-void visus::power_overwhelming::detail::time_synchroniser_impl::stop(void) {
-    auto expected = 1;
-    if (this->state.compare_exchange_weak(expected, 2,
-            std::memory_order::memory_order_release)) {
-        // Closing the socket will cause the receive to fail and the thread will
-        // notice that the state has changed and it should exit.
-        assert(this->socket != INVALID_SOCKET);
-#if defined(_WIN32)
-        ::closesocket(this->socket);
-#else /* defined(_WIN3) */
-        ::close(this->socket);
-#endif /* defined(_WIN3) */
-        this->socket = INVALID_SOCKET;
+void visus::power_overwhelming::detail::time_synchroniser_impl::to_reference(
+        measurement_data *data, const std::size_t cnt) const {
+    assert((data != nullptr) || (cnt == 0));
+    std::lock_guard<decltype(this->lock)> l(this->lock);
+
+    if ((this->reference == nullptr) || this->reference->empty()) {
+        // The local clock is the reference or we do not know anything about
+        // the reference yet, so we cannot do anything.
+        return;
+    }
+
+    for (std::size_t i = 0; i < cnt; ++i) {
+        auto& d = data[i];
+        d = measurement_data((*this->reference)(d.timestamp()),
+            d.voltage(), d.current(), d.power());
     }
 }
 #endif /* defined(POWER_OVERWHELMING_WITH_TIME_SYNCHRONISER) */
@@ -1,5 +1,5 @@
 // <copyright file="time_synchroniser_impl.h" company="Visualisierungsinstitut der Universitt Stuttgart">
-// Copyright  2022 Visualisierungsinstitut der Universitt Stuttgart.
+// Copyright  2022 - 2024 Visualisierungsinstitut der Universitt Stuttgart.
 // Licensed under the MIT licence. See LICENCE file for details.
 // </copyright>
 // <author>Christoph Mller</author>
@@ -13,6 +13,7 @@
 #endif /* defined(_WIN32) */
 
 #include <atomic>
+#include <chrono>
 #include <cinttypes>
 #include <limits>
 #include <map>
@@ -20,8 +21,12 @@
 #include <thread>
 #include <vector>
 
+#include "power_overwhelming/event.h"
+#include "power_overwhelming/measurement_data.h"
 #include "power_overwhelming/timestamp.h"
 
+#include "peer_clock_model.h"
+
 
 #if !defined(_WIN32)
 #define SOCKET int
@@ -34,8 +39,9 @@ namespace std {
     /// Specialisation of the <see cref="std::less" /> operator for socket
     /// addresses.
     /// </summary>
-    template<> struct less<sockaddr> {
-        bool operator ()(const sockaddr& lhs, const sockaddr& rhs) const;
+    template<> struct less<sockaddr_storage> {
+        bool operator ()(const sockaddr_storage& lhs,
+            const sockaddr_storage& rhs) const;
     };
 }
 
@@ -80,38 +86,39 @@ namespace detail {
             timestamp(timestamp_type::now()) { }
     };
 
-    /// <summary>
-    /// Represents the state of a peer node of the time synchroniser.
-    /// </summary>
-    struct tsstate {
-        typedef power_overwhelming::timestamp timestamp_type;
-
-        timestamp_type timestamp;
-        timestamp_type::value_type roundtrip;
-        double drift;
-
-        inline tsstate(void)
-            : timestamp(0),
-            roundtrip((std::numeric_limits<timestamp_type::value_type>::max)()),
-            drift(0.0) { }
-    };
-
     /// <summary>
     /// The actual implementation of <see cref="time_synchroniser" />, which is
     /// managing the network and threading resources.
     /// </summary>
+    /// <remarks>
+    /// <para>Each instance answers requests for its time from other nodes and
+    /// periodically probes all of its <see cref="peers" /> for their time. The
+    /// responses are fed into a <see cref="peer_clock_model" /> per peer, which
+    /// is used to transform local timestamps into the time of the
+    /// <see cref="reference" /> peer.</para>
+    /// </remarks>
     struct time_synchroniser_impl final {
 
 #if defined(POWER_OVERWHELMING_WITH_TIME_SYNCHRONISER)
         /// <summary>
-        /// The grace period for out-of-sequence requests before they are
-        /// discarded.
+        /// The type to identify a peer.
+        /// </summary>
+        typedef sockaddr_storage address_type;
+
+        /// <summary>
+        /// The address family of <see cref="socket" />.
+        /// </summary>
+        int address_family;
+
+        /// <summary>
+        /// The time after which an unanswered request is discarded.
         /// </summary>
         /// <remarks>
-        /// <para>If a response is received, all outstanding
-        /// <see cref="requests" /> are checked whether they have a smaller
-        /// sequence number than the currently received one minus this value.
-        /// If this is the case, the requests are discarded.</para>
+        /// <para>If a response is received and before new requests are sent,
+        /// all outstanding <see cref="requests" /> are checked whether they
+        /// have been sent more than this number of probe intervals ago. If this
+        /// is the case, the requests are discarded. Therefore, peers that never
+        /// answer do not make the list grow.</para>
         /// <para>This value defaults to 2.</para>
         /// </remarks>
         std::uint32_t grace_period;
@@ -119,18 +126,38 @@ namespace detail {
         /// <summary>
         /// A lock protecting the state of the object.
         /// </summary>
-        std::mutex lock;
+        mutable std::mutex lock;
+
+        /// <summary>
+        /// The peer nodes which are probed for their time.
+        /// </summary>
+        std::map<address_type, peer_clock_model> peers;
 
         /// <summary>
-        /// The peer nodes for which we know the drift.
+        /// The interval in which the <see cref="prober" /> sends requests to
+        /// all <see cref="peers" />.
         /// </summary>
-        std::map<sockaddr, tsstate> peers;
+        std::chrono::milliseconds probe_interval;
+
+        /// <summary>
+        /// The thread periodically sending requests to the peers.
+        /// </summary>
+        std::thread prober;
 
         /// <summary>
         /// The receiver thread waiting for incoming synchronisation requests.
         /// </summary>
         std::thread receiver;
 
+        /// <summary>
+        /// The peer whose clock is the common time line, or <c>nullptr</c>
+        /// if the local clock is the reference.
+        /// </summary>
+        /// <remarks>
+        /// This pointer refers to an element of <see cref="peers" />.
+        /// </remarks>
+        const peer_clock_model *reference;
+
         /// <summary>
         /// Holds the outstanding requests for timestamps from other nodes.
         /// </summary>
@@ -139,21 +166,31 @@ namespace detail {
         /// nodes for which no response was received yet. Once we receive a
         /// response with a matching sequence number, we use Cristian's
         /// algorithm (https://www.geeksforgeeks.org/cristians-algorithm) to
-        /// compute the clock drift between the nodes.</para>
+        /// update the clock model of the peer.</para>
         /// </remarks>
         std::vector<tsmsg_request> requests;
 
+        /// <summary>
+        /// The sequence number of the next request.
+        /// </summary>
+        std::uint32_t sequence_number;
+
         /// <summary>
         /// The datagram socket used to exchange network packets.
         /// </summary>
         SOCKET socket;
 
         /// <summary>
-        /// Remembers the state of the thread, which is 0 if it is not running,
-        /// 1 while it is running and 2 in transitional states.
+        /// Remembers the state of the threads, which is 0 if they are not
+        /// running, 1 while they are running and 2 in transitional states.
         /// </summary>
         std::atomic<int> state;
 
+        /// <summary>
+        /// An event signalled to make the <see cref="prober" /> exit.
+        /// </summary>
+        event_type stop_event;
+
         /// <summary>
         /// Initialises a new instance.
         /// </summary>
@@ -164,6 +201,18 @@ namespace detail {
         /// </summary>
         ~time_synchroniser_impl(void);
 
+        /// <summary>
+        /// Adds the given peer if it is not yet known.
+        /// </summary>
+        /// <param name="host"></param>
+        /// <param name="port"></param>
+        /// <returns>The clock model of the peer.</returns>
+        /// <exception cref="std::invalid_argument">If the host name is
+        /// <c>nullptr</c>.</exception>
+        /// <exception cref="std::runtime_error">If the host name could not be
+        /// resolved.</exception>
+        peer_clock_model& add_peer(const char *host, const std::uint16_t port);
+
         /// <summary>
         /// Handle a request on behalf of <see cref="receive" />.
         /// </summary>
@@ -178,16 +227,18 @@ namespace detail {
         /// </summary>
         /// <param name="response"></param>
         /// <param name="addr"></param>
-        /// <param name="addr_length"></param>
-        void on_response(const tsmsg_response *response, const sockaddr& addr,
-            const int addr_length);
+        void on_response(const tsmsg_response *response,
+            const address_type& addr);
+
+        /// <summary>
+        /// Periodically sends requests to all peers.
+        /// </summary>
+        void probe(void);
 
         /// <summary>
         /// Runs the receive operations.
         /// </summary>
-        /// <param name="address_family"></param>
-        /// <param name="port"></param>
-        void receive(const int address_family, const std::uint16_t port);
+        void receive(void);
 
         /// <summary>
         /// Starts the time synchroniser.
@@ -196,12 +247,22 @@ namespace detail {
         /// <param name="port"></param>
         /// <exception cref="std::runtime_error">If the synchroniser is already
         /// running.</exception>
+        /// <exception cref="std::system_error">If the socket could not be
+        /// created.</exception>
         void start(const int address_family, const std::uint16_t port);
 
         /// <summary>
         /// Stops the time synchroniser if it is running.
         /// </summary>
         void stop(void);
+
+        /// <summary>
+        /// Transforms the given local timestamps into the time of the
+        /// <see cref="reference" /> peer.
+        /// </summary>
+        /// <param name="data"></param>
+        /// <param name="cnt"></param>
+        void to_reference(measurement_data *data, const std::size_t cnt) const;
 #endif /* defined(POWER_OVERWHELMING_WITH_TIME_SYNCHRONISER) */
 
     };
@@ -0,0 +1,100 @@
+﻿// <copyright file="tinkerforge_clock_model.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "tinkerforge_clock_model.h"
+
+
+/*
+ * ...::detail::tinkerforge_clock_model::tinkerforge_clock_model
+ */
+visus::power_overwhelming::detail::tinkerforge_clock_model
+::tinkerforge_clock_model(void) noexcept
+    // RTTs below 100 µs cannot be distinguished from scheduling jitter, so we
+    // never reject probes below this limit.
+    : _fitter(capacity, rejection_factor, timestamp::tick_rate / 10000,
+        nominal_scale, max_drift * nominal_scale) {
+    this->clear();
+}
+
+
+/*
+ * visus::power_overwhelming::detail::tinkerforge_clock_model::add
+ */
+bool visus::power_overwhelming::detail::tinkerforge_clock_model::add(
+        _In_ const probe_type& probe) {
+    const auto rtt = probe.receive.value() - probe.send.value();
+
+    if (!this->_fitter.accept(rtt)) {
+        return false;
+    }
+
+    min_rtt_fitter::sample_type sample;
+    sample.x = this->unwrap(probe.bricklet);
+    sample.y = probe.send.value() + rtt / 2;
+    sample.rtt = rtt;
+
+    this->_last_raw = probe.bricklet;
+    this->_last_unwrapped = sample.x;
+    this->_fitter.add(sample);
+
+    return true;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::tinkerforge_clock_model::clear
+ */
+void visus::power_overwhelming::detail::tinkerforge_clock_model::clear(
+        void) noexcept {
+    this->_fitter.clear();
+    this->_last_raw = 0;
+    this->_last_unwrapped = 0;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::tinkerforge_clock_model::drift
+ */
+double visus::power_overwhelming::detail::tinkerforge_clock_model::drift(
+        void) const noexcept {
+    return this->_fitter.slope() / nominal_scale - 1.0;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::tinkerforge_clock_model::offset
+ */
+visus::power_overwhelming::timestamp
+visus::power_overwhelming::detail::tinkerforge_clock_model::offset(
+        void) const noexcept {
+    return timestamp(this->_fitter(0));
+}
+
+
+/*
+ * visus::power_overwhelming::detail::tinkerforge_clock_model::operator ()
+ */
+visus::power_overwhelming::timestamp
+visus::power_overwhelming::detail::tinkerforge_clock_model::operator ()(
+        _In_ const bricklet_time_type time) const noexcept {
+    return timestamp(this->_fitter(this->unwrap(time)));
+}
+
+
+/*
+ * visus::power_overwhelming::detail::tinkerforge_clock_model::unwrap
+ */
+std::int64_t visus::power_overwhelming::detail::tinkerforge_clock_model::unwrap(
+        _In_ const bricklet_time_type time) const noexcept {
+    if (this->_fitter.empty()) {
+        return time;
+    }
+
+    // The difference is computed modulo 2^32 and interpreted as signed, which
+    // yields the closest unwrapped time in either direction.
+    const auto delta = static_cast<std::int32_t>(time - this->_last_raw);
+    return this->_last_unwrapped + delta;
+}
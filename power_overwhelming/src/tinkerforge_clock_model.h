@@ -0,0 +1,170 @@
+﻿// <copyright file="tinkerforge_clock_model.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+
+#include "power_overwhelming/power_overwhelming_api.h"
+#include "power_overwhelming/timestamp.h"
+
+#include "min_rtt_fitter.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// An online linear model mapping the millisecond clock of a Tinkerforge
+    /// bricklet to timestamps on the host.
+    /// </summary>
+    /// <remarks>
+    /// <para>The model is fitted from probes, each comprising the time on the
+    /// host before a request for the bricklet clock was sent, the time reported
+    /// by the bricklet and the time on the host when the response arrived. The
+    /// bricklet time is assumed to correspond to the midpoint of the round
+    /// trip, so the error caused by an asymmetric round trip is bounded by half
+    /// of the round-trip time (RTT). Therefore, the model only uses the probes
+    /// with the lowest RTT from a small window of recent probes to fit offset
+    /// and drift via least squares, which is implemented by the
+    /// <see cref="min_rtt_fitter" />.</para>
+    /// <para>The 32-bit bricklet clock wraps after approximately 49.7 days.
+    /// The model unwraps bricklet times relative to the most recent probe, so
+    /// translated times must be within about 24 days of the last probe.</para>
+    /// <para>This class is not thread-safe.</para>
+    /// </remarks>
+    class tinkerforge_clock_model final {
+
+    public:
+
+        /// <summary>
+        /// The type of the timestamps from the bricklet.
+        /// </summary>
+        typedef std::uint32_t bricklet_time_type;
+
+        /// <summary>
+        /// A single measurement of the bricklet clock.
+        /// </summary>
+        struct probe_type {
+            /// <summary>
+            /// The time on the host when the request was sent.
+            /// </summary>
+            timestamp send;
+
+            /// <summary>
+            /// The time reported by the bricklet in milliseconds.
+            /// </summary>
+            bricklet_time_type bricklet;
+
+            /// <summary>
+            /// The time on the host when the response was received.
+            /// </summary>
+            timestamp receive;
+        };
+
+        /// <summary>
+        /// The maximum number of probes retained in the window.
+        /// </summary>
+        static constexpr std::size_t capacity = 16;
+
+        /// <summary>
+        /// The maximum relative drift that the model accepts from a fit. Fits
+        /// beyond this value are considered degenerate and only the offset is
+        /// updated.
+        /// </summary>
+        static constexpr double max_drift = 0.01;
+
+        /// <summary>
+        /// The factor by which the RTT of a probe may exceed the median RTT of
+        /// the window before the probe is rejected.
+        /// </summary>
+        static constexpr double rejection_factor = 4.0;
+
+        /// <summary>
+        /// Initialises a new instance without any probes.
+        /// </summary>
+        tinkerforge_clock_model(void) noexcept;
+
+        /// <summary>
+        /// Adds a new probe to the model and refits it.
+        /// </summary>
+        /// <remarks>
+        /// If the model has been rejecting more than <see cref="capacity" />
+        /// probes in a row, it assumes that the link has become permanently
+        /// slower and accepts the probe anyway.
+        /// </remarks>
+        /// <param name="probe">The probe to be added.</param>
+        /// <returns><c>true</c> if the probe has been used, <c>false</c> if it
+        /// has been rejected as an outlier.</returns>
+        bool add(_In_ const probe_type& probe);
+
+        /// <summary>
+        /// Discards all probes and resets the model to the identity scale.
+        /// </summary>
+        void clear(void) noexcept;
+
+        /// <summary>
+        /// Answer the estimated relative drift of the bricklet clock.
+        /// </summary>
+        /// <returns>The relative deviation of the rate of the host clock from
+        /// the rate of the bricklet clock. Multiply by one million to obtain
+        /// parts per million.</returns>
+        double drift(void) const noexcept;
+
+        /// <summary>
+        /// Answer whether the model has no probes.
+        /// </summary>
+        /// <returns><c>true</c> if the model cannot translate times yet,
+        /// <c>false</c> otherwise.</returns>
+        inline bool empty(void) const noexcept {
+            return this->_fitter.empty();
+        }
+
+        /// <summary>
+        /// Answer the estimated time on the host when the (unwrapped) clock of
+        /// the bricklet was zero.
+        /// </summary>
+        /// <returns>The estimated offset of the bricklet clock.</returns>
+        timestamp offset(void) const noexcept;
+
+        /// <summary>
+        /// Answer the number of probes in the window.
+        /// </summary>
+        /// <returns>The number of probes.</returns>
+        inline std::size_t size(void) const noexcept {
+            return this->_fitter.size();
+        }
+
+        /// <summary>
+        /// Translates the given bricklet time into a timestamp on the host.
+        /// </summary>
+        /// <param name="time">The time on the bricklet in milliseconds.</param>
+        /// <returns>The estimated time on the host.</returns>
+        timestamp operator ()(_In_ const bricklet_time_type time) const noexcept;
+
+    private:
+
+        /// <summary>
+        /// The nominal number of host ticks per bricklet millisecond.
+        /// </summary>
+        static constexpr double nominal_scale = static_cast<double>(
+            timestamp::tick_rate) / 1000.0;
+
+        /// <summary>
+        /// Extends the given 32-bit bricklet time to 64 bits relative to the
+        /// last probe.
+        /// </summary>
+        std::int64_t unwrap(_In_ const bricklet_time_type time) const noexcept;
+
+        min_rtt_fitter _fitter;
+        bricklet_time_type _last_raw;
+        std::int64_t _last_unwrapped;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
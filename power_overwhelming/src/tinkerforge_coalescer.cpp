@@ -0,0 +1,118 @@
+﻿// <copyright file="tinkerforge_coalescer.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "tinkerforge_coalescer.h"
+
+#include <algorithm>
+
+
+/*
+ * ...::detail::tinkerforge_coalescer::tinkerforge_coalescer
+ */
+visus::power_overwhelming::detail::tinkerforge_coalescer::tinkerforge_coalescer(
+        void) noexcept {
+    this->reset(tinkerforge_sensor_source::all, std::chrono::milliseconds(1));
+}
+
+
+/*
+ * visus::power_overwhelming::detail::tinkerforge_coalescer::sample
+ */
+visus::power_overwhelming::measurement_data
+visus::power_overwhelming::detail::tinkerforge_coalescer::sample(
+        void) const noexcept {
+    return measurement_data(this->_timestamp,
+        this->_values[index_of(static_cast<mask_type>(
+            tinkerforge_sensor_source::voltage))],
+        this->_values[index_of(static_cast<mask_type>(
+            tinkerforge_sensor_source::current))],
+        this->_values[index_of(static_cast<mask_type>(
+            tinkerforge_sensor_source::power))]);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::tinkerforge_coalescer::reset
+ */
+void visus::power_overwhelming::detail::tinkerforge_coalescer::reset(
+        _In_ const tinkerforge_sensor_source enabled,
+        _In_ const duration_type window) noexcept {
+    this->_dropped = 0;
+    this->_enabled = static_cast<mask_type>(enabled)
+        & static_cast<mask_type>(tinkerforge_sensor_source::all);
+    this->_pending = 0;
+    this->_window = window;
+    std::fill(this->_values.begin(), this->_values.end(),
+        measurement_data::invalid_value);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::tinkerforge_coalescer::update
+ */
+bool visus::power_overwhelming::detail::tinkerforge_coalescer::update(
+        _In_ const tinkerforge_sensor_source quantity,
+        _In_ const value_type value,
+        _In_ const timestamp timestamp) noexcept {
+    const auto q = static_cast<mask_type>(quantity);
+    const auto index = index_of(q);
+
+    if ((index < 0) || ((this->_enabled & q) == 0)) {
+        // Ignore anything we have not been asked to coalesce.
+        return false;
+    }
+
+    if (this->_pending != 0) {
+        // If we already have this quantity or if the reading is too far away
+        // from the start of the period, the bricklet has moved on without us
+        // seeing all quantities of the current period, so we drop it.
+        const auto dt = (timestamp > this->_first)
+            ? timestamp - this->_first
+            : this->_first - timestamp;
+        if (((this->_pending & q) != 0) || (dt > this->_window)) {
+            this->_pending = 0;
+            ++this->_dropped;
+        }
+    }
+
+    if (this->_pending == 0) {
+        this->_first = timestamp;
+    }
+
+    this->_pending |= q;
+    this->_values[index] = value;
+
+    if (q == static_cast<mask_type>(tinkerforge_sensor_source::power)) {
+        // The power reading is the only one that might carry the internal time
+        // of the bricklet, so we prefer its timestamp for the whole sample.
+        this->_power = timestamp;
+    }
+
+    if (this->_pending != this->_enabled) {
+        return false;
+    }
+
+    const auto power = static_cast<mask_type>(tinkerforge_sensor_source::power);
+    this->_timestamp = ((this->_enabled & power) != 0)
+        ? this->_power
+        : this->_first;
+    this->_pending = 0;
+    return true;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::tinkerforge_coalescer::index_of
+ */
+int visus::power_overwhelming::detail::tinkerforge_coalescer::index_of(
+        _In_ const mask_type quantity) noexcept {
+    switch (static_cast<tinkerforge_sensor_source>(quantity)) {
+        case tinkerforge_sensor_source::current: return 0;
+        case tinkerforge_sensor_source::power: return 1;
+        case tinkerforge_sensor_source::voltage: return 2;
+        default: return -1;
+    }
+}
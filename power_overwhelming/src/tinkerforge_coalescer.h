@@ -0,0 +1,141 @@
+﻿// <copyright file="tinkerforge_coalescer.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cinttypes>
+#include <type_traits>
+
+#include "power_overwhelming/measurement_data.h"
+#include "power_overwhelming/timestamp.h"
+#include "power_overwhelming/tinkerforge_sensor_source.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Assembles the current, power and voltage readings that a
+    /// voltage/current bricklet reports via separate callbacks into a single
+    /// consistent <see cref="measurement_data" /> per bricklet period.
+    /// </summary>
+    /// <remarks>
+    /// <para>A sample is considered complete once all enabled quantities have
+    /// been refreshed. If a quantity is reported a second time before the
+    /// sample is complete, or if a reading arrives later than the skew window
+    /// after the first reading of the current period, the incomplete period
+    /// is dropped and a new one is started with the new reading.</para>
+    /// <para>This class is not thread-safe. The owner must serialise calls
+    /// to <see cref="update" />.</para>
+    /// </remarks>
+    class tinkerforge_coalescer final {
+
+    public:
+
+        /// <summary>
+        /// The type used to express the skew window.
+        /// </summary>
+        typedef std::chrono::microseconds duration_type;
+
+        /// <summary>
+        /// The type of the values being coalesced.
+        /// </summary>
+        typedef measurement_data::value_type value_type;
+
+        /// <summary>
+        /// Initialises a new instance, which expects all quantities within one
+        /// millisecond.
+        /// </summary>
+        tinkerforge_coalescer(void) noexcept;
+
+        /// <summary>
+        /// Answer the number of incomplete periods that have been dropped since
+        /// the last call to <see cref="reset" />.
+        /// </summary>
+        /// <returns>The number of dropped periods.</returns>
+        inline std::size_t dropped(void) const noexcept {
+            return this->_dropped;
+        }
+
+        /// <summary>
+        /// Answer the consistent sample that was completed by the last call to
+        /// <see cref="update" /> that returned <c>true</c>.
+        /// </summary>
+        /// <remarks>
+        /// Quantities that are not enabled are reported as
+        /// <see cref="measurement_data::invalid_value" />.
+        /// </remarks>
+        /// <returns>The last complete sample.</returns>
+        measurement_data sample(void) const noexcept;
+
+        /// <summary>
+        /// Discards any incomplete period and configures the quantities that
+        /// are expected in every period.
+        /// </summary>
+        /// <param name="enabled">A bitmask of the quantities the bricklet has
+        /// been configured to report.</param>
+        /// <param name="window">The maximum time between the first and the
+        /// last reading of a period.</param>
+        void reset(_In_ const tinkerforge_sensor_source enabled,
+            _In_ const duration_type window) noexcept;
+
+        /// <summary>
+        /// Answer the skew window.
+        /// </summary>
+        /// <returns>The maximum time between the first and the last reading of
+        /// a period.</returns>
+        inline duration_type window(void) const noexcept {
+            return this->_window;
+        }
+
+        /// <summary>
+        /// Adds a new reading of a single quantity.
+        /// </summary>
+        /// <param name="quantity">The quantity that was read. This must be one
+        /// of <see cref="tinkerforge_sensor_source::current" />,
+        /// <see cref="tinkerforge_sensor_source::power" /> or
+        /// <see cref="tinkerforge_sensor_source::voltage" />. Readings of
+        /// quantities that are not enabled are ignored.</param>
+        /// <param name="value">The value that was read.</param>
+        /// <param name="timestamp">The time when the value was read.</param>
+        /// <returns><c>true</c> if the reading completed a period, in which
+        /// case the result can be retrieved via <see cref="sample" />,
+        /// <c>false</c> otherwise.</returns>
+        bool update(_In_ const tinkerforge_sensor_source quantity,
+            _In_ const value_type value,
+            _In_ const timestamp timestamp) noexcept;
+
+    private:
+
+        /// <summary>
+        /// The type used for the bitmasks of quantities.
+        /// </summary>
+        typedef std::underlying_type<tinkerforge_sensor_source>::type
+            mask_type;
+
+        /// <summary>
+        /// Answer the index of <paramref name="quantity" /> in
+        /// <see cref="_values" />, or a negative number if the quantity is not
+        /// a single one.
+        /// </summary>
+        static int index_of(_In_ const mask_type quantity) noexcept;
+
+        std::size_t _dropped;
+        mask_type _enabled;
+        timestamp _first;
+        mask_type _pending;
+        timestamp _power;
+        timestamp _timestamp;
+        std::array<value_type, 3> _values;
+        duration_type _window;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -9,6 +9,7 @@
 #include <algorithm>
 #include <cctype>
 #include <iterator>
+#include <stdexcept>
 
 #if defined(_WIN32)
 #include <WinSock2.h>
@@ -17,6 +18,52 @@
 #include "tinkerforge_exception.h"
 
 
+/*
+ * ...::detail::tinkerforge_scope::enumeration_lifetime
+ */
+std::chrono::milliseconds
+visus::power_overwhelming::detail::tinkerforge_scope::enumeration_lifetime(
+        void) noexcept {
+    std::lock_guard<decltype(_lock_enumerations)> l(_lock_enumerations);
+    return _enumeration_lifetime;
+}
+
+
+/*
+ * ...::detail::tinkerforge_scope::enumeration_lifetime
+ */
+void visus::power_overwhelming::detail::tinkerforge_scope::enumeration_lifetime(
+        const std::chrono::milliseconds lifetime) noexcept {
+    std::lock_guard<decltype(_lock_enumerations)> l(_lock_enumerations);
+    _enumeration_lifetime = lifetime;
+}
+
+
+/*
+ * ...::detail::tinkerforge_scope::connections_per_endpoint
+ */
+std::size_t visus::power_overwhelming::detail::tinkerforge_scope
+::connections_per_endpoint(void) noexcept {
+    std::lock_guard<decltype(_lock_scopes)> l(_lock_scopes);
+    return _connections_per_endpoint;
+}
+
+
+/*
+ * ...::detail::tinkerforge_scope::connections_per_endpoint
+ */
+void visus::power_overwhelming::detail::tinkerforge_scope
+::connections_per_endpoint(const std::size_t cnt) {
+    if (cnt < 1) {
+        throw std::invalid_argument("At least one connection per endpoint is "
+            "required.");
+    }
+
+    std::lock_guard<decltype(_lock_scopes)> l(_lock_scopes);
+    _connections_per_endpoint = cnt;
+}
+
+
 /*
  * visus::power_overwhelming::detail::tinkerforge_scope::tinkerforge_scope
  */
@@ -24,19 +71,71 @@ visus::power_overwhelming::detail::tinkerforge_scope::tinkerforge_scope(
     const std::string &host, const std::uint16_t port) {
     auto endpoint = to_endpoint(host, port);
 
-    std::lock_guard<decltype(_lock_scopes)> l(_lock_scopes);
-    auto it = _scopes.find(endpoint);
-    if (it != _scopes.end()) {
-        // Reuse existing scope for same connection.
-        this->_scope = it->second.lock();
+    {
+        std::lock_guard<decltype(_lock_scopes)> l(_lock_scopes);
+        auto& pool = _scopes[endpoint];
+
+        // Forget about the connections that have been closed in the meantime.
+        pool.erase(std::remove_if(pool.begin(), pool.end(),
+            [](const std::weak_ptr<data>& d) { return d.expired(); }),
+            pool.end());
+
+        if (pool.size() >= _connections_per_endpoint) {
+            // The pool is full, so reuse the connection with the fewest users.
+            for (auto& d : pool) {
+                auto candidate = d.lock();
+                if (candidate == nullptr) {
+                    continue;
+                }
+                if ((this->_scope == nullptr)
+                        || (candidate.use_count() < this->_scope.use_count())) {
+                    this->_scope = std::move(candidate);
+                }
+            }
+        }
     }
 
     if (this->_scope == nullptr) {
-        // If no existing scope was found or if the previous scope has been
-        // deleted, create a new one.
-        this->_scope = std::make_shared<data>(host, port);
-        _scopes[endpoint] = this->_scope;
+        // If the pool is not yet full, open a new connection to distribute the
+        // load over more callback threads. We do not hold the lock while
+        // connecting such that scopes for different endpoints can be created
+        // concurrently. In turn, concurrent callers might exceed the size of
+        // the pool for a short time.
+        this->_scope = std::make_shared<data>(host, port, endpoint);
+
+        std::lock_guard<decltype(_lock_scopes)> l(_lock_scopes);
+        _scopes[endpoint].push_back(this->_scope);
+    }
+}
+
+
+/*
+ * ...::detail::tinkerforge_scope::register_reconnect_handler
+ */
+void visus::power_overwhelming::detail::tinkerforge_scope
+::register_reconnect_handler(const reconnect_handler handler, void *context) {
+    if (handler == nullptr) {
+        throw std::invalid_argument("The reconnect handler must not be null.");
     }
+
+    std::lock_guard<decltype(this->_scope->lock_handlers)> l(
+        this->_scope->lock_handlers);
+    this->_scope->handlers.emplace_back(handler, context);
+}
+
+
+/*
+ * ...::detail::tinkerforge_scope::unregister_reconnect_handler
+ */
+void visus::power_overwhelming::detail::tinkerforge_scope
+::unregister_reconnect_handler(void *context) noexcept {
+    auto& handlers = this->_scope->handlers;
+    std::lock_guard<decltype(this->_scope->lock_handlers)> l(
+        this->_scope->lock_handlers);
+    handlers.erase(std::remove_if(handlers.begin(), handlers.end(),
+        [context](const std::pair<reconnect_handler, void *>& h) {
+            return (h.second == context);
+        }), handlers.end());
 }
 
 
@@ -44,9 +143,26 @@ visus::power_overwhelming::detail::tinkerforge_scope::tinkerforge_scope(
  * visus::power_overwhelming::detail::tinkerforge_scope::data::data
  */
 visus::power_overwhelming::detail::tinkerforge_scope::data::data(
-    const std::string &host, const std::uint16_t port) {
+        const std::string &host, const std::uint16_t port,
+        const std::string& endpoint)
+        : disconnects(0), endpoint(endpoint), host(host), port(port),
+        reconnect_pending(false), reconnects(0), running(true) {
+    // Start with what we know about the endpoint if it is recent enough. The
+    // enumeration below will add any bricklets that we do not know yet.
+    {
+        std::lock_guard<decltype(_lock_enumerations)> l(_lock_enumerations);
+        auto it = _enumerations.find(endpoint);
+        if ((it != _enumerations.end()) && (std::chrono::steady_clock::now()
+                < it->second.updated + _enumeration_lifetime)) {
+            this->bricklets = it->second.bricklets;
+        }
+    }
+
     ::ipcon_create(&this->connection);
-    //::ipcon_set_auto_reconnect(&this->connection, true);
+
+    // We handle reconnects ourselves, because the bindings retry every 100 ms
+    // forever from within the callback thread.
+    ::ipcon_set_auto_reconnect(&this->connection, false);
 
     // Connect to master brick.
     {
@@ -58,9 +174,11 @@ visus::power_overwhelming::detail::tinkerforge_scope::data::data(
         }
     }
 
-    // Register the callback.
+    // Register the callbacks.
     ::ipcon_register_callback(&this->connection, IPCON_CALLBACK_ENUMERATE,
         reinterpret_cast<void(*)(void)>(on_enumerate), this);
+    ::ipcon_register_callback(&this->connection, IPCON_CALLBACK_DISCONNECTED,
+        reinterpret_cast<void(*)(void)>(on_disconnected), this);
 
     // Perform first enumeration of devices.
     {
@@ -71,6 +189,13 @@ visus::power_overwhelming::detail::tinkerforge_scope::data::data(
             throw tinkerforge_exception(status);
         }
     }
+
+    try {
+        this->reconnect_thread = std::thread(&data::reconnect, this);
+    } catch (...) {
+        ::ipcon_destroy(&this->connection);
+        throw;
+    }
 }
 
 
@@ -78,7 +203,102 @@ visus::power_overwhelming::detail::tinkerforge_scope::data::data(
  * visus::power_overwhelming::detail::tinkerforge_scope::data::~data
  */
 visus::power_overwhelming::detail::tinkerforge_scope::data::~data(void) {
+    {
+        std::lock_guard<decltype(this->lock_reconnect)> l(this->lock_reconnect);
+        this->running = false;
+    }
+    this->reconnect_signal.notify_all();
+
+    if (this->reconnect_thread.joinable()) {
+        this->reconnect_thread.join();
+    }
+
     ::ipcon_destroy(&this->connection);
+
+    // The enumeration results remain valid for some time after the last
+    // connection has been closed.
+    std::lock_guard<decltype(_lock_enumerations)> l(_lock_enumerations);
+    auto it = _enumerations.find(this->endpoint);
+    if (it != _enumerations.end()) {
+        it->second.updated = std::chrono::steady_clock::now();
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::tinkerforge_scope::data::reconnect
+ */
+void visus::power_overwhelming::detail::tinkerforge_scope::data::reconnect(
+        void) {
+    std::unique_lock<decltype(this->lock_reconnect)> l(this->lock_reconnect);
+
+    while (this->running) {
+        this->reconnect_signal.wait(l, [this](void) {
+            return (!this->running || this->reconnect_pending);
+        });
+
+        auto backoff = initial_backoff;
+
+        while (this->running && this->reconnect_pending) {
+            // Wait before the next attempt, but allow the destructor to
+            // interrupt us.
+            if (this->reconnect_signal.wait_for(l, backoff,
+                    [this](void) { return !this->running; })) {
+                break;
+            }
+
+            l.unlock();
+            auto status = ::ipcon_connect(&this->connection,
+                this->host.c_str(), this->port);
+            if (status == E_ALREADY_CONNECTED) {
+                status = E_OK;
+            }
+            if (status == E_OK) {
+                // Refresh the bricklets and give the users of the connection
+                // the opportunity to reconfigure their callbacks.
+                ::ipcon_enumerate(&this->connection);
+
+                {
+                    std::lock_guard<decltype(this->lock_handlers)> lh(
+                        this->lock_handlers);
+                    for (auto& h : this->handlers) {
+                        h.first(h.second);
+                    }
+                }
+
+                // Count the reconnect only once all handlers have run, such
+                // that observers of the counter find the users reconfigured.
+                ++this->reconnects;
+            }
+            l.lock();
+
+            if (status == E_OK) {
+                this->reconnect_pending = false;
+            } else {
+                backoff = (std::min)(2 * backoff, maximum_backoff);
+            }
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::tinkerforge_scope::on_disconnected
+ */
+void CALLBACK visus::power_overwhelming::detail::tinkerforge_scope::on_disconnected(
+        std::uint8_t reason, void *user_data) {
+    auto data = static_cast<tinkerforge_scope::data *>(user_data);
+
+    if (reason != IPCON_DISCONNECT_REASON_REQUEST) {
+        ++data->disconnects;
+
+        {
+            std::lock_guard<decltype(data->lock_reconnect)> l(
+                data->lock_reconnect);
+            data->reconnect_pending = true;
+        }
+        data->reconnect_signal.notify_all();
+    }
 }
 
 
@@ -94,19 +314,40 @@ void CALLBACK visus::power_overwhelming::detail::tinkerforge_scope::on_enumerate
     const auto is_add = (enumeration_type == IPCON_ENUMERATION_TYPE_AVAILABLE)
         || (enumeration_type == IPCON_ENUMERATION_TYPE_CONNECTED);
 
-    std::lock_guard<decltype(data->lock_bricklets)> l(data->lock_bricklets);
-    auto it = data->bricklets.find(uid);
+    const tinkerforge_bricklet bricklet(uid, connected_uid, position,
+        hardware_version, firmware_version, device_identifier);
+
+    // Note: We must not hold the lock for the bricklets while acquiring the
+    // lock for the enumerations, because wait_for_bricklets() acquires them
+    // in the opposite order.
+    const auto update = [is_add, &bricklet, uid](
+            std::map<std::string, tinkerforge_bricklet>& bricklets) {
+        auto it = bricklets.find(uid);
+
+        if (is_add && (it == bricklets.end())) {
+            // Insert if added and unknown.
+            bricklets[uid] = bricklet;
+        }
+
+        if (!is_add && (it != bricklets.end())) {
+            // Erase if removed and known.
+            bricklets.erase(it);
+        }
+    };
 
-    if (is_add && (it == data->bricklets.end())) {
-        // Insert if added and unknown.
-        data->bricklets[uid] = tinkerforge_bricklet(uid, connected_uid,
-            position, hardware_version, firmware_version, device_identifier);
+    {
+        std::lock_guard<decltype(data->lock_bricklets)> l(data->lock_bricklets);
+        update(data->bricklets);
     }
 
-    if (!is_add && (it != data->bricklets.end())) {
-        // Erase if removed and known.
-        data->bricklets.erase(it);
+    {
+        std::lock_guard<decltype(_lock_enumerations)> l(_lock_enumerations);
+        auto& e = _enumerations[data->endpoint];
+        update(e.bricklets);
+        e.updated = _last_enumeration = std::chrono::steady_clock::now();
     }
+
+    _enumerated.notify_all();
 }
 
 
@@ -127,11 +368,55 @@ std::string visus::power_overwhelming::detail::tinkerforge_scope::to_endpoint(
 }
 
 
+/*
+ * ...::detail::tinkerforge_scope::_connections_per_endpoint
+ */
+std::size_t visus::power_overwhelming::detail::tinkerforge_scope
+::_connections_per_endpoint = 4;
+
+
+/*
+ * visus::power_overwhelming::detail::tinkerforge_scope::_enumerated
+ */
+std::condition_variable
+visus::power_overwhelming::detail::tinkerforge_scope::_enumerated;
+
+
+/*
+ * ...::detail::tinkerforge_scope::_enumeration_lifetime
+ */
+std::chrono::milliseconds
+visus::power_overwhelming::detail::tinkerforge_scope::_enumeration_lifetime(
+    30000);
+
+
+/*
+ * visus::power_overwhelming::detail::tinkerforge_scope::_enumerations
+ */
+std::map<std::string,
+    visus::power_overwhelming::detail::tinkerforge_scope::enumeration>
+    visus::power_overwhelming::detail::tinkerforge_scope::_enumerations;
+
+
+/*
+ * ...::detail::tinkerforge_scope::_last_enumeration
+ */
+std::chrono::steady_clock::time_point
+visus::power_overwhelming::detail::tinkerforge_scope::_last_enumeration;
+
+
+/*
+ * ...::detail::tinkerforge_scope::_lock_enumerations
+ */
+std::mutex
+visus::power_overwhelming::detail::tinkerforge_scope::_lock_enumerations;
+
+
 /*
  * visus::power_overwhelming::detail::tinkerforge_scope::_scopes
  */
-std::map<std::string, std::weak_ptr<
-    visus::power_overwhelming::detail::tinkerforge_scope::data>>
+std::map<std::string, std::vector<std::weak_ptr<
+    visus::power_overwhelming::detail::tinkerforge_scope::data>>>
     visus::power_overwhelming::detail::tinkerforge_scope::_scopes;
 
 
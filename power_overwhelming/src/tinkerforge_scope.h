@@ -7,12 +7,16 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cinttypes>
+#include <condition_variable>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <thread>
+#include <vector>
 
 #include <ip_connection.h>
 
@@ -35,6 +39,20 @@ namespace detail {
     /// <para>Tinkerforge scopes can be shared on a per-connection basis. The
     /// scope keeps a reference count for each connection and terminates it once
     /// the last instance was destructed.</para>
+    /// <para>Each Brick daemon endpoint is served by a pool of up to
+    /// <see cref="connections_per_endpoint" /> connections. New scopes are
+    /// assigned to the least used connection of the pool once the pool is
+    /// full, which distributes the bricklets over the callback threads of the
+    /// Tinkerforge bindings.</para>
+    /// <para>The bricklets enumerated on an endpoint are remembered for
+    /// <see cref="enumeration_lifetime" /> after the last connection to it
+    /// has been closed. New connections to the same endpoint start with this
+    /// list such that discovery does not need to wait for the Brick daemon
+    /// again.</para>
+    /// <para>If a connection is lost, the scope reconnects in the background
+    /// with exponential backoff and notifies all registered reconnect handlers
+    /// such that they can restore the callback configuration of their
+    /// bricklets.</para>
     /// <para>Callers must make sure to adhere the thread-safety requirements
     /// of the Tingerforge <see cref="IPConnection" /> they can obtain from a
     /// scope. The creation of new scopes and their destruction is, however,
@@ -44,6 +62,96 @@ namespace detail {
 
     public:
 
+        /// <summary>
+        /// The type of a callback that is invoked after a connection has been
+        /// re-established.
+        /// </summary>
+        typedef void (CALLBACK *reconnect_handler)(void *context);
+
+        /// <summary>
+        /// The delay before the first attempt to reconnect.
+        /// </summary>
+        static constexpr std::chrono::milliseconds initial_backoff
+            = std::chrono::milliseconds(100);
+
+        /// <summary>
+        /// The maximum delay between two attempts to reconnect.
+        /// </summary>
+        static constexpr std::chrono::milliseconds maximum_backoff
+            = std::chrono::milliseconds(10000);
+
+        /// <summary>
+        /// Answer the maximum number of connections that are opened to a single
+        /// Brick daemon.
+        /// </summary>
+        /// <returns>The maximum number of connections per endpoint.</returns>
+        static std::size_t connections_per_endpoint(void) noexcept;
+
+        /// <summary>
+        /// Sets the maximum number of connections that are opened to a single
+        /// Brick daemon.
+        /// </summary>
+        /// <remarks>
+        /// The change affects only scopes created afterwards. Existing
+        /// connections remain open as long as they are in use.
+        /// </remarks>
+        /// <param name="cnt">The maximum number of connections per endpoint.
+        /// </param>
+        /// <exception cref="std::invalid_argument">If <paramref name="cnt" />
+        /// is zero.</exception>
+        static void connections_per_endpoint(const std::size_t cnt);
+
+        /// <summary>
+        /// Answer how long the bricklets enumerated on an endpoint are
+        /// reused for new connections.
+        /// </summary>
+        /// <returns>The lifetime of cached enumeration results.</returns>
+        static std::chrono::milliseconds enumeration_lifetime(void) noexcept;
+
+        /// <summary>
+        /// Sets how long the bricklets enumerated on an endpoint are reused
+        /// for new connections.
+        /// </summary>
+        /// <param name="lifetime">The lifetime of cached enumeration results.
+        /// A value of zero disables the cache.</param>
+        static void enumeration_lifetime(
+            const std::chrono::milliseconds lifetime) noexcept;
+
+        /// <summary>
+        /// Blocks until enough bricklets have been enumerated on one or more
+        /// scopes or the given deadline has passed.
+        /// </summary>
+        /// <remarks>
+        /// <para>The method is woken by the enumeration callbacks of all
+        /// connections, which allows for waiting on several endpoints at the
+        /// same time.</para>
+        /// <para>If <paramref name="expected" /> is zero, the method returns
+        /// once at least one bricklet is known and no enumeration callback has
+        /// been received for <see cref="settle_time" />.</para>
+        /// </remarks>
+        /// <typeparam name="TCount">A functor without parameters returning the
+        /// number of relevant bricklets known so far.</typeparam>
+        /// <param name="count">The functor counting the bricklets. It is
+        /// invoked while holding an internal lock and must therefore not
+        /// create or destroy scopes.</param>
+        /// <param name="deadline">The point in time when to give up waiting.
+        /// </param>
+        /// <param name="expected">The number of bricklets to wait for, or zero
+        /// for waiting for the enumeration to settle.</param>
+        /// <returns>The last result of <paramref name="count" />.</returns>
+        template<class TCount>
+        static std::size_t wait_for_bricklets(const TCount& count,
+            const std::chrono::steady_clock::time_point deadline,
+            const std::size_t expected);
+
+        /// <summary>
+        /// The time without new enumeration callbacks after which the
+        /// enumeration is considered complete if the number of expected
+        /// bricklets is unknown.
+        /// </summary>
+        static constexpr std::chrono::milliseconds settle_time
+            = std::chrono::milliseconds(50);
+
         /// <summary>
         /// Initialises a new instance.
         /// </summary>
@@ -121,6 +229,71 @@ namespace detail {
             const std::chrono::milliseconds timeout,
             const std::size_t expected = 0) const;
 
+        /// <summary>
+        /// Count the currently known <see cref="tinkerforge_bricklet" />s
+        /// matching the given predicate in a thread-safe manner.
+        /// </summary>
+        /// <typeparam name="TPredicate">An unary predicate accepting a
+        /// <see cref="tinkerforge_bricklet" /> returning a <c>bool</c> that
+        /// indicates whether the bricklet should be counted or not.
+        /// </typeparam>
+        /// <param name="predicate">The predicate the counted bricklets
+        /// must match.</param>
+        /// <returns>The number of matching bricklets.</returns>
+        template<class TPredicate>
+        std::size_t count_bricklets(const TPredicate& predicate) const;
+
+        /// <summary>
+        /// Answer how often the connection of the scope has been lost.
+        /// </summary>
+        /// <remarks>
+        /// Each disconnect corresponds to a gap in the data received from the
+        /// bricklets using this connection.
+        /// </remarks>
+        /// <returns>The number of unrequested disconnects.</returns>
+        inline std::size_t disconnects(void) const noexcept {
+            return this->_scope->disconnects.load();
+        }
+
+        /// <summary>
+        /// Answer how often the connection of the scope has been
+        /// re-established.
+        /// </summary>
+        /// <remarks>
+        /// The counter is incremented after all reconnect handlers have been
+        /// invoked.
+        /// </remarks>
+        /// <returns>The number of successful reconnects.</returns>
+        inline std::size_t reconnects(void) const noexcept {
+            return this->_scope->reconnects.load();
+        }
+
+        /// <summary>
+        /// Registers a callback that is invoked whenever the connection of the
+        /// scope has been re-established.
+        /// </summary>
+        /// <remarks>
+        /// The handler is invoked from a background thread while holding an
+        /// internal lock. It must not register or unregister handlers itself.
+        /// </remarks>
+        /// <param name="handler">The handler to be invoked.</param>
+        /// <param name="context">A user-defined pointer passed to the handler,
+        /// which is also used to unregister the handler.</param>
+        void register_reconnect_handler(const reconnect_handler handler,
+            void *context);
+
+        /// <summary>
+        /// Removes all reconnect handlers that have been registered for the
+        /// given <paramref name="context" />.
+        /// </summary>
+        /// <remarks>
+        /// Once the method returns, the handler is guaranteed not to be running
+        /// and not to be invoked anymore.
+        /// </remarks>
+        /// <param name="context">The context of the handlers to be
+        /// removed.</param>
+        void unregister_reconnect_handler(void *context) noexcept;
+
         /// <summary>
         /// Converts the scope into the embedded <see cref="IPConnection" />.
         /// </summary>
@@ -146,10 +319,24 @@ namespace detail {
         /// </remarks>
         struct data {
             std::map<std::string, tinkerforge_bricklet> bricklets;
-            std::mutex lock_bricklets;
             IPConnection connection;
-            data(const std::string& host, const std::uint16_t port);
+            std::atomic<std::size_t> disconnects;
+            std::string endpoint;
+            std::vector<std::pair<reconnect_handler, void *>> handlers;
+            std::string host;
+            std::mutex lock_bricklets;
+            std::mutex lock_handlers;
+            std::mutex lock_reconnect;
+            std::uint16_t port;
+            bool reconnect_pending;
+            std::condition_variable reconnect_signal;
+            std::thread reconnect_thread;
+            std::atomic<std::size_t> reconnects;
+            bool running;
+            data(const std::string& host, const std::uint16_t port,
+                const std::string& endpoint);
             ~data(void);
+            void reconnect(void);
         };
 
         /// <summary>
@@ -183,7 +370,30 @@ namespace detail {
         static std::string to_endpoint(const std::string& host,
             const std::uint16_t port);
 
-        static std::map<std::string, std::weak_ptr<data>> _scopes;
+        /// <summary>
+        /// Disconnect callback for a connection, which triggers the
+        /// reconnect.
+        /// </summary>
+        /// <param name="reason"></param>
+        /// <param name="user_data"></param>
+        static void CALLBACK on_disconnected(std::uint8_t reason,
+            void *user_data);
+
+        /// <summary>
+        /// The bricklets last known to be attached to an endpoint.
+        /// </summary>
+        struct enumeration {
+            std::map<std::string, tinkerforge_bricklet> bricklets;
+            std::chrono::steady_clock::time_point updated;
+        };
+
+        static std::size_t _connections_per_endpoint;
+        static std::condition_variable _enumerated;
+        static std::chrono::milliseconds _enumeration_lifetime;
+        static std::map<std::string, enumeration> _enumerations;
+        static std::chrono::steady_clock::time_point _last_enumeration;
+        static std::mutex _lock_enumerations;
+        static std::map<std::string, std::vector<std::weak_ptr<data>>> _scopes;
         static std::mutex _lock_scopes;
 
         std::shared_ptr<data> _scope;
@@ -34,22 +34,64 @@ std::size_t visus::power_overwhelming::detail::tinkerforge_scope::copy_bricklets
             TIterator oit, const TPredicate& predicate,
             const std::chrono::milliseconds timeout,
             const std::size_t expected) const {
-    const auto deadline = std::chrono::system_clock::now() + timeout;
-    std::size_t retval = 0;
+    // Wait until the bricklets are known, because the enumeration callbacks
+    // might trickle in. See also
+    // https://www.tinkerunity.org/topic/5661-tipps-f%C3%BCr-l%C3%B6sung-eines-kniffligen-problems/#comment-30618
+    tinkerforge_scope::wait_for_bricklets([this, &predicate](void) {
+        return this->count_bricklets(predicate);
+    }, std::chrono::steady_clock::now() + timeout, expected);
+
+    return this->copy_bricklets(oit, predicate);
+}
+
+
+/*
+ * visus::power_overwhelming::detail::tinkerforge_scope::count_bricklets
+ */
+template<class TPredicate>
+std::size_t visus::power_overwhelming::detail::tinkerforge_scope::count_bricklets(
+        const TPredicate& predicate) const {
+    std::lock_guard<decltype(this->_scope->lock_bricklets)> l(
+        this->_scope->lock_bricklets);
+    return std::count_if(this->_scope->bricklets.begin(),
+        this->_scope->bricklets.end(),
+        [&predicate](const std::pair<const std::string,
+                tinkerforge_bricklet>& b) {
+            return predicate(b.second);
+        });
+}
+
 
-    while (std::chrono::system_clock::now() < deadline) {
-        retval = this->copy_bricklets(oit, predicate);
-
-        // Determine whether the bricklets are already known. If not, we
-        // repeat this step every 100 ms until the bricklets have been
-        // discovered or the timeout was reached. See also
-        // https://www.tinkerunity.org/topic/5661-tipps-f%C3%BCr-l%C3%B6sung-eines-kniffligen-problems/#comment-30618
-        if ((retval == 0) || ((expected > 0) && (retval < expected))) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        } else {
-            break;
+/*
+ * ...::detail::tinkerforge_scope::wait_for_bricklets
+ */
+template<class TCount>
+std::size_t visus::power_overwhelming::detail::tinkerforge_scope
+::wait_for_bricklets(const TCount& count,
+        const std::chrono::steady_clock::time_point deadline,
+        const std::size_t expected) {
+    std::unique_lock<decltype(_lock_enumerations)> l(_lock_enumerations);
+
+    while (true) {
+        const std::size_t retval = count();
+        const auto now = std::chrono::steady_clock::now();
+
+        if (((expected > 0) && (retval >= expected)) || (now >= deadline)) {
+            return retval;
         }
-    }
 
-    return retval;
+        auto until = deadline;
+        if ((expected == 0) && (retval > 0)) {
+            // We do not know how many bricklets there are, so we wait for the
+            // callbacks to stop coming in.
+            const auto settled = _last_enumeration + settle_time;
+            if (now >= settled) {
+                return retval;
+            }
+
+            until = (std::min)(until, settled);
+        }
+
+        _enumerated.wait_until(l, until);
+    }
 }
@@ -8,6 +8,7 @@
 
 #include <cassert>
 #include <chrono>
+#include <future>
 #include <thread>
 #include <vector>
 
@@ -76,33 +77,95 @@ std::size_t visus::power_overwhelming::tinkerforge_sensor::get_definitions(
         _In_ const std::size_t timeout,
         _In_opt_z_ const char *host,
         _In_ const std::uint16_t port) {
+    return get_definitions(dst, cnt, &host, &port, 1, timeout);
+}
+
+
+/*
+ * visus::power_overwhelming::tinkerforge_sensor::get_definitions
+ */
+std::size_t visus::power_overwhelming::tinkerforge_sensor::get_definitions(
+        _When_(dst != nullptr, _Out_writes_opt_(cnt))
+        tinkerforge_sensor_definition *dst,
+        _In_ const std::size_t cnt,
+        _In_reads_(cnt_endpoints) const char *const *hosts,
+        _In_reads_opt_(cnt_endpoints) const std::uint16_t *ports,
+        _In_ const std::size_t cnt_endpoints,
+        _In_ const std::size_t timeout) {
     typedef detail::tinkerforge_bricklet bricklet_type;
+    typedef detail::tinkerforge_scope scope_type;
 
-    try {
-        std::vector<bricklet_type> bricklets;
-        const auto h = (host != nullptr) ? host : default_host;
-        detail::tinkerforge_scope scope(h, port);
+    if ((hosts == nullptr) && (cnt_endpoints > 0)) {
+        throw std::invalid_argument("The list of Brick daemon hosts must not "
+            "be null.");
+    }
+
+    const auto deadline = std::chrono::steady_clock::now()
+        + std::chrono::milliseconds(timeout);
+    const auto is_vc = [](const bricklet_type& b) {
+        return (b.device_type() == VOLTAGE_CURRENT_V2_DEVICE_IDENTIFIER);
+    };
+    const auto host = [hosts](const std::size_t i) {
+        return (hosts[i] != nullptr) ? hosts[i] : default_host;
+    };
+    const auto port = [ports](const std::size_t i) {
+        return (ports != nullptr) ? ports[i] : default_port;
+    };
+
+    // Connecting to brickd is a blocking operation, which we do not want to
+    // serialise if there are multiple endpoints, so we connect all of them
+    // concurrently and only afterwards wait for the enumeration.
+    std::vector<std::future<scope_type>> connects;
+    connects.reserve(cnt_endpoints);
+    for (std::size_t i = 0; i < cnt_endpoints; ++i) {
+        connects.push_back(std::async(std::launch::async,
+            [](const char *h, const std::uint16_t p) {
+                return scope_type(h, p);
+            }, host(i), port(i)));
+    }
+
+    std::vector<std::pair<std::size_t, scope_type>> scopes;
+    scopes.reserve(cnt_endpoints);
+    for (std::size_t i = 0; i < cnt_endpoints; ++i) {
+        try {
+            scopes.emplace_back(i, connects[i].get());
+        } catch (tinkerforge_exception) {
+            // If the connection failed in the scope, we do not have any
+            // bricklets. This is typically caused by brickd not running on
+            // the host, which should not prevent us from using the others.
+        }
+    }
+
+    // All endpoints share the same deadline and the expected number of
+    // bricklets refers to the sum over all of them.
+    scope_type::wait_for_bricklets([&scopes, &is_vc](void) {
+        std::size_t retval = 0;
+        for (auto& s : scopes) {
+            retval += s.second.count_bricklets(is_vc);
+        }
+        return retval;
+    }, deadline, cnt);
 
-        auto retval = scope.copy_bricklets(
-            std::back_inserter(bricklets),
-            [](const bricklet_type& b) { return (b.device_type()
-                == VOLTAGE_CURRENT_V2_DEVICE_IDENTIFIER); },
-            std::chrono::milliseconds(timeout),
-            cnt);
+    std::size_t retval = 0;
+    std::vector<bricklet_type> bricklets;
+    for (auto& s : scopes) {
+        bricklets.clear();
+        s.second.copy_bricklets(std::back_inserter(bricklets), is_vc);
 
         if (dst != nullptr) {
-            for (std::size_t i = 0; (i < cnt) && (i < retval); ++i) {
-                dst[i] = tinkerforge_sensor_definition(
-                    bricklets[i].uid().c_str());
+            for (std::size_t i = 0; (retval + i < cnt)
+                    && (i < bricklets.size()); ++i) {
+                dst[retval + i] = tinkerforge_sensor_definition(
+                    bricklets[i].uid().c_str(),
+                    host(s.first),
+                    port(s.first));
             }
         }
 
-        return retval;
-    } catch (tinkerforge_exception) {
-        // If the connection failed in the scope, we do not have any bricklets.
-        // This is typically caused by brickd not running on 'host'.
-        return 0;
+        retval += bricklets.size();
     }
+
+    return retval;
 }
 
 
@@ -149,10 +212,21 @@ visus::power_overwhelming::tinkerforge_sensor::tinkerforge_sensor(
         _In_ const tinkerforge_sensor_definition& definition,
         _In_opt_z_ const char *host,
         _In_ const std::uint16_t port) : _impl(nullptr) {
-    this->_impl = new detail::tinkerforge_sensor_impl(
-        (host != nullptr) ? host : default_host,
-        port,
-        definition.uid());
+    // If the definition knows where it has been discovered, this is more
+    // reliable than whatever the caller passed.
+    const auto discovered = (definition.host() != nullptr);
+
+    if (discovered) {
+        this->_impl = new detail::tinkerforge_sensor_impl(
+            definition.host(),
+            definition.port(),
+            definition.uid());
+    } else {
+        this->_impl = new detail::tinkerforge_sensor_impl(
+            (host != nullptr) ? host : default_host,
+            port,
+            definition.uid());
+    }
 
     if (definition.description() != nullptr) {
         this->_impl->description = definition.description();
@@ -254,6 +328,15 @@ visus::power_overwhelming::tinkerforge_sensor::error_count(void) const {
 }
 
 
+/*
+ * visus::power_overwhelming::tinkerforge_sensor::gaps
+ */
+std::size_t visus::power_overwhelming::tinkerforge_sensor::gaps(void) const {
+    this->check_not_disposed();
+    return this->_impl->scope.disconnects() - this->_impl->disconnects;
+}
+
+
 /*
  * visus::power_overwhelming::tinkerforge_sensor::identify
  */
@@ -421,35 +504,44 @@ void visus::power_overwhelming::tinkerforge_sensor::sample_async(
             "it is already running.");
     }
 
+    if (enabled) {
+        // Deliver any samples that are still buffered from streaming to the
+        // configuration that they have been collected for.
+        this->_impl->flush_batch();
+    }
+
     if ((this->_impl->async_sampling = std::move(sampling))) {
         // Callback is non-null, so user wants to enable asynchronous sampling.
 
         try {
             const auto& config = this->_impl->async_sampling;
-            const auto millis = static_cast<std::int32_t>((std::max)(one,
+            auto millis = static_cast<std::int32_t>((std::max)(one,
                 config.interval() / thousand));
             const auto source = config.tinkerforge_sensor_source();
 
-            if (source == tinkerforge_sensor_source::all) {
-                // Enable all sensor readings.
-                this->_impl->enable_callbacks(millis);
-
-            } else {
-                // Enable individual sensor readings.
-                if ((source & tinkerforge_sensor_source::current)
-                        == tinkerforge_sensor_source::current) {
-                    this->_impl->enable_current_callback(millis);
-                }
-                if ((source & tinkerforge_sensor_source::power)
-                        == tinkerforge_sensor_source::power) {
-                    this->_impl->enable_power_callback(millis);
-                }
-                if ((source & tinkerforge_sensor_source::voltage)
-                        == tinkerforge_sensor_source::voltage) {
-                    this->_impl->enable_voltage_callback(millis);
-                }
+            if (config.batch_size() > 1) {
+                // In streaming mode, we do not want the bricklet to send the
+                // same value over and over again, so we do not request
+                // callbacks faster than the ADC produces new values.
+                millis = this->_impl->streaming_period(millis);
+                this->_impl->async_batch.clear();
+                this->_impl->async_batch.reserve(config.batch_size());
             }
 
+            const auto window = (config.coalescing_window() > 0)
+                ? config.coalescing_window()
+                : millis * thousand;
+
+            // Prepare assembling the callbacks of the bricklet into consistent
+            // samples before any of the callbacks is enabled.
+            this->_impl->async_data.reset(source,
+                detail::tinkerforge_coalescer::duration_type(window));
+
+            // Remember the period such that the callbacks can be restored if
+            // the connection is re-established.
+            this->_impl->async_period = millis;
+            this->_impl->enable_callbacks(source, millis);
+
         } catch (...) {
             // Clear the guard in case the operation failed.
             this->_impl->async_sampling.is_disabled();
@@ -489,7 +581,7 @@ visus::power_overwhelming::tinkerforge_sensor::sample_sync(void) const {
 
     {
         auto status = ::voltage_current_v2_get_current(&this->_impl->bricklet,
-            &voltage);
+            &current);
         if (status < 0) {
             throw tinkerforge_exception(status);
         }
@@ -15,7 +15,8 @@
  * ...::tinkerforge_sensor_definition::tinkerforge_sensor_definition
  */
 visus::power_overwhelming::tinkerforge_sensor_definition::tinkerforge_sensor_definition(
-        _In_z_ const char *uid) : _description(nullptr), _uid(nullptr) {
+        _In_z_ const char *uid) : _description(nullptr), _host(nullptr),
+        _port(0), _uid(nullptr) {
     if (uid == nullptr) {
         throw std::invalid_argument("The UID of a Tinkerforge sensor cannot "
             "be null.");
@@ -26,12 +27,31 @@ visus::power_overwhelming::tinkerforge_sensor_definition::tinkerforge_sensor_def
 }
 
 
+/*
+ * ...::tinkerforge_sensor_definition::tinkerforge_sensor_definition
+ */
+visus::power_overwhelming::tinkerforge_sensor_definition::tinkerforge_sensor_definition(
+        _In_z_ const char *uid, _In_z_ const char *host,
+        _In_ const std::uint16_t port)
+        : tinkerforge_sensor_definition(uid) {
+    if (host == nullptr) {
+        throw std::invalid_argument("The host of a Tinkerforge sensor cannot "
+            "be null.");
+    }
+
+    // Note: If this throws, the delegated constructor has already completed
+    // and the destructor will free the UID.
+    detail::safe_assign(this->_host, host);
+    this->_port = port;
+}
+
+
 /*
  * ...::tinkerforge_sensor_definition::tinkerforge_sensor_definition
  */
 visus::power_overwhelming::tinkerforge_sensor_definition::tinkerforge_sensor_definition(
         _In_ const tinkerforge_sensor_definition& rhs)
-        : _description(nullptr), _uid(nullptr) {
+        : _description(nullptr), _host(nullptr), _port(0), _uid(nullptr) {
     try {
         *this = rhs;
     } catch (...) {
@@ -47,6 +67,7 @@ visus::power_overwhelming::tinkerforge_sensor_definition::tinkerforge_sensor_def
 visus::power_overwhelming::tinkerforge_sensor_definition::~tinkerforge_sensor_definition(
         void) {
     detail::safe_assign(this->_description, nullptr);
+    detail::safe_assign(this->_host, nullptr);
     detail::safe_assign(this->_uid, nullptr);
 }
 
@@ -68,6 +89,8 @@ visus::power_overwhelming::tinkerforge_sensor_definition::operator =(
         _In_ const tinkerforge_sensor_definition& rhs) {
     if (this != std::addressof(rhs)) {
         detail::safe_assign(this->_description, rhs._description);
+        detail::safe_assign(this->_host, rhs._host);
+        this->_port = rhs._port;
         detail::safe_assign(this->_uid, rhs._uid);
     }
 
@@ -84,6 +107,9 @@ visus::power_overwhelming::tinkerforge_sensor_definition::operator =(
     if (this != std::addressof(rhs)) {
         detail::safe_assign(this->_description, std::move(rhs._description));
         assert(rhs._description == nullptr);
+        detail::safe_assign(this->_host, std::move(rhs._host));
+        assert(rhs._host == nullptr);
+        this->_port = rhs._port;
         detail::safe_assign(this->_uid, std::move(rhs._uid));
         assert(rhs._uid == nullptr);
     }
@@ -35,9 +35,7 @@ namespace detail {
         auto that = static_cast<tinkerforge_sensor_impl *>(data);
         std::lock_guard<decltype(that->async_lock)> l(that->async_lock);
         const auto ts = timestamp::now();
-        that->async_data[0] = static_cast<measurement::value_type>(current)
-            / static_cast<measurement::value_type>(1000);
-        that->invoke_callback(ts);   // TODO: Do we really want to invoke directly? How do we detect a consistent state?
+        that->invoke_callback(tinkerforge_sensor_source::current, current, ts);
     }
 
     /// <summary>
@@ -51,9 +49,7 @@ namespace detail {
         auto that = static_cast<tinkerforge_sensor_impl *>(data);
         std::lock_guard<decltype(that->async_lock)> l(that->async_lock);
         const auto ts = timestamp::now();
-        that->async_data[1] = static_cast<measurement::value_type>(power)
-            / static_cast<measurement::value_type>(1000);
-        that->invoke_callback(ts);   // TODO: Do we really want to invoke directly? How do we detect a consistent state?
+        that->invoke_callback(tinkerforge_sensor_source::power, power, ts);
     }
 
     /// <summary>
@@ -75,14 +71,39 @@ namespace detail {
         //    + L" " + std::to_wstring(time)
         //    + L" " + std::to_wstring(wall_time - ts)
         //    + L"\r\n").c_str());
-        that->async_data[1] = static_cast<measurement::value_type>(power)
-            / static_cast<measurement::value_type>(1000);
-        that->invoke_callback(ts);
+        that->invoke_callback(tinkerforge_sensor_source::power, power, ts);
 #else /* defined(CUSTOM_TINKERFORGE_FIRMWARE) */
         power_callback(power, data);
 #endif /* defined(CUSTOM_TINKERFORGE_FIRMWARE) */
     }
 
+    /// <summary>
+    /// The callback to be invoked once the connection to the Brick daemon has
+    /// been re-established.
+    /// </summary>
+    /// <param name="data"></param>
+    void CALLBACK reconnect_callback(void *data) {
+        assert(data != nullptr);
+        auto that = static_cast<tinkerforge_sensor_impl *>(data);
+        std::lock_guard<decltype(that->async_lock)> l(that->async_lock);
+
+        if (that->async_sampling) {
+            // The bricklet might have lost its configuration if the whole
+            // stack has been power-cycled, so we need to restore it. Anything
+            // that has been buffered before the disconnect is not consistent
+            // with the data we are about to receive.
+            const auto source = that->async_sampling.tinkerforge_sensor_source();
+            that->async_data.reset(source, that->async_data.window());
+
+            try {
+                that->enable_callbacks(source, that->async_period);
+            } catch (...) {
+                // There is nothing we can do here. If the connection is lost
+                // again, we will retry after the next reconnect.
+            }
+        }
+    }
+
     /// <summary>
     /// The callback to be invoked for incoming asynchronous voltage
     /// readings.
@@ -94,9 +115,7 @@ namespace detail {
         auto that = static_cast<tinkerforge_sensor_impl *>(data);
         std::lock_guard<decltype(that->async_lock)> l(that->async_lock);
         const auto ts = timestamp::now();
-        that->async_data[2] = static_cast<measurement::value_type>(voltage)
-            / static_cast<measurement::value_type>(1000);
-        that->invoke_callback(ts);   // TODO: Do we really want to invoke directly? How do we detect a consistent state?
+        that->invoke_callback(tinkerforge_sensor_source::voltage, voltage, ts);
     }
 
 } /* namespace detail */
@@ -104,6 +123,32 @@ namespace detail {
 } /* namespace visus */
 
 
+/*
+ * ...::detail::tinkerforge_sensor_impl::conversion_period
+ */
+std::chrono::microseconds
+visus::power_overwhelming::detail::tinkerforge_sensor_impl::conversion_period(
+        const sample_averaging averaging,
+        const conversion_time voltage_conversion_time,
+        const conversion_time current_conversion_time) noexcept {
+    // The tables are indexed by the values of the enumerations, which are the
+    // native values of the bricklet API.
+    static constexpr std::array<std::chrono::microseconds::rep, 8> counts = {
+        1, 4, 16, 64, 128, 256, 512, 1024
+    };
+    static constexpr std::array<std::chrono::microseconds::rep, 8> times = {
+        140, 204, 332, 588, 1100, 2116, 4156, 8244
+    };
+    static constexpr std::size_t mask = 0x7;
+
+    const auto a = static_cast<std::size_t>(averaging) & mask;
+    const auto v = static_cast<std::size_t>(voltage_conversion_time) & mask;
+    const auto c = static_cast<std::size_t>(current_conversion_time) & mask;
+
+    return std::chrono::microseconds(counts[a] * (times[v] + times[c]));
+}
+
+
 /*
  * visus::power_overwhelming::detail::tinkerforge_sensor_impl::get_sensor_name
  */
@@ -122,7 +167,7 @@ visus::power_overwhelming::detail::tinkerforge_sensor_impl::get_sensor_name(
 visus::power_overwhelming::detail::tinkerforge_sensor_impl::tinkerforge_sensor_impl(
         const std::string& host, const std::uint16_t port,
         const char *uid)
-        : scope(host, port), uid(uid) {
+        : async_period(1), disconnects(0), scope(host, port), uid(uid) {
     // Note that there is a delicate balance in what is done where and when in
     // this constructor: If we enter the body, the scope will have a valid
     // connection to a master brick. Otherwise, its constructor would have
@@ -142,11 +187,14 @@ visus::power_overwhelming::detail::tinkerforge_sensor_impl::tinkerforge_sensor_i
     this->sensor_name = power_overwhelming::convert_string<wchar_t>(
         tinkerforge_sensor_impl::get_sensor_name(host, port, uid));
 
-    ::voltage_current_v2_create(&this->bricklet, uid, this->scope);
+    this->disconnects = this->scope.disconnects();
 
-    // Initialise the asynchronous measurement buffer with in valid data.
-    std::fill(this->async_data.begin(), this->async_data.end(),
-        measurement::invalid_value);
+    // The handler must be registered before the bricklet is created, because
+    // it might throw. This is safe, because the handler does not touch the
+    // bricklet unless asynchronous sampling has been enabled.
+    this->scope.register_reconnect_handler(reconnect_callback, this);
+
+    ::voltage_current_v2_create(&this->bricklet, uid, this->scope);
 
     // TODO: this is too slow, only set timing in reset.
 //#if defined(CUSTOM_TINKERFORGE_FIRMWARE)
@@ -160,6 +208,10 @@ visus::power_overwhelming::detail::tinkerforge_sensor_impl::tinkerforge_sensor_i
  */
 visus::power_overwhelming::detail::tinkerforge_sensor_impl
 ::~tinkerforge_sensor_impl(void) {
+    // Make sure that a concurrent reconnect does not re-enable the callbacks
+    // we are about to disable.
+    this->scope.unregister_reconnect_handler(this);
+
     // Make sure to disable the callbacks in case the user forgot to do
     // so before destroying the sensor. Note that we do not hold the lock at
     // this point, which enables all callbacks that are already running to
@@ -259,6 +311,34 @@ void visus::power_overwhelming::detail::tinkerforge_sensor_impl::enable_callback
 }
 
 
+/*
+ * ...::tinkerforge_sensor_impl::enable_callbacks
+ */
+void visus::power_overwhelming::detail::tinkerforge_sensor_impl::enable_callbacks(
+        const tinkerforge_sensor_source source,
+        const std::int32_t period) {
+    if (source == tinkerforge_sensor_source::all) {
+        // Enable all sensor readings.
+        this->enable_callbacks(period);
+
+    } else {
+        // Enable individual sensor readings.
+        if ((source & tinkerforge_sensor_source::current)
+                == tinkerforge_sensor_source::current) {
+            this->enable_current_callback(period);
+        }
+        if ((source & tinkerforge_sensor_source::power)
+                == tinkerforge_sensor_source::power) {
+            this->enable_power_callback(period);
+        }
+        if ((source & tinkerforge_sensor_source::voltage)
+                == tinkerforge_sensor_source::voltage) {
+            this->enable_voltage_callback(period);
+        }
+    }
+}
+
+
 /*
  * ...::detail::tinkerforge_sensor_impl::enable_current_callback
  */
@@ -311,6 +391,20 @@ void visus::power_overwhelming::detail::tinkerforge_sensor_impl
 }
 
 
+/*
+ * ...::detail::tinkerforge_sensor_impl::flush_batch
+ */
+void visus::power_overwhelming::detail::tinkerforge_sensor_impl::flush_batch(
+        void) {
+    if (!this->async_batch.empty()) {
+        this->async_sampling.deliver(this->sensor_name.c_str(),
+            this->async_batch.data(),
+            this->async_batch.size());
+        this->async_batch.clear();
+    }
+}
+
+
 /*
  * ...::detail::tinkerforge_sensor_impl::enable_voltage_callback
  */
@@ -335,13 +429,67 @@ void visus::power_overwhelming::detail::tinkerforge_sensor_impl
  * visus::power_overwhelming::detail::tinkerforge_sensor_impl::invoke_callback
  */
 void visus::power_overwhelming::detail::tinkerforge_sensor_impl::invoke_callback(
+        const tinkerforge_sensor_source quantity,
+        const std::int32_t value,
         const power_overwhelming::timestamp timestamp) {
-    auto current = this->async_data[0];
-    auto power = this->async_data[1];
-    auto voltage = this->async_data[2];
-    measurement_data measurement(timestamp, voltage, current, power);
+    const auto v = static_cast<measurement::value_type>(value)
+        / static_cast<measurement::value_type>(1000);
 
-    if (measurement) {
-        this->async_sampling.deliver(this->sensor_name.c_str(), measurement);
+    if (this->async_data.update(quantity, v, timestamp)) {
+        const auto measurement = this->async_data.sample();
+        const auto batch = this->async_sampling.batch_size();
+
+        if (!measurement) {
+            return;
+        }
+
+        if (batch > 1) {
+            // In streaming mode, the buffer has been reserved in advance, so
+            // this should not allocate in the callback thread.
+            this->async_batch.push_back(measurement);
+
+            // Deliver early if the oldest sample has been held for longer than
+            // filling the batch should take, which bounds the latency if the
+            // bricklet delivers less often than requested.
+            const auto age = measurement.timestamp()
+                - this->async_batch.front().timestamp();
+            const auto max_age = this->async_data.window()
+                * static_cast<std::int64_t>(batch);
+
+            if ((this->async_batch.size() >= batch) || (age >= max_age)) {
+                this->flush_batch();
+            }
+
+        } else {
+            this->async_sampling.deliver(this->sensor_name.c_str(),
+                measurement);
+        }
     }
 }
+
+
+/*
+ * ...::detail::tinkerforge_sensor_impl::streaming_period
+ */
+std::int32_t
+visus::power_overwhelming::detail::tinkerforge_sensor_impl::streaming_period(
+        const std::int32_t period) {
+    std::uint8_t averaging = 0;
+    std::uint8_t current_conversion_time = 0;
+    std::uint8_t voltage_conversion_time = 0;
+
+    auto status = ::voltage_current_v2_get_configuration(&this->bricklet,
+        &averaging, &voltage_conversion_time, &current_conversion_time);
+    if (status < 0) {
+        throw tinkerforge_exception(status);
+    }
+
+    const auto conversion = conversion_period(
+        static_cast<sample_averaging>(averaging),
+        static_cast<conversion_time>(voltage_conversion_time),
+        static_cast<conversion_time>(current_conversion_time));
+    const auto millis = std::chrono::ceil<std::chrono::milliseconds>(
+        conversion).count();
+
+    return (std::max)(period, static_cast<std::int32_t>(millis));
+}
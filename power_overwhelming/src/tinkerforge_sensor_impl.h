@@ -7,8 +7,10 @@
 #pragma once
 
 #include <array>
+#include <chrono>
 #include <mutex>
 #include <functional>
+#include <vector>
 
 #include <bricklet_voltage_current_v2.h>
 
@@ -17,9 +19,12 @@
 #endif /* defined(_WIN32) */
 
 #include "power_overwhelming/async_sampling.h"
+#include "power_overwhelming/conversion_time.h"
 #include "power_overwhelming/measurement.h"
+#include "power_overwhelming/sample_averaging.h"
 #include "power_overwhelming/timestamp.h"
 
+#include "tinkerforge_coalescer.h"
 #include "tinkerforge_scope.h"
 #include "tinkerforge_time_translator.h"
 
@@ -33,6 +38,22 @@ namespace detail {
     /// </summary>
     struct tinkerforge_sensor_impl final {
 
+        /// <summary>
+        /// Computes the time the ADC of the bricklet needs to produce a new
+        /// value with the given configuration.
+        /// </summary>
+        /// <param name="averaging">The number of conversions averaged into a
+        /// single value.</param>
+        /// <param name="voltage_conversion_time">The conversion time of the
+        /// voltage ADC.</param>
+        /// <param name="current_conversion_time">The conversion time of the
+        /// current ADC.</param>
+        /// <returns>The time between two distinct values.</returns>
+        static std::chrono::microseconds conversion_period(
+            const sample_averaging averaging,
+            const conversion_time voltage_conversion_time,
+            const conversion_time current_conversion_time) noexcept;
+
         /// <summary>
         /// Compose the sensor name from the given connection information.
         /// </summary>
@@ -49,10 +70,16 @@ namespace detail {
         VoltageCurrentV2 bricklet;
 
         /// <summary>
-        /// Buffer for incoming asynchronous data (current, power, voltage, in
-        /// that order).
+        /// Assembles the incoming asynchronous current, power and voltage
+        /// readings into consistent samples.
+        /// </summary>
+        tinkerforge_coalescer async_data;
+
+        /// <summary>
+        /// Buffer for complete samples that have not yet been delivered in
+        /// streaming mode.
         /// </summary>
-        std::array<measurement::value_type, 3> async_data;
+        std::vector<measurement_data> async_batch;
 
         /// <summary>
         /// A lock for protecting <see cref="async_data" /> and the callback
@@ -60,6 +87,12 @@ namespace detail {
         /// </summary>
         std::mutex async_lock;
 
+        /// <summary>
+        /// The callback period in milliseconds that has been configured on the
+        /// bricklet for asynchronous sampling.
+        /// </summary>
+        std::int32_t async_period;
+
         /// <summary>
         /// The asynchronous sampling configuration for the sensor.
         /// </summary>
@@ -70,6 +103,12 @@ namespace detail {
         /// </summary>
         std::wstring description;
 
+        /// <summary>
+        /// The number of disconnects of <see cref="scope" /> when the sensor
+        /// was created.
+        /// </summary>
+        std::size_t disconnects;
+
         /// <summary>
         /// The name of the sensor, which has been created from the host,
         /// port and unique ID of the bricklet.
@@ -127,6 +166,16 @@ namespace detail {
         /// <exception cref="tinkerforge_exception"></exception>
         void enable_callbacks(const std::int32_t period = 1);
 
+        /// <summary>
+        /// Enable the callbacks of <see cref="bricklet" /> for the given
+        /// sources.
+        /// </summary>
+        /// <param name="source"></param>
+        /// <param name="period"></param>
+        /// <exception cref="tinkerforge_exception"></exception>
+        void enable_callbacks(const tinkerforge_sensor_source source,
+            const std::int32_t period);
+
         /// <summary>
         /// Enable the current callback with <see cref="bricklet" />.
         /// </summary>
@@ -148,6 +197,13 @@ namespace detail {
         /// <exception cref="tinkerforge_exception"></exception>
         void enable_voltage_callback(const std::int32_t period = 1);
 
+        /// <summary>
+        /// Delivers all samples in <see cref="async_batch" /> to the callback
+        /// configured in <see cref="async_sampling" /> and clears the batch.
+        /// </summary>
+        /// <remarks>The caller must hold <see cref="async_lock" />.</remarks>
+        void flush_batch(void);
+
         /// <summary>
         /// Answer whether the code has access to the internal timer of the
         /// bricklet.
@@ -164,12 +220,29 @@ namespace detail {
 #endif /* defined(CUSTOM_TINKERFORGE_FIRMWARE) */
 
         /// <summary>
-        /// If <see cref="on_measurement" /> is set, invoke the callback with
-        /// the data stored in <see cref="async_data" />.
+        /// Adds the given reading to <see cref="async_data" /> and, if this
+        /// completes a sample of all enabled quantities, delivers the sample
+        /// to the callback configured in <see cref="async_sampling" />.
         /// </summary>
         /// <remarks>The caller must hold <see cref="async_lock" />.</remarks>
-        /// <param name="timestamp"></param>
-        void invoke_callback(const power_overwhelming::timestamp timestamp);
+        /// <param name="quantity">The quantity that has been read.</param>
+        /// <param name="value">The raw reading in milli units.</param>
+        /// <param name="timestamp">The time of the reading.</param>
+        void invoke_callback(const tinkerforge_sensor_source quantity,
+            const std::int32_t value,
+            const power_overwhelming::timestamp timestamp);
+
+        /// <summary>
+        /// Computes the callback period for streaming mode, which is at least
+        /// <paramref name="period" />, but not shorter than the time the ADC
+        /// needs for a new value with its current configuration.
+        /// </summary>
+        /// <param name="period">The requested callback period in
+        /// milliseconds.</param>
+        /// <returns>The callback period in milliseconds.</returns>
+        /// <exception cref="tinkerforge_exception">If the configuration
+        /// could not be retrieved from the bricklet.</exception>
+        std::int32_t streaming_period(const std::int32_t period);
 
     };
 
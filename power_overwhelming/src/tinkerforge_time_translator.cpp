@@ -88,16 +88,38 @@ visus::power_overwhelming::detail::tinkerforge_time_translator::get_coord_times(
 }
 
 
+/*
+ * visus::power_overwhelming::detail::tinkerforge_time_translator::probe
+ */
+visus::power_overwhelming::detail::tinkerforge_time_translator::probe_type
+visus::power_overwhelming::detail::tinkerforge_time_translator::probe(
+        _In_ bricklet_type& bricklet) {
+#if defined(CUSTOM_TINKERFORGE_FIRMWARE)
+    probe_type retval;
+
+    retval.send = timestamp::now();
+    const auto status = ::voltage_current_v2_get_time(&bricklet,
+        &retval.bricklet);
+    retval.receive = timestamp::now();
+    if (status < 0) {
+        throw tinkerforge_exception(status);
+    }
+
+    return retval;
+
+#else /* defined(CUSTOM_TINKERFORGE_FIRMWARE) */
+    throw std::logic_error("This operation is not supported without the "
+        "customised firmware to read the clock of the bricklet.");
+#endif /* defined(CUSTOM_TINKERFORGE_FIRMWARE) */
+}
+
+
 /*
  * ...::detail::tinkerforge_time_translator::tinkerforge_time_translator
  */
 visus::power_overwhelming::detail::tinkerforge_time_translator
 ::tinkerforge_time_translator(void) noexcept
-        : _begin_bricklet(0),
-        _begin_host(0),
-        _next_update((std::numeric_limits<std::size_t>::max)()),
-        _time_offset(0),
-        _time_scale(1.0),
+        : _next_update((std::numeric_limits<std::size_t>::max)()),
         _update_every((std::numeric_limits<std::size_t>::max)()) { }
 
 
@@ -107,48 +129,19 @@ visus::power_overwhelming::detail::tinkerforge_time_translator
 bool visus::power_overwhelming::detail::tinkerforge_time_translator::update(
         _In_ bricklet_type& bricklet) noexcept {
 #if defined(CUSTOM_TINKERFORGE_FIRMWARE)
-    using namespace std::chrono;
-    assert(this->_begin_host != 0);
-    assert(this->_time_offset.count() != 0);
-    std::uint32_t btime;
-
-    // Determine the current time on the host and the bricklet.
-    const auto begin = timestamp::now();
-    const auto status = ::voltage_current_v2_get_time(&bricklet, &btime);
-    const auto end = timestamp::now();
-    if (status < 0) {
-        return false;
-    }
+    assert(*this);
 
-    const auto dt = end - begin;
-    const auto htime = begin + (dt  / 2);
-
-    // Compute the times elapsed on the host and on the bricklet.
-    const auto db = static_cast<double>(btime) - this->_begin_bricklet;
-    const auto dh = static_cast<double>(htime)
-        - static_cast<double>(this->_begin_host);
-
-    // Assuming both clocks having started at the same point in time, compute
-    // the scaling of the bricklet clock such that it runs at the same rate as
-    // the host system.
-    this->_time_scale = dh / db;
-
-    // Compute the (probable) point in time on the host when the time on the
-    // bricklet was zero. We need to scale the offset, because the result should
-    // be in the units of the clock on the host, but the offset we have is in
-    // ticks on the bricklet.
-    const timestamp_millis origin_offset(static_cast<timestamp::value_type>(
-        this->_time_scale * this->_begin_bricklet));
-    this->_time_offset = this->_begin_host.to_duration<std::milli>()
-        - origin_offset;
-
-    // Reset the update counter.
+    // Reset the update counter first such that a failing bricklet is not
+    // queried on every translation.
     this->_next_update = this->_update_every;
 
-    return true;
+    try {
+        return this->_model.add(probe(bricklet));
+    } catch (...) {
+        return false;
+    }
 #else /* defined(CUSTOM_TINKERFORGE_FIRMWARE) */
-    assert(this->_begin_host == 0);
-    assert(this->_time_offset.count() == 0);
+    assert(!*this);
     return false;
 #endif /* defined(CUSTOM_TINKERFORGE_FIRMWARE) */
 }
@@ -161,15 +154,11 @@ visus::power_overwhelming::timestamp
 visus::power_overwhelming::detail::tinkerforge_time_translator::operator ()(
         _In_ const bricklet_time_type time,
         _In_ bricklet_type& bricklet) {
-    using namespace std::chrono;
-    const auto offset = duration<double, std::milli>(time * this->_time_scale);
-
-    if (this->_update_every == 0) {
+    if (this->_next_update == 0) {
         this->update(bricklet);
     } else {
-        --this->_update_every;
+        --this->_next_update;
     }
 
-    const auto retval = (this->_time_offset + offset);
-    return timestamp(duration_cast<timestamp_duration>(retval).count());
+    return this->_model(time);
 }
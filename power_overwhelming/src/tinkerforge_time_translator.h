@@ -18,6 +18,7 @@
 #include "power_overwhelming/power_overwhelming_api.h"
 #include "power_overwhelming/timestamp.h"
 
+#include "tinkerforge_clock_model.h"
 #include "tinkerforge_exception.h"
 
 
@@ -52,6 +53,12 @@ namespace detail {
         /// </summary>
         typedef std::pair<timestamp, bricklet_time_type> times_type;
 
+        /// <summary>
+        /// The type of a single measurement of the bricklet clock including the
+        /// round trip on the host.
+        /// </summary>
+        typedef tinkerforge_clock_model::probe_type probe_type;
+
         /// <summary>
         /// Checks whether timestamps from the bricklet are supported, which
         /// requires two conditions to be met: first, the library must have been
@@ -71,11 +78,39 @@ namespace detail {
         /// <exception cref="tinkerforge_exception"></exception>
         static times_type get_coord_times(_In_ bricklet_type& bricklet);
 
+        /// <summary>
+        /// Measures the clock of the bricklet along with the times on the host
+        /// before and after the request.
+        /// </summary>
+        /// <param name="bricklet"></param>
+        /// <returns></returns>
+        /// <exception cref="tinkerforge_exception"></exception>
+        static probe_type probe(_In_ bricklet_type& bricklet);
+
         /// <summary>
         /// Initialises a new instance.
         /// </summary>
         tinkerforge_time_translator(void) noexcept;
 
+        /// <summary>
+        /// Answer the estimated relative drift of the bricklet clock with
+        /// respect to the host clock.
+        /// </summary>
+        /// <returns>The relative drift, which can be multiplied by one million
+        /// to obtain parts per million.</returns>
+        inline double drift(void) const noexcept {
+            return this->_model.drift();
+        }
+
+        /// <summary>
+        /// Answer the estimated time on the host when the clock of the
+        /// bricklet was zero.
+        /// </summary>
+        /// <returns>The estimated offset of the bricklet clock.</returns>
+        inline timestamp offset(void) const noexcept {
+            return this->_model.offset();
+        }
+
         /// <summary>
         /// Resets the calibration for the given bricklet by estimating the
         /// clock drift over the specified timespan.
@@ -83,6 +118,9 @@ namespace detail {
         /// <remarks>
         /// <para>This method has no effect unless <see cref="check_support" />
         /// returns <c>true</c> for <paramref name="bricklet" />.</para>
+        /// <para>The method probes the clock of the bricklet several times
+        /// during the time span such that the clock model can reject probes
+        /// that have been delayed.</para>
         /// <para>Longer <paramref name="time_span" />s typically yield more
         /// reliable translations, but obviously take longer.</para>
         /// </remarks>
@@ -103,8 +141,8 @@ namespace detail {
         }
 
         /// <summary>
-        /// Updates the estimate of the offset and the scaling based on the
-        /// time elapsed since the last <see cref="reset" />.
+        /// Adds a new probe of the bricklet clock to the clock model and
+        /// updates the estimate of the offset and the drift.
         /// </summary>
         /// <remarks>
         /// <para>This method must only be called if the times have been reset
@@ -115,7 +153,9 @@ namespace detail {
         /// our modified firmware.</para>
         /// </remarks>
         /// <param name="bricklet"></param>
-        /// <returns></returns>
+        /// <returns><c>true</c> if the probe has been used to update the
+        /// model, <c>false</c> if it could not be obtained or has been
+        /// rejected as an outlier.</returns>
         bool update(_In_ bricklet_type& bricklet) noexcept;
 
         /// <summary>
@@ -124,7 +164,7 @@ namespace detail {
         /// </summary>
         /// <param name="cnt"></param>
         inline void update_every(_In_ std::size_t cnt) noexcept {
-            this->_update_every = cnt;
+            this->_next_update = this->_update_every = cnt;
         }
 
         /// <summary>
@@ -132,7 +172,7 @@ namespace detail {
         /// used.
         /// </summary>
         inline operator bool(void) const noexcept {
-            return (this->_begin_host != 0);
+            return !this->_model.empty();
         }
 
         /// <summary>
@@ -147,28 +187,14 @@ namespace detail {
     private:
 
         /// <summary>
-        /// The duration of native timestamp ticks.
-        /// </summary>
-        typedef std::chrono::duration<timestamp::value_type,
-            std::ratio<1, timestamp::tick_rate>> timestamp_duration;
-
-        /// <summary>
-        /// A timestamp value in milliseconds.
+        /// The number of probes taken by <see cref="reset" />.
         /// </summary>
-        typedef std::chrono::duration<timestamp::value_type, std::milli>
-            timestamp_millis;
+        static constexpr std::size_t reset_probes = 8;
 
         /// <summary>
-        /// The timestamp on the bricklet when the first calibration was
-        /// performed in <see cref="reset " />.
+        /// The model translating bricklet times to host times.
         /// </summary>
-        double _begin_bricklet;
-
-        /// <summary>
-        /// The timestamp on the host when the first calibration was performed
-        /// in <see cref="reset " />.
-        /// </summary>
-        timestamp _begin_host;
+        tinkerforge_clock_model _model;
 
         /// <summary>
         /// Tracks how many translations need to be made before the next
@@ -176,18 +202,6 @@ namespace detail {
         /// </summary>
         std::size_t _next_update;
 
-        /// <summary>
-        /// The wall-clock timestamp (in milliseconds) from the zero-point
-        /// of the time reported by the bricklet with Moritz' custom firmware.
-        /// </summary>
-        timestamp_millis _time_offset;
-
-        /// <summary>
-        /// Allows for adapting the slope of the bricklets clock to the system
-        /// clock (the dübel constant).
-        /// </summary>
-        double _time_scale;
-
         /// <summary>
         /// The number of translations that will trigger an automatic
         /// <see cref="update" />.
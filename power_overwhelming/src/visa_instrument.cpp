@@ -712,6 +712,35 @@ visus::power_overwhelming::visa_instrument::query(_In_z_ const wchar_t *query,
 }
 
 
+/*
+ * visus::power_overwhelming::visa_instrument::query
+ */
+std::size_t visus::power_overwhelming::visa_instrument::query(
+        _Inout_ blob& response,
+        _In_z_ const char *query) const {
+    auto& impl = this->check_not_disposed();
+    impl.write(query);
+    // Note: we cannot check the system state in case of a query as this is a
+    // query in itself that cannot overlap.
+    return impl.read_all(response);
+}
+
+
+/*
+ * visus::power_overwhelming::visa_instrument::query
+ */
+std::size_t visus::power_overwhelming::visa_instrument::query(
+        _Inout_ blob& response,
+        _In_z_ const wchar_t *query) const {
+    auto& impl = this->check_not_disposed();
+    auto q = convert_string<char>(query);
+    impl.write(q.c_str());
+    // Note: we cannot check the system state in case of a query as this is a
+    // query in itself that cannot overlap.
+    return impl.read_all(response);
+}
+
+
 /*
  * visus::power_overwhelming::visa_instrument::read
  */
@@ -739,6 +768,16 @@ visus::power_overwhelming::visa_instrument::read_all(
 }
 
 
+/*
+ * visus::power_overwhelming::visa_instrument::read_all
+ */
+std::size_t visus::power_overwhelming::visa_instrument::read_all(
+        _Inout_ blob& dst) const {
+    auto& impl = this->check_not_disposed();
+    return impl.read_all(dst);
+}
+
+
 /*
  * visus::power_overwhelming::visa_instrument::read_binary
  */
@@ -751,6 +790,40 @@ visus::power_overwhelming::visa_instrument::read_binary(void) const {
 }
 
 
+/*
+ * visus::power_overwhelming::visa_instrument::read_binary
+ */
+std::size_t visus::power_overwhelming::visa_instrument::read_binary(
+        _Inout_ blob& dst) const {
+    auto& impl = this->check_not_disposed();
+    auto retval = impl.read_binary(dst);
+    this->throw_on_system_error();
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::visa_instrument::read_binary
+ */
+std::size_t visus::power_overwhelming::visa_instrument::read_binary(
+        _In_ const binary_chunk_callback callback,
+        _In_opt_ void *context,
+        _In_ const std::size_t chunk_size) const {
+    if (callback == nullptr) {
+        throw std::invalid_argument("The callback receiving the binary data "
+            "must not be nullptr.");
+    }
+    if (chunk_size == 0) {
+        throw std::invalid_argument("The size of a chunk must be positive.");
+    }
+
+    auto& impl = this->check_not_disposed();
+    auto retval = impl.read_binary(callback, context, chunk_size);
+    this->throw_on_system_error();
+    return retval;
+}
+
+
 /*
  * visus::power_overwhelming::visa_instrument::reset
  */
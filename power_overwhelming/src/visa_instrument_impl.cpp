@@ -6,6 +6,9 @@
 
 #include "visa_instrument_impl.h"
 
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
 #include <stdexcept>
 
 #include "no_visa_error_msg.h"
@@ -334,10 +337,24 @@ std::size_t visus::power_overwhelming::detail::visa_instrument_impl::read(
 visus::power_overwhelming::blob
 visus::power_overwhelming::detail::visa_instrument_impl::read_all(
         _In_ const std::size_t buffer_size) const {
+    blob retval;
+    this->read_all(retval, buffer_size);
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::visa_instrument_impl::read_all
+ */
+std::size_t visus::power_overwhelming::detail::visa_instrument_impl::read_all(
+        _Inout_ blob& dst,
+        _In_ const std::size_t buffer_size) const {
 #if defined(POWER_OVERWHELMING_WITH_VISA)
     static const std::size_t min_size = 1;
 
-    blob retval((std::max)(buffer_size, min_size));
+    // The previous content of 'dst' is irrelevant, but we use all of its
+    // capacity such that a blob reused by the caller is not reallocated.
+    dst.resize((std::max)({ dst.capacity(), buffer_size, min_size }));
     ViUInt32 offset = 0;
     ViUInt32 read = 0;
     ViStatus status = VI_SUCCESS_MAX_CNT;
@@ -345,28 +362,31 @@ visus::power_overwhelming::detail::visa_instrument_impl::read_all(
     while (status == VI_SUCCESS_MAX_CNT) {
         status = detail::visa_library::instance().viRead(
             this->session,
-            retval.as<ViByte>(offset),
-            static_cast<ViUInt32>(retval.size() - offset),
+            dst.as<ViByte>(offset),
+            static_cast<ViUInt32>(dst.size() - offset),
             &read);
         offset += read;
 
         if (status == VI_SUCCESS_MAX_CNT) {
             // Increase the buffer size if the message was not completely read.
             // The 50% increase is something used by many STL vector
-            // implementations, so it is probably a reasonable heuristic.
-            retval.grow(retval.size() + (std::max)(retval.size() / 2,
-                min_size));
+            // implementations, so it is probably a reasonable heuristic. The
+            // blob will round this up to its next size class, which we use
+            // completely.
+            dst.grow(dst.size() + (std::max)(dst.size() / 2, min_size));
+            dst.truncate(dst.capacity());
         } else {
             // Terminate in case of any error.
             visa_exception::throw_on_error(status);
         }
     };
 
-    retval.truncate(offset);
+    dst.truncate(offset);
 
-    return retval;
+    return offset;
 #else /*defined(POWER_OVERWHELMING_WITH_VISA) */
-    return blob();
+    dst.clear();
+    return 0;
 #endif /*defined(POWER_OVERWHELMING_WITH_VISA) */
 }
 
@@ -377,30 +397,119 @@ visus::power_overwhelming::detail::visa_instrument_impl::read_all(
 visus::power_overwhelming::blob
 visus::power_overwhelming::detail::visa_instrument_impl::read_binary(
         void) const {
+    blob retval;
+    this->read_binary(retval);
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::visa_instrument_impl::read_binary
+ */
+std::size_t visus::power_overwhelming::detail::visa_instrument_impl::read_binary(
+        _Inout_ blob& dst) const {
 #if defined(POWER_OVERWHELMING_WITH_VISA)
-    blob retval(16);
-    std::size_t size = 0;
+    dst.resize(this->read_binary_header());
+
+    auto rem = dst.size();
+    while (rem > 0) {
+        rem -= this->read(dst.end() - rem, rem);
+    }
 
-    this->read(retval.begin(), 2);
-    if (*retval.as<char>(0) != '#') {
+    // Read and discard all junk that might be in the buffer. If we do not
+    // do this, the next query could be interrupted. This might also fail,
+    // in which case we just ignore it.
+    try {
+        this->read_all();
+    } catch (...) { }
+
+    return dst.size();
+#else /*defined(POWER_OVERWHELMING_WITH_VISA) */
+    dst.clear();
+    return 0;
+#endif /*defined(POWER_OVERWHELMING_WITH_VISA) */
+}
+
+
+/*
+ * visus::power_overwhelming::detail::visa_instrument_impl::read_binary
+ */
+std::size_t visus::power_overwhelming::detail::visa_instrument_impl::read_binary(
+        _In_ const visa_instrument::binary_chunk_callback callback,
+        _In_opt_ void *context,
+        _In_ const std::size_t chunk_size) const {
+    assert(callback != nullptr);
+    assert(chunk_size > 0);
+#if defined(POWER_OVERWHELMING_WITH_VISA)
+    const auto retval = this->read_binary_header();
+    this->read_binary_data(retval, callback, context, chunk_size);
+    return retval;
+#else /*defined(POWER_OVERWHELMING_WITH_VISA) */
+    return 0;
+#endif /*defined(POWER_OVERWHELMING_WITH_VISA) */
+}
+
+
+/*
+ * ...::detail::visa_instrument_impl::read_binary_data
+ */
+void visus::power_overwhelming::detail::visa_instrument_impl::read_binary_data(
+        _In_ const std::size_t size,
+        _In_ const visa_instrument::binary_chunk_callback callback,
+        _In_opt_ void *context,
+        _In_ const std::size_t chunk_size) const {
+    assert(callback != nullptr);
+    assert(chunk_size > 0);
+#if defined(POWER_OVERWHELMING_WITH_VISA)
+    blob chunk((std::min)(size, chunk_size));
+
+    auto rem = size;
+    while (rem > 0) {
+        const auto cnt = this->read(chunk.begin(), (std::min)(rem,
+            chunk.size()));
+        callback(chunk.begin(), cnt, context);
+        rem -= cnt;
+    }
+
+    // Read and discard all junk that might be in the buffer. If we do not
+    // do this, the next query could be interrupted. This might also fail,
+    // in which case we just ignore it.
+    try {
+        this->read_all();
+    } catch (...) { }
+#endif /*defined(POWER_OVERWHELMING_WITH_VISA) */
+}
+
+
+/*
+ * ...::detail::visa_instrument_impl::read_binary_header
+ */
+std::size_t
+visus::power_overwhelming::detail::visa_instrument_impl::read_binary_header(
+        void) const {
+#if defined(POWER_OVERWHELMING_WITH_VISA)
+    blob buffer(16);
+    std::size_t retval = 0;
+
+    this->read(buffer.begin(), 2);
+    if (*buffer.as<char>(0) != '#') {
         throw std::runtime_error("The instrument did not send the expected "
             "type of binary response.");
     }
 
-    if (*retval.as<char>(1) == '(') {
+    if (*buffer.as<char>(1) == '(') {
         // This is the "variable length" mode where the data starts with
         // #(<number of bytes>). We need to read the input character by
         // character until we read the closing parenthesis.
         byte_type byte = 0;
         bool need_more = true;
 
-        assert(size == 0);
         while (need_more) {
             this->read(&byte, 1);
 
             if ((byte >= '0') && (byte <= '9')) {
-                size *= 10;
-                size += byte - '0';
+                retval *= 10;
+                retval += byte - '0';
 
             } else if (byte == ')') {
                 need_more = false;
@@ -415,32 +524,18 @@ visus::power_overwhelming::detail::visa_instrument_impl::read_binary(
         // This is the "normal length" more where the data starts with
         // #<digits><number of bytes>. In this mode, the second character
         // is the number of digits to follow (at most 9).
-        *retval.as<char>(2) = 0;
-        const auto digits = std::atoi(retval.as<char>(1));
-        retval.reserve(digits + 1);
-        this->read(retval.begin(), digits);
+        *buffer.as<char>(2) = 0;
+        const auto digits = std::atoi(buffer.as<char>(1));
+        buffer.reserve(digits + 1);
+        this->read(buffer.begin(), digits);
 
-        *retval.as<char>(digits) = 0;
-        size = std::atoi(retval.as<char>());
+        *buffer.as<char>(digits) = 0;
+        retval = std::atoi(buffer.as<char>());
     }
 
-    retval.reserve(size);
-
-    auto rem = retval.size();
-    while (rem > 0) {
-        rem -= this->read(retval.end() - rem, rem);
-    }
-
-    // Read and discard all junk that might be in the buffer. If we do not
-    // do this, the next query could be interrupted. This might also fail,
-    // in which case we just ignore it.
-    try {
-        this->read_all();
-    } catch (...) { }
-
     return retval;
 #else /*defined(POWER_OVERWHELMING_WITH_VISA) */
-    return blob();
+    return 0;
 #endif /*defined(POWER_OVERWHELMING_WITH_VISA) */
 }
 
@@ -312,6 +312,23 @@ namespace detail {
         /// <exception cref="visa_exception">If the operation failed.</exception>
         blob read_all(_In_ const std::size_t buffer_size = 1024) const;
 
+        /// <summary>
+        /// Read a full response into <paramref name="dst" />, reusing its
+        /// memory if possible.
+        /// </summary>
+        /// <remarks>
+        /// <para>This method never checks the system state, because it is
+        /// required for implementing the check of the system state.</para>
+        /// </remarks>
+        /// <param name="dst">The blob receiving the response, which will be
+        /// truncated to the size of the response.</param>
+        /// <param name="buffer_size">The minimum size of the read buffer being
+        /// used.</param>
+        /// <returns>The size of the response in bytes.</returns>
+        /// <exception cref="visa_exception">If the operation failed.</exception>
+        std::size_t read_all(_Inout_ blob& dst,
+            _In_ const std::size_t buffer_size = 1024) const;
+
         /// <summary>
         /// Reads a binary response starting with the # marker for the number of
         /// bytes to follow.
@@ -327,6 +344,82 @@ namespace detail {
         /// binary.</exception>
         blob read_binary(void) const;
 
+        /// <summary>
+        /// Reads a binary response starting with the # marker for the number of
+        /// bytes to follow into <paramref name="dst" />, reusing its memory if
+        /// possible.
+        /// </summary>
+        /// <remarks>
+        /// <para>This method never checks the system state, because it is
+        /// required for implementing the check of the system state.</para>
+        /// </remarks>
+        /// <param name="dst">The blob receiving the binary data excluding the
+        /// length marker.</param>
+        /// <returns>The size of the binary data in bytes.</returns>
+        /// <exception cref="visa_exception">If the operation failed.</exception>
+        /// <exception cref="std::runtime_error">If the data being read are not
+        /// binary.</exception>
+        std::size_t read_binary(_Inout_ blob& dst) const;
+
+        /// <summary>
+        /// Reads a binary response starting with the # marker for the number of
+        /// bytes to follow and passes the data to <paramref name="callback" />
+        /// in chunks of at most <paramref name="chunk_size" /> bytes.
+        /// </summary>
+        /// <remarks>
+        /// <para>This method never checks the system state, because it is
+        /// required for implementing the check of the system state.</para>
+        /// </remarks>
+        /// <param name="callback">The callback receiving the chunks.</param>
+        /// <param name="context">The context to be passed to
+        /// <paramref name="callback" />.</param>
+        /// <param name="chunk_size">The maximum size of a chunk in bytes.
+        /// </param>
+        /// <returns>The total size of the binary data excluding the length
+        /// marker.</returns>
+        /// <exception cref="visa_exception">If the operation failed.</exception>
+        /// <exception cref="std::runtime_error">If the data being read are not
+        /// binary.</exception>
+        std::size_t read_binary(
+            _In_ const visa_instrument::binary_chunk_callback callback,
+            _In_opt_ void *context,
+            _In_ const std::size_t chunk_size) const;
+
+        /// <summary>
+        /// Reads <paramref name="size" /> bytes of binary data following a
+        /// length marker that has already been read by
+        /// <see cref="read_binary_header" /> and passes them to
+        /// <paramref name="callback" /> in chunks of at most
+        /// <paramref name="chunk_size" /> bytes.
+        /// </summary>
+        /// <remarks>
+        /// This allows callers to decide how to process the data based on
+        /// their size before receiving them. This method never checks the
+        /// system state.
+        /// </remarks>
+        /// <param name="size">The size of the binary data as returned by
+        /// <see cref="read_binary_header" />.</param>
+        /// <param name="callback">The callback receiving the chunks.</param>
+        /// <param name="context">The context to be passed to
+        /// <paramref name="callback" />.</param>
+        /// <param name="chunk_size">The maximum size of a chunk in bytes.
+        /// </param>
+        /// <exception cref="visa_exception">If the operation failed.</exception>
+        void read_binary_data(_In_ const std::size_t size,
+            _In_ const visa_instrument::binary_chunk_callback callback,
+            _In_opt_ void *context,
+            _In_ const std::size_t chunk_size) const;
+
+        /// <summary>
+        /// Reads the length marker of a binary response.
+        /// </summary>
+        /// <returns>The number of bytes of binary data following the marker.
+        /// </returns>
+        /// <exception cref="visa_exception">If the operation failed.</exception>
+        /// <exception cref="std::runtime_error">If the data being read are not
+        /// binary.</exception>
+        std::size_t read_binary_header(void) const;
+
         /// <summary>
         /// Release the reference on the object and free it if this was the last
         /// reference.
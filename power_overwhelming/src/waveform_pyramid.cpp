@@ -0,0 +1,357 @@
+﻿// <copyright file="waveform_pyramid.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/waveform_pyramid.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+
+#include "power_overwhelming/convert_string.h"
+
+#include "waveform_pyramid_impl.h"
+
+
+/*
+ * visus::power_overwhelming::waveform_pyramid::load
+ */
+visus::power_overwhelming::waveform_pyramid
+visus::power_overwhelming::waveform_pyramid::load(_In_z_ const char *path) {
+    if (path == nullptr) {
+        throw std::invalid_argument("The path to the waveform pyramid must not "
+            "be nullptr.");
+    }
+
+    std::ifstream s;
+    s.exceptions(s.exceptions() | std::ios::failbit | std::ios::badbit);
+    s.open(path, std::ifstream::in | std::ifstream::binary);
+
+    return waveform_pyramid(detail::waveform_pyramid_impl::read(s).release());
+}
+
+
+/*
+ * visus::power_overwhelming::waveform_pyramid::load
+ */
+visus::power_overwhelming::waveform_pyramid
+visus::power_overwhelming::waveform_pyramid::load(_In_z_ const wchar_t *path) {
+    if (path == nullptr) {
+        throw std::invalid_argument("The path to the waveform pyramid must not "
+            "be nullptr.");
+    }
+
+    std::ifstream s;
+    s.exceptions(s.exceptions() | std::ios::failbit | std::ios::badbit);
+
+#if defined(_WIN32)
+    s.open(path, std::ifstream::in | std::ifstream::binary);
+#else /* defined(_WIN32) */
+    auto p = power_overwhelming::convert_string<char>(path);
+    s.open(p, std::ifstream::in | std::ifstream::binary);
+#endif /* defined(_WIN32) */
+
+    return waveform_pyramid(detail::waveform_pyramid_impl::read(s).release());
+}
+
+
+/*
+ * visus::power_overwhelming::waveform_pyramid::waveform_pyramid
+ */
+visus::power_overwhelming::waveform_pyramid::waveform_pyramid(
+        _In_ const timestamp origin,
+        _In_ const double sample_distance,
+        _In_ const std::size_t samples_per_bin,
+        _In_ const std::size_t fan_out)
+    : _impl(new detail::waveform_pyramid_impl(origin, sample_distance,
+        samples_per_bin, fan_out)) { }
+
+
+/*
+ * visus::power_overwhelming::waveform_pyramid::waveform_pyramid
+ */
+visus::power_overwhelming::waveform_pyramid::waveform_pyramid(
+        _In_ const oscilloscope_waveform& waveform,
+        _In_ const std::size_t samples_per_bin,
+        _In_ const std::size_t fan_out)
+    : _impl(nullptr) {
+    std::unique_ptr<detail::waveform_pyramid_impl> impl(
+        new detail::waveform_pyramid_impl(
+            waveform.sample_timestamp(0),
+            waveform.sample_distance(),
+            samples_per_bin,
+            fan_out));
+    impl->append(waveform.samples(), waveform.record_length());
+    this->_impl = impl.release();
+}
+
+
+/*
+ * visus::power_overwhelming::waveform_pyramid::~waveform_pyramid
+ */
+visus::power_overwhelming::waveform_pyramid::~waveform_pyramid(void) {
+    delete this->_impl;
+}
+
+
+/*
+ * visus::power_overwhelming::waveform_pyramid::append
+ */
+void visus::power_overwhelming::waveform_pyramid::append(
+        _In_reads_(cnt) const float *samples,
+        _In_ const std::size_t cnt) {
+    auto& impl = this->check_not_disposed();
+
+    if ((samples == nullptr) && (cnt > 0)) {
+        throw std::invalid_argument("The samples must not be nullptr.");
+    }
+
+    impl.append(samples, cnt);
+}
+
+
+/*
+ * visus::power_overwhelming::waveform_pyramid::fan_out
+ */
+std::size_t visus::power_overwhelming::waveform_pyramid::fan_out(
+        void) const noexcept {
+    return (this->_impl != nullptr) ? this->_impl->fan_out : 0;
+}
+
+
+/*
+ * visus::power_overwhelming::waveform_pyramid::levels
+ */
+std::size_t visus::power_overwhelming::waveform_pyramid::levels(
+        void) const noexcept {
+    return (this->_impl != nullptr) ? this->_impl->bins.size() : 0;
+}
+
+
+/*
+ * visus::power_overwhelming::waveform_pyramid::origin
+ */
+visus::power_overwhelming::timestamp
+visus::power_overwhelming::waveform_pyramid::origin(void) const noexcept {
+    return (this->_impl != nullptr) ? this->_impl->origin : timestamp::zero;
+}
+
+
+/*
+ * visus::power_overwhelming::waveform_pyramid::query
+ */
+std::size_t visus::power_overwhelming::waveform_pyramid::query(
+        _Out_writes_opt_(cnt) bin *dst,
+        _In_ const std::size_t cnt,
+        _In_ const std::size_t begin,
+        _In_ std::size_t end,
+        _Out_opt_ std::size_t *first,
+        _Out_opt_ std::size_t *width) const {
+    auto& impl = this->check_not_disposed();
+    end = (std::min)(end, impl.size);
+
+    if ((cnt < 1) || (begin >= end)) {
+        if (first != nullptr) {
+            *first = begin;
+        }
+        if (width != nullptr) {
+            *width = 0;
+        }
+        return 0;
+    }
+
+    // Find the finest level that covers the range with at most 'cnt' bins.
+    const auto top = impl.bins.size() - 1;
+    std::size_t level = 0;
+    std::uint64_t w = impl.width(level);
+    while ((level < top) && ((end - 1) / w - begin / w + 1 > cnt)) {
+        w = impl.width(++level);
+    }
+
+    // The search cannot fail, because the pyramid gets a new level as soon
+    // as the top one completes its first bin. The single open bin of the top
+    // level therefore covers all samples.
+    const auto begin_bin = begin / w;
+    const auto end_bin = (end - 1) / w + 1;
+    const auto retval = static_cast<std::size_t>(end_bin - begin_bin);
+    assert(retval <= cnt);
+
+    if (first != nullptr) {
+        *first = static_cast<std::size_t>(begin_bin * w);
+    }
+    if (width != nullptr) {
+        *width = static_cast<std::size_t>(w);
+    }
+
+    if (dst != nullptr) {
+        for (std::size_t i = 0; i < retval; ++i) {
+            dst[i] = impl.bin(level, begin_bin + i);
+        }
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::waveform_pyramid::query
+ */
+std::size_t visus::power_overwhelming::waveform_pyramid::query(
+        _Out_writes_opt_(cnt) bin *dst,
+        _In_ const std::size_t cnt,
+        _In_ const timestamp begin,
+        _In_ const timestamp end,
+        _Out_opt_ std::size_t *first,
+        _Out_opt_ std::size_t *width) const {
+    return this->query(dst, cnt,
+        this->sample_index(begin),
+        this->sample_index(end),
+        first,
+        width);
+}
+
+
+/*
+ * visus::power_overwhelming::waveform_pyramid::sample_distance
+ */
+double visus::power_overwhelming::waveform_pyramid::sample_distance(
+        void) const noexcept {
+    return (this->_impl != nullptr) ? this->_impl->sample_distance : 0.0;
+}
+
+
+/*
+ * visus::power_overwhelming::waveform_pyramid::sample_index
+ */
+std::size_t visus::power_overwhelming::waveform_pyramid::sample_index(
+        _In_ const timestamp timestamp) const noexcept {
+    if ((this->_impl == nullptr) || (timestamp <= this->_impl->origin)) {
+        return 0;
+    }
+
+    const auto dt = static_cast<double>((timestamp - this->_impl->origin).count())
+        / timestamp::tick_rate;
+    return static_cast<std::size_t>(std::llround(dt
+        / this->_impl->sample_distance));
+}
+
+
+/*
+ * visus::power_overwhelming::waveform_pyramid::sample_timestamp
+ */
+visus::power_overwhelming::timestamp
+visus::power_overwhelming::waveform_pyramid::sample_timestamp(
+        _In_ const std::size_t i) const noexcept {
+    if (this->_impl == nullptr) {
+        return timestamp::zero;
+    }
+
+    const auto dt = static_cast<double>(i) * this->_impl->sample_distance
+        * timestamp::tick_rate;
+    return timestamp(this->_impl->origin.value()
+        + static_cast<timestamp::value_type>(std::llround(dt)));
+}
+
+
+/*
+ * visus::power_overwhelming::waveform_pyramid::samples_per_bin
+ */
+std::size_t visus::power_overwhelming::waveform_pyramid::samples_per_bin(
+        void) const noexcept {
+    return (this->_impl != nullptr) ? this->_impl->samples_per_bin : 0;
+}
+
+
+/*
+ * visus::power_overwhelming::waveform_pyramid::save
+ */
+void visus::power_overwhelming::waveform_pyramid::save(
+        _In_z_ const char *path) const {
+    if (path == nullptr) {
+        throw std::invalid_argument("The path to the waveform pyramid must not "
+            "be nullptr.");
+    }
+
+    auto& impl = this->check_not_disposed();
+
+    std::ofstream s;
+    s.exceptions(s.exceptions() | std::ios::failbit | std::ios::badbit);
+    s.open(path, std::ofstream::out | std::ofstream::trunc
+        | std::ofstream::binary);
+    impl.write(s);
+    s.flush();
+}
+
+
+/*
+ * visus::power_overwhelming::waveform_pyramid::save
+ */
+void visus::power_overwhelming::waveform_pyramid::save(
+        _In_z_ const wchar_t *path) const {
+    if (path == nullptr) {
+        throw std::invalid_argument("The path to the waveform pyramid must not "
+            "be nullptr.");
+    }
+
+    auto& impl = this->check_not_disposed();
+
+    std::ofstream s;
+    s.exceptions(s.exceptions() | std::ios::failbit | std::ios::badbit);
+
+#if defined(_WIN32)
+    s.open(path, std::ofstream::out | std::ofstream::trunc
+        | std::ofstream::binary);
+#else /* defined(_WIN32) */
+    auto p = power_overwhelming::convert_string<char>(path);
+    s.open(p, std::ofstream::out | std::ofstream::trunc
+        | std::ofstream::binary);
+#endif /* defined(_WIN32) */
+
+    impl.write(s);
+    s.flush();
+}
+
+
+/*
+ * visus::power_overwhelming::waveform_pyramid::size
+ */
+std::size_t visus::power_overwhelming::waveform_pyramid::size(
+        void) const noexcept {
+    return (this->_impl != nullptr) ? this->_impl->size : 0;
+}
+
+
+/*
+ * visus::power_overwhelming::waveform_pyramid::operator =
+ */
+visus::power_overwhelming::waveform_pyramid&
+visus::power_overwhelming::waveform_pyramid::operator =(
+        _Inout_ waveform_pyramid&& rhs) noexcept {
+    if (this != std::addressof(rhs)) {
+        delete this->_impl;
+        this->_impl = rhs._impl;
+        rhs._impl = nullptr;
+    }
+
+    return *this;
+}
+
+
+/*
+ * visus::power_overwhelming::waveform_pyramid::check_not_disposed
+ */
+visus::power_overwhelming::detail::waveform_pyramid_impl&
+visus::power_overwhelming::waveform_pyramid::check_not_disposed(
+        void) const {
+    if (this->_impl == nullptr) {
+        throw std::runtime_error("A disposed instance of waveform_pyramid "
+            "cannot be used.");
+    }
+
+    return *this->_impl;
+}
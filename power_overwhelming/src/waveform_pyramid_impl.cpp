@@ -0,0 +1,335 @@
+﻿// <copyright file="waveform_pyramid_impl.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "waveform_pyramid_impl.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// The magic number at the begin of a serialised pyramid.
+    /// </summary>
+    static constexpr const char waveform_pyramid_magic[] = "PWROWGWP";
+
+    /// <summary>
+    /// The version of the file format.
+    /// </summary>
+    static constexpr const std::uint32_t waveform_pyramid_version = 1;
+
+    /// <summary>
+    /// Makes sure that the last read from <paramref name="stream" />
+    /// succeeded.
+    /// </summary>
+    inline void check_stream(_In_ const std::istream& stream) {
+        if (!stream) {
+            throw std::invalid_argument("The stream ended before the waveform "
+                "pyramid was complete.");
+        }
+    }
+
+    /// <summary>
+    /// Reads a trivially copyable value from the given stream.
+    /// </summary>
+    template<class TValue>
+    inline TValue read_value(_Inout_ std::istream& stream) {
+        TValue retval;
+        stream.read(reinterpret_cast<char *>(&retval), sizeof(retval));
+        check_stream(stream);
+        return retval;
+    }
+
+    /// <summary>
+    /// Writes a trivially copyable value to the given stream.
+    /// </summary>
+    template<class TValue>
+    inline void write_value(_Inout_ std::ostream& stream,
+            _In_ const TValue value) {
+        stream.write(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
+
+
+/*
+ * visus::power_overwhelming::detail::waveform_pyramid_impl::read
+ */
+std::unique_ptr<visus::power_overwhelming::detail::waveform_pyramid_impl>
+visus::power_overwhelming::detail::waveform_pyramid_impl::read(
+        _Inout_ std::istream& stream) {
+    {
+        char magic[sizeof(waveform_pyramid_magic) - 1];
+        stream.read(magic, sizeof(magic));
+        if (::memcmp(magic, waveform_pyramid_magic, sizeof(magic)) != 0) {
+            throw std::invalid_argument("The stream does not contain a "
+                "waveform pyramid.");
+        }
+    }
+
+    if (read_value<std::uint32_t>(stream) != waveform_pyramid_version) {
+        throw std::invalid_argument("The version of the waveform pyramid is "
+            "not supported.");
+    }
+
+    const auto samples_per_bin = read_value<std::uint64_t>(stream);
+    const auto fan_out = read_value<std::uint64_t>(stream);
+    const auto origin = read_value<timestamp::value_type>(stream);
+    const auto sample_distance = read_value<double>(stream);
+
+    if ((samples_per_bin < 1) || (samples_per_bin > SIZE_MAX)) {
+        throw std::invalid_argument("The number of samples per bin of the "
+            "waveform pyramid is invalid.");
+    }
+    if ((fan_out < 2) || (fan_out > SIZE_MAX)) {
+        throw std::invalid_argument("The fan-out of the waveform pyramid is "
+            "invalid.");
+    }
+
+    std::unique_ptr<waveform_pyramid_impl> retval(new waveform_pyramid_impl(
+        timestamp(origin),
+        sample_distance,
+        static_cast<std::size_t>(samples_per_bin),
+        static_cast<std::size_t>(fan_out)));
+
+    const auto size = read_value<std::uint64_t>(stream);
+    if (size > SIZE_MAX) {
+        throw std::invalid_argument("The waveform pyramid is too large.");
+    }
+    retval->size = static_cast<std::size_t>(size);
+
+    // The pyramid has a level for each bin width up to the first one that
+    // exceeds the number of samples, because close() adds a level as soon as
+    // the finer one has completed its first bin. Anything else is corrupt.
+    std::size_t expected_levels = 1;
+    for (auto w = samples_per_bin; w <= size; w *= fan_out) {
+        ++expected_levels;
+        if (w > size / fan_out) {
+            break;
+        }
+    }
+
+    if (read_value<std::uint64_t>(stream) != expected_levels) {
+        throw std::invalid_argument("The number of levels does not match the "
+            "size of the waveform pyramid.");
+    }
+
+    retval->bins.resize(expected_levels);
+    retval->open.resize(expected_levels);
+
+    for (std::size_t l = 0; l < expected_levels; ++l) {
+        // The bins of a level and the samples accumulated in its open bin
+        // must add up to the samples that have been completed at the next
+        // finer level.
+        const auto width = retval->width(l);
+        const auto finer = (l > 0) ? retval->width(l - 1) : 1;
+        const auto expected_bins = size / width;
+        const auto expected_open = size % width - size % finer;
+
+        if (read_value<std::uint64_t>(stream) != expected_bins) {
+            throw std::invalid_argument("The number of bins does not match the "
+                "size of the waveform pyramid.");
+        }
+
+        // Grow the level while reading such that a forged size cannot make
+        // us allocate more memory than the stream actually provides.
+        auto& bins = retval->bins[l];
+        while (bins.size() < expected_bins) {
+            const auto offset = bins.size();
+            const auto cnt = static_cast<std::size_t>((std::min)(
+                expected_bins - offset, static_cast<std::uint64_t>(4096)));
+            bins.resize(offset + cnt);
+            stream.read(reinterpret_cast<char *>(bins.data() + offset),
+                cnt * sizeof(bin_type));
+            check_stream(stream);
+        }
+
+        auto& open = retval->open[l];
+        open.maximum = read_value<float>(stream);
+        open.minimum = read_value<float>(stream);
+        open.sum = read_value<double>(stream);
+        open.count = read_value<std::uint64_t>(stream);
+
+        if (open.count != expected_open) {
+            throw std::invalid_argument("The open bin does not match the size "
+                "of the waveform pyramid.");
+        }
+    }
+
+    return retval;
+}
+
+
+/*
+ * ...::detail::waveform_pyramid_impl::waveform_pyramid_impl
+ */
+visus::power_overwhelming::detail::waveform_pyramid_impl::waveform_pyramid_impl(
+        _In_ const timestamp origin,
+        _In_ const double sample_distance,
+        _In_ const std::size_t samples_per_bin,
+        _In_ const std::size_t fan_out)
+    : bins(1), fan_out(fan_out), open(1), origin(origin),
+        sample_distance(sample_distance), samples_per_bin(samples_per_bin),
+        size(0) {
+    if (!(sample_distance > 0.0)) {
+        throw std::invalid_argument("The distance between two samples must be "
+            "positive.");
+    }
+    if (samples_per_bin < 1) {
+        throw std::invalid_argument("A bin must comprise at least one "
+            "sample.");
+    }
+    if (fan_out < 2) {
+        throw std::invalid_argument("The fan-out of the pyramid must be at "
+            "least two.");
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::waveform_pyramid_impl::append
+ */
+void visus::power_overwhelming::detail::waveform_pyramid_impl::append(
+        _In_reads_(cnt) const float *samples,
+        _In_ const std::size_t cnt) {
+    assert(!this->open.empty());
+    auto open = std::addressof(this->open.front());
+
+    for (std::size_t i = 0; i < cnt; ++i) {
+        open->add(samples[i]);
+
+        if (open->count == this->samples_per_bin) {
+            // Closing the bin might add a new level, which could relocate the
+            // accumulators, so we need to retrieve the pointer again.
+            this->close(0);
+            open = std::addressof(this->open.front());
+            assert(open->count == 0);
+        }
+    }
+
+    this->size += cnt;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::waveform_pyramid_impl::bin
+ */
+visus::power_overwhelming::detail::waveform_pyramid_impl::bin_type
+visus::power_overwhelming::detail::waveform_pyramid_impl::bin(
+        _In_ const std::size_t level,
+        _In_ const std::size_t i) const {
+    assert(level < this->bins.size());
+    const auto& bins = this->bins[level];
+
+    if (i < bins.size()) {
+        return bins[i];
+    } else {
+        assert(i == bins.size());
+        return this->tail(level).to_bin();
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::waveform_pyramid_impl::close
+ */
+void visus::power_overwhelming::detail::waveform_pyramid_impl::close(
+        _In_ std::size_t level) {
+    while (true) {
+        assert(level < this->open.size());
+        const auto bin = this->open[level].to_bin();
+        const auto count = this->open[level].count;
+        this->bins[level].push_back(bin);
+        this->open[level] = accumulator();
+
+        if (++level == this->open.size()) {
+            // Create the next coarser level on demand.
+            this->bins.emplace_back();
+            this->open.emplace_back();
+        }
+
+        auto& next = this->open[level];
+        next.add(bin, count);
+
+        if (next.count < this->width(level)) {
+            // The next level is not yet complete, so stop propagating.
+            break;
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::detail::waveform_pyramid_impl::tail
+ */
+visus::power_overwhelming::detail::waveform_pyramid_impl::accumulator
+visus::power_overwhelming::detail::waveform_pyramid_impl::tail(
+        _In_ const std::size_t level) const {
+    assert(level < this->open.size());
+    auto retval = this->open[level];
+
+    // The open bin of a level only contains the completed bins of the next
+    // finer level, so we need to add all the incomplete ones below.
+    for (std::size_t l = 0; l < level; ++l) {
+        retval.add(this->open[l]);
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::waveform_pyramid_impl::width
+ */
+std::uint64_t visus::power_overwhelming::detail::waveform_pyramid_impl::width(
+        _In_ const std::size_t level) const noexcept {
+    std::uint64_t retval = this->samples_per_bin;
+
+    for (std::size_t l = 0; l < level; ++l) {
+        retval *= this->fan_out;
+    }
+
+    return retval;
+}
+
+
+/*
+ * visus::power_overwhelming::detail::waveform_pyramid_impl::write
+ */
+void visus::power_overwhelming::detail::waveform_pyramid_impl::write(
+        _Inout_ std::ostream& stream) const {
+    assert(this->bins.size() == this->open.size());
+    stream.write(waveform_pyramid_magic, sizeof(waveform_pyramid_magic) - 1);
+    write_value(stream, waveform_pyramid_version);
+    write_value(stream, static_cast<std::uint64_t>(this->samples_per_bin));
+    write_value(stream, static_cast<std::uint64_t>(this->fan_out));
+    write_value(stream, this->origin.value());
+    write_value(stream, this->sample_distance);
+    write_value(stream, static_cast<std::uint64_t>(this->size));
+    write_value(stream, static_cast<std::uint64_t>(this->bins.size()));
+
+    for (std::size_t l = 0; l < this->bins.size(); ++l) {
+        const auto& bins = this->bins[l];
+        write_value(stream, static_cast<std::uint64_t>(bins.size()));
+        stream.write(reinterpret_cast<const char *>(bins.data()),
+            bins.size() * sizeof(bin_type));
+
+        const auto& open = this->open[l];
+        write_value(stream, open.maximum);
+        write_value(stream, open.minimum);
+        write_value(stream, open.sum);
+        write_value(stream, open.count);
+    }
+}
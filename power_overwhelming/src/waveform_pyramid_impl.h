@@ -0,0 +1,181 @@
+﻿// <copyright file="waveform_pyramid_impl.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#include <cinttypes>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "power_overwhelming/waveform_pyramid.h"
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace detail {
+
+    /// <summary>
+    /// Private data container for the <see cref="waveform_pyramid" />.
+    /// </summary>
+    struct waveform_pyramid_impl final {
+
+        /// <summary>
+        /// The type of a bin in the pyramid.
+        /// </summary>
+        typedef waveform_pyramid::bin bin_type;
+
+        /// <summary>
+        /// Accumulates the summary of a bin that has not yet been completed.
+        /// </summary>
+        struct accumulator final {
+            float maximum;
+            float minimum;
+            double sum;
+            std::uint64_t count;
+
+            inline accumulator(void) noexcept
+                : maximum(std::numeric_limits<float>::lowest()),
+                minimum((std::numeric_limits<float>::max)()),
+                sum(0.0),
+                count(0) { }
+
+            inline void add(_In_ const float value) noexcept {
+                if (value > this->maximum) {
+                    this->maximum = value;
+                }
+                if (value < this->minimum) {
+                    this->minimum = value;
+                }
+                this->sum += value;
+                ++this->count;
+            }
+
+            inline void add(_In_ const bin_type& bin,
+                    _In_ const std::uint64_t count) noexcept {
+                if (bin.maximum > this->maximum) {
+                    this->maximum = bin.maximum;
+                }
+                if (bin.minimum < this->minimum) {
+                    this->minimum = bin.minimum;
+                }
+                this->sum += static_cast<double>(bin.mean) * count;
+                this->count += count;
+            }
+
+            inline void add(_In_ const accumulator& rhs) noexcept {
+                if (rhs.maximum > this->maximum) {
+                    this->maximum = rhs.maximum;
+                }
+                if (rhs.minimum < this->minimum) {
+                    this->minimum = rhs.minimum;
+                }
+                this->sum += rhs.sum;
+                this->count += rhs.count;
+            }
+
+            inline bin_type to_bin(void) const noexcept {
+                bin_type retval;
+                retval.maximum = this->maximum;
+                retval.mean = (this->count > 0)
+                    ? static_cast<float>(this->sum / this->count)
+                    : 0.0f;
+                retval.minimum = this->minimum;
+                return retval;
+            }
+        };
+
+        /// <summary>
+        /// The bins of each level that have been completed.
+        /// </summary>
+        std::vector<std::vector<bin_type>> bins;
+
+        /// <summary>
+        /// The number of bins combined into a bin of the next level.
+        /// </summary>
+        std::size_t fan_out;
+
+        /// <summary>
+        /// The incomplete bin at the end of each level. This vector always has
+        /// the same size as <see cref="bins" />.
+        /// </summary>
+        std::vector<accumulator> open;
+
+        /// <summary>
+        /// The timestamp of the first sample.
+        /// </summary>
+        timestamp origin;
+
+        /// <summary>
+        /// The distance between two samples in seconds.
+        /// </summary>
+        double sample_distance;
+
+        /// <summary>
+        /// The number of samples in a bin of the finest level.
+        /// </summary>
+        std::size_t samples_per_bin;
+
+        /// <summary>
+        /// The total number of samples added to the pyramid.
+        /// </summary>
+        std::size_t size;
+
+        /// <summary>
+        /// Restores a pyramid from the given stream that has been written by
+        /// <see cref="write" />.
+        /// </summary>
+        static std::unique_ptr<waveform_pyramid_impl> read(
+            _Inout_ std::istream& stream);
+
+        /// <summary>
+        /// Initialises a new instance.
+        /// </summary>
+        waveform_pyramid_impl(_In_ const timestamp origin,
+            _In_ const double sample_distance,
+            _In_ const std::size_t samples_per_bin,
+            _In_ const std::size_t fan_out);
+
+        /// <summary>
+        /// Adds the given samples to the pyramid.
+        /// </summary>
+        void append(_In_reads_(cnt) const float *samples,
+            _In_ const std::size_t cnt);
+
+        /// <summary>
+        /// Answer the <paramref name="i" />th bin of the given level, including
+        /// the incomplete one at the end.
+        /// </summary>
+        bin_type bin(_In_ const std::size_t level,
+            _In_ const std::size_t i) const;
+
+        /// <summary>
+        /// Moves the open bin of the given level to the completed ones and
+        /// propagates it to the next coarser level.
+        /// </summary>
+        void close(_In_ std::size_t level);
+
+        /// <summary>
+        /// Answer the summary of all samples in the incomplete bin of the
+        /// given level, which includes the incomplete bins of all finer levels.
+        /// </summary>
+        accumulator tail(_In_ const std::size_t level) const;
+
+        /// <summary>
+        /// Answer the number of samples summarised by a bin of the given level.
+        /// </summary>
+        std::uint64_t width(_In_ const std::size_t level) const noexcept;
+
+        /// <summary>
+        /// Writes the state of the pyramid to the given stream.
+        /// </summary>
+        void write(_Inout_ std::ostream& stream) const;
+    };
+
+} /* namespace detail */
+} /* namespace power_overwhelming */
+} /* namespace visus */
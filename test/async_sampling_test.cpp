@@ -23,6 +23,8 @@ namespace test {
             Assert::IsNull(as.context(), L"Context is null", LINE_INFO());
             Assert::AreEqual(int(tinkerforge_sensor_source::all), int(as.tinkerforge_sensor_source()), L"All Tinkerforge enabled", LINE_INFO());
             Assert::AreEqual(async_sampling::default_interval, as.interval(), L"1000 us default interval", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(0), as.coalescing_window(), L"Coalescing window derived from interval", LINE_INFO());
+            Assert::AreEqual(std::size_t(1), as.batch_size(), L"No batching", LINE_INFO());
             Assert::IsFalse(bool(as), L"Not enabled", LINE_INFO());
         }
 
@@ -49,9 +51,13 @@ namespace test {
                 .samples_every(1000)
                 .delivers_measurement_data_to(cb)
                 .from_source(tinkerforge_sensor_source::power)
+                .coalesces_within(std::chrono::milliseconds(2))
+                .delivers_in_batches_of(64)
                 .passes_context((void *) 42));
 
             Assert::AreEqual(intptr_t(42), intptr_t(as.context()), L"Context is 42", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(2000), as.coalescing_window(), L"2 ms coalescing window", LINE_INFO());
+            Assert::AreEqual(std::size_t(64), as.batch_size(), L"Batches of 64", LINE_INFO());
             Assert::AreEqual(int(tinkerforge_sensor_source::power), int(as.tinkerforge_sensor_source()), L"Power only", LINE_INFO());
             Assert::AreEqual(std::uint64_t(1000), as.interval(), L"1 ms interval", LINE_INFO());
             Assert::AreEqual(int(async_delivery_method::on_measurement_data), int(as.delivery_method()), L"on_measurement_data enabled", LINE_INFO());
@@ -72,6 +78,20 @@ namespace test {
             Assert::IsTrue(bool(as), L"Is enabled", LINE_INFO());
         }
 
+        TEST_METHOD(test_hmc8015_sample) {
+            const auto cb = [](const wchar_t *, const hmc8015_sample *, const std::size_t, void *) { };
+
+            const auto as = std::move(async_sampling()
+                .samples_every(1000)
+                .delivers_hmc8015_samples_to(cb)
+                .passes_context((void *)42));
+
+            Assert::AreEqual(intptr_t(42), intptr_t(as.context()), L"Context is 42", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(1000), as.interval(), L"1 ms interval", LINE_INFO());
+            Assert::AreEqual(int(async_delivery_method::on_hmc8015_sample), int(as.delivery_method()), L"on_hmc8015_sample enabled", LINE_INFO());
+            Assert::IsTrue(bool(as), L"Is enabled", LINE_INFO());
+        }
+
         TEST_METHOD(test_thermal_sample) {
             const auto cb = [](const wchar_t *, const thermal_sample *, const std::size_t, void *) { };
 
@@ -155,6 +175,49 @@ namespace test {
             Assert::AreEqual(42.0f, data.temperature(), L"temperature assigned", LINE_INFO());
             Assert::AreEqual(L"dummy", source.c_str(), L"source assigned", LINE_INFO());
         }
+
+        TEST_METHOD(test_view_lambda) {
+            const float voltages[] = { 1.0f, 2.0f, 3.0f };
+            const float currents[] = { 4.0f, 5.0f, 6.0f };
+            const measurement_data_view view(voltages, currents, 3, timestamp(10), 0.000001);
+            const float *voltage = nullptr;
+            std::size_t size = 0;
+
+            const auto as = std::move(async_sampling()
+                .delivers_measurement_data_views_to_functor(
+                    [&](const wchar_t *s, const measurement_data_view *v, const std::size_t) {
+                voltage = v->voltages();
+                size = v->size();
+            }));
+
+            Assert::AreEqual(int(async_delivery_method::on_measurement_data_view), int(as.delivery_method()), L"on_measurement_data_view enabled", LINE_INFO());
+            Assert::IsTrue(as.deliver(L"dummy", view), L"View delivered", LINE_INFO());
+            Assert::IsTrue(voltage == voltages, L"View not copied", LINE_INFO());
+            Assert::AreEqual(std::size_t(3), size, L"size assigned", LINE_INFO());
+        }
+
+        TEST_METHOD(test_view_expansion) {
+            const float voltages[] = { 1.0f, 2.0f, 3.0f };
+            const float currents[] = { 4.0f, 5.0f, 6.0f };
+            const measurement_data_view view(voltages, currents, 3, timestamp(10), 0.000001);
+            std::vector<measurement_data> data;
+
+            const auto as = std::move(async_sampling()
+                .delivers_measurement_data_to_functor(
+                    [&](const wchar_t *s, const measurement_data *m, const std::size_t n) {
+                data.assign(m, m + n);
+            }));
+
+            Assert::IsTrue(as.deliver(L"dummy", view), L"View delivered", LINE_INFO());
+            Assert::AreEqual(std::size_t(3), data.size(), L"All samples expanded", LINE_INFO());
+            Assert::AreEqual(timestamp::value_type(10), data[0].timestamp().value(), L"timestamp[0]", LINE_INFO());
+            Assert::AreEqual(timestamp::value_type(30), data[2].timestamp().value(), L"timestamp[2]", LINE_INFO());
+            Assert::AreEqual(3.0f, data[2].voltage(), L"voltage[2]", LINE_INFO());
+            Assert::AreEqual(6.0f, data[2].current(), L"current[2]", LINE_INFO());
+
+            const auto nop = async_sampling().delivers_thermal_samples_to([](const wchar_t *, const thermal_sample *, const std::size_t, void *) { }).as_rvalue();
+            Assert::IsFalse(nop.deliver(L"dummy", view), L"Views not delivered to thermal samples", LINE_INFO());
+        }
     };
 
 } /* namespace test */
@@ -150,6 +150,81 @@ namespace test {
             Assert::AreEqual(std::int16_t(2), *static_cast<std::int16_t *>(b.at(2)), L"Data at 2", LINE_INFO());
         }
 
+        TEST_METHOD(capacity) {
+            blob b(100);
+            const auto data = b.data();
+            Assert::IsTrue(b.capacity() >= b.size(), L"Capacity covers size", LINE_INFO());
+
+            b.resize(50);
+            Assert::AreEqual(std::size_t(50), b.size(), L"Size after shrinking resize", LINE_INFO());
+            Assert::AreEqual(data, b.data(), L"Shrinking does not reallocate", LINE_INFO());
+
+            b.truncate(b.capacity());
+            Assert::AreEqual(b.capacity(), b.size(), L"Truncate to capacity", LINE_INFO());
+            Assert::AreEqual(data, b.data(), L"Truncate within capacity does not reallocate", LINE_INFO());
+
+            b.grow(b.capacity() + 1);
+            Assert::IsTrue(b.capacity() > b.size() / 2, L"Capacity after grow", LINE_INFO());
+        }
+
+        TEST_METHOD(pool) {
+            void *data = nullptr;
+            {
+                blob b(1000);
+                data = b.data();
+            }
+
+            {
+                blob b(900);
+                Assert::AreEqual(data, b.data(), L"Block of same size class is reused", LINE_INFO());
+            }
+
+            {
+                const std::size_t size = 3 * 1024 * 1024;
+                blob b(size);
+                b.as<std::uint8_t>()[0] = 1;
+                b.as<std::uint8_t>()[size - 1] = 2;
+                data = b.data();
+            }
+
+            {
+                blob b(3 * 1024 * 1024);
+                Assert::AreEqual(data, b.data(), L"Large block is reused", LINE_INFO());
+            }
+
+            {
+                blob b1(100);
+                blob b2(200);
+                b2 = std::move(b1);
+                Assert::IsNull(b1.data(), L"Moved from", LINE_INFO());
+                Assert::AreEqual(std::size_t(100), b2.size(), L"Move assigned", LINE_INFO());
+            }
+        }
+
+        TEST_METHOD(pool_budget) {
+            typedef detail::blob_pool pool;
+            pool::trim();
+
+            {
+                blob b(pool::max_class_size + 1);
+            }
+            Assert::AreEqual(std::size_t(0), pool::retained(), L"Oversized block is not cached", LINE_INFO());
+
+            {
+                std::vector<blob> blobs;
+                for (auto s = pool::max_class_size; s >= pool::large_page_size; s /= 2) {
+                    for (std::size_t i = 0; i < pool::cache_budget / s; ++i) {
+                        blobs.emplace_back(s);
+                    }
+                }
+            }
+            Assert::IsTrue(pool::retained() > 0, L"Blocks are cached", LINE_INFO());
+            Assert::IsTrue(pool::retained() <= pool::thread_budget, L"Thread budget is not exceeded", LINE_INFO());
+
+            pool::trim();
+            Assert::AreEqual(std::size_t(0), pool::retained(), L"Trim frees all blocks", LINE_INFO());
+        }
+
         TEST_METHOD(clear) {
             blob b(5);
 
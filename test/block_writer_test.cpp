@@ -0,0 +1,90 @@
+﻿// <copyright file="block_writer_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(block_writer_test) {
+
+    public:
+
+        TEST_METHOD(test_block_size) {
+            const std::filesystem::path output(L"block_writer_size.bin");
+            detail::block_writer writer(output.wstring().c_str(), 1);
+            writer.close();
+            Assert::IsFalse(writer.is_open(), L"Closed", LINE_INFO());
+            Assert::AreEqual(std::uintmax_t(0), std::filesystem::file_size(output), L"Empty file", LINE_INFO());
+            std::filesystem::remove(output);
+        }
+
+        TEST_METHOD(test_invalid) {
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                detail::block_writer writer(nullptr, 4096);
+            }, L"Null path", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                detail::block_writer writer(L"block_writer_invalid.bin", 0);
+            }, L"Empty block", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                detail::block_writer writer(L"block_writer_invalid.bin", 4096, 0);
+            }, L"No blocks", LINE_INFO());
+            std::filesystem::remove(L"block_writer_invalid.bin");
+        }
+
+        TEST_METHOD(test_write) {
+            const std::filesystem::path output(L"block_writer_write.csv");
+            const output_sync_policy policies[] = {
+                output_sync_policy::none,
+                output_sync_policy::on_close,
+                output_sync_policy::every_block
+            };
+
+            for (auto direct : { false, true }) {
+                for (auto policy : policies) {
+                    std::string expected;
+
+                    {
+                        // Use small blocks such that we write several of them
+                        // and end with an incomplete one.
+                        detail::block_writer writer(output.wstring().c_str(), 4096, 2, policy, direct);
+                        std::ostream stream(&writer);
+
+                        for (int i = 0; i < 10000; ++i) {
+                            std::stringstream line;
+                            line << "line" << i << ";" << (i * 0.5f) << '\n';
+                            expected += line.str();
+                            stream << line.str();
+                        }
+
+                        stream.write(expected.data(), 10000);
+                        expected.append(expected.data(), 10000);
+                        stream.flush();
+                        Assert::IsTrue(stream.good(), L"Stream is good", LINE_INFO());
+
+                        writer.close();
+                        Assert::IsFalse(writer.is_open(), L"Closed", LINE_INFO());
+                    }
+
+                    std::ifstream input(output, std::ios::binary);
+                    const std::string actual((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+                    Assert::AreEqual(expected.size(), actual.size(), L"File size", LINE_INFO());
+                    Assert::IsTrue(expected == actual, L"File content", LINE_INFO());
+                }
+            }
+
+            std::filesystem::remove(output);
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,159 @@
+﻿// <copyright file="capture_codec_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(capture_codec_test) {
+
+    public:
+
+        TEST_METHOD(test_bit_stream) {
+            std::vector<std::uint8_t> data;
+
+            {
+                detail::bit_writer writer(data);
+                writer.write(0x1, 1);
+                writer.write(0x5, 3);
+                writer.write(0xDEADBEEFCAFEBABE, 64);
+                writer.write(0x7F, 7);
+                writer.write(0, 0);
+            }
+
+            Assert::AreEqual(std::size_t(10), data.size(), L"75 bits in 10 bytes", LINE_INFO());
+
+            detail::bit_reader reader(data.data(), data.size());
+            Assert::IsTrue(reader.read_bit(), L"Single bit", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(0x5), reader.read(3), L"Three bits", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(0xDEADBEEFCAFEBABE), reader.read(64), L"Straddling 64 bits", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(0x7F), reader.read(7), L"Seven bits", LINE_INFO());
+
+            Assert::ExpectException<std::runtime_error>([&reader](void) {
+                reader.read(8);
+            }, L"Read past end", LINE_INFO());
+        }
+
+        TEST_METHOD(test_regular) {
+            std::vector<detail::capture_sample> expected;
+            for (std::size_t i = 0; i < 1000; ++i) {
+                expected.push_back(detail::capture_sample {
+                    133485408000000000LL + static_cast<std::int64_t>(i) * 10000,
+                    12.0f,
+                    1.5f + 0.25f * (i % 4),
+                    18.0f + 3.0f * (i % 4),
+                    static_cast<std::uint32_t>(i / 100)
+                });
+            }
+
+            std::vector<std::uint8_t> encoded;
+            detail::encode_capture_block(encoded, expected.data(), expected.size());
+            Assert::IsTrue(encoded.size() < expected.size() * sizeof(detail::capture_sample) / 4, L"Regular data compress well", LINE_INFO());
+
+            std::vector<detail::capture_sample> actual(expected.size());
+            detail::decode_capture_block(actual.data(), actual.size(), encoded.data(), encoded.size());
+            assert_equal(expected, actual);
+        }
+
+        TEST_METHOD(test_irregular) {
+            std::vector<detail::capture_sample> expected;
+            std::int64_t t = 0;
+            const std::int64_t steps[] = { 1, 63, -64, 64, 2047, -2048, 524287, -524288, 2147483647LL, -2147483647LL, 4294967296LL, (std::numeric_limits<std::int64_t>::max)() / 4, (std::numeric_limits<std::int64_t>::min)() / 4, 0, 0 };
+
+            std::uint32_t m = 0;
+            float v = 0.0f;
+            for (auto s : steps) {
+                t += s;
+                v = (v == 0.0f) ? 1.0e-30f : -v * 3.7f;
+                expected.push_back(detail::capture_sample {
+                    t,
+                    v,
+                    measurement_data::invalid_value,
+                    std::numeric_limits<float>::quiet_NaN(),
+                    (m++ % 3 == 0) ? capture_writer::no_marker : m
+                });
+            }
+
+            std::vector<std::uint8_t> encoded;
+            detail::encode_capture_block(encoded, expected.data(), expected.size());
+
+            std::vector<detail::capture_sample> actual(expected.size());
+            detail::decode_capture_block(actual.data(), actual.size(), encoded.data(), encoded.size());
+            assert_equal(expected, actual);
+        }
+
+        TEST_METHOD(test_single) {
+            const detail::capture_sample expected {
+                -1, -0.0f, std::numeric_limits<float>::infinity(), 42.0f, 0
+            };
+
+            std::vector<std::uint8_t> encoded;
+            detail::encode_capture_block(encoded, &expected, 1);
+
+            detail::capture_sample actual;
+            detail::decode_capture_block(&actual, 1, encoded.data(), encoded.size());
+            assert_equal({ expected }, { actual });
+        }
+
+        TEST_METHOD(test_corrupt) {
+            std::vector<detail::capture_sample> samples(16);
+            std::vector<std::uint8_t> encoded;
+            detail::encode_capture_block(encoded, samples.data(), samples.size());
+
+            Assert::ExpectException<std::runtime_error>([&](void) {
+                detail::decode_capture_block(samples.data(), samples.size(), encoded.data(), encoded.size() / 2);
+            }, L"Truncated block", LINE_INFO());
+        }
+
+        TEST_METHOD(test_compression) {
+            const std::uint8_t data[] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+            std::vector<std::uint8_t> compressed;
+            std::vector<std::uint8_t> decompressed;
+
+            detail::compress_capture_block(compressed, data, sizeof(data), capture_compression::none);
+            detail::decompress_capture_block(decompressed, sizeof(data), compressed.data(), compressed.size(), capture_compression::none);
+            Assert::IsTrue(std::equal(decompressed.begin(), decompressed.end(), data, data + sizeof(data)), L"Uncompressed round trip", LINE_INFO());
+
+#if defined(POWER_OVERWHELMING_WITH_ZSTD)
+            detail::compress_capture_block(compressed, data, sizeof(data), capture_compression::zstd);
+            detail::decompress_capture_block(decompressed, sizeof(data), compressed.data(), compressed.size(), capture_compression::zstd);
+            Assert::IsTrue(std::equal(decompressed.begin(), decompressed.end(), data, data + sizeof(data)), L"Zstandard round trip", LINE_INFO());
+            Assert::ExpectException<std::runtime_error>([&](void) {
+                detail::decompress_capture_block(decompressed, UINT32_MAX, compressed.data(), compressed.size(), capture_compression::zstd);
+            }, L"Size not matching the frame", LINE_INFO());
+#else /* defined(POWER_OVERWHELMING_WITH_ZSTD) */
+            Assert::ExpectException<std::logic_error>([&](void) {
+                detail::compress_capture_block(compressed, data, sizeof(data), capture_compression::zstd);
+            }, L"Zstandard not available", LINE_INFO());
+#endif /* defined(POWER_OVERWHELMING_WITH_ZSTD) */
+        }
+
+    private:
+
+        static void assert_equal(const std::vector<detail::capture_sample>& expected, const std::vector<detail::capture_sample>& actual) {
+            Assert::AreEqual(expected.size(), actual.size(), L"Number of samples", LINE_INFO());
+
+            for (std::size_t i = 0; i < expected.size(); ++i) {
+                auto& e = expected[i];
+                auto& a = actual[i];
+                Assert::AreEqual(e.timestamp, a.timestamp, L"Timestamp", LINE_INFO());
+                Assert::AreEqual(0, ::memcmp(&e.voltage, &a.voltage, sizeof(e.voltage)), L"Voltage bits", LINE_INFO());
+                Assert::AreEqual(0, ::memcmp(&e.current, &a.current, sizeof(e.current)), L"Current bits", LINE_INFO());
+                Assert::AreEqual(0, ::memcmp(&e.power, &a.power, sizeof(e.power)), L"Power bits", LINE_INFO());
+                Assert::AreEqual(e.marker, a.marker, L"Marker", LINE_INFO());
+            }
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
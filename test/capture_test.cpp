@@ -0,0 +1,430 @@
+﻿// <copyright file="capture_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(capture_test) {
+
+    public:
+
+        TEST_METHOD(test_aggregate) {
+            const std::filesystem::path path(L"capture_aggregate.pwrowg");
+            const auto t = [](const std::size_t i) {
+                return timestamp(static_cast<timestamp::value_type>(i) * timestamp::tick_rate / 10);
+            };
+
+            {
+                // Change the marker in the middle of a block and add a peak
+                // in the second phase.
+                capture_writer writer(path.wstring().c_str(), capture_compression::none, 10);
+                writer.sensor(L"one");
+                writer.sensor(L"two");
+                writer.marker(L"first");
+                writer.marker(L"second");
+                for (std::size_t i = 0; i < 100; ++i) {
+                    writer.write(0, measurement_data(t(i), (i == 60) ? 20.0f : 10.0f), (i < 45) ? 0 : 1);
+                    writer.write(1, measurement_data(t(i), 2.0f), capture_writer::no_marker);
+                }
+            }
+
+            capture_reader reader(path.wstring().c_str());
+            Assert::AreEqual(std::size_t(3), reader.aggregate(nullptr, 0), L"Number of aggregates", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([&reader](void) {
+                reader.aggregate(nullptr, 1);
+            }, L"Null buffer", LINE_INFO());
+
+            std::vector<capture_aggregate> aggregates(reader.sensors() * (reader.markers() + 1));
+            aggregates.resize(reader.aggregate(aggregates.data(), aggregates.size()));
+            Assert::AreEqual(std::size_t(3), aggregates.size(), L"Number of aggregates", LINE_INFO());
+
+            Assert::AreEqual(capture_writer::id_type(0), aggregates[0].sensor, L"Sensor", LINE_INFO());
+            Assert::AreEqual(capture_writer::id_type(0), aggregates[0].marker, L"Marker", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(45), aggregates[0].samples, L"Samples", LINE_INFO());
+            Assert::AreEqual(t(0).value(), aggregates[0].begin.value(), L"Begin", LINE_INFO());
+            Assert::AreEqual(t(44).value(), aggregates[0].end.value(), L"End", LINE_INFO());
+            Assert::AreEqual(4.5, aggregates[0].duration, 0.0001, L"Duration includes interval to next marker", LINE_INFO());
+            Assert::AreEqual(45.0, aggregates[0].energy, 0.0001, L"Energy", LINE_INFO());
+            Assert::AreEqual(10.0f, aggregates[0].max_power, L"Max", LINE_INFO());
+            Assert::AreEqual(10.0, aggregates[0].mean_power, 0.0001, L"Mean", LINE_INFO());
+
+            Assert::AreEqual(capture_writer::id_type(0), aggregates[1].sensor, L"Sensor", LINE_INFO());
+            Assert::AreEqual(capture_writer::id_type(1), aggregates[1].marker, L"Marker", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(55), aggregates[1].samples, L"Samples", LINE_INFO());
+            Assert::AreEqual(5.4, aggregates[1].duration, 0.0001, L"Duration", LINE_INFO());
+            Assert::AreEqual(55.0, aggregates[1].energy, 0.0001, L"Energy", LINE_INFO());
+            Assert::AreEqual(20.0f, aggregates[1].max_power, L"Max", LINE_INFO());
+            Assert::AreEqual(560.0 / 55.0, aggregates[1].mean_power, 0.0001, L"Mean", LINE_INFO());
+
+            Assert::AreEqual(capture_writer::id_type(1), aggregates[2].sensor, L"Sensor", LINE_INFO());
+            Assert::AreEqual(capture_writer::no_marker, aggregates[2].marker, L"No marker", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(100), aggregates[2].samples, L"Samples", LINE_INFO());
+            Assert::AreEqual(19.8, aggregates[2].energy, 0.0001, L"Energy", LINE_INFO());
+
+            {
+                auto filter = capture_filter().begin(t(20)).end(t(80)).sensor(0);
+                aggregates.resize(reader.aggregate(aggregates.data(), aggregates.size(), filter));
+                Assert::AreEqual(std::size_t(2), aggregates.size(), L"Number of filtered aggregates", LINE_INFO());
+                Assert::AreEqual(std::uint64_t(25), aggregates[0].samples, L"Samples in range", LINE_INFO());
+                Assert::AreEqual(25.0, aggregates[0].energy, 0.0001, L"Energy in range", LINE_INFO());
+                Assert::AreEqual(std::uint64_t(35), aggregates[1].samples, L"Samples in range", LINE_INFO());
+                Assert::AreEqual(35.0, aggregates[1].energy, 0.0001, L"Energy in range", LINE_INFO());
+                Assert::AreEqual(t(79).value(), aggregates[1].end.value(), L"End of range", LINE_INFO());
+            }
+
+            {
+                auto filter = capture_filter().begin(t(200));
+                Assert::AreEqual(std::size_t(0), reader.aggregate(nullptr, 0, filter), L"Nothing in range", LINE_INFO());
+            }
+
+            reader = capture_reader();
+            std::filesystem::remove(path);
+        }
+
+        TEST_METHOD(test_corrupt_count) {
+            const std::filesystem::path path(L"capture_corrupt_count.pwrowg");
+
+            const auto write = [&path](void) {
+                capture_writer writer(path.wstring().c_str(), capture_compression::none, 10);
+                const auto sensor = writer.sensor(L"sensor");
+                for (std::size_t i = 0; i < 10; ++i) {
+                    writer.write(sensor, measurement_data(timestamp(static_cast<timestamp::value_type>(i)), 1.0f));
+                }
+            };
+
+            // Locate the only block and its entry in the index via the trailer.
+            std::uint64_t entry = 0;
+            std::uint64_t block = 0;
+            write();
+            {
+                const auto size = std::filesystem::file_size(path);
+                std::ifstream stream(path, std::ios::binary);
+                detail::capture_trailer trailer;
+                stream.seekg(size - sizeof(trailer));
+                stream.read(reinterpret_cast<char *>(&trailer), sizeof(trailer));
+                entry = trailer.index + sizeof(detail::capture_chunk_header) + sizeof(detail::capture_index_header) + sizeof(std::uint64_t);
+                stream.seekg(entry);
+                stream.read(reinterpret_cast<char *>(&block), sizeof(block));
+            }
+
+            const auto patch = [&path](const std::uint64_t offset, const std::uint32_t count) {
+                std::fstream stream(path, std::ios::binary | std::ios::in | std::ios::out);
+                stream.seekp(offset);
+                stream.write(reinterpret_cast<const char *>(&count), sizeof(count));
+            };
+            const auto entry_count = entry + offsetof(detail::capture_index_entry, count);
+            const auto header_count = block + sizeof(detail::capture_chunk_header) + offsetof(detail::capture_block_header, count);
+
+            patch(entry_count, UINT32_MAX);
+            Assert::ExpectException<std::runtime_error>([&path](void) {
+                capture_reader reader(path.wstring().c_str());
+            }, L"Huge block in index", LINE_INFO());
+
+            // Stay below the maximum block size, but exceed what the encoded
+            // data can hold.
+            write();
+            patch(entry_count, 1000);
+            patch(header_count, 1000);
+            {
+                capture_reader reader(path.wstring().c_str());
+                Assert::ExpectException<std::runtime_error>([&reader](void) {
+                    reader.read(L"sensor");
+                }, L"Block too small for its samples", LINE_INFO());
+            }
+
+            // Without the index, the block headers are checked while walking
+            // the file.
+            write();
+            patch(header_count, UINT32_MAX);
+            std::filesystem::resize_file(path, entry);
+            Assert::ExpectException<std::runtime_error>([&path](void) {
+                capture_reader reader(path.wstring().c_str());
+            }, L"Huge block in unclosed capture", LINE_INFO());
+
+            std::filesystem::remove(path);
+        }
+
+        TEST_METHOD(test_disposed) {
+            capture_writer writer;
+            Assert::IsFalse(bool(writer), L"Default writer is disposed", LINE_INFO());
+            Assert::ExpectException<std::runtime_error>([&writer](void) {
+                writer.sensor(L"sensor");
+            }, L"Use disposed writer", LINE_INFO());
+            writer.close();
+
+            capture_reader reader;
+            Assert::IsFalse(bool(reader), L"Default reader is disposed", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), reader.sensors(), L"No sensors", LINE_INFO());
+            Assert::ExpectException<std::runtime_error>([&reader](void) {
+                reader.read(L"sensor");
+            }, L"Use disposed reader", LINE_INFO());
+            Assert::ExpectException<std::runtime_error>([&reader](void) {
+                reader.aggregate(nullptr, 0);
+            }, L"Aggregate disposed reader", LINE_INFO());
+        }
+
+        TEST_METHOD(test_filter) {
+            capture_filter filter;
+            Assert::IsTrue(filter.matches(timestamp(0)), L"All times selected", LINE_INFO());
+            Assert::IsTrue(filter.matches(timestamp((std::numeric_limits<timestamp::value_type>::min)())), L"All times selected", LINE_INFO());
+            Assert::IsTrue(filter.matches(capture_filter::id_type(42)), L"All sensors selected", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), filter.sensors(), L"No explicit sensors", LINE_INFO());
+
+            filter.begin(timestamp(10)).end(timestamp(20)).sensor(3).sensor(1).sensor(3);
+            Assert::AreEqual(std::size_t(2), filter.sensors(), L"Sensors added once", LINE_INFO());
+            Assert::IsFalse(filter.matches(timestamp(9)), L"Before begin", LINE_INFO());
+            Assert::IsTrue(filter.matches(timestamp(10)), L"Begin inclusive", LINE_INFO());
+            Assert::IsFalse(filter.matches(timestamp(20)), L"End exclusive", LINE_INFO());
+            Assert::IsTrue(filter.matches(capture_filter::id_type(1)), L"Sensor 1", LINE_INFO());
+            Assert::IsFalse(filter.matches(capture_filter::id_type(2)), L"Sensor 2", LINE_INFO());
+            Assert::IsTrue(filter.matches(capture_filter::id_type(3)), L"Sensor 3", LINE_INFO());
+            Assert::IsTrue(filter.overlaps(timestamp(0), timestamp(10)), L"Overlap at begin", LINE_INFO());
+            Assert::IsFalse(filter.overlaps(timestamp(0), timestamp(9)), L"Before range", LINE_INFO());
+            Assert::IsFalse(filter.overlaps(timestamp(20), timestamp(30)), L"After range", LINE_INFO());
+
+            auto copy = filter;
+            Assert::AreEqual(std::size_t(2), copy.sensors(), L"Sensors copied", LINE_INFO());
+            Assert::IsTrue(copy.matches(capture_filter::id_type(3)), L"Sensor 3 copied", LINE_INFO());
+
+            auto moved = std::move(filter);
+            Assert::AreEqual(std::size_t(2), moved.sensors(), L"Sensors moved", LINE_INFO());
+            Assert::AreEqual(timestamp::value_type(10), moved.begin().value(), L"Begin moved", LINE_INFO());
+        }
+
+        TEST_METHOD(test_filtered_read) {
+            const std::filesystem::path path(L"capture_filtered_read.pwrowg");
+
+            {
+                capture_writer writer(path.wstring().c_str(), capture_compression::none, 16);
+                for (std::size_t i = 0; i < 1000; ++i) {
+                    const auto t = timestamp(static_cast<timestamp::value_type>(10 * i));
+                    writer.write(measurement(L"first", t, 1.0f, static_cast<float>(i)));
+                    writer.write(measurement(L"second", t, 2.0f, static_cast<float>(i)));
+                }
+            }
+
+            capture_reader reader(path.wstring().c_str());
+            auto filter = capture_filter().begin(timestamp(1005)).end(timestamp(5000));
+
+            auto series = reader.read(1, filter);
+            Assert::AreEqual(std::size_t(399), series.size(), L"Samples in range", LINE_INFO());
+            Assert::AreEqual(timestamp::value_type(1010), series.front().timestamp().value(), L"First sample", LINE_INFO());
+            Assert::AreEqual(timestamp::value_type(4990), series.back().timestamp().value(), L"Last sample", LINE_INFO());
+            for (std::size_t i = 1; i < series.size(); ++i) {
+                Assert::IsTrue(series.sample(i - 1).timestamp() < series.sample(i).timestamp(), L"Order preserved", LINE_INFO());
+            }
+
+            filter.sensor(0);
+            Assert::AreEqual(std::size_t(0), reader.read(1, filter).size(), L"Sensor not selected", LINE_INFO());
+            Assert::AreEqual(std::size_t(399), reader.read(0, filter).size(), L"Sensor selected", LINE_INFO());
+            Assert::AreEqual(std::size_t(1000), reader.read(capture_reader::id_type(0)).size(), L"Unfiltered read", LINE_INFO());
+
+            reader = capture_reader();
+            std::filesystem::remove(path);
+        }
+
+        TEST_METHOD(test_invalid) {
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                capture_writer writer(nullptr);
+            }, L"Null path", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                capture_writer writer(L"capture_invalid.pwrowg", capture_compression::none, 0);
+            }, L"Empty block", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                capture_reader reader(nullptr);
+            }, L"Null path", LINE_INFO());
+
+            {
+                std::ofstream stream("capture_invalid.pwrowg");
+                stream << "This is not a capture file." << std::endl;
+            }
+
+            Assert::ExpectException<std::runtime_error>([](void) {
+                capture_reader reader(L"capture_invalid.pwrowg");
+            }, L"Wrong magic number", LINE_INFO());
+
+            {
+                capture_writer writer(L"capture_invalid.pwrowg");
+                writer.write(measurement(L"sensor", timestamp(1), 5.0f, 1.0f));
+            }
+
+            {
+                // Let the otherwise valid trailer point into the file header.
+                const auto size = std::filesystem::file_size(L"capture_invalid.pwrowg");
+                const std::uint64_t index = 1;
+                std::fstream stream("capture_invalid.pwrowg", std::ios::binary | std::ios::in | std::ios::out);
+                stream.seekp(size - sizeof(detail::capture_trailer));
+                stream.write(reinterpret_cast<const char *>(&index), sizeof(index));
+            }
+
+            Assert::ExpectException<std::runtime_error>([](void) {
+                capture_reader reader(L"capture_invalid.pwrowg");
+            }, L"Corrupt index", LINE_INFO());
+            std::filesystem::remove(L"capture_invalid.pwrowg");
+        }
+
+        TEST_METHOD(test_round_trip) {
+            const std::filesystem::path path(L"capture_round_trip.pwrowg");
+
+            {
+                capture_writer writer(path.wstring().c_str(), capture_compression::none, 100);
+                Assert::AreEqual(capture_writer::id_type(0), writer.sensor(L"first"), L"First sensor", LINE_INFO());
+                Assert::AreEqual(capture_writer::id_type(1), writer.sensor(L"second"), L"Second sensor", LINE_INFO());
+                Assert::AreEqual(capture_writer::id_type(0), writer.sensor(L"first"), L"Sensor declared once", LINE_INFO());
+                Assert::AreEqual(capture_writer::id_type(0), writer.marker(L"marker"), L"First marker", LINE_INFO());
+
+                for (std::size_t i = 0; i < 1000; ++i) {
+                    const auto t = timestamp(static_cast<timestamp::value_type>(1000 + 10 * i));
+                    writer.write(0, measurement_data(t, 12.0f, static_cast<float>(i)), 0);
+                    writer.write(1, measurement_data(t, static_cast<float>(i) / 2.0f), capture_writer::no_marker);
+                }
+
+                // Write an incomplete block at the end.
+                writer.write(measurement(L"third", timestamp(42), 1.0f, 2.0f, 3.0f));
+
+                writer.close();
+                writer.close();
+            }
+
+            capture_reader reader(path.wstring().c_str());
+            Assert::IsTrue(reader.complete(), L"Complete capture", LINE_INFO());
+            Assert::AreEqual(std::size_t(3), reader.sensors(), L"Sensors", LINE_INFO());
+            Assert::AreEqual(std::size_t(1), reader.markers(), L"Markers", LINE_INFO());
+            Assert::AreEqual(std::size_t(21), reader.blocks(), L"Blocks", LINE_INFO());
+            Assert::AreEqual(L"second", reader.sensor(1), L"Sensor name", LINE_INFO());
+            Assert::AreEqual(L"marker", reader.marker(0), L"Marker name", LINE_INFO());
+
+            {
+                auto series = reader.read(L"first");
+                Assert::AreEqual(L"first", series.sensor(), L"Series name", LINE_INFO());
+                Assert::AreEqual(std::size_t(1000), series.size(), L"Series size", LINE_INFO());
+                for (std::size_t i = 0; i < series.size(); ++i) {
+                    auto& s = series.sample(i);
+                    Assert::AreEqual(timestamp::value_type(1000 + 10 * i), s.timestamp().value(), L"Timestamp", LINE_INFO());
+                    Assert::AreEqual(12.0f, s.voltage(), L"Voltage", LINE_INFO());
+                    Assert::AreEqual(static_cast<float>(i), s.current(), L"Current", LINE_INFO());
+                    Assert::AreEqual(12.0f * i, s.power(), L"Power", LINE_INFO());
+                }
+            }
+
+            {
+                auto series = reader.read(1);
+                Assert::AreEqual(std::size_t(1000), series.size(), L"Series size", LINE_INFO());
+                for (std::size_t i = 0; i < series.size(); ++i) {
+                    auto& s = series.sample(i);
+                    Assert::IsTrue(bool(s), L"Valid sample", LINE_INFO());
+                    Assert::AreEqual(measurement_data::invalid_value, s.voltage(), L"Voltage", LINE_INFO());
+                    Assert::AreEqual(static_cast<float>(i) / 2.0f, s.power(), L"Power", LINE_INFO());
+                }
+            }
+
+            {
+                auto series = reader.read(L"third");
+                Assert::AreEqual(std::size_t(1), series.size(), L"Series size", LINE_INFO());
+                Assert::AreEqual(3.0f, series.front().power(), L"Power", LINE_INFO());
+            }
+
+            Assert::ExpectException<std::invalid_argument>([&reader](void) {
+                reader.read(L"fourth");
+            }, L"Unknown sensor", LINE_INFO());
+            Assert::ExpectException<std::out_of_range>([&reader](void) {
+                reader.read(3);
+            }, L"Unknown sensor", LINE_INFO());
+
+            reader = capture_reader();
+            std::filesystem::remove(path);
+        }
+
+        TEST_METHOD(test_series) {
+            const std::filesystem::path path(L"capture_series.pwrowg");
+            measurement_data_series expected(L"series");
+            auto data = measurement_data_series::resize(expected, 5000);
+            for (std::size_t i = 0; i < expected.size(); ++i) {
+                // Add some jitter to the timestamps.
+                data[i] = measurement_data(timestamp(static_cast<timestamp::value_type>(100 * i + (i * 7) % 13)), 3.3f, 0.001f * (i % 50));
+            }
+
+            {
+                capture_writer writer(path.wstring().c_str());
+                writer.write(expected);
+            }
+
+            capture_reader reader(path.wstring().c_str());
+            auto actual = reader.read(L"series");
+            Assert::AreEqual(expected.size(), actual.size(), L"Series size", LINE_INFO());
+            for (std::size_t i = 0; i < expected.size(); ++i) {
+                Assert::AreEqual(expected.sample(i).timestamp().value(), actual.sample(i).timestamp().value(), L"Timestamp", LINE_INFO());
+                Assert::AreEqual(expected.sample(i).current(), actual.sample(i).current(), L"Current", LINE_INFO());
+                Assert::AreEqual(expected.sample(i).power(), actual.sample(i).power(), L"Power", LINE_INFO());
+            }
+
+            const auto csv = expected.size() * 40;
+            Assert::IsTrue(std::filesystem::file_size(path) < csv / 4, L"Capture much smaller than CSV", LINE_INFO());
+
+            std::filesystem::remove(path);
+        }
+
+        TEST_METHOD(test_truncated) {
+            const std::filesystem::path path(L"capture_truncated.pwrowg");
+
+            {
+                capture_writer writer(path.wstring().c_str(), capture_compression::none, 10);
+                const auto sensor = writer.sensor(L"sensor");
+                for (std::size_t i = 0; i < 25; ++i) {
+                    writer.write(sensor, measurement_data(timestamp(static_cast<timestamp::value_type>(i)), 1.0f));
+                }
+            }
+
+            // Cut off the trailer, the index of the sensor and the three blocks
+            // and the last byte of the last block.
+            const auto size = std::filesystem::file_size(path);
+            const auto index = sizeof(detail::capture_chunk_header) + sizeof(detail::capture_index_header) + sizeof(std::uint64_t) + 3 * sizeof(detail::capture_index_entry) + sizeof(detail::capture_trailer);
+            std::filesystem::resize_file(path, size - index - 1);
+
+            capture_reader reader(path.wstring().c_str());
+            Assert::IsFalse(reader.complete(), L"Incomplete capture", LINE_INFO());
+            Assert::AreEqual(std::size_t(2), reader.blocks(), L"Complete blocks", LINE_INFO());
+
+            auto series = reader.read(L"sensor");
+            Assert::AreEqual(std::size_t(20), series.size(), L"Samples in complete blocks", LINE_INFO());
+            Assert::AreEqual(timestamp::value_type(19), series.back().timestamp().value(), L"Last sample", LINE_INFO());
+
+            reader = capture_reader();
+            std::filesystem::remove(path);
+        }
+
+#if defined(POWER_OVERWHELMING_WITH_ZSTD)
+        TEST_METHOD(test_zstd) {
+            const std::filesystem::path path(L"capture_zstd.pwrowg");
+
+            {
+                capture_writer writer(path.wstring().c_str(), capture_compression::zstd);
+                for (std::size_t i = 0; i < 10000; ++i) {
+                    writer.write(measurement(L"sensor", timestamp(static_cast<timestamp::value_type>(i)), 5.0f, 1.0f));
+                }
+            }
+
+            capture_reader reader(path.wstring().c_str());
+            auto series = reader.read(L"sensor");
+            Assert::AreEqual(std::size_t(10000), series.size(), L"Series size", LINE_INFO());
+            Assert::AreEqual(5.0f, series.back().power(), L"Power", LINE_INFO());
+
+            reader = capture_reader();
+            std::filesystem::remove(path);
+        }
+#endif /* defined(POWER_OVERWHELMING_WITH_ZSTD) */
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
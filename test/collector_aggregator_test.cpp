@@ -0,0 +1,182 @@
+﻿// <copyright file="collector_aggregator_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+#if defined(_WIN32)
+#include <WinSock2.h>
+#else /* defined(_WIN32) */
+#include <sys/socket.h>
+#endif /* defined(_WIN32) */
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(collector_aggregator_test) {
+
+    public:
+
+        TEST_METHOD(test_disposed) {
+            collector_aggregator aggregator;
+            Assert::IsFalse(bool(aggregator), L"Default instance is disposed", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), aggregator.agents(), L"No agents", LINE_INFO());
+            aggregator.stop();
+        }
+
+        TEST_METHOD(test_merge) {
+            const std::uint16_t port = 48791;
+            const std::filesystem::path output(L"aggregator_merge.csv");
+            auto aggregator = collector_aggregator::create(collector_settings()
+                .output_path(output.wstring().c_str())
+                .aggregator(nullptr, port)
+                .sampling_interval(1000), AF_INET);
+            Assert::IsTrue(bool(aggregator), L"New aggregator is valid", LINE_INFO());
+
+            const timestamp t0(100 * timestamp::tick_rate);
+            const auto t = [&t0](const int i) { return t0 + std::chrono::milliseconds(i); };
+
+            {
+                detail::collector_agent agent1(L"node1", L"127.0.0.1", port);
+                detail::collector_agent agent2(L"node2", L"127.0.0.1", port);
+
+                for (int i = 0; (i < 100) && (aggregator.agents() < 2); ++i) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                }
+                Assert::AreEqual(std::size_t(2), aggregator.agents(), L"Both agents connected", LINE_INFO());
+
+                agent1.markers({ L"frame" });
+                agent1.add(measurement(L"gpu", t(1), 1.0f, 1.0f, 1.0f), 0);
+                agent1.add(measurement(L"gpu", t(3), 3.0f, 1.0f, 3.0f), 0);
+                agent1.send();
+
+                agent2.add(measurement(L"gpu", t(4), 4.0f, 1.0f, 4.0f), collector::no_marker);
+                agent2.add(measurement(L"gpu", t(2), 2.0f, 1.0f, 2.0f), collector::no_marker);
+                agent2.send();
+            }
+
+            for (int i = 0; (i < 100) && (aggregator.agents() > 0); ++i) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            Assert::AreEqual(std::size_t(0), aggregator.agents(), L"Agents disconnected", LINE_INFO());
+            aggregator.stop();
+
+            std::vector<std::string> lines;
+            {
+                std::ifstream s(output);
+                std::string line;
+                while (std::getline(s, line)) {
+                    lines.push_back(line);
+                }
+            }
+
+            Assert::AreEqual(std::size_t(5), lines.size(), L"Header and four samples", LINE_INFO());
+            Assert::IsTrue(lines[0].find("marker") != std::string::npos, L"Header", LINE_INFO());
+            Assert::IsTrue(lines[1].find("node1/gpu") != std::string::npos, L"Sample 1", LINE_INFO());
+            Assert::IsTrue(lines[1].find("frame") != std::string::npos, L"Sample 1 marker", LINE_INFO());
+            Assert::IsTrue(lines[2].find("node2/gpu") != std::string::npos, L"Sample 2", LINE_INFO());
+            Assert::IsTrue(lines[2].find("frame") == std::string::npos, L"Sample 2 has no marker", LINE_INFO());
+            Assert::IsTrue(lines[3].find("node1/gpu") != std::string::npos, L"Sample 3", LINE_INFO());
+            Assert::IsTrue(lines[4].find("node2/gpu") != std::string::npos, L"Sample 4", LINE_INFO());
+
+            std::filesystem::remove(output);
+        }
+
+        TEST_METHOD(test_silent_agent) {
+            const std::uint16_t port = 48793;
+            const std::filesystem::path output(L"aggregator_silent.csv");
+            auto aggregator = collector_aggregator::create(collector_settings()
+                .output_path(output.wstring().c_str())
+                .aggregator(nullptr, port)
+                .sampling_interval(1000), AF_INET);
+
+            const timestamp t0(100 * timestamp::tick_rate);
+
+            {
+                // The first agent never sends anything, eg because it waits
+                // for a marker.
+                detail::collector_agent silent(L"silent", L"127.0.0.1", port);
+                detail::collector_agent agent(L"node", L"127.0.0.1", port);
+
+                for (int i = 0; (i < 100) && (aggregator.agents() < 2); ++i) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                }
+                Assert::AreEqual(std::size_t(2), aggregator.agents(), L"Both agents connected", LINE_INFO());
+
+                agent.add(measurement(L"gpu", t0, 1.0f, 1.0f, 1.0f), collector::no_marker);
+                agent.send();
+
+                // Keep the second agent alive, such that it limits the
+                // watermark to its latest batch.
+                std::uintmax_t size = 0;
+                for (int i = 1; (i < 500) && (size == 0); ++i) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                    agent.add(measurement(L"gpu", t0 + std::chrono::milliseconds(i), 1.0f, 1.0f, 1.0f), collector::no_marker);
+                    agent.send();
+
+                    std::error_code ec;
+                    size = std::filesystem::file_size(output, ec);
+                    if (ec) {
+                        size = 0;
+                    }
+                }
+
+                Assert::AreEqual(std::size_t(2), aggregator.agents(), L"Both agents still connected", LINE_INFO());
+                Assert::IsTrue(size > 0, L"Silent agent does not hold back output forever", LINE_INFO());
+            }
+
+            aggregator.stop();
+            std::filesystem::remove(output);
+        }
+
+        TEST_METHOD(test_collector_agent) {
+            const std::uint16_t port = 48792;
+            const std::filesystem::path output(L"aggregator_collector.csv");
+            const auto settings = collector_settings()
+                .output_path(output.wstring().c_str())
+                .aggregator(L"127.0.0.1", port);
+            Assert::AreEqual(L"127.0.0.1", settings.aggregator(), L"Aggregator set", LINE_INFO());
+            Assert::AreEqual(port, settings.aggregator_port(), L"Aggregator port set", LINE_INFO());
+
+            {
+                auto collector = collector::from_sensor_lists(settings, std::vector<nvml_sensor>());
+                Assert::ExpectException<std::system_error>([&collector](void) {
+                    collector.start();
+                }, L"Start without aggregator fails", LINE_INFO());
+            }
+
+            auto aggregator = collector_aggregator::create(settings, AF_INET);
+
+            {
+                auto collector = collector::from_sensor_lists(settings, std::vector<nvml_sensor>());
+                collector.start();
+
+                for (int i = 0; (i < 100) && (aggregator.agents() < 1); ++i) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                }
+                Assert::AreEqual(std::size_t(1), aggregator.agents(), L"Collector connected", LINE_INFO());
+
+                collector.marker(L"frame");
+                collector.stop();
+            }
+
+            for (int i = 0; (i < 100) && (aggregator.agents() > 0); ++i) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            Assert::AreEqual(std::size_t(0), aggregator.agents(), L"Collector disconnected", LINE_INFO());
+
+            aggregator.stop();
+            std::filesystem::remove(output);
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -30,6 +30,104 @@ namespace test {
             auto copy = settings;
             Assert::AreEqual(settings.output_path(), copy.output_path(), L"Copy output_path", LINE_INFO());
             Assert::AreEqual(settings.sampling_interval(), copy.sampling_interval(), L"Copy sampling_interval", LINE_INFO());
+
+            Assert::IsNull(settings.discovery_cache(), L"Discovery cache disabled by default", LINE_INFO());
+            settings.discovery_cache(L"cache.json");
+            Assert::AreEqual(L"cache.json", settings.discovery_cache(), L"Set discovery_cache", LINE_INFO());
+            copy = settings;
+            Assert::AreEqual(settings.discovery_cache(), copy.discovery_cache(), L"Copy discovery_cache", LINE_INFO());
+            settings.discovery_cache(nullptr);
+            Assert::IsNull(settings.discovery_cache(), L"Reset discovery_cache", LINE_INFO());
+
+            Assert::IsNull(settings.aggregator(), L"Aggregator disabled by default", LINE_INFO());
+            Assert::AreEqual(collector_settings::default_aggregator_port, settings.aggregator_port(), L"Default for aggregator_port", LINE_INFO());
+            Assert::IsNull(settings.time_synchroniser(), L"No time synchroniser by default", LINE_INFO());
+            settings.aggregator(L"localhost", 42);
+            copy = settings;
+            Assert::AreEqual(L"localhost", copy.aggregator(), L"Copy aggregator", LINE_INFO());
+            Assert::AreEqual(std::uint16_t(42), copy.aggregator_port(), L"Copy aggregator_port", LINE_INFO());
+            settings.aggregator(nullptr);
+            Assert::IsNull(settings.aggregator(), L"Reset aggregator", LINE_INFO());
+
+            Assert::IsTrue(settings.output_format() == output_format::csv, L"CSV by default", LINE_INFO());
+            Assert::IsTrue(settings.capture_compression() == capture_compression::none, L"No compression by default", LINE_INFO());
+            settings.output_format(output_format::capture).capture_compression(capture_compression::zstd);
+            copy = settings;
+            Assert::IsTrue(copy.output_format() == output_format::capture, L"Copy output_format", LINE_INFO());
+            Assert::IsTrue(copy.capture_compression() == capture_compression::zstd, L"Copy capture_compression", LINE_INFO());
+        }
+
+        TEST_METHOD(test_capture_output) {
+            const std::filesystem::path path(L"collector_output.pwrowg");
+            collector_settings settings;
+            settings.output_path(path.wstring().c_str())
+                .output_format(output_format::capture)
+                .sampling_interval(1000);
+
+            {
+                auto collector = collector::from_sensor_lists(settings, std::vector<nvml_sensor>());
+                collector.register_marker(L"first");
+                collector.marker(L"second");
+                collector.start();
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                collector.stop();
+            }
+
+            capture_reader reader(path.wstring().c_str());
+            Assert::IsTrue(reader.complete(), L"Capture has been closed", LINE_INFO());
+            Assert::AreEqual(std::size_t(2), reader.markers(), L"Markers", LINE_INFO());
+            Assert::AreEqual(L"first", reader.marker(0), L"Marker IDs match", LINE_INFO());
+            Assert::AreEqual(L"second", reader.marker(1), L"Marker IDs match", LINE_INFO());
+
+            reader = capture_reader();
+            std::filesystem::remove(path);
+        }
+
+        TEST_METHOD(test_late_batch) {
+            using namespace std::chrono;
+            const std::filesystem::path path(L"collector_late_batch.csv");
+            const auto origin = timestamp::now();
+
+            {
+                detail::collector_impl impl;
+                impl.apply(collector_settings()
+                    .output_path(path.wstring().c_str())
+                    .sampling_interval(1000));
+                impl.start();
+
+                impl.marker(L"early", origin);
+                impl.marker(L"late", origin + seconds(2));
+
+                // The first sensor delivers a sample after the second marker,
+                // which the I/O thread writes before the batch from the other
+                // sensor arrives with an older timestamp.
+                detail::collector_impl::on_measurement(measurement(L"fast", origin + seconds(3), 1.0f), &impl);
+                std::this_thread::sleep_for(milliseconds(100));
+                detail::collector_impl::on_measurement(measurement(L"batched", origin + seconds(1), 1.0f), &impl);
+                std::this_thread::sleep_for(milliseconds(100));
+
+                impl.stop();
+            }
+
+            std::string fast, batched;
+            {
+                std::ifstream s(path);
+                std::string line;
+                while (std::getline(s, line)) {
+                    if (line.find("batched") != std::string::npos) {
+                        batched = line;
+                    } else if (line.find("fast") != std::string::npos) {
+                        fast = line;
+                    }
+                }
+            }
+
+            Assert::IsTrue(fast.size() > 4, L"Fast sample written", LINE_INFO());
+            Assert::AreEqual(std::string("late"), fast.substr(fast.size() - 4), L"Fast sample has latest marker", LINE_INFO());
+            Assert::IsTrue(batched.size() > 5, L"Late sample written", LINE_INFO());
+            Assert::AreEqual(std::string("early"), batched.substr(batched.size() - 5), L"Late sample has marker at its time", LINE_INFO());
+
+            std::filesystem::remove(path);
         }
 
         TEST_METHOD(test_for_all) {
@@ -37,6 +135,77 @@ namespace test {
             Assert::IsTrue(bool(collector), L"New collector is valid.", LINE_INFO());
         }
 
+        TEST_METHOD(test_for_all_cached) {
+            const std::filesystem::path cache(L"discovery_cache.json");
+            const auto settings = collector_settings()
+                .output_path(L"test.csv")
+                .discovery_cache(cache.wstring().c_str());
+            std::filesystem::remove(cache);
+
+            std::size_t expected = 0;
+            {
+                auto collector = collector::for_all(settings);
+                Assert::IsTrue(bool(collector), L"New collector is valid.", LINE_INFO());
+                expected = collector.size();
+            }
+
+            {
+                std::ifstream s(cache);
+                Assert::IsTrue(s.good(), L"Cache has been written", LINE_INFO());
+            }
+
+            {
+                auto collector = collector::for_all(settings);
+                Assert::IsTrue(bool(collector), L"Cached collector is valid.", LINE_INFO());
+                Assert::AreEqual(expected, collector.size(), L"Cache restores same sensors", LINE_INFO());
+            }
+
+            {
+                std::ofstream s(cache, std::ios::trunc);
+                s << "garbage";
+            }
+
+            {
+                auto collector = collector::for_all(settings);
+                Assert::IsTrue(bool(collector), L"Corrupt cache is rebuilt.", LINE_INFO());
+                Assert::AreEqual(expected, collector.size(), L"Rediscovered same sensors", LINE_INFO());
+            }
+
+            std::filesystem::remove(cache);
+        }
+
+        TEST_METHOD(test_register_marker) {
+            auto collector = collector::from_sensor_lists(collector_settings(), std::vector<nvml_sensor>());
+            Assert::IsTrue(bool(collector), L"New collector is valid.", LINE_INFO());
+
+            Assert::ExpectException<std::invalid_argument>([&collector](void) {
+                collector.register_marker(nullptr);
+            }, L"Null marker cannot be registered", LINE_INFO());
+
+            const auto frame = collector.register_marker(L"frame");
+            const auto idle = collector.register_marker(L"idle");
+            Assert::AreNotEqual(frame, idle, L"Different markers have different IDs", LINE_INFO());
+            Assert::AreEqual(frame, collector.register_marker(L"frame"), L"Markers are interned", LINE_INFO());
+            Assert::AreNotEqual(collector::no_marker, frame, L"Valid marker ID", LINE_INFO());
+
+            for (std::size_t i = 0; i < 4096; ++i) {
+                // Exceed the capacity of the lock-free queue without the I/O
+                // thread running to make sure that the slow path works, too.
+                collector.marker((i % 2) ? frame : idle);
+            }
+            collector.marker(collector::no_marker);
+            collector.marker(frame, timestamp::now());
+            collector.marker(L"string");
+
+            auto moved = std::move(collector);
+            Assert::ExpectException<std::runtime_error>([&collector, frame](void) {
+                collector.marker(frame);
+            }, L"Marker on disposed collector", LINE_INFO());
+            Assert::ExpectException<std::runtime_error>([&collector](void) {
+                collector.register_marker(L"frame");
+            }, L"Register on disposed collector", LINE_INFO());
+        }
+
         TEST_METHOD(test_from_defaults) {
             auto collector = collector::from_defaults();
             Assert::IsTrue(bool(collector), L"New collector is valid.", LINE_INFO());
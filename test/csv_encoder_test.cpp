@@ -0,0 +1,112 @@
+﻿// <copyright file="csv_encoder_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(csv_encoder_test) {
+
+    public:
+
+        TEST_METHOD(test_values) {
+            char buffer[csv_encoder::max_value_size];
+
+            {
+                auto cnt = csv_encoder::encode(buffer, std::int64_t(0));
+                Assert::AreEqual(std::string("0"), std::string(buffer, cnt), L"Zero", LINE_INFO());
+            }
+
+            {
+                auto cnt = csv_encoder::encode(buffer, (std::numeric_limits<std::int64_t>::min)());
+                Assert::AreEqual(std::string("-9223372036854775808"), std::string(buffer, cnt), L"Minimum timestamp", LINE_INFO());
+            }
+
+            {
+                auto cnt = csv_encoder::encode(buffer, 0.1f);
+                Assert::AreEqual(std::string("0.1"), std::string(buffer, cnt), L"Shortest representation", LINE_INFO());
+            }
+
+            {
+                auto cnt = csv_encoder::encode(buffer, measurement_data::invalid_value);
+                Assert::AreEqual(measurement_data::invalid_value, std::strtof(std::string(buffer, cnt).c_str(), nullptr), L"Invalid value", LINE_INFO());
+            }
+
+            const float values[] = {
+                1.0f / 3.0f,
+                -(std::numeric_limits<float>::max)(),
+                (std::numeric_limits<float>::min)(),
+                std::numeric_limits<float>::denorm_min(),
+                1234567.0f,
+                230.04999f
+            };
+            for (auto v : values) {
+                auto cnt = csv_encoder::encode(buffer, v);
+                Assert::IsTrue(cnt <= csv_encoder::max_value_size, L"Size in bounds", LINE_INFO());
+                Assert::AreEqual(v, std::strtof(std::string(buffer, cnt).c_str(), nullptr), L"Round trip", LINE_INFO());
+            }
+        }
+
+        TEST_METHOD(test_measurement_data) {
+            char buffer[csv_encoder::max_data_size];
+            const measurement_data data(timestamp(9999), 1.5f, 2.0f);
+
+            {
+                csv_encoder encoder;
+                auto cnt = encoder.encode(buffer, data);
+                Assert::AreEqual(std::string("9999\t1\t1.5\t2\t3"), std::string(buffer, cnt), L"Default delimiter", LINE_INFO());
+            }
+
+            {
+                csv_encoder encoder(';');
+                auto cnt = encoder.encode(buffer, data);
+                Assert::AreEqual(std::string("9999;1;1.5;2;3"), std::string(buffer, cnt), L"Custom delimiter", LINE_INFO());
+            }
+        }
+
+        TEST_METHOD(test_measurement) {
+            const measurement dummy(L"dummy", timestamp(9999), 1, 2, 3);
+
+            {
+                csv_encoder encoder;
+                Assert::AreEqual(std::size_t(18), encoder.encode(nullptr, 0, dummy), L"Measure size", LINE_INFO());
+
+                char buffer[4];
+                Assert::AreEqual(std::size_t(18), encoder.encode(buffer, sizeof(buffer), dummy), L"Buffer too small", LINE_INFO());
+            }
+
+            {
+                std::vector<char> buffer(64);
+                csv_encoder encoder(';', '\'');
+                auto cnt = encoder.encode(buffer.data(), buffer.size(), dummy);
+                Assert::AreEqual(std::string("'dummy';9999;1;1;2;3"), std::string(buffer.data(), cnt), L"Quoted line", LINE_INFO());
+            }
+
+            {
+                std::stringstream stream;
+                stream << setcsvdelimiter(',') << setcsvquote('"');
+
+                std::vector<char> buffer(64);
+                csv_encoder encoder(stream);
+                Assert::AreEqual(',', encoder.delimiter(), L"Delimiter from stream", LINE_INFO());
+                Assert::AreEqual('"', encoder.quote(), L"Quote from stream", LINE_INFO());
+
+                auto cnt = encoder.encode(buffer.data(), buffer.size(), dummy);
+                stream << dummy;
+                Assert::AreEqual(stream.str(), std::string(buffer.data(), cnt), L"Same as stream", LINE_INFO());
+            }
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -7,6 +7,10 @@
 #include "pch.h"
 #include "CppUnitTest.h"
 
+#if !defined(_WIN32)
+#include <poll.h>
+#endif /* !defined(_WIN32) */
+
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
 
@@ -61,6 +65,70 @@ namespace test {
 
         }
 
+        TEST_METHOD(test_wait_any) {
+            event_type events[] = { create_event(false, false), create_event(true, false) };
+            const auto cnt = sizeof(events) / sizeof(*events);
+
+            Assert::AreEqual(cnt, wait_events(events, cnt, false, 1), L"No event is signalled", LINE_INFO());
+
+            set_event(events[1]);
+            Assert::AreEqual(std::size_t(1), wait_events(events, cnt, false, 1), L"Manual reset event signalled", LINE_INFO());
+            Assert::AreEqual(std::size_t(1), wait_events(events, cnt, false, 1), L"Manual reset event stays signalled", LINE_INFO());
+            reset_event(events[1]);
+
+            std::thread t([&events] {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                set_event(events[0]);
+            });
+            t.detach();
+
+            Assert::AreEqual(std::size_t(0), wait_events(events, cnt, false), L"Auto reset event signalled", LINE_INFO());
+            Assert::AreEqual(cnt, wait_events(events, cnt, false, 1), L"Auto reset event was reset", LINE_INFO());
+
+            for (auto& e : events) {
+                destroy_event(e);
+                Assert::IsNull(e, L"Event was destroyed", LINE_INFO());
+            }
+        }
+
+        TEST_METHOD(test_wait_all) {
+            event_type events[] = { create_event(false, false), create_event(false, true) };
+            const auto cnt = sizeof(events) / sizeof(*events);
+
+            Assert::AreEqual(cnt, wait_events(events, cnt, true, 1), L"Not all events are signalled", LINE_INFO());
+            Assert::IsTrue(wait_event(events[1], 1), L"Partial wait did not reset event", LINE_INFO());
+
+            set_event(events[1]);
+            std::thread t([&events] {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                set_event(events[0]);
+            });
+            t.detach();
+
+            Assert::AreEqual(std::size_t(0), wait_events(events, cnt, true), L"All events signalled", LINE_INFO());
+            Assert::IsFalse(wait_event(events[0], 1), L"First event was reset", LINE_INFO());
+            Assert::IsFalse(wait_event(events[1], 1), L"Second event was reset", LINE_INFO());
+
+            for (auto& e : events) {
+                destroy_event(e);
+            }
+        }
+
+#if !defined(_WIN32)
+        TEST_METHOD(test_native_handle) {
+            auto event = create_event(false, false);
+            pollfd fd { get_event_native_handle(event), POLLIN, 0 };
+
+            Assert::AreEqual(0, ::poll(&fd, 1, 0), L"Descriptor not readable", LINE_INFO());
+            set_event(event);
+            Assert::AreEqual(1, ::poll(&fd, 1, 0), L"Descriptor readable", LINE_INFO());
+            Assert::IsTrue(wait_event(event, 0), L"Event signalled", LINE_INFO());
+            Assert::AreEqual(0, ::poll(&fd, 1, 0), L"Descriptor not readable after reset", LINE_INFO());
+
+            destroy_event(event);
+        }
+#endif /* !defined(_WIN32) */
+
     };
 } /* namespace test */
 } /* namespace power_overwhelming */
@@ -0,0 +1,786 @@
+﻿// <copyright file="fake_brickd.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "fake_brickd.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+
+#if defined(_WIN32)
+#include <WS2tcpip.h>
+#else /* defined(_WIN32) */
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif /* defined(_WIN32) */
+
+
+#if defined(_WIN32)
+#define poll WSAPoll
+#define last_socket_error() ::WSAGetLastError()
+#define MSG_NOSIGNAL (0)
+#else /* defined(_WIN32) */
+#define INVALID_SOCKET (-1)
+#define last_socket_error() errno
+#endif /* defined(_WIN32) */
+
+
+namespace {
+
+    typedef std::vector<std::uint8_t> packet_type;
+
+    /// <summary>
+    /// The function IDs of the protocol that the emulator understands.
+    /// </summary>
+    enum : std::uint8_t {
+        function_get_current = 1,
+        function_set_current_callback_configuration = 2,
+        function_get_current_callback_configuration = 3,
+        callback_current = 4,
+        function_get_voltage = 5,
+        function_set_voltage_callback_configuration = 6,
+        function_get_voltage_callback_configuration = 7,
+        callback_voltage = 8,
+        function_get_power = 9,
+        function_set_power_callback_configuration = 10,
+        function_get_power_callback_configuration = 11,
+        callback_power = 12,
+        function_set_configuration = 13,
+        function_get_configuration = 14,
+        function_set_calibration = 15,
+        function_get_calibration = 16,
+        function_get_power_time = 17,
+        function_set_power_time_callback_configuration = 18,
+        function_get_power_time_callback_configuration = 19,
+        callback_power_time = 20,
+        function_get_time = 21,
+        function_disconnect_probe = 128,
+        function_get_spitfp_error_count = 234,
+        function_reset = 243,
+        callback_enumerate = 253,
+        function_enumerate = 254,
+        function_get_identity = 255
+    };
+
+    /// <summary>
+    /// The indices of the periodic callbacks in the schedules of a bricklet.
+    /// </summary>
+    enum : std::size_t {
+        schedule_current = 0,
+        schedule_voltage = 1,
+        schedule_power = 2,
+        schedule_power_time = 3
+    };
+
+    /// <summary>
+    /// The device identifier of the voltage/current bricklet 2.0.
+    /// </summary>
+    constexpr std::uint16_t device_identifier = 2105;
+
+    /// <summary>
+    /// The error code for unsupported functions.
+    /// </summary>
+    constexpr std::uint8_t error_not_supported = 2;
+
+    /// <summary>
+    /// The size of the packet header in bytes.
+    /// </summary>
+    constexpr std::size_t header_size = 8;
+
+    /// <summary>
+    /// The constant current reported by the bricklets in milliamperes.
+    /// </summary>
+    constexpr std::int32_t nominal_current = 1000;
+
+    /// <summary>
+    /// The constant voltage reported by the bricklets in millivolts.
+    /// </summary>
+    constexpr std::int32_t nominal_voltage = 12000;
+
+    /// <summary>
+    /// Appends <paramref name="value" /> in little endian byte order.
+    /// </summary>
+    template<class TValue>
+    void append(packet_type& packet, const TValue value) {
+        typedef typename std::make_unsigned<TValue>::type unsigned_type;
+        auto v = static_cast<unsigned_type>(value);
+        for (std::size_t i = 0; i < sizeof(TValue); ++i) {
+            packet.push_back(static_cast<std::uint8_t>(v & 0xFF));
+            v >>= 8;
+        }
+    }
+
+    /// <summary>
+    /// Appends the bytes of a fixed-size, zero-padded string.
+    /// </summary>
+    void append(packet_type& packet, const std::string& str,
+            const std::size_t size) {
+        for (std::size_t i = 0; i < size; ++i) {
+            packet.push_back((i < str.size())
+                ? static_cast<std::uint8_t>(str[i])
+                : 0);
+        }
+    }
+
+    /// <summary>
+    /// Encodes a UID in the base58 format of Tinkerforge.
+    /// </summary>
+    std::string base58(std::uint32_t value) {
+        static const char alphabet[]
+            = "123456789abcdefghijkmnopqrstuvwxyzABCDEFGHJKLMNPQRSTUVWXYZ";
+        std::string retval;
+
+        do {
+            retval.insert(retval.begin(), alphabet[value % 58]);
+            value /= 58;
+        } while (value > 0);
+
+        return retval;
+    }
+
+    /// <summary>
+    /// Creates the header of a packet. The length is set by
+    /// <see cref="finish" />.
+    /// </summary>
+    packet_type make_packet(const std::uint32_t uid,
+            const std::uint8_t function_id,
+            const std::uint8_t sequence_number_and_options,
+            const std::uint8_t error_code = 0) {
+        packet_type retval;
+        retval.reserve(header_size + 64);
+        append(retval, uid);
+        append(retval, std::uint8_t(0));
+        append(retval, function_id);
+        append(retval, sequence_number_and_options);
+        append(retval, static_cast<std::uint8_t>(error_code << 6));
+        return retval;
+    }
+
+    /// <summary>
+    /// Fills in the length of the packet.
+    /// </summary>
+    inline packet_type& finish(packet_type& packet) {
+        packet[4] = static_cast<std::uint8_t>(packet.size());
+        return packet;
+    }
+
+    /// <summary>
+    /// Reads a little endian value from <paramref name="data" />.
+    /// </summary>
+    template<class TValue>
+    TValue read(const std::uint8_t *data) {
+        typedef typename std::make_unsigned<TValue>::type unsigned_type;
+        unsigned_type retval = 0;
+        for (std::size_t i = sizeof(TValue); i > 0; --i) {
+            retval = static_cast<unsigned_type>((retval << 8) | data[i - 1]);
+        }
+        return static_cast<TValue>(retval);
+    }
+}
+
+
+/*
+ * ...::test::fake_brickd::configuration::configuration
+ */
+visus::power_overwhelming::test::fake_brickd::configuration::configuration(
+        void)
+    : bricklets(0), firmware_version{ { 2, 0, 0 } }, jitter(0), loss(0.0),
+        period(0), seed(0) { }
+
+
+/*
+ * visus::power_overwhelming::test::fake_brickd::fake_brickd
+ */
+visus::power_overwhelming::test::fake_brickd::fake_brickd(void)
+    : fake_brickd(configuration()) { }
+
+
+/*
+ * visus::power_overwhelming::test::fake_brickd::fake_brickd
+ */
+visus::power_overwhelming::test::fake_brickd::fake_brickd(
+        const configuration& config)
+        : _accepted(0), _config(config), _listener(INVALID_SOCKET), _lost(0),
+        _port(0), _random(config.seed), _running(true), _sent(0),
+        _start(timestamp::now()) {
+    if ((config.loss < 0.0) || (config.loss > 1.0)) {
+        throw std::invalid_argument("The loss rate must be within [0, 1].");
+    }
+
+    this->_bricklets.reserve(config.bricklets);
+    for (std::size_t i = 0; i < config.bricklets; ++i) {
+        std::unique_ptr<bricklet> b(new bricklet());
+        // Averaging of 64 samples, 1.1 ms conversion time for U and I.
+        b->configuration = { 3, 4, 4 };
+        b->emitted.reset(new std::atomic<timestamp::value_type>[history]);
+        for (std::uint32_t j = 0; j < history; ++j) {
+            b->emitted[j] = 0;
+        }
+        b->schedules.fill(schedule());
+        b->uid = static_cast<std::uint32_t>(100000 + i);
+        b->uid_string = base58(b->uid);
+        this->_bricklets.push_back(std::move(b));
+    }
+
+#if defined(_WIN32)
+    WSADATA wsa_data;
+    {
+        auto status = ::WSAStartup(MAKEWORD(2, 2), &wsa_data);
+        if (status != 0) {
+            throw std::system_error(status, std::system_category());
+        }
+    }
+#endif /* defined(_WIN32) */
+
+    this->_listener = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (this->_listener == INVALID_SOCKET) {
+        throw std::system_error(last_socket_error(), std::system_category());
+    }
+
+    sockaddr_in address;
+    ::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+
+    auto a = reinterpret_cast<sockaddr *>(&address);
+    socklen_t length = sizeof(address);
+    if ((::bind(this->_listener, a, sizeof(address)) != 0)
+            || (::listen(this->_listener, SOMAXCONN) != 0)
+            || (::getsockname(this->_listener, a, &length) != 0)) {
+        const auto error = last_socket_error();
+        fake_brickd::close(this->_listener);
+        throw std::system_error(error, std::system_category());
+    }
+
+    this->_port = ntohs(address.sin_port);
+    this->_thread = std::thread(&fake_brickd::serve, this);
+}
+
+
+/*
+ * visus::power_overwhelming::test::fake_brickd::~fake_brickd
+ */
+visus::power_overwhelming::test::fake_brickd::~fake_brickd(void) {
+    this->_running = false;
+    if (this->_thread.joinable()) {
+        this->_thread.join();
+    }
+
+    this->drop_all();
+    fake_brickd::close(this->_listener);
+
+#if defined(_WIN32)
+    ::WSACleanup();
+#endif /* defined(_WIN32) */
+}
+
+
+/*
+ * visus::power_overwhelming::test::fake_brickd::connections
+ */
+std::size_t visus::power_overwhelming::test::fake_brickd::connections(void) {
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    return this->_clients.size();
+}
+
+
+/*
+ * visus::power_overwhelming::test::fake_brickd::drop_all
+ */
+void visus::power_overwhelming::test::fake_brickd::drop_all(void) {
+    std::lock_guard<decltype(this->_lock)> l(this->_lock);
+    for (auto& c : this->_clients) {
+        fake_brickd::close(c.socket);
+    }
+    this->_clients.clear();
+}
+
+
+/*
+ * visus::power_overwhelming::test::fake_brickd::emitted
+ */
+visus::power_overwhelming::timestamp
+visus::power_overwhelming::test::fake_brickd::emitted(
+        const std::size_t bricklet, const std::uint32_t sequence) const {
+    const auto& b = this->_bricklets.at(bricklet);
+    return timestamp(b->emitted[sequence % history].load());
+}
+
+
+/*
+ * visus::power_overwhelming::test::fake_brickd::uid
+ */
+const std::string& visus::power_overwhelming::test::fake_brickd::uid(
+        const std::size_t bricklet) const {
+    return this->_bricklets.at(bricklet)->uid_string;
+}
+
+
+/*
+ * visus::power_overwhelming::test::fake_brickd::wait_accepted
+ */
+bool visus::power_overwhelming::test::fake_brickd::wait_accepted(
+        const std::size_t cnt, const std::chrono::milliseconds timeout) {
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (this->_accepted < cnt) {
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    return true;
+}
+
+
+/*
+ * visus::power_overwhelming::test::fake_brickd::close
+ */
+void visus::power_overwhelming::test::fake_brickd::close(
+        const socket_type socket) noexcept {
+    if (socket != INVALID_SOCKET) {
+#if defined(_WIN32)
+        ::closesocket(socket);
+#else /* defined(_WIN32) */
+        ::close(socket);
+#endif /* defined(_WIN32) */
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::test::fake_brickd::send
+ */
+void visus::power_overwhelming::test::fake_brickd::send(
+        const socket_type socket, const packet_type& packet) noexcept {
+    auto data = reinterpret_cast<const char *>(packet.data());
+    auto remaining = static_cast<int>(packet.size());
+
+    while (remaining > 0) {
+        auto cnt = ::send(socket, data, remaining, MSG_NOSIGNAL);
+        if (cnt <= 0) {
+            // The client is gone, which we will find out when polling it the
+            // next time.
+            return;
+        }
+
+        data += cnt;
+        remaining -= static_cast<int>(cnt);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::test::fake_brickd::configure
+ */
+void visus::power_overwhelming::test::fake_brickd::configure(
+        schedule& schedule,
+        const std::chrono::microseconds period,
+        const clock_type::time_point now) {
+    if ((period.count() > 0) && (this->_config.period.count() > 0)) {
+        schedule.period = this->_config.period;
+    } else {
+        schedule.period = period;
+    }
+
+    if (schedule.period.count() > 0) {
+        schedule.nominal = now + schedule.period;
+        this->reschedule(schedule);
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::test::fake_brickd::emit
+ */
+void visus::power_overwhelming::test::fake_brickd::emit(bricklet& bricklet,
+        const std::size_t callback, const clock_type::time_point now) {
+    static const std::array<std::uint8_t, 4> ids = {
+        callback_current,
+        callback_voltage,
+        callback_power,
+        callback_power_time
+    };
+
+    auto& s = bricklet.schedules[callback];
+    const auto sequence = s.sequence++ % history;
+
+    // Schedule the next callback. If we fell behind by more than a period,
+    // we do not try to catch up, but continue from now.
+    s.nominal += s.period;
+    if (s.nominal < now) {
+        s.nominal = now;
+    }
+    this->reschedule(s);
+
+    const auto is_power = (callback == schedule_power)
+        || (callback == schedule_power_time);
+    if (is_power) {
+        bricklet.emitted[sequence] = 0;
+    }
+
+    if ((this->_config.loss > 0.0)
+            && (std::bernoulli_distribution(this->_config.loss)(this->_random))) {
+        ++this->_lost;
+        return;
+    }
+
+    auto packet = make_packet(bricklet.uid, ids[callback], 0);
+    switch (callback) {
+        case schedule_current:
+            append(packet, nominal_current);
+            break;
+
+        case schedule_voltage:
+            append(packet, nominal_voltage);
+            break;
+
+        case schedule_power:
+            append(packet, static_cast<std::int32_t>(sequence));
+            break;
+
+        case schedule_power_time:
+            append(packet, static_cast<std::int32_t>(sequence));
+            append(packet, this->time());
+            break;
+    }
+
+    if (is_power) {
+        bricklet.emitted[sequence] = timestamp::now().value();
+    }
+
+    finish(packet);
+    this->_outbox.insert(this->_outbox.end(), packet.begin(), packet.end());
+    ++this->_sent;
+}
+
+
+/*
+ * visus::power_overwhelming::test::fake_brickd::process
+ */
+void visus::power_overwhelming::test::fake_brickd::process(client& client,
+        const std::uint8_t *request) {
+    const auto uid = read<std::uint32_t>(request);
+    const auto function_id = request[5];
+    const auto options = request[6];
+    const auto response_expected = ((options >> 3) & 0x01) != 0;
+    const auto payload = request + header_size;
+
+    if (function_id == function_disconnect_probe) {
+        return;
+    }
+
+    if (function_id == function_enumerate) {
+        for (auto& b : this->_bricklets) {
+            auto packet = make_packet(b->uid, callback_enumerate, 0);
+            append(packet, b->uid_string, 8);
+            append(packet, "1", 8);
+            append(packet, 'a');
+            append(packet, std::uint8_t(2));
+            append(packet, std::uint8_t(0));
+            append(packet, std::uint8_t(0));
+            for (auto v : this->_config.firmware_version) {
+                append(packet, v);
+            }
+            append(packet, device_identifier);
+            append(packet, std::uint8_t(0));    // Available.
+            fake_brickd::send(client.socket, finish(packet));
+        }
+        return;
+    }
+
+    auto it = std::find_if(this->_bricklets.begin(), this->_bricklets.end(),
+        [uid](const std::unique_ptr<bricklet>& b) { return (b->uid == uid); });
+    if (it == this->_bricklets.end()) {
+        // Like brickd, we silently ignore requests to unknown devices.
+        return;
+    }
+
+    auto& b = **it;
+    const auto now = clock_type::now();
+    auto response = make_packet(uid, function_id, options);
+    auto respond = response_expected;
+
+    switch (function_id) {
+        case function_get_current:
+            append(response, nominal_current);
+            respond = true;
+            break;
+
+        case function_get_voltage:
+            append(response, nominal_voltage);
+            respond = true;
+            break;
+
+        case function_get_power:
+            append(response, static_cast<std::int32_t>(
+                b.schedules[schedule_power].sequence % history));
+            respond = true;
+            break;
+
+        case function_get_power_time:
+            append(response, static_cast<std::int32_t>(
+                b.schedules[schedule_power_time].sequence % history));
+            append(response, this->time());
+            respond = true;
+            break;
+
+        case function_set_current_callback_configuration:
+        case function_set_voltage_callback_configuration:
+        case function_set_power_callback_configuration: {
+            const auto period = read<std::uint32_t>(payload);
+            const auto callback = (function_id - 2) / 4;
+            b.schedules[callback].requested = period;
+            this->configure(b.schedules[callback],
+                std::chrono::milliseconds(period), now);
+            } break;
+
+        case function_get_current_callback_configuration:
+        case function_get_voltage_callback_configuration:
+        case function_get_power_callback_configuration: {
+            const auto callback = (function_id - 3) / 4;
+            append(response, b.schedules[callback].requested);
+            append(response, std::uint8_t(0));
+            append(response, 'x');
+            append(response, std::int32_t(0));
+            append(response, std::int32_t(0));
+            respond = true;
+            } break;
+
+        case function_set_power_time_callback_configuration: {
+            // We do not know which period the firmware uses, so we use the
+            // fastest one the protocol could express.
+            const auto enable = (payload[0] != 0);
+            auto& s = b.schedules[schedule_power_time];
+            s.requested = enable ? 1 : 0;
+            this->configure(s, std::chrono::milliseconds(s.requested), now);
+            } break;
+
+        case function_get_power_time_callback_configuration:
+            append(response, static_cast<std::uint8_t>(
+                b.schedules[schedule_power_time].requested));
+            respond = true;
+            break;
+
+        case function_set_configuration:
+            std::copy(payload, payload + b.configuration.size(),
+                b.configuration.begin());
+            break;
+
+        case function_get_configuration:
+            for (auto v : b.configuration) {
+                append(response, v);
+            }
+            respond = true;
+            break;
+
+        case function_set_calibration:
+            break;
+
+        case function_get_calibration:
+            for (std::size_t i = 0; i < 4; ++i) {
+                append(response, std::uint16_t(1));
+            }
+            respond = true;
+            break;
+
+        case function_get_time:
+            append(response, this->time());
+            respond = true;
+            break;
+
+        case function_get_spitfp_error_count:
+            for (std::size_t i = 0; i < 4; ++i) {
+                append(response, std::uint32_t(0));
+            }
+            respond = true;
+            break;
+
+        case function_reset:
+            b.configuration = { 3, 4, 4 };
+            for (auto& s : b.schedules) {
+                s.requested = 0;
+                this->configure(s, std::chrono::microseconds(0), now);
+            }
+            break;
+
+        case function_get_identity:
+            append(response, b.uid_string, 8);
+            append(response, "1", 8);
+            append(response, 'a');
+            append(response, std::uint8_t(2));
+            append(response, std::uint8_t(0));
+            append(response, std::uint8_t(0));
+            for (auto v : this->_config.firmware_version) {
+                append(response, v);
+            }
+            append(response, device_identifier);
+            respond = true;
+            break;
+
+        default:
+            response = make_packet(uid, function_id, options,
+                error_not_supported);
+            break;
+    }
+
+    if (respond) {
+        fake_brickd::send(client.socket, finish(response));
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::test::fake_brickd::reschedule
+ */
+void visus::power_overwhelming::test::fake_brickd::reschedule(
+        schedule& schedule) {
+    schedule.due = schedule.nominal;
+
+    const auto jitter = this->_config.jitter.count();
+    if (jitter > 0) {
+        std::uniform_int_distribution<std::int64_t> dist(-jitter, jitter);
+        schedule.due += std::chrono::microseconds(dist(this->_random));
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::test::fake_brickd::serve
+ */
+void visus::power_overwhelming::test::fake_brickd::serve(void) {
+    std::uint8_t buffer[1024];
+    std::vector<pollfd> fds;
+
+    while (this->_running) {
+        // Hold the lock for the whole iteration such that drop_all() cannot
+        // close a socket that we are using.
+        std::lock_guard<decltype(this->_lock)> l(this->_lock);
+
+        // Emit all callbacks that are due and find out how long we can wait
+        // for the next one.
+        auto now = clock_type::now();
+        auto next = now + std::chrono::milliseconds(10);
+        for (auto& b : this->_bricklets) {
+            for (std::size_t i = 0; i < b->schedules.size(); ++i) {
+                auto& s = b->schedules[i];
+                if (s.period.count() > 0) {
+                    if (s.due <= now) {
+                        this->emit(*b, i, now);
+                    }
+                    next = (std::min)(next, s.due);
+                }
+            }
+        }
+
+        // Like brickd, we send callbacks to all clients and leave it to the
+        // bindings to ignore the devices they do not know. Sending all
+        // callbacks that are due at once enables us to emulate a lot of
+        // bricklets without a system call for each of their callbacks.
+        if (!this->_outbox.empty()) {
+            for (auto& c : this->_clients) {
+                fake_brickd::send(c.socket, this->_outbox);
+            }
+            this->_outbox.clear();
+        }
+
+        // The timeout of poll is in milliseconds, so we spin if the next
+        // callback is due earlier.
+        const auto timeout = static_cast<int>(std::chrono::duration_cast<
+            std::chrono::milliseconds>(next - clock_type::now()).count());
+
+        fds.resize(this->_clients.size() + 1);
+        fds[0].fd = this->_listener;
+        fds[0].events = POLLIN;
+        fds[0].revents = 0;
+        for (std::size_t i = 0; i < this->_clients.size(); ++i) {
+            fds[i + 1].fd = this->_clients[i].socket;
+            fds[i + 1].events = POLLIN;
+            fds[i + 1].revents = 0;
+        }
+
+        if (::poll(fds.data(), static_cast<unsigned long>(fds.size()),
+                (std::max)(timeout, 0)) <= 0) {
+            continue;
+        }
+
+        // Process the requests from the clients and forget about the ones
+        // that have hung up. We go backwards such that we can erase in place.
+        for (std::size_t i = fds.size() - 1; i > 0; --i) {
+            if (fds[i].revents == 0) {
+                continue;
+            }
+
+            auto& c = this->_clients[i - 1];
+            auto cnt = ::recv(c.socket, reinterpret_cast<char *>(buffer),
+                sizeof(buffer), 0);
+            auto valid = (cnt > 0);
+
+            if (valid) {
+                c.pending.insert(c.pending.end(), buffer, buffer + cnt);
+
+                std::size_t offset = 0;
+                while (c.pending.size() - offset >= header_size) {
+                    const auto length = c.pending[offset + 4];
+                    if (length < header_size) {
+                        // This is not a valid packet, so we hang up.
+                        valid = false;
+                        break;
+                    }
+                    if (c.pending.size() - offset < length) {
+                        break;
+                    }
+
+                    this->process(c, c.pending.data() + offset);
+                    offset += length;
+                }
+
+                c.pending.erase(c.pending.begin(), c.pending.begin() + offset);
+            }
+
+            if (!valid) {
+                fake_brickd::close(c.socket);
+                this->_clients.erase(this->_clients.begin() + i - 1);
+            }
+        }
+
+        if ((fds[0].revents & POLLIN) != 0) {
+            auto socket = ::accept(this->_listener, nullptr, nullptr);
+            if (socket != INVALID_SOCKET) {
+                // Callbacks should arrive as soon as possible.
+                const int no_delay = 1;
+                ::setsockopt(socket, IPPROTO_TCP, TCP_NODELAY,
+                    reinterpret_cast<const char *>(&no_delay),
+                    sizeof(no_delay));
+
+                client c;
+                c.socket = socket;
+                this->_clients.push_back(std::move(c));
+                ++this->_accepted;
+            }
+        }
+    }
+}
+
+
+/*
+ * visus::power_overwhelming::test::fake_brickd::time
+ */
+std::uint32_t visus::power_overwhelming::test::fake_brickd::time(
+        void) const {
+    using namespace std::chrono;
+    const auto dt = duration_cast<milliseconds>(timestamp::now() - this->_start);
+    return static_cast<std::uint32_t>(dt.count());
+}
@@ -0,0 +1,297 @@
+﻿// <copyright file="fake_brickd.h" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#pragma once
+
+#if defined(_WIN32)
+#include <WinSock2.h>
+#include <Windows.h>
+#endif /* defined(_WIN32) */
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <power_overwhelming/timestamp.h>
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    /// <summary>
+    /// An in-process emulator of brickd with a configurable number of
+    /// voltage/current bricklets attached.
+    /// </summary>
+    /// <remarks>
+    /// <para>The emulator listens on an ephemeral port of the loopback
+    /// interface and speaks enough of the Tinkerforge TCP protocol for the
+    /// bindings to enumerate the bricklets, verify their identity, configure
+    /// them and receive voltage, current and power callbacks. It also answers
+    /// the <c>get_time</c> request and emits the <c>power_time</c> callback
+    /// of our customised firmware.</para>
+    /// <para>The bricklet clock is the host clock in milliseconds since the
+    /// emulator was started. The power reported in callbacks is a running
+    /// sequence number in milliwatts, which can be passed to
+    /// <see cref="emitted" /> in order to find out when the callback has been
+    /// sent.</para>
+    /// </remarks>
+    class fake_brickd final {
+
+    public:
+
+        /// <summary>
+        /// The configuration of the emulator.
+        /// </summary>
+        struct configuration {
+
+            /// <summary>
+            /// The number of voltage/current bricklets to emulate.
+            /// </summary>
+            std::size_t bricklets;
+
+            /// <summary>
+            /// The firmware version reported by the bricklets.
+            /// </summary>
+            std::array<std::uint8_t, 3> firmware_version;
+
+            /// <summary>
+            /// The maximum deviation of a callback from its nominal time.
+            /// </summary>
+            std::chrono::microseconds jitter;
+
+            /// <summary>
+            /// The probability in [0, 1] that a callback is not sent.
+            /// </summary>
+            /// <remarks>
+            /// Responses to requests are never lost, because the bindings
+            /// would wait for them until they time out.
+            /// </remarks>
+            double loss;
+
+            /// <summary>
+            /// If positive, overrides the callback period that the clients
+            /// request, which allows for emulating rates beyond the 1 kHz
+            /// that the protocol can express.
+            /// </summary>
+            std::chrono::microseconds period;
+
+            /// <summary>
+            /// The seed for the random jitter and loss.
+            /// </summary>
+            std::uint32_t seed;
+
+            /// <summary>
+            /// Initialises a configuration without bricklets.
+            /// </summary>
+            configuration(void);
+        };
+
+#if defined(_WIN32)
+        typedef SOCKET socket_type;
+#else /* defined(_WIN32) */
+        typedef int socket_type;
+#endif /* defined(_WIN32) */
+
+        /// <summary>
+        /// The number of emission times remembered per bricklet.
+        /// </summary>
+        static constexpr std::uint32_t history = 4096;
+
+        /// <summary>
+        /// Starts an emulator without bricklets on an ephemeral port of
+        /// 127.0.0.1.
+        /// </summary>
+        /// <exception cref="std::system_error">If the listening socket could
+        /// not be created.</exception>
+        fake_brickd(void);
+
+        /// <summary>
+        /// Starts an emulator with the given configuration on an ephemeral
+        /// port of 127.0.0.1.
+        /// </summary>
+        /// <param name="config">The configuration of the emulator.</param>
+        /// <exception cref="std::system_error">If the listening socket could
+        /// not be created.</exception>
+        explicit fake_brickd(const configuration& config);
+
+        fake_brickd(const fake_brickd&) = delete;
+
+        /// <summary>
+        /// Stops the server thread and closes all sockets.
+        /// </summary>
+        ~fake_brickd(void);
+
+        /// <summary>
+        /// Answer the total number of connections accepted so far.
+        /// </summary>
+        /// <returns>The number of accepted connections.</returns>
+        inline std::size_t accepted(void) const noexcept {
+            return this->_accepted.load();
+        }
+
+        /// <summary>
+        /// Answer the number of emulated bricklets.
+        /// </summary>
+        /// <returns>The number of bricklets.</returns>
+        inline std::size_t bricklets(void) const noexcept {
+            return this->_bricklets.size();
+        }
+
+        /// <summary>
+        /// Answer the number of currently open client connections.
+        /// </summary>
+        /// <returns>The number of open connections.</returns>
+        std::size_t connections(void);
+
+        /// <summary>
+        /// Closes all client connections, but keeps listening for new ones.
+        /// </summary>
+        void drop_all(void);
+
+        /// <summary>
+        /// Answer when the power callback with the given sequence number has
+        /// been sent by the given bricklet.
+        /// </summary>
+        /// <param name="bricklet">The zero-based index of the bricklet.</param>
+        /// <param name="sequence">The sequence number, which is the power in
+        /// milliwatts that has been reported in the callback.</param>
+        /// <returns>The time when the callback has been sent, or a zero
+        /// timestamp if it has been lost or has not been sent yet.</returns>
+        /// <exception cref="std::out_of_range">If
+        /// <paramref name="bricklet" /> is not a valid index.</exception>
+        power_overwhelming::timestamp emitted(const std::size_t bricklet,
+            const std::uint32_t sequence) const;
+
+        /// <summary>
+        /// Answer the number of callbacks that have been discarded to emulate
+        /// packet loss.
+        /// </summary>
+        /// <returns>The number of lost callbacks.</returns>
+        inline std::size_t lost(void) const noexcept {
+            return this->_lost.load();
+        }
+
+        /// <summary>
+        /// Answer the port the emulator is listening on.
+        /// </summary>
+        /// <returns>The port in host byte order.</returns>
+        inline std::uint16_t port(void) const noexcept {
+            return this->_port;
+        }
+
+        /// <summary>
+        /// Answer the number of callbacks that have been sent to all clients.
+        /// </summary>
+        /// <returns>The number of callbacks sent.</returns>
+        inline std::size_t sent(void) const noexcept {
+            return this->_sent.load();
+        }
+
+        /// <summary>
+        /// Answer the UID of the given bricklet.
+        /// </summary>
+        /// <param name="bricklet">The zero-based index of the bricklet.</param>
+        /// <returns>The base58-encoded UID of the bricklet.</returns>
+        /// <exception cref="std::out_of_range">If
+        /// <paramref name="bricklet" /> is not a valid index.</exception>
+        const std::string& uid(const std::size_t bricklet) const;
+
+        /// <summary>
+        /// Blocks until at least <paramref name="cnt" /> connections have been
+        /// accepted or the given timeout expired.
+        /// </summary>
+        /// <param name="cnt">The number of accepted connections to wait
+        /// for.</param>
+        /// <param name="timeout">The maximum time to wait.</param>
+        /// <returns><c>true</c> if the connections have been accepted,
+        /// <c>false</c> if the timeout expired.</returns>
+        bool wait_accepted(const std::size_t cnt,
+            const std::chrono::milliseconds timeout);
+
+        fake_brickd& operator =(const fake_brickd&) = delete;
+
+    private:
+
+        typedef std::chrono::steady_clock clock_type;
+        typedef std::vector<std::uint8_t> packet_type;
+
+        /// <summary>
+        /// The state of a periodic callback of a bricklet.
+        /// </summary>
+        struct schedule {
+            clock_type::time_point due;
+            clock_type::time_point nominal;
+            std::chrono::microseconds period;
+            std::uint32_t requested;
+            std::uint32_t sequence;
+        };
+
+        /// <summary>
+        /// The state of an emulated bricklet.
+        /// </summary>
+        struct bricklet {
+            std::array<std::uint8_t, 3> configuration;
+            std::unique_ptr<std::atomic<timestamp::value_type>[]> emitted;
+            std::array<schedule, 4> schedules;
+            std::uint32_t uid;
+            std::string uid_string;
+        };
+
+        /// <summary>
+        /// The state of a connected client.
+        /// </summary>
+        struct client {
+            packet_type pending;
+            socket_type socket;
+        };
+
+        static void close(const socket_type socket) noexcept;
+
+        static void send(const socket_type socket,
+            const packet_type& packet) noexcept;
+
+        void emit(bricklet& bricklet, const std::size_t callback,
+            const clock_type::time_point now);
+
+        void configure(schedule& schedule,
+            const std::chrono::microseconds period,
+            const clock_type::time_point now);
+
+        void process(client& client, const std::uint8_t *request);
+
+        void reschedule(schedule& schedule);
+
+        void serve(void);
+
+        std::uint32_t time(void) const;
+
+        std::atomic<std::size_t> _accepted;
+        std::vector<std::unique_ptr<bricklet>> _bricklets;
+        std::vector<client> _clients;
+        configuration _config;
+        socket_type _listener;
+        std::mutex _lock;
+        std::atomic<std::size_t> _lost;
+        std::uint16_t _port;
+        std::mt19937 _random;
+        packet_type _outbox;
+        std::atomic<bool> _running;
+        std::atomic<std::size_t> _sent;
+        power_overwhelming::timestamp _start;
+        std::thread _thread;
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,150 @@
+﻿// <copyright file="hmc8015_log_parser_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(hmc8015_log_parser_test) {
+
+    public:
+
+        TEST_METHOD(test_relative_time) {
+            const std::string log = "#Date: 2024-03-01\r\n"
+                "#Start Time: 12:00:00\r\n"
+                "#Interval: 100 ms\r\n"
+                "Time[s];U[V];I[A];P[W]\r\n"
+                "0.0;230,0;0,5;115,0\r\n"
+                "0.1;231.0;0.5;115.5\r\n";
+            detail::hmc8015_log_parser parser;
+            std::vector<measurement_data> samples;
+
+            auto cnt = parser.feed(log.data(), log.size(), samples);
+            Assert::AreEqual(std::size_t(2), cnt, L"Two samples parsed", LINE_INFO());
+            Assert::AreEqual(std::size_t(2), samples.size(), L"Two samples stored", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(2), parser.rows(), L"Two rows", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(log.size()), parser.offset(), L"All consumed", LINE_INFO());
+
+            const auto start = timestamp::create(2024, 3, 1, 12);
+            Assert::AreEqual(start.value(), parser.start().value(), L"Start time", LINE_INFO());
+            Assert::AreEqual(start.value(), samples[0].timestamp().value(), L"Timestamp #0", LINE_INFO());
+            Assert::AreEqual(start.value() + timestamp::tick_rate / 10, samples[1].timestamp().value(), L"Timestamp #1", LINE_INFO());
+            Assert::AreEqual(230.0f, samples[0].voltage(), L"Decimal comma", LINE_INFO());
+            Assert::AreEqual(0.5f, samples[0].current(), L"Current #0", LINE_INFO());
+            Assert::AreEqual(115.0f, samples[0].power(), L"Power #0", LINE_INFO());
+            Assert::AreEqual(231.0f, samples[1].voltage(), L"Voltage #1", LINE_INFO());
+        }
+
+        TEST_METHOD(test_chunks) {
+            const std::string log = "Date;01.03.2024\n"
+                "Start Time;23:59:59\n"
+                "Nr;Time;Urms[V];Irms[A];P[W]\n"
+                "1;23:59:59.500;230;1;230\n"
+                "2;00:00:00.500;230;2;460\n"
+                "3;00:00:01";
+            std::vector<measurement_data> expected;
+
+            {
+                detail::hmc8015_log_parser parser;
+                parser.feed(log.data(), log.size(), expected);
+                Assert::AreEqual(std::size_t(2), expected.size(), L"Incomplete line ignored", LINE_INFO());
+                Assert::AreEqual(std::uint64_t(log.rfind('\n') + 1), parser.offset(), L"Offset at begin of incomplete line", LINE_INFO());
+
+                const auto day = timestamp::create(2024, 3, 1);
+                Assert::AreEqual(day.value() + (23 * 3600 + 59 * 60 + 59) * timestamp::tick_rate + timestamp::tick_rate / 2, expected[0].timestamp().value(), L"Timestamp #0", LINE_INFO());
+                Assert::AreEqual(day.value() + 24 * 3600 * timestamp::tick_rate + timestamp::tick_rate / 2, expected[1].timestamp().value(), L"Midnight", LINE_INFO());
+                Assert::AreEqual(460.0f, expected[1].power(), L"Power #1", LINE_INFO());
+            }
+
+            for (std::size_t chunk = 1; chunk < 16; ++chunk) {
+                detail::hmc8015_log_parser parser;
+                std::vector<measurement_data> actual;
+
+                for (std::size_t i = 0; i < log.size(); i += chunk) {
+                    parser.feed(log.data() + i, (std::min)(chunk, log.size() - i), actual);
+                }
+
+                Assert::AreEqual(expected.size(), actual.size(), L"Same number of samples", LINE_INFO());
+                for (std::size_t i = 0; i < actual.size(); ++i) {
+                    Assert::AreEqual(expected[i].timestamp().value(), actual[i].timestamp().value(), L"Same timestamp", LINE_INFO());
+                    Assert::AreEqual(expected[i].current(), actual[i].current(), L"Same current", LINE_INFO());
+                }
+            }
+        }
+
+        TEST_METHOD(test_resume) {
+            std::string log = "Interval: 1 s\n"
+                "U,I\n"
+                "1,2\n"
+                "3,";
+            detail::hmc8015_log_parser parser;
+            std::vector<measurement_data> samples;
+
+            parser.feed(log.data(), log.size(), samples);
+            Assert::AreEqual(std::size_t(1), samples.size(), L"First harvest", LINE_INFO());
+
+            // Simulate the download of the grown file, which must start at the
+            // offset of the incomplete line.
+            log += "4\n5,6\n";
+            parser.restart();
+            const auto offset = static_cast<std::size_t>(parser.offset());
+            parser.feed(log.data() + offset, log.size() - offset, samples);
+            Assert::AreEqual(std::size_t(3), samples.size(), L"Second harvest", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(3), parser.rows(), L"Three rows", LINE_INFO());
+            Assert::AreEqual(3.0f, samples[1].voltage(), L"Completed line", LINE_INFO());
+            Assert::AreEqual(4.0f, samples[1].current(), L"Completed line", LINE_INFO());
+            Assert::AreEqual(12.0f, samples[1].power(), L"Derived power", LINE_INFO());
+            Assert::AreEqual(2 * timestamp::tick_rate, samples[2].timestamp().value(), L"Time from interval", LINE_INFO());
+        }
+
+        TEST_METHOD(test_invalid_rows) {
+            const std::string log = "U;I;P\n"
+                "---;---;---\n"
+                "# Comment\n"
+                "1;1;1\n";
+            detail::hmc8015_log_parser parser;
+            std::vector<measurement_data> samples;
+
+            parser.feed(log.data(), log.size(), samples);
+            Assert::AreEqual(std::size_t(1), samples.size(), L"Invalid row skipped", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(2), parser.rows(), L"Invalid row counted", LINE_INFO());
+        }
+
+        TEST_METHOD(test_line_too_long) {
+            const std::string log(detail::hmc8015_log_parser::max_line + 1, 'x');
+            detail::hmc8015_log_parser parser;
+            std::vector<measurement_data> samples;
+
+            Assert::ExpectException<std::runtime_error>([&](void) {
+                parser.feed(log.data(), log.size(), samples);
+            }, L"Line too long", LINE_INFO());
+        }
+
+        TEST_METHOD(test_cursor) {
+            hmc8015_log_cursor cursor;
+            Assert::IsTrue(bool(cursor), L"Cursor valid", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(0), cursor.offset(), L"Initial offset", LINE_INFO());
+            Assert::AreEqual(std::uint64_t(0), cursor.rows(), L"Initial rows", LINE_INFO());
+            Assert::AreEqual(timestamp::value_type(0), cursor.clock_offset(), L"Initial clock offset", LINE_INFO());
+
+            hmc8015_log_cursor moved(std::move(cursor));
+            Assert::IsFalse(bool(cursor), L"Cursor disposed", LINE_INFO());
+            Assert::IsTrue(bool(moved), L"Cursor moved", LINE_INFO());
+            Assert::ExpectException<std::runtime_error>([&cursor](void) {
+                cursor.offset();
+            }, L"Disposed cursor", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
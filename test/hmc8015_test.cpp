@@ -47,6 +47,73 @@ namespace test {
                 to_string((hmc8015_function)UINT_MAX);
             }, L"Illegal function", LINE_INFO());
         }
+
+        TEST_METHOD(test_sample) {
+            {
+                hmc8015_sample sample;
+                Assert::AreEqual(std::size_t(0), sample.size(), L"Empty sample", LINE_INFO());
+                Assert::IsFalse(sample.contains(hmc8015_function::active_power), L"Empty sample has no power", LINE_INFO());
+                Assert::AreEqual(measurement_data::invalid_value, sample.value(hmc8015_function::active_power), L"Missing power is invalid", LINE_INFO());
+                Assert::ExpectException<std::range_error>([&sample]() { sample.value(std::size_t(0)); }, L"Index out of range", LINE_INFO());
+            }
+
+            {
+                const hmc8015_function functions[] = { hmc8015_function::power_factor, hmc8015_function::average_voltage, hmc8015_function::watt_hour, hmc8015_function::rms_current, hmc8015_function::active_power };
+                const float values[] = { 0.9f, 230.0f, 12.5f, 0.5f, 103.5f };
+                hmc8015_sample sample(timestamp(42), functions, values, std::size(functions));
+                Assert::AreEqual(std::size(functions), sample.size(), L"Size", LINE_INFO());
+                Assert::AreEqual(timestamp::value_type(42), sample.timestamp().value(), L"Timestamp", LINE_INFO());
+                Assert::AreEqual(int(hmc8015_function::watt_hour), int(sample.function(2)), L"Function #2", LINE_INFO());
+                Assert::AreEqual(12.5f, sample.value(std::size_t(2)), L"Value #2", LINE_INFO());
+                Assert::AreEqual(0.9f, sample[hmc8015_function::power_factor], L"Power factor", LINE_INFO());
+                Assert::IsFalse(sample.contains(hmc8015_function::rms_voltage), L"No RMS voltage", LINE_INFO());
+
+                const auto data = sample.to_measurement_data();
+                Assert::AreEqual(230.0f, data.voltage(), L"Voltage falls back to average", LINE_INFO());
+                Assert::AreEqual(0.5f, data.current(), L"RMS current", LINE_INFO());
+                Assert::AreEqual(103.5f, data.power(), L"Active power", LINE_INFO());
+            }
+
+            {
+                const hmc8015_function functions[hmc8015_sample::max_functions + 1] = { hmc8015_function::empty };
+                const float values[hmc8015_sample::max_functions + 1] = { 0.0f };
+                Assert::ExpectException<std::invalid_argument>([&]() { hmc8015_sample(timestamp::zero, functions, values, std::size(functions)); }, L"Too many functions", LINE_INFO());
+                Assert::ExpectException<std::invalid_argument>([&]() { hmc8015_sample(timestamp::zero, nullptr, values, 1); }, L"No functions", LINE_INFO());
+            }
+        }
+
+        TEST_METHOD(test_parse_sample) {
+            typedef detail::hmc8015_sensor_impl impl;
+            const auto& functions = impl::default_functions;
+
+            {
+                const std::string str("+2.3012E+02,+3.0000E+02,+4.5000E-01,+1.6000E+01,+1.0355E+02,+1.0104E+02\n");
+                blob response(str.size());
+                std::copy(str.begin(), str.end(), response.as<char>());
+                const auto sample = impl::parse_sample(timestamp(1), functions, std::size(functions), response);
+                Assert::AreEqual(std::size(functions), sample.size(), L"All functions parsed", LINE_INFO());
+                Assert::AreEqual(300.0f, sample[hmc8015_function::voltage_range], L"Voltage range", LINE_INFO());
+                Assert::AreEqual(103.55f, sample[hmc8015_function::apparent_power], L"Apparent power", LINE_INFO());
+
+                const auto data = sample.to_measurement_data();
+                Assert::AreEqual(230.12f, data.voltage(), L"Voltage is first value", LINE_INFO());
+                Assert::AreEqual(0.45f, data.current(), L"Current is third value", LINE_INFO());
+                Assert::AreEqual(101.04f, data.power(), L"Power is last value", LINE_INFO());
+            }
+
+            {
+                const hmc8015_function functions[] = { hmc8015_function::power_factor, hmc8015_function::voltage_frequency, hmc8015_function::watt_hour };
+                const std::string str("9.91E+37, 5.0002E+01\n");
+                blob response(str.size());
+                std::copy(str.begin(), str.end(), response.as<char>());
+                const auto sample = impl::parse_sample(timestamp(1), functions, std::size(functions), response);
+                Assert::AreEqual(std::size(functions), sample.size(), L"All functions present", LINE_INFO());
+                Assert::IsTrue(std::isnan(sample[hmc8015_function::power_factor]), L"Not a number", LINE_INFO());
+                Assert::AreEqual(50.002f, sample[hmc8015_function::voltage_frequency], L"Frequency", LINE_INFO());
+                Assert::AreEqual(measurement_data::invalid_value, sample[hmc8015_function::watt_hour], L"Missing value", LINE_INFO());
+                Assert::IsFalse(sample.contains(hmc8015_function::active_power), L"No power", LINE_INFO());
+            }
+        }
     };
 
 } /* namespace test */
@@ -0,0 +1,238 @@
+﻿// <copyright file="hwmon_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(hwmon_test) {
+
+        /// <summary>
+        /// Writes <paramref name="value" /> to the attribute file
+        /// <paramref name="name" /> in <paramref name="dir" />.
+        /// </summary>
+        static void write_attribute(const std::filesystem::path& dir,
+                const char *name, const std::string& value) {
+            std::ofstream stream(dir / name, std::ios::trunc);
+            stream << value << "\n";
+        }
+
+        std::filesystem::path _root;
+
+    public:
+
+        TEST_METHOD_INITIALIZE(create_fake_sysfs) {
+            namespace fs = std::filesystem;
+            this->_root = fs::temp_directory_path() / "pwrowg_hwmon_test";
+            fs::remove_all(this->_root);
+
+            // A GPU reporting average power, voltage and current.
+            {
+                auto dir = this->_root / "hwmon0";
+                fs::create_directories(dir);
+                write_attribute(dir, "name", "amdgpu");
+                write_attribute(dir, "power1_average", "42000000");
+                write_attribute(dir, "in0_input", "12000");
+                write_attribute(dir, "in0_label", "vddgfx");
+                write_attribute(dir, "curr1_input", "3500");
+            }
+
+            // A device which only reports its energy.
+            {
+                auto dir = this->_root / "hwmon1";
+                fs::create_directories(dir);
+                write_attribute(dir, "name", "xe");
+                write_attribute(dir, "energy1_input", "1000000");
+            }
+
+            // A platform sensor only reporting voltage and current, which
+            // are paired by their labels.
+            {
+                auto dir = this->_root / "hwmon3";
+                fs::create_directories(dir);
+                write_attribute(dir, "name", "ina3221");
+                write_attribute(dir, "in1_input", "5000");
+                write_attribute(dir, "in1_label", "VDD_IN");
+                write_attribute(dir, "in2_input", "3300");
+                write_attribute(dir, "in2_label", "VDD_CPU");
+                write_attribute(dir, "in4_input", "40");
+                write_attribute(dir, "curr1_input", "1500");
+                write_attribute(dir, "curr1_label", "VDD_IN");
+            }
+
+            // A platform sensor without labels, where in0 is the shunt voltage
+            // and in1 the bus voltage matching curr1.
+            {
+                auto dir = this->_root / "hwmon4";
+                fs::create_directories(dir);
+                write_attribute(dir, "name", "ina226");
+                write_attribute(dir, "in0_input", "80");
+                write_attribute(dir, "in1_input", "12000");
+                write_attribute(dir, "curr1_input", "2000");
+            }
+
+            // A device whose voltage and current measure different rails and
+            // which therefore cannot measure power.
+            {
+                auto dir = this->_root / "hwmon5";
+                fs::create_directories(dir);
+                write_attribute(dir, "name", "amdgpu");
+                write_attribute(dir, "in0_input", "800");
+                write_attribute(dir, "in0_label", "vddgfx");
+                write_attribute(dir, "curr1_input", "1000");
+            }
+
+            // A temperature sensor, which must be skipped.
+            {
+                auto dir = this->_root / "hwmon2";
+                fs::create_directories(dir);
+                write_attribute(dir, "name", "coretemp");
+                write_attribute(dir, "temp1_input", "42000");
+            }
+        }
+
+        TEST_METHOD_CLEANUP(delete_fake_sysfs) {
+            std::error_code ec;
+            std::filesystem::remove_all(this->_root, ec);
+        }
+
+        TEST_METHOD(test_for_all) {
+            const auto root = this->_root.generic_string();
+
+            auto cnt = hwmon_sensor::for_all(nullptr, 0, root.c_str());
+            Assert::AreEqual(std::size_t(4), cnt, L"Power sensors found",
+                LINE_INFO());
+
+            std::vector<hwmon_sensor> sensors(cnt);
+            hwmon_sensor::for_all(sensors.data(), sensors.size(),
+                root.c_str());
+            Assert::AreEqual("amdgpu", sensors[0].device_name(),
+                L"Device name", LINE_INFO());
+            Assert::AreEqual(L"HWMON/amdgpu/hwmon0", sensors[0].name(),
+                L"Sensor name", LINE_INFO());
+            Assert::AreEqual("xe", sensors[1].device_name(), L"Device name",
+                LINE_INFO());
+            Assert::AreEqual("ina3221", sensors[2].device_name(),
+                L"Device name", LINE_INFO());
+            Assert::AreEqual("ina226", sensors[3].device_name(),
+                L"Device name", LINE_INFO());
+        }
+
+        TEST_METHOD(test_missing_root) {
+            const auto root = (this->_root / "nonexistent").generic_string();
+            Assert::AreEqual(std::size_t(0), hwmon_sensor::for_all(nullptr, 0,
+                root.c_str()), L"No sensors", LINE_INFO());
+        }
+
+        TEST_METHOD(test_power_attributes) {
+            const auto path = (this->_root / "hwmon0").generic_string();
+            hwmon_sensor sensor(path.c_str());
+            Assert::IsTrue(bool(sensor), L"Sensor valid", LINE_INFO());
+
+            {
+                auto sample = sensor.sample();
+                Assert::AreEqual(42.0f, sample.power(), L"Power in watts",
+                    LINE_INFO());
+                Assert::AreEqual(12.0f, sample.voltage(), L"Voltage in volts",
+                    LINE_INFO());
+                Assert::AreEqual(3.5f, sample.current(), L"Current in amperes",
+                    LINE_INFO());
+            }
+
+            // The sensor must re-read the open file rather than caching it.
+            write_attribute(this->_root / "hwmon0", "power1_average",
+                "23500000");
+            {
+                auto sample = sensor.sample();
+                Assert::AreEqual(23.5f, sample.power(), L"Power re-read",
+                    LINE_INFO());
+            }
+        }
+
+        TEST_METHOD(test_energy_attribute) {
+            const auto dir = this->_root / "hwmon1";
+            const auto path = dir.generic_string();
+            hwmon_sensor sensor(path.c_str());
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+            // 10 J in at least 200 ms are at most 50 W.
+            write_attribute(dir, "energy1_input", "11000000");
+            auto sample = sensor.sample();
+            Assert::IsTrue(sample.power() > 0.0f, L"Positive power",
+                LINE_INFO());
+            Assert::IsTrue(sample.power() <= 50.0f, L"Energy over time",
+                LINE_INFO());
+            Assert::AreEqual(measurement_data::invalid_value, sample.voltage(),
+                L"No voltage", LINE_INFO());
+        }
+
+        TEST_METHOD(test_voltage_current) {
+            const auto path = (this->_root / "hwmon3").generic_string();
+            hwmon_sensor sensor(path.c_str());
+
+            auto sample = sensor.sample();
+            Assert::AreEqual(5.0f, sample.voltage(), L"Voltage in volts",
+                LINE_INFO());
+            Assert::AreEqual(1.5f, sample.current(), L"Current in amperes",
+                LINE_INFO());
+            Assert::AreEqual(7.5f, sample.power(), L"Power derived from "
+                L"voltage and current", LINE_INFO());
+        }
+
+        TEST_METHOD(test_unlabelled_channels) {
+            const auto path = (this->_root / "hwmon4").generic_string();
+            hwmon_sensor sensor(path.c_str());
+
+            auto sample = sensor.sample();
+            Assert::AreEqual(12.0f, sample.voltage(), L"Bus voltage",
+                LINE_INFO());
+            Assert::AreEqual(2.0f, sample.current(), L"Current in amperes",
+                LINE_INFO());
+            Assert::AreEqual(24.0f, sample.power(), L"Power derived from "
+                L"matching channels", LINE_INFO());
+        }
+
+        TEST_METHOD(test_unmatched_channels) {
+            const auto path = (this->_root / "hwmon5").generic_string();
+            Assert::ExpectException<std::invalid_argument>([&path](void) {
+                hwmon_sensor sensor(path.c_str());
+            }, L"Power not derived from different rails", LINE_INFO());
+        }
+
+        TEST_METHOD(test_no_power) {
+            const auto path = (this->_root / "hwmon2").generic_string();
+            Assert::ExpectException<std::invalid_argument>([&path](void) {
+                hwmon_sensor sensor(path.c_str());
+            });
+        }
+
+        TEST_METHOD(test_desc) {
+            const auto path = (this->_root / "hwmon0").generic_string();
+            hwmon_sensor sensor(path.c_str());
+
+            auto json = detail::sensor_desc<hwmon_sensor>::serialise(sensor);
+            Assert::IsTrue(detail::sensor_desc<hwmon_sensor>::describes(json),
+                L"Describes hwmon_sensor", LINE_INFO());
+
+            auto restored = detail::sensor_desc<hwmon_sensor>::deserialise(
+                json);
+            Assert::AreEqual(sensor.path(), restored.path(), L"Same path",
+                LINE_INFO());
+            Assert::AreEqual(sensor.name(), restored.name(), L"Same name",
+                LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,85 @@
+﻿// <copyright file="lock_free_queue_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(lock_free_queue_test) {
+
+    public:
+
+        TEST_METHOD(test_single_thread) {
+            detail::lock_free_queue<int, 4> queue;
+            int value = 0;
+
+            Assert::IsFalse(queue.try_pop(value), L"New queue is empty", LINE_INFO());
+
+            for (int i = 0; i < 4; ++i) {
+                Assert::IsTrue(queue.try_push(i), L"Push into queue with space", LINE_INFO());
+            }
+            Assert::IsFalse(queue.try_push(4), L"Push into full queue", LINE_INFO());
+
+            for (int i = 0; i < 4; ++i) {
+                Assert::IsTrue(queue.try_pop(value), L"Pop from non-empty queue", LINE_INFO());
+                Assert::AreEqual(i, value, L"Queue is FIFO", LINE_INFO());
+            }
+            Assert::IsFalse(queue.try_pop(value), L"Queue is empty again", LINE_INFO());
+
+            // Make sure that the sequence numbers wrap correctly.
+            for (int i = 0; i < 10; ++i) {
+                Assert::IsTrue(queue.try_push(i), L"Push after wrap", LINE_INFO());
+                Assert::IsTrue(queue.try_pop(value), L"Pop after wrap", LINE_INFO());
+                Assert::AreEqual(i, value, L"Value after wrap", LINE_INFO());
+            }
+        }
+
+        TEST_METHOD(test_multiple_producers) {
+            struct value_type { std::uint32_t first; std::uint32_t second; };
+            const std::uint32_t producers = 4;
+            const std::uint32_t cnt = 100000;
+            detail::lock_free_queue<value_type, 256> queue;
+            std::vector<std::thread> threads;
+
+            for (std::uint32_t p = 0; p < producers; ++p) {
+                threads.emplace_back([&queue, p, cnt](void) {
+                    for (std::uint32_t i = 0; i < cnt; ++i) {
+                        while (!queue.try_push(value_type { p, i })) {
+                            std::this_thread::yield();
+                        }
+                    }
+                });
+            }
+
+            std::vector<std::uint32_t> next(producers, 0);
+            std::size_t received = 0;
+            while (received < producers * cnt) {
+                value_type value;
+                if (queue.try_pop(value)) {
+                    Assert::AreEqual(next[value.first], value.second, L"Elements of each producer are in order", LINE_INFO());
+                    ++next[value.first];
+                    ++received;
+                }
+            }
+
+            for (auto& t : threads) {
+                t.join();
+            }
+
+            value_type value;
+            Assert::IsFalse(queue.try_pop(value), L"All elements consumed", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
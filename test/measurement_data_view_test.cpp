@@ -0,0 +1,79 @@
+﻿// <copyright file="measurement_data_view_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(measurement_data_view_test) {
+
+    public:
+
+        TEST_METHOD(test_default) {
+            measurement_data_view view;
+            Assert::IsTrue(view.empty(), L"Default view is empty", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), view.size(), L"Default view has no samples", LINE_INFO());
+            Assert::IsNull(view.voltages(), L"No voltages", LINE_INFO());
+            Assert::IsNull(view.currents(), L"No currents", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), view.expand(nullptr, 0), L"Nothing to expand", LINE_INFO());
+        }
+
+        TEST_METHOD(test_ctor) {
+            const float samples[] = { 1.0f };
+            Assert::ExpectException<std::invalid_argument>([&samples](void) {
+                measurement_data_view(nullptr, samples, 1, timestamp::zero, 1.0);
+            }, L"Voltages must not be nullptr", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([&samples](void) {
+                measurement_data_view(samples, nullptr, 1, timestamp::zero, 1.0);
+            }, L"Currents must not be nullptr", LINE_INFO());
+        }
+
+        TEST_METHOD(test_access) {
+            const float voltages[] = { 1.0f, 2.0f, 3.0f, 4.0f };
+            const float currents[] = { 0.5f, 0.25f, 0.125f, 1.0f };
+            const measurement_data_view view(voltages, currents, 4, timestamp(100), 0.00001);
+
+            Assert::AreEqual(std::size_t(4), view.size(), L"size", LINE_INFO());
+            Assert::AreEqual(timestamp::value_type(100), view.origin().value(), L"origin", LINE_INFO());
+            Assert::AreEqual(0.00001, view.increment(), L"increment", LINE_INFO());
+            Assert::AreEqual(timestamp::value_type(400), view.timestamp(3).value(), L"timestamp", LINE_INFO());
+
+            const auto sample = view[2];
+            Assert::AreEqual(timestamp::value_type(300), sample.timestamp().value(), L"Timestamp of sample", LINE_INFO());
+            Assert::AreEqual(3.0f, sample.voltage(), L"Voltage of sample", LINE_INFO());
+            Assert::AreEqual(0.125f, sample.current(), L"Current of sample", LINE_INFO());
+            Assert::AreEqual(0.375f, sample.power(), L"Power of sample", LINE_INFO());
+
+            Assert::ExpectException<std::range_error>([&view](void) {
+                view.at(4);
+            }, L"Out of range", LINE_INFO());
+        }
+
+        TEST_METHOD(test_expand) {
+            const float voltages[] = { 1.0f, 2.0f, 3.0f, 4.0f };
+            const float currents[] = { 0.5f, 0.25f, 0.125f, 1.0f };
+            const measurement_data_view view(voltages, currents, 4, timestamp(100), 0.00001);
+
+            std::vector<measurement_data> data(2, measurement_data(timestamp::zero, 0.0f));
+            Assert::AreEqual(std::size_t(4), view.expand(nullptr, 0), L"Measure expansion", LINE_INFO());
+            Assert::AreEqual(std::size_t(3), view.expand(data.data(), data.size(), 1), L"Expand with offset", LINE_INFO());
+            Assert::AreEqual(timestamp::value_type(200), data[0].timestamp().value(), L"Timestamp of first sample", LINE_INFO());
+            Assert::AreEqual(2.0f, data[0].voltage(), L"Voltage of first sample", LINE_INFO());
+            Assert::AreEqual(timestamp::value_type(300), data[1].timestamp().value(), L"Timestamp of second sample", LINE_INFO());
+            Assert::AreEqual(0.125f, data[1].current(), L"Current of second sample", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), view.expand(data.data(), data.size(), 4), L"Expand beyond end", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,84 @@
+﻿// <copyright file="min_rtt_fitter_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(min_rtt_fitter_test) {
+
+    public:
+
+        TEST_METHOD(test_empty) {
+            detail::min_rtt_fitter f(8, 4.0, 10, 2.0, 0.1);
+            Assert::IsTrue(f.empty(), L"New fitter is empty", LINE_INFO());
+            Assert::AreEqual(2.0, f.slope(), 0.0, L"Nominal slope", LINE_INFO());
+            Assert::AreEqual(detail::min_rtt_fitter::value_type(6), f(3), L"Nominal line", LINE_INFO());
+            Assert::AreEqual(timestamp::value_type(0), f.roundtrip(), L"No round trip", LINE_INFO());
+        }
+
+        TEST_METHOD(test_fit) {
+            detail::min_rtt_fitter f(8, 4.0, 10, 2.0, 0.1);
+            for (detail::min_rtt_fitter::value_type x = 0; x < 8; ++x) {
+                Assert::IsTrue(f.accept(100), L"Probe accepted", LINE_INFO());
+                f.add({ 1000 * x, 2050 * x + 7, 100 });
+            }
+
+            Assert::AreEqual(std::size_t(8), f.size(), L"All probes retained", LINE_INFO());
+            Assert::AreEqual(2.05, f.slope(), 1e-9, L"Slope", LINE_INFO());
+            Assert::AreEqual(detail::min_rtt_fitter::value_type(20507), f(10000), L"Extrapolation", LINE_INFO());
+        }
+
+        TEST_METHOD(test_implausible_slope) {
+            detail::min_rtt_fitter f(8, 4.0, 10, 2.0, 0.1);
+            for (detail::min_rtt_fitter::value_type x = 0; x < 8; ++x) {
+                f.add({ 1000 * x, 3000 * x, 100 });
+            }
+
+            Assert::AreEqual(2.0, f.slope(), 0.0, L"Slope retained", LINE_INFO());
+        }
+
+        TEST_METHOD(test_rejection) {
+            detail::min_rtt_fitter f(4, 4.0, 10, 1.0, 0.1);
+            Assert::IsFalse(f.accept(-1), L"Negative RTT rejected", LINE_INFO());
+
+            for (detail::min_rtt_fitter::value_type x = 0; x < 4; ++x) {
+                f.add({ x, x, 100 });
+            }
+
+            Assert::IsTrue(f.accept(400), L"Moderate RTT accepted", LINE_INFO());
+
+            for (int i = 0; i < 4; ++i) {
+                Assert::IsFalse(f.accept(1000), L"Outlier rejected", LINE_INFO());
+            }
+
+            Assert::IsTrue(f.accept(1000), L"Persistent slowdown accepted", LINE_INFO());
+        }
+
+        TEST_METHOD(test_sliding_window) {
+            detail::min_rtt_fitter f(4, 4.0, 10, 1.0, 0.1);
+            for (detail::min_rtt_fitter::value_type x = 0; x < 8; ++x) {
+                f.add({ x, x, 100 - x });
+            }
+
+            Assert::AreEqual(std::size_t(4), f.size(), L"Window is bounded", LINE_INFO());
+            Assert::AreEqual(timestamp::value_type(93), f.roundtrip(), L"Round trip", LINE_INFO());
+
+            f.clear();
+            Assert::IsTrue(f.empty(), L"Fitter cleared", LINE_INFO());
+            Assert::AreEqual(1.0, f.slope(), 0.0, L"Nominal slope restored", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
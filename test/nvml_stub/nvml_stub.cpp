@@ -0,0 +1,313 @@
+﻿// <copyright file="nvml_stub.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+// This file implements a fake NVML library that the tests can load via
+// nvidia_management_library instead of the driver. It simulates a single GPU
+// whose power, energy counter and sample buffer are controlled by the tests
+// via the nvml_stub_* functions.
+
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#define NVML_LIB_EXPORT
+#include <nvml.h>
+
+// NVML maps some of its functions to versioned names, but we are loaded by
+// name, ie we must export the unversioned ones.
+#undef nvmlInit
+#undef nvmlDeviceGetPciInfo
+#undef nvmlDeviceGetCount
+#undef nvmlDeviceGetHandleByIndex
+#undef nvmlDeviceGetHandleByPciBusId
+
+#include "nvml_extensions.h"
+
+#if defined(_WIN32)
+#define NVML_STUB_API extern "C" __declspec(dllexport)
+#else /* defined(_WIN32) */
+#define NVML_STUB_API extern "C" __attribute__((visibility("default")))
+#endif /* defined(_WIN32) */
+
+
+using namespace visus::power_overwhelming::detail;
+
+
+namespace {
+
+    /// <summary>
+    /// A sample in the simulated power buffer of the GPU.
+    /// </summary>
+    struct stub_sample {
+        unsigned long long timestamp;
+        unsigned int power;
+    };
+
+    /// <summary>
+    /// The simulated state of the GPU.
+    /// </summary>
+    struct stub_state {
+        unsigned long long energy = 0;
+        std::mutex lock;
+        unsigned int power = 0;
+        std::vector<stub_sample> samples;
+    } state;
+
+    /// <summary>
+    /// The address of this variable serves as handle of the only device.
+    /// </summary>
+    int device;
+
+    /// <summary>
+    /// Answer the handle of the only device.
+    /// </summary>
+    inline nvmlDevice_t get_device(void) {
+        return reinterpret_cast<nvmlDevice_t>(&::device);
+    }
+
+    /// <summary>
+    /// Copies <paramref name="src" /> to the buffer of an NVML string query.
+    /// </summary>
+    nvmlReturn_t copy_string(char *dst, const unsigned int cnt,
+            const char *src) {
+        if ((dst == nullptr) || (cnt <= std::strlen(src))) {
+            return NVML_ERROR_INSUFFICIENT_SIZE;
+        }
+
+        std::strcpy(dst, src);
+        return NVML_SUCCESS;
+    }
+}
+
+
+/*
+ * nvml_stub_add_sample
+ */
+NVML_STUB_API void nvml_stub_add_sample(const unsigned long long timestamp,
+        const unsigned int power) {
+    std::lock_guard<std::mutex> l(state.lock);
+    state.samples.push_back({ timestamp, power });
+}
+
+
+/*
+ * nvml_stub_reset
+ */
+NVML_STUB_API void nvml_stub_reset(void) {
+    std::lock_guard<std::mutex> l(state.lock);
+    state.energy = 0;
+    state.power = 0;
+    state.samples.clear();
+}
+
+
+/*
+ * nvml_stub_set_energy
+ */
+NVML_STUB_API void nvml_stub_set_energy(const unsigned long long energy) {
+    std::lock_guard<std::mutex> l(state.lock);
+    state.energy = energy;
+}
+
+
+/*
+ * nvml_stub_set_power
+ */
+NVML_STUB_API void nvml_stub_set_power(const unsigned int power) {
+    std::lock_guard<std::mutex> l(state.lock);
+    state.power = power;
+}
+
+
+/*
+ * nvmlDeviceGetCount
+ */
+NVML_STUB_API nvmlReturn_t nvmlDeviceGetCount(unsigned int *deviceCount) {
+    if (deviceCount == nullptr) {
+        return NVML_ERROR_INVALID_ARGUMENT;
+    }
+
+    *deviceCount = 1;
+    return NVML_SUCCESS;
+}
+
+
+/*
+ * nvmlDeviceGetHandleByIndex
+ */
+NVML_STUB_API nvmlReturn_t nvmlDeviceGetHandleByIndex(unsigned int index,
+        nvmlDevice_t *device) {
+    if ((device == nullptr) || (index != 0)) {
+        return NVML_ERROR_INVALID_ARGUMENT;
+    }
+
+    *device = get_device();
+    return NVML_SUCCESS;
+}
+
+
+/*
+ * nvmlDeviceGetHandleByPciBusId
+ */
+NVML_STUB_API nvmlReturn_t nvmlDeviceGetHandleByPciBusId(const char *pciBusId,
+        nvmlDevice_t *device) {
+    return NVML_ERROR_NOT_FOUND;
+}
+
+
+/*
+ * nvmlDeviceGetHandleBySerial
+ */
+NVML_STUB_API nvmlReturn_t nvmlDeviceGetHandleBySerial(const char *serial,
+        nvmlDevice_t *device) {
+    return NVML_ERROR_NOT_FOUND;
+}
+
+
+/*
+ * nvmlDeviceGetHandleByUUID
+ */
+NVML_STUB_API nvmlReturn_t nvmlDeviceGetHandleByUUID(const char *uuid,
+        nvmlDevice_t *device) {
+    return NVML_ERROR_NOT_FOUND;
+}
+
+
+/*
+ * nvmlDeviceGetName
+ */
+NVML_STUB_API nvmlReturn_t nvmlDeviceGetName(nvmlDevice_t device, char *name,
+        unsigned int length) {
+    return copy_string(name, length, "NVML Stub");
+}
+
+
+/*
+ * nvmlDeviceGetPciInfo
+ */
+NVML_STUB_API nvmlReturn_t nvmlDeviceGetPciInfo(nvmlDevice_t device,
+        nvmlPciInfo_t *pci) {
+    if (pci == nullptr) {
+        return NVML_ERROR_INVALID_ARGUMENT;
+    }
+
+    std::memset(pci, 0, sizeof(*pci));
+    return copy_string(pci->busId, sizeof(pci->busId), "00000000:00:00.0");
+}
+
+
+/*
+ * nvmlDeviceGetPowerUsage
+ */
+NVML_STUB_API nvmlReturn_t nvmlDeviceGetPowerUsage(nvmlDevice_t device,
+        unsigned int *power) {
+    if (power == nullptr) {
+        return NVML_ERROR_INVALID_ARGUMENT;
+    }
+
+    std::lock_guard<std::mutex> l(state.lock);
+    *power = state.power;
+    return NVML_SUCCESS;
+}
+
+
+/*
+ * nvmlDeviceGetSamples
+ */
+NVML_STUB_API nvmlReturn_t nvmlDeviceGetSamples(nvmlDevice_t device,
+        nvml_sampling_type type,
+        unsigned long long lastSeenTimeStamp,
+        nvml_value_type *sampleValType,
+        unsigned int *sampleCount,
+        nvml_sample *samples) {
+    if ((type != nvml_total_power_samples) || (sampleValType == nullptr)
+            || (sampleCount == nullptr)) {
+        return NVML_ERROR_INVALID_ARGUMENT;
+    }
+
+    std::lock_guard<std::mutex> l(state.lock);
+    *sampleValType = nvml_value_type_unsigned_int;
+
+    unsigned int cnt = 0;
+    for (auto& s : state.samples) {
+        if (s.timestamp > lastSeenTimeStamp) {
+            ++cnt;
+        }
+    }
+
+    if (cnt == 0) {
+        return NVML_ERROR_NOT_FOUND;
+    }
+
+    if (samples == nullptr) {
+        *sampleCount = cnt;
+        return NVML_SUCCESS;
+    }
+
+    if (*sampleCount < cnt) {
+        return NVML_ERROR_INSUFFICIENT_SIZE;
+    }
+
+    *sampleCount = 0;
+    for (auto& s : state.samples) {
+        if (s.timestamp > lastSeenTimeStamp) {
+            auto& dst = samples[(*sampleCount)++];
+            dst.timeStamp = s.timestamp;
+            dst.sampleValue.uiVal = s.power;
+        }
+    }
+
+    return NVML_SUCCESS;
+}
+
+
+/*
+ * nvmlDeviceGetTotalEnergyConsumption
+ */
+NVML_STUB_API nvmlReturn_t nvmlDeviceGetTotalEnergyConsumption(
+        nvmlDevice_t device, unsigned long long *energy) {
+    if (energy == nullptr) {
+        return NVML_ERROR_INVALID_ARGUMENT;
+    }
+
+    std::lock_guard<std::mutex> l(state.lock);
+    *energy = state.energy;
+    return NVML_SUCCESS;
+}
+
+
+/*
+ * nvmlDeviceGetUUID
+ */
+NVML_STUB_API nvmlReturn_t nvmlDeviceGetUUID(nvmlDevice_t device, char *uuid,
+        unsigned int length) {
+    return copy_string(uuid, length,
+        "GPU-00000000-0000-0000-0000-000000000000");
+}
+
+
+/*
+ * nvmlErrorString
+ */
+NVML_STUB_API const char *nvmlErrorString(nvmlReturn_t result) {
+    return "NVML stub error";
+}
+
+
+/*
+ * nvmlInit
+ */
+NVML_STUB_API nvmlReturn_t nvmlInit(void) {
+    return NVML_SUCCESS;
+}
+
+
+/*
+ * nvmlShutdown
+ */
+NVML_STUB_API nvmlReturn_t nvmlShutdown(void) {
+    return NVML_SUCCESS;
+}
@@ -1,5 +1,5 @@
 // <copyright file="nvml_test.cpp" company="Visualisierungsinstitut der Universitt Stuttgart">
-// Copyright  2021 Visualisierungsinstitut der Universitt Stuttgart.
+// Copyright  2021 - 2024 Visualisierungsinstitut der Universitt Stuttgart.
 // Licensed under the MIT licence. See LICENCE file for details.
 // </copyright>
 // <author>Christoph Mller</author>
@@ -52,6 +52,218 @@ namespace test {
     };
 #endif /* defined(POWER_OVERWHELMING_WITH_NVML) */
 
+    TEST_CLASS(nvml_sampler_test) {
+
+    public:
+
+        TEST_METHOD(test_next_tick) {
+            typedef detail::nvml_sampler::clock_type clock_type;
+            typedef detail::nvml_sampler::interval_type interval_type;
+            const interval_type interval(1000);
+
+            {
+                const clock_type::time_point now(std::chrono::microseconds(0));
+                auto tick = detail::nvml_sampler::next_tick(now, interval);
+                Assert::IsTrue(tick - now == interval, L"Tick after epoch",
+                    LINE_INFO());
+            }
+
+            {
+                const clock_type::time_point now(std::chrono::microseconds(
+                    4200));
+                auto tick = detail::nvml_sampler::next_tick(now, interval);
+                Assert::IsTrue(tick == clock_type::time_point(
+                    std::chrono::microseconds(5000)), L"Aligned to grid",
+                    LINE_INFO());
+            }
+
+            {
+                // All workers must agree on the tick regardless of when they
+                // were late.
+                const clock_type::time_point a(std::chrono::microseconds(
+                    7001));
+                const clock_type::time_point b(std::chrono::microseconds(
+                    7999));
+                Assert::IsTrue(detail::nvml_sampler::next_tick(a, interval)
+                    == detail::nvml_sampler::next_tick(b, interval),
+                    L"Same tick", LINE_INFO());
+            }
+
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                detail::nvml_sampler::next_tick(clock_type::now(),
+                    interval_type(0));
+            });
+        }
+    };
+
+#if defined(POWER_OVERWHELMING_NVML_STUB)
+    TEST_CLASS(nvml_stub_test) {
+
+        /// <summary>
+        /// Provides access to the functions controlling the fake GPU.
+        /// </summary>
+        struct stub_control : public detail::library_base {
+            void (*add_sample)(unsigned long long, unsigned int);
+            void (*reset)(void);
+            void (*set_energy)(unsigned long long);
+            void (*set_power)(unsigned int);
+
+            inline stub_control(void)
+                    : library_base(TEXT(POWER_OVERWHELMING_NVML_STUB)) {
+                this->add_sample = this->get_function<decltype(
+                    this->add_sample)>("nvml_stub_add_sample");
+                this->reset = this->get_function<decltype(
+                    this->reset)>("nvml_stub_reset");
+                this->set_energy = this->get_function<decltype(
+                    this->set_energy)>("nvml_stub_set_energy");
+                this->set_power = this->get_function<decltype(
+                    this->set_power)>("nvml_stub_set_power");
+                this->reset();
+            }
+        };
+
+        static nvmlDevice_t get_device(
+                const detail::nvidia_management_library& library) {
+            nvmlDevice_t retval = nullptr;
+            auto status = library.nvmlDeviceGetHandleByIndex(0, &retval);
+            Assert::AreEqual(int(NVML_SUCCESS), int(status), L"Got device",
+                LINE_INFO());
+            return retval;
+        }
+
+    public:
+
+        TEST_METHOD(test_power_usage) {
+            stub_control stub;
+            detail::nvidia_management_library library(
+                TEXT(POWER_OVERWHELMING_NVML_STUB));
+            detail::nvml_power_reader reader(library);
+            auto device = get_device(library);
+
+            Assert::IsTrue(reader.mode() == nvml_sampling_mode::power_usage,
+                L"Power usage is default", LINE_INFO());
+
+            stub.set_power(42000);
+            auto sample = reader.read(device);
+            Assert::AreEqual(42.0f, sample.power(), L"Power in watts",
+                LINE_INFO());
+        }
+
+        TEST_METHOD(test_energy_consumption) {
+            stub_control stub;
+            detail::nvidia_management_library library(
+                TEXT(POWER_OVERWHELMING_NVML_STUB));
+            detail::nvml_power_reader reader(library);
+            auto device = get_device(library);
+
+            stub.set_power(100000);
+            stub.set_energy(1000000);
+            reader.mode(device, nvml_sampling_mode::energy_consumption);
+            Assert::IsTrue(reader.mode()
+                == nvml_sampling_mode::energy_consumption,
+                L"Mode changed", LINE_INFO());
+
+            {
+                auto sample = reader.read(device);
+                Assert::AreEqual(100.0f, sample.power(),
+                    L"Power usage until counter changes", LINE_INFO());
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            stub.set_energy(1000000 + 10000);
+
+            {
+                // 10 J in at least 200 ms are at most 50 W.
+                auto sample = reader.read(device);
+                Assert::IsTrue(sample.power() > 0.0f, L"Positive power",
+                    LINE_INFO());
+                Assert::IsTrue(sample.power() <= 50.0f, L"Energy over time",
+                    LINE_INFO());
+            }
+
+            {
+                // Counter was reset, eg by reloading the driver.
+                stub.set_power(23000);
+                stub.set_energy(0);
+                auto sample = reader.read(device);
+                Assert::AreEqual(23.0f, sample.power(),
+                    L"Power usage after reset of counter", LINE_INFO());
+            }
+        }
+
+        TEST_METHOD(test_power_samples) {
+            stub_control stub;
+            detail::nvidia_management_library library(
+                TEXT(POWER_OVERWHELMING_NVML_STUB));
+            detail::nvml_power_reader reader(library);
+            auto device = get_device(library);
+            std::vector<measurement_data> samples;
+
+            stub.set_power(10000);
+            stub.add_sample(1000, 1000);
+            stub.add_sample(2000, 2000);
+            reader.mode(device, nvml_sampling_mode::power_samples);
+
+            Assert::AreEqual(std::size_t(0), reader.read(samples, device),
+                L"History discarded", LINE_INFO());
+            Assert::IsTrue(samples.empty(), L"History discarded", LINE_INFO());
+
+            stub.add_sample(3000, 1500);
+            stub.add_sample(4000, 2500);
+            Assert::AreEqual(std::size_t(2), reader.read(samples, device),
+                L"New samples", LINE_INFO());
+            Assert::AreEqual(std::size_t(2), samples.size(), L"New samples",
+                LINE_INFO());
+            Assert::AreEqual(
+                detail::nvml_power_reader::to_timestamp(3000).value(),
+                samples[0].timestamp().value(), L"Driver timestamp",
+                LINE_INFO());
+            Assert::AreEqual(1.5f, samples[0].power(), L"Power in watts",
+                LINE_INFO());
+            Assert::AreEqual(
+                detail::nvml_power_reader::to_timestamp(4000).value(),
+                samples[1].timestamp().value(), L"Driver timestamp",
+                LINE_INFO());
+            Assert::AreEqual(2.5f, samples[1].power(), L"Power in watts",
+                LINE_INFO());
+
+            samples.clear();
+            Assert::AreEqual(std::size_t(0), reader.read(samples, device),
+                L"No duplicates", LINE_INFO());
+
+            {
+                auto sample = reader.read(device);
+                Assert::AreEqual(
+                    detail::nvml_power_reader::to_timestamp(4000).value(),
+                    sample.timestamp().value(), L"Latest sample", LINE_INFO());
+                Assert::AreEqual(2.5f, sample.power(), L"Latest sample",
+                    LINE_INFO());
+            }
+        }
+
+        TEST_METHOD(test_unsupported) {
+            stub_control stub;
+            detail::nvidia_management_library library(
+                TEXT(POWER_OVERWHELMING_NVML_STUB));
+            detail::nvml_power_reader reader(library);
+            auto device = get_device(library);
+
+            // Simulate a driver that does not export the new functions.
+            library.nvmlDeviceGetSamples = nullptr;
+            library.nvmlDeviceGetTotalEnergyConsumption = nullptr;
+
+            Assert::ExpectException<nvml_exception>([&](void) {
+                reader.mode(device, nvml_sampling_mode::energy_consumption);
+            });
+            Assert::ExpectException<nvml_exception>([&](void) {
+                reader.mode(device, nvml_sampling_mode::power_samples);
+            });
+            Assert::IsTrue(reader.mode() == nvml_sampling_mode::power_usage,
+                L"Mode unchanged", LINE_INFO());
+        }
+    };
+#endif /* defined(POWER_OVERWHELMING_NVML_STUB) */
+
 } /* namespace test */
 } /* namespace power_overwhelming */
 } /* namespace visus */
@@ -73,6 +73,28 @@ namespace test {
             Assert::AreEqual(parallel_port_trigger::value_type(0), parallel_port_trigger::to_value(parallel_port_pin::acknowledge), L"acknowledge", LINE_INFO());
         }
 
+        TEST_METHOD(test_pulse_at) {
+            parallel_port_trigger trigger;
+            Assert::IsFalse(bool(trigger), L"Trigger is not open", LINE_INFO());
+
+            const auto begin = timestamp::now();
+            const auto when = begin + std::chrono::milliseconds(50);
+
+            Assert::ExpectException<std::system_error>([&trigger, when](void) {
+                trigger.pulse_at(when, 1, 0);
+            }, L"Pulse on closed port fails", LINE_INFO());
+
+            Assert::IsTrue(timestamp::now() >= when, L"Pulse was not emitted before the scheduled time", LINE_INFO());
+        }
+
+        TEST_METHOD(test_write_timestamps) {
+            parallel_port_trigger trigger;
+            timestamp before, after;
+            Assert::ExpectException<std::system_error>([&](void) {
+                trigger.write(1, &before, &after);
+            }, L"Write on closed port fails", LINE_INFO());
+        }
+
     };
 } /* namespace test */
 } /* namespace power_overwhelming */
@@ -6,45 +6,84 @@
 
 #pragma once
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
 #include <regex>
 #include <sstream>
 #include <thread>
+#include <vector>
 
 #include <power_overwhelming/adl_sensor.h>
 #include <power_overwhelming/async_sampling.h>
 #include <power_overwhelming/blob.h>
+#include <power_overwhelming/capture_aggregate.h>
+#include <power_overwhelming/capture_filter.h>
+#include <power_overwhelming/capture_reader.h>
+#include <power_overwhelming/capture_writer.h>
 #include <power_overwhelming/collector.h>
+#include <power_overwhelming/collector_aggregator.h>
 #include <power_overwhelming/convert_string.h>
 #include <power_overwhelming/computer_name.h>
 #include <power_overwhelming/cpu_affinity.h>
 #include <power_overwhelming/cpu_info.h>
+#include <power_overwhelming/csv_encoder.h>
 #include <power_overwhelming/csv_iomanip.h>
 #include <power_overwhelming/emi_sensor.h>
 #include <power_overwhelming/event.h>
 #include <power_overwhelming/for_each_rapl_domain.h>
 #include <power_overwhelming/hmc8015_function.h>
+#include <power_overwhelming/hmc8015_log_cursor.h>
+#include <power_overwhelming/hmc8015_sample.h>
+#include <power_overwhelming/hwmon_sensor.h>
 #include <power_overwhelming/measurement.h>
 #include <power_overwhelming/measurement_data.h>
 #include <power_overwhelming/measurement_data_series.h>
+#include <power_overwhelming/measurement_data_view.h>
 #include <power_overwhelming/nvml_sensor.h>
 #include <power_overwhelming/oscilloscope_sample.h>
+#include <power_overwhelming/output_sync_policy.h>
 #include <power_overwhelming/parallel_port_trigger.h>
 #include <power_overwhelming/rtx_instrument_configuration.h>
 #include <power_overwhelming/rtx_sensor.h>
 #include <power_overwhelming/rtx_sensor_definition.h>
 #include <power_overwhelming/rapl_domain.h>
+#include <power_overwhelming/time_synchroniser.h>
 #include <power_overwhelming/timestamp.h>
 #include <power_overwhelming/tinkerforge_sensor_definition.h>
+#include <power_overwhelming/waveform_pyramid.h>
 
 #include <adl_exception.h>
+#include <bit_stream.h>
+#include <block_writer.h>
+#include <blob_pool.h>
+#include <capture_codec.h>
+#include <collector_agent.h>
+#include <collector_impl.h>
 #include <emi_device.h>
+#include <hmc8015_log_parser.h>
+#include <hmc8015_sensor_impl.h>
 #include <io_util.h>
+#include <library_base.h>
+#include <lock_free_queue.h>
+#include <memory_mapped_file.h>
+#include <min_rtt_fitter.h>
 #include <on_exit.h>
 #include <msr_magic.h>
 #include <nvml_exception.h>
+#include <nvml_power_reader.h>
+#include <nvml_sampler.h>
 #include <nvml_scope.h>
+#include <peer_clock_model.h>
 #include <rtx_serialisation.h>
+#include <scpi_parser.h>
 #include <sensor_desc.h>
 #include <setup_api.h>
 #include <string_functions.h>
+#include <tinkerforge_clock_model.h>
+#include <tinkerforge_coalescer.h>
+#include <tinkerforge_scope.h>
+#include <tinkerforge_sensor_impl.h>
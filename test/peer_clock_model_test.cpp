@@ -0,0 +1,120 @@
+﻿// <copyright file="peer_clock_model_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(peer_clock_model_test) {
+
+    public:
+
+        TEST_METHOD(test_empty) {
+            detail::peer_clock_model m;
+            Assert::IsTrue(m.empty(), L"New model is empty", LINE_INFO());
+            Assert::AreEqual(0.0, m.drift(), 0.0, L"No drift", LINE_INFO());
+            Assert::AreEqual(timestamp::value_type(0), m.offset(timestamp::now()), L"No offset", LINE_INFO());
+            Assert::AreEqual(timestamp::value_type(0), m.roundtrip(), L"No round trip", LINE_INFO());
+        }
+
+        TEST_METHOD(test_offset) {
+            // The peer is 1 s ahead and both clocks run at the same speed.
+            const timestamp::value_type origin = 100 * timestamp::tick_rate;
+            const timestamp::value_type offset = timestamp::tick_rate;
+            const timestamp::value_type rtt = 2000;     // 200 us.
+
+            detail::peer_clock_model m;
+            for (int i = 0; i < 8; ++i) {
+                const auto local = origin + i * timestamp::tick_rate;
+                Assert::IsTrue(m.add({ timestamp(local - rtt / 2), timestamp(local + offset), timestamp(local + rtt / 2) }), L"Probe accepted", LINE_INFO());
+            }
+
+            Assert::AreEqual(std::size_t(8), m.size(), L"All probes retained", LINE_INFO());
+            Assert::AreEqual(0.0, m.drift(), 1e-9, L"No drift", LINE_INFO());
+            Assert::AreEqual(rtt, m.roundtrip(), L"Round trip", LINE_INFO());
+            Assert::AreEqual(double(offset), double(m.offset(timestamp(origin))), 1.0, L"Offset estimated", LINE_INFO());
+            Assert::AreEqual(double(origin + offset), double(m(timestamp(origin)).value()), 1.0, L"Transformation", LINE_INFO());
+        }
+
+        TEST_METHOD(test_drift) {
+            // The peer clock runs 50 ppm fast and is 5 ms ahead at the origin.
+            const timestamp::value_type origin = 100 * timestamp::tick_rate;
+            const auto offset = 50000.0;
+            const auto drift = 50e-6;
+            const timestamp::value_type rtt = 2000;
+
+            const auto peer = [&](const timestamp::value_type local) {
+                return timestamp(local + static_cast<timestamp::value_type>(offset + drift * (local - origin)));
+            };
+
+            detail::peer_clock_model m;
+            for (int i = 0; i < 16; ++i) {
+                const auto local = origin + i * timestamp::tick_rate;
+                m.add({ timestamp(local - rtt / 2), peer(local), timestamp(local + rtt / 2) });
+            }
+
+            Assert::AreEqual(drift, m.drift(), 1e-8, L"Drift estimated", LINE_INFO());
+
+            const auto later = origin + 20 * timestamp::tick_rate;
+            Assert::AreEqual(double(peer(later).value()), double(m(timestamp(later)).value()), 2.0, L"Extrapolation", LINE_INFO());
+        }
+
+        TEST_METHOD(test_outlier) {
+            const timestamp::value_type origin = 100 * timestamp::tick_rate;
+            const timestamp::value_type offset = timestamp::tick_rate;
+            const timestamp::value_type rtt = 2000;
+
+            detail::peer_clock_model m;
+            for (int i = 0; i < 8; ++i) {
+                const auto local = origin + i * timestamp::tick_rate;
+                m.add({ timestamp(local - rtt / 2), timestamp(local + offset), timestamp(local + rtt / 2) });
+            }
+
+            // A response that has been stuck for 50 ms must not be used.
+            {
+                const auto local = origin + 8 * timestamp::tick_rate;
+                Assert::IsFalse(m.add({ timestamp(local - rtt / 2), timestamp(local + offset), timestamp(local + 500000) }), L"Delayed probe rejected", LINE_INFO());
+            }
+
+            Assert::AreEqual(std::size_t(8), m.size(), L"Outlier not retained", LINE_INFO());
+            Assert::AreEqual(double(offset), double(m.offset(timestamp(origin))), 1.0, L"Offset unaffected", LINE_INFO());
+
+            // Probes with an asymmetric but moderate delay are retained, but do
+            // not affect the fit as long as there are better ones.
+            {
+                const auto local = origin + 9 * timestamp::tick_rate;
+                Assert::IsTrue(m.add({ timestamp(local - rtt / 2), timestamp(local + offset + 1000), timestamp(local + rtt) }), L"Slower probe accepted", LINE_INFO());
+            }
+
+            Assert::AreEqual(double(offset), double(m.offset(timestamp(origin))), 1.0, L"Offset uses fastest probes", LINE_INFO());
+        }
+
+        TEST_METHOD(test_sliding_window) {
+            const timestamp::value_type origin = 100 * timestamp::tick_rate;
+            const timestamp::value_type rtt = 2000;
+
+            detail::peer_clock_model m;
+            for (std::size_t i = 0; i < 2 * detail::peer_clock_model::capacity; ++i) {
+                const auto local = origin + static_cast<timestamp::value_type>(i) * timestamp::tick_rate;
+                m.add({ timestamp(local - rtt / 2), timestamp(local), timestamp(local + rtt / 2) });
+            }
+
+            Assert::AreEqual(detail::peer_clock_model::capacity, m.size(), L"Window is bounded", LINE_INFO());
+
+            m.clear();
+            Assert::IsTrue(m.empty(), L"Model cleared", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
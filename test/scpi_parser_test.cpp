@@ -0,0 +1,115 @@
+﻿// <copyright file="scpi_parser_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(scpi_parser_test) {
+
+    public:
+
+        TEST_METHOD(test_tokeniser) {
+            {
+                detail::scpi_tokeniser tokens("");
+                std::string_view token;
+                Assert::IsFalse(tokens.next(token), L"No token in empty string", LINE_INFO());
+            }
+
+            {
+                detail::scpi_tokeniser tokens("\n");
+                std::string_view token;
+                Assert::IsFalse(tokens.next(token), L"No token in line break", LINE_INFO());
+            }
+
+            {
+                detail::scpi_tokeniser tokens(" 1.0, 2 ,,abc\r\n");
+                std::string_view token;
+                Assert::IsTrue(tokens.next(token), L"Token #0", LINE_INFO());
+                Assert::IsTrue(token == "1.0", L"Token #0 trimmed", LINE_INFO());
+                Assert::IsTrue(tokens.next(token), L"Token #1", LINE_INFO());
+                Assert::IsTrue(token == "2", L"Token #1 trimmed", LINE_INFO());
+                Assert::IsTrue(tokens.next(token), L"Token #2", LINE_INFO());
+                Assert::IsTrue(token.empty(), L"Token #2 empty", LINE_INFO());
+                Assert::IsTrue(tokens.next(token), L"Token #3", LINE_INFO());
+                Assert::IsTrue(token == "abc", L"Token #3 without line break", LINE_INFO());
+                Assert::IsFalse(tokens.next(token), L"End of input", LINE_INFO());
+            }
+        }
+
+        TEST_METHOD(test_number) {
+            float f = 0.0f;
+            Assert::IsTrue(detail::parse_scpi_number("+2.500000E+02", f), L"Float with plus sign", LINE_INFO());
+            Assert::AreEqual(250.0f, f, L"Float value", LINE_INFO());
+
+            Assert::IsTrue(detail::parse_scpi_number(" -1.5e-3\n", f), L"Float with space", LINE_INFO());
+            Assert::AreEqual(-1.5e-3f, f, L"Negative float value", LINE_INFO());
+
+            Assert::IsTrue(detail::parse_scpi_number("9.91E+37", f), L"SCPI NaN", LINE_INFO());
+            Assert::IsTrue(std::isnan(f), L"SCPI NaN is NaN", LINE_INFO());
+
+            Assert::IsFalse(detail::parse_scpi_number("abc", f), L"Not a number", LINE_INFO());
+            Assert::IsFalse(detail::parse_scpi_number("", f), L"Empty", LINE_INFO());
+
+            int i = 0;
+            Assert::IsTrue(detail::parse_scpi_number("2024", i), L"Integer", LINE_INFO());
+            Assert::AreEqual(2024, i, L"Integer value", LINE_INFO());
+        }
+
+        TEST_METHOD(test_array) {
+            const std::string list = "1.0,-2.5E+00, 3,4e1\n";
+            const auto begin = list.data();
+            const auto end = begin + list.size();
+
+            Assert::AreEqual(std::size_t(4), detail::parse_scpi_array<float>(nullptr, 0, begin, end), L"Count only", LINE_INFO());
+
+            std::vector<float> values(4);
+            Assert::AreEqual(std::size_t(4), detail::parse_scpi_array(values.data(), values.size(), begin, end), L"Parse all", LINE_INFO());
+            Assert::AreEqual(1.0f, values[0], L"Value #0", LINE_INFO());
+            Assert::AreEqual(-2.5f, values[1], L"Value #1", LINE_INFO());
+            Assert::AreEqual(3.0f, values[2], L"Value #2", LINE_INFO());
+            Assert::AreEqual(40.0f, values[3], L"Value #3", LINE_INFO());
+
+            std::fill(values.begin(), values.end(), 0.0f);
+            Assert::AreEqual(std::size_t(4), detail::parse_scpi_array(values.data(), 2, begin, end), L"Parse partially", LINE_INFO());
+            Assert::AreEqual(-2.5f, values[1], L"Value #1", LINE_INFO());
+            Assert::AreEqual(0.0f, values[2], L"Value #2 untouched", LINE_INFO());
+
+            Assert::AreEqual(std::size_t(0), detail::parse_scpi_array<float>(nullptr, 0, end, end), L"Empty list", LINE_INFO());
+
+            const std::string invalid = "1,x,3";
+            Assert::ExpectException<std::invalid_argument>([&](void) {
+                detail::parse_scpi_array(values.data(), values.size(), invalid.data(), invalid.data() + invalid.size());
+            }, L"Invalid value", LINE_INFO());
+        }
+
+        TEST_METHOD(test_large_array) {
+            const std::size_t cnt = 100000;
+            std::string list;
+            for (std::size_t i = 0; i < cnt; ++i) {
+                if (i > 0) {
+                    list += ',';
+                }
+                list += std::to_string(i);
+                list += ".5";
+            }
+
+            std::vector<float> values(cnt);
+            Assert::AreEqual(cnt, detail::parse_scpi_array(values.data(), values.size(), list.data(), list.data() + list.size()), L"All values", LINE_INFO());
+            Assert::AreEqual(0.5f, values.front(), L"First value", LINE_INFO());
+            Assert::AreEqual(static_cast<float>(cnt - 1) + 0.5f, values.back(), L"Last value", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
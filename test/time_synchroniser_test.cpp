@@ -0,0 +1,94 @@
+﻿// <copyright file="time_synchroniser_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+#if defined(_WIN32)
+#include <WinSock2.h>
+#else /* defined(_WIN32) */
+#include <sys/socket.h>
+#endif /* defined(_WIN32) */
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(time_synchroniser_test) {
+
+    public:
+
+#if defined(POWER_OVERWHELMING_WITH_TIME_SYNCHRONISER)
+        TEST_METHOD(test_disposed) {
+            time_synchroniser ts;
+            Assert::IsFalse(bool(ts), L"Default instance is disposed", LINE_INFO());
+            Assert::ExpectException<std::runtime_error>([&ts](void) { ts.synchronised(); }, L"Disposed instance throws", LINE_INFO());
+        }
+
+        TEST_METHOD(test_loopback) {
+            const std::uint16_t port1 = 48711;
+            const std::uint16_t port2 = 48712;
+
+            auto ts1 = time_synchroniser::create(AF_INET, port1, 10);
+            auto ts2 = time_synchroniser::create(AF_INET, port2, 10);
+            Assert::IsTrue(bool(ts1), L"Synchroniser 1 valid", LINE_INFO());
+            Assert::IsTrue(bool(ts2), L"Synchroniser 2 valid", LINE_INFO());
+            Assert::IsTrue(ts1.synchronised(), L"Local clock is reference", LINE_INFO());
+
+            ts1.reference_peer("127.0.0.1", port2);
+            ts2.reference_peer("127.0.0.1", port1);
+
+            for (int i = 0; (i < 200) && !(ts1.synchronised() && ts2.synchronised()); ++i) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+
+            Assert::IsTrue(ts1.synchronised(), L"Synchroniser 1 received probes", LINE_INFO());
+            Assert::IsTrue(ts2.synchronised(), L"Synchroniser 2 received probes", LINE_INFO());
+
+            // Both share the same clock, so the offset must be small.
+            const auto max_error = std::chrono::milliseconds(1);
+            const auto now = timestamp::now();
+            Assert::IsTrue(std::chrono::abs(ts1.to_reference(now) - now) < max_error, L"Synchroniser 1 offset", LINE_INFO());
+            Assert::IsTrue(std::chrono::abs(ts2.to_reference(now) - now) < max_error, L"Synchroniser 2 offset", LINE_INFO());
+
+            {
+                std::vector<measurement_data> data;
+                data.emplace_back(now, 1.0f, 2.0f);
+                data.emplace_back(now + std::chrono::seconds(1), 1.0f, 2.0f);
+                ts1.to_reference(data.data(), data.size());
+                Assert::IsTrue(std::chrono::abs(data[0].timestamp() - now) < max_error, L"Sample 0 transformed", LINE_INFO());
+                Assert::IsTrue(std::chrono::abs(data[1].timestamp() - (now + std::chrono::seconds(1))) < max_error, L"Sample 1 transformed", LINE_INFO());
+                Assert::AreEqual(2.0f, data[0].power(), L"Power retained", LINE_INFO());
+            }
+
+            {
+                // Samples delivered via async_sampling are transformed.
+                std::vector<measurement_data> received;
+                async_sampling config;
+                config.delivers_measurement_data_to_functor([&received](const wchar_t *, const measurement_data *d, const std::size_t cnt) {
+                        received.insert(received.end(), d, d + cnt);
+                    })
+                    .synchronises_with(&ts1);
+                Assert::IsTrue(config.time_synchroniser() == &ts1, L"Synchroniser set", LINE_INFO());
+
+                const measurement_data sample(now, 1.0f, 2.0f);
+                Assert::IsTrue(config.deliver(L"test", sample), L"Sample delivered", LINE_INFO());
+                Assert::AreEqual(std::size_t(1), received.size(), L"One sample received", LINE_INFO());
+                Assert::IsTrue(std::chrono::abs(received[0].timestamp() - now) < max_error, L"Delivered sample transformed", LINE_INFO());
+            }
+
+            ts1.reference_peer(nullptr);
+            Assert::IsTrue(ts1.to_reference(now) == now, L"Local clock is reference again", LINE_INFO());
+        }
+#endif /* defined(POWER_OVERWHELMING_WITH_TIME_SYNCHRONISER) */
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,104 @@
+﻿// <copyright file="tinkerforge_clock_model_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(tinkerforge_clock_model_test) {
+
+    public:
+
+        TEST_METHOD(test_empty) {
+            detail::tinkerforge_clock_model m;
+            Assert::IsTrue(m.empty(), L"New model is empty", LINE_INFO());
+            Assert::AreEqual(0.0, m.drift(), 0.0, L"No drift", LINE_INFO());
+        }
+
+        TEST_METHOD(test_drift) {
+            // The bricklet clock runs 100 ppm slow, the offset is 1 s.
+            const timestamp::value_type origin = timestamp::tick_rate;
+            const auto scale = 10000.0 * (1.0 + 100e-6);
+            const timestamp::value_type rtt = 20000;   // 2 ms.
+
+            detail::tinkerforge_clock_model m;
+            for (std::uint32_t t = 0; t < 16 * 1000; t += 1000) {
+                const auto host = origin + static_cast<timestamp::value_type>(scale * t);
+                Assert::IsTrue(m.add({ timestamp(host - rtt / 2), t, timestamp(host + rtt / 2) }), L"Probe accepted", LINE_INFO());
+            }
+
+            Assert::AreEqual(std::size_t(16), m.size(), L"Window is full", LINE_INFO());
+            Assert::AreEqual(100e-6, m.drift(), 1e-7, L"Drift estimated", LINE_INFO());
+            Assert::AreEqual(double(origin), double(m.offset().value()), 2.0, L"Offset estimated", LINE_INFO());
+            Assert::AreEqual(double(origin + scale * 20000), double(m(20000).value()), 2.0, L"Extrapolation", LINE_INFO());
+        }
+
+        TEST_METHOD(test_outlier) {
+            const timestamp::value_type origin = timestamp::tick_rate;
+            const timestamp::value_type rtt = 20000;
+
+            detail::tinkerforge_clock_model m;
+            for (std::uint32_t t = 0; t < 8 * 1000; t += 1000) {
+                const auto host = origin + 10000LL * t;
+                m.add({ timestamp(host - rtt / 2), t, timestamp(host + rtt / 2) });
+            }
+
+            // A response that has been stuck for 50 ms must not be used.
+            {
+                const std::uint32_t t = 8000;
+                const auto host = origin + 10000LL * t;
+                Assert::IsFalse(m.add({ timestamp(host - rtt / 2), t, timestamp(host + 500000) }), L"Delayed probe rejected", LINE_INFO());
+            }
+
+            Assert::AreEqual(std::size_t(8), m.size(), L"Outlier not in window", LINE_INFO());
+            Assert::AreEqual(0.0, m.drift(), 1e-9, L"No drift", LINE_INFO());
+            Assert::AreEqual(double(origin + 10000LL * 9000), double(m(9000).value()), 2.0, L"Translation unaffected", LINE_INFO());
+        }
+
+        TEST_METHOD(test_asymmetric_rtt) {
+            // Probes with a large RTT are asymmetric, which would bias the fit
+            // if they were used.
+            const timestamp::value_type origin = timestamp::tick_rate;
+
+            detail::tinkerforge_clock_model m;
+            for (std::uint32_t t = 0; t < 16 * 1000; t += 1000) {
+                const auto host = origin + 10000LL * t;
+                const timestamp::value_type rtt = ((t / 1000) % 2 == 0) ? 10000 : 30000;
+                // The response of the slow probes is delayed, so their midpoint
+                // is late by half of the additional RTT.
+                m.add({ timestamp(host - 5000), t, timestamp(host - 5000 + rtt) });
+            }
+
+            Assert::AreEqual(double(origin + 10000LL * 16000), double(m(16000).value()), 2.0, L"Fast probes used", LINE_INFO());
+        }
+
+        TEST_METHOD(test_wrap) {
+            const timestamp::value_type origin = timestamp::tick_rate;
+            const timestamp::value_type rtt = 20000;
+            const std::uint32_t begin = (std::numeric_limits<std::uint32_t>::max)() - 4000;
+
+            detail::tinkerforge_clock_model m;
+            for (std::int64_t i = 0; i < 8; ++i) {
+                const auto t = static_cast<std::uint32_t>(begin + 1000 * i);
+                const auto host = origin + 10000LL * 1000 * i;
+                m.add({ timestamp(host - rtt / 2), t, timestamp(host + rtt / 2) });
+            }
+
+            Assert::AreEqual(0.0, m.drift(), 1e-9, L"No drift across wrap", LINE_INFO());
+            Assert::AreEqual(double(origin + 10000LL * 8000), double(m(static_cast<std::uint32_t>(begin + 8000)).value()), 2.0, L"Translation after wrap", LINE_INFO());
+            Assert::AreEqual(double(origin + 10000LL * 1000), double(m(begin + 1000).value()), 2.0, L"Translation before wrap", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,104 @@
+﻿// <copyright file="tinkerforge_coalescer_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(tinkerforge_coalescer_test) {
+
+    public:
+
+        TEST_METHOD(test_all) {
+            typedef detail::tinkerforge_coalescer::duration_type duration_type;
+            detail::tinkerforge_coalescer c;
+            c.reset(tinkerforge_sensor_source::all, duration_type(1000));
+
+            const auto t0 = timestamp(10000);
+            Assert::IsFalse(c.update(tinkerforge_sensor_source::current, 2.0f, t0), L"Current only", LINE_INFO());
+            Assert::IsFalse(c.update(tinkerforge_sensor_source::voltage, 12.0f, t0 + std::chrono::microseconds(100)), L"Current and voltage", LINE_INFO());
+            Assert::IsTrue(c.update(tinkerforge_sensor_source::power, 24.0f, t0 + std::chrono::microseconds(200)), L"Complete", LINE_INFO());
+
+            const auto s = c.sample();
+            Assert::AreEqual(2.0f, s.current(), L"Current", LINE_INFO());
+            Assert::AreEqual(12.0f, s.voltage(), L"Voltage", LINE_INFO());
+            Assert::AreEqual(24.0f, s.power(), L"Power", LINE_INFO());
+            Assert::AreEqual((t0 + std::chrono::microseconds(200)).value(), s.timestamp().value(), L"Timestamp of power", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), c.dropped(), L"Nothing dropped", LINE_INFO());
+
+            // The next period must be assembled from scratch.
+            Assert::IsFalse(c.update(tinkerforge_sensor_source::power, 25.0f, t0 + std::chrono::milliseconds(1)), L"New period", LINE_INFO());
+        }
+
+        TEST_METHOD(test_duplicate) {
+            typedef detail::tinkerforge_coalescer::duration_type duration_type;
+            detail::tinkerforge_coalescer c;
+            c.reset(tinkerforge_sensor_source::all, duration_type(1000));
+
+            const auto t0 = timestamp(10000);
+            Assert::IsFalse(c.update(tinkerforge_sensor_source::current, 1.0f, t0), L"Current", LINE_INFO());
+            Assert::IsFalse(c.update(tinkerforge_sensor_source::voltage, 10.0f, t0), L"Voltage", LINE_INFO());
+            Assert::IsFalse(c.update(tinkerforge_sensor_source::current, 2.0f, t0), L"Current again", LINE_INFO());
+            Assert::AreEqual(std::size_t(1), c.dropped(), L"Period dropped", LINE_INFO());
+            Assert::IsFalse(c.update(tinkerforge_sensor_source::power, 20.0f, t0), L"Voltage missing", LINE_INFO());
+            Assert::IsTrue(c.update(tinkerforge_sensor_source::voltage, 12.0f, t0), L"Complete", LINE_INFO());
+
+            const auto s = c.sample();
+            Assert::AreEqual(2.0f, s.current(), L"Current", LINE_INFO());
+            Assert::AreEqual(12.0f, s.voltage(), L"Voltage", LINE_INFO());
+            Assert::AreEqual(20.0f, s.power(), L"Power", LINE_INFO());
+        }
+
+        TEST_METHOD(test_skew) {
+            typedef detail::tinkerforge_coalescer::duration_type duration_type;
+            detail::tinkerforge_coalescer c;
+            c.reset(tinkerforge_sensor_source::all, duration_type(500));
+
+            const auto t0 = timestamp(10000);
+            Assert::IsFalse(c.update(tinkerforge_sensor_source::current, 1.0f, t0), L"Current", LINE_INFO());
+            Assert::IsFalse(c.update(tinkerforge_sensor_source::voltage, 10.0f, t0), L"Voltage", LINE_INFO());
+            Assert::IsFalse(c.update(tinkerforge_sensor_source::power, 10.0f, t0 + std::chrono::microseconds(600)), L"Power too late", LINE_INFO());
+            Assert::AreEqual(std::size_t(1), c.dropped(), L"Period dropped", LINE_INFO());
+        }
+
+        TEST_METHOD(test_subset) {
+            typedef detail::tinkerforge_coalescer::duration_type duration_type;
+            detail::tinkerforge_coalescer c;
+            c.reset(tinkerforge_sensor_source::current | tinkerforge_sensor_source::voltage, duration_type(1000));
+
+            const auto t0 = timestamp(10000);
+            Assert::IsFalse(c.update(tinkerforge_sensor_source::power, 5.0f, t0), L"Power ignored", LINE_INFO());
+            Assert::IsFalse(c.update(tinkerforge_sensor_source::voltage, 10.0f, t0), L"Voltage", LINE_INFO());
+            Assert::IsTrue(c.update(tinkerforge_sensor_source::current, 2.0f, t0 + std::chrono::microseconds(10)), L"Complete", LINE_INFO());
+
+            const auto s = c.sample();
+            Assert::AreEqual(2.0f, s.current(), L"Current", LINE_INFO());
+            Assert::AreEqual(10.0f, s.voltage(), L"Voltage", LINE_INFO());
+            Assert::AreEqual(20.0f, s.power(), L"Power computed", LINE_INFO());
+            Assert::AreEqual(t0.value(), s.timestamp().value(), L"Timestamp of first reading", LINE_INFO());
+        }
+
+        TEST_METHOD(test_single) {
+            detail::tinkerforge_coalescer c;
+            c.reset(tinkerforge_sensor_source::power, std::chrono::milliseconds(1));
+
+            const auto t0 = timestamp(10000);
+            Assert::IsTrue(c.update(tinkerforge_sensor_source::power, 5.0f, t0), L"First", LINE_INFO());
+            Assert::IsTrue(c.update(tinkerforge_sensor_source::power, 6.0f, t0 + std::chrono::milliseconds(1)), L"Second", LINE_INFO());
+            Assert::AreEqual(6.0f, c.sample().power(), L"Power", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), c.dropped(), L"Nothing dropped", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
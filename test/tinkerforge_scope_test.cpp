@@ -0,0 +1,78 @@
+﻿// <copyright file="tinkerforge_scope_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+#include "fake_brickd.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(tinkerforge_scope_test) {
+
+    public:
+
+        TEST_METHOD(test_pool) {
+            fake_brickd brickd;
+            const auto restore = detail::tinkerforge_scope::connections_per_endpoint();
+            detail::tinkerforge_scope::connections_per_endpoint(2);
+
+            {
+                detail::tinkerforge_scope s1("127.0.0.1", brickd.port());
+                detail::tinkerforge_scope s2("127.0.0.1", brickd.port());
+                detail::tinkerforge_scope s3("127.0.0.1", brickd.port());
+
+                IPConnection *c1 = s1;
+                IPConnection *c2 = s2;
+                IPConnection *c3 = s3;
+                Assert::AreNotEqual(reinterpret_cast<std::uintptr_t>(c1), reinterpret_cast<std::uintptr_t>(c2), L"Second connection opened", LINE_INFO());
+                Assert::IsTrue((c3 == c1) || (c3 == c2), L"Third scope shares a connection", LINE_INFO());
+                Assert::IsTrue(brickd.wait_accepted(2, std::chrono::seconds(1)), L"Two connections accepted", LINE_INFO());
+                Assert::AreEqual(std::size_t(2), brickd.accepted(), L"No third connection", LINE_INFO());
+            }
+
+            detail::tinkerforge_scope::connections_per_endpoint(restore);
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                detail::tinkerforge_scope::connections_per_endpoint(0);
+            }, L"Empty pool is illegal", LINE_INFO());
+        }
+
+        TEST_METHOD(test_reconnect) {
+            fake_brickd brickd;
+            detail::tinkerforge_scope scope("127.0.0.1", brickd.port());
+
+            std::atomic<int> called(0);
+            scope.register_reconnect_handler([](void *c) {
+                ++(*static_cast<std::atomic<int> *>(c));
+            }, &called);
+
+            Assert::IsTrue(brickd.wait_accepted(1, std::chrono::seconds(1)), L"Connected", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), scope.disconnects(), L"No disconnect yet", LINE_INFO());
+
+            brickd.drop_all();
+
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            while ((scope.reconnects() < 1) && (std::chrono::steady_clock::now() < deadline)) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+
+            Assert::AreEqual(std::size_t(1), scope.disconnects(), L"Disconnect counted", LINE_INFO());
+            Assert::AreEqual(std::size_t(1), scope.reconnects(), L"Reconnected", LINE_INFO());
+            Assert::AreEqual(1, called.load(), L"Handler invoked", LINE_INFO());
+            Assert::IsTrue(brickd.wait_accepted(2, std::chrono::seconds(1)), L"New connection accepted", LINE_INFO());
+
+            scope.unregister_reconnect_handler(&called);
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
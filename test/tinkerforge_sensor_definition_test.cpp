@@ -56,6 +56,32 @@ namespace test {
             }
         }
 
+        TEST_METHOD(test_endpoint) {
+            {
+                tinkerforge_sensor_definition d("uid");
+                Assert::IsNull(d.host(), L"No host", LINE_INFO());
+            }
+
+            {
+                tinkerforge_sensor_definition d("uid", "host", 42);
+                Assert::AreEqual("uid", d.uid(), L"UID", LINE_INFO());
+                Assert::AreEqual("host", d.host(), L"Host", LINE_INFO());
+                Assert::AreEqual(std::uint16_t(42), d.port(), L"Port", LINE_INFO());
+
+                tinkerforge_sensor_definition c(d);
+                Assert::AreEqual("host", c.host(), L"Copied host", LINE_INFO());
+                Assert::AreEqual(std::uint16_t(42), c.port(), L"Copied port", LINE_INFO());
+
+                tinkerforge_sensor_definition m(std::move(c));
+                Assert::AreEqual("host", m.host(), L"Moved host", LINE_INFO());
+                Assert::IsNull(c.host(), L"Moved from host", LINE_INFO());
+            }
+
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                tinkerforge_sensor_definition d("uid", nullptr, 42);
+            }, L"Null host", LINE_INFO());
+        }
+
         TEST_METHOD(test_assignment) {
             {
                 tinkerforge_sensor_definition d("horst");
@@ -0,0 +1,43 @@
+﻿// <copyright file="tinkerforge_sensor_impl_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(tinkerforge_sensor_impl_test) {
+
+    public:
+
+        TEST_METHOD(test_conversion_period) {
+            typedef detail::tinkerforge_sensor_impl impl_type;
+
+            Assert::AreEqual(std::int64_t(280), std::int64_t(impl_type::conversion_period(
+                sample_averaging::average_of_1,
+                conversion_time::microseconds_140,
+                conversion_time::microseconds_140).count()), L"Fastest", LINE_INFO());
+
+            Assert::AreEqual(std::int64_t(64 * 2200), std::int64_t(impl_type::conversion_period(
+                sample_averaging::average_of_64,
+                conversion_time::milliseconds_1_1,
+                conversion_time::milliseconds_1_1).count()), L"Bricklet default", LINE_INFO());
+
+            Assert::AreEqual(std::int64_t(4 * (332 + 8244)), std::int64_t(impl_type::conversion_period(
+                sample_averaging::average_of_4,
+                conversion_time::microseconds_332,
+                conversion_time::milliseconds_8_244).count()), L"Asymmetric", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
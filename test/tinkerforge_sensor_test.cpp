@@ -0,0 +1,180 @@
+﻿// <copyright file="tinkerforge_sensor_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+#include "fake_brickd.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(tinkerforge_sensor_test) {
+
+    public:
+
+        TEST_METHOD(test_get_definitions) {
+            fake_brickd::configuration config;
+            config.bricklets = 3;
+            fake_brickd brickd(config);
+
+            std::vector<tinkerforge_sensor_definition> definitions(4);
+            const auto cnt = tinkerforge_sensor::get_definitions(
+                definitions.data(), definitions.size(), 500, "127.0.0.1",
+                brickd.port());
+            Assert::AreEqual(std::size_t(3), cnt, L"All bricklets enumerated", LINE_INFO());
+
+            for (std::size_t i = 0; i < brickd.bricklets(); ++i) {
+                auto it = std::find_if(definitions.begin(),
+                    definitions.begin() + cnt,
+                    [&brickd, i](const tinkerforge_sensor_definition& d) {
+                        return (brickd.uid(i) == d.uid());
+                    });
+                Assert::IsTrue(it != definitions.begin() + cnt, L"UID found", LINE_INFO());
+            }
+        }
+
+        TEST_METHOD(test_get_definitions_multi) {
+            fake_brickd::configuration config;
+            config.bricklets = 2;
+            fake_brickd brickd1(config);
+            config.bricklets = 3;
+            fake_brickd brickd2(config);
+
+            // The third endpoint does not exist and must be skipped.
+            const char *hosts[] = { "127.0.0.1", "127.0.0.1", "127.0.0.1" };
+            const std::uint16_t ports[] = { brickd1.port(), brickd2.port(), 1 };
+
+            std::vector<tinkerforge_sensor_definition> definitions(5);
+            const auto begin = std::chrono::steady_clock::now();
+            const auto cnt = tinkerforge_sensor::get_definitions(
+                definitions.data(), definitions.size(), hosts, ports, 3, 5000);
+            const auto elapsed = std::chrono::steady_clock::now() - begin;
+            Assert::AreEqual(std::size_t(5), cnt, L"All bricklets enumerated", LINE_INFO());
+            Assert::IsTrue(elapsed < std::chrono::seconds(5), L"Returned before deadline", LINE_INFO());
+
+            for (std::size_t i = 0; i < cnt; ++i) {
+                const auto& d = definitions[i];
+                Assert::IsNotNull(d.host(), L"Host set", LINE_INFO());
+                Assert::AreEqual("127.0.0.1", d.host(), L"Host", LINE_INFO());
+
+                auto& brickd = (d.port() == brickd1.port()) ? brickd1 : brickd2;
+                Assert::AreEqual(brickd.port(), d.port(), L"Port of a brickd", LINE_INFO());
+
+                auto found = false;
+                for (std::size_t j = 0; j < brickd.bricklets(); ++j) {
+                    found = found || (brickd.uid(j) == d.uid());
+                }
+                Assert::IsTrue(found, L"UID belongs to the brickd", LINE_INFO());
+            }
+
+            {
+                // The definition must override the default endpoint.
+                tinkerforge_sensor sensor(definitions[0]);
+                Assert::IsTrue(bool(sensor), L"Sensor created", LINE_INFO());
+            }
+
+            {
+                // The second enumeration is served from the cache.
+                const auto begin = std::chrono::steady_clock::now();
+                const auto cnt = tinkerforge_sensor::get_definitions(
+                    nullptr, 0, hosts, ports, 2, 5000);
+                const auto elapsed = std::chrono::steady_clock::now() - begin;
+                Assert::AreEqual(std::size_t(5), cnt, L"All bricklets cached", LINE_INFO());
+                Assert::IsTrue(elapsed < std::chrono::seconds(1), L"Cache is fast", LINE_INFO());
+            }
+        }
+
+        TEST_METHOD(test_sample_sync) {
+            fake_brickd::configuration config;
+            config.bricklets = 1;
+            fake_brickd brickd(config);
+
+            tinkerforge_sensor sensor(brickd.uid(0).c_str(), "127.0.0.1",
+                brickd.port());
+            const auto sample = sensor.sample();
+            Assert::AreEqual(12.0f, sample.voltage(), 0.001f, L"Voltage", LINE_INFO());
+            Assert::AreEqual(1.0f, sample.current(), 0.001f, L"Current", LINE_INFO());
+        }
+
+        TEST_METHOD(test_sample_async) {
+            struct context_type {
+                fake_brickd *brickd;
+                std::atomic<std::size_t> early;
+                std::atomic<std::size_t> samples;
+            } context;
+            context.early = 0;
+            context.samples = 0;
+
+            fake_brickd::configuration config;
+            config.bricklets = 1;
+            fake_brickd brickd(config);
+            context.brickd = &brickd;
+
+            tinkerforge_sensor sensor(brickd.uid(0).c_str(), "127.0.0.1",
+                brickd.port());
+            sensor.sample(std::move(async_sampling()
+                .samples_every(std::chrono::milliseconds(1))
+                .delivers_measurement_data_to([](const wchar_t *,
+                        const measurement_data *samples,
+                        const std::size_t cnt,
+                        void *c) {
+                    auto ctx = static_cast<context_type *>(c);
+                    for (std::size_t i = 0; i < cnt; ++i) {
+                        const auto s = static_cast<std::uint32_t>(
+                            std::lround(samples[i].power() * 1000.0f));
+                        const auto e = ctx->brickd->emitted(0, s);
+                        if (samples[i].timestamp() < e) {
+                            ++ctx->early;
+                        }
+                    }
+                    ctx->samples += cnt;
+                })
+                .passes_context(&context)));
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(250));
+            sensor.sample(async_sampling());
+
+            Assert::IsTrue(context.samples > 10, L"Samples received", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), context.early.load(), L"No sample before its emission", LINE_INFO());
+        }
+
+        TEST_METHOD(test_loss) {
+            fake_brickd::configuration config;
+            config.bricklets = 1;
+            config.loss = 0.5;
+            fake_brickd brickd(config);
+
+            std::atomic<std::size_t> samples(0);
+            tinkerforge_sensor sensor(brickd.uid(0).c_str(), "127.0.0.1",
+                brickd.port());
+            sensor.sample(std::move(async_sampling()
+                .samples_every(std::chrono::milliseconds(1))
+                .from_source(tinkerforge_sensor_source::power)
+                .delivers_measurement_data_to([](const wchar_t *,
+                        const measurement_data *,
+                        const std::size_t cnt,
+                        void *c) {
+                    *static_cast<std::atomic<std::size_t> *>(c) += cnt;
+                })
+                .passes_context(&samples)));
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(250));
+            sensor.sample(async_sampling());
+
+            Assert::IsTrue(brickd.lost() > 0, L"Callbacks lost", LINE_INFO());
+            Assert::IsTrue(samples.load() > 0, L"Some samples received", LINE_INFO());
+            Assert::IsTrue(samples.load() <= brickd.sent(), L"No more samples than sent", LINE_INFO());
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
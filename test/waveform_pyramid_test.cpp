@@ -0,0 +1,272 @@
+﻿// <copyright file="waveform_pyramid_test.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "pch.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace visus {
+namespace power_overwhelming {
+namespace test {
+
+    TEST_CLASS(waveform_pyramid_test) {
+
+    public:
+
+        TEST_METHOD(ctor) {
+            {
+                waveform_pyramid p;
+                Assert::IsFalse(bool(p), L"Default pyramid is invalid", LINE_INFO());
+                Assert::AreEqual(std::size_t(0), p.size(), L"Default pyramid is empty", LINE_INFO());
+                Assert::ExpectException<std::runtime_error>([&p](void) {
+                    p.append(1.0f);
+                }, L"Append to invalid pyramid", LINE_INFO());
+            }
+
+            {
+                waveform_pyramid p(timestamp(42), 0.5, 8, 2);
+                Assert::IsTrue(bool(p), L"Pyramid is valid", LINE_INFO());
+                Assert::AreEqual(std::size_t(0), p.size(), L"New pyramid is empty", LINE_INFO());
+                Assert::AreEqual(std::size_t(1), p.levels(), L"New pyramid has one level", LINE_INFO());
+                Assert::AreEqual(std::size_t(8), p.samples_per_bin(), L"samples_per_bin", LINE_INFO());
+                Assert::AreEqual(std::size_t(2), p.fan_out(), L"fan_out", LINE_INFO());
+                Assert::AreEqual(0.5, p.sample_distance(), L"sample_distance", LINE_INFO());
+                Assert::AreEqual(timestamp::value_type(42), p.origin().value(), L"origin", LINE_INFO());
+
+                waveform_pyramid q(std::move(p));
+                Assert::IsFalse(bool(p), L"Moved pyramid is invalid", LINE_INFO());
+                Assert::IsTrue(bool(q), L"Move target is valid", LINE_INFO());
+            }
+
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                waveform_pyramid p(timestamp::zero, 0.0);
+            }, L"Sample distance must be positive", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                waveform_pyramid p(timestamp::zero, 1.0, 0);
+            }, L"Bins must not be empty", LINE_INFO());
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                waveform_pyramid p(timestamp::zero, 1.0, 1, 1);
+            }, L"Fan-out must be at least two", LINE_INFO());
+        }
+
+        TEST_METHOD(append) {
+            const std::size_t cnt = 1000;
+            waveform_pyramid p(timestamp::zero, 1.0, 4, 2);
+
+            std::vector<float> samples(cnt);
+            for (std::size_t i = 0; i < cnt; ++i) {
+                samples[i] = static_cast<float>((i * 7919) % 101) - 50.0f;
+            }
+
+            // Add the samples in irregular chunks.
+            for (std::size_t i = 0, c = 1; i < cnt; i += c, c = c % 13 + 1) {
+                p.append(samples.data() + i, (std::min)(c, cnt - i));
+            }
+
+            Assert::AreEqual(cnt, p.size(), L"All samples added", LINE_INFO());
+            Assert::IsTrue(p.levels() > 1, L"Coarser levels were created", LINE_INFO());
+
+            for (std::size_t bins : { 1000, 250, 100, 17, 3, 1 }) {
+                std::vector<waveform_pyramid::bin> dst(bins);
+                std::size_t first, width;
+                const auto n = p.query(dst.data(), dst.size(), 0, cnt, &first, &width);
+                Assert::IsTrue(n <= bins, L"Query respects the requested number of bins", LINE_INFO());
+                Assert::AreEqual(std::size_t(0), first, L"Range starts at begin", LINE_INFO());
+                Assert::IsTrue(n * width >= cnt, L"Range covers all samples", LINE_INFO());
+
+                for (std::size_t b = 0; b < n; ++b) {
+                    const auto s = samples.begin() + b * width;
+                    const auto e = samples.begin() + (std::min)((b + 1) * width, cnt);
+                    const auto mean = std::accumulate(s, e, 0.0) / (e - s);
+                    Assert::AreEqual(*std::max_element(s, e), dst[b].maximum, L"Maximum", LINE_INFO());
+                    Assert::AreEqual(*std::min_element(s, e), dst[b].minimum, L"Minimum", LINE_INFO());
+                    Assert::AreEqual(float(mean), dst[b].mean, 0.001f, L"Mean", LINE_INFO());
+                }
+            }
+        }
+
+        TEST_METHOD(query) {
+            waveform_pyramid p(timestamp::zero, 0.001, 10, 4);
+
+            for (std::size_t i = 0; i < 1000; ++i) {
+                p.append(static_cast<float>(i));
+            }
+
+            std::size_t first, width;
+            Assert::AreEqual(std::size_t(10), p.query(nullptr, 100, 0, 100, &first, &width), L"Finest level", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), first, L"First of finest level", LINE_INFO());
+            Assert::AreEqual(std::size_t(10), width, L"Width of finest level", LINE_INFO());
+
+            Assert::AreEqual(std::size_t(3), p.query(nullptr, 4, 15, 105, &first, &width), L"Second level", LINE_INFO());
+            Assert::AreEqual(std::size_t(0), first, L"First of second level", LINE_INFO());
+            Assert::AreEqual(std::size_t(40), width, L"Width of second level", LINE_INFO());
+
+            Assert::AreEqual(std::size_t(0), p.query(nullptr, 4, 1000, 2000, &first, &width), L"Out of range", LINE_INFO());
+            Assert::AreEqual(std::size_t(1), p.query(nullptr, 4, 999, 2000, &first, &width), L"Clamped range", LINE_INFO());
+
+            waveform_pyramid::bin bin;
+            Assert::AreEqual(std::size_t(1), p.query(&bin, 1, 0, 1000), L"Single bin", LINE_INFO());
+            Assert::AreEqual(0.0f, bin.minimum, L"Global minimum", LINE_INFO());
+            Assert::AreEqual(999.0f, bin.maximum, L"Global maximum", LINE_INFO());
+            Assert::AreEqual(499.5f, bin.mean, 0.001f, L"Global mean", LINE_INFO());
+
+            const auto begin = p.sample_timestamp(200);
+            const auto end = p.sample_timestamp(300);
+            Assert::AreEqual(std::size_t(200), p.sample_index(begin), L"Sample index", LINE_INFO());
+            Assert::AreEqual(std::size_t(10), p.query(nullptr, 10, begin, end, &first, &width), L"Time range", LINE_INFO());
+            Assert::AreEqual(std::size_t(200), first, L"First of time range", LINE_INFO());
+        }
+
+        TEST_METHOD(query_wide) {
+            const std::size_t cnt = 5000;
+            waveform_pyramid p(timestamp::zero, 1.0, 3, 4);
+
+            std::vector<float> samples(cnt);
+            for (std::size_t i = 0; i < cnt; ++i) {
+                samples[i] = std::sin(0.01f * i) * 100.0f + static_cast<float>((i * 31) % 7);
+            }
+            p.append(samples.data(), samples.size());
+
+            // Ranges that are not aligned to the bins and much wider than the
+            // requested number of bins must be summarised from coarse levels.
+            const std::pair<std::size_t, std::size_t> ranges[] = { { 1, 4999 }, { 17, 3001 }, { 250, 5000 }, { 4000, 4999 }, { 0, 5000 } };
+            for (auto& r : ranges) {
+                for (std::size_t bins : { 1, 2, 5, 11 }) {
+                    std::vector<waveform_pyramid::bin> dst(bins);
+                    std::size_t first, width;
+                    const auto n = p.query(dst.data(), dst.size(), r.first, r.second, &first, &width);
+                    Assert::IsTrue(n > 0, L"Bins returned", LINE_INFO());
+                    Assert::IsTrue(n <= bins, L"Query respects the requested number of bins", LINE_INFO());
+                    Assert::IsTrue(width > 1, L"More than one sample per bin", LINE_INFO());
+                    Assert::IsTrue(first <= r.first, L"Range starts before begin", LINE_INFO());
+                    Assert::IsTrue(first + n * width >= r.second, L"Range covers end", LINE_INFO());
+
+                    for (std::size_t b = 0; b < n; ++b) {
+                        const auto s = samples.begin() + (std::min)(first + b * width, cnt);
+                        const auto e = samples.begin() + (std::min)(first + (b + 1) * width, cnt);
+                        Assert::IsTrue(s < e, L"Bin is not empty", LINE_INFO());
+                        const auto mean = std::accumulate(s, e, 0.0) / (e - s);
+                        Assert::AreEqual(*std::max_element(s, e), dst[b].maximum, L"Maximum", LINE_INFO());
+                        Assert::AreEqual(*std::min_element(s, e), dst[b].minimum, L"Minimum", LINE_INFO());
+                        Assert::AreEqual(float(mean), dst[b].mean, 0.01f, L"Mean", LINE_INFO());
+                    }
+                }
+            }
+        }
+
+        TEST_METHOD(load_corrupt) {
+            static const char *path = "waveform_pyramid_corrupt.pwp";
+            waveform_pyramid p(timestamp::zero, 1.0, 4, 2);
+            for (std::size_t i = 0; i < 100; ++i) {
+                p.append(static_cast<float>(i));
+            }
+            p.save(path);
+
+            std::vector<char> original;
+            {
+                std::ifstream s(path, std::ios::binary);
+                original.assign(std::istreambuf_iterator<char>(s), std::istreambuf_iterator<char>());
+            }
+
+            // Offsets of the header fields: magic, version, samples per bin,
+            // fan-out, origin, sample distance, size and number of levels.
+            const std::size_t samples_per_bin = 12;
+            const std::size_t fan_out = 20;
+            const std::size_t size = 44;
+            const std::size_t levels = 52;
+            const std::size_t level_bins = 60;
+
+            const auto write = [](const std::vector<char>& data) {
+                std::ofstream s(path, std::ios::binary | std::ios::trunc);
+                s.write(data.data(), data.size());
+            };
+            const auto patch = [&original, &write](const std::size_t offset, const std::uint64_t value) {
+                auto data = original;
+                ::memcpy(data.data() + offset, &value, sizeof(value));
+                write(data);
+            };
+
+            patch(samples_per_bin, 0);
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                waveform_pyramid::load(path);
+            }, L"Empty bins", LINE_INFO());
+
+            patch(fan_out, 1);
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                waveform_pyramid::load(path);
+            }, L"Fan-out of one", LINE_INFO());
+
+            patch(size, 101);
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                waveform_pyramid::load(path);
+            }, L"Size not matching the bins", LINE_INFO());
+
+            patch(size, UINT64_MAX / 2);
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                waveform_pyramid::load(path);
+            }, L"Size not matching the levels", LINE_INFO());
+
+            patch(levels, UINT64_MAX);
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                waveform_pyramid::load(path);
+            }, L"Huge number of levels", LINE_INFO());
+
+            patch(level_bins, 26);
+            Assert::ExpectException<std::invalid_argument>([](void) {
+                waveform_pyramid::load(path);
+            }, L"Bins not matching the size", LINE_INFO());
+
+            write(std::vector<char>(original.begin(), original.end() - 1));
+            Assert::ExpectException<std::ios_base::failure>([](void) {
+                waveform_pyramid::load(path);
+            }, L"Truncated file", LINE_INFO());
+
+            write(original);
+            Assert::AreEqual(std::size_t(100), waveform_pyramid::load(path).size(), L"Valid file", LINE_INFO());
+            std::remove(path);
+        }
+
+        TEST_METHOD(save_load) {
+            static const char *path = "waveform_pyramid_test.pwp";
+            waveform_pyramid p(timestamp(1234), 0.25, 3, 3);
+
+            for (std::size_t i = 0; i < 100; ++i) {
+                p.append(static_cast<float>(i % 17));
+            }
+
+            p.save(path);
+            auto q = waveform_pyramid::load(path);
+            std::remove(path);
+
+            Assert::AreEqual(p.size(), q.size(), L"Size restored", LINE_INFO());
+            Assert::AreEqual(p.levels(), q.levels(), L"Levels restored", LINE_INFO());
+            Assert::AreEqual(p.origin().value(), q.origin().value(), L"Origin restored", LINE_INFO());
+            Assert::AreEqual(p.sample_distance(), q.sample_distance(), L"Sample distance restored", LINE_INFO());
+
+            // Both pyramids must continue to evolve the same way.
+            for (std::size_t i = 0; i < 50; ++i) {
+                p.append(static_cast<float>(i));
+                q.append(static_cast<float>(i));
+            }
+
+            std::vector<waveform_pyramid::bin> expected(16);
+            std::vector<waveform_pyramid::bin> actual(16);
+            const auto n = p.query(expected.data(), expected.size(), 0, p.size());
+            Assert::AreEqual(n, q.query(actual.data(), actual.size(), 0, q.size()), L"Same number of bins", LINE_INFO());
+
+            for (std::size_t i = 0; i < n; ++i) {
+                Assert::AreEqual(expected[i].minimum, actual[i].minimum, L"Same minimum", LINE_INFO());
+                Assert::AreEqual(expected[i].maximum, actual[i].maximum, L"Same maximum", LINE_INFO());
+                Assert::AreEqual(expected[i].mean, actual[i].mean, L"Same mean", LINE_INFO());
+            }
+        }
+    };
+
+} /* namespace test */
+} /* namespace power_overwhelming */
+} /* namespace visus */
@@ -0,0 +1,232 @@
+﻿// <copyright file="tinkerforge_benchmark.cpp" company="Visualisierungsinstitut der Universität Stuttgart">
+// Copyright © 2024 Visualisierungsinstitut der Universität Stuttgart.
+// Licensed under the MIT licence. See LICENCE file for details.
+// </copyright>
+// <author>Christoph Müller</author>
+
+#include "power_overwhelming/tinkerforge_sensor.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "fake_brickd.h"
+
+#if defined(_WIN32)
+#include <Windows.h>
+#include <tchar.h>
+#endif /* defined(_WIN32) */
+
+#if !defined(_tmain)
+#define _tmain main
+#define TCHAR char
+#define _T(x) (x)
+#endif /* !defined(_tmain) */
+
+
+namespace {
+
+    using namespace visus::power_overwhelming;
+    using visus::power_overwhelming::test::fake_brickd;
+
+    /// <summary>
+    /// The data collected for a single sensor.
+    /// </summary>
+    struct sensor_context {
+        fake_brickd *brickd;
+        std::size_t index;
+        std::vector<double> latencies;
+        std::size_t samples;
+        std::vector<double> timestamp_errors;
+        std::size_t unmatched;
+    };
+
+    /// <summary>
+    /// Records the latency and the timestamp error of the samples delivered by
+    /// a sensor. This runs on the callback thread of the connection.
+    /// </summary>
+    void on_samples(const wchar_t *, const measurement_data *samples,
+            const std::size_t cnt, void *context) {
+        const auto now = timestamp::now();
+        auto ctx = static_cast<sensor_context *>(context);
+
+        for (std::size_t i = 0; i < cnt; ++i) {
+            const auto sequence = static_cast<std::uint32_t>(
+                std::lround(samples[i].power() * 1000.0f));
+            const auto emitted = ctx->brickd->emitted(ctx->index, sequence);
+
+            if (emitted.value() == 0) {
+                ++ctx->unmatched;
+                continue;
+            }
+
+            typedef std::chrono::duration<double, std::micro> micros;
+            ctx->latencies.push_back(std::chrono::duration_cast<micros>(
+                now - emitted).count());
+            ctx->timestamp_errors.push_back(std::chrono::duration_cast<micros>(
+                samples[i].timestamp() - emitted).count());
+        }
+
+        ctx->samples += cnt;
+    }
+
+    /// <summary>
+    /// Prints the given quantiles of <paramref name="values" />.
+    /// </summary>
+    void print_distribution(const wchar_t *name, std::vector<double>& values) {
+        std::wcout << name << L" [µs]: ";
+
+        if (values.empty()) {
+            std::wcout << L"n/a" << std::endl;
+            return;
+        }
+
+        std::sort(values.begin(), values.end());
+        const auto quantile = [&values](const double q) {
+            const auto i = static_cast<std::size_t>(q * (values.size() - 1));
+            return values[i];
+        };
+
+        std::wcout << L"min " << values.front()
+            << L", p50 " << quantile(0.5)
+            << L", p99 " << quantile(0.99)
+            << L", max " << values.back()
+            << std::endl;
+    }
+
+    /// <summary>
+    /// Answer the value following <paramref name="option" /> or
+    /// <paramref name="fallback" /> if the option has not been specified.
+    /// </summary>
+    template<class TValue>
+    TValue get_option(const std::vector<std::basic_string<TCHAR>>& cmd_line,
+            const TCHAR *option, const TValue fallback) {
+        auto it = std::find(cmd_line.begin(), cmd_line.end(), option);
+        if ((it == cmd_line.end()) || (++it == cmd_line.end())) {
+            return fallback;
+        } else {
+            return static_cast<TValue>(std::stod(*it));
+        }
+    }
+}
+
+
+/// <summary>
+/// Entry point of the Tinkerforge load test, which samples an emulated brickd
+/// with a configurable number of bricklets through the
+/// <see cref="tinkerforge_sensor" /> and reports the throughput, the latency
+/// of the callbacks and the accuracy of the timestamps.
+/// </summary>
+/// <param name="argc"></param>
+/// <param name="argv"></param>
+/// <returns></returns>
+int _tmain(const int argc, const TCHAR **argv) {
+    using namespace visus::power_overwhelming;
+    using visus::power_overwhelming::test::fake_brickd;
+
+    const std::vector<std::basic_string<TCHAR>> cmd_line(argv, argv + argc);
+
+    if (std::find(cmd_line.begin(), cmd_line.end(), _T("--help"))
+            != cmd_line.end()) {
+        std::wcout << L"Samples voltage/current bricklets on an emulated "
+            << L"brickd and reports the throughput," << std::endl
+            << L"the callback latency and the timestamp accuracy."
+            << std::endl << std::endl;
+        std::wcout << L"Usage: tinkerforge_benchmark [--bricklets <count>] "
+            << L"[--interval <µs>] [--period <µs>]" << std::endl
+            << L"    [--jitter <µs>] [--loss <probability>] "
+            << L"[--duration <s>] [--batch <count>]" << std::endl
+            << L"    [--firmware <major>] [--resync]" << std::endl;
+        return 0;
+    }
+
+    try {
+        fake_brickd::configuration config;
+        config.bricklets = get_option(cmd_line, _T("--bricklets"),
+            std::size_t(40));
+        config.firmware_version[0] = get_option(cmd_line, _T("--firmware"),
+            config.firmware_version[0]);
+        config.jitter = std::chrono::microseconds(get_option(cmd_line,
+            _T("--jitter"), 0));
+        config.loss = get_option(cmd_line, _T("--loss"), 0.0);
+        config.period = std::chrono::microseconds(get_option(cmd_line,
+            _T("--period"), 0));
+        const auto batch = get_option(cmd_line, _T("--batch"), std::size_t(1));
+        const auto duration = std::chrono::seconds(get_option(cmd_line,
+            _T("--duration"), 5));
+        const auto interval = get_option(cmd_line, _T("--interval"),
+            async_sampling::microseconds_type(1000));
+        const auto resync = (std::find(cmd_line.begin(), cmd_line.end(),
+            _T("--resync")) != cmd_line.end());
+
+        fake_brickd brickd(config);
+        std::wcout << L"Emulating " << brickd.bricklets()
+            << L" bricklets on port " << brickd.port() << L"." << std::endl;
+
+        std::vector<sensor_context> contexts(brickd.bricklets());
+        std::vector<tinkerforge_sensor> sensors;
+        sensors.reserve(brickd.bricklets());
+
+        for (std::size_t i = 0; i < brickd.bricklets(); ++i) {
+            contexts[i].brickd = &brickd;
+            contexts[i].index = i;
+            contexts[i].samples = 0;
+            contexts[i].unmatched = 0;
+            sensors.emplace_back(brickd.uid(i).c_str(), "127.0.0.1",
+                brickd.port());
+
+            if (resync) {
+                sensors.back().resync_internal_clock();
+            }
+        }
+
+        const auto begin = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < sensors.size(); ++i) {
+            sensors[i].sample(std::move(async_sampling()
+                .samples_every(interval)
+                .delivers_in_batches_of(batch)
+                .delivers_measurement_data_to(on_samples)
+                .passes_context(&contexts[i])));
+        }
+
+        std::this_thread::sleep_for(duration);
+
+        for (auto& s : sensors) {
+            s.sample(async_sampling());
+        }
+        const auto end = std::chrono::steady_clock::now();
+
+        std::size_t gaps = 0;
+        std::size_t samples = 0;
+        std::size_t unmatched = 0;
+        std::vector<double> latencies;
+        std::vector<double> errors;
+        for (std::size_t i = 0; i < sensors.size(); ++i) {
+            gaps += sensors[i].gaps();
+            samples += contexts[i].samples;
+            unmatched += contexts[i].unmatched;
+            latencies.insert(latencies.end(), contexts[i].latencies.begin(),
+                contexts[i].latencies.end());
+            errors.insert(errors.end(), contexts[i].timestamp_errors.begin(),
+                contexts[i].timestamp_errors.end());
+        }
+
+        const auto elapsed = std::chrono::duration<double>(end - begin).count();
+        std::wcout << L"Callbacks sent: " << brickd.sent()
+            << L", lost: " << brickd.lost() << std::endl;
+        std::wcout << L"Samples received: " << samples
+            << L" (" << (samples / elapsed) << L"/s), unmatched: " << unmatched
+            << L", connection gaps: " << gaps << std::endl;
+        print_distribution(L"Callback latency", latencies);
+        print_distribution(L"Timestamp error", errors);
+
+        return 0;
+    } catch (std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        return -1;
+    }
+}